@@ -16,6 +16,7 @@
 
 #include <anki/collision/GjkEpa.h>
 #include <anki/collision/Functions.h>
+#include <anki/collision/FrustumCulling.h>
 #include <anki/collision/Tests.h>
 
 /// @defgroup collision Collision detection module
@@ -137,6 +137,7 @@
 // Graphics backend
 #define ANKI_GR_BACKEND_GL 1
 #define ANKI_GR_BACKEND_VULKAN 2
+#define ANKI_GR_BACKEND_NULL 3
 #define ANKI_GR_BACKEND ANKI_GR_BACKEND_${ANKI_GR_BACKEND}
 
 // Enable performance counters
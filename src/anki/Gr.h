@@ -26,3 +26,6 @@
 
 /// @defgroup vulkan Vulkan backend
 /// @ingroup graphics
+
+/// @defgroup null Null backend
+/// @ingroup graphics
@@ -32,11 +32,15 @@
 #include <anki/util/System.h>
 #include <anki/util/Thread.h>
 #include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/ParallelFor.h>
+#include <anki/util/ThreadHiveTaskGraph.h>
 #include <anki/util/Visitor.h>
 #include <anki/util/INotify.h>
 #include <anki/util/SparseArray.h>
 #include <anki/util/ObjectAllocator.h>
 #include <anki/util/Tracer.h>
+#include <anki/util/RadixSort.h>
 
 /// @defgroup util Utilities (like STL)
 
@@ -0,0 +1,139 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/collision/FrustumCulling.h>
+#include <anki/math/Simd.h>
+#include <cstring>
+
+namespace anki
+{
+
+void cullBoundingVolumes(const Array<Plane, 6>& planes, const BoundingVolumeBatch& batch, U64* visibleMask)
+{
+	ANKI_ASSERT(visibleMask);
+	ANKI_ASSERT(batch.m_count == 0
+				|| (batch.m_centersX && batch.m_centersY && batch.m_centersZ && batch.m_extentsX && batch.m_extentsY
+					   && batch.m_extentsZ && batch.m_radii));
+
+	const U32 count = batch.m_count;
+	memset(visibleMask, 0, sizeof(U64) * ((count + 63) / 64));
+
+	U32 i = 0;
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+	// Splat the planes once
+	Array<__m128, 6> nx, ny, nz, absNx, absNy, absNz, offsets;
+	for(U p = 0; p < 6; ++p)
+	{
+		const Vec4& n = planes[p].getNormal();
+		nx[p] = _mm_set1_ps(n.x());
+		ny[p] = _mm_set1_ps(n.y());
+		nz[p] = _mm_set1_ps(n.z());
+		absNx[p] = _mm_set1_ps(absolute(n.x()));
+		absNy[p] = _mm_set1_ps(absolute(n.y()));
+		absNz[p] = _mm_set1_ps(absolute(n.z()));
+		offsets[p] = _mm_set1_ps(planes[p].getOffset());
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(batch.m_centersX + i);
+		const __m128 cy = _mm_loadu_ps(batch.m_centersY + i);
+		const __m128 cz = _mm_loadu_ps(batch.m_centersZ + i);
+		const __m128 ex = _mm_loadu_ps(batch.m_extentsX + i);
+		const __m128 ey = _mm_loadu_ps(batch.m_extentsY + i);
+		const __m128 ez = _mm_loadu_ps(batch.m_extentsZ + i);
+		const __m128 r = _mm_loadu_ps(batch.m_radii + i);
+
+		__m128 visible = _mm_cmpeq_ps(zero, zero);
+		for(U p = 0; p < 6; ++p)
+		{
+			// The signed distance of the center plus how far the volume reaches towards the normal
+			__m128 dist = _mm_mul_ps(cx, nx[p]);
+			dist = _mm_add_ps(dist, _mm_mul_ps(cy, ny[p]));
+			dist = _mm_add_ps(dist, _mm_mul_ps(cz, nz[p]));
+			dist = _mm_sub_ps(dist, offsets[p]);
+
+			__m128 reach = _mm_add_ps(r, _mm_mul_ps(ex, absNx[p]));
+			reach = _mm_add_ps(reach, _mm_mul_ps(ey, absNy[p]));
+			reach = _mm_add_ps(reach, _mm_mul_ps(ez, absNz[p]));
+
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(dist, reach), zero));
+		}
+
+		visibleMask[i / 64] |= U64(_mm_movemask_ps(visible)) << (i % 64);
+	}
+#elif ANKI_SIMD == ANKI_SIMD_NEON
+	Array<float32x4_t, 6> nx, ny, nz, absNx, absNy, absNz, offsets;
+	for(U p = 0; p < 6; ++p)
+	{
+		const Vec4& n = planes[p].getNormal();
+		nx[p] = vdupq_n_f32(n.x());
+		ny[p] = vdupq_n_f32(n.y());
+		nz[p] = vdupq_n_f32(n.z());
+		absNx[p] = vdupq_n_f32(absolute(n.x()));
+		absNy[p] = vdupq_n_f32(absolute(n.y()));
+		absNz[p] = vdupq_n_f32(absolute(n.z()));
+		offsets[p] = vdupq_n_f32(planes[p].getOffset());
+	}
+
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const uint32x4_t laneBits = {1, 2, 4, 8};
+	for(; i + 4 <= count; i += 4)
+	{
+		const float32x4_t cx = vld1q_f32(batch.m_centersX + i);
+		const float32x4_t cy = vld1q_f32(batch.m_centersY + i);
+		const float32x4_t cz = vld1q_f32(batch.m_centersZ + i);
+		const float32x4_t ex = vld1q_f32(batch.m_extentsX + i);
+		const float32x4_t ey = vld1q_f32(batch.m_extentsY + i);
+		const float32x4_t ez = vld1q_f32(batch.m_extentsZ + i);
+		const float32x4_t r = vld1q_f32(batch.m_radii + i);
+
+		uint32x4_t visible = vdupq_n_u32(0xFFFFFFFF);
+		for(U p = 0; p < 6; ++p)
+		{
+			float32x4_t dist = vmulq_f32(cx, nx[p]);
+			dist = vmlaq_f32(dist, cy, ny[p]);
+			dist = vmlaq_f32(dist, cz, nz[p]);
+			dist = vsubq_f32(dist, offsets[p]);
+
+			float32x4_t reach = vmlaq_f32(r, ex, absNx[p]);
+			reach = vmlaq_f32(reach, ey, absNy[p]);
+			reach = vmlaq_f32(reach, ez, absNz[p]);
+
+			visible = vandq_u32(visible, vcgeq_f32(vaddq_f32(dist, reach), zero));
+		}
+
+		const uint32x4_t bits = vandq_u32(visible, laneBits);
+		const U64 mask = vgetq_lane_u32(bits, 0) | vgetq_lane_u32(bits, 1) | vgetq_lane_u32(bits, 2)
+						 | vgetq_lane_u32(bits, 3);
+		visibleMask[i / 64] |= mask << (i % 64);
+	}
+#endif
+
+	// The remaining
+	for(; i < count; ++i)
+	{
+		Bool visible = true;
+		for(U p = 0; p < 6 && visible; ++p)
+		{
+			const Vec4& n = planes[p].getNormal();
+			const F32 dist = batch.m_centersX[i] * n.x() + batch.m_centersY[i] * n.y() + batch.m_centersZ[i] * n.z()
+							 - planes[p].getOffset();
+			const F32 reach = batch.m_radii[i] + batch.m_extentsX[i] * absolute(n.x())
+							  + batch.m_extentsY[i] * absolute(n.y()) + batch.m_extentsZ[i] * absolute(n.z());
+
+			visible = dist + reach >= 0.0f;
+		}
+
+		if(visible)
+		{
+			visibleMask[i / 64] |= U64(1) << (i % 64);
+		}
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,40 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/collision/Plane.h>
+
+namespace anki
+{
+
+/// @addtogroup collision
+/// @{
+
+/// A number of bounding volumes packed in struct of arrays layout for cullBoundingVolumes(). Every member points to an
+/// array of m_count elements. An AABB has its half sizes in the extents and zero radius. A sphere has zero extents and
+/// its radius.
+class BoundingVolumeBatch
+{
+public:
+	const F32* m_centersX = nullptr;
+	const F32* m_centersY = nullptr;
+	const F32* m_centersZ = nullptr;
+	const F32* m_extentsX = nullptr;
+	const F32* m_extentsY = nullptr;
+	const F32* m_extentsZ = nullptr;
+	const F32* m_radii = nullptr;
+	U32 m_count = 0;
+};
+
+/// Test a batch of bounding volumes against 6 planes. A volume is visible if it's not completely behind any of the
+/// planes. It's the same test as Frustum::insideFrustum() but it processes 4 volumes at a time using SIMD.
+/// @param[in] planes The planes. Usually the ones of Frustum::getPlanesWorldSpace() or extractClipPlanes().
+/// @param[in] batch The volumes.
+/// @param[out] visibleMask A bitmask of (batch.m_count + 63) / 64 elements. Bit i is set if volume i is visible.
+void cullBoundingVolumes(const Array<Plane, 6>& planes, const BoundingVolumeBatch& batch, U64* visibleMask);
+/// @}
+
+} // end namespace anki
@@ -385,7 +385,10 @@ Error App::initInternal(const ConfigSet& config_, AllocAlignedCallback allocCb,
 	// ThreadPool
 	//
 	m_threadpool = m_heapAlloc.newInstance<ThreadPool>(config.getNumber("core.mainThreadCount"), true);
-	m_threadHive = m_heapAlloc.newInstance<ThreadHive>(config.getNumber("core.mainThreadCount"), m_heapAlloc, true);
+	m_threadHive = m_heapAlloc.newInstance<ThreadHive>(config.getNumber("core.mainThreadCount"),
+		m_heapAlloc,
+		true,
+		config.getNumber("core.threadHiveWorkStealing"));
 
 	//
 	// Graphics API
@@ -452,8 +455,16 @@ Error App::initInternal(const ConfigSet& config_, AllocAlignedCallback allocCb,
 
 	m_renderer = m_heapAlloc.newInstance<MainRenderer>();
 
-	ANKI_CHECK(m_renderer->init(
-		m_threadpool, m_resources, m_gr, m_stagingMem, m_ui, m_allocCb, m_allocCbData, config, &m_globalTimestamp));
+	ANKI_CHECK(m_renderer->init(m_threadpool,
+		m_threadHive,
+		m_resources,
+		m_gr,
+		m_stagingMem,
+		m_ui,
+		m_allocCb,
+		m_allocCbData,
+		config,
+		&m_globalTimestamp));
 
 	//
 	// Script
@@ -588,6 +599,10 @@ Error App::mainLoop()
 		// Pause and sync async loader. That will force all tasks before the pause to finish in this frame.
 		m_resources->getAsyncLoader().pause();
 
+		// The async loader is paused so the streamed textures and the hot reloaded resources can be swapped safely
+		m_resources->updateTextureStreaming();
+		m_resources->updateHotReload();
+
 		m_gr->swapBuffers();
 		m_stagingMem->endFrame();
 
@@ -596,6 +611,12 @@ Error App::mainLoop()
 		ANKI_TRACE_INC_COUNTER(RESOURCE_ASYNC_TASKS, asyncTaskCount - m_resourceCompletedAsyncTaskCount);
 		m_resourceCompletedAsyncTaskCount = asyncTaskCount;
 
+		const AsyncLoader& asyncLoader = m_resources->getAsyncLoader();
+		ANKI_TRACE_INC_COUNTER(
+			RSRC_ASYNC_VISIBLE_QUEUE_DEPTH, asyncLoader.getQueuedTaskCount(AsyncLoaderPriority::VISIBLE));
+		ANKI_TRACE_INC_COUNTER(
+			RSRC_ASYNC_BACKGROUND_QUEUE_DEPTH, asyncLoader.getQueuedTaskCount(AsyncLoaderPriority::BACKGROUND));
+
 		// Now resume the loader
 		m_resources->getAsyncLoader().resume();
 
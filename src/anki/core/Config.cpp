@@ -13,17 +13,18 @@ Config::Config()
 {
 	// Renderer
 	newOption("r.renderingQuality", 1.0, "Rendering quality factor");
-	newOption("r.lodDistance0", 10.0, "Distance that will be used to calculate the LOD 0");
-	newOption("r.lodDistance1", 20.0, "Distance that will be used to calculate the LOD 1");
 	newOption("r.clusterSizeX", 32);
 	newOption("r.clusterSizeY", 26);
 	newOption("r.clusterSizeZ", 32);
+	newOption("r.incrementalLightBinning", true, "Reuse the clusters of the lights that didn't move");
 	newOption("r.maxLightsPerCluster", 8);
 
 	newOption("r.shadowMapping.enabled", true);
 	newOption("r.shadowMapping.resolution", 512);
 	newOption("r.shadowMapping.tileCountPerRowOrColumn", 8);
 	newOption("r.shadowMapping.scratchTileCount", 8);
+	newOption("r.shadowMapping.lodCount", 3, "The shadow maps of the lights that are far use lower resolutions");
+	newOption("r.shadowMapping.lodHysteresis", 0.1, "How much a light can cross a tile size before it changes LOD");
 
 	newOption("r.lensFlare.maxSpritesPerFlare", 8);
 	newOption("r.lensFlare.maxFlares", 16);
@@ -41,6 +42,9 @@ Config::Config()
 	// Scene
 	newOption("scene.imageReflectionMaxDistance", 30.0);
 	newOption("scene.earlyZDistance", 10.0, "Objects with distance lower than that will be used in early Z");
+	newOption("scene.lodScreenSize0", 0.25, "Objects smaller than that fraction of the screen height use the LOD 1");
+	newOption("scene.lodScreenSize1", 0.1, "Objects smaller than that fraction of the screen height use the LOD 2");
+	newOption("scene.lodHysteresis", 0.1, "How much the screen size should pass a LOD threshold to change the LOD");
 
 	// Globals
 	newOption("width", 1280);
@@ -51,6 +55,12 @@ Config::Config()
 	newOption("rsrc.textureAnisotropy", 8);
 	newOption("rsrc.dataPaths", ".", "The engine loads assets only in from these paths. Separate them with :");
 	newOption("rsrc.transferScratchMemorySize", 256_MB);
+	newOption("rsrc.asyncLoaderThreadCount", 2, "The number of threads that load resources in the background");
+	newOption("rsrc.textureStreamingBudget", 0, "The memory of the streamed textures. 0 disables streaming");
+	newOption("rsrc.textureStreamingTailSize", 64, "The max size of the mips that a streamed texture starts with");
+	newOption("rsrc.textureStreamingMaxTextureCount", 4096);
+	newOption("rsrc.textureStreamingMaxChangesInFlight", 8);
+	newOption("rsrc.hotReload", 0, "Reload the resources when their files change. It's for development");
 
 	// Window
 	newOption("window.fullscreenDesktopResolution", false);
@@ -71,6 +81,7 @@ Config::Config()
 	newOption("core.vertexPerFrameMemorySize", 10_MB);
 	newOption("core.textureBufferPerFrameMemorySize", 1_MB);
 	newOption("core.mainThreadCount", max(2u, getCpuCoresCount() / 2u - 1u));
+	newOption("core.threadHiveWorkStealing", false);
 	newOption("core.displayStats", false);
 	newOption("core.clearCaches", false);
 }
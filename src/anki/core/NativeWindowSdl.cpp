@@ -19,6 +19,11 @@ Error NativeWindow::init(NativeWindowInitInfo& init, HeapAllocator<U8>& alloc)
 	m_alloc = alloc;
 	m_impl = m_alloc.newInstance<NativeWindowImpl>();
 
+#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_NULL
+	// Nothing is presented. Use SDL's dummy video driver so it can run without a display (eg on a CI machine)
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+#endif
+
 	if(SDL_Init(INIT_SUBSYSTEMS) != 0)
 	{
 		ANKI_CORE_LOGE("SDL_Init() failed");
@@ -967,34 +967,54 @@ BufferPtr RenderGraph::getBuffer(RenderPassBufferHandle handle) const
 	return m_ctx->m_buffers[handle.m_idx].m_buffer;
 }
 
-void RenderGraph::runSecondLevel(U32 threadIdx)
+U32 RenderGraph::getSecondLevelCommandBufferCount() const
 {
-	ANKI_TRACE_SCOPED_EVENT(GR_RENDER_GRAPH);
 	ANKI_ASSERT(m_ctx);
 
-	RenderPassWorkContext ctx;
-	ctx.m_rgraph = this;
-	ctx.m_currentSecondLevelCommandBufferIndex = threadIdx;
+	U32 count = 0;
+	for(const Pass& p : m_ctx->m_passes)
+	{
+		count += p.m_secondLevelCmdbs.getSize();
+	}
 
+	return count;
+}
+
+void RenderGraph::runSecondLevel(U32 cmdbIdx)
+{
+	ANKI_TRACE_SCOPED_EVENT(GR_RENDER_GRAPH);
+	ANKI_ASSERT(m_ctx);
+
+	// Find the pass
 	for(Pass& p : m_ctx->m_passes)
 	{
 		const U size = p.m_secondLevelCmdbs.getSize();
-		if(threadIdx < size)
+		if(cmdbIdx >= size)
 		{
-			ANKI_ASSERT(!p.m_secondLevelCmdbs[threadIdx].isCreated());
-			p.m_secondLevelCmdbs[threadIdx] = getManager().newCommandBuffer(p.m_secondLevelCmdbInitInfo);
+			cmdbIdx -= size;
+			continue;
+		}
 
-			ctx.m_commandBuffer = p.m_secondLevelCmdbs[threadIdx];
-			ctx.m_secondLevelCommandBufferCount = size;
-			ctx.m_passIdx = &p - &m_ctx->m_passes[0];
-			ctx.m_userData = p.m_userData;
+		RenderPassWorkContext ctx;
+		ctx.m_rgraph = this;
+		ctx.m_currentSecondLevelCommandBufferIndex = cmdbIdx;
 
-			ANKI_ASSERT(ctx.m_commandBuffer.isCreated());
-			p.m_callback(ctx);
+		ANKI_ASSERT(!p.m_secondLevelCmdbs[cmdbIdx].isCreated());
+		p.m_secondLevelCmdbs[cmdbIdx] = getManager().newCommandBuffer(p.m_secondLevelCmdbInitInfo);
 
-			ctx.m_commandBuffer->flush();
-		}
+		ctx.m_commandBuffer = p.m_secondLevelCmdbs[cmdbIdx];
+		ctx.m_secondLevelCommandBufferCount = size;
+		ctx.m_passIdx = &p - &m_ctx->m_passes[0];
+		ctx.m_userData = p.m_userData;
+
+		ANKI_ASSERT(ctx.m_commandBuffer.isCreated());
+		p.m_callback(ctx);
+
+		ctx.m_commandBuffer->flush();
+		return;
 	}
+
+	ANKI_ASSERT(!"Out of bounds");
 }
 
 void RenderGraph::run() const
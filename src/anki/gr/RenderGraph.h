@@ -614,8 +614,13 @@ public:
 	/// @name 2nd step methods
 	/// @{
 
-	/// Will call a number of RenderPassWorkCallback that populate 2nd level command buffers.
-	void runSecondLevel(U32 threadIdx);
+	/// Get the number of the 2nd level command buffers of all the passes.
+	U32 getSecondLevelCommandBufferCount() const;
+
+	/// Will call the RenderPassWorkCallback that populates one 2nd level command buffer. The command buffers can be
+	/// populated in parallel.
+	/// @param cmdbIdx The command buffer to populate. It's in [0, getSecondLevelCommandBufferCount()).
+	void runSecondLevel(U32 cmdbIdx);
 	/// @}
 
 	/// @name 3rd step methods
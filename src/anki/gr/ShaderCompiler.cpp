@@ -18,7 +18,7 @@ namespace anki
 
 void ShaderCompilerOptions::setFromGrManager(const GrManager& gr)
 {
-#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_VULKAN
+#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_VULKAN || ANKI_GR_BACKEND == ANKI_GR_BACKEND_NULL
 	m_outLanguage = ShaderLanguage::SPIRV;
 #else
 	m_outLanguage = ShaderLanguage::GLSL;
@@ -0,0 +1,55 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/BufferImpl.h>
+#include <anki/gr/null/GrManagerImpl.h>
+
+namespace anki
+{
+
+BufferImpl::~BufferImpl()
+{
+	ANKI_ASSERT(!m_mapped);
+
+	if(m_memory)
+	{
+		getAllocator().deallocate(m_memory, m_size);
+		static_cast<GrManagerImpl&>(getManager()).onBufferMemoryChanged(0, m_size);
+	}
+}
+
+Error BufferImpl::init(const BufferInitInfo& inf)
+{
+	ANKI_ASSERT(inf.isValid());
+
+	m_size = inf.m_size;
+	m_usage = inf.m_usage;
+	m_access = inf.m_access;
+
+	if(!!m_access)
+	{
+		const PtrSize alignment = ANKI_SAFE_ALIGNMENT;
+		m_memory = getAllocator().allocate(m_size, &alignment);
+		static_cast<GrManagerImpl&>(getManager()).onBufferMemoryChanged(m_size, 0);
+	}
+
+	return Error::NONE;
+}
+
+void* BufferImpl::map(PtrSize offset, PtrSize range, BufferMapAccessBit access)
+{
+	ANKI_ASSERT(m_memory && "The buffer is not mappable");
+	ANKI_ASSERT((access & m_access) != BufferMapAccessBit::NONE);
+	ANKI_ASSERT(!m_mapped);
+	ANKI_ASSERT(rangeValid(offset, range));
+
+#if ANKI_EXTRA_CHECKS
+	m_mapped = true;
+#endif
+
+	return m_memory + offset;
+}
+
+} // end namespace anki
@@ -0,0 +1,60 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Buffer.h>
+#include <anki/gr/null/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Buffer implementation. Only the mappable buffers have memory.
+class BufferImpl final : public Buffer
+{
+public:
+	BufferImpl(GrManager* manager, CString name)
+		: Buffer(manager, name)
+	{
+	}
+
+	~BufferImpl();
+
+	ANKI_USE_RESULT Error init(const BufferInitInfo& inf);
+
+	ANKI_USE_RESULT void* map(PtrSize offset, PtrSize range, BufferMapAccessBit access);
+
+	void unmap()
+	{
+		ANKI_ASSERT(m_mapped);
+#if ANKI_EXTRA_CHECKS
+		m_mapped = false;
+#endif
+	}
+
+	Bool usageValid(BufferUsageBit usage) const
+	{
+		return (m_usage & usage) == usage;
+	}
+
+	/// Check that a range is inside the buffer. MAX_PTR_SIZE means the rest of the buffer.
+	Bool rangeValid(PtrSize offset, PtrSize range) const
+	{
+		return offset < m_size && (range == MAX_PTR_SIZE || offset + range <= m_size);
+	}
+
+private:
+	U8* m_memory = nullptr;
+
+#if ANKI_EXTRA_CHECKS
+	Bool8 m_mapped = false;
+#endif
+};
+/// @}
+
+} // end namespace anki
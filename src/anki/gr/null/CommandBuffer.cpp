@@ -0,0 +1,412 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/CommandBuffer.h>
+#include <anki/gr/null/CommandBufferImpl.h>
+#include <anki/gr/null/BufferImpl.h>
+#include <anki/gr/null/TextureViewImpl.h>
+#include <anki/gr/null/ShaderProgramImpl.h>
+#include <anki/gr/null/FramebufferImpl.h>
+#include <anki/gr/null/SamplerImpl.h>
+#include <anki/gr/null/OcclusionQueryImpl.h>
+#include <anki/gr/null/FenceImpl.h>
+#include <anki/gr/GrManager.h>
+
+namespace anki
+{
+
+CommandBuffer* CommandBuffer::newInstance(GrManager* manager, const CommandBufferInitInfo& init)
+{
+	CommandBufferImpl* impl = manager->getAllocator().newInstance<CommandBufferImpl>(manager, init.getName());
+	Error err = impl->init(init);
+	if(err)
+	{
+		manager->getAllocator().deleteInstance(impl);
+	}
+	return impl;
+}
+
+CommandBufferInitHints CommandBuffer::computeInitHints() const
+{
+	// Nothing is stored so the defaults are fine
+	CommandBufferInitHints hints;
+	return hints;
+}
+
+void CommandBuffer::flush(FencePtr* fence)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.endRecording(fence);
+}
+
+void CommandBuffer::bindVertexBuffer(
+	U32 binding, BufferPtr buff, PtrSize offset, PtrSize stride, VertexStepRate stepRate)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*buff).usageValid(BufferUsageBit::VERTEX));
+}
+
+void CommandBuffer::setVertexAttribute(U32 location, U32 buffBinding, Format fmt, PtrSize relativeOffset)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::bindIndexBuffer(BufferPtr buff, PtrSize offset, IndexType type)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*buff).usageValid(BufferUsageBit::INDEX));
+	self.bindIndexBuffer();
+}
+
+void CommandBuffer::setPrimitiveRestart(Bool enable)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setViewport(U32 minx, U32 miny, U32 width, U32 height)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setScissor(U32 minx, U32 miny, U32 width, U32 height)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setFillMode(FillMode mode)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setCullMode(FaceSelectionBit mode)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setPolygonOffset(F32 factor, F32 units)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setStencilOperations(FaceSelectionBit face,
+	StencilOperation stencilFail,
+	StencilOperation stencilPassDepthFail,
+	StencilOperation stencilPassDepthPass)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setStencilCompareOperation(FaceSelectionBit face, CompareOperation comp)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setStencilCompareMask(FaceSelectionBit face, U32 mask)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setStencilWriteMask(FaceSelectionBit face, U32 mask)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setStencilReference(FaceSelectionBit face, U32 ref)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setDepthWrite(Bool enable)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setDepthCompareOperation(CompareOperation op)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setAlphaToCoverage(Bool enable)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setColorChannelWriteMask(U32 attachment, ColorBit mask)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setBlendFactors(
+	U32 attachment, BlendFactor srcRgb, BlendFactor dstRgb, BlendFactor srcA, BlendFactor dstA)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::setBlendOperation(U32 attachment, BlendOperation funcRgb, BlendOperation funcA)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::bindTextureAndSampler(
+	U32 set, U32 binding, TextureViewPtr texView, SamplerPtr sampler, TextureUsageBit usage)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+	ANKI_ASSERT(sampler.isCreated());
+	const TextureViewImpl& view = static_cast<const TextureViewImpl&>(*texView);
+	ANKI_ASSERT(view.getTextureImpl().isSubresourceGoodForSampling(view.getSubresource()));
+	(void)view;
+}
+
+void CommandBuffer::bindUniformBuffer(U32 set, U32 binding, BufferPtr buff, PtrSize offset, PtrSize range)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+	const BufferImpl& impl = static_cast<const BufferImpl&>(*buff);
+	ANKI_ASSERT(!!(impl.getBufferUsage() & BufferUsageBit::UNIFORM_ALL));
+	ANKI_ASSERT(impl.rangeValid(offset, range));
+	(void)impl;
+}
+
+void CommandBuffer::bindStorageBuffer(U32 set, U32 binding, BufferPtr buff, PtrSize offset, PtrSize range)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+	const BufferImpl& impl = static_cast<const BufferImpl&>(*buff);
+	ANKI_ASSERT(!!(impl.getBufferUsage() & BufferUsageBit::STORAGE_ALL));
+	ANKI_ASSERT(impl.rangeValid(offset, range));
+	(void)impl;
+}
+
+void CommandBuffer::bindImage(U32 set, U32 binding, TextureViewPtr img)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+	const TextureViewImpl& view = static_cast<const TextureViewImpl&>(*img);
+	ANKI_ASSERT(view.getTextureImpl().isSubresourceGoodForImageLoadStore(view.getSubresource()));
+	(void)view;
+}
+
+void CommandBuffer::bindTextureBuffer(U32 set, U32 binding, BufferPtr buff, PtrSize offset, PtrSize range, Format fmt)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*buff).rangeValid(offset, range));
+}
+
+void CommandBuffer::bindShaderProgram(ShaderProgramPtr prog)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.bindShaderProgram(prog);
+}
+
+void CommandBuffer::beginRenderPass(FramebufferPtr fb,
+	const Array<TextureUsageBit, MAX_COLOR_ATTACHMENTS>& colorAttachmentUsages,
+	TextureUsageBit depthStencilAttachmentUsage,
+	U32 minx,
+	U32 miny,
+	U32 width,
+	U32 height)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.beginRenderPass(fb);
+}
+
+void CommandBuffer::endRenderPass()
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.endRenderPass();
+}
+
+void CommandBuffer::drawElements(
+	PrimitiveTopology topology, U32 count, U32 instanceCount, U32 firstIndex, U32 baseVertex, U32 baseInstance)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.drawcallCommon(true);
+}
+
+void CommandBuffer::drawArrays(PrimitiveTopology topology, U32 count, U32 instanceCount, U32 first, U32 baseInstance)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.drawcallCommon(false);
+}
+
+void CommandBuffer::drawArraysIndirect(PrimitiveTopology topology, U32 drawCount, PtrSize offset, BufferPtr buff)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*buff).usageValid(BufferUsageBit::INDIRECT));
+	self.drawcallCommon(false);
+}
+
+void CommandBuffer::drawElementsIndirect(PrimitiveTopology topology, U32 drawCount, PtrSize offset, BufferPtr buff)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*buff).usageValid(BufferUsageBit::INDIRECT));
+	self.drawcallCommon(true);
+}
+
+void CommandBuffer::dispatchCompute(U32 groupCountX, U32 groupCountY, U32 groupCountZ)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	ANKI_ASSERT(groupCountX > 0 && groupCountY > 0 && groupCountZ > 0);
+	self.dispatchCommon();
+}
+
+void CommandBuffer::generateMipmaps2d(TextureViewPtr texView)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+	const TextureViewImpl& view = static_cast<const TextureViewImpl&>(*texView);
+	ANKI_ASSERT(view.getTextureImpl().isSubresourceGoodForMipmapGeneration(view.getSubresource()));
+	(void)view;
+}
+
+void CommandBuffer::generateMipmaps3d(TextureViewPtr texView)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+}
+
+void CommandBuffer::blitTextureViews(TextureViewPtr srcView, TextureViewPtr destView)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+}
+
+void CommandBuffer::clearTextureView(TextureViewPtr texView, const ClearValue& clearValue)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+}
+
+void CommandBuffer::copyBufferToTextureView(BufferPtr buff, PtrSize offset, PtrSize range, TextureViewPtr texView)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*buff).usageValid(BufferUsageBit::TEXTURE_UPLOAD_SOURCE));
+	const TextureViewImpl& view = static_cast<const TextureViewImpl&>(*texView);
+	ANKI_ASSERT(view.getTextureImpl().isSubresourceGoodForCopyFromBuffer(view.getSubresource()));
+	(void)view;
+}
+
+void CommandBuffer::fillBuffer(BufferPtr buff, PtrSize offset, PtrSize size, U32 value)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*buff).usageValid(BufferUsageBit::FILL));
+	ANKI_ASSERT((offset % 4) == 0);
+	ANKI_ASSERT(size == MAX_PTR_SIZE || (size % 4) == 0);
+}
+
+void CommandBuffer::writeOcclusionQueryResultToBuffer(OcclusionQueryPtr query, PtrSize offset, BufferPtr buff)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*buff).usageValid(BufferUsageBit::QUERY_RESULT));
+	ANKI_ASSERT((offset % 4) == 0);
+}
+
+void CommandBuffer::copyBufferToBuffer(
+	BufferPtr src, PtrSize srcOffset, BufferPtr dst, PtrSize dstOffset, PtrSize range)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*src).rangeValid(srcOffset, range));
+	ANKI_ASSERT(static_cast<const BufferImpl&>(*dst).rangeValid(dstOffset, range));
+}
+
+void CommandBuffer::setTextureBarrier(
+	TexturePtr tex, TextureUsageBit prevUsage, TextureUsageBit nextUsage, const TextureSubresourceInfo& subresource)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+	ANKI_ASSERT(tex->isSubresourceValid(subresource));
+}
+
+void CommandBuffer::setTextureSurfaceBarrier(
+	TexturePtr tex, TextureUsageBit prevUsage, TextureUsageBit nextUsage, const TextureSurfaceInfo& surf)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+}
+
+void CommandBuffer::setTextureVolumeBarrier(
+	TexturePtr tex, TextureUsageBit prevUsage, TextureUsageBit nextUsage, const TextureVolumeInfo& vol)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+}
+
+void CommandBuffer::setBufferBarrier(
+	BufferPtr buff, BufferUsageBit before, BufferUsageBit after, PtrSize offset, PtrSize size)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+}
+
+void CommandBuffer::resetOcclusionQuery(OcclusionQueryPtr query)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.transferCommon();
+}
+
+void CommandBuffer::beginOcclusionQuery(OcclusionQueryPtr query)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::endOcclusionQuery(OcclusionQueryPtr query)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+void CommandBuffer::pushSecondLevelCommandBuffer(CommandBufferPtr cmdb)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.pushSecondLevelCommandBuffer(cmdb);
+}
+
+Bool CommandBuffer::isEmpty() const
+{
+	ANKI_NULL_SELF_CONST(CommandBufferImpl);
+	return self.isEmpty();
+}
+
+void CommandBuffer::setPushConstants(const void* data, U32 dataSize)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+	ANKI_ASSERT(data && dataSize > 0);
+	ANKI_ASSERT(dataSize <= getManager().getDeviceCapabilities().m_pushConstantsSize);
+}
+
+void CommandBuffer::setRasterizationOrder(RasterizationOrder order)
+{
+	ANKI_NULL_SELF(CommandBufferImpl);
+	self.commandCommon();
+}
+
+} // end namespace anki
@@ -0,0 +1,128 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/CommandBufferImpl.h>
+#include <anki/gr/null/GrManagerImpl.h>
+#include <anki/gr/null/FenceImpl.h>
+#include <anki/gr/null/FramebufferImpl.h>
+#include <anki/gr/null/ShaderProgramImpl.h>
+#include <anki/gr/Fence.h>
+#include <anki/gr/ShaderProgram.h>
+
+namespace anki
+{
+
+CommandBufferImpl::CommandBufferImpl(GrManager* manager, CString name)
+	: CommandBuffer(manager, name)
+{
+	static_cast<GrManagerImpl&>(getManager()).onCommandBufferCreatedOrDestroyed(true);
+}
+
+CommandBufferImpl::~CommandBufferImpl()
+{
+	static_cast<GrManagerImpl&>(getManager()).onCommandBufferCreatedOrDestroyed(false);
+}
+
+Error CommandBufferImpl::init(const CommandBufferInitInfo& init)
+{
+	m_flags = init.m_flags;
+
+	// The second level command buffers are recorded inside the render pass of the primary
+	if(isSecondLevel())
+	{
+		ANKI_ASSERT(init.m_framebuffer.isCreated());
+		m_insideRenderPass = true;
+	}
+
+	return Error::NONE;
+}
+
+void CommandBufferImpl::endRecording(FencePtr* fence)
+{
+	ANKI_ASSERT(!m_finalized);
+	m_finalized = true;
+
+	if(!isSecondLevel())
+	{
+		ANKI_ASSERT(!insideRenderPass() && "Forgot to end the render pass");
+		static_cast<GrManagerImpl&>(getManager()).onCommandBufferFlushed(*this);
+
+		if(fence)
+		{
+			fence->reset(getAllocator().newInstance<FenceImpl>(&getManager(), "N/A"));
+		}
+	}
+	else
+	{
+		ANKI_ASSERT(fence == nullptr);
+	}
+}
+
+void CommandBufferImpl::beginRenderPass(FramebufferPtr fb)
+{
+	commandCommon();
+	ANKI_ASSERT(!isSecondLevel());
+	ANKI_ASSERT(!insideRenderPass());
+	ANKI_ASSERT(fb.isCreated());
+
+	m_insideRenderPass = true;
+	++m_renderPassCount;
+}
+
+void CommandBufferImpl::endRenderPass()
+{
+	commandCommon();
+	ANKI_ASSERT(!isSecondLevel());
+	ANKI_ASSERT(insideRenderPass());
+
+	m_insideRenderPass = false;
+}
+
+void CommandBufferImpl::bindShaderProgram(ShaderProgramPtr prog)
+{
+	commandCommon();
+	ANKI_ASSERT(prog.isCreated());
+
+	const Bool compute = static_cast<const ShaderProgramImpl&>(*prog).isCompute();
+	m_computeProgBound = compute;
+	m_graphicsProgBound = !compute;
+}
+
+void CommandBufferImpl::drawcallCommon(Bool indexed)
+{
+	commandCommon();
+	ANKI_ASSERT(insideRenderPass() && "Drawcalls should be inside a render pass");
+	ANKI_ASSERT(m_graphicsProgBound && "Forgot to bind a graphics program");
+	ANKI_ASSERT((!indexed || m_indexBufferBound) && "Forgot to bind an index buffer");
+	(void)indexed;
+
+	++m_drawcallCount;
+}
+
+void CommandBufferImpl::dispatchCommon()
+{
+	commandCommon();
+	ANKI_ASSERT(!insideRenderPass() && "Dispatches should be outside render passes");
+	ANKI_ASSERT(m_computeProgBound && "Forgot to bind a compute program");
+
+	++m_dispatchCount;
+}
+
+void CommandBufferImpl::pushSecondLevelCommandBuffer(CommandBufferPtr cmdb)
+{
+	commandCommon();
+	ANKI_ASSERT(!isSecondLevel());
+	ANKI_ASSERT(insideRenderPass());
+
+	const CommandBufferImpl& impl = static_cast<const CommandBufferImpl&>(*cmdb);
+	ANKI_ASSERT(impl.isSecondLevel());
+	ANKI_ASSERT(impl.isFinalized() && "Flush the second level command buffer first");
+
+	// The work of the second level command buffer is accounted to this one
+	m_commandCount += impl.m_commandCount;
+	m_drawcallCount += impl.m_drawcallCount;
+}
+
+} // end namespace anki
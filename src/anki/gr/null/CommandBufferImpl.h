@@ -0,0 +1,118 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/CommandBuffer.h>
+#include <anki/gr/null/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Command buffer implementation. The commands are not stored anywhere. They are validated the way the other backends
+/// expect them and they are counted.
+class CommandBufferImpl final : public CommandBuffer
+{
+public:
+	CommandBufferImpl(GrManager* manager, CString name);
+
+	~CommandBufferImpl();
+
+	ANKI_USE_RESULT Error init(const CommandBufferInitInfo& init);
+
+	Bool isSecondLevel() const
+	{
+		return !!(m_flags & CommandBufferFlag::SECOND_LEVEL);
+	}
+
+	Bool isFinalized() const
+	{
+		return m_finalized;
+	}
+
+	/// Finalize it. If it's a primary command buffer then submit it.
+	void endRecording(FencePtr* fence);
+
+	/// Call it at the start of every command.
+	void commandCommon()
+	{
+		ANKI_ASSERT(!m_finalized && "Recording commands after flush");
+		++m_commandCount;
+	}
+
+	Bool insideRenderPass() const
+	{
+		return m_insideRenderPass;
+	}
+
+	void beginRenderPass(FramebufferPtr fb);
+
+	void endRenderPass();
+
+	void bindShaderProgram(ShaderProgramPtr prog);
+
+	void bindIndexBuffer()
+	{
+		commandCommon();
+		m_indexBufferBound = true;
+	}
+
+	void drawcallCommon(Bool indexed);
+
+	void dispatchCommon();
+
+	/// The commands that are not allowed in render passes. Copies, clears, barriers and the like.
+	void transferCommon()
+	{
+		commandCommon();
+		ANKI_ASSERT(!insideRenderPass());
+	}
+
+	void pushSecondLevelCommandBuffer(CommandBufferPtr cmdb);
+
+	Bool isEmpty() const
+	{
+		return m_commandCount == 0;
+	}
+
+	U32 getCommandCount() const
+	{
+		return m_commandCount;
+	}
+
+	U32 getRenderPassCount() const
+	{
+		return m_renderPassCount;
+	}
+
+	U32 getDrawcallCount() const
+	{
+		return m_drawcallCount;
+	}
+
+	U32 getDispatchCount() const
+	{
+		return m_dispatchCount;
+	}
+
+private:
+	CommandBufferFlag m_flags = CommandBufferFlag::NONE;
+	Bool8 m_finalized = false;
+	Bool8 m_insideRenderPass = false;
+	Bool8 m_graphicsProgBound = false;
+	Bool8 m_computeProgBound = false;
+	Bool8 m_indexBufferBound = false;
+
+	U32 m_commandCount = 0;
+	U32 m_renderPassCount = 0;
+	U32 m_drawcallCount = 0;
+	U32 m_dispatchCount = 0;
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,52 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Framebuffer.h>
+#include <anki/gr/null/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Framebuffer implementation.
+class FramebufferImpl final : public Framebuffer
+{
+public:
+	FramebufferImpl(GrManager* manager, CString name)
+		: Framebuffer(manager, name)
+	{
+	}
+
+	~FramebufferImpl()
+	{
+	}
+
+	ANKI_USE_RESULT Error init(const FramebufferInitInfo& init)
+	{
+		ANKI_ASSERT(init.isValid());
+		m_init = init;
+		return Error::NONE;
+	}
+
+	Bool isDefaultFramebuffer() const
+	{
+		return m_init.refersToDefaultFramebuffer();
+	}
+
+	U32 getColorAttachmentCount() const
+	{
+		return m_init.m_colorAttachmentCount;
+	}
+
+private:
+	FramebufferInitInfo m_init; ///< Holds references to the views.
+};
+/// @}
+
+} // end namespace anki
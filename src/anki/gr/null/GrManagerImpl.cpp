@@ -0,0 +1,57 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/gr/null/GrManagerImpl.h>
+#include <anki/gr/null/CommandBufferImpl.h>
+#include <anki/core/Config.h>
+
+namespace anki
+{
+
+GrManagerImpl::~GrManagerImpl()
+{
+}
+
+Error GrManagerImpl::init(const GrManagerInitInfo& init)
+{
+	ANKI_NULL_LOGI("Initializing the null backend. Nothing will be drawn");
+
+	// Some sane limits so the code that sub-allocates buffers works as usual
+	m_capabilities.m_uniformBufferBindOffsetAlignment = 256;
+	m_capabilities.m_uniformBufferMaxRange = 64 * 1024;
+	m_capabilities.m_storageBufferBindOffsetAlignment = max<U32>(ANKI_SAFE_ALIGNMENT, 16);
+	m_capabilities.m_storageBufferMaxRange = MAX_U32;
+	m_capabilities.m_textureBufferBindOffsetAlignment = max<U32>(ANKI_SAFE_ALIGNMENT, 16);
+	m_capabilities.m_textureBufferMaxRange = MAX_U32;
+	m_capabilities.m_gpuVendor = GpuVendor::UNKNOWN;
+
+	// The shaders are still compiled to SPIR-V so pretend to be the Vulkan version of the config
+	m_capabilities.m_majorApiVersion = init.m_config->getNumber("gr.vkmajor");
+	m_capabilities.m_minorApiVersion = init.m_config->getNumber("gr.vkminor");
+
+	return Error::NONE;
+}
+
+void GrManagerImpl::onCommandBufferFlushed(const CommandBufferImpl& cmdb)
+{
+	m_flushedCommandBufferCount.fetchAdd(1);
+	m_commandCount.fetchAdd(cmdb.getCommandCount());
+	m_renderPassCount.fetchAdd(cmdb.getRenderPassCount());
+	m_drawcallCount.fetchAdd(cmdb.getDrawcallCount());
+	m_dispatchCount.fetchAdd(cmdb.getDispatchCount());
+}
+
+NullGrCounters GrManagerImpl::getCounters() const
+{
+	NullGrCounters out;
+	out.m_commandBufferCount = m_flushedCommandBufferCount.load();
+	out.m_commandCount = m_commandCount.load();
+	out.m_renderPassCount = m_renderPassCount.load();
+	out.m_drawcallCount = m_drawcallCount.load();
+	out.m_dispatchCount = m_dispatchCount.load();
+	return out;
+}
+
+} // end namespace anki
@@ -0,0 +1,107 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/GrManager.h>
+#include <anki/gr/null/Common.h>
+
+namespace anki
+{
+
+// Forward
+class CommandBufferImpl;
+
+/// @addtogroup null
+/// @{
+
+/// The work that the flushed command buffers had.
+class NullGrCounters
+{
+public:
+	U64 m_commandBufferCount = 0;
+	U64 m_commandCount = 0;
+	U64 m_renderPassCount = 0;
+	U64 m_drawcallCount = 0;
+	U64 m_dispatchCount = 0;
+};
+
+/// Null backend of the GrManager. The objects are CPU side stand-ins that don't draw anything. It's for measuring the
+/// CPU cost of the renderer on machines without a GPU.
+class GrManagerImpl final : public GrManager
+{
+public:
+	GrManagerImpl()
+	{
+	}
+
+	~GrManagerImpl();
+
+	ANKI_USE_RESULT Error init(const GrManagerInitInfo& init);
+
+	void beginFrame()
+	{
+	}
+
+	void endFrame()
+	{
+		++m_frame;
+	}
+
+	U64 getFrame() const
+	{
+		return m_frame;
+	}
+
+	/// Add the work of a flushed command buffer to the counters. It's thread-safe.
+	void onCommandBufferFlushed(const CommandBufferImpl& cmdb);
+
+	/// Get the work of all the command buffers that were flushed so far.
+	NullGrCounters getCounters() const;
+
+	/// Account the CPU memory of the mappable buffers.
+	void onBufferMemoryChanged(PtrSize allocated, PtrSize freed)
+	{
+		m_cpuMemory.fetchAdd(allocated);
+		m_cpuMemory.fetchSub(freed);
+	}
+
+	PtrSize getCpuMemory() const
+	{
+		return m_cpuMemory.load();
+	}
+
+	/// Track the command buffers that are alive.
+	void onCommandBufferCreatedOrDestroyed(Bool created)
+	{
+		if(created)
+		{
+			m_commandBufferCount.fetchAdd(1);
+		}
+		else
+		{
+			m_commandBufferCount.fetchSub(1);
+		}
+	}
+
+	U32 getCommandBufferCount() const
+	{
+		return m_commandBufferCount.load();
+	}
+
+private:
+	U64 m_frame = 0;
+	Atomic<PtrSize> m_cpuMemory = {0};
+	Atomic<U32> m_commandBufferCount = {0}; ///< The command buffers that are alive.
+
+	Atomic<U64> m_flushedCommandBufferCount = {0};
+	Atomic<U64> m_commandCount = {0};
+	Atomic<U64> m_renderPassCount = {0};
+	Atomic<U64> m_drawcallCount = {0};
+	Atomic<U64> m_dispatchCount = {0};
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,37 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/OcclusionQuery.h>
+#include <anki/gr/null/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Occlusion query implementation. It has no state.
+class OcclusionQueryImpl final : public OcclusionQuery
+{
+public:
+	OcclusionQueryImpl(GrManager* manager, CString name)
+		: OcclusionQuery(manager, name)
+	{
+	}
+
+	~OcclusionQueryImpl()
+	{
+	}
+
+	ANKI_USE_RESULT Error init()
+	{
+		return Error::NONE;
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,39 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Shader.h>
+#include <anki/gr/null/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Shader implementation. The binary is not kept.
+class ShaderImpl final : public Shader
+{
+public:
+	ShaderImpl(GrManager* manager, CString name)
+		: Shader(manager, name)
+	{
+	}
+
+	~ShaderImpl()
+	{
+	}
+
+	ANKI_USE_RESULT Error init(const ShaderInitInfo& init)
+	{
+		ANKI_ASSERT(init.m_shaderType != ShaderType::COUNT && init.m_binary.getSize() > 0);
+		m_shaderType = init.m_shaderType;
+		return Error::NONE;
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,63 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/gr/Texture.h>
+#include <anki/gr/null/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup null
+/// @{
+
+/// Texture implementation. It keeps the properties but not the texels.
+class TextureImpl final : public Texture
+{
+public:
+	TextureImpl(GrManager* manager, CString name)
+		: Texture(manager, name)
+	{
+	}
+
+	~TextureImpl()
+	{
+	}
+
+	ANKI_USE_RESULT Error init(const TextureInitInfo& init)
+	{
+		ANKI_ASSERT(init.isValid());
+
+		m_width = init.m_width;
+		m_height = init.m_height;
+		m_depth = init.m_depth;
+		m_texType = init.m_type;
+
+		if(m_texType == TextureType::_3D)
+		{
+			m_mipCount = min<U>(init.m_mipmapCount, computeMaxMipmapCount3d(m_width, m_height, m_depth));
+		}
+		else
+		{
+			m_mipCount = min<U>(init.m_mipmapCount, computeMaxMipmapCount2d(m_width, m_height));
+		}
+
+		m_layerCount = init.m_layerCount;
+		m_format = init.m_format;
+		m_aspect = computeFormatAspect(m_format);
+		m_usage = init.m_usage;
+
+		return Error::NONE;
+	}
+
+	Bool usageValid(TextureUsageBit usage) const
+	{
+		return (usage & m_usage) == usage;
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -47,9 +47,7 @@ Error Bloom::initExposure(const ConfigSet& config)
 	consts.add(
 		"TEX_SIZE", Vec2(m_r->getDownscaleBlur().getPassWidth(MAX_U), m_r->getDownscaleBlur().getPassHeight(MAX_U)));
 
-	const ShaderProgramResourceVariant* variant;
-	m_exposure.m_prog->getOrCreateVariant(consts.get(), variant);
-	m_exposure.m_grProg = variant->getProgram();
+	getProgramVariant(m_exposure.m_prog, consts.get(), m_exposure.m_grProg);
 
 	return Error::NONE;
 }
@@ -75,9 +73,7 @@ Error Bloom::initUpscale(const ConfigSet& config)
 	ShaderProgramResourceConstantValueInitList<1> consts(m_upscale.m_prog);
 	consts.add("TEX_SIZE", Vec2(m_upscale.m_width, m_upscale.m_height));
 
-	const ShaderProgramResourceVariant* variant;
-	m_upscale.m_prog->getOrCreateVariant(consts.get(), variant);
-	m_upscale.m_grProg = variant->getProgram();
+	getProgramVariant(m_upscale.m_prog, consts.get(), m_upscale.m_grProg);
 
 	return Error::NONE;
 }
@@ -90,9 +86,7 @@ Error Bloom::initSslf(const ConfigSet& cfg)
 	ShaderProgramResourceConstantValueInitList<1> consts(m_sslf.m_prog);
 	consts.add("INPUT_TEX_SIZE", UVec2(m_exposure.m_width, m_exposure.m_height));
 
-	const ShaderProgramResourceVariant* variant;
-	m_sslf.m_prog->getOrCreateVariant(consts.get(), variant);
-	m_sslf.m_grProg = variant->getProgram();
+	getProgramVariant(m_sslf.m_prog, consts.get(), m_sslf.m_grProg);
 
 	return Error::NONE;
 }
@@ -4,25 +4,13 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/renderer/Clusterer.h>
-#include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHiveTaskGraph.h>
 #include <anki/Collision.h>
+#include <anki/math/Simd.h>
 
 namespace anki
 {
 
-class UpdatePlanesPerspectiveCameraTask : public ThreadPoolTask
-{
-public:
-	Clusterer* m_clusterer = nullptr;
-	Bool m_frustumChanged;
-
-	Error operator()(U32 threadId, PtrSize threadsCount)
-	{
-		m_clusterer->update(threadId, threadsCount, m_frustumChanged);
-		return Error::NONE;
-	}
-};
-
 static Vec4 unproject(const F32 depth, const Vec2& ndc, const Vec4& projParams)
 {
 	Vec4 view;
@@ -144,7 +132,13 @@ void Clusterer::setClusterBoxes(const Vec4& projParams, U begin, U end)
 			yMax = (F32(y + 1) / m_counts[1] * 2.0 - 1.0) * projParams.y() * zMin;
 		}
 
-		m_clusterBoxes[i] = Aabb(Vec4(xMin, yMin, zMin, 0.0), Vec4(xMax, yMax, zMax, 0.0));
+		F32* row = &m_clusterBoxes[(z * m_counts[1] + y) * 6 * m_rowStride];
+		row[x] = xMin;
+		row[x + m_rowStride] = yMin;
+		row[x + m_rowStride * 2] = zMin;
+		row[x + m_rowStride * 3] = xMax;
+		row[x + m_rowStride * 4] = yMax;
+		row[x + m_rowStride * 5] = zMax;
 	}
 }
 
@@ -185,10 +179,12 @@ void Clusterer::init(const GenericMemoryPoolAllocator<U8>& alloc, U clusterCount
 
 	ANKI_ASSERT(count == m_allPlanes.getSize());
 
-	m_clusterBoxes.create(m_alloc, m_counts[0] * m_counts[1] * m_counts[2]);
+	// The SIMD tests read 4 clusters at a time so add some padding at the end
+	m_rowStride = getAlignedRoundUp(4, U32(m_counts[0]));
+	m_clusterBoxes.create(m_alloc, m_counts[1] * m_counts[2] * 6 * m_rowStride + 4, 0.0f);
 }
 
-void Clusterer::prepare(ThreadPool& threadPool, const ClustererPrepareInfo& inf)
+void Clusterer::prepare(ThreadHive& hive, const ClustererPrepareInfo& inf)
 {
 	Bool frustumChanged = m_projMat != inf.m_projMat;
 
@@ -244,18 +240,7 @@ void Clusterer::prepare(ThreadPool& threadPool, const ClustererPrepareInfo& inf)
 	//
 	// Issue parallel jobs
 	//
-	UpdatePlanesPerspectiveCameraTask job;
-	job.m_clusterer = this;
-	job.m_frustumChanged = frustumChanged;
-
-	for(U i = 0; i < threadPool.getThreadCount(); i++)
-	{
-		threadPool.assignNewTask(i, &job);
-	}
-
-	// Sync threads
-	Error err = threadPool.waitForAllThreadsToFinish();
-	(void)err;
+	update(hive, frustumChanged);
 }
 
 void Clusterer::computeSplitRange(const CollisionShape& cs, U& zBegin, U& zEnd) const
@@ -347,135 +332,201 @@ void Clusterer::quickReduction(const Aabb& aabb, const Mat4& mvp, U& xBegin, U&
 	ANKI_ASSERT(yBegin <= m_counts[1] && yEnd <= m_counts[1]);
 }
 
-template<typename TFunc>
-void Clusterer::boxReduction(
-	U xBegin, U xEnd, U yBegin, U yEnd, U zBegin, U zEnd, ClustererTestResult& rez, TFunc func) const
+void Clusterer::binSphereRow(const Sphere& sphere, U xBegin, U xEnd, U y, U z, ClustererTestResult& rez) const
 {
-	U zcount = zEnd - zBegin;
-	U ycount = yEnd - yBegin;
-	U xcount = xEnd - xBegin;
-
-	if(xcount > ycount && xcount > zcount)
+	const F32* minX = getClusterRowBoxes(y, z);
+	const F32* minY = minX + m_rowStride;
+	const F32* minZ = minY + m_rowStride;
+	const F32* maxX = minZ + m_rowStride;
+	const F32* maxY = maxX + m_rowStride;
+	const F32* maxZ = maxY + m_rowStride;
+	const Vec4& c = sphere.getCenter();
+
+	U x = xBegin;
+#if ANKI_SIMD == ANKI_SIMD_SSE
+	const __m128 cx = _mm_set1_ps(c.x());
+	const __m128 cy = _mm_set1_ps(c.y());
+	const __m128 cz = _mm_set1_ps(c.z());
+	const __m128 radiusSq = _mm_set1_ps(sphere.getRadiusSquared());
+	const __m128 zero = _mm_setzero_ps();
+
+	for(; x < xEnd; x += 4)
 	{
-		for(U z = zBegin; z < zEnd; ++z)
-		{
-			const U zc = (m_counts[0] * m_counts[1]) * z;
-
-			for(U y = yBegin; y < yEnd; ++y)
-			{
-				const U yc = zc + m_counts[0] * y;
-
-				// Do a reduction to avoid some checks
-				U firstX = MAX_U;
-
-				for(U x = xBegin; x < xEnd; ++x)
-				{
-					U i = yc + x;
-
-					if(func(m_clusterBoxes[i]))
-					{
-						firstX = x;
-						break;
-					}
-				}
-
-				for(U x = xEnd - 1; x >= firstX; --x)
-				{
-					U i = yc + x;
-
-					if(func(m_clusterBoxes[i]))
-					{
-						for(U a = firstX; a <= x; ++a)
-						{
-							rez.pushBack(a, y, z);
-						}
+		// The distance of the center from the boxes in every axis. It's zero if it's between the min and the max
+		__m128 dx = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minX + x), cx), _mm_sub_ps(cx, _mm_loadu_ps(maxX + x)));
+		__m128 dy = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minY + x), cy), _mm_sub_ps(cy, _mm_loadu_ps(maxY + x)));
+		__m128 dz = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minZ + x), cz), _mm_sub_ps(cz, _mm_loadu_ps(maxZ + x)));
+		dx = _mm_max_ps(dx, zero);
+		dy = _mm_max_ps(dy, zero);
+		dz = _mm_max_ps(dz, zero);
+
+		__m128 distSq = _mm_mul_ps(dx, dx);
+		distSq = _mm_add_ps(distSq, _mm_mul_ps(dy, dy));
+		distSq = _mm_add_ps(distSq, _mm_mul_ps(dz, dz));
+
+		pushRowMask(_mm_movemask_ps(_mm_cmple_ps(distSq, radiusSq)), x, xEnd, y, z, rez);
+	}
+#elif ANKI_SIMD == ANKI_SIMD_NEON
+	const float32x4_t cx = vdupq_n_f32(c.x());
+	const float32x4_t cy = vdupq_n_f32(c.y());
+	const float32x4_t cz = vdupq_n_f32(c.z());
+	const float32x4_t radiusSq = vdupq_n_f32(sphere.getRadiusSquared());
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const uint32x4_t laneBits = {1, 2, 4, 8};
+
+	for(; x < xEnd; x += 4)
+	{
+		float32x4_t dx = vmaxq_f32(vsubq_f32(vld1q_f32(minX + x), cx), vsubq_f32(cx, vld1q_f32(maxX + x)));
+		float32x4_t dy = vmaxq_f32(vsubq_f32(vld1q_f32(minY + x), cy), vsubq_f32(cy, vld1q_f32(maxY + x)));
+		float32x4_t dz = vmaxq_f32(vsubq_f32(vld1q_f32(minZ + x), cz), vsubq_f32(cz, vld1q_f32(maxZ + x)));
+		dx = vmaxq_f32(dx, zero);
+		dy = vmaxq_f32(dy, zero);
+		dz = vmaxq_f32(dz, zero);
+
+		float32x4_t distSq = vmulq_f32(dx, dx);
+		distSq = vmlaq_f32(distSq, dy, dy);
+		distSq = vmlaq_f32(distSq, dz, dz);
+
+		const uint32x4_t bits = vandq_u32(vcleq_f32(distSq, radiusSq), laneBits);
+		const U32 mask = vgetq_lane_u32(bits, 0) | vgetq_lane_u32(bits, 1) | vgetq_lane_u32(bits, 2)
+						 | vgetq_lane_u32(bits, 3);
+		pushRowMask(mask, x, xEnd, y, z, rez);
+	}
+#else
+	for(; x < xEnd; ++x)
+	{
+		const F32 dx = max(0.0f, max(minX[x] - c.x(), c.x() - maxX[x]));
+		const F32 dy = max(0.0f, max(minY[x] - c.y(), c.y() - maxY[x]));
+		const F32 dz = max(0.0f, max(minZ[x] - c.z(), c.z() - maxZ[x]));
 
-						break;
-					}
-				}
-			}
+		if(dx * dx + dy * dy + dz * dz <= sphere.getRadiusSquared())
+		{
+			rez.pushBack(x, y, z);
 		}
 	}
-	else if(ycount > xcount && ycount > zcount)
+#endif
+}
+
+void Clusterer::binPlanesRow(ConstWeakArray<Plane> planes, U xBegin, U xEnd, U y, U z, ClustererTestResult& rez) const
+{
+	const F32* minX = getClusterRowBoxes(y, z);
+	const F32* minY = minX + m_rowStride;
+	const F32* minZ = minY + m_rowStride;
+	const F32* maxX = minZ + m_rowStride;
+	const F32* maxY = maxX + m_rowStride;
+	const F32* maxZ = maxY + m_rowStride;
+
+	U x = xBegin;
+#if ANKI_SIMD == ANKI_SIMD_SSE
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for(; x < xEnd; x += 4)
 	{
-		for(U z = zBegin; z < zEnd; ++z)
+		const __m128 bminX = _mm_loadu_ps(minX + x);
+		const __m128 bminY = _mm_loadu_ps(minY + x);
+		const __m128 bminZ = _mm_loadu_ps(minZ + x);
+		const __m128 bmaxX = _mm_loadu_ps(maxX + x);
+		const __m128 bmaxY = _mm_loadu_ps(maxY + x);
+		const __m128 bmaxZ = _mm_loadu_ps(maxZ + x);
+
+		const __m128 cx = _mm_mul_ps(_mm_add_ps(bminX, bmaxX), half);
+		const __m128 cy = _mm_mul_ps(_mm_add_ps(bminY, bmaxY), half);
+		const __m128 cz = _mm_mul_ps(_mm_add_ps(bminZ, bmaxZ), half);
+		const __m128 ex = _mm_mul_ps(_mm_sub_ps(bmaxX, bminX), half);
+		const __m128 ey = _mm_mul_ps(_mm_sub_ps(bmaxY, bminY), half);
+		const __m128 ez = _mm_mul_ps(_mm_sub_ps(bmaxZ, bminZ), half);
+
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for(const Plane& plane : planes)
 		{
-			const U zc = (m_counts[0] * m_counts[1]) * z;
-
-			for(U x = xBegin; x < xEnd; ++x)
-			{
-				// Do a reduction to avoid some checks
-				U firstY = MAX_U;
-
-				for(U y = yBegin; y < yEnd; ++y)
-				{
-					const U i = zc + m_counts[0] * y + x;
-
-					if(func(m_clusterBoxes[i]))
-					{
-						firstY = y;
-						break;
-					}
-				}
-
-				for(U y = yEnd - 1; y >= firstY; --y)
-				{
-					const U i = zc + m_counts[0] * y + x;
-
-					if(func(m_clusterBoxes[i]))
-					{
-						for(U a = firstY; a <= y; ++a)
-						{
-							rez.pushBack(x, a, z);
-						}
-
-						break;
-					}
-				}
-			}
+			// The signed distance of the center plus how far the box reaches towards the normal
+			const Vec4& n = plane.getNormal();
+			__m128 dist = _mm_mul_ps(cx, _mm_set1_ps(n.x()));
+			dist = _mm_add_ps(dist, _mm_mul_ps(cy, _mm_set1_ps(n.y())));
+			dist = _mm_add_ps(dist, _mm_mul_ps(cz, _mm_set1_ps(n.z())));
+			dist = _mm_sub_ps(dist, _mm_set1_ps(plane.getOffset()));
+
+			__m128 reach = _mm_mul_ps(ex, _mm_set1_ps(absolute(n.x())));
+			reach = _mm_add_ps(reach, _mm_mul_ps(ey, _mm_set1_ps(absolute(n.y()))));
+			reach = _mm_add_ps(reach, _mm_mul_ps(ez, _mm_set1_ps(absolute(n.z()))));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, reach), zero));
 		}
+
+		pushRowMask(_mm_movemask_ps(inside), x, xEnd, y, z, rez);
 	}
-	else
+#elif ANKI_SIMD == ANKI_SIMD_NEON
+	const float32x4_t half = vdupq_n_f32(0.5f);
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const uint32x4_t laneBits = {1, 2, 4, 8};
+
+	for(; x < xEnd; x += 4)
 	{
-		for(U y = yBegin; y < yEnd; ++y)
+		const float32x4_t bminX = vld1q_f32(minX + x);
+		const float32x4_t bminY = vld1q_f32(minY + x);
+		const float32x4_t bminZ = vld1q_f32(minZ + x);
+		const float32x4_t bmaxX = vld1q_f32(maxX + x);
+		const float32x4_t bmaxY = vld1q_f32(maxY + x);
+		const float32x4_t bmaxZ = vld1q_f32(maxZ + x);
+
+		const float32x4_t cx = vmulq_f32(vaddq_f32(bminX, bmaxX), half);
+		const float32x4_t cy = vmulq_f32(vaddq_f32(bminY, bmaxY), half);
+		const float32x4_t cz = vmulq_f32(vaddq_f32(bminZ, bmaxZ), half);
+		const float32x4_t ex = vmulq_f32(vsubq_f32(bmaxX, bminX), half);
+		const float32x4_t ey = vmulq_f32(vsubq_f32(bmaxY, bminY), half);
+		const float32x4_t ez = vmulq_f32(vsubq_f32(bmaxZ, bminZ), half);
+
+		uint32x4_t inside = vdupq_n_u32(0xFFFFFFFF);
+		for(const Plane& plane : planes)
 		{
-			for(U x = xBegin; x < xEnd; ++x)
-			{
-				// Do a reduction to avoid some checks
-				U firstZ = MAX_U;
+			const Vec4& n = plane.getNormal();
+			float32x4_t dist = vmulq_n_f32(cx, n.x());
+			dist = vmlaq_n_f32(dist, cy, n.y());
+			dist = vmlaq_n_f32(dist, cz, n.z());
+			dist = vsubq_f32(dist, vdupq_n_f32(plane.getOffset()));
 
-				for(U z = zBegin; z < zEnd; ++z)
-				{
-					const U i = (m_counts[0] * m_counts[1]) * z + m_counts[0] * y + x;
+			float32x4_t reach = vmulq_n_f32(ex, absolute(n.x()));
+			reach = vmlaq_n_f32(reach, ey, absolute(n.y()));
+			reach = vmlaq_n_f32(reach, ez, absolute(n.z()));
 
-					if(func(m_clusterBoxes[i]))
-					{
-						firstZ = z;
-						break;
-					}
-				}
+			inside = vandq_u32(inside, vcgeq_f32(vaddq_f32(dist, reach), zero));
+		}
 
-				for(U z = zEnd - 1; z >= firstZ; --z)
-				{
-					const U i = (m_counts[0] * m_counts[1]) * z + m_counts[0] * y + x;
+		const uint32x4_t bits = vandq_u32(inside, laneBits);
+		const U32 mask = vgetq_lane_u32(bits, 0) | vgetq_lane_u32(bits, 1) | vgetq_lane_u32(bits, 2)
+						 | vgetq_lane_u32(bits, 3);
+		pushRowMask(mask, x, xEnd, y, z, rez);
+	}
+#else
+	for(; x < xEnd; ++x)
+	{
+		const Aabb box(Vec4(minX[x], minY[x], minZ[x], 0.0f), Vec4(maxX[x], maxY[x], maxZ[x], 0.0f));
 
-					if(func(m_clusterBoxes[i]))
-					{
-						for(U a = firstZ; a <= z; ++a)
-						{
-							rez.pushBack(x, y, a);
-						}
+		Bool inside = true;
+		for(U i = 0; i < planes.getSize() && inside; ++i)
+		{
+			inside = box.testPlane(planes[i]) >= 0.0f;
+		}
 
-						break;
-					}
-				}
-			}
+		if(inside)
+		{
+			rez.pushBack(x, y, z);
 		}
 	}
+#endif
 }
 
 void Clusterer::binSphere(const Sphere& s, const Aabb& aabb, ClustererTestResult& rez) const
 {
+	// Cull the z splits early. The shape might be out of them
+	U zBegin, zEnd;
+	computeSplitRange(s, zBegin, zEnd);
+	if(zBegin >= zEnd)
+	{
+		return;
+	}
+
 	// Move the sphere to view space
 	Vec4 cVSpace = (m_viewMat * s.getCenter().xyz1()).xyz0();
 	Sphere sphere(cVSpace, s.getRadius());
@@ -489,18 +540,29 @@ void Clusterer::binSphere(const Sphere& s, const Aabb& aabb, ClustererTestResult
 	ANKI_ASSERT(box.getMax().xyz() > box.getMin().xyz());
 
 	// Quick reduction
-	U xBegin, xEnd, yBegin, yEnd, zBegin, zEnd;
-	computeSplitRange(s, zBegin, zEnd);
+	U xBegin, xEnd, yBegin, yEnd;
 	quickReduction(box, m_projMat, xBegin, xEnd, yBegin, yEnd);
 
 	// Detailed
-	boxReduction(xBegin, xEnd, yBegin, yEnd, zBegin, zEnd, rez, [&](const Aabb& aabb) {
-		return testCollisionShapes(sphere, aabb);
-	});
+	for(U z = zBegin; z < zEnd; ++z)
+	{
+		for(U y = yBegin; y < yEnd; ++y)
+		{
+			binSphereRow(sphere, xBegin, xEnd, y, z, rez);
+		}
+	}
 }
 
 void Clusterer::binGeneric(const CollisionShape& cs, const Aabb& box0, ClustererTestResult& rez) const
 {
+	// Cull the z splits early. The shape might be out of them
+	U zBegin, zEnd;
+	computeSplitRange(cs, zBegin, zEnd);
+	if(zBegin >= zEnd)
+	{
+		return;
+	}
+
 	// Move the box to view space
 	Aabb box = box0.getTransformed(Transform(m_viewMat));
 
@@ -509,8 +571,7 @@ void Clusterer::binGeneric(const CollisionShape& cs, const Aabb& box0, Clusterer
 	ANKI_ASSERT(box.getMax().xyz() > box.getMin().xyz());
 
 	// Quick reduction
-	U xBegin, xEnd, yBegin, yEnd, zBegin, zEnd;
-	computeSplitRange(cs, zBegin, zEnd);
+	U xBegin, xEnd, yBegin, yEnd;
 	quickReduction(box, m_projMat, xBegin, xEnd, yBegin, yEnd);
 
 	// Detailed
@@ -646,6 +707,14 @@ void Clusterer::binPerspectiveFrustum(const PerspectiveFrustum& fr, const Aabb&
 {
 	rez.m_count = 0;
 
+	// Cull the z splits early. The shape might be out of them
+	U zBegin, zEnd;
+	computeSplitRange(fr, zBegin, zEnd);
+	if(zBegin >= zEnd)
+	{
+		return;
+	}
+
 	// Move the box to view space
 	Aabb box = box0.getTransformed(Transform(m_viewMat));
 
@@ -654,8 +723,7 @@ void Clusterer::binPerspectiveFrustum(const PerspectiveFrustum& fr, const Aabb&
 	ANKI_ASSERT(box.getMax().xyz() > box.getMin().xyz());
 
 	// Quick reduction
-	U xBegin, xEnd, yBegin, yEnd, zBegin, zEnd;
-	computeSplitRange(fr, zBegin, zEnd);
+	U xBegin, xEnd, yBegin, yEnd;
 	quickReduction(box, m_projMat, xBegin, xEnd, yBegin, yEnd);
 
 	// Detailed tests
@@ -665,84 +733,76 @@ void Clusterer::binPerspectiveFrustum(const PerspectiveFrustum& fr, const Aabb&
 		vspacePlanes[i] = fr.getPlanesWorldSpace()[i + 1].getTransformed(Transform(m_viewMat));
 	}
 
-	boxReduction(xBegin, xEnd, yBegin, yEnd, zBegin, zEnd, rez, [&](const Aabb& aabb) {
-		for(const Plane& p : vspacePlanes)
+	const ConstWeakArray<Plane> planes(&vspacePlanes[0], vspacePlanes.getSize());
+	for(U z = zBegin; z < zEnd; ++z)
+	{
+		for(U y = yBegin; y < yEnd; ++y)
 		{
-			if(aabb.testPlane(p) < 0.0)
-			{
-				return false;
-			}
+			binPlanesRow(planes, xBegin, xEnd, y, z, rez);
 		}
-
-		return true;
-	});
+	}
 }
 
-void Clusterer::update(U32 threadId, PtrSize threadsCount, Bool frustumChanged)
+void Clusterer::update(ThreadHive& hive, Bool frustumChanged)
 {
-	PtrSize start, end;
-
 	const Transform& trf = m_camTrf;
 	const Vec4& projParams = m_unprojParams;
 
-	if(frustumChanged)
-	{
-		// Re-calculate the planes in local space
-
-		// First the top looking planes
-		ThreadPoolTask::choseStartEnd(threadId, threadsCount, m_planesYW.getSize(), start, end);
+	// The planes and the boxes don't depend on each other so let them run concurrently
+	ThreadHiveTaskGraph graph(hive);
 
-		for(U i = start; i < end; i++)
+	// First the top looking planes
+	graph.addParallelFor(0, m_planesYW.getSize(), 0, [=](PtrSize begin, PtrSize end, U32) -> Error {
+		for(PtrSize i = begin; i < end; i++)
 		{
-			calcPlaneY(i, projParams);
+			if(frustumChanged)
+			{
+				// Re-calculate the planes in local space
+				calcPlaneY(i, projParams);
+			}
 
 			m_planesYW[i] = m_planesY[i].getTransformed(trf);
 		}
 
-		// Then the right looking planes
-		ThreadPoolTask::choseStartEnd(threadId, threadsCount, m_planesXW.getSize(), start, end);
+		return Error::NONE;
+	});
 
-		for(U j = start; j < end; j++)
+	// Then the right looking planes
+	graph.addParallelFor(0, m_planesXW.getSize(), 0, [=](PtrSize begin, PtrSize end, U32) -> Error {
+		for(PtrSize j = begin; j < end; j++)
 		{
-			calcPlaneX(j, projParams);
+			if(frustumChanged)
+			{
+				calcPlaneX(j, projParams);
+			}
 
 			m_planesXW[j] = m_planesX[j].getTransformed(trf);
 		}
 
-		// The boxes
-		ThreadPoolTask::choseStartEnd(threadId, threadsCount, m_clusterBoxes.getSize(), start, end);
-		setClusterBoxes(projParams, start, end);
-	}
-	else
-	{
-		// Only transform planes
-
-		// First the top looking planes
-		ThreadPoolTask::choseStartEnd(threadId, threadsCount, m_planesYW.getSize(), start, end);
-
-		for(U i = start; i < end; i++)
-		{
-			m_planesYW[i] = m_planesY[i].getTransformed(trf);
-		}
-
-		// Then the right looking planes
-		ThreadPoolTask::choseStartEnd(threadId, threadsCount, m_planesXW.getSize(), start, end);
+		return Error::NONE;
+	});
 
-		for(U j = start; j < end; j++)
-		{
-			m_planesXW[j] = m_planesX[j].getTransformed(trf);
-		}
+	// The boxes
+	if(frustumChanged)
+	{
+		graph.addParallelFor(0, getClusterCount(), 0, [=](PtrSize begin, PtrSize end, U32) -> Error {
+			setClusterBoxes(projParams, begin, end);
+			return Error::NONE;
+		});
 	}
 
 	// Finaly tranform the near and far planes
-	if(threadId == 0)
-	{
+	graph.addTask([=](U32) -> Error {
 		*m_nearPlane = Plane(Vec4(0.0, 0.0, -1.0, 0.0), m_near);
 		m_nearPlane->transform(trf);
 
 		*m_farPlane = Plane(Vec4(0.0, 0.0, 1.0, 0.0), -m_far);
 		m_farPlane->transform(trf);
-	}
+		return Error::NONE;
+	});
+
+	const Error err = graph.run();
+	(void)err;
 }
 
 void Clusterer::debugDraw(ClustererDebugDrawer& drawer) const
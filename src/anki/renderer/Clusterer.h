@@ -14,7 +14,7 @@ namespace anki
 {
 
 // Forward
-class ThreadPool;
+class ThreadHive;
 class PerspectiveFrustum;
 
 /// @addtogroup renderer
@@ -133,8 +133,6 @@ public:
 /// Collection of clusters for visibility tests.
 class Clusterer
 {
-	friend class UpdatePlanesPerspectiveCameraTask;
-
 public:
 	Clusterer()
 	{
@@ -145,7 +143,7 @@ public:
 	void init(const GenericMemoryPoolAllocator<U8>& alloc, U clusterCountX, U clusterCountY, U clusterCountZ);
 
 	/// Prepare for visibility tests.
-	void prepare(ThreadPool& threadpool, const ClustererPrepareInfo& inf);
+	void prepare(ThreadHive& hive, const ClustererPrepareInfo& inf);
 
 	void initTestResults(const GenericMemoryPoolAllocator<U8>& alloc, ClustererTestResult& rez) const;
 
@@ -188,6 +186,23 @@ public:
 	/// Call this with a result.
 	void debugDrawResult(const ClustererTestResult& rez, ClustererDebugDrawer& drawer) const;
 
+anki_internal:
+	/// Get the box of a cluster in view space. Call this after prepare()
+	Aabb getClusterBox(U x, U y, U z) const
+	{
+		ANKI_ASSERT(x < m_counts[0] && y < m_counts[1] && z < m_counts[2]);
+		const F32* row = getClusterRowBoxes(y, z);
+		return Aabb(Vec4(row[x], row[x + m_rowStride], row[x + m_rowStride * 2], 0.0f),
+			Vec4(row[x + m_rowStride * 3], row[x + m_rowStride * 4], row[x + m_rowStride * 5], 0.0f));
+	}
+
+	/// Test a sphere in view space against a row of clusters. It tests 4 clusters at a time.
+	void binSphereRow(const Sphere& sphere, U xBegin, U xEnd, U y, U z, ClustererTestResult& rez) const;
+
+	/// Test a convex shape that is defined by planes in view space against a row of clusters. It tests 4 clusters at a
+	/// time.
+	void binPlanesRow(ConstWeakArray<Plane> planes, U xBegin, U xEnd, U y, U z, ClustererTestResult& rez) const;
+
 private:
 	GenericMemoryPoolAllocator<U8> m_alloc;
 
@@ -202,8 +217,10 @@ private:
 	Plane* m_nearPlane; ///< In world space
 	Plane* m_farPlane; ///< In world space
 
-	/// Cluster boxes in view space.
-	DynamicArray<Aabb> m_clusterBoxes;
+	/// Cluster boxes in view space. They are in SoA layout for the SIMD tests. Every row of clusters (the clusters
+	/// with the same y and z) has 6 arrays (min x, y, z and max x, y, z) of m_rowStride elements.
+	DynamicArray<F32> m_clusterBoxes;
+	U32 m_rowStride = 0;
 
 	Mat4 m_viewMat = Mat4::getIdentity();
 	Mat4 m_projMat = Mat4::getIdentity();
@@ -230,13 +247,26 @@ private:
 	/// Quick reduction.
 	void quickReduction(const Aabb& aabb, const Mat4& mvp, U& xBegin, U& xEnd, U& yBegin, U& yEnd) const;
 
-	/// Box based reduction.
-	template<typename TFunc>
-	void boxReduction(U xBegin, U xEnd, U yBegin, U yEnd, U zBegin, U zEnd, ClustererTestResult& rez, TFunc func) const;
+	const F32* getClusterRowBoxes(U y, U z) const
+	{
+		return &m_clusterBoxes[(z * m_counts[1] + y) * 6 * m_rowStride];
+	}
+
+	/// Push the clusters of a row that are set in the mask. Bit N of the mask is the cluster x + N.
+	static void pushRowMask(U32 mask, U x, U xEnd, U y, U z, ClustererTestResult& rez)
+	{
+		for(U i = 0; i < 4 && x + i < xEnd; ++i)
+		{
+			if(mask & (1u << i))
+			{
+				rez.pushBack(x + i, y, z);
+			}
+		}
+	}
 
 	void computeSplitRange(const CollisionShape& cs, U& zBegin, U& zEnd) const;
 
-	void update(U32 threadId, PtrSize threadsCount, Bool frustumChanged);
+	void update(ThreadHive& hive, Bool frustumChanged);
 
 	/// Calculate and set a top looking plane.
 	void calcPlaneY(U i, const Vec4& projParams);
@@ -56,6 +56,10 @@ class ShaderProgramResourceVariant;
 /// Don't create second level command buffers if they contain more drawcalls than this constant.
 const U MIN_DRAWCALLS_PER_2ND_LEVEL_COMMAND_BUFFER = 16;
 
+/// Don't create second level command buffers that take less CPU time than that to record. Less work doesn't pay for the
+/// command buffer and the task.
+const Second MIN_RECORDING_TIME_PER_2ND_LEVEL_COMMAND_BUFFER = 50.0 / 1000000.0;
+
 /// FS size is rendererSize/FS_FRACTION.
 const U FS_FRACTION = 2;
 
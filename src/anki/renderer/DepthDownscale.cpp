@@ -64,9 +64,7 @@ Error DepthDownscale::initInternal(const ConfigSet&)
 	ShaderProgramResourceMutationInitList<3> mutations(m_prog);
 	mutations.add("COPY_TO_CLIENT", 0).add("TYPE", 0).add("SAMPLE_RESOLVE_TYPE", 2);
 
-	const ShaderProgramResourceVariant* variant;
-	m_prog->getOrCreateVariant(mutations.get(), variant);
-	m_passes[0].m_grProg = variant->getProgram();
+	getProgramVariant(m_prog, mutations.get(), m_passes[0].m_grProg);
 
 	for(U i = 1; i < m_passes.getSize(); ++i)
 	{
@@ -77,8 +75,7 @@ Error DepthDownscale::initInternal(const ConfigSet&)
 			mutations[0].m_value = 1;
 		}
 
-		m_prog->getOrCreateVariant(mutations.get(), variant);
-		m_passes[i].m_grProg = variant->getProgram();
+		getProgramVariant(m_prog, mutations.get(), m_passes[i].m_grProg);
 	}
 
 	// Copy to buffer
@@ -62,7 +62,6 @@ Error DownscaleBlur::initInternal(const ConfigSet&)
 	}
 
 	// Shader programs
-	const ShaderProgramResourceVariant* variant = nullptr;
 	if(m_useCompute)
 	{
 		ANKI_CHECK(getResourceManager().loadResource("shaders/DownscaleBlurCompute.glslp", m_prog));
@@ -70,14 +69,13 @@ Error DownscaleBlur::initInternal(const ConfigSet&)
 		ShaderProgramResourceConstantValueInitList<1> consts(m_prog);
 		consts.add("WORKGROUP_SIZE", UVec2(m_workgroupSize[0], m_workgroupSize[1]));
 
-		m_prog->getOrCreateVariant(consts.get(), variant);
+		getProgramVariant(m_prog, consts.get(), m_grProg);
 	}
 	else
 	{
 		ANKI_CHECK(getResourceManager().loadResource("shaders/DownscaleBlur.glslp", m_prog));
-		m_prog->getOrCreateVariant(variant);
+		getProgramVariant(m_prog, m_grProg);
 	}
-	m_grProg = variant->getProgram();
 
 	return Error::NONE;
 }
@@ -10,6 +10,7 @@
 #include <anki/renderer/Renderer.h>
 #include <anki/core/Trace.h>
 #include <anki/util/Logger.h>
+#include <anki/util/HighRezTimer.h>
 
 namespace anki
 {
@@ -46,6 +47,8 @@ void RenderableDrawer::drawRange(Pass pass,
 	const RenderableQueueElement* end)
 {
 	ANKI_ASSERT(begin && end && begin < end);
+	const Second startTime = HighRezTimer::getCurrentTime();
+	const U32 renderableCount = end - begin;
 
 	DrawContext ctx;
 	ctx.m_queueCtx.m_viewMatrix = viewMat;
@@ -66,6 +69,23 @@ void RenderableDrawer::drawRange(Pass pass,
 
 	// Flush the last drawcall
 	flushDrawcall(ctx);
+
+	const Second time = HighRezTimer::getCurrentTime() - startTime;
+	m_frameRecordingTimeNs.fetchAdd(U64(time * 1000000000.0));
+	m_frameRenderableCount.fetchAdd(renderableCount);
+}
+
+void RenderableDrawer::endFrame()
+{
+	const U32 renderableCount = m_frameRenderableCount.exchange(0);
+	const U64 timeNs = m_frameRecordingTimeNs.exchange(0);
+
+	if(renderableCount > 0)
+	{
+		// Smooth it because the cost of the renderables varies a lot from frame to frame
+		const Second time = Second(timeNs) / (Second(renderableCount) * 1000000000.0);
+		m_recordingTimePerRenderable = mix(m_recordingTimePerRenderable, time, 0.1);
+	}
 }
 
 void RenderableDrawer::flushDrawcall(DrawContext& ctx)
@@ -100,7 +120,7 @@ void RenderableDrawer::drawSingle(DrawContext& ctx)
 	}
 	else
 	{
-		lod = min<U8>(m_r->calculateLod(rqel.m_distanceFromCamera), MAX_LOD_COUNT - 1);
+		lod = min<U8>(rqel.m_lod, MAX_LOD_COUNT - 1);
 	}
 
 	const Bool shouldFlush =
@@ -32,6 +32,9 @@ public:
 
 	~RenderableDrawer();
 
+	/// Draw a range of renderables. The consecutive renderables that can be merged become instanced drawcalls of up to
+	/// MAX_INSTANCES instances. The visibility sorts the render queues so the mergeable renderables are consecutive.
+	/// It's thread-safe.
 	void drawRange(Pass pass,
 		const Mat4& viewMat,
 		const Mat4& viewProjMat,
@@ -39,9 +42,22 @@ public:
 		const RenderableQueueElement* begin,
 		const RenderableQueueElement* end);
 
+	/// The average CPU time of recording a renderable. It's measured in the previous frames.
+	Second getRecordingTimePerRenderable() const
+	{
+		return m_recordingTimePerRenderable;
+	}
+
+	/// Update the average recording time with the measurements of the frame. Call it when the recording is done.
+	void endFrame();
+
 private:
 	Renderer* m_r;
 
+	Second m_recordingTimePerRenderable = 5.0 / 1000000.0; ///< Some initial guess.
+	Atomic<U64> m_frameRecordingTimeNs = {0};
+	Atomic<U32> m_frameRenderableCount = {0};
+
 	void flushDrawcall(DrawContext& ctx);
 
 	void drawSingle(DrawContext& ctx);
@@ -67,13 +67,10 @@ Error FinalComposite::initInternal(const ConfigSet& config)
 	ShaderProgramResourceConstantValueInitList<2> consts(m_prog);
 	consts.add("LUT_SIZE", U32(LUT_SIZE)).add("FB_SIZE", UVec2(m_r->getWidth(), m_r->getHeight()));
 
-	const ShaderProgramResourceVariant* variant;
-	m_prog->getOrCreateVariant(mutations.get(), consts.get(), variant);
-	m_grProgs[0] = variant->getProgram();
+	getProgramVariant(m_prog, mutations.get(), consts.get(), m_grProgs[0]);
 
 	mutations[3].m_value = 1;
-	m_prog->getOrCreateVariant(mutations.get(), consts.get(), variant);
-	m_grProgs[1] = variant->getProgram();
+	getProgramVariant(m_prog, mutations.get(), consts.get(), m_grProgs[1]);
 
 	return Error::NONE;
 }
@@ -67,9 +67,7 @@ Error ForwardShading::initVol()
 		.add("SRC_SIZE", Vec2(m_r->getWidth() / VOLUMETRIC_FRACTION, m_r->getHeight() / VOLUMETRIC_FRACTION))
 		.add("FB_SIZE", Vec2(m_width, m_height));
 
-	const ShaderProgramResourceVariant* variant;
-	m_vol.m_prog->getOrCreateVariant(consts.get(), variant);
-	m_vol.m_grProg = variant->getProgram();
+	getProgramVariant(m_vol.m_prog, consts.get(), m_vol.m_grProg);
 
 	return Error::NONE;
 }
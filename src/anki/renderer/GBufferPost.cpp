@@ -39,9 +39,7 @@ Error GBufferPost::initInternal(const ConfigSet& cfg)
 	consts.add("CLUSTER_COUNT_Y", U32(cfg.getNumber("r.clusterSizeY")));
 	consts.add("CLUSTER_COUNT_Z", U32(cfg.getNumber("r.clusterSizeZ")));
 
-	const ShaderProgramResourceVariant* variant;
-	m_prog->getOrCreateVariant(consts.get(), variant);
-	m_grProg = variant->getProgram();
+	getProgramVariant(m_prog, consts.get(), m_grProg);
 
 	// Create FB descr
 	m_fbDescr.m_colorAttachmentCount = 2;
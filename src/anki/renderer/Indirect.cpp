@@ -165,9 +165,7 @@ Error Indirect::initIrradiance(const ConfigSet& config)
 		consts.add("ENV_TEX_TILE_SIZE", U32(m_irradiance.m_envMapReadSize));
 		consts.add("ENV_TEX_MIP", envMapReadMip);
 
-		const ShaderProgramResourceVariant* variant;
-		m_irradiance.m_prog->getOrCreateVariant(consts.get(), variant);
-		m_irradiance.m_grProg = variant->getProgram();
+		getProgramVariant(m_irradiance.m_prog, consts.get(), m_irradiance.m_grProg);
 	}
 
 	return Error::NONE;
@@ -179,9 +177,7 @@ Error Indirect::initIrradianceToRefl(const ConfigSet& cfg)
 	ANKI_CHECK(
 		m_r->getResourceManager().loadResource("shaders/ApplyIrradianceToReflection.glslp", m_irradianceToRefl.m_prog));
 
-	const ShaderProgramResourceVariant* variant;
-	m_irradianceToRefl.m_prog->getOrCreateVariant(variant);
-	m_irradianceToRefl.m_grProg = variant->getProgram();
+	getProgramVariant(m_irradianceToRefl.m_prog, m_irradianceToRefl.m_grProg);
 
 	return Error::NONE;
 }
@@ -57,9 +57,7 @@ Error LensFlare::initSprite(const ConfigSet& config)
 
 	ShaderProgramResourceConstantValueInitList<1> consts(m_realProg);
 	consts.add("MAX_SPRITES", U32(m_maxSprites));
-	const ShaderProgramResourceVariant* variant;
-	m_realProg->getOrCreateVariant(consts.get(), variant);
-	m_realGrProg = variant->getProgram();
+	getProgramVariant(m_realProg, consts.get(), m_realGrProg);
 
 	return Error::NONE;
 }
@@ -79,9 +77,7 @@ Error LensFlare::initOcclusion(const ConfigSet& config)
 	ShaderProgramResourceConstantValueInitList<1> consts(m_updateIndirectBuffProg);
 	consts.add("IN_DEPTH_MAP_SIZE", Vec2(m_r->getWidth() / 2 / 2, m_r->getHeight() / 2 / 2));
 
-	const ShaderProgramResourceVariant* variant;
-	m_updateIndirectBuffProg->getOrCreateVariant(consts.get(), variant);
-	m_updateIndirectBuffGrProg = variant->getProgram();
+	getProgramVariant(m_updateIndirectBuffProg, consts.get(), m_updateIndirectBuffGrProg);
 
 	return Error::NONE;
 }
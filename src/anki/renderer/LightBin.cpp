@@ -6,7 +6,7 @@
 #include <anki/renderer/LightBin.h>
 #include <anki/renderer/RenderQueue.h>
 #include <anki/core/Trace.h>
-#include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHiveTaskGraph.h>
 #include <anki/collision/Sphere.h>
 #include <anki/collision/Frustum.h>
 #include <shaders/glsl_cpp_common/ClusteredShading.h>
@@ -214,6 +214,15 @@ private:
 	}
 };
 
+/// The clusters of a light in the current frame.
+class LightBin::LightClusters
+{
+public:
+	U64 m_uuid;
+	U64 m_shapeHash;
+	ConstWeakArray<Cluster> m_clusters;
+};
+
 /// Common data for all tasks.
 class LightBin::BinContext
 {
@@ -258,8 +267,13 @@ public:
 	WeakArray<const ReflectionProbeQueueElement> m_vProbes;
 	WeakArray<const DecalQueueElement> m_vDecals;
 
-	Atomic<U32> m_count = {0};
-	Atomic<U32> m_count2 = {0};
+	/// One per hive thread.
+	Array<ClustererTestResult, ThreadHive::MAX_THREADS> m_testResults;
+
+	// Incremental binning
+	Bool m_incremental = false; ///< The clusters of the previous frame can be used.
+	WeakArray<LightClusters> m_lightClusters; ///< The points and then the spots.
+	Atomic<U32> m_cacheMissCount = {0};
 
 	TextureViewPtr m_diffDecalTexAtlas;
 	SpinLock m_diffDecalTexAtlasMtx;
@@ -269,36 +283,26 @@ public:
 	LightBin* m_bin = nullptr;
 };
 
-/// Write the lights to the GPU buffers.
-class LightBin::WriteLightsTask : public ThreadPoolTask
-{
-public:
-	BinContext* m_ctx = nullptr;
-
-	Error operator()(U32 threadId, PtrSize threadsCount)
-	{
-		m_ctx->m_bin->binLights(threadId, threadsCount, *m_ctx);
-		return Error::NONE;
-	}
-};
-
 LightBin::LightBin(const GenericMemoryPoolAllocator<U8>& alloc,
 	U clusterCountX,
 	U clusterCountY,
 	U clusterCountZ,
-	ThreadPool* threadPool,
-	StagingGpuMemoryManager* stagingMem)
+	ThreadHive* hive,
+	StagingGpuMemoryManager* stagingMem,
+	Bool incremental)
 	: m_alloc(alloc)
 	, m_clusterCount(clusterCountX * clusterCountY * clusterCountZ)
-	, m_threadPool(threadPool)
+	, m_hive(hive)
 	, m_stagingMem(stagingMem)
-	, m_barrier(threadPool->getThreadCount())
+	, m_incremental(incremental)
 {
 	m_clusterer.init(alloc, clusterCountX, clusterCountY, clusterCountZ);
 }
 
 LightBin::~LightBin()
 {
+	m_cachedLights.destroy(m_alloc);
+	m_cachedClusters.destroy(m_alloc);
 }
 
 Error LightBin::bin(const Mat4& viewMat,
@@ -321,7 +325,12 @@ Error LightBin::bin(const Mat4& viewMat,
 	pinf.m_camTrf = Transform(camTrf);
 	pinf.m_near = rqueue.m_cameraNear;
 	pinf.m_far = rqueue.m_cameraFar;
-	m_clusterer.prepare(*m_threadPool, pinf);
+	m_clusterer.prepare(*m_hive, pinf);
+
+	// The clusters of the previous frame are valid only if the camera didn't move
+	const Bool cameraStill = viewMat == m_prevViewMat && projMat == m_prevProjMat;
+	m_prevViewMat = viewMat;
+	m_prevProjMat = projMat;
 
 	//
 	// Quickly get the lights
@@ -336,7 +345,6 @@ Error LightBin::bin(const Mat4& viewMat,
 	//
 	// Write the lights and tiles UBOs
 	//
-	Array<WriteLightsTask, ThreadPool::MAX_THREADS> tasks;
 	BinContext ctx(frameAlloc);
 	ctx.m_viewMat = viewMat;
 	ctx.m_viewProjMat = viewProjMat;
@@ -344,6 +352,13 @@ Error LightBin::bin(const Mat4& viewMat,
 	ctx.m_maxLightIndices = maxLightIndices;
 	ctx.m_shadowsEnabled = shadowsEnabled;
 	ctx.m_tempClusters.create(m_clusterCount);
+	ctx.m_incremental = m_incremental && cameraStill;
+
+	const U lightCount = visiblePointLightsCount + visibleSpotLightsCount;
+	if(ctx.m_incremental && lightCount)
+	{
+		ctx.m_lightClusters = WeakArray<LightClusters>(frameAlloc.newArray<LightClusters>(lightCount), lightCount);
+	}
 
 	if(visiblePointLightsCount)
 	{
@@ -425,16 +440,47 @@ Error LightBin::bin(const Mat4& viewMat,
 	}
 	ctx.m_lightIdsCount.set(SIZE_IDX_COUNT);
 
-	// Fire the async job
-	for(U i = 0; i < m_threadPool->getThreadCount(); i++)
+	for(U i = 0; i < m_hive->getThreadCount(); ++i)
 	{
-		tasks[i].m_ctx = &ctx;
+		m_clusterer.initTestResults(ctx.m_alloc, ctx.m_testResults[i]);
+	}
+
+	// Fire the async jobs. First reset the clusters, then bin and last write the clusters
+	ThreadHiveTaskGraph graph(*m_hive);
+
+	ThreadHiveTaskGraphNode* resetNode =
+		graph.addParallelFor(0, m_clusterCount, 0, [&ctx](PtrSize begin, PtrSize end, U32) -> Error {
+			ANKI_TRACE_SCOPED_EVENT(R_LIGHT_BINNING);
+			for(PtrSize i = begin; i < end; ++i)
+			{
+				ctx.m_tempClusters[i].reset();
+			}
+			return Error::NONE;
+		});
 
-		m_threadPool->assignNewTask(i, &tasks[i]);
+	ThreadHiveTaskGraphNode* lastNode = resetNode;
+	const U totalCount = visiblePointLightsCount + visibleSpotLightsCount + visibleProbeCount + visibleDecalCount;
+	if(totalCount > 0)
+	{
+		ThreadHiveTaskGraphNode* binNode =
+			graph.addParallelFor(0, totalCount, 1, [this, &ctx](PtrSize begin, PtrSize end, U32 threadId) -> Error {
+				binLights(begin, end, threadId, ctx);
+				return Error::NONE;
+			});
+		graph.addDependency(binNode, resetNode);
+		lastNode = binNode;
 	}
 
-	// Sync
-	ANKI_CHECK(m_threadPool->waitForAllThreadsToFinish());
+	ThreadHiveTaskGraphNode* writeNode =
+		graph.addParallelFor(0, m_clusterCount, 0, [this, &ctx](PtrSize begin, PtrSize end, U32) -> Error {
+			writeClusters(begin, end, ctx);
+			return Error::NONE;
+		});
+	graph.addDependency(writeNode, lastNode);
+
+	ANKI_CHECK(graph.run());
+
+	updateCache(ctx);
 
 	out.m_diffDecalTexView = ctx.m_diffDecalTexAtlas;
 	out.m_specularRoughnessDecalTexView = ctx.m_specularRoughnessDecalTexAtlas;
@@ -442,159 +488,213 @@ Error LightBin::bin(const Mat4& viewMat,
 	return Error::NONE;
 }
 
-void LightBin::binLights(U32 threadId, PtrSize threadsCount, BinContext& ctx)
+void LightBin::binLights(PtrSize begin, PtrSize end, U32 threadId, BinContext& ctx)
 {
-	U clusterCount = m_clusterCount;
-	PtrSize start, end;
-
-	//
-	// Initialize the temp clusters
-	//
-	{
-		ANKI_TRACE_SCOPED_EVENT(R_LIGHT_BINNING);
+	ANKI_TRACE_SCOPED_EVENT(R_LIGHT_BINNING);
 
-		ThreadPoolTask::choseStartEnd(threadId, threadsCount, clusterCount, start, end);
+	ClustererTestResult& testResult = ctx.m_testResults[threadId];
+	const U lightCount = ctx.m_vPointLights.getSize() + ctx.m_vSpotLights.getSize();
 
-		for(U i = start; i < end; ++i)
+	for(PtrSize j = begin; j < end; ++j)
+	{
+		if(j >= lightCount + ctx.m_vDecals.getSize())
 		{
-			ctx.m_tempClusters[i].reset();
+			U i = j - (lightCount + ctx.m_vDecals.getSize());
+			writeAndBinProbe(ctx.m_vProbes[i], ctx, testResult);
+		}
+		else if(j >= ctx.m_vPointLights.getSize() + ctx.m_vDecals.getSize())
+		{
+			U i = j - (ctx.m_vPointLights.getSize() + ctx.m_vDecals.getSize());
+			writeAndBinSpotLight(ctx.m_vSpotLights[i], ctx, testResult);
+		}
+		else if(j >= ctx.m_vDecals.getSize())
+		{
+			U i = j - ctx.m_vDecals.getSize();
+			writeAndBinPointLight(ctx.m_vPointLights[i], ctx, testResult);
+		}
+		else
+		{
+			U i = j;
+			writeAndBinDecal(ctx.m_vDecals[i], ctx, testResult);
 		}
 	}
+}
 
-	m_barrier.wait();
+void LightBin::writeClusters(PtrSize begin, PtrSize end, BinContext& ctx)
+{
+	ANKI_TRACE_SCOPED_EVENT(R_LIGHT_BINNING);
 
-	//
-	// Iterate lights and probes and bin them
-	//
+	for(PtrSize i = begin; i < end; ++i)
 	{
-		ANKI_TRACE_SCOPED_EVENT(R_LIGHT_BINNING);
+		auto& cluster = ctx.m_tempClusters[i];
+		cluster.normalizeCounts();
 
-		ClustererTestResult testResult;
-		m_clusterer.initTestResults(ctx.m_alloc, testResult);
-		U lightCount = ctx.m_vPointLights.getSize() + ctx.m_vSpotLights.getSize();
-		U totalCount = lightCount + ctx.m_vProbes.getSize() + ctx.m_vDecals.getSize();
+		const U countP = cluster.m_pointCount.get();
+		const U countS = cluster.m_spotCount.get();
+		const U countProbe = cluster.m_probeCount.get();
+		const U countDecal = cluster.m_decalCount.get();
+		const U count = countP + countS + countProbe + countDecal;
 
-		const U TO_BIN_COUNT = 1;
-		while((start = ctx.m_count2.fetchAdd(TO_BIN_COUNT)) < totalCount)
+		auto& c = ctx.m_clusters[i];
+		c.m_firstIdx = 0; // Point to the first empty indices
+
+		// Early exit
+		if(ANKI_UNLIKELY(count == 0))
 		{
-			end = min<U>(start + TO_BIN_COUNT, totalCount);
+			continue;
+		}
+
+		// Check if the previous cluster contains the same lights as this one and if yes then merge them. This
+		// will avoid allocating new IDs (and thrashing GPU caches).
+		cluster.sortLightIds();
+		if(i != begin)
+		{
+			const auto& clusterB = ctx.m_tempClusters[i - 1];
+
+			if(cluster == clusterB)
+			{
+				c.m_firstIdx = ctx.m_clusters[i - 1].m_firstIdx;
+				continue;
+			}
+		}
+
+		U offset = ctx.m_lightIdsCount.fetchAdd(count + SIZE_IDX_COUNT);
+		U initialOffset = offset;
+		(void)initialOffset;
+
+		if(offset + count + SIZE_IDX_COUNT <= ctx.m_maxLightIndices)
+		{
+			c.m_firstIdx = offset;
+
+			ctx.m_lightIds[offset++] = countDecal;
+			for(U i = 0; i < countDecal; ++i)
+			{
+				ctx.m_lightIds[offset++] = cluster.m_decalIds[i].getIndex();
+			}
+
+			ctx.m_lightIds[offset++] = countP;
+			for(U i = 0; i < countP; ++i)
+			{
+				ctx.m_lightIds[offset++] = cluster.m_pointIds[i].getIndex();
+			}
 
-			for(U j = start; j < end; ++j)
+			ctx.m_lightIds[offset++] = countS;
+			for(U i = 0; i < countS; ++i)
 			{
-				if(j >= lightCount + ctx.m_vDecals.getSize())
-				{
-					U i = j - (lightCount + ctx.m_vDecals.getSize());
-					writeAndBinProbe(ctx.m_vProbes[i], ctx, testResult);
-				}
-				else if(j >= ctx.m_vPointLights.getSize() + ctx.m_vDecals.getSize())
-				{
-					U i = j - (ctx.m_vPointLights.getSize() + ctx.m_vDecals.getSize());
-					writeAndBinSpotLight(ctx.m_vSpotLights[i], ctx, testResult);
-				}
-				else if(j >= ctx.m_vDecals.getSize())
-				{
-					U i = j - ctx.m_vDecals.getSize();
-					writeAndBinPointLight(ctx.m_vPointLights[i], ctx, testResult);
-				}
-				else
-				{
-					U i = j;
-					writeAndBinDecal(ctx.m_vDecals[i], ctx, testResult);
-				}
+				ctx.m_lightIds[offset++] = cluster.m_spotIds[i].getIndex();
 			}
+
+			ctx.m_lightIds[offset++] = countProbe;
+			for(U i = 0; i < countProbe; ++i)
+			{
+				ctx.m_lightIds[offset++] = cluster.m_probeIds[i].getIndex();
+			}
+
+			ANKI_ASSERT(offset - initialOffset == count + SIZE_IDX_COUNT);
+		}
+		else
+		{
+			ANKI_R_LOGW("Light IDs buffer too small");
 		}
 	}
+}
 
-	m_barrier.wait();
+template<typename TBinFunc>
+ConstWeakArray<Cluster> LightBin::binOrGetCached(
+	U64 uuid, U64 shapeHash, U32 slot, BinContext& ctx, ClustererTestResult& testResult, TBinFunc binFunc) const
+{
+	if(!ctx.m_incremental)
+	{
+		binFunc();
+		return ConstWeakArray<Cluster>(testResult.getClustersBegin(), testResult.getClusterCount());
+	}
 
-	//
-	// Last thing, update the real clusters
-	//
+	LightClusters& light = ctx.m_lightClusters[slot];
+	light.m_uuid = uuid;
+	light.m_shapeHash = shapeHash;
 
+	auto it = m_cachedLights.find(uuid);
+	if(it != m_cachedLights.getEnd() && (*it).m_shapeHash == shapeHash)
+	{
+		// The light didn't move, use the clusters of the previous frame
+		const CachedLight& cached = *it;
+		light.m_clusters =
+			ConstWeakArray<Cluster>(m_cachedClusters.getBegin() + cached.m_firstCluster, cached.m_clusterCount);
+	}
+	else
 	{
-		ANKI_TRACE_SCOPED_EVENT(R_LIGHT_BINNING);
+		binFunc();
+		ctx.m_cacheMissCount.fetchAdd(1);
 
-		// Run per cluster
-		const U CLUSTER_GROUP = 16;
-		while((start = ctx.m_count.fetchAdd(CLUSTER_GROUP)) < clusterCount)
+		// Copy the clusters because the test result will be reused
+		const U32 count = testResult.getClusterCount();
+		Cluster* clusters = nullptr;
+		if(count)
 		{
-			end = min<U>(start + CLUSTER_GROUP, clusterCount);
+			clusters = ctx.m_alloc.newArray<Cluster>(count);
+			memcpy(clusters, &(*testResult.getClustersBegin()), sizeof(Cluster) * count);
+		}
 
-			for(U i = start; i < end; ++i)
-			{
-				auto& cluster = ctx.m_tempClusters[i];
-				cluster.normalizeCounts();
-
-				const U countP = cluster.m_pointCount.get();
-				const U countS = cluster.m_spotCount.get();
-				const U countProbe = cluster.m_probeCount.get();
-				const U countDecal = cluster.m_decalCount.get();
-				const U count = countP + countS + countProbe + countDecal;
-
-				auto& c = ctx.m_clusters[i];
-				c.m_firstIdx = 0; // Point to the first empty indices
-
-				// Early exit
-				if(ANKI_UNLIKELY(count == 0))
-				{
-					continue;
-				}
-
-				// Check if the previous cluster contains the same lights as this one and if yes then merge them. This
-				// will avoid allocating new IDs (and thrashing GPU caches).
-				cluster.sortLightIds();
-				if(i != start)
-				{
-					const auto& clusterB = ctx.m_tempClusters[i - 1];
-
-					if(cluster == clusterB)
-					{
-						c.m_firstIdx = ctx.m_clusters[i - 1].m_firstIdx;
-						continue;
-					}
-				}
-
-				U offset = ctx.m_lightIdsCount.fetchAdd(count + SIZE_IDX_COUNT);
-				U initialOffset = offset;
-				(void)initialOffset;
-
-				if(offset + count + SIZE_IDX_COUNT <= ctx.m_maxLightIndices)
-				{
-					c.m_firstIdx = offset;
-
-					ctx.m_lightIds[offset++] = countDecal;
-					for(U i = 0; i < countDecal; ++i)
-					{
-						ctx.m_lightIds[offset++] = cluster.m_decalIds[i].getIndex();
-					}
-
-					ctx.m_lightIds[offset++] = countP;
-					for(U i = 0; i < countP; ++i)
-					{
-						ctx.m_lightIds[offset++] = cluster.m_pointIds[i].getIndex();
-					}
-
-					ctx.m_lightIds[offset++] = countS;
-					for(U i = 0; i < countS; ++i)
-					{
-						ctx.m_lightIds[offset++] = cluster.m_spotIds[i].getIndex();
-					}
-
-					ctx.m_lightIds[offset++] = countProbe;
-					for(U i = 0; i < countProbe; ++i)
-					{
-						ctx.m_lightIds[offset++] = cluster.m_probeIds[i].getIndex();
-					}
-
-					ANKI_ASSERT(offset - initialOffset == count + SIZE_IDX_COUNT);
-				}
-				else
-				{
-					ANKI_R_LOGW("Light IDs buffer too small");
-				}
-			} // end for
-		} // end while
-	} // scope
+		light.m_clusters = ConstWeakArray<Cluster>(clusters, count);
+	}
+
+	return light.m_clusters;
+}
+
+void LightBin::updateCache(BinContext& ctx)
+{
+	if(!ctx.m_incremental)
+	{
+		// The camera moved or the cache is disabled. Nothing of this frame can be used in the next one
+		m_lastCacheMissCount = ctx.m_vPointLights.getSize() + ctx.m_vSpotLights.getSize();
+		m_cachedLights.destroy(m_alloc);
+		m_cachedClusters.destroy(m_alloc);
+		m_cachedLightCount = 0;
+		return;
+	}
+
+	const U32 missCount = ctx.m_cacheMissCount.get();
+	ANKI_TRACE_INC_COUNTER(R_LIGHT_BINNING_CACHE_MISSES, missCount);
+	m_lastCacheMissCount = missCount;
+
+	if(missCount == 0 && ctx.m_lightClusters.getSize() == m_cachedLightCount)
+	{
+		// Every light was in the cache and no light left it
+		return;
+	}
+
+	U32 clusterCount = 0;
+	for(const LightClusters& light : ctx.m_lightClusters)
+	{
+		clusterCount += light.m_clusters.getSize();
+	}
+
+	// Gather the clusters of this frame. Some of them point to the old cache so destroy it last
+	HashMap<U64, CachedLight> cachedLights;
+	DynamicArray<Cluster> cachedClusters;
+	if(clusterCount)
+	{
+		cachedClusters.create(m_alloc, clusterCount);
+	}
+
+	U32 offset = 0;
+	for(const LightClusters& light : ctx.m_lightClusters)
+	{
+		const U32 count = light.m_clusters.getSize();
+		if(count)
+		{
+			memcpy(&cachedClusters[offset], &light.m_clusters[0], sizeof(Cluster) * count);
+		}
+
+		cachedLights.emplace(m_alloc, light.m_uuid, CachedLight{light.m_shapeHash, offset, count});
+		offset += count;
+	}
+
+	m_cachedLights.destroy(m_alloc);
+	m_cachedLights = std::move(cachedLights);
+	m_cachedClusters.destroy(m_alloc);
+	m_cachedClusters = std::move(cachedClusters);
+	m_cachedLightCount = ctx.m_lightClusters.getSize();
 }
 
 void LightBin::writeAndBinPointLight(
@@ -621,18 +721,21 @@ void LightBin::writeAndBinPointLight(
 	slight.m_radiusPad1 = Vec2(lightEl.m_radius);
 
 	// Now bin it
-	Sphere sphere(lightEl.m_worldPosition.xyz0(), lightEl.m_radius);
-	Aabb box;
-	sphere.computeAabb(box);
-	m_clusterer.bin(sphere, box, testResult);
-
-	auto it = testResult.getClustersBegin();
-	auto end = testResult.getClustersEnd();
-	for(; it != end; ++it)
-	{
-		U x = (*it).x();
-		U y = (*it).y();
-		U z = (*it).z();
+	const Vec4 shape(lightEl.m_worldPosition, lightEl.m_radius);
+	const U64 shapeHash = computeHash(&shape, sizeof(shape));
+	const ConstWeakArray<Cluster> clusters =
+		binOrGetCached(lightEl.m_uuid, shapeHash, idx, ctx, testResult, [&]() {
+			Sphere sphere(lightEl.m_worldPosition.xyz0(), lightEl.m_radius);
+			Aabb box;
+			sphere.computeAabb(box);
+			m_clusterer.bin(sphere, box, testResult);
+		});
+
+	for(const Cluster& c : clusters)
+	{
+		U x = c.x();
+		U y = c.y();
+		U z = c.z();
 
 		U i = m_clusterer.getClusterCountX() * (z * m_clusterer.getClusterCountY() + y) + x;
 
@@ -674,19 +777,23 @@ void LightBin::writeAndBinSpotLight(
 	light.m_outerCosInnerCos = Vec4(cos(lightEl.m_outerAngle / 2.0f), cos(lightEl.m_innerAngle / 2.0f), 1.0f, 1.0f);
 
 	// Bin lights
-	PerspectiveFrustum shape(lightEl.m_outerAngle, lightEl.m_outerAngle, 0.01f, lightEl.m_distance);
-	shape.transform(Transform(lightEl.m_worldTransform));
-	Aabb box;
-	shape.computeAabb(box);
-	m_clusterer.binPerspectiveFrustum(shape, box, testResult);
-
-	auto it = testResult.getClustersBegin();
-	auto end = testResult.getClustersEnd();
-	for(; it != end; ++it)
-	{
-		U x = (*it).x();
-		U y = (*it).y();
-		U z = (*it).z();
+	U64 shapeHash = computeHash(&lightEl.m_worldTransform, sizeof(lightEl.m_worldTransform));
+	const Vec2 distAngle(lightEl.m_distance, lightEl.m_outerAngle);
+	shapeHash = computeHash(&distAngle, sizeof(distAngle), shapeHash);
+	const ConstWeakArray<Cluster> clusters = binOrGetCached(
+		lightEl.m_uuid, shapeHash, ctx.m_vPointLights.getSize() + idx, ctx, testResult, [&]() {
+			PerspectiveFrustum shape(lightEl.m_outerAngle, lightEl.m_outerAngle, 0.01f, lightEl.m_distance);
+			shape.transform(Transform(lightEl.m_worldTransform));
+			Aabb box;
+			shape.computeAabb(box);
+			m_clusterer.binPerspectiveFrustum(shape, box, testResult);
+		});
+
+	for(const Cluster& c : clusters)
+	{
+		U x = c.x();
+		U y = c.y();
+		U z = c.z();
 
 		U i = m_clusterer.getClusterCountX() * (z * m_clusterer.getClusterCountY() + y) + x;
 
@@ -31,15 +31,14 @@ public:
 /// Bins lights and probes to clusters.
 class LightBin
 {
-	friend class WriteLightsTask;
-
 public:
 	LightBin(const GenericMemoryPoolAllocator<U8>& alloc,
 		U clusterCountX,
 		U clusterCountY,
 		U clusterCountZ,
-		ThreadPool* threadPool,
-		StagingGpuMemoryManager* stagingMem);
+		ThreadHive* hive,
+		StagingGpuMemoryManager* stagingMem,
+		Bool incremental);
 
 	~LightBin();
 
@@ -58,22 +57,84 @@ public:
 		return m_clusterer;
 	}
 
+anki_internal:
+	/// The number of point and spot lights that the last bin() didn't take from the cache.
+	U32 getLastCacheMissCount() const
+	{
+		return m_lastCacheMissCount;
+	}
+
+	/// Get the clusters of a light that the next bin() will use if the camera and the light don't move.
+	Bool tryGetCachedClusters(U64 uuid, ConstWeakArray<Cluster>& clusters) const
+	{
+		auto it = m_cachedLights.find(uuid);
+		if(it == m_cachedLights.getEnd())
+		{
+			return false;
+		}
+
+		clusters = ConstWeakArray<Cluster>(m_cachedClusters.getBegin() + (*it).m_firstCluster, (*it).m_clusterCount);
+		return true;
+	}
+
 private:
 	class BinContext;
 	class ShaderCluster;
 	class ClusterLightIndex;
 	class ClusterProbeIndex;
 	class ClusterData;
-	class WriteLightsTask;
+	class LightClusters;
+
+	/// The clusters of a light from the previous frame.
+	class CachedLight
+	{
+	public:
+		U64 m_shapeHash;
+		U32 m_firstCluster; ///< Index in m_cachedClusters.
+		U32 m_clusterCount;
+	};
 
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Clusterer m_clusterer;
 	U32 m_clusterCount = 0;
-	ThreadPool* m_threadPool = nullptr;
+	ThreadHive* m_hive = nullptr;
 	StagingGpuMemoryManager* m_stagingMem = nullptr;
-	Barrier m_barrier;
 
-	void binLights(U32 threadId, PtrSize threadsCount, BinContext& ctx);
+	/// @name Incremental binning
+	/// If the camera doesn't move the lights that didn't move keep the clusters of the previous frame.
+	/// @{
+	Bool8 m_incremental = false;
+	Mat4 m_prevViewMat = Mat4(0.0f);
+	Mat4 m_prevProjMat = Mat4(0.0f);
+	HashMap<U64, CachedLight> m_cachedLights; ///< Light UUID to the clusters of the previous frame.
+	U32 m_cachedLightCount = 0;
+	DynamicArray<Cluster> m_cachedClusters;
+	U32 m_lastCacheMissCount = 0;
+	/// @}
+
+	/// Bin a range of lights, decals and probes.
+	void binLights(PtrSize begin, PtrSize end, U32 threadId, BinContext& ctx);
+
+	/// Write a range of the GPU clusters.
+	void writeClusters(PtrSize begin, PtrSize end, BinContext& ctx);
+
+	/// Bin a light or get its clusters from the previous frame.
+	/// @param uuid The light.
+	/// @param shapeHash A hash of what affects the clusters of the light.
+	/// @param slot A unique index of the light in the current frame.
+	/// @param ctx The context.
+	/// @param testResult Used by the binning.
+	/// @param binFunc The function that bins the light into the testResult.
+	template<typename TBinFunc>
+	ConstWeakArray<Cluster> binOrGetCached(U64 uuid,
+		U64 shapeHash,
+		U32 slot,
+		BinContext& ctx,
+		ClustererTestResult& testResult,
+		TBinFunc binFunc) const;
+
+	/// Store the clusters of the lights of this frame for the next one.
+	void updateCache(BinContext& ctx);
 
 	void writeAndBinPointLight(const PointLightQueueElement& lightEl, BinContext& ctx, ClustererTestResult& testResult);
 
@@ -65,8 +65,9 @@ Error LightShading::initInternal(const ConfigSet& config)
 		m_clusterCounts[0],
 		m_clusterCounts[1],
 		m_clusterCounts[2],
-		&m_r->getThreadPool(),
-		&m_r->getStagingGpuMemoryManager());
+		&m_r->getThreadHive(),
+		&m_r->getStagingGpuMemoryManager(),
+		config.getNumber("r.incrementalLightBinning"));
 
 	// Load shaders and programs
 	ANKI_CHECK(getResourceManager().loadResource("shaders/LightShading.glslp", m_prog));
@@ -78,7 +79,7 @@ Error LightShading::initInternal(const ConfigSet& config)
 		.add("CLUSTER_COUNT", U32(m_clusterCount))
 		.add("IR_MIPMAP_COUNT", U32(m_r->getIndirect().getReflectionTextureMipmapCount()));
 
-	m_prog->getOrCreateVariant(consts.get(), m_progVariant);
+	getProgramVariant(m_prog, consts.get(), m_grProg);
 
 	// Create RT descr
 	m_rtDescr = m_r->create2DRenderTargetDescription(
@@ -102,9 +103,7 @@ Error LightShading::initInternal(const ConfigSet& config)
 			.add("SRC_SIZE", Vec2(m_r->getWidth() / FS_FRACTION, m_r->getHeight() / FS_FRACTION))
 			.add("FB_SIZE", Vec2(m_r->getWidth(), m_r->getWidth()));
 
-		const ShaderProgramResourceVariant* variant;
-		m_fs.m_prog->getOrCreateVariant(consts.get(), variant);
-		m_fs.m_grProg = variant->getProgram();
+		getProgramVariant(m_fs.m_prog, consts.get(), m_fs.m_grProg);
 	}
 
 	return Error::NONE;
@@ -136,7 +135,7 @@ void LightShading::run(const RenderingContext& ctx, RenderPassWorkContext& rgrap
 
 	// Do light shading
 	{
-		cmdb->bindShaderProgram(m_progVariant->getProgram());
+		cmdb->bindShaderProgram(m_grProg);
 
 		// Bind textures
 		rgraphCtx.bindColorTextureAndSampler(0, 0, m_r->getGBuffer().getColorRt(0), m_r->getNearestSampler());
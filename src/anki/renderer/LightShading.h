@@ -61,7 +61,7 @@ private:
 
 	// Light shaders
 	ShaderProgramResourcePtr m_prog;
-	const ShaderProgramResourceVariant* m_progVariant = nullptr;
+	ShaderProgramPtr m_grProg;
 
 	LightBin* m_lightBin = nullptr;
 
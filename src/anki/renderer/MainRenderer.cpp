@@ -31,6 +31,7 @@ MainRenderer::~MainRenderer()
 }
 
 Error MainRenderer::init(ThreadPool* threadpool,
+	ThreadHive* hive,
 	ResourceManager* resources,
 	GrManager* gr,
 	StagingGpuMemoryManager* stagingMem,
@@ -58,16 +59,17 @@ Error MainRenderer::init(ThreadPool* threadpool,
 	m_rDrawToDefaultFb = m_renderingQuality == 1.0;
 
 	m_r.reset(m_alloc.newInstance<Renderer>());
-	ANKI_CHECK(
-		m_r->init(threadpool, resources, gr, stagingMem, ui, m_alloc, config2, globTimestamp, m_rDrawToDefaultFb));
+	ANKI_CHECK(m_r->init(
+		threadpool, hive, resources, gr, stagingMem, ui, m_alloc, config2, globTimestamp, m_rDrawToDefaultFb));
 
 	// Init other
 	if(!m_rDrawToDefaultFb)
 	{
 		ANKI_CHECK(resources->loadResource("shaders/Blit.glslp", m_blitProg));
-		const ShaderProgramResourceVariant* variant;
-		m_blitProg->getOrCreateVariant(variant);
-		m_blitGrProg = variant->getProgram();
+		m_r->getProgramVariant(m_blitProg,
+			ConstWeakArray<ShaderProgramResourceMutation>(),
+			ConstWeakArray<ShaderProgramResourceConstantValue>(),
+			m_blitGrProg);
 
 		ANKI_R_LOGI("The main renderer will have to blit the offscreen renderer's result");
 	}
@@ -118,27 +120,8 @@ Error MainRenderer::render(RenderQueue& rqueue)
 	// Bake the render graph
 	m_rgraph->compileNewGraph(ctx.m_renderGraphDescr, m_frameAlloc);
 
-	// Populate the 2nd level command buffers
-	class Task : public ThreadPoolTask
-	{
-	public:
-		RenderGraphPtr m_rgraph;
-
-		Error operator()(U32 taskId, PtrSize threadsCount)
-		{
-			m_rgraph->runSecondLevel(taskId);
-			return Error::NONE;
-		}
-	};
-
-	Task task;
-	task.m_rgraph = m_rgraph;
-	for(U i = 0; i < m_r->getThreadPool().getThreadCount(); ++i)
-	{
-		m_r->getThreadPool().assignNewTask(i, &task);
-	}
-
-	ANKI_CHECK(m_r->getThreadPool().waitForAllThreadsToFinish());
+	// Populate the 2nd level command buffers in the hive
+	RendererObject::recordSecondLevelCommandBuffers(*m_rgraph, m_r->getThreadHive(), m_frameAlloc);
 
 	// Populate 1st level command buffers
 	m_rgraph->run();
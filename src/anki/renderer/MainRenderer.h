@@ -16,6 +16,7 @@ namespace anki
 class ResourceManager;
 class ConfigSet;
 class ThreadPool;
+class ThreadHive;
 class StagingGpuMemoryManager;
 class UiManager;
 
@@ -38,6 +39,7 @@ public:
 	~MainRenderer();
 
 	ANKI_USE_RESULT Error init(ThreadPool* threadpool,
+		ThreadHive* hive,
 		ResourceManager* resources,
 		GrManager* gl,
 		StagingGpuMemoryManager* stagingMem,
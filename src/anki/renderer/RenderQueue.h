@@ -54,6 +54,7 @@ public:
 	const void* m_userData;
 	U64 m_mergeKey;
 	F32 m_distanceFromCamera; ///< Don't set this
+	U8 m_lod; ///< Don't set this
 };
 
 static_assert(
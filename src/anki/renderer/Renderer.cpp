@@ -31,6 +31,17 @@
 namespace anki
 {
 
+/// A variant that a RendererObject holds.
+class Renderer::ProgramVariantRef
+{
+public:
+	ShaderProgramResourcePtr m_prog;
+	DynamicArray<ShaderProgramResourceMutation> m_mutations;
+	DynamicArray<ShaderProgramResourceConstantValue> m_constants;
+	ShaderProgramPtr* m_grProg = nullptr;
+	U32 m_reloadGeneration = 0;
+};
+
 Renderer::Renderer()
 	: m_sceneDrawer(this)
 {
@@ -38,9 +49,16 @@ Renderer::Renderer()
 
 Renderer::~Renderer()
 {
+	for(ProgramVariantRef& ref : m_programVariants)
+	{
+		ref.m_mutations.destroy(m_alloc);
+		ref.m_constants.destroy(m_alloc);
+	}
+	m_programVariants.destroy(m_alloc);
 }
 
 Error Renderer::init(ThreadPool* threadpool,
+	ThreadHive* hive,
 	ResourceManager* resources,
 	GrManager* gl,
 	StagingGpuMemoryManager* stagingMem,
@@ -54,6 +72,7 @@ Error Renderer::init(ThreadPool* threadpool,
 
 	m_globTimestamp = globTimestamp;
 	m_threadpool = threadpool;
+	m_threadHive = hive;
 	m_resources = resources;
 	m_gr = gl;
 	m_stagingMem = stagingMem;
@@ -77,9 +96,6 @@ Error Renderer::initInternal(const ConfigSet& config)
 	m_height = config.getNumber("height");
 	ANKI_R_LOGI("Initializing offscreen renderer. Size %ux%u", m_width, m_height);
 
-	ANKI_ASSERT(m_lodDistances.getSize() == 2);
-	m_lodDistances[0] = config.getNumber("r.lodDistance0");
-	m_lodDistances[1] = config.getNumber("r.lodDistance1");
 	m_frameCount = 0;
 
 	// A few sanity checks
@@ -249,6 +265,8 @@ Error Renderer::populateRenderGraph(RenderingContext& ctx)
 	ctx.m_prevViewProjMat = m_prevViewProjMat;
 	ctx.m_prevCamTransform = m_prevCamTransform;
 
+	updateReloadedProgramVariants();
+
 	// Check if resources got loaded
 	if(m_prevLoadRequestCount != m_resources->getLoadingRequestCount()
 		|| m_prevAsyncTasksCompleted != m_resources->getAsyncTaskCompletedCount())
@@ -297,11 +315,56 @@ Error Renderer::populateRenderGraph(RenderingContext& ctx)
 	return Error::NONE;
 }
 
+void Renderer::getProgramVariant(const ShaderProgramResourcePtr& prog,
+	ConstWeakArray<ShaderProgramResourceMutation> mutations,
+	ConstWeakArray<ShaderProgramResourceConstantValue> constants,
+	ShaderProgramPtr& grProg)
+{
+	const ShaderProgramResourceVariant* variant;
+	prog->getOrCreateVariant(mutations, constants, variant);
+	grProg = variant->getProgram();
+
+	// The inputs and the mutators of the program survive the hot reloads so the mutations and the constants can be
+	// used again
+	ProgramVariantRef& ref = *m_programVariants.emplaceBack(m_alloc);
+	ref.m_prog = prog;
+	ref.m_grProg = &grProg;
+	ref.m_reloadGeneration = prog->getReloadGeneration();
+
+	if(mutations.getSize())
+	{
+		ref.m_mutations.create(m_alloc, mutations.getSize());
+		memcpy(&ref.m_mutations[0], &mutations[0], mutations.getSizeInBytes());
+	}
+
+	if(constants.getSize())
+	{
+		ref.m_constants.create(m_alloc, constants.getSize());
+		memcpy(&ref.m_constants[0], &constants[0], constants.getSizeInBytes());
+	}
+}
+
+void Renderer::updateReloadedProgramVariants()
+{
+	for(ProgramVariantRef& ref : m_programVariants)
+	{
+		const U32 reloadGeneration = ref.m_prog->getReloadGeneration();
+		if(ref.m_reloadGeneration != reloadGeneration)
+		{
+			const ShaderProgramResourceVariant* variant;
+			ref.m_prog->getOrCreateVariant(ref.m_mutations, ref.m_constants, variant);
+			*ref.m_grProg = variant->getProgram();
+			ref.m_reloadGeneration = reloadGeneration;
+		}
+	}
+}
+
 void Renderer::finalize(const RenderingContext& ctx)
 {
 	++m_frameCount;
 	m_prevViewProjMat = ctx.m_renderQueue->m_viewProjectionMatrix;
 	m_prevCamTransform = ctx.m_renderQueue->m_cameraTransform;
+	m_sceneDrawer.endFrame();
 
 	// Inform about the HiZ map. Do it as late as possible
 	if(ctx.m_renderQueue->m_fillCoverageBufferCallback)
@@ -12,6 +12,7 @@
 #include <anki/resource/Forward.h>
 #include <anki/core/StagingGpuMemoryManager.h>
 #include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHive.h>
 #include <anki/collision/Forward.h>
 
 namespace anki
@@ -22,6 +23,8 @@ class ConfigSet;
 class ResourceManager;
 class StagingGpuMemoryManager;
 class UiManager;
+class ShaderProgramResourceMutation;
+class ShaderProgramResourceConstantValue;
 
 /// @addtogroup renderer
 /// @{
@@ -179,6 +182,7 @@ public:
 
 	/// Init the renderer.
 	ANKI_USE_RESULT Error init(ThreadPool* threadpool,
+		ThreadHive* hive,
 		ResourceManager* resources,
 		GrManager* gr,
 		StagingGpuMemoryManager* stagingMem,
@@ -229,24 +233,6 @@ anki_internal:
 	static Vec3 unproject(
 		const Vec3& windowCoords, const Mat4& modelViewMat, const Mat4& projectionMat, const int view[4]);
 
-	/// Get the LOD given the distance of an object from the camera
-	U calculateLod(F32 distance) const
-	{
-		ANKI_ASSERT(m_lodDistances.getSize() == 2);
-		if(distance < m_lodDistances[0])
-		{
-			return 0;
-		}
-		else if(distance < m_lodDistances[1])
-		{
-			return 1;
-		}
-		else
-		{
-			return 2;
-		}
-	}
-
 	/// Create the init info for a 2D texture that will be used as a render target.
 	ANKI_USE_RESULT TextureInitInfo create2DRenderTargetInitInfo(
 		U32 w, U32 h, Format format, TextureUsageBit usage, CString name = {});
@@ -283,6 +269,11 @@ anki_internal:
 		return *m_threadpool;
 	}
 
+	ThreadHive& getThreadHive()
+	{
+		return *m_threadHive;
+	}
+
 	Timestamp getGlobalTimestamp() const
 	{
 		return *m_globTimestamp;
@@ -334,8 +325,18 @@ anki_internal:
 		return m_nearesetNearestSampler;
 	}
 
+	/// Get a variant of a program and write its program to grProg. When the program is hot reloaded the new program is
+	/// written to grProg between frames so grProg should live as long as the renderer.
+	void getProgramVariant(const ShaderProgramResourcePtr& prog,
+		ConstWeakArray<ShaderProgramResourceMutation> mutations,
+		ConstWeakArray<ShaderProgramResourceConstantValue> constants,
+		ShaderProgramPtr& grProg);
+
 private:
+	class ProgramVariantRef;
+
 	ThreadPool* m_threadpool = nullptr;
+	ThreadHive* m_threadHive = nullptr;
 	ResourceManager* m_resources = nullptr;
 	GrManager* m_gr = nullptr;
 	StagingGpuMemoryManager* m_stagingMem = nullptr;
@@ -368,8 +369,6 @@ private:
 	U32 m_width;
 	U32 m_height;
 
-	Array<F32, MAX_LOD_COUNT - 1> m_lodDistances; ///< Distance that used to calculate the LOD
-
 	RenderableDrawer m_sceneDrawer;
 
 	U64 m_frameCount; ///< Frame number
@@ -396,11 +395,16 @@ private:
 
 	ShaderProgramResourcePtr m_clearTexComputeProg;
 
+	DynamicArray<ProgramVariantRef> m_programVariants; ///< The variants to get again after hot reloads.
+
 	RendererStats m_stats;
 
 	ANKI_USE_RESULT Error initInternal(const ConfigSet& initializer);
 
 	void initJitteredMats();
+
+	/// Get the variants of the programs that were hot reloaded again.
+	void updateReloadedProgramVariants();
 };
 /// @}
 
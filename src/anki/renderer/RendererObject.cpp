@@ -6,6 +6,8 @@
 #include <anki/renderer/RendererObject.h>
 #include <anki/renderer/Renderer.h>
 #include <anki/util/Enum.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/core/Trace.h>
 
 namespace anki
 {
@@ -59,20 +61,71 @@ void RendererObject::bindStorage(CommandBufferPtr& cmdb, U set, U binding, const
 	}
 }
 
+void RendererObject::getProgramVariant(const ShaderProgramResourcePtr& prog,
+	ConstWeakArray<ShaderProgramResourceMutation> mutations,
+	ConstWeakArray<ShaderProgramResourceConstantValue> constants,
+	ShaderProgramPtr& grProg)
+{
+	m_r->getProgramVariant(prog, mutations, constants, grProg);
+}
+
 U32 RendererObject::computeNumberOfSecondLevelCommandBuffers(U32 drawcallCount) const
 {
-	const U drawcallsPerThread = drawcallCount / m_r->getThreadPool().getThreadCount();
-	U secondLevelCmdbCount;
-	if(drawcallsPerThread < MIN_DRAWCALLS_PER_2ND_LEVEL_COMMAND_BUFFER)
+	return computeNumberOfSecondLevelCommandBuffers(
+		drawcallCount, m_r->getSceneDrawer().getRecordingTimePerRenderable(), m_r->getThreadHive().getThreadCount());
+}
+
+U32 RendererObject::computeNumberOfSecondLevelCommandBuffers(
+	U32 drawcallCount, Second recordingTimePerDrawcall, U32 threadCount)
+{
+	// Give every command buffer enough work to pay for itself. Use the measured cost of the drawcalls for that. Work in
+	// whole nanoseconds or the float error will drop a command buffer when the time is an exact multiple of the minimum
+	const U64 timePerDrawcallNs = U64(recordingTimePerDrawcall * 1000000000.0 + 0.5);
+	const U64 minTimeNs = U64(MIN_RECORDING_TIME_PER_2ND_LEVEL_COMMAND_BUFFER * 1000000000.0 + 0.5);
+	U64 secondLevelCmdbCount = U64(drawcallCount) * timePerDrawcallNs / minTimeNs;
+	secondLevelCmdbCount = min<U64>(secondLevelCmdbCount, drawcallCount / MIN_DRAWCALLS_PER_2ND_LEVEL_COMMAND_BUFFER);
+
+	// The command buffers are recorded in the hive. More than its threads won't make it faster
+	return clamp<U32>(U32(secondLevelCmdbCount), 1u, threadCount);
+}
+
+void RendererObject::recordSecondLevelCommandBuffers(RenderGraph& rgraph, ThreadHive& hive, StackAllocator<U8> alloc)
+{
+	const U32 secondLevelCmdbCount = rgraph.getSecondLevelCommandBufferCount();
+	if(secondLevelCmdbCount == 0)
 	{
-		secondLevelCmdbCount = max<U>(1u, drawcallCount / MIN_DRAWCALLS_PER_2ND_LEVEL_COMMAND_BUFFER);
+		return;
 	}
-	else
+
+	ANKI_TRACE_SCOPED_EVENT(R_RECORD_2ND_LEVEL);
+	ANKI_TRACE_INC_COUNTER(R_2ND_LEVEL_COMMAND_BUFFERS, secondLevelCmdbCount);
+
+	class Task
 	{
-		secondLevelCmdbCount = m_r->getThreadPool().getThreadCount();
+	public:
+		RenderGraph* m_rgraph;
+		U32 m_cmdbIdx;
+
+		static void callback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem)
+		{
+			Task& self = *static_cast<Task*>(ud);
+			self.m_rgraph->runSecondLevel(self.m_cmdbIdx);
+		}
+	};
+
+	Task* tasks = alloc.newArray<Task>(secondLevelCmdbCount);
+	ThreadHiveTask* hiveTasks = alloc.newArray<ThreadHiveTask>(secondLevelCmdbCount);
+	for(U32 i = 0; i < secondLevelCmdbCount; ++i)
+	{
+		tasks[i].m_rgraph = &rgraph;
+		tasks[i].m_cmdbIdx = i;
+
+		hiveTasks[i].m_callback = Task::callback;
+		hiveTasks[i].m_argument = &tasks[i];
 	}
 
-	return secondLevelCmdbCount;
+	hive.submitTasks(hiveTasks, secondLevelCmdbCount);
+	hive.waitAllTasks();
 }
 
 } // end namespace anki
@@ -17,6 +17,7 @@ namespace anki
 
 // Forward
 class Renderer;
+class ThreadHive;
 class ResourceManager;
 class ConfigSet;
 
@@ -38,6 +39,16 @@ anki_internal:
 
 	HeapAllocator<U8> getAllocator() const;
 
+	/// Compute the number of 2nd level command buffers that will record drawcallCount drawcalls in threadCount threads.
+	/// recordingTimePerDrawcall is the CPU time it takes to record a drawcall.
+	static U32 computeNumberOfSecondLevelCommandBuffers(
+		U32 drawcallCount, Second recordingTimePerDrawcall, U32 threadCount);
+
+	/// Record all the 2nd level command buffers of a compiled render graph in the hive. One task per command buffer so
+	/// the big passes are spread to all the threads.
+	/// @param alloc Allocates the tasks. It should be a per frame allocator.
+	static void recordSecondLevelCommandBuffers(RenderGraph& rgraph, ThreadHive& hive, StackAllocator<U8> alloc);
+
 protected:
 	Renderer* m_r; ///< Know your father
 
@@ -50,6 +61,37 @@ protected:
 
 	U32 computeNumberOfSecondLevelCommandBuffers(U32 drawcallCount) const;
 
+	/// Get a variant of a program and write its program to grProg. grProg is updated when the program is hot reloaded.
+	void getProgramVariant(const ShaderProgramResourcePtr& prog,
+		ConstWeakArray<ShaderProgramResourceMutation> mutations,
+		ConstWeakArray<ShaderProgramResourceConstantValue> constants,
+		ShaderProgramPtr& grProg);
+
+	/// @copydoc getProgramVariant
+	void getProgramVariant(const ShaderProgramResourcePtr& prog,
+		ConstWeakArray<ShaderProgramResourceConstantValue> constants,
+		ShaderProgramPtr& grProg)
+	{
+		getProgramVariant(prog, ConstWeakArray<ShaderProgramResourceMutation>(), constants, grProg);
+	}
+
+	/// @copydoc getProgramVariant
+	void getProgramVariant(const ShaderProgramResourcePtr& prog,
+		ConstWeakArray<ShaderProgramResourceMutation> mutations,
+		ShaderProgramPtr& grProg)
+	{
+		getProgramVariant(prog, mutations, ConstWeakArray<ShaderProgramResourceConstantValue>(), grProg);
+	}
+
+	/// @copydoc getProgramVariant
+	void getProgramVariant(const ShaderProgramResourcePtr& prog, ShaderProgramPtr& grProg)
+	{
+		getProgramVariant(prog,
+			ConstWeakArray<ShaderProgramResourceMutation>(),
+			ConstWeakArray<ShaderProgramResourceConstantValue>(),
+			grProg);
+	}
+
 	/// Used in fullscreen quad draws.
 	static void drawQuad(CommandBufferPtr& cmdb)
 	{
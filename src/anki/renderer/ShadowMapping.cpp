@@ -23,8 +23,6 @@ struct ShadowMapping::LightToRenderToScratchInfo
 
 ShadowMapping::~ShadowMapping()
 {
-	m_tiles.destroy(getAllocator());
-	m_lightUuidToTileIdx.destroy(getAllocator());
 }
 
 Error ShadowMapping::init(const ConfigSet& config)
@@ -69,8 +67,42 @@ Error ShadowMapping::initEsm(const ConfigSet& cfg)
 	// Init RTs and FBs
 	{
 		m_tileResolution = cfg.getNumber("r.shadowMapping.resolution");
-		m_tileCountPerRowOrColumn = cfg.getNumber("r.shadowMapping.tileCountPerRowOrColumn");
-		m_atlasResolution = m_tileResolution * m_tileCountPerRowOrColumn;
+		const U32 tileCountPerRowOrColumn = cfg.getNumber("r.shadowMapping.tileCountPerRowOrColumn");
+		m_atlasResolution = m_tileResolution * tileCountPerRowOrColumn;
+		m_lodCount = cfg.getNumber("r.shadowMapping.lodCount");
+		m_lodHysteresis = cfg.getNumber("r.shadowMapping.lodHysteresis");
+
+		if(!isPowerOfTwo(m_tileResolution) || !isPowerOfTwo(tileCountPerRowOrColumn))
+		{
+			ANKI_R_LOGE("r.shadowMapping.resolution and r.shadowMapping.tileCountPerRowOrColumn should be powers of 2");
+			return Error::USER_DATA;
+		}
+
+		if(tileCountPerRowOrColumn > 32 || m_lodCount == 0 || (m_tileResolution >> (m_lodCount - 1)) < 8)
+		{
+			ANKI_R_LOGE("Wrong r.shadowMapping.tileCountPerRowOrColumn or r.shadowMapping.lodCount");
+			return Error::USER_DATA;
+		}
+
+		// The tiles of the last LOD are the leaves of the quadtree of the atlas
+		U32 levelCount = m_lodCount;
+		while((1u << (levelCount - m_lodCount)) < tileCountPerRowOrColumn)
+		{
+			++levelCount;
+		}
+
+		if(levelCount > TileAllocator::MAX_LEVEL_COUNT)
+		{
+			ANKI_R_LOGE("Too many tile sizes. Decrease r.shadowMapping.tileCountPerRowOrColumn or "
+						"r.shadowMapping.lodCount");
+			return Error::USER_DATA;
+		}
+
+		if(m_lodHysteresis < 0.0f || m_lodHysteresis >= 1.0f)
+		{
+			ANKI_R_LOGE("r.shadowMapping.lodHysteresis should be in [0, 1)");
+			return Error::USER_DATA;
+		}
 
 		// RT
 		TextureInitInfo texinit = m_r->create2DRenderTargetInitInfo(m_atlasResolution,
@@ -91,29 +123,22 @@ Error ShadowMapping::initEsm(const ConfigSet& cfg)
 
 	// Tiles
 	{
-		m_tiles.create(getAllocator(), m_tileCountPerRowOrColumn * m_tileCountPerRowOrColumn);
+		m_tileAlloc.init(getAllocator(), m_atlasResolution, m_tileResolution, m_lodCount);
 
-		for(U y = 0; y < m_tileCountPerRowOrColumn; ++y)
+		// The point lights store the tile indices of their faces in 5 bits
+		m_pointLightMaxLod = 0;
+		while(m_pointLightMaxLod + 1 < m_lodCount
+			  && m_atlasResolution / m_tileAlloc.getTileResolution(m_pointLightMaxLod + 1) <= 32)
 		{
-			for(U x = 0; x < m_tileCountPerRowOrColumn; ++x)
-			{
-				const U tileIdx = y * m_tileCountPerRowOrColumn + x;
-				Tile& tile = m_tiles[tileIdx];
-
-				tile.m_uv[0] = F32(x) / m_tileCountPerRowOrColumn;
-				tile.m_uv[1] = F32(y) / m_tileCountPerRowOrColumn;
-				tile.m_uv[2] = 1.0f / m_tileCountPerRowOrColumn;
-				tile.m_uv[3] = tile.m_uv[2];
-
-				tile.m_viewport[0] = x * m_tileResolution;
-				tile.m_viewport[1] = y * m_tileResolution;
-				tile.m_viewport[2] = m_tileResolution;
-				tile.m_viewport[3] = m_tileResolution;
-			}
+			++m_pointLightMaxLod;
 		}
 
-		// The first tile is always pinned
-		m_tiles[0].m_pinned = true;
+		// The faces of the point lights that don't have shadow casters point to the tile at the origin. It's never
+		// rendered. It's as big as the biggest tile of the point lights
+		Array<U32, 4> viewport;
+		const Bool failed = m_tileAlloc.allocatePinned(0, viewport);
+		(void)failed;
+		ANKI_ASSERT(!failed && viewport[0] == 0 && viewport[1] == 0);
 	}
 
 	// Programs and shaders
@@ -124,9 +149,7 @@ Error ShadowMapping::initEsm(const ConfigSet& cfg)
 		ShaderProgramResourceConstantValueInitList<1> consts(m_esmResolveProg);
 		consts.add("INPUT_TEXTURE_SIZE", UVec2(m_scratchTileCount * m_scratchTileResolution, m_scratchTileResolution));
 
-		const ShaderProgramResourceVariant* variant;
-		m_esmResolveProg->getOrCreateVariant(consts.get(), variant);
-		m_esmResolveGrProg = variant->getProgram();
+		getProgramVariant(m_esmResolveProg, consts.get(), m_esmResolveGrProg);
 	}
 
 	return Error::NONE;
@@ -225,7 +248,7 @@ void ShadowMapping::populateRenderGraph(RenderingContext& ctx)
 			m_scratchRt = rgraph.newRenderTarget(m_scratchRtDescr);
 			pass.setFramebufferInfo(m_scratchFbDescr, {}, m_scratchRt, minx, miny, width, height);
 			ANKI_ASSERT(
-				threadCountForScratchPass && threadCountForScratchPass <= m_r->getThreadPool().getThreadCount());
+				threadCountForScratchPass && threadCountForScratchPass <= m_r->getThreadHive().getThreadCount());
 			pass.setWork(runShadowmappingCallback, this, threadCountForScratchPass);
 
 			TextureSubresourceInfo subresource = TextureSubresourceInfo(DepthStencilAspectBit::DEPTH);
@@ -254,16 +277,18 @@ void ShadowMapping::populateRenderGraph(RenderingContext& ctx)
 	}
 }
 
-Mat4 ShadowMapping::createSpotLightTextureMatrix(const Tile& tile)
+Mat4 ShadowMapping::createSpotLightTextureMatrix(const Array<U32, 4>& viewport) const
 {
-	return Mat4(tile.m_uv[2],
+	const Vec4 uv =
+		Vec4(F32(viewport[0]), F32(viewport[1]), F32(viewport[2]), F32(viewport[3])) / F32(m_atlasResolution);
+	return Mat4(uv[2],
 		0.0,
 		0.0,
-		tile.m_uv[0],
+		uv[0],
 		0.0,
-		tile.m_uv[3],
+		uv[3],
 		0.0,
-		tile.m_uv[1],
+		uv[1],
 		0.0,
 		0.0,
 		1.0,
@@ -274,6 +299,22 @@ Mat4 ShadowMapping::createSpotLightTextureMatrix(const Tile& tile)
 		1.0);
 }
 
+U32 ShadowMapping::computeTileLod(
+	const RenderingContext& ctx, const Vec3& center, F32 radius, U64 lightUuid, U32 lightFace) const
+{
+	const Vec3 cameraPos = ctx.m_renderQueue->m_cameraTransform.getTranslationPart().xyz();
+	const F32 distance = (center - cameraPos).getLength();
+	if(distance <= radius)
+	{
+		return 0;
+	}
+
+	// The pixels that the diameter of the sphere covers in the vertical direction
+	const F32 pixels = radius / distance * ctx.m_renderQueue->m_projectionMatrix(1, 1) * F32(m_r->getHeight());
+
+	return m_tileAlloc.selectLod(pixels, lightUuid, lightFace, m_lodHysteresis);
+}
+
 void ShadowMapping::processLights(RenderingContext& ctx, U32& threadCountForScratchPass)
 {
 	// Reset stuff
@@ -288,7 +329,7 @@ void ShadowMapping::processLights(RenderingContext& ctx, U32& threadCountForScra
 	for(PointLightQueueElement* light : ctx.m_renderQueue->m_shadowPointLights)
 	{
 		// Prepare data to allocate tiles and allocate
-		Array<U32, 6> tiles;
+		Array<Array<U32, 4>, 6> atlasViewports;
 		Array<U32, 6> scratchTiles;
 		Array<U64, 6> timestamps;
 		Array<U32, 6> faceIndices;
@@ -311,21 +352,31 @@ void ShadowMapping::processLights(RenderingContext& ctx, U32& threadCountForScra
 				++numOfFacesThatHaveDrawcalls;
 			}
 		}
+		// All the faces have the same LOD because the shaders expect one tile size
+		const U32 lod = min(computeTileLod(ctx,
+								light->m_worldPosition,
+								light->m_radius,
+								light->m_uuid,
+								(numOfFacesThatHaveDrawcalls) ? faceIndices[0] : 0),
+			m_pointLightMaxLod);
+
 		const Bool allocationFailed = numOfFacesThatHaveDrawcalls == 0
 									  || allocateTilesAndScratchTiles(light->m_uuid,
 											 numOfFacesThatHaveDrawcalls,
 											 &timestamps[0],
 											 &faceIndices[0],
 											 &drawcallCounts[0],
-											 &tiles[0],
+											 lod,
+											 &atlasViewports[0],
 											 &scratchTiles[0]);
 
 		if(!allocationFailed)
 		{
 			// All good, update the lights
 
+			const U32 tileResolution = m_tileAlloc.getTileResolution(lod);
 			light->m_atlasTiles = UVec2(0u);
-			light->m_atlasTileSize = 1.0f / m_tileCountPerRowOrColumn;
+			light->m_atlasTileSize = F32(tileResolution) / F32(m_atlasResolution);
 
 			numOfFacesThatHaveDrawcalls = 0;
 			for(U face = 0; face < 6; ++face)
@@ -334,16 +385,16 @@ void ShadowMapping::processLights(RenderingContext& ctx, U32& threadCountForScra
 				{
 					// Has drawcalls, asigned it to a tile
 
-					const U32 tileIdx = tiles[numOfFacesThatHaveDrawcalls];
-					const U32 tileIdxX = tileIdx % m_tileCountPerRowOrColumn;
-					const U32 tileIdxY = tileIdx / m_tileCountPerRowOrColumn;
+					const Array<U32, 4>& viewport = atlasViewports[numOfFacesThatHaveDrawcalls];
+					const U32 tileIdxX = viewport[0] / tileResolution;
+					const U32 tileIdxY = viewport[1] / tileResolution;
 					ANKI_ASSERT(tileIdxX <= 31u && tileIdxY <= 31u);
 					light->m_atlasTiles.x() |= tileIdxX << (5u * face);
 					light->m_atlasTiles.y() |= tileIdxY << (5u * face);
 
 					if(scratchTiles[numOfFacesThatHaveDrawcalls] != MAX_U32)
 					{
-						newScratchAndEsmResloveRenderWorkItems(tiles[numOfFacesThatHaveDrawcalls],
+						newScratchAndEsmResloveRenderWorkItems(viewport,
 							scratchTiles[numOfFacesThatHaveDrawcalls],
 							light->m_shadowRenderQueues[face],
 							lightsToRender,
@@ -373,8 +424,17 @@ void ShadowMapping::processLights(RenderingContext& ctx, U32& threadCountForScra
 	{
 		ANKI_ASSERT(light->m_shadowRenderQueue);
 
+		// The bounding sphere of the cone
+		const F32 halfDistance = light->m_distance / 2.0f;
+		const F32 baseRadius = light->m_distance * tan(light->m_outerAngle / 2.0f);
+		const Vec3 center = light->m_worldTransform.getTranslationPart().xyz()
+							- light->m_worldTransform.getColumn(2).xyz() * halfDistance;
+		const U32 lod =
+			computeTileLod(ctx, center, sqrt(halfDistance * halfDistance + baseRadius * baseRadius), light->m_uuid, 0);
+
 		// Allocate tiles
-		U32 tileIdx, scratchTileIdx, faceIdx = 0;
+		Array<U32, 4> atlasViewport;
+		U32 scratchTileIdx, faceIdx = 0;
 		const U32 localDrawcallCount = light->m_shadowRenderQueue->m_renderables.getSize();
 		const Bool allocationFailed = localDrawcallCount == 0
 									  || allocateTilesAndScratchTiles(light->m_uuid,
@@ -382,7 +442,8 @@ void ShadowMapping::processLights(RenderingContext& ctx, U32& threadCountForScra
 											 &light->m_shadowRenderQueue->m_shadowRenderablesLastUpdateTimestamp,
 											 &faceIdx,
 											 &localDrawcallCount,
-											 &tileIdx,
+											 lod,
+											 &atlasViewport,
 											 &scratchTileIdx);
 
 		if(!allocationFailed)
@@ -390,12 +451,16 @@ void ShadowMapping::processLights(RenderingContext& ctx, U32& threadCountForScra
 			// All good, update the light
 
 			// Update the texture matrix to point to the correct region in the atlas
-			light->m_textureMatrix = createSpotLightTextureMatrix(m_tiles[tileIdx]) * light->m_textureMatrix;
+			light->m_textureMatrix = createSpotLightTextureMatrix(atlasViewport) * light->m_textureMatrix;
 
 			if(scratchTileIdx != MAX_U32)
 			{
-				newScratchAndEsmResloveRenderWorkItems(
-					tileIdx, scratchTileIdx, light->m_shadowRenderQueue, lightsToRender, esmWorkItems, drawcallCount);
+				newScratchAndEsmResloveRenderWorkItems(atlasViewport,
+					scratchTileIdx,
+					light->m_shadowRenderQueue,
+					lightsToRender,
+					esmWorkItems,
+					drawcallCount);
 			}
 		}
 		else
@@ -479,20 +544,24 @@ void ShadowMapping::processLights(RenderingContext& ctx, U32& threadCountForScra
 	}
 }
 
-void ShadowMapping::newScratchAndEsmResloveRenderWorkItems(U32 tileIdx,
+void ShadowMapping::newScratchAndEsmResloveRenderWorkItems(const Array<U32, 4>& atlasViewport,
 	U32 scratchTileIdx,
 	RenderQueue* lightRenderQueue,
 	DynamicArrayAuto<LightToRenderToScratchInfo>& scratchWorkItem,
 	DynamicArrayAuto<EsmResolveWorkItem>& esmResolveWorkItem,
 	U32& drawcallCount) const
 {
+	// Render to a part of the scratch tile that has the resolution of the atlas tile
+	const U32 tileResolution = atlasViewport[2];
+	ANKI_ASSERT(tileResolution <= m_scratchTileResolution);
+
 	// Scratch work item
 	{
 		Array<U32, 4> viewport;
 		viewport[0] = scratchTileIdx * m_scratchTileResolution;
 		viewport[1] = 0;
-		viewport[2] = m_scratchTileResolution;
-		viewport[3] = m_scratchTileResolution;
+		viewport[2] = tileResolution;
+		viewport[3] = tileResolution;
 
 		LightToRenderToScratchInfo toRender = {
 			viewport, lightRenderQueue, U32(lightRenderQueue->m_renderables.getSize())};
@@ -505,10 +574,10 @@ void ShadowMapping::newScratchAndEsmResloveRenderWorkItems(U32 tileIdx,
 		EsmResolveWorkItem esmItem;
 		esmItem.m_uvIn[0] = F32(scratchTileIdx) / m_scratchTileCount;
 		esmItem.m_uvIn[1] = 0.0f;
-		esmItem.m_uvIn[2] = 1.0f / m_scratchTileCount;
-		esmItem.m_uvIn[3] = 1.0f;
+		esmItem.m_uvIn[2] = F32(tileResolution) / F32(m_scratchTileResolution * m_scratchTileCount);
+		esmItem.m_uvIn[3] = F32(tileResolution) / F32(m_scratchTileResolution);
 
-		esmItem.m_viewportOut = m_tiles[tileIdx].m_viewport;
+		esmItem.m_viewportOut = atlasViewport;
 
 		esmItem.m_cameraFar = lightRenderQueue->m_cameraFar;
 		esmItem.m_cameraNear = lightRenderQueue->m_cameraNear;
@@ -522,43 +591,47 @@ Bool ShadowMapping::allocateTilesAndScratchTiles(U64 lightUuid,
 	const U64* faceTimestamps,
 	const U32* faceIndices,
 	const U32* drawcallsCount,
-	U32* tileIndices,
+	U32 lod,
+	Array<U32, 4>* atlasViewports,
 	U32* scratchTileIndices)
 {
 	ANKI_ASSERT(faceTimestamps);
 	ANKI_ASSERT(lightUuid > 0);
 	ANKI_ASSERT(faceCount > 0 && faceCount <= 6);
-	ANKI_ASSERT(faceIndices && tileIndices && scratchTileIndices && drawcallsCount);
+	ANKI_ASSERT(faceIndices && atlasViewports && scratchTileIndices && drawcallsCount);
 
 	Bool failed = false;
-	Array<Bool, 6> inTheCache;
+	Array<TileAllocatorResult, 6> results;
+	U32 allocatedCount = 0;
 
 	// Allocate ESM tiles
+	for(; allocatedCount < faceCount && !failed; ++allocatedCount)
 	{
-		memset(tileIndices, 0xFF, sizeof(*tileIndices) * faceCount);
-		for(U i = 0; i < faceCount && !failed; ++i)
-		{
-			failed = allocateTile(faceTimestamps[i], lightUuid, faceIndices[i], tileIndices[i], inTheCache[i]);
-		}
-
-		// Unpin the tiles
-		for(U i = 0; i < faceCount; ++i)
+		const U32 i = allocatedCount;
+		results[i] = m_tileAlloc.allocate(m_r->getGlobalTimestamp(),
+			faceTimestamps[i],
+			lightUuid,
+			faceIndices[i],
+			drawcallsCount[i],
+			lod,
+			atlasViewports[i]);
+
+		if(results[i] == TileAllocatorResult::ALLOCATION_FAILED)
 		{
-			if(tileIndices[i] != MAX_U32)
-			{
-				m_tiles[tileIndices[i]].m_pinned = false;
-			}
+			ANKI_R_LOGW("There is not enough space in the shadow atlas for more shadow maps. "
+						"Increase the r.shadowMapping.tileCountPerRowOrColumn or decrease the scene's shadow casters");
+			failed = true;
 		}
 	}
 
 	// Allocate scratch tiles
+	if(!failed)
 	{
 		U32 freeScratchTiles = m_freeScratchTiles;
 		for(U i = 0; i < faceCount && !failed; ++i)
 		{
 			scratchTileIndices[i] = MAX_U32;
-			const Bool shouldRender = shouldRenderTile(
-				faceTimestamps[i], lightUuid, faceIndices[i], m_tiles[tileIndices[i]], drawcallsCount[i]);
+			const Bool shouldRender = results[i] == TileAllocatorResult::ALLOCATION_SUCCEEDED;
 			const Bool scratchTileFailed = shouldRender && freeScratchTiles == 0;
 
 			if(scratchTileFailed)
@@ -581,23 +654,14 @@ Bool ShadowMapping::allocateTilesAndScratchTiles(U64 lightUuid,
 		}
 	}
 
-	// Update the tiles if everything was successful
-	if(!failed)
+	// The tiles that won't be rendered don't have valid contents, release them
+	if(failed)
 	{
-		for(U i = 0; i < faceCount; ++i)
+		for(U i = 0; i < allocatedCount; ++i)
 		{
-			Tile& tile = m_tiles[tileIndices[i]];
-			tile.m_face = faceIndices[i];
-			tile.m_lightUuid = lightUuid;
-			tile.m_lastUsedTimestamp = m_r->getGlobalTimestamp();
-			tile.m_drawcallCount = drawcallsCount[i];
-
-			// Update the cache
-			if(!inTheCache[i])
+			if(results[i] == TileAllocatorResult::ALLOCATION_SUCCEEDED)
 			{
-				TileKey key{lightUuid, faceIndices[i]};
-				ANKI_ASSERT(m_lightUuidToTileIdx.find(key) == m_lightUuidToTileIdx.getEnd());
-				m_lightUuidToTileIdx.emplace(getAllocator(), key, tileIndices[i]);
+				m_tileAlloc.invalidateCache(lightUuid, faceIndices[i]);
 			}
 		}
 	}
@@ -605,97 +669,4 @@ Bool ShadowMapping::allocateTilesAndScratchTiles(U64 lightUuid,
 	return failed;
 }
 
-Bool ShadowMapping::shouldRenderTile(
-	U64 lightTimestamp, U64 lightUuid, U32 face, const Tile& tileIdx, U32 drawcallCount)
-{
-	if(tileIdx.m_face == face && tileIdx.m_lightUuid == lightUuid && tileIdx.m_lastUsedTimestamp >= lightTimestamp
-		&& tileIdx.m_drawcallCount == drawcallCount)
-	{
-		return false;
-	}
-	else
-	{
-		return true;
-	}
-}
-
-Bool ShadowMapping::allocateTile(U64 lightTimestamp, U64 lightUuid, U32 face, U32& tileAllocated, Bool& inTheCache)
-{
-	ANKI_ASSERT(lightTimestamp > 0);
-	ANKI_ASSERT(lightUuid > 0);
-	ANKI_ASSERT(face < 6);
-
-	// First, try to see if the light/face is in the cache
-	inTheCache = false;
-	TileKey key = TileKey{lightUuid, U64(face)};
-	auto it = m_lightUuidToTileIdx.find(key);
-	if(it != m_lightUuidToTileIdx.getEnd())
-	{
-		const U32 tileIdx = *it;
-		if(m_tiles[tileIdx].m_lightUuid == lightUuid && m_tiles[tileIdx].m_face == face && !m_tiles[tileIdx].m_pinned)
-		{
-			// Found it
-			tileAllocated = tileIdx;
-			inTheCache = true;
-			return false;
-		}
-		else
-		{
-			// Cache entry is wrong, remove it
-			m_lightUuidToTileIdx.erase(getAllocator(), it);
-		}
-	}
-
-	// 2nd and 3rd choice, find an empty tile or some tile to re-use
-	U32 emptyTile = MAX_U32;
-	U32 tileToKick = MAX_U32;
-	Timestamp tileToKickMinTimestamp = MAX_TIMESTAMP;
-	for(U32 tileIdx = 0; tileIdx < m_tiles.getSize(); ++tileIdx)
-	{
-		if(m_tiles[tileIdx].m_pinned)
-		{
-			continue;
-		}
-
-		if(m_tiles[tileIdx].m_lightUuid == 0)
-		{
-			// Found an empty
-			emptyTile = tileIdx;
-			break;
-		}
-		else if(m_tiles[tileIdx].m_lastUsedTimestamp != m_r->getGlobalTimestamp()
-				&& m_tiles[tileIdx].m_lastUsedTimestamp < tileToKickMinTimestamp)
-		{
-			// Found some with low timestamp
-			tileToKick = tileIdx;
-			tileToKickMinTimestamp = m_tiles[tileIdx].m_lastUsedTimestamp;
-		}
-	}
-
-	Bool failed = false;
-	if(emptyTile != MAX_U32)
-	{
-		tileAllocated = emptyTile;
-	}
-	else if(tileToKick != MAX_U32)
-	{
-		tileAllocated = tileToKick;
-	}
-	else
-	{
-		// We have a problem
-		failed = true;
-		ANKI_R_LOGW("There is not enough space in the shadow atlas for more shadow maps. "
-					"Increase the r.shadowMapping.tileCountPerRowOrColumn or decrease the scene's shadow casters");
-	}
-
-	if(!failed)
-	{
-		ANKI_ASSERT(!m_tiles[tileAllocated].m_pinned);
-		m_tiles[tileAllocated].m_pinned = true;
-	}
-
-	return failed;
-}
-
 } // end namespace anki
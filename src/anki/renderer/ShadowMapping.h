@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/renderer/RendererObject.h>
+#include <anki/renderer/TileAllocator.h>
 #include <anki/Gr.h>
 #include <anki/resource/TextureResource.h>
 
@@ -40,50 +41,20 @@ private:
 	/// @name ESM stuff
 	/// @{
 
-	/// The ESM map consists of tiles.
-	class Tile
-	{
-	public:
-		U64 m_lastUsedTimestamp = 0;
-		U64 m_lightUuid = 0;
-		U32 m_drawcallCount = 0;
-		U8 m_face = 0;
-		Bool8 m_pinned = false; ///< If true we cannot allocate from it.
-
-		Vec4 m_uv;
-		Array<U32, 4> m_viewport;
-	};
-
-	/// A HashMap key.
-	class TileKey
-	{
-	public:
-		U64 m_lightUuid;
-		U64 m_face;
-
-		U64 computeHash() const
-		{
-			return anki::computeHash(this, sizeof(*this), 693);
-		}
-	};
-
 	FramebufferDescription m_esmFbDescr; ///< The FB for ESM
 	TexturePtr m_esmAtlas; ///< ESM texture atlas.
 	RenderTargetHandle m_esmRt;
 
-	U32 m_tileResolution = 0; ///< Tile resolution.
+	U32 m_tileResolution = 0; ///< Resolution of the tiles of LOD 0.
 	U32 m_atlasResolution = 0; ///< Atlas size is (m_atlasResolution, m_atlasResolution)
-	U32 m_tileCountPerRowOrColumn = 0;
-	DynamicArray<Tile> m_tiles;
+	U32 m_lodCount = 0;
+	U32 m_pointLightMaxLod = 0; ///< The point lights can't go lower than that because of the way they store tiles.
+	F32 m_lodHysteresis = 0.0f;
+	TileAllocator m_tileAlloc;
 
 	ShaderProgramResourcePtr m_esmResolveProg;
 	ShaderProgramPtr m_esmResolveGrProg;
 
-	HashMap<TileKey, U32> m_lightUuidToTileIdx;
-
-	Bool allocateTile(U64 lightTimestamp, U64 lightUuid, U32 face, U32& tileAllocated, Bool& inTheCache);
-	static Bool shouldRenderTile(U64 lightTimestamp, U64 lightUuid, U32 face, const Tile& tileIdx, U32 drawcallCount);
-
 	class EsmResolveWorkItem
 	{
 	public:
@@ -96,7 +67,12 @@ private:
 
 	ANKI_USE_RESULT Error initEsm(const ConfigSet& cfg);
 
-	static Mat4 createSpotLightTextureMatrix(const Tile& tile);
+	Mat4 createSpotLightTextureMatrix(const Array<U32, 4>& viewport) const;
+
+	/// Choose the LOD of a light's tiles from the pixels its bounding sphere covers on the screen.
+	/// @param lightFace A face of the light that will get a tile. Its previous tile is used for the hysteresis.
+	U32 computeTileLod(
+		const RenderingContext& ctx, const Vec3& center, F32 radius, U64 lightUuid, U32 lightFace) const;
 
 	/// A RenderPassWorkCallback for ESM
 	static void runEsmCallback(RenderPassWorkContext& rgraphCtx)
@@ -151,11 +127,12 @@ private:
 		const U64* faceTimestamps,
 		const U32* faceIndices,
 		const U32* drawcallsCount,
-		U32* tileIndices,
+		U32 lod,
+		Array<U32, 4>* atlasViewports,
 		U32* scratchTileIndices);
 
 	/// Add new work to render to scratch buffer and ESM buffer.
-	void newScratchAndEsmResloveRenderWorkItems(U32 tileIdx,
+	void newScratchAndEsmResloveRenderWorkItems(const Array<U32, 4>& atlasViewport,
 		U32 scratchTileIdx,
 		RenderQueue* lightRenderQueue,
 		DynamicArrayAuto<LightToRenderToScratchInfo>& scratchWorkItem,
@@ -44,9 +44,7 @@ Error Ssao::initMain(const ConfigSet& config)
 		.add("STRENGTH", 2.5f)
 		.add("SAMPLE_COUNT", 8u)
 		.add("WORKGROUP_SIZE", UVec2(m_workgroupSize[0], m_workgroupSize[1]));
-	const ShaderProgramResourceVariant* variant;
-	m_main.m_prog->getOrCreateVariant(mutators.get(), consts.get(), variant);
-	m_main.m_grProg = variant->getProgram();
+	getProgramVariant(m_main.m_prog, mutators.get(), consts.get(), m_main.m_grProg);
 
 	return Error::NONE;
 }
@@ -64,10 +62,7 @@ Error Ssao::initBlur(const ConfigSet& config)
 		consts.add("TEXTURE_SIZE", UVec2(m_width, m_height))
 			.add("WORKGROUP_SIZE", UVec2(m_workgroupSize[0], m_workgroupSize[1]));
 
-		const ShaderProgramResourceVariant* variant;
-		m_blur.m_prog->getOrCreateVariant(mutators.get(), consts.get(), variant);
-
-		m_blur.m_grProg = variant->getProgram();
+		getProgramVariant(m_blur.m_prog, mutators.get(), consts.get(), m_blur.m_grProg);
 	}
 	else
 	{
@@ -78,10 +73,7 @@ Error Ssao::initBlur(const ConfigSet& config)
 		ShaderProgramResourceConstantValueInitList<1> consts(m_blur.m_prog);
 		consts.add("TEXTURE_SIZE", UVec2(m_width, m_height));
 
-		const ShaderProgramResourceVariant* variant;
-		m_blur.m_prog->getOrCreateVariant(mutators.get(), consts.get(), variant);
-
-		m_blur.m_grProg = variant->getProgram();
+		getProgramVariant(m_blur.m_prog, mutators.get(), consts.get(), m_blur.m_grProg);
 	}
 
 	return Error::NONE;
@@ -51,13 +51,10 @@ Error Ssr::initInternal(const ConfigSet& cfg)
 	ShaderProgramResourceMutationInitList<1> mutators(m_prog);
 	mutators.add("VARIANT", 0);
 
-	const ShaderProgramResourceVariant* variant;
-	m_prog->getOrCreateVariant(mutators.get(), consts.get(), variant);
-	m_grProg[0] = variant->getProgram();
+	getProgramVariant(m_prog, mutators.get(), consts.get(), m_grProg[0]);
 
 	mutators[0].m_value = 1;
-	m_prog->getOrCreateVariant(mutators.get(), consts.get(), variant);
-	m_grProg[1] = variant->getProgram();
+	getProgramVariant(m_prog, mutators.get(), consts.get(), m_grProg[1]);
 
 	return Error::NONE;
 }
@@ -46,9 +46,7 @@ Error TemporalAA::initInternal(const ConfigSet& config)
 		ShaderProgramResourceMutationInitList<4> mutations(m_prog);
 		mutations.add("SHARPEN", i + 1).add("VARIANCE_CLIPPING", 1).add("TONEMAP_FIX", 1).add("YCBCR", 0);
 
-		const ShaderProgramResourceVariant* variant;
-		m_prog->getOrCreateVariant(mutations.get(), consts.get(), variant);
-		m_grProgs[i] = variant->getProgram();
+		getProgramVariant(m_prog, mutations.get(), consts.get(), m_grProgs[i]);
 	}
 
 	for(U i = 0; i < 2; ++i)
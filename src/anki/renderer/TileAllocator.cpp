@@ -0,0 +1,334 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/renderer/TileAllocator.h>
+
+namespace anki
+{
+
+TileAllocator::~TileAllocator()
+{
+	m_nodes.destroy(m_alloc);
+	m_lightInfoToNodeIdx.destroy(m_alloc);
+}
+
+void TileAllocator::init(HeapAllocator<U8> alloc, U32 atlasResolution, U32 maxTileResolution, U32 lodCount)
+{
+	ANKI_ASSERT(isPowerOfTwo(atlasResolution) && isPowerOfTwo(maxTileResolution));
+	ANKI_ASSERT(maxTileResolution <= atlasResolution);
+	ANKI_ASSERT(lodCount > 0 && (maxTileResolution >> (lodCount - 1)) > 0);
+
+	m_alloc = alloc;
+	m_atlasResolution = atlasResolution;
+	m_lodCount = lodCount;
+
+	m_lod0Level = 0;
+	while((atlasResolution >> m_lod0Level) > maxTileResolution)
+	{
+		++m_lod0Level;
+	}
+
+	const U32 levelCount = m_lod0Level + lodCount;
+	ANKI_ASSERT(levelCount <= MAX_LEVEL_COUNT && "Too many nodes");
+	U32 nodeCount = 0;
+	for(U32 level = 0; level < levelCount; ++level)
+	{
+		nodeCount += 1u << (2u * level);
+	}
+
+	m_nodes.create(m_alloc, nodeCount);
+
+	// The root is the whole atlas. Compute the positions of the rest
+	m_nodes[0].m_state = NodeState::FREE;
+	for(U32 i = 1; i < nodeCount; ++i)
+	{
+		const Node& parent = m_nodes[(i - 1) / 4];
+		const U32 child = (i - 1) % 4;
+
+		Node& node = m_nodes[i];
+		node.m_level = parent.m_level + 1;
+		node.m_x = parent.m_x * 2 + (child & 1);
+		node.m_y = parent.m_y * 2 + (child >> 1);
+	}
+}
+
+U32 TileAllocator::findFreeNode(U32 level) const
+{
+	// Search the small nodes first to leave the big ones for the big tiles
+	for(I32 l = level; l >= 0; --l)
+	{
+		const U32 first = ((1u << (2u * l)) - 1) / 3;
+		const U32 count = 1u << (2u * l);
+		for(U32 i = first; i < first + count; ++i)
+		{
+			if(m_nodes[i].m_state == NodeState::FREE)
+			{
+				return i;
+			}
+		}
+	}
+
+	return MAX_U32;
+}
+
+Bool TileAllocator::getSubtreeTimestamp(U32 nodeIdx, Timestamp crntTimestamp, Timestamp& timestamp) const
+{
+	const Node& node = m_nodes[nodeIdx];
+	timestamp = 0;
+
+	if(node.m_state == NodeState::ALLOCATED)
+	{
+		if(node.m_pinned || node.m_lastUsedTimestamp == crntTimestamp)
+		{
+			return false;
+		}
+
+		timestamp = node.m_lastUsedTimestamp;
+	}
+	else if(node.m_state == NodeState::SPLIT)
+	{
+		for(U32 i = 0; i < 4; ++i)
+		{
+			Timestamp childTimestamp;
+			if(!getSubtreeTimestamp(nodeIdx * 4 + 1 + i, crntTimestamp, childTimestamp))
+			{
+				return false;
+			}
+
+			timestamp = max(timestamp, childTimestamp);
+		}
+	}
+
+	return true;
+}
+
+void TileAllocator::findNodeToKick(
+	U32 nodeIdx, U32 level, Timestamp crntTimestamp, U32& nodeToKick, Timestamp& minTimestamp) const
+{
+	const Node& node = m_nodes[nodeIdx];
+
+	if(node.m_level == level || node.m_state == NodeState::ALLOCATED)
+	{
+		// Kicking this node will free enough space
+		Timestamp timestamp;
+		if(getSubtreeTimestamp(nodeIdx, crntTimestamp, timestamp) && timestamp < minTimestamp)
+		{
+			nodeToKick = nodeIdx;
+			minTimestamp = timestamp;
+		}
+	}
+	else if(node.m_state == NodeState::SPLIT)
+	{
+		for(U32 i = 0; i < 4; ++i)
+		{
+			findNodeToKick(nodeIdx * 4 + 1 + i, level, crntTimestamp, nodeToKick, minTimestamp);
+		}
+	}
+}
+
+void TileAllocator::kickSubtree(U32 nodeIdx)
+{
+	Node& node = m_nodes[nodeIdx];
+
+	if(node.m_state == NodeState::ALLOCATED)
+	{
+		ANKI_ASSERT(!node.m_pinned);
+		auto it = m_lightInfoToNodeIdx.find(TileKey{node.m_lightUuid, node.m_lightFace});
+		ANKI_ASSERT(it != m_lightInfoToNodeIdx.getEnd() && *it == nodeIdx);
+		m_lightInfoToNodeIdx.erase(m_alloc, it);
+
+		node.m_lightUuid = 0;
+		node.m_state = NodeState::FREE;
+	}
+	else if(node.m_state == NodeState::SPLIT)
+	{
+		for(U32 i = 0; i < 4; ++i)
+		{
+			kickSubtree(nodeIdx * 4 + 1 + i);
+			m_nodes[nodeIdx * 4 + 1 + i].m_state = NodeState::UNUSED;
+		}
+
+		node.m_state = NodeState::FREE;
+	}
+}
+
+void TileAllocator::mergeUpwards(U32 nodeIdx)
+{
+	while(nodeIdx != 0)
+	{
+		const U32 parentIdx = (nodeIdx - 1) / 4;
+		const U32 firstChildIdx = parentIdx * 4 + 1;
+
+		for(U32 i = 0; i < 4; ++i)
+		{
+			if(m_nodes[firstChildIdx + i].m_state != NodeState::FREE)
+			{
+				return;
+			}
+		}
+
+		for(U32 i = 0; i < 4; ++i)
+		{
+			m_nodes[firstChildIdx + i].m_state = NodeState::UNUSED;
+		}
+
+		m_nodes[parentIdx].m_state = NodeState::FREE;
+		nodeIdx = parentIdx;
+	}
+}
+
+void TileAllocator::freeNode(U32 nodeIdx)
+{
+	kickSubtree(nodeIdx);
+	mergeUpwards(nodeIdx);
+}
+
+U32 TileAllocator::newNode(U32 level, Timestamp crntTimestamp)
+{
+	U32 nodeIdx = findFreeNode(level);
+
+	if(nodeIdx == MAX_U32)
+	{
+		// No space, kick the tiles that were used the longest time ago
+		U32 nodeToKick = MAX_U32;
+		Timestamp minTimestamp = MAX_TIMESTAMP;
+		findNodeToKick(0, level, crntTimestamp, nodeToKick, minTimestamp);
+		if(nodeToKick == MAX_U32)
+		{
+			return MAX_U32;
+		}
+
+		freeNode(nodeToKick);
+		nodeIdx = findFreeNode(level);
+		ANKI_ASSERT(nodeIdx != MAX_U32);
+	}
+
+	// Split until the node has the right size
+	while(m_nodes[nodeIdx].m_level < level)
+	{
+		m_nodes[nodeIdx].m_state = NodeState::SPLIT;
+
+		const U32 firstChildIdx = nodeIdx * 4 + 1;
+		for(U32 i = 0; i < 4; ++i)
+		{
+			m_nodes[firstChildIdx + i].m_state = NodeState::FREE;
+		}
+
+		nodeIdx = firstChildIdx;
+	}
+
+	return nodeIdx;
+}
+
+TileAllocatorResult TileAllocator::allocate(Timestamp crntTimestamp,
+	Timestamp lightTimestamp,
+	U64 lightUuid,
+	U32 lightFace,
+	U32 drawcallCount,
+	U32 lod,
+	Array<U32, 4>& viewport)
+{
+	ANKI_ASSERT(lightTimestamp > 0);
+	ANKI_ASSERT(lightUuid > 0);
+	ANKI_ASSERT(lightFace < 6);
+	ANKI_ASSERT(lod < m_lodCount);
+
+	const U32 level = m_lod0Level + lod;
+
+	// First, try to see if the light face is in the cache
+	const TileKey key{lightUuid, lightFace};
+	auto it = m_lightInfoToNodeIdx.find(key);
+	if(it != m_lightInfoToNodeIdx.getEnd())
+	{
+		const U32 nodeIdx = *it;
+		Node& node = m_nodes[nodeIdx];
+		ANKI_ASSERT(node.m_state == NodeState::ALLOCATED);
+		ANKI_ASSERT(node.m_lightUuid == lightUuid && node.m_lightFace == lightFace);
+
+		if(node.m_level == level)
+		{
+			const Bool valid = node.m_lastUsedTimestamp >= lightTimestamp && node.m_drawcallCount == drawcallCount;
+
+			node.m_lastUsedTimestamp = crntTimestamp;
+			node.m_drawcallCount = drawcallCount;
+			computeViewport(node, viewport);
+
+			return (valid) ? TileAllocatorResult::CACHED : TileAllocatorResult::ALLOCATION_SUCCEEDED;
+		}
+
+		// The LOD changed, release the old tile
+		freeNode(nodeIdx);
+	}
+
+	const U32 nodeIdx = newNode(level, crntTimestamp);
+	if(nodeIdx == MAX_U32)
+	{
+		return TileAllocatorResult::ALLOCATION_FAILED;
+	}
+
+	Node& node = m_nodes[nodeIdx];
+	node.m_state = NodeState::ALLOCATED;
+	node.m_lightUuid = lightUuid;
+	node.m_lightFace = lightFace;
+	node.m_lastUsedTimestamp = crntTimestamp;
+	node.m_drawcallCount = drawcallCount;
+	m_lightInfoToNodeIdx.emplace(m_alloc, key, nodeIdx);
+
+	computeViewport(node, viewport);
+	return TileAllocatorResult::ALLOCATION_SUCCEEDED;
+}
+
+Bool TileAllocator::allocatePinned(U32 lod, Array<U32, 4>& viewport)
+{
+	ANKI_ASSERT(lod < m_lodCount);
+
+	const U32 nodeIdx = newNode(m_lod0Level + lod, MAX_TIMESTAMP);
+	if(nodeIdx == MAX_U32)
+	{
+		return true;
+	}
+
+	Node& node = m_nodes[nodeIdx];
+	node.m_state = NodeState::ALLOCATED;
+	node.m_pinned = true;
+
+	computeViewport(node, viewport);
+	return false;
+}
+
+void TileAllocator::invalidateCache(U64 lightUuid, U32 lightFace)
+{
+	auto it = m_lightInfoToNodeIdx.find(TileKey{lightUuid, lightFace});
+	if(it != m_lightInfoToNodeIdx.getEnd())
+	{
+		freeNode(*it);
+	}
+}
+
+U32 TileAllocator::selectLod(F32 pixels, U64 lightUuid, U32 lightFace, F32 hysteresis) const
+{
+	ANKI_ASSERT(hysteresis >= 0.0f && hysteresis < 1.0f);
+
+	// Use the smallest tile that has more texels than the pixels. The resolutions are scaled for the hysteresis
+	auto lodFor = [&](F32 scale) -> U32 {
+		U32 lod = 0;
+		while(lod + 1 < m_lodCount && F32(getTileResolution(lod + 1)) * scale >= pixels)
+		{
+			++lod;
+		}
+		return lod;
+	};
+
+	auto it = m_lightInfoToNodeIdx.find(TileKey{lightUuid, lightFace});
+	if(it == m_lightInfoToNodeIdx.getEnd())
+	{
+		return lodFor(1.0f);
+	}
+
+	const U32 prevLod = m_nodes[*it].m_level - m_lod0Level;
+	return max(lodFor(1.0f - hysteresis), min(prevLod, lodFor(1.0f + hysteresis)));
+}
+
+} // end namespace anki
@@ -0,0 +1,155 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/renderer/Common.h>
+
+namespace anki
+{
+
+/// @addtogroup renderer
+/// @{
+
+/// The result of TileAllocator::allocate().
+enum class TileAllocatorResult : U8
+{
+	CACHED, ///< The light face has a tile from a previous frame and its contents are still valid.
+	ALLOCATION_SUCCEEDED, ///< The light face got a tile that needs to be rendered.
+	ALLOCATION_FAILED
+};
+
+/// Allocates square tiles of different resolutions from a square atlas. The atlas is a quadtree so the tiles are
+/// powers of two and they are aligned to their size. The tiles are cached per light face. When the atlas is full it
+/// kicks the tiles that were used the longest time ago.
+class TileAllocator
+{
+public:
+	/// The levels of the quadtree. Every level has 4 times the nodes of the previous one so keep it small.
+	static const U32 MAX_LEVEL_COUNT = 10;
+
+	TileAllocator() = default;
+
+	~TileAllocator();
+
+	/// @param alloc The allocator.
+	/// @param atlasResolution The size of the atlas. Power of two.
+	/// @param maxTileResolution The size of the tiles of LOD 0. Power of two.
+	/// @param lodCount Every LOD has half the resolution of the previous one.
+	void init(HeapAllocator<U8> alloc, U32 atlasResolution, U32 maxTileResolution, U32 lodCount);
+
+	/// Allocate a tile for a light face or find the one it got in a previous frame.
+	/// @param crntTimestamp The current frame. The tiles that are used in the current frame won't be kicked.
+	/// @param lightTimestamp When the light or its shadow casters changed.
+	/// @param lightUuid The light.
+	/// @param lightFace The face of the light.
+	/// @param drawcallCount The shadow casters of the face. If it changes the tile is rendered again.
+	/// @param lod The LOD of the tile.
+	/// @param[out] viewport The tile's viewport in the atlas.
+	TileAllocatorResult allocate(Timestamp crntTimestamp,
+		Timestamp lightTimestamp,
+		U64 lightUuid,
+		U32 lightFace,
+		U32 drawcallCount,
+		U32 lod,
+		Array<U32, 4>& viewport);
+
+	/// Allocate a tile that will never be kicked. If it's the first allocation it's at the origin of the atlas.
+	/// @return True if it failed.
+	Bool allocatePinned(U32 lod, Array<U32, 4>& viewport);
+
+	/// Release the tile of a light face. Use it when the contents of the tile won't be rendered.
+	void invalidateCache(U64 lightUuid, U32 lightFace);
+
+	/// Choose the LOD of the tile of a light face. If the face already has a tile its LOD is kept while the pixels are
+	/// close to the resolutions of the LODs. That way a light that is about the size of a tile doesn't change LOD (and
+	/// get rendered again) every frame.
+	/// @param pixels The pixels that the light covers on the screen.
+	/// @param lightUuid The light.
+	/// @param lightFace The face of the light.
+	/// @param hysteresis The fraction of the tile resolution that the pixels have to cross to change LOD.
+	U32 selectLod(F32 pixels, U64 lightUuid, U32 lightFace, F32 hysteresis) const;
+
+	U32 getTileResolution(U32 lod) const
+	{
+		ANKI_ASSERT(lod < m_lodCount);
+		return m_atlasResolution >> (m_lod0Level + lod);
+	}
+
+private:
+	enum class NodeState : U8
+	{
+		UNUSED, ///< Not part of the tree. Its parent is not split.
+		FREE,
+		ALLOCATED,
+		SPLIT
+	};
+
+	/// A node of the quadtree. The children of node N are the nodes 4N+1 to 4N+4.
+	class Node
+	{
+	public:
+		U64 m_lightUuid = 0;
+		Timestamp m_lastUsedTimestamp = 0;
+		U32 m_drawcallCount = 0;
+		U16 m_x = 0; ///< In tiles of its level.
+		U16 m_y = 0; ///< In tiles of its level.
+		U8 m_level = 0;
+		U8 m_lightFace = 0;
+		NodeState m_state = NodeState::UNUSED;
+		Bool8 m_pinned = false;
+	};
+
+	/// A HashMap key.
+	class TileKey
+	{
+	public:
+		U64 m_lightUuid;
+		U64 m_face;
+
+		U64 computeHash() const
+		{
+			return anki::computeHash(this, sizeof(*this), 693);
+		}
+	};
+
+	HeapAllocator<U8> m_alloc;
+	DynamicArray<Node> m_nodes;
+	HashMap<TileKey, U32> m_lightInfoToNodeIdx;
+	U32 m_atlasResolution = 0;
+	U32 m_lod0Level = 0; ///< The level of the quadtree that has the tiles of LOD 0.
+	U32 m_lodCount = 0;
+
+	/// Find the smallest free node that can hold a tile of some level.
+	U32 findFreeNode(U32 level) const;
+
+	/// Find the node of some level that has the tiles that were used the longest time ago.
+	void findNodeToKick(
+		U32 nodeIdx, U32 level, Timestamp crntTimestamp, U32& nodeToKick, Timestamp& minTimestamp) const;
+
+	/// Get the most recent timestamp of the tiles of a node and its children.
+	/// @return False if some tile can't be kicked.
+	Bool getSubtreeTimestamp(U32 nodeIdx, Timestamp crntTimestamp, Timestamp& timestamp) const;
+
+	/// Free the tiles of a node and its children.
+	void kickSubtree(U32 nodeIdx);
+
+	void freeNode(U32 nodeIdx);
+
+	/// Merge the node with its siblings if they are all free.
+	void mergeUpwards(U32 nodeIdx);
+
+	/// Get a free node of some level. Split or kick nodes if needed.
+	U32 newNode(U32 level, Timestamp crntTimestamp);
+
+	void computeViewport(const Node& node, Array<U32, 4>& viewport) const
+	{
+		const U32 size = m_atlasResolution >> node.m_level;
+		viewport = {{node.m_x * size, node.m_y * size, size, size}};
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -35,9 +35,7 @@ Error Tonemapping::initInternal(const ConfigSet& initializer)
 		UVec2(
 			m_r->getDownscaleBlur().getPassWidth(m_inputTexMip), m_r->getDownscaleBlur().getPassHeight(m_inputTexMip)));
 
-	const ShaderProgramResourceVariant* variant;
-	m_prog->getOrCreateVariant(consts.get(), variant);
-	m_grProg = variant->getProgram();
+	getProgramVariant(m_prog, consts.get(), m_grProg);
 
 	// Create buffer
 	m_luminanceBuff = getGrManager().newBuffer(BufferInitInfo(sizeof(Vec4),
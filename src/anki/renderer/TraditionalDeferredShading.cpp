@@ -31,13 +31,10 @@ Error TraditionalDeferredLightShading::init()
 		ShaderProgramResourceMutationInitList<1> mutators(m_lightProg);
 		mutators.add("LIGHT_TYPE", 0);
 
-		const ShaderProgramResourceVariant* variant;
-		m_lightProg->getOrCreateVariant(mutators.get(), variant);
-		m_plightGrProg = variant->getProgram();
+		getProgramVariant(m_lightProg, mutators.get(), m_plightGrProg);
 
 		mutators[0].m_value = 1;
-		m_lightProg->getOrCreateVariant(mutators.get(), variant);
-		m_slightGrProg = variant->getProgram();
+		getProgramVariant(m_lightProg, mutators.get(), m_slightGrProg);
 	}
 
 	// Init meshes
@@ -55,6 +52,7 @@ void TraditionalDeferredLightShading::bindVertexIndexBuffers(
 	Format fmt;
 	PtrSize relativeOffset;
 	mesh->getVertexAttributeInfo(VertexAttributeLocation::POSITION, bufferBinding, fmt, relativeOffset);
+	ANKI_ASSERT(mesh->getPositionScale() == 1.0f && "The light volumes are drawn without a model transform");
 
 	cmdb->setVertexAttribute(0, 0, fmt, relativeOffset);
 
@@ -33,9 +33,7 @@ Error Volumetric::initMain(const ConfigSet& config)
 				m_r->getLightShading().getLightBin().getClusterer().getClusterCountZ()))
 		.add("NOISE_MAP_SIZE", U32(m_main.m_noiseTex->getWidth()));
 
-	const ShaderProgramResourceVariant* variant;
-	m_main.m_prog->getOrCreateVariant(mutators.get(), consts.get(), variant);
-	m_main.m_grProg = variant->getProgram();
+	getProgramVariant(m_main.m_prog, mutators.get(), consts.get(), m_main.m_grProg);
 
 	return Error::NONE;
 }
@@ -50,9 +48,7 @@ Error Volumetric::initHBlur(const ConfigSet& config)
 	ShaderProgramResourceConstantValueInitList<1> consts(m_hblur.m_prog);
 	consts.add("TEXTURE_SIZE", UVec2(m_width, m_height));
 
-	const ShaderProgramResourceVariant* variant;
-	m_hblur.m_prog->getOrCreateVariant(mutators.get(), consts.get(), variant);
-	m_hblur.m_grProg = variant->getProgram();
+	getProgramVariant(m_hblur.m_prog, mutators.get(), consts.get(), m_hblur.m_grProg);
 
 	return Error::NONE;
 }
@@ -67,9 +63,7 @@ Error Volumetric::initVBlur(const ConfigSet& config)
 	ShaderProgramResourceConstantValueInitList<1> consts(m_vblur.m_prog);
 	consts.add("TEXTURE_SIZE", UVec2(m_width, m_height));
 
-	const ShaderProgramResourceVariant* variant;
-	m_vblur.m_prog->getOrCreateVariant(mutators.get(), consts.get(), variant);
-	m_vblur.m_grProg = variant->getProgram();
+	getProgramVariant(m_vblur.m_prog, mutators.get(), consts.get(), m_vblur.m_grProg);
 
 	return Error::NONE;
 }
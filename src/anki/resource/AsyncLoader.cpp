@@ -5,173 +5,295 @@
 
 #include <anki/resource/AsyncLoader.h>
 #include <anki/util/Logger.h>
+#include <anki/util/HighRezTimer.h>
 #include <anki/core/Trace.h>
 
 namespace anki
 {
 
+class AsyncLoader::WorkerThread
+{
+public:
+	AsyncLoader* m_loader;
+	Thread m_thread;
+	const void* m_runningTaskOwner = nullptr; ///< Protected by AsyncLoader::m_mtx.
+
+	WorkerThread(AsyncLoader* loader)
+		: m_loader(loader)
+		, m_thread("anki_asyload")
+	{
+		m_thread.start(this, threadCallback);
+	}
+
+private:
+	static Error threadCallback(ThreadCallbackInfo& info)
+	{
+		WorkerThread& self = *static_cast<WorkerThread*>(info.m_userData);
+		return self.m_loader->threadWorker(self);
+	}
+};
+
 AsyncLoader::AsyncLoader()
-	: m_thread("anki_asyload")
 {
+	for(Atomic<U32>& count : m_queuedTaskCounts)
+	{
+		count.set(0);
+	}
 }
 
 AsyncLoader::~AsyncLoader()
 {
 	stop();
 
-	if(!m_taskQueue.isEmpty())
+	for(IntrusiveList<AsyncLoaderTask>& queue : m_taskQueues)
 	{
-		ANKI_RESOURCE_LOGW("Stoping loading thread while there is work to do");
-
-		while(!m_taskQueue.isEmpty())
+		if(!queue.isEmpty())
 		{
-			AsyncLoaderTask* task = &m_taskQueue.getFront();
-			m_taskQueue.popFront();
-			m_alloc.deleteInstance(task);
+			ANKI_RESOURCE_LOGW("Stoping loading thread while there is work to do");
+
+			while(!queue.isEmpty())
+			{
+				AsyncLoaderTask* task = &queue.getFront();
+				queue.popFront();
+				m_alloc.deleteInstance(task);
+			}
 		}
 	}
 }
 
-void AsyncLoader::init(const HeapAllocator<U8>& alloc)
+void AsyncLoader::init(const HeapAllocator<U8>& alloc, U32 threadCount)
 {
+	ANKI_ASSERT(threadCount > 0);
 	m_alloc = alloc;
-	m_thread.start(this, threadCallback);
+
+	m_threadCount = threadCount;
+	PtrSize alignment = alignof(WorkerThread);
+	m_threads = reinterpret_cast<WorkerThread*>(m_alloc.allocate(sizeof(WorkerThread) * threadCount, &alignment));
+	for(U32 i = 0; i < threadCount; ++i)
+	{
+		::new(&m_threads[i]) WorkerThread(this);
+	}
 }
 
 void AsyncLoader::stop()
 {
+	if(m_threads == nullptr)
+	{
+		return;
+	}
+
 	{
 		LockGuard<Mutex> lock(m_mtx);
 		m_quit = true;
-		m_condVar.notifyOne();
+		m_condVar.notifyAll();
 	}
 
-	Error err = m_thread.join();
-	(void)err;
+	for(U32 i = 0; i < m_threadCount; ++i)
+	{
+		Error err = m_threads[i].m_thread.join();
+		(void)err;
+		m_threads[i].~WorkerThread();
+	}
+
+	m_alloc.deallocate(static_cast<void*>(m_threads), sizeof(WorkerThread) * m_threadCount);
+	m_threads = nullptr;
 }
 
 void AsyncLoader::pause()
 {
+	LockGuard<Mutex> lock(m_mtx);
+	m_paused = true;
+
+	while(m_runningTaskCount > 0)
 	{
-		LockGuard<Mutex> lock(m_mtx);
-		m_paused = true;
-		m_sync = true;
-		m_condVar.notifyOne();
+		m_idleCondVar.wait(m_mtx);
 	}
-
-	m_barrier.wait();
 }
 
 void AsyncLoader::resume()
 {
 	LockGuard<Mutex> lock(m_mtx);
 	m_paused = false;
-	m_condVar.notifyOne();
+	m_condVar.notifyAll();
 }
 
-Error AsyncLoader::threadCallback(ThreadCallbackInfo& info)
+U32 AsyncLoader::cancelTasks(const void* owner)
 {
-	AsyncLoader& self = *reinterpret_cast<AsyncLoader*>(info.m_userData);
-	return self.threadWorker();
+	ANKI_ASSERT(owner);
+	U32 cancelledCount = 0;
+
+	LockGuard<Mutex> lock(m_mtx);
+	while(true)
+	{
+		for(AsyncLoaderPriority p = AsyncLoaderPriority::FIRST; p < AsyncLoaderPriority::COUNT; ++p)
+		{
+			IntrusiveList<AsyncLoaderTask>& queue = m_taskQueues[p];
+			auto it = queue.getBegin();
+			while(it != queue.getEnd())
+			{
+				AsyncLoaderTask& task = *it;
+				++it;
+
+				if(task.m_owner == owner)
+				{
+					queue.erase(&task);
+					m_queuedTaskCounts[p].fetchSub(1);
+					m_alloc.deleteInstance(&task);
+					++cancelledCount;
+				}
+			}
+		}
+
+		if(!isOwnerRunning(owner))
+		{
+			break;
+		}
+
+		// Wait for the running tasks. They may resubmit themselves so check the queues again after
+		m_idleCondVar.wait(m_mtx);
+	}
+
+	return cancelledCount;
 }
 
-Error AsyncLoader::threadWorker()
+Bool AsyncLoader::isOwnerRunning(const void* owner) const
 {
-	Error err = Error::NONE;
+	for(U32 i = 0; i < m_threadCount; ++i)
+	{
+		if(m_threads[i].m_runningTaskOwner == owner)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
 
-	while(!err)
+void AsyncLoader::pushTask(AsyncLoaderTask* task)
+{
+	task->m_submitTime = HighRezTimer::getCurrentTime();
+	m_taskQueues[task->m_priority].pushBack(task);
+	m_queuedTaskCounts[task->m_priority].fetchAdd(1);
+}
+
+AsyncLoaderTask* AsyncLoader::popTask()
+{
+	for(AsyncLoaderPriority p = AsyncLoaderPriority::FIRST; p < AsyncLoaderPriority::COUNT; ++p)
+	{
+		IntrusiveList<AsyncLoaderTask>& queue = m_taskQueues[p];
+		if(!queue.isEmpty())
+		{
+			AsyncLoaderTask* task = &queue.getFront();
+			queue.popFront();
+			m_queuedTaskCounts[p].fetchSub(1);
+			return task;
+		}
+	}
+
+	return nullptr;
+}
+
+Error AsyncLoader::threadWorker(WorkerThread& thread)
+{
+	while(true)
 	{
 		AsyncLoaderTask* task = nullptr;
-		Bool quit = false;
-		Bool sync = false;
 
 		{
 			// Wait for something
 			LockGuard<Mutex> lock(m_mtx);
-			while((m_taskQueue.isEmpty() || m_paused) && !m_quit && !m_sync)
+			while(!m_quit && (m_paused || (task = popTask()) == nullptr))
 			{
 				m_condVar.wait(m_mtx);
 			}
 
-			// Do some work
 			if(m_quit)
 			{
-				quit = true;
-			}
-			else if(m_sync)
-			{
-				sync = true;
-				m_sync = false;
-			}
-			else
-			{
-				task = &m_taskQueue.getFront();
-				m_taskQueue.popFront();
+				ANKI_ASSERT(task == nullptr);
+				break;
 			}
+
+			++m_runningTaskCount;
+			thread.m_runningTaskOwner = task->m_owner;
 		}
 
-		if(quit)
+		// Trace the time it waited in the queue
+		const U64 latencyUs = U64((HighRezTimer::getCurrentTime() - task->m_submitTime) * 1000000.0);
+		switch(task->m_priority)
 		{
+		case AsyncLoaderPriority::VISIBLE:
+			ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_VISIBLE_TASKS, 1);
+			ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_VISIBLE_LATENCY_US, latencyUs);
 			break;
+		default:
+			ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_BACKGROUND_TASKS, 1);
+			ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_BACKGROUND_LATENCY_US, latencyUs);
 		}
-		else if(sync)
+		(void)latencyUs;
+
+		// Exec the task
+		AsyncLoaderTaskContext ctx;
+		Error err = Error::NONE;
+		{
+			ANKI_TRACE_SCOPED_EVENT(RSRC_ASYNC_TASK);
+			err = (*task)(ctx);
+		}
+
+		if(!err)
 		{
-			m_barrier.wait();
+			m_completedTaskCount.fetchAdd(1);
 		}
 		else
 		{
-			// Exec the task
-			ANKI_ASSERT(task);
-			AsyncLoaderTaskContext ctx;
+			ANKI_RESOURCE_LOGE("Async loader task failed");
+		}
 
-			{
-				ANKI_TRACE_SCOPED_EVENT(RSRC_ASYNC_TASK);
-				err = (*task)(ctx);
-			}
+		// Delete the task before it stops running so it doesn't outlive its owner
+		if(!ctx.m_resubmitTask)
+		{
+			m_alloc.deleteInstance(task);
+		}
 
-			if(!err)
-			{
-				m_completedTaskCount.fetchAdd(1);
-			}
-			else
-			{
-				ANKI_RESOURCE_LOGE("Async loader task failed");
-			}
+		{
+			LockGuard<Mutex> lock(m_mtx);
+			ANKI_ASSERT(m_runningTaskCount > 0);
+			--m_runningTaskCount;
+			thread.m_runningTaskOwner = nullptr;
 
-			// Do other stuff
 			if(ctx.m_resubmitTask)
 			{
-				LockGuard<Mutex> lock(m_mtx);
-				m_taskQueue.pushBack(task);
-			}
-			else
-			{
-				// Delete the task
-				m_alloc.deleteInstance(task);
+				pushTask(task);
 			}
 
 			if(ctx.m_pause)
 			{
-				LockGuard<Mutex> lock(m_mtx);
 				m_paused = true;
 			}
+			else if(ctx.m_resubmitTask)
+			{
+				m_condVar.notifyOne();
+			}
+
+			m_idleCondVar.notifyAll();
 		}
 	}
 
-	return err;
+	return Error::NONE;
 }
 
-void AsyncLoader::submitTask(AsyncLoaderTask* task)
+void AsyncLoader::submitTask(AsyncLoaderTask* task, AsyncLoaderPriority priority)
 {
 	ANKI_ASSERT(task);
+	ANKI_ASSERT(priority < AsyncLoaderPriority::COUNT);
 
 	// Append task to the list
 	LockGuard<Mutex> lock(m_mtx);
-	m_taskQueue.pushBack(task);
+	task->m_priority = priority;
+	pushTask(task);
 
 	if(!m_paused)
 	{
-		// Wake up the thread if it's not paused
+		// Wake up a thread if it's not paused
 		m_condVar.notifyOne();
 	}
 }
@@ -18,6 +18,17 @@ class AsyncLoader;
 /// @addtogroup resource
 /// @{
 
+/// The priority of an AsyncLoaderTask. The tasks of a higher priority run first.
+enum class AsyncLoaderPriority : U8
+{
+	VISIBLE, ///< Needed by something that is visible now.
+	BACKGROUND, ///< Will be needed at some point.
+
+	COUNT,
+	FIRST = 0
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(AsyncLoaderPriority, inline)
+
 class AsyncLoaderTaskContext
 {
 public:
@@ -31,15 +42,29 @@ public:
 /// Interface for tasks for the AsyncLoader.
 class AsyncLoaderTask : public IntrusiveListEnabled<AsyncLoaderTask>
 {
+	friend class AsyncLoader;
+
 public:
 	virtual ~AsyncLoaderTask()
 	{
 	}
 
 	virtual ANKI_USE_RESULT Error operator()(AsyncLoaderTaskContext& ctx) = 0;
+
+	/// Set the object the task works for. See AsyncLoader::cancelTasks().
+	void setOwner(const void* owner)
+	{
+		m_owner = owner;
+	}
+
+private:
+	const void* m_owner = nullptr;
+	Second m_submitTime = 0.0;
+	AsyncLoaderPriority m_priority = AsyncLoaderPriority::VISIBLE;
 };
 
-/// Asynchronous resource loader.
+/// Asynchronous resource loader. It has a number of threads that execute tasks from a queue per priority. The tasks of
+/// the same priority are executed in submission order but if there are many threads they may run at the same time.
 class AsyncLoader
 {
 public:
@@ -47,10 +72,11 @@ public:
 
 	~AsyncLoader();
 
-	void init(const HeapAllocator<U8>& alloc);
+	/// Create the threads.
+	void init(const HeapAllocator<U8>& alloc, U32 threadCount = 1);
 
 	/// Submit a task.
-	void submitTask(AsyncLoaderTask* task);
+	void submitTask(AsyncLoaderTask* task, AsyncLoaderPriority priority = AsyncLoaderPriority::VISIBLE);
 
 	/// Create a new asynchronous loading task.
 	template<typename TTask, typename... TArgs>
@@ -66,7 +92,12 @@ public:
 		submitTask(newTask<TTask>(std::forward<TArgs>(args)...));
 	}
 
-	/// Pause the loader. This method will block the main thread for the current async task to finish. The rest of the
+	/// Delete the queued tasks of an owner and wait for its running tasks to finish. Call it before deleting the owner.
+	/// Don't call it from a task of the same owner.
+	/// @return The number of tasks that were deleted without running.
+	U32 cancelTasks(const void* owner);
+
+	/// Pause the loader. This method will block the main thread for the current async tasks to finish. The rest of the
 	/// tasks in the queue will not be executed until resume is called.
 	void pause();
 
@@ -84,24 +115,45 @@ public:
 		return m_completedTaskCount.load();
 	}
 
+	/// Get the number of tasks that wait in the queue of a priority.
+	U32 getQueuedTaskCount(AsyncLoaderPriority priority) const
+	{
+		return m_queuedTaskCounts[priority].load();
+	}
+
+	U32 getThreadCount() const
+	{
+		return m_threadCount;
+	}
+
 private:
+	class WorkerThread;
+
 	HeapAllocator<U8> m_alloc;
-	Thread m_thread;
-	Barrier m_barrier = {2};
+	WorkerThread* m_threads = nullptr;
+	U32 m_threadCount = 0;
 
 	Mutex m_mtx;
-	ConditionVariable m_condVar;
-	IntrusiveList<AsyncLoaderTask> m_taskQueue;
+	ConditionVariable m_condVar; ///< The threads wait on it for tasks.
+	ConditionVariable m_idleCondVar; ///< Signaled when a task finishes.
+	Array<IntrusiveList<AsyncLoaderTask>, U(AsyncLoaderPriority::COUNT)> m_taskQueues;
+	U32 m_runningTaskCount = 0;
 	Bool8 m_quit = false;
 	Bool8 m_paused = false;
-	Bool8 m_sync = false;
 
 	Atomic<U64> m_completedTaskCount = {0};
+	Array<Atomic<U32>, U(AsyncLoaderPriority::COUNT)> m_queuedTaskCounts;
+
+	Error threadWorker(WorkerThread& thread);
+
+	/// Pop the task of the highest priority. Call it with m_mtx locked.
+	AsyncLoaderTask* popTask();
 
-	/// Thread callback
-	static ANKI_USE_RESULT Error threadCallback(ThreadCallbackInfo& info);
+	/// Push a task at the end of its queue. Call it with m_mtx locked.
+	void pushTask(AsyncLoaderTask* task);
 
-	Error threadWorker();
+	/// Check if a task of an owner is running. Call it with m_mtx locked.
+	Bool isOwnerRunning(const void* owner) const;
 
 	void stop();
 };
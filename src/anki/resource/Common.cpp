@@ -5,6 +5,7 @@
 
 #include <anki/resource/Common.h>
 #include <anki/Resource.h>
+#include <anki/resource/AsyncLoader.h>
 
 namespace anki
 {
@@ -14,6 +15,9 @@ namespace anki
 template<typename T>
 void ResourcePtrDeleter<T>::operator()(T* ptr)
 {
+	// Drop the loading tasks that still reference the resource
+	ptr->getManager().getAsyncLoader().cancelTasks(static_cast<const ResourceObject*>(ptr));
+
 	ptr->getManager().unregisterResource(ptr);
 	auto alloc = ptr->getAllocator();
 	alloc.deleteInstance(ptr);
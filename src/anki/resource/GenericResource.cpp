@@ -18,6 +18,13 @@ GenericResource::~GenericResource()
 	m_data.destroy(getAllocator());
 }
 
+Bool GenericResource::hotReload(GenericResource& newer)
+{
+	m_data.destroy(getAllocator());
+	m_data = std::move(newer.m_data);
+	return true;
+}
+
 Error GenericResource::load(const ResourceFilename& filename, Bool async)
 {
 	ResourceFilePtr file;
@@ -29,6 +29,10 @@ public:
 		return m_data;
 	}
 
+anki_internal:
+	/// Take the data of a newer version of the same file.
+	Bool hotReload(GenericResource& newer);
+
 private:
 	DynamicArray<U8> m_data;
 };
@@ -252,78 +252,75 @@ static PtrSize calcVolumeSize(const U width,
 	return out;
 }
 
-/// Calculate the size of a compressed or uncomressed color data
-static PtrSize calcSizeOfSegment(const AnkiTextureHeader& header, ImageLoader::DataCompression comp)
+/// Get the number of surfaces of every mip. 3D textures have a single volume per mip.
+static U32 getSurfaceCountPerMip(const AnkiTextureHeader& header)
 {
-	PtrSize out = 0;
-	U width = header.m_width;
-	U height = header.m_height;
-	U mips = header.m_mipLevels;
-	ANKI_ASSERT(mips > 0);
-
-	if(header.m_type != ImageLoader::TextureType::_3D)
+	switch(header.m_type)
 	{
-		U surfCountPerMip = 0;
-
-		switch(header.m_type)
-		{
-		case ImageLoader::TextureType::_2D:
-			surfCountPerMip = 1;
-			break;
-		case ImageLoader::TextureType::CUBE:
-			surfCountPerMip = 6;
-			break;
-		case ImageLoader::TextureType::_2D_ARRAY:
-			surfCountPerMip = header.m_depthOrLayerCount;
-			break;
-		default:
-			ANKI_ASSERT(0);
-			break;
-		}
+	case ImageLoader::TextureType::CUBE:
+		return 6;
+	case ImageLoader::TextureType::_2D_ARRAY:
+		return header.m_depthOrLayerCount;
+	default:
+		return 1;
+	}
+}
 
-		while(mips-- != 0)
-		{
-			out += calcSurfaceSize(width, height, comp, header.m_colorFormat) * surfCountPerMip;
+/// Get the size in bytes of all the surfaces or the volume of a mip
+static PtrSize calcMipSize(const AnkiTextureHeader& header, ImageLoader::DataCompression comp, U32 mip)
+{
+	const U width = header.m_width >> mip;
+	const U height = header.m_height >> mip;
 
-			width /= 2;
-			height /= 2;
-		}
+	if(header.m_type == ImageLoader::TextureType::_3D)
+	{
+		return calcVolumeSize(width, height, header.m_depthOrLayerCount >> mip, comp, header.m_colorFormat);
 	}
 	else
 	{
-		U depth = header.m_depthOrLayerCount;
+		return calcSurfaceSize(width, height, comp, header.m_colorFormat) * getSurfaceCountPerMip(header);
+	}
+}
 
-		while(mips-- != 0)
+/// Calculate the size of a range of mips of a compressed or uncomressed color data
+static PtrSize calcSizeOfMips(
+	const AnkiTextureHeader& header, ImageLoader::DataCompression comp, U32 firstMip, U32 mipCount)
+{
+	PtrSize out = 0;
+	for(U32 mip = firstMip; mip < firstMip + mipCount; ++mip)
+	{
+		out += calcMipSize(header, comp, mip);
+	}
+
+	return out;
+}
+
+/// Get the offset of the color data of a compression from the end of the header. The color data of every compression
+/// that the file contains are stored one after the other.
+static PtrSize calcSegmentOffset(const AnkiTextureHeader& header, ImageLoader::DataCompression comp)
+{
+	static const Array<ImageLoader::DataCompression, 3> SEGMENT_ORDER = {
+		{ImageLoader::DataCompression::RAW, ImageLoader::DataCompression::S3TC, ImageLoader::DataCompression::ETC}};
+
+	PtrSize offset = 0;
+	for(ImageLoader::DataCompression segment : SEGMENT_ORDER)
+	{
+		if(segment == comp)
 		{
-			out += calcVolumeSize(width, height, depth, comp, header.m_colorFormat);
+			break;
+		}
 
-			width /= 2;
-			height /= 2;
-			depth /= 2;
+		if((header.m_compressionFormats & segment) != ImageLoader::DataCompression::NONE)
+		{
+			offset += calcSizeOfMips(header, segment, 0, header.m_mipLevels);
 		}
 	}
 
-	return out;
+	return offset;
 }
 
-static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
-	U32 maxTextureSize,
-	ImageLoader::DataCompression& preferredCompression,
-	DynamicArray<ImageLoader::Surface>& surfaces,
-	DynamicArray<ImageLoader::Volume>& volumes,
-	GenericMemoryPoolAllocator<U8>& alloc,
-	U32& width,
-	U32& height,
-	U32& depth,
-	U32& layerCount,
-	U8& toLoadMipCount,
-	ImageLoader::TextureType& textureType,
-	ImageLoader::ColorFormat& colorFormat)
+Error ImageLoader::loadAnkiTextureHeader(ResourceFilePtr file, U32 maxTextureSize, AnkiTextureHeader& header)
 {
-	//
-	// Read and check the header
-	//
-	AnkiTextureHeader header;
 	ANKI_CHECK(file->read(&header, sizeof(AnkiTextureHeader)));
 
 	if(std::memcmp(&header.m_magic[0], "ANKITEX1", 8) != 0)
@@ -357,14 +354,14 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 		return Error::USER_DATA;
 	}
 
-	if((header.m_compressionFormats & preferredCompression) == ImageLoader::DataCompression::NONE)
+	if((header.m_compressionFormats & m_compression) == ImageLoader::DataCompression::NONE)
 	{
 		ANKI_RESOURCE_LOGW("File does not contain the requested compression");
 
 		// Fallback
-		preferredCompression = ImageLoader::DataCompression::RAW;
+		m_compression = ImageLoader::DataCompression::RAW;
 
-		if((header.m_compressionFormats & preferredCompression) == ImageLoader::DataCompression::NONE)
+		if((header.m_compressionFormats & m_compression) == ImageLoader::DataCompression::NONE)
 		{
 			ANKI_RESOURCE_LOGE("File does not contain raw compression");
 			return Error::USER_DATA;
@@ -377,9 +374,6 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 		return Error::USER_DATA;
 	}
 
-	width = header.m_width;
-	height = header.m_height;
-
 	// Check mip levels
 	U size = min(header.m_width, header.m_height);
 	U maxSize = max(header.m_width, header.m_height);
@@ -388,174 +382,143 @@ static ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file,
 		maxSize = max<U>(maxSize, header.m_depthOrLayerCount);
 		size = min<U>(size, header.m_depthOrLayerCount);
 	}
-	toLoadMipCount = 0;
 	U tmpMipLevels = 0;
 	while(size >= 4) // The minimum size is 4x4
 	{
 		++tmpMipLevels;
-
-		if(maxSize <= maxTextureSize)
-		{
-			++toLoadMipCount;
-		}
-
 		size /= 2;
-		maxSize /= 2;
 	}
 
-	if(header.m_mipLevels > tmpMipLevels)
+	if(header.m_mipLevels == 0 || header.m_mipLevels > tmpMipLevels)
 	{
 		ANKI_RESOURCE_LOGE("Incorrect number of mip levels");
 		return Error::USER_DATA;
 	}
 
-	toLoadMipCount = min<U>(toLoadMipCount, header.m_mipLevels);
+	// Skip the mips that are bigger than the max texture size but always load the last one
+	U32 firstMip = 0;
+	while(firstMip + 1u < header.m_mipLevels && (maxSize >> firstMip) > maxTextureSize)
+	{
+		++firstMip;
+	}
 
-	colorFormat = header.m_colorFormat;
+	m_firstMipLevel = U8(firstMip);
+	m_mipLevels = U8(header.m_mipLevels - firstMip);
+	m_width = header.m_width >> firstMip;
+	m_height = header.m_height >> firstMip;
+	m_colorFormat = header.m_colorFormat;
+	m_textureType = header.m_type;
 
-	U faceCount = 1;
 	switch(header.m_type)
 	{
-	case ImageLoader::TextureType::_2D:
-		depth = 1;
-		layerCount = 1;
-		break;
-	case ImageLoader::TextureType::CUBE:
-		depth = 1;
-		layerCount = 1;
-		faceCount = 6;
-		break;
 	case ImageLoader::TextureType::_3D:
-		depth = header.m_depthOrLayerCount;
-		layerCount = 1;
+		m_depth = header.m_depthOrLayerCount >> firstMip;
+		m_layerCount = 1;
 		break;
 	case ImageLoader::TextureType::_2D_ARRAY:
-		depth = 1;
-		layerCount = header.m_depthOrLayerCount;
+		m_depth = 1;
+		m_layerCount = header.m_depthOrLayerCount;
 		break;
 	default:
-		ANKI_ASSERT(0);
+		m_depth = 1;
+		m_layerCount = 1;
 	}
 
-	textureType = header.m_type;
+	return Error::NONE;
+}
 
-	//
-	// Move file pointer
-	//
+Error ImageLoader::loadAnkiTexture(ResourceFilePtr file, U32 maxTextureSize)
+{
+	AnkiTextureHeader header;
+	ANKI_CHECK(loadAnkiTextureHeader(file, maxTextureSize, header));
 
-	if(preferredCompression == ImageLoader::DataCompression::RAW)
+	// Go straight to the first mip that is needed. The file is right after the header
+	const PtrSize offset =
+		calcSegmentOffset(header, m_compression) + calcSizeOfMips(header, m_compression, 0, m_firstMipLevel);
+	if(offset)
 	{
-		// Do nothing
+		ANKI_CHECK(file->seek(offset, ResourceFile::SeekOrigin::CURRENT));
 	}
-	else if(preferredCompression == ImageLoader::DataCompression::S3TC)
+
+	// The mips are contiguous in the file so read them at once
+	const PtrSize size = calcSizeOfMips(header, m_compression, m_firstMipLevel, m_mipLevels);
+	ConstWeakArray<U8> data;
+	if(file->isMemoryMapped())
 	{
-		if((header.m_compressionFormats & ImageLoader::DataCompression::RAW) != ImageLoader::DataCompression::NONE)
-		{
-			// If raw compression is present then skip it
-			ANKI_CHECK(file->seek(
-				calcSizeOfSegment(header, ImageLoader::DataCompression::RAW), ResourceFile::SeekOrigin::CURRENT));
-		}
+		ANKI_CHECK(file->getMappedSpan(size, data));
+		m_mappedFile = file;
 	}
-	else if(preferredCompression == ImageLoader::DataCompression::ETC)
+	else
 	{
-		if((header.m_compressionFormats & ImageLoader::DataCompression::RAW) != ImageLoader::DataCompression::NONE)
-		{
-			// If raw compression is present then skip it
-			ANKI_CHECK(file->seek(
-				calcSizeOfSegment(header, ImageLoader::DataCompression::RAW), ResourceFile::SeekOrigin::CURRENT));
-		}
-
-		if((header.m_compressionFormats & ImageLoader::DataCompression::S3TC) != ImageLoader::DataCompression::NONE)
-		{
-			// If s3tc compression is present then skip it
-			ANKI_CHECK(file->seek(
-				calcSizeOfSegment(header, ImageLoader::DataCompression::S3TC), ResourceFile::SeekOrigin::CURRENT));
-		}
+		m_data.create(m_alloc, size);
+		ANKI_CHECK(file->read(&m_data[0], size));
+		data = ConstWeakArray<U8>(m_data);
 	}
 
-	//
-	// It's time to read
-	//
-
-	// Allocate the surfaces
-	if(header.m_type != ImageLoader::TextureType::_3D)
+	// Point the surfaces or the volumes to the data
+	PtrSize dataOffset = 0;
+	if(m_textureType != TextureType::_3D)
 	{
-		surfaces.create(alloc, toLoadMipCount * layerCount * faceCount);
+		const U32 surfCountPerMip = getSurfaceCountPerMip(header);
+		m_surfaces.create(m_alloc, m_mipLevels * surfCountPerMip);
 
-		// Read all surfaces
-		U mipWidth = header.m_width;
-		U mipHeight = header.m_height;
-		U index = 0;
-		for(U mip = 0; mip < header.m_mipLevels; mip++)
+		for(U32 mip = 0; mip < m_mipLevels; ++mip)
 		{
-			for(U l = 0; l < layerCount; l++)
-			{
+			const U32 width = m_width >> mip;
+			const U32 height = m_height >> mip;
+			const PtrSize surfSize = calcSurfaceSize(width, height, m_compression, m_colorFormat);
 
-				for(U f = 0; f < faceCount; ++f)
-				{
-					U dataSize = calcSurfaceSize(mipWidth, mipHeight, preferredCompression, header.m_colorFormat);
-
-					// Check if this mipmap can be skipped because of size
-					if(maxSize <= maxTextureSize)
-					{
-						ImageLoader::Surface& surf = surfaces[index++];
-						surf.m_width = mipWidth;
-						surf.m_height = mipHeight;
-
-						surf.m_data.create(alloc, dataSize);
-
-						ANKI_CHECK(file->read(&surf.m_data[0], dataSize));
-					}
-					else
-					{
-						ANKI_CHECK(file->seek(dataSize, ResourceFile::SeekOrigin::CURRENT));
-					}
-				}
+			for(U32 i = 0; i < surfCountPerMip; ++i)
+			{
+				Surface& surf = m_surfaces[mip * surfCountPerMip + i];
+				surf.m_width = width;
+				surf.m_height = height;
+				surf.m_mipLevel = mip;
+				surf.m_data = ConstWeakArray<U8>(&data[dataOffset], surfSize);
+				dataOffset += surfSize;
 			}
-
-			mipWidth /= 2;
-			mipHeight /= 2;
 		}
 	}
 	else
 	{
-		volumes.create(alloc, toLoadMipCount);
+		m_volumes.create(m_alloc, m_mipLevels);
 
-		U mipWidth = header.m_width;
-		U mipHeight = header.m_height;
-		U mipDepth = header.m_depthOrLayerCount;
-		for(U mip = 0; mip < header.m_mipLevels; mip++)
+		for(U32 mip = 0; mip < m_mipLevels; ++mip)
 		{
-			U dataSize = calcVolumeSize(mipWidth, mipHeight, mipDepth, preferredCompression, header.m_colorFormat);
-
-			// Check if this mipmap can be skipped because of size
-			if(maxSize <= maxTextureSize)
-			{
-				ImageLoader::Volume& vol = volumes[mip];
-				vol.m_width = mipWidth;
-				vol.m_height = mipHeight;
-				vol.m_depth = mipDepth;
-
-				vol.m_data.create(alloc, dataSize);
-
-				ANKI_CHECK(file->read(&vol.m_data[0], dataSize));
-			}
-			else
-			{
-				ANKI_CHECK(file->seek(dataSize, ResourceFile::SeekOrigin::CURRENT));
-			}
-
-			mipWidth /= 2;
-			mipHeight /= 2;
-			mipDepth /= 2;
+			Volume& vol = m_volumes[mip];
+			vol.m_width = m_width >> mip;
+			vol.m_height = m_height >> mip;
+			vol.m_depth = m_depth >> mip;
+			vol.m_mipLevel = mip;
+
+			const PtrSize volSize =
+				calcVolumeSize(vol.m_width, vol.m_height, vol.m_depth, m_compression, m_colorFormat);
+			vol.m_data = ConstWeakArray<U8>(&data[dataOffset], volSize);
+			dataOffset += volSize;
 		}
 	}
 
+	ANKI_ASSERT(dataOffset == size);
 	return Error::NONE;
 }
 
+/// Get the compression that the GPU of the platform prefers.
+static ImageLoader::DataCompression getPreferredCompression()
+{
+#if 0
+	return ImageLoader::DataCompression::RAW;
+#elif ANKI_GL == ANKI_GL_DESKTOP
+	return ImageLoader::DataCompression::S3TC;
+#else
+	return ImageLoader::DataCompression::ETC;
+#endif
+}
+
 Error ImageLoader::load(ResourceFilePtr file, const CString& filename, U32 maxTextureSize)
 {
+	// Forget a previous load
+	destroy();
+
 	// get the extension
 	StringAuto ext(m_alloc);
 	getFilepathExtension(filename, m_alloc, ext);
@@ -576,9 +539,12 @@ Error ImageLoader::load(ResourceFilePtr file, const CString& filename, U32 maxTe
 		m_surfaces.create(m_alloc, 1);
 
 		m_mipLevels = 1;
+		m_firstMipLevel = 0;
 		m_depth = 1;
 		m_layerCount = 1;
-		ANKI_CHECK(loadTga(file, m_surfaces[0].m_width, m_surfaces[0].m_height, bpp, m_surfaces[0].m_data, m_alloc));
+		ANKI_CHECK(loadTga(file, m_surfaces[0].m_width, m_surfaces[0].m_height, bpp, m_data, m_alloc));
+		m_surfaces[0].m_mipLevel = 0;
+		m_surfaces[0].m_data = ConstWeakArray<U8>(m_data);
 
 		m_width = m_surfaces[0].m_width;
 		m_height = m_surfaces[0].m_height;
@@ -598,27 +564,8 @@ Error ImageLoader::load(ResourceFilePtr file, const CString& filename, U32 maxTe
 	}
 	else if(ext == "ankitex")
 	{
-#if 0
-		compression = ImageLoader::DataCompression::RAW;
-#elif ANKI_GL == ANKI_GL_DESKTOP
-		m_compression = ImageLoader::DataCompression::S3TC;
-#else
-		m_compression = ImageLoader::DataCompression::ETC;
-#endif
-
-		ANKI_CHECK(loadAnkiTexture(file,
-			maxTextureSize,
-			m_compression,
-			m_surfaces,
-			m_volumes,
-			m_alloc,
-			m_width,
-			m_height,
-			m_depth,
-			m_layerCount,
-			m_mipLevels,
-			m_textureType,
-			m_colorFormat));
+		m_compression = getPreferredCompression();
+		ANKI_CHECK(loadAnkiTexture(file, maxTextureSize));
 	}
 	else
 	{
@@ -629,6 +576,26 @@ Error ImageLoader::load(ResourceFilePtr file, const CString& filename, U32 maxTe
 	return Error::NONE;
 }
 
+Error ImageLoader::loadHeader(ResourceFilePtr file, const CString& filename, U32 maxTextureSize)
+{
+	destroy();
+
+	StringAuto ext(m_alloc);
+	getFilepathExtension(filename, m_alloc, ext);
+
+	if(ext.isEmpty() || ext != "ankitex")
+	{
+		ANKI_RESOURCE_LOGE("Only the header of AnKi textures can be loaded: %s", filename.get());
+		return Error::USER_DATA;
+	}
+
+	m_compression = getPreferredCompression();
+	AnkiTextureHeader header;
+	ANKI_CHECK(loadAnkiTextureHeader(file, maxTextureSize, header));
+
+	return Error::NONE;
+}
+
 const ImageLoader::Surface& ImageLoader::getSurface(U level, U face, U layer) const
 {
 	ANKI_ASSERT(level < m_mipLevels);
@@ -665,19 +632,10 @@ const ImageLoader::Volume& ImageLoader::getVolume(U level) const
 
 void ImageLoader::destroy()
 {
-	for(Surface& surf : m_surfaces)
-	{
-		surf.m_data.destroy(m_alloc);
-	}
-
 	m_surfaces.destroy(m_alloc);
-
-	for(Volume& v : m_volumes)
-	{
-		v.m_data.destroy(m_alloc);
-	}
-
 	m_volumes.destroy(m_alloc);
+	m_data.destroy(m_alloc);
+	m_mappedFile.reset(nullptr);
 }
 
 } // end namespace anki
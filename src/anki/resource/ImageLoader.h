@@ -13,6 +13,9 @@
 namespace anki
 {
 
+// Forward
+class AnkiTextureHeader;
+
 /// Image loader.
 class ImageLoader
 {
@@ -53,7 +56,13 @@ public:
 		U32 m_width;
 		U32 m_height;
 		U32 m_mipLevel;
-		DynamicArray<U8> m_data;
+		ConstWeakArray<U8> m_data; ///< Points to the memory of the loader or to the file's if it's memory mapped.
+
+		/// Get the pixels.
+		ConstWeakArray<U8> getData() const
+		{
+			return m_data;
+		}
 	};
 
 	class Volume
@@ -63,7 +72,13 @@ public:
 		U32 m_height;
 		U32 m_depth;
 		U32 m_mipLevel;
-		DynamicArray<U8> m_data;
+		ConstWeakArray<U8> m_data; ///< Points to the memory of the loader or to the file's if it's memory mapped.
+
+		/// Get the texels.
+		ConstWeakArray<U8> getData() const
+		{
+			return m_data;
+		}
 	};
 
 	ImageLoader(GenericMemoryPoolAllocator<U8> alloc)
@@ -94,6 +109,13 @@ public:
 		return m_mipLevels;
 	}
 
+	/// Get the mip of the file that is the first loaded mip. The mips before it were bigger than the max texture size.
+	U getFirstMipLevel() const
+	{
+		return m_firstMipLevel;
+	}
+
+	/// Get the width of the first loaded mip.
 	U getWidth() const
 	{
 		return m_width;
@@ -132,8 +154,13 @@ public:
 	}
 
 	/// Load an image file.
+	/// @param maxTextureSize The mips of AnKi textures that are bigger than that are skipped.
 	ANKI_USE_RESULT Error load(ResourceFilePtr file, const CString& filename, U32 maxTextureSize = MAX_U32);
 
+	/// Read only the header of an AnKi texture. The getters work as if load() was called but there are no surfaces or
+	/// volumes.
+	ANKI_USE_RESULT Error loadHeader(ResourceFilePtr file, const CString& filename, U32 maxTextureSize = MAX_U32);
+
 	Atomic<I32>& getRefcount()
 	{
 		return m_refcount;
@@ -143,6 +170,9 @@ private:
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Atomic<I32> m_refcount = {0};
 
+	ResourceFilePtr m_mappedFile; ///< Keep the file alive if the surfaces point to its memory.
+	DynamicArray<U8> m_data; ///< The data of all the surfaces or volumes if the file is not memory mapped.
+
 	/// [mip][depth or face or layer]. Loader doesn't support cube arrays ATM so face and layer won't be used at the
 	/// same time.
 	DynamicArray<Surface> m_surfaces;
@@ -150,6 +180,7 @@ private:
 	DynamicArray<Volume> m_volumes;
 
 	U8 m_mipLevels = 0;
+	U8 m_firstMipLevel = 0;
 	U32 m_width = 0;
 	U32 m_height = 0;
 	U32 m_depth = 0;
@@ -159,6 +190,10 @@ private:
 	TextureType m_textureType = TextureType::NONE;
 
 	void destroy();
+
+	ANKI_USE_RESULT Error loadAnkiTextureHeader(ResourceFilePtr file, U32 maxTextureSize, AnkiTextureHeader& header);
+
+	ANKI_USE_RESULT Error loadAnkiTexture(ResourceFilePtr file, U32 maxTextureSize);
 };
 
 } // end namespace anki
@@ -562,6 +562,24 @@ const MaterialVariant& MaterialResource::getOrCreateVariant(const RenderingKey&
 	return variant;
 }
 
+void MaterialResource::invalidateVariants() const
+{
+	LockGuard<SpinLock> lock(m_variantMatrixMtx);
+	for(auto& a : m_variantMatrix)
+	{
+		for(auto& b : a)
+		{
+			for(auto& c : b)
+			{
+				for(MaterialVariant& variant : c)
+				{
+					variant.m_variant = nullptr;
+				}
+			}
+		}
+	}
+}
+
 U MaterialResource::getInstanceGroupIdx(U instanceCount)
 {
 	ANKI_ASSERT(instanceCount > 0);
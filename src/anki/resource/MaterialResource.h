@@ -253,6 +253,10 @@ public:
 		return m_descriptorSetIdx;
 	}
 
+anki_internal:
+	/// Forget the variants. The hot reload calls it when the source of the program changes.
+	void invalidateVariants() const;
+
 private:
 	ShaderProgramResourcePtr m_prog;
 
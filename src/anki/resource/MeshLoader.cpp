@@ -18,6 +18,7 @@ MeshLoader::MeshLoader(ResourceManager* manager)
 MeshLoader::~MeshLoader()
 {
 	m_subMeshes.destroy(m_alloc);
+	m_meshlets.destroy(m_alloc);
 }
 
 Error MeshLoader::load(const ResourceFilename& filename)
@@ -39,7 +40,7 @@ Error MeshLoader::load(const ResourceFilename& filename)
 		U idxSum = 0;
 		for(U i = 0; i < m_subMeshes.getSize(); i++)
 		{
-			const MeshBinaryFile::SubMesh& sm = m_subMeshes[0];
+			const MeshBinaryFile::SubMesh& sm = m_subMeshes[i];
 			if(sm.m_firstIndex != idxSum || (sm.m_indexCount % indicesPerFace) != 0)
 			{
 				ANKI_RESOURCE_LOGE("Incorrect sub mesh info");
@@ -48,7 +49,7 @@ Error MeshLoader::load(const ResourceFilename& filename)
 
 			for(U d = 0; d < 3; ++d)
 			{
-				if(sm.m_aabbMin[i] >= sm.m_aabbMax[i])
+				if(sm.m_aabbMin[d] >= sm.m_aabbMax[d])
 				{
 					ANKI_RESOURCE_LOGE("Wrong bounding box");
 					return Error::USER_DATA;
@@ -65,6 +66,12 @@ Error MeshLoader::load(const ResourceFilename& filename)
 		}
 	}
 
+	// Read meshlets
+	if(!!(m_header.m_flags & MeshBinaryFile::Flag::MESHLETS))
+	{
+		ANKI_CHECK(loadMeshlets());
+	}
+
 	// Read vert buffer info
 	{
 		U32 vertBufferMask = 0;
@@ -98,6 +105,10 @@ Error MeshLoader::load(const ResourceFilename& filename)
 		U32 totalSize = sizeof(m_header);
 
 		totalSize += sizeof(MeshBinaryFile::SubMesh) * m_header.m_subMeshCount;
+		if(!!(m_header.m_flags & MeshBinaryFile::Flag::MESHLETS))
+		{
+			totalSize += sizeof(U32) + sizeof(MeshBinaryFile::Meshlet) * m_meshlets.getSize();
+		}
 		totalSize += getIndexBufferSize();
 
 		for(U i = 0; i < m_header.m_vertexBufferCount; ++i)
@@ -115,6 +126,66 @@ Error MeshLoader::load(const ResourceFilename& filename)
 	return Error::NONE;
 }
 
+Error MeshLoader::loadMeshlets()
+{
+	if(!!(m_header.m_flags & MeshBinaryFile::Flag::QUAD))
+	{
+		ANKI_RESOURCE_LOGE("Meshlets are supported only for triangles");
+		return Error::USER_DATA;
+	}
+
+	U32 meshletCount;
+	ANKI_CHECK(m_file->read(&meshletCount, sizeof(meshletCount)));
+	if(meshletCount == 0 || meshletCount > m_header.m_totalIndexCount / 3)
+	{
+		ANKI_RESOURCE_LOGE("Wrong meshlet count");
+		return Error::USER_DATA;
+	}
+
+	m_meshlets.create(m_alloc, meshletCount);
+	ANKI_CHECK(m_file->read(&m_meshlets[0], m_meshlets.getSizeInBytes()));
+
+	// The meshlets should cover the sub meshes in order without crossing their boundaries
+	U32 subMeshIdx = 0;
+	U32 idxSum = 0;
+	for(const MeshBinaryFile::Meshlet& meshlet : m_meshlets)
+	{
+		while(subMeshIdx < m_subMeshes.getSize()
+			  && idxSum == m_subMeshes[subMeshIdx].m_firstIndex + m_subMeshes[subMeshIdx].m_indexCount)
+		{
+			++subMeshIdx;
+		}
+
+		if(subMeshIdx >= m_subMeshes.getSize() || meshlet.m_firstIndex != idxSum || meshlet.m_indexCount == 0
+			|| (meshlet.m_indexCount % 3) != 0
+			|| idxSum + meshlet.m_indexCount
+				   > m_subMeshes[subMeshIdx].m_firstIndex + m_subMeshes[subMeshIdx].m_indexCount)
+		{
+			ANKI_RESOURCE_LOGE("Incorrect meshlet info");
+			return Error::USER_DATA;
+		}
+
+		for(U d = 0; d < 3; ++d)
+		{
+			if(meshlet.m_aabbMin[d] > meshlet.m_aabbMax[d])
+			{
+				ANKI_RESOURCE_LOGE("Wrong meshlet bounding box");
+				return Error::USER_DATA;
+			}
+		}
+
+		idxSum += meshlet.m_indexCount;
+	}
+
+	if(idxSum != m_header.m_totalIndexCount)
+	{
+		ANKI_RESOURCE_LOGE("Incorrect meshlet info");
+		return Error::USER_DATA;
+	}
+
+	return Error::NONE;
+}
+
 Error MeshLoader::checkFormat(VertexAttributeLocation type, ConstWeakArray<Format> supportedFormats) const
 {
 	const MeshBinaryFile::VertexAttribute& attrib = m_header.m_vertexAttributes[type];
@@ -143,8 +214,16 @@ Error MeshLoader::checkFormat(VertexAttributeLocation type, ConstWeakArray<Forma
 		return Error::NONE;
 	}
 
-	// Scale should be 1.0 for now
-	if(attrib.m_scale != 1.0f)
+	// Only the normalized positions are scaled. The scale is applied with the transform of the model and that doesn't
+	// work with skinning
+	const Bool scaled = type == VertexAttributeLocation::POSITION && attrib.m_format == Format::R16G16B16A16_SNORM
+						&& !hasBoneInfo();
+	if(scaled && !(attrib.m_scale > 0.0f))
+	{
+		ANKI_RESOURCE_LOGE("Vertex attribute %u should have a positive scale", U(type));
+		return Error::USER_DATA;
+	}
+	else if(!scaled && attrib.m_scale != 1.0f)
 	{
 		ANKI_RESOURCE_LOGE("Vertex attribute %u should have 1.0 scale", U(type));
 		return Error::USER_DATA;
@@ -172,8 +251,8 @@ Error MeshLoader::checkHeader() const
 	}
 
 	// Attributes
-	ANKI_CHECK(checkFormat(
-		VertexAttributeLocation::POSITION, Array<Format, 2>{{Format::R16G16B16A16_SFLOAT, Format::R32G32B32_SFLOAT}}));
+	ANKI_CHECK(checkFormat(VertexAttributeLocation::POSITION,
+		Array<Format, 3>{{Format::R16G16B16A16_SFLOAT, Format::R32G32B32_SFLOAT, Format::R16G16B16A16_SNORM}}));
 	ANKI_CHECK(checkFormat(VertexAttributeLocation::NORMAL, Array<Format, 1>{{Format::A2B10G10R10_SNORM_PACK32}}));
 	ANKI_CHECK(checkFormat(VertexAttributeLocation::TANGENT, Array<Format, 1>{{Format::A2B10G10R10_SNORM_PACK32}}));
 	ANKI_CHECK(
@@ -264,30 +343,48 @@ Error MeshLoader::storeVertexBuffer(U32 bufferIdx, void* ptr, PtrSize size)
 	return Error::NONE;
 }
 
+Error MeshLoader::loadChunk(PtrSize size, DynamicArrayAuto<U8>& staging, ConstWeakArray<U8>& chunk)
+{
+	if(m_file->isMemoryMapped())
+	{
+		ANKI_CHECK(m_file->getMappedSpan(size, chunk));
+	}
+	else
+	{
+		staging.create(size);
+		ANKI_CHECK(m_file->read(&staging[0], size));
+		chunk = ConstWeakArray<U8>(staging);
+	}
+
+	++m_loadedChunk;
+	return Error::NONE;
+}
+
 Error MeshLoader::storeIndicesAndPosition(DynamicArrayAuto<U32>& indices, DynamicArrayAuto<Vec3>& positions)
 {
 	// Store indices
 	{
 		indices.resize(m_header.m_totalIndexCount);
 
-		// Create staging buff
-		const PtrSize idxBufferSize = getIndexBufferSize();
+		ANKI_ASSERT(m_loadedChunk == 0);
 		DynamicArrayAuto<U8> staging(m_alloc);
-		staging.create(idxBufferSize);
-
-		// Store to staging buff
-		ANKI_CHECK(storeIndexBuffer(&staging[0], staging.getSizeInBytes()));
+		ConstWeakArray<U8> chunk;
+		ANKI_CHECK(loadChunk(getIndexBufferSize(), staging, chunk));
 
 		// Copy
 		for(U i = 0; i < m_header.m_totalIndexCount; ++i)
 		{
 			if(m_header.m_indexType == IndexType::U32)
 			{
-				indices[i] = *reinterpret_cast<U32*>(&staging[i * 4]);
+				U32 idx;
+				memcpy(&idx, chunk.getBegin() + i * 4, sizeof(idx));
+				indices[i] = idx;
 			}
 			else
 			{
-				indices[i] = *reinterpret_cast<U16*>(&staging[i * 2]);
+				U16 idx;
+				memcpy(&idx, chunk.getBegin() + i * 2, sizeof(idx));
+				indices[i] = idx;
 			}
 		}
 	}
@@ -299,30 +396,39 @@ Error MeshLoader::storeIndicesAndPosition(DynamicArrayAuto<U32>& indices, Dynami
 		const MeshBinaryFile::VertexAttribute& attrib = m_header.m_vertexAttributes[VertexAttributeLocation::POSITION];
 		const MeshBinaryFile::VertexBuffer& buffInfo = m_header.m_vertexBuffers[attrib.m_bufferBinding];
 
-		// Create staging buff
-		const PtrSize vertBuffSize = m_header.m_totalVertexCount * buffInfo.m_vertexStride;
+		ANKI_ASSERT(m_loadedChunk == attrib.m_bufferBinding + 1);
 		DynamicArrayAuto<U8> staging(m_alloc);
-		staging.create(vertBuffSize);
-
-		// Store to staging buff
-		ANKI_CHECK(storeVertexBuffer(attrib.m_bufferBinding, &staging[0], staging.getSizeInBytes()));
+		ConstWeakArray<U8> chunk;
+		ANKI_CHECK(loadChunk(m_header.m_totalVertexCount * buffInfo.m_vertexStride, staging, chunk));
 
 		// Copy
 		for(U i = 0; i < m_header.m_totalVertexCount; ++i)
 		{
+			const U8* src = chunk.getBegin() + i * buffInfo.m_vertexStride + attrib.m_relativeOffset;
 			Vec3 vert(0.0f);
 			if(attrib.m_format == Format::R32G32B32_SFLOAT)
 			{
-				vert = *reinterpret_cast<Vec3*>(&staging[i * buffInfo.m_vertexStride + attrib.m_relativeOffset]);
+				memcpy(&vert[0], src, sizeof(F32) * 3);
 			}
 			else if(attrib.m_format == Format::R16G16B16A16_SFLOAT)
 			{
-				F16* f16 = reinterpret_cast<F16*>(&staging[i * buffInfo.m_vertexStride + attrib.m_relativeOffset]);
+				Array<F16, 3> f16;
+				memcpy(&f16[0], src, sizeof(f16));
 
 				vert[0] = f16[0].toF32();
 				vert[1] = f16[1].toF32();
 				vert[2] = f16[2].toF32();
 			}
+			else if(attrib.m_format == Format::R16G16B16A16_SNORM)
+			{
+				Array<I16, 3> snorm;
+				memcpy(&snorm[0], src, sizeof(snorm));
+
+				for(U d = 0; d < 3; ++d)
+				{
+					vert[d] = max(F32(snorm[d]) / F32(MAX_I16), -1.0f) * attrib.m_scale;
+				}
+			}
 			else
 			{
 				ANKI_ASSERT(0);
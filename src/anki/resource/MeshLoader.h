@@ -27,8 +27,9 @@ public:
 	{
 		NONE = 0,
 		QUAD = 1 << 0,
+		MESHLETS = 1 << 1, ///< The sub meshes are followed by the meshlets.
 
-		ALL = QUAD,
+		ALL = QUAD | MESHLETS,
 	};
 	ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(Flag, friend)
 
@@ -53,6 +54,21 @@ public:
 		Vec3 m_aabbMax; ///< Bounding box max.
 	};
 
+	/// A small range of the triangles of a sub mesh. If the file has meshlets the sub meshes are followed by a U32 with
+	/// the meshlet count and then the meshlets. The meshlets of every sub mesh cover all of its indices in order.
+	struct Meshlet
+	{
+		U32 m_firstIndex;
+		U32 m_indexCount;
+		U32 m_vertexCount; ///< The unique vertices it uses.
+		Vec3 m_aabbMin; ///< Bounding box min.
+		Vec3 m_aabbMax; ///< Bounding box max.
+		Vec3 m_coneAxis; ///< The average normal of the triangles.
+		/// The cosine of the angle between m_coneAxis and the normal that is the furthest from it. If it's not positive
+		/// the normals don't fit in a cone that can be used for back face culling.
+		F32 m_coneCutoff;
+	};
+
 	struct Header
 	{
 		char m_magic[8]; ///< Magic word.
@@ -115,6 +131,12 @@ public:
 		return ConstWeakArray<MeshBinaryFile::SubMesh>(m_subMeshes);
 	}
 
+	/// Get the meshlets. It's empty if the file doesn't have them.
+	ConstWeakArray<MeshBinaryFile::Meshlet> getMeshlets() const
+	{
+		return ConstWeakArray<MeshBinaryFile::Meshlet>(m_meshlets);
+	}
+
 private:
 	ResourceManager* m_manager;
 	GenericMemoryPoolAllocator<U8> m_alloc;
@@ -124,6 +146,7 @@ private:
 	MeshBinaryFile::Header m_header;
 
 	DynamicArray<MeshBinaryFile::SubMesh> m_subMeshes;
+	DynamicArray<MeshBinaryFile::Meshlet> m_meshlets;
 
 	U32 m_loadedChunk = 0; ///< Because the store methods need to be called in sequence.
 
@@ -138,7 +161,12 @@ private:
 	}
 
 	ANKI_USE_RESULT Error checkHeader() const;
+
+	/// Load the next chunk of the file. If the file is memory mapped the chunk points to its memory, else the chunk is
+	/// read to the staging.
+	ANKI_USE_RESULT Error loadChunk(PtrSize size, DynamicArrayAuto<U8>& staging, ConstWeakArray<U8>& chunk);
 	ANKI_USE_RESULT Error checkFormat(VertexAttributeLocation type, ConstWeakArray<Format> supportedFormats) const;
+	ANKI_USE_RESULT Error loadMeshlets();
 };
 /// @}
 
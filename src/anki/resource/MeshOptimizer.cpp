@@ -0,0 +1,716 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/MeshOptimizer.h>
+#include <algorithm>
+
+namespace anki
+{
+
+/// The constants of Forsyth's algorithm. See "Linear-Speed Vertex Cache Optimisation".
+class ForsythConstants
+{
+public:
+	static const U32 CACHE_SIZE = 32;
+	static constexpr F32 CACHE_DECAY_POWER = 1.5f;
+	static constexpr F32 LAST_TRIANGLE_SCORE = 0.75f;
+	static constexpr F32 VALENCE_BOOST_SCALE = 2.0f;
+	static constexpr F32 VALENCE_BOOST_POWER = 0.5f;
+};
+
+class ForsythVertex
+{
+public:
+	U32 m_firstTriangle = 0; ///< Offset to the adjacency list.
+	U32 m_remainingTriangleCount = 0; ///< The triangles that are not emitted yet. The first of the adjacency list.
+	I32 m_cachePosition = -1;
+	F32 m_score = 0.0f;
+};
+
+static F32 computeForsythScore(const ForsythVertex& vert)
+{
+	if(vert.m_remainingTriangleCount == 0)
+	{
+		// No triangle needs it
+		return -1.0f;
+	}
+
+	F32 score = 0.0f;
+	if(vert.m_cachePosition >= 0)
+	{
+		if(vert.m_cachePosition < 3)
+		{
+			// It was used by the last triangle. Give it a fixed score so there is no preference for the way the strips
+			// are walked
+			score = ForsythConstants::LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			const F32 scale = 1.0f / F32(ForsythConstants::CACHE_SIZE - 3);
+			score = pow(1.0f - F32(vert.m_cachePosition - 3) * scale, ForsythConstants::CACHE_DECAY_POWER);
+		}
+	}
+
+	// Boost the vertices with few triangles left so the lone triangles are not left behind
+	score += ForsythConstants::VALENCE_BOOST_SCALE
+			 * pow(F32(vert.m_remainingTriangleCount), -ForsythConstants::VALENCE_BOOST_POWER);
+
+	return score;
+}
+
+VertexCacheStatistics MeshOptimizer::computeVertexCacheStatistics(
+	ConstWeakArray<U32> indices, U32 vertexCount, GenericMemoryPoolAllocator<U8> alloc, U32 cacheSize)
+{
+	ANKI_ASSERT((indices.getSize() % 3) == 0 && cacheSize > 0);
+
+	VertexCacheStatistics stats;
+	if(indices.getSize() == 0)
+	{
+		return stats;
+	}
+
+	// A vertex is in the FIFO if less than cacheSize misses happened after it was pushed
+	DynamicArrayAuto<U32> pushTime(alloc);
+	pushTime.create(vertexCount, MAX_U32);
+	DynamicArrayAuto<Bool8> used(alloc);
+	used.create(vertexCount, false);
+
+	U32 missCount = 0;
+	U32 usedVertexCount = 0;
+	for(U32 idx : indices)
+	{
+		ANKI_ASSERT(idx < vertexCount);
+
+		if(pushTime[idx] == MAX_U32 || missCount - pushTime[idx] >= cacheSize)
+		{
+			pushTime[idx] = missCount;
+			++missCount;
+		}
+
+		if(!used[idx])
+		{
+			used[idx] = true;
+			++usedVertexCount;
+		}
+	}
+
+	stats.m_acmr = F32(missCount) / F32(indices.getSize() / 3);
+	stats.m_atvr = F32(missCount) / F32(usedVertexCount);
+	return stats;
+}
+
+void MeshOptimizer::optimizeVertexCache(ConstWeakArray<U32> indices,
+	U32 vertexCount,
+	WeakArray<U32> outIndices,
+	GenericMemoryPoolAllocator<U8> alloc)
+{
+	ANKI_ASSERT((indices.getSize() % 3) == 0 && outIndices.getSize() == indices.getSize());
+	ANKI_ASSERT(indices.getBegin() != outIndices.getBegin());
+
+	const U32 triangleCount = indices.getSize() / 3;
+	if(triangleCount == 0)
+	{
+		return;
+	}
+
+	// Build the vertex to triangle adjacency
+	DynamicArrayAuto<ForsythVertex> verts(alloc);
+	verts.create(vertexCount);
+	for(U32 idx : indices)
+	{
+		ANKI_ASSERT(idx < vertexCount);
+		++verts[idx].m_remainingTriangleCount;
+	}
+
+	U32 offset = 0;
+	for(ForsythVertex& vert : verts)
+	{
+		vert.m_firstTriangle = offset;
+		offset += vert.m_remainingTriangleCount;
+		vert.m_remainingTriangleCount = 0;
+	}
+
+	DynamicArrayAuto<U32> adjacency(alloc);
+	adjacency.create(indices.getSize());
+	for(U32 i = 0; i < indices.getSize(); ++i)
+	{
+		ForsythVertex& vert = verts[indices[i]];
+		adjacency[vert.m_firstTriangle + vert.m_remainingTriangleCount++] = i / 3;
+	}
+
+	// Initial scores
+	for(ForsythVertex& vert : verts)
+	{
+		vert.m_score = computeForsythScore(vert);
+	}
+
+	DynamicArrayAuto<F32> triangleScores(alloc);
+	triangleScores.create(triangleCount);
+	DynamicArrayAuto<Bool8> emitted(alloc);
+	emitted.create(triangleCount, false);
+	for(U32 tri = 0; tri < triangleCount; ++tri)
+	{
+		triangleScores[tri] = verts[indices[tri * 3]].m_score + verts[indices[tri * 3 + 1]].m_score
+							  + verts[indices[tri * 3 + 2]].m_score;
+	}
+
+	// The cache has room for the vertices of a new triangle before the old ones are dropped
+	Array<U32, ForsythConstants::CACHE_SIZE + 3> cache;
+	U32 cacheSize = 0;
+	Array<U32, ForsythConstants::CACHE_SIZE + 3> newCache;
+
+	U32 bestTriangle = MAX_U32;
+	U32 nextUnemittedTriangle = 0;
+	for(U32 outTri = 0; outTri < triangleCount; ++outTri)
+	{
+		if(bestTriangle == MAX_U32)
+		{
+			// None of the cached vertices has triangles left. Start from any triangle
+			while(emitted[nextUnemittedTriangle])
+			{
+				++nextUnemittedTriangle;
+			}
+			bestTriangle = nextUnemittedTriangle;
+		}
+
+		// Emit the triangle
+		const U32 tri = bestTriangle;
+		ANKI_ASSERT(!emitted[tri]);
+		emitted[tri] = true;
+
+		U32 newCacheSize = 0;
+		for(U32 i = 0; i < 3; ++i)
+		{
+			const U32 idx = indices[tri * 3 + i];
+			outIndices[outTri * 3 + i] = idx;
+			newCache[newCacheSize++] = idx;
+
+			// Remove the triangle from the ones the vertex has left
+			ForsythVertex& vert = verts[idx];
+			U32* adjBegin = &adjacency[vert.m_firstTriangle];
+			for(U32 j = 0; j < vert.m_remainingTriangleCount; ++j)
+			{
+				if(adjBegin[j] == tri)
+				{
+					adjBegin[j] = adjBegin[vert.m_remainingTriangleCount - 1];
+					break;
+				}
+			}
+			--vert.m_remainingTriangleCount;
+		}
+
+		// Push the vertices of the triangle to the front of the cache and move the rest after them
+		for(U32 i = 0; i < cacheSize; ++i)
+		{
+			const U32 idx = cache[i];
+			if(idx != newCache[0] && idx != newCache[1] && idx != newCache[2])
+			{
+				newCache[newCacheSize++] = idx;
+			}
+		}
+
+		// Update the scores of the vertices that are or were in the cache
+		for(U32 i = 0; i < newCacheSize; ++i)
+		{
+			ForsythVertex& vert = verts[newCache[i]];
+			vert.m_cachePosition = (i < ForsythConstants::CACHE_SIZE) ? I32(i) : -1;
+
+			const F32 newScore = computeForsythScore(vert);
+			const F32 diff = newScore - vert.m_score;
+			vert.m_score = newScore;
+
+			for(U32 j = 0; j < vert.m_remainingTriangleCount; ++j)
+			{
+				triangleScores[adjacency[vert.m_firstTriangle + j]] += diff;
+			}
+		}
+
+		cacheSize = min(newCacheSize, ForsythConstants::CACHE_SIZE);
+		memcpy(&cache[0], &newCache[0], sizeof(cache[0]) * cacheSize);
+
+		// The next triangle is the best one that uses a cached vertex
+		bestTriangle = MAX_U32;
+		F32 bestScore = -1.0f;
+		for(U32 i = 0; i < cacheSize; ++i)
+		{
+			const ForsythVertex& vert = verts[cache[i]];
+			for(U32 j = 0; j < vert.m_remainingTriangleCount; ++j)
+			{
+				const U32 candidate = adjacency[vert.m_firstTriangle + j];
+				if(triangleScores[candidate] > bestScore)
+				{
+					bestScore = triangleScores[candidate];
+					bestTriangle = candidate;
+				}
+			}
+		}
+	}
+}
+
+U32 MeshOptimizer::optimizeVertexFetch(WeakArray<U32> indices, WeakArray<U32> remap)
+{
+	for(U32& r : remap)
+	{
+		r = MAX_U32;
+	}
+
+	U32 newVertexCount = 0;
+	for(U32& idx : indices)
+	{
+		ANKI_ASSERT(idx < remap.getSize());
+		if(remap[idx] == MAX_U32)
+		{
+			remap[idx] = newVertexCount++;
+		}
+
+		idx = remap[idx];
+	}
+
+	return newVertexCount;
+}
+
+/// A symmetric 4x4 matrix that sums the squared distances from planes.
+class Quadric
+{
+public:
+	F32 m_a2 = 0.0f, m_ab = 0.0f, m_ac = 0.0f, m_ad = 0.0f;
+	F32 m_b2 = 0.0f, m_bc = 0.0f, m_bd = 0.0f;
+	F32 m_c2 = 0.0f, m_cd = 0.0f;
+	F32 m_d2 = 0.0f;
+
+	void addPlane(const Vec3& n, F32 d)
+	{
+		m_a2 += n.x() * n.x();
+		m_ab += n.x() * n.y();
+		m_ac += n.x() * n.z();
+		m_ad += n.x() * d;
+		m_b2 += n.y() * n.y();
+		m_bc += n.y() * n.z();
+		m_bd += n.y() * d;
+		m_c2 += n.z() * n.z();
+		m_cd += n.z() * d;
+		m_d2 += d * d;
+	}
+
+	Quadric operator+(const Quadric& b) const
+	{
+		Quadric out;
+		out.m_a2 = m_a2 + b.m_a2;
+		out.m_ab = m_ab + b.m_ab;
+		out.m_ac = m_ac + b.m_ac;
+		out.m_ad = m_ad + b.m_ad;
+		out.m_b2 = m_b2 + b.m_b2;
+		out.m_bc = m_bc + b.m_bc;
+		out.m_bd = m_bd + b.m_bd;
+		out.m_c2 = m_c2 + b.m_c2;
+		out.m_cd = m_cd + b.m_cd;
+		out.m_d2 = m_d2 + b.m_d2;
+		return out;
+	}
+
+	/// Get the sum of the squared distances of a point from the planes.
+	F32 evaluate(const Vec3& p) const
+	{
+		const F32 x = p.x(), y = p.y(), z = p.z();
+		const F32 err = m_a2 * x * x + m_b2 * y * y + m_c2 * z * z
+						+ 2.0f * (m_ab * x * y + m_ac * x * z + m_bc * y * z + m_ad * x + m_bd * y + m_cd * z)
+						+ m_d2;
+		return max(err, 0.0f);
+	}
+};
+
+class EdgeCollapse
+{
+public:
+	U32 m_from;
+	U32 m_to;
+	F32 m_error;
+};
+
+static Vec3 computeTriangleNormal(const Vec3& a, const Vec3& b, const Vec3& c)
+{
+	return (b - a).cross(c - a);
+}
+
+/// Lock the vertices that share their position with other vertices (attribute seams) and the vertices of the edges
+/// that only one triangle uses (open borders).
+static void findLockedVertices(ConstWeakArray<U32> indices,
+	ConstWeakArray<Vec3> positions,
+	GenericMemoryPoolAllocator<U8> alloc,
+	DynamicArrayAuto<Bool8>& locked)
+{
+	const U32 vertCount = positions.getSize();
+	locked.create(vertCount, false);
+
+	// Sort the vertices by position to find the ones with the same position
+	DynamicArrayAuto<U32> sorted(alloc);
+	sorted.create(vertCount);
+	for(U32 i = 0; i < vertCount; ++i)
+	{
+		sorted[i] = i;
+	}
+
+	auto lessPosition = [&](U32 a, U32 b) {
+		const Vec3& pa = positions[a];
+		const Vec3& pb = positions[b];
+		return (pa.x() != pb.x()) ? pa.x() < pb.x() : ((pa.y() != pb.y()) ? pa.y() < pb.y() : pa.z() < pb.z());
+	};
+	std::sort(sorted.getBegin(), sorted.getEnd(), lessPosition);
+
+	// Every vertex points to the first vertex with the same position
+	DynamicArrayAuto<U32> welded(alloc);
+	welded.create(vertCount);
+	for(U32 i = 0; i < vertCount; ++i)
+	{
+		const Bool sameAsPrev = i > 0 && !lessPosition(sorted[i - 1], sorted[i]);
+		welded[sorted[i]] = (sameAsPrev) ? welded[sorted[i - 1]] : sorted[i];
+		if(sameAsPrev)
+		{
+			locked[sorted[i]] = true;
+			locked[sorted[i - 1]] = true;
+		}
+	}
+
+	// Count the triangles of every edge. The welded positions are used so that seams are not borders
+	DynamicArrayAuto<U64> edges(alloc);
+	edges.create(indices.getSize());
+	for(U32 i = 0; i < indices.getSize(); ++i)
+	{
+		const U32 a = welded[indices[i]];
+		const U32 b = welded[indices[(i % 3 == 2) ? i - 2 : i + 1]];
+		edges[i] = (U64(min(a, b)) << U64(32)) | U64(max(a, b));
+	}
+	std::sort(edges.getBegin(), edges.getEnd());
+
+	DynamicArrayAuto<Bool8> borderPositions(alloc);
+	borderPositions.create(vertCount, false);
+	for(U32 i = 0; i < edges.getSize();)
+	{
+		U32 end = i + 1;
+		while(end < edges.getSize() && edges[end] == edges[i])
+		{
+			++end;
+		}
+
+		if(end - i == 1)
+		{
+			borderPositions[U32(edges[i] >> U64(32))] = true;
+			borderPositions[U32(edges[i] & MAX_U32)] = true;
+		}
+
+		i = end;
+	}
+
+	for(U32 v = 0; v < vertCount; ++v)
+	{
+		if(borderPositions[welded[v]])
+		{
+			locked[v] = true;
+		}
+	}
+}
+
+F32 MeshOptimizer::simplify(ConstWeakArray<U32> indices,
+	ConstWeakArray<Vec3> positions,
+	U32 targetIndexCount,
+	F32 maxError,
+	DynamicArrayAuto<U32>& outIndices,
+	GenericMemoryPoolAllocator<U8> alloc)
+{
+	ANKI_ASSERT((indices.getSize() % 3) == 0);
+	const U32 vertCount = positions.getSize();
+
+	outIndices.resize(indices.getSize());
+	if(indices.getSize())
+	{
+		memcpy(&outIndices[0], &indices[0], indices.getSizeInBytes());
+	}
+
+	DynamicArrayAuto<Bool8> locked(alloc);
+	findLockedVertices(indices, positions, alloc, locked);
+
+	// The quadrics of the planes of the triangles around every vertex
+	DynamicArrayAuto<Quadric> quadrics(alloc);
+	quadrics.create(vertCount);
+	for(U32 tri = 0; tri < indices.getSize() / 3; ++tri)
+	{
+		const Vec3& a = positions[indices[tri * 3]];
+		Vec3 n = computeTriangleNormal(a, positions[indices[tri * 3 + 1]], positions[indices[tri * 3 + 2]]);
+		const F32 length = n.getLength();
+		if(length < EPSILON)
+		{
+			continue;
+		}
+
+		n /= length;
+		const F32 d = -n.dot(a);
+		for(U32 i = 0; i < 3; ++i)
+		{
+			quadrics[indices[tri * 3 + i]].addPlane(n, d);
+		}
+	}
+
+	// Every pass collapses the cheapest edges that don't touch each other
+	const F32 maxQuadricError = maxError * maxError;
+	F32 maxDoneError = 0.0f;
+	DynamicArrayAuto<EdgeCollapse> collapses(alloc);
+	DynamicArrayAuto<U32> remap(alloc);
+	remap.create(vertCount);
+	DynamicArrayAuto<Bool8> touched(alloc);
+	touched.create(vertCount);
+	DynamicArrayAuto<U32> adjacencyOffsets(alloc);
+	adjacencyOffsets.create(vertCount + 1);
+	DynamicArrayAuto<U32> adjacency(alloc);
+	while(outIndices.getSize() > targetIndexCount)
+	{
+		const U32 triCount = outIndices.getSize() / 3;
+
+		// Gather the collapses
+		collapses.destroy();
+		for(U32 i = 0; i < outIndices.getSize(); ++i)
+		{
+			const U32 a = outIndices[i];
+			const U32 b = outIndices[(i % 3 == 2) ? i - 2 : i + 1];
+			const Quadric q = quadrics[a] + quadrics[b];
+
+			if(!locked[a])
+			{
+				*collapses.emplaceBack() = {a, b, q.evaluate(positions[b])};
+			}
+
+			if(!locked[b])
+			{
+				*collapses.emplaceBack() = {b, a, q.evaluate(positions[a])};
+			}
+		}
+
+		std::sort(collapses.getBegin(), collapses.getEnd(), [](const EdgeCollapse& a, const EdgeCollapse& b) {
+			return a.m_error < b.m_error;
+		});
+
+		// The triangles of every vertex
+		memset(&adjacencyOffsets[0], 0, adjacencyOffsets.getSizeInBytes());
+		for(U32 idx : outIndices)
+		{
+			++adjacencyOffsets[idx + 1];
+		}
+		for(U32 v = 0; v < vertCount; ++v)
+		{
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+
+		adjacency.resize(outIndices.getSize());
+		{
+			DynamicArrayAuto<U32> counts(alloc);
+			counts.create(vertCount, 0);
+			for(U32 i = 0; i < outIndices.getSize(); ++i)
+			{
+				const U32 v = outIndices[i];
+				adjacency[adjacencyOffsets[v] + counts[v]++] = i / 3;
+			}
+		}
+
+		// Do the collapses
+		for(U32 v = 0; v < vertCount; ++v)
+		{
+			remap[v] = v;
+			touched[v] = false;
+		}
+
+		U32 remainingTriCount = triCount;
+		U32 collapseCount = 0;
+		for(const EdgeCollapse& collapse : collapses)
+		{
+			if(collapse.m_error > maxQuadricError || remainingTriCount * 3 <= targetIndexCount)
+			{
+				break;
+			}
+
+			if(touched[collapse.m_from] || touched[collapse.m_to])
+			{
+				continue;
+			}
+
+			// Check that the triangles that move don't flip
+			Bool flips = false;
+			U32 removedTriCount = 0;
+			for(U32 j = adjacencyOffsets[collapse.m_from]; j < adjacencyOffsets[collapse.m_from + 1] && !flips; ++j)
+			{
+				const U32* tri = &outIndices[adjacency[j] * 3];
+				if(tri[0] == collapse.m_to || tri[1] == collapse.m_to || tri[2] == collapse.m_to)
+				{
+					++removedTriCount;
+					continue;
+				}
+
+				Array<Vec3, 3> verts;
+				for(U32 k = 0; k < 3; ++k)
+				{
+					verts[k] = positions[tri[k]];
+				}
+				const Vec3 before = computeTriangleNormal(verts[0], verts[1], verts[2]);
+
+				for(U32 k = 0; k < 3; ++k)
+				{
+					if(tri[k] == collapse.m_from)
+					{
+						verts[k] = positions[collapse.m_to];
+					}
+				}
+				const Vec3 after = computeTriangleNormal(verts[0], verts[1], verts[2]);
+
+				flips = before.dot(after) <= 0.25f * before.getLength() * after.getLength();
+			}
+
+			if(flips)
+			{
+				continue;
+			}
+
+			remap[collapse.m_from] = collapse.m_to;
+			quadrics[collapse.m_to] = quadrics[collapse.m_to] + quadrics[collapse.m_from];
+			maxDoneError = max(maxDoneError, collapse.m_error);
+			remainingTriCount -= removedTriCount;
+			++collapseCount;
+
+			// Don't touch the neighbourhood again in this pass because the checks above used the old triangles
+			for(U32 j = adjacencyOffsets[collapse.m_from]; j < adjacencyOffsets[collapse.m_from + 1]; ++j)
+			{
+				const U32* tri = &outIndices[adjacency[j] * 3];
+				touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+			}
+		}
+
+		if(collapseCount == 0)
+		{
+			break;
+		}
+
+		// Apply the collapses and drop the triangles that became degenerate
+		U32 newIndexCount = 0;
+		for(U32 tri = 0; tri < triCount; ++tri)
+		{
+			const U32 a = remap[outIndices[tri * 3]];
+			const U32 b = remap[outIndices[tri * 3 + 1]];
+			const U32 c = remap[outIndices[tri * 3 + 2]];
+			if(a != b && b != c && c != a)
+			{
+				outIndices[newIndexCount++] = a;
+				outIndices[newIndexCount++] = b;
+				outIndices[newIndexCount++] = c;
+			}
+		}
+		outIndices.resize(newIndexCount);
+	}
+
+	return sqrt(maxDoneError);
+}
+
+/// Compute the bounds of a meshlet that has its first index and index count set.
+static void computeMeshletBounds(
+	ConstWeakArray<U32> indices, ConstWeakArray<Vec3> positions, MeshBinaryFile::Meshlet& meshlet)
+{
+	meshlet.m_aabbMin = Vec3(MAX_F32);
+	meshlet.m_aabbMax = Vec3(MIN_F32);
+	Vec3 normalSum(0.0f);
+
+	const U32 firstTri = meshlet.m_firstIndex / 3;
+	const U32 endTri = firstTri + meshlet.m_indexCount / 3;
+	for(U32 tri = firstTri; tri < endTri; ++tri)
+	{
+		const Vec3& a = positions[indices[tri * 3]];
+		const Vec3& b = positions[indices[tri * 3 + 1]];
+		const Vec3& c = positions[indices[tri * 3 + 2]];
+
+		meshlet.m_aabbMin = meshlet.m_aabbMin.min(a).min(b).min(c);
+		meshlet.m_aabbMax = meshlet.m_aabbMax.max(a).max(b).max(c);
+
+		// Weighted by the area
+		normalSum += (b - a).cross(c - a);
+	}
+
+	const F32 normalSumLength = normalSum.getLength();
+	if(normalSumLength < EPSILON)
+	{
+		meshlet.m_coneAxis = Vec3(0.0f, 0.0f, 1.0f);
+		meshlet.m_coneCutoff = -1.0f;
+		return;
+	}
+
+	meshlet.m_coneAxis = normalSum / normalSumLength;
+	meshlet.m_coneCutoff = 1.0f;
+	for(U32 tri = firstTri; tri < endTri; ++tri)
+	{
+		const Vec3& a = positions[indices[tri * 3]];
+		const Vec3 n = (positions[indices[tri * 3 + 1]] - a).cross(positions[indices[tri * 3 + 2]] - a);
+		const F32 length = n.getLength();
+		if(length > EPSILON)
+		{
+			meshlet.m_coneCutoff = min(meshlet.m_coneCutoff, n.dot(meshlet.m_coneAxis) / length);
+		}
+	}
+}
+
+void MeshOptimizer::generateMeshlets(ConstWeakArray<U32> indices,
+	ConstWeakArray<Vec3> positions,
+	const MeshBinaryFile::SubMesh& subMesh,
+	U32 maxVertices,
+	U32 maxTriangles,
+	DynamicArrayAuto<MeshBinaryFile::Meshlet>& meshlets)
+{
+	ANKI_ASSERT(maxVertices >= 3 && maxTriangles > 0);
+	ANKI_ASSERT((subMesh.m_firstIndex % 3) == 0 && (subMesh.m_indexCount % 3) == 0);
+	ANKI_ASSERT(subMesh.m_firstIndex + subMesh.m_indexCount <= indices.getSize());
+
+	// The meshlet that used a vertex last. It's how the unique vertices of a meshlet are counted
+	DynamicArrayAuto<U32> vertexMeshlet(meshlets.getAllocator());
+	vertexMeshlet.create(positions.getSize(), MAX_U32);
+
+	const U32 firstMeshlet = meshlets.getSize();
+	const U32 firstTri = subMesh.m_firstIndex / 3;
+	const U32 endTri = firstTri + subMesh.m_indexCount / 3;
+	MeshBinaryFile::Meshlet* meshlet = nullptr;
+	U32 meshletIdx = MAX_U32;
+	for(U32 tri = firstTri; tri < endTri; ++tri)
+	{
+		U32 newVertexCount = 0;
+		if(meshlet)
+		{
+			for(U32 i = 0; i < 3; ++i)
+			{
+				newVertexCount += vertexMeshlet[indices[tri * 3 + i]] != meshletIdx;
+			}
+		}
+
+		if(!meshlet || meshlet->m_vertexCount + newVertexCount > maxVertices
+			|| meshlet->m_indexCount / 3 + 1 > maxTriangles)
+		{
+			// Start a new one
+			meshletIdx = meshlets.getSize();
+			meshlet = meshlets.emplaceBack();
+			meshlet->m_firstIndex = tri * 3;
+			meshlet->m_indexCount = 0;
+			meshlet->m_vertexCount = 0;
+		}
+
+		for(U32 i = 0; i < 3; ++i)
+		{
+			const U32 idx = indices[tri * 3 + i];
+			if(vertexMeshlet[idx] != meshletIdx)
+			{
+				vertexMeshlet[idx] = meshletIdx;
+				++meshlet->m_vertexCount;
+			}
+		}
+		meshlet->m_indexCount += 3;
+	}
+
+	for(U32 i = firstMeshlet; i < meshlets.getSize(); ++i)
+	{
+		computeMeshletBounds(indices, positions, meshlets[i]);
+	}
+}
+
+} // end namespace anki
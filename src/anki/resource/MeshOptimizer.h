@@ -0,0 +1,97 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/MeshLoader.h>
+#include <anki/util/DynamicArray.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// How well the indices of a triangle list use a FIFO post-transform vertex cache.
+class VertexCacheStatistics
+{
+public:
+	/// Average cache miss ratio. The vertices that are transformed per triangle. It's 3.0 at worst and close to 0.5
+	/// for regular meshes at best.
+	F32 m_acmr = 0.0f;
+
+	/// Average transformed vertex ratio. The vertices that are transformed per vertex. It's 1.0 at best.
+	F32 m_atvr = 0.0f;
+};
+
+/// Offline optimizations of triangle lists. They are used by the exporters to prepare the mesh files.
+class MeshOptimizer
+{
+public:
+	/// The size of the FIFO cache that computeVertexCacheStatistics() assumes by default.
+	static const U32 DEFAULT_CACHE_SIZE = 16;
+
+	/// Simulate a FIFO vertex cache.
+	/// @param indices The triangle list.
+	/// @param vertexCount All the indices should be less than that.
+	/// @param alloc Used for temporary memory.
+	/// @param cacheSize The number of vertices the cache holds.
+	static VertexCacheStatistics computeVertexCacheStatistics(ConstWeakArray<U32> indices,
+		U32 vertexCount,
+		GenericMemoryPoolAllocator<U8> alloc,
+		U32 cacheSize = DEFAULT_CACHE_SIZE);
+
+	/// Reorder the triangles for the post-transform vertex cache using Tom Forsyth's linear-speed algorithm.
+	/// @param indices The triangle list.
+	/// @param vertexCount All the indices should be less than that.
+	/// @param[out] outIndices The reordered triangle list. It can't alias the indices.
+	/// @param alloc Used for temporary memory.
+	static void optimizeVertexCache(ConstWeakArray<U32> indices,
+		U32 vertexCount,
+		WeakArray<U32> outIndices,
+		GenericMemoryPoolAllocator<U8> alloc);
+
+	/// Renumber the vertices in the order the indices use them so the vertex fetches are sequential. Unused vertices
+	/// are dropped.
+	/// @param[in,out] indices The triangle list. It's rewritten with the new vertex numbers.
+	/// @param[out] remap For every old vertex its new number or MAX_U32 if it's not used. It should have vertexCount
+	///             elements.
+	/// @return The new vertex count.
+	static U32 optimizeVertexFetch(WeakArray<U32> indices, WeakArray<U32> remap);
+
+	/// Simplify a triangle list by collapsing edges in the order of the quadric error they add. An edge collapses to
+	/// one of its vertices so no vertices are moved or created and the attributes are kept. The vertices on open
+	/// borders and attribute seams don't move.
+	/// @param indices The triangle list.
+	/// @param positions The positions of the vertices.
+	/// @param targetIndexCount Stop when the indices are that many or less.
+	/// @param maxError Don't do collapses with error bigger than that. It's a distance in the space of the positions.
+	/// @param[out] outIndices The simplified triangle list. It uses the same vertices.
+	/// @param alloc Used for temporary memory.
+	/// @return The max error of the collapses that were done.
+	static F32 simplify(ConstWeakArray<U32> indices,
+		ConstWeakArray<Vec3> positions,
+		U32 targetIndexCount,
+		F32 maxError,
+		DynamicArrayAuto<U32>& outIndices,
+		GenericMemoryPoolAllocator<U8> alloc);
+
+	/// Split a sub mesh to meshlets that are contiguous ranges of its triangles and compute their bounds.
+	/// @param indices All the indices of the mesh.
+	/// @param positions All the positions of the mesh.
+	/// @param subMesh The range of indices to split.
+	/// @param maxVertices The max unique vertices of a meshlet.
+	/// @param maxTriangles The max triangles of a meshlet.
+	/// @param[in,out] meshlets The new meshlets are appended there.
+	static void generateMeshlets(ConstWeakArray<U32> indices,
+		ConstWeakArray<Vec3> positions,
+		const MeshBinaryFile::SubMesh& subMesh,
+		U32 maxVertices,
+		U32 maxTriangles,
+		DynamicArrayAuto<MeshBinaryFile::Meshlet>& meshlets);
+};
+/// @}
+
+} // end namespace anki
@@ -69,6 +69,7 @@ Error MeshResource::load(const ResourceFilename& filename, Bool async)
 	if(async)
 	{
 		task = getManager().getAsyncLoader().newTask<LoadTask>(this);
+		task->setOwner(static_cast<const ResourceObject*>(this));
 		ctx = &task->m_ctx;
 	}
 	else
@@ -139,10 +140,12 @@ Error MeshResource::load(const ResourceFilename& filename, Bool async)
 			out.m_fmt = in.m_format;
 			out.m_relativeOffset = in.m_relativeOffset;
 			out.m_buffIdx = in.m_bufferBinding;
-			ANKI_ASSERT(in.m_scale == 1.0f && "Not supported ATM");
 		}
 	}
 
+	// The loader made sure that only the positions can be scaled
+	m_positionScale = header.m_vertexAttributes[VertexAttributeLocation::POSITION].m_scale;
+
 	// Other
 	const Vec3 obbCenter = (header.m_aabbMax + header.m_aabbMin) / 2.0f;
 	const Vec3 obbExtend = header.m_aabbMax - obbCenter;
@@ -190,9 +193,13 @@ Error MeshResource::loadAsync(MeshLoader& loader) const
 	cmdb->setBufferBarrier(
 		m_indexBuff, BufferUsageBit::INDEX, BufferUsageBit::BUFFER_UPLOAD_DESTINATION, 0, MAX_PTR_SIZE);
 
+	// Allocate the staging memory of both buffers at once. Allocating one while holding the other might deadlock with
+	// the other loader threads
+	const Array<PtrSize, 2> sizes = {{m_vertBuff->getSize(), m_indexBuff->getSize()}};
+	ANKI_CHECK(transferAlloc.allocate(sizes, WeakArray<TransferGpuAllocatorHandle>(handles)));
+
 	// Write index buffer
 	{
-		ANKI_CHECK(transferAlloc.allocate(m_indexBuff->getSize(), handles[1]));
 		void* data = handles[1].getMappedMemory();
 		ANKI_ASSERT(data);
 
@@ -203,7 +210,6 @@ Error MeshResource::loadAsync(MeshLoader& loader) const
 
 	// Write vert buff
 	{
-		ANKI_CHECK(transferAlloc.allocate(m_vertBuff->getSize(), handles[0]));
 		U8* data = static_cast<U8*>(handles[0].getMappedMemory());
 		ANKI_ASSERT(data);
 
@@ -99,6 +99,13 @@ public:
 		return m_texChannelCount;
 	}
 
+	/// Get the scale of the positions. The normalized positions should be multiplied by it and it's 1.0 for the float
+	/// formats.
+	F32 getPositionScale() const
+	{
+		return m_positionScale;
+	}
+
 	/// Return true if it has bone weights.
 	Bool hasBoneWeights() const
 	{
@@ -145,6 +152,7 @@ protected:
 
 	BufferPtr m_vertBuff;
 	U8 m_texChannelCount = 0;
+	F32 m_positionScale = 1.0f;
 
 	// Other
 	Obb m_obb;
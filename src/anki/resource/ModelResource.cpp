@@ -109,6 +109,7 @@ void ModelPatch::getRenderingDataSub(
 	// Index buff
 	U32 indexCount;
 	mesh.getIndexBufferInfo(inf.m_indexBuffer, inf.m_indexBufferOffset, indexCount, inf.m_indexType);
+	inf.m_positionScale = mesh.getPositionScale();
 
 	// Other
 	ANKI_ASSERT(subMeshIndicesArray.getSize() == 0 && mesh.getSubMeshCount() == 1 && "Not supported ATM");
@@ -78,6 +78,8 @@ public:
 	BufferPtr m_indexBuffer;
 	PtrSize m_indexBufferOffset;
 	IndexType m_indexType;
+
+	F32 m_positionScale; ///< Should be applied to the model transform. See MeshResource::getPositionScale.
 };
 
 /// Model patch interface class. Its very important class and it binds the material with the mesh
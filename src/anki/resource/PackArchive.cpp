@@ -0,0 +1,201 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/PackArchive.h>
+#include <anki/util/File.h>
+#include <anki/util/StringList.h>
+#include <algorithm>
+#include <cstring>
+
+namespace anki
+{
+
+Error PackArchive::open(const CString& filename)
+{
+	ANKI_CHECK(m_mapping.map(filename));
+	const ConstWeakArray<U8> data = m_mapping.getData();
+
+	// Check the header
+	if(data.getSize() < sizeof(PackArchiveHeader))
+	{
+		ANKI_RESOURCE_LOGE("Archive too small: %s", filename.get());
+		return Error::USER_DATA;
+	}
+
+	const PackArchiveHeader& header = *reinterpret_cast<const PackArchiveHeader*>(data.getBegin());
+	if(std::memcmp(&header.m_magic[0], ANKI_PACK_ARCHIVE_MAGIC, sizeof(header.m_magic)) != 0)
+	{
+		ANKI_RESOURCE_LOGE("Wrong archive magic: %s", filename.get());
+		return Error::USER_DATA;
+	}
+
+	const PtrSize tocSize = PtrSize(header.m_fileCount) * sizeof(PackArchiveEntry);
+	if(data.getSize() < sizeof(PackArchiveHeader) + tocSize + header.m_filenamesSize)
+	{
+		ANKI_RESOURCE_LOGE("Truncated archive: %s", filename.get());
+		return Error::USER_DATA;
+	}
+
+	m_entries = reinterpret_cast<const PackArchiveEntry*>(data.getBegin() + sizeof(PackArchiveHeader));
+	m_filenames = reinterpret_cast<const char*>(data.getBegin() + sizeof(PackArchiveHeader) + tocSize);
+	m_fileCount = header.m_fileCount;
+
+	// Check the table of contents once so the lookups can trust it
+	for(U32 i = 0; i < m_fileCount; ++i)
+	{
+		const PackArchiveEntry& entry = m_entries[i];
+		if(entry.m_offset > data.getSize() || entry.m_size > data.getSize() - entry.m_offset
+			|| entry.m_filenameLength == 0 || PtrSize(entry.m_filenameOffset) + entry.m_filenameLength
+												  >= header.m_filenamesSize
+			|| m_filenames[entry.m_filenameOffset + entry.m_filenameLength] != '\0'
+			|| (i > 0 && m_entries[i - 1].m_filenameHash > entry.m_filenameHash))
+		{
+			ANKI_RESOURCE_LOGE("Corrupted table of contents: %s", filename.get());
+			m_fileCount = 0;
+			return Error::USER_DATA;
+		}
+	}
+
+	return Error::NONE;
+}
+
+Bool PackArchive::findFile(const CString& filename, ConstWeakArray<U8>& data) const
+{
+	const U64 hash = computePackArchiveFilenameHash(filename);
+	const PackArchiveEntry* end = m_entries + m_fileCount;
+	const PackArchiveEntry* it = std::lower_bound(
+		m_entries, end, hash, [](const PackArchiveEntry& entry, U64 hash) { return entry.m_filenameHash < hash; });
+
+	// Walk the entries with the same hash in case of collisions
+	for(; it != end && it->m_filenameHash == hash; ++it)
+	{
+		if(it->m_filenameLength == filename.getLength()
+			&& std::memcmp(m_filenames + it->m_filenameOffset, filename.get(), filename.getLength()) == 0)
+		{
+			data = ConstWeakArray<U8>(m_mapping.getData().getBegin() + it->m_offset, it->m_size);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+CString PackArchive::getFilename(U32 i) const
+{
+	ANKI_ASSERT(i < m_fileCount);
+	return CString(m_filenames + m_entries[i].m_filenameOffset);
+}
+
+static Error writeZeros(File& file, PtrSize size)
+{
+	const Array<U8, PACK_ARCHIVE_DATA_ALIGNMENT> zeros = {};
+	ANKI_ASSERT(size <= zeros.getSize());
+	if(size)
+	{
+		ANKI_CHECK(file.write(&zeros[0], size));
+	}
+
+	return Error::NONE;
+}
+
+Error createPackArchive(const CString& dir, const CString& archiveFilename, GenericMemoryPoolAllocator<U8> alloc)
+{
+	// Gather the files
+	StringListAuto filenames(alloc);
+	ANKI_CHECK(walkDirectoryTree(dir, &filenames, [](const CString& fname, void* ud, Bool isDir) -> Error {
+		if(!isDir)
+		{
+			static_cast<StringListAuto*>(ud)->pushBackSprintf("%s", fname.get());
+		}
+		return Error::NONE;
+	}));
+
+	const U32 fileCount = U32(filenames.getSize());
+	DynamicArrayAuto<PackArchiveEntry> entries(alloc);
+	entries.create(fileCount);
+	DynamicArrayAuto<CString> entryFilenames(alloc);
+	entryFilenames.create(fileCount);
+
+	// Fill the entries without the offsets and sort them
+	U32 filenamesSize = 0;
+	U32 count = 0;
+	for(const String& fname : filenames)
+	{
+		PackArchiveEntry& entry = entries[count];
+		entry.m_filenameHash = computePackArchiveFilenameHash(fname.toCString());
+		entry.m_size = 0;
+		entry.m_filenameOffset = filenamesSize;
+		entry.m_filenameLength = U32(fname.getLength());
+		entryFilenames[count] = fname.toCString();
+
+		filenamesSize += entry.m_filenameLength + 1;
+		++count;
+	}
+
+	DynamicArrayAuto<U32> order(alloc);
+	order.create(fileCount);
+	for(U32 i = 0; i < fileCount; ++i)
+	{
+		order[i] = i;
+	}
+	std::sort(order.getBegin(), order.getEnd(), [&](U32 a, U32 b) {
+		return entries[a].m_filenameHash < entries[b].m_filenameHash;
+	});
+
+	// Map the files and compute the offsets of their contents
+	DynamicArrayAuto<MemoryMappedFile> files(alloc);
+	files.create(fileCount);
+	PtrSize offset = sizeof(PackArchiveHeader) + sizeof(PackArchiveEntry) * fileCount + filenamesSize;
+	for(U32 i : order)
+	{
+		StringAuto path(alloc);
+		path.sprintf("%s/%s", dir.get(), entryFilenames[i].get());
+		ANKI_CHECK(files[i].map(path.toCString()));
+
+		alignRoundUp(PACK_ARCHIVE_DATA_ALIGNMENT, offset);
+		entries[i].m_offset = offset;
+		entries[i].m_size = files[i].getData().getSize();
+		offset += entries[i].m_size;
+	}
+
+	// Write the header, the table of contents and the filenames
+	File out;
+	ANKI_CHECK(out.open(archiveFilename, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+
+	PackArchiveHeader header;
+	memcpy(&header.m_magic[0], ANKI_PACK_ARCHIVE_MAGIC, sizeof(header.m_magic));
+	header.m_fileCount = fileCount;
+	header.m_filenamesSize = filenamesSize;
+	ANKI_CHECK(out.write(&header, sizeof(header)));
+
+	for(U32 i : order)
+	{
+		ANKI_CHECK(out.write(&entries[i], sizeof(PackArchiveEntry)));
+	}
+
+	for(U32 i = 0; i < fileCount; ++i)
+	{
+		ANKI_CHECK(out.write(entryFilenames[i].get(), entries[i].m_filenameLength + 1));
+	}
+
+	// Write the contents
+	offset = sizeof(PackArchiveHeader) + sizeof(PackArchiveEntry) * fileCount + filenamesSize;
+	for(U32 i : order)
+	{
+		ANKI_CHECK(writeZeros(out, entries[i].m_offset - offset));
+		offset = entries[i].m_offset;
+
+		if(entries[i].m_size)
+		{
+			ANKI_CHECK(out.write(files[i].getData().getBegin(), entries[i].m_size));
+			offset += entries[i].m_size;
+		}
+	}
+
+	ANKI_RESOURCE_LOGI("Created archive \"%s\" with %u files", archiveFilename.get(), fileCount);
+	return Error::NONE;
+}
+
+} // end namespace anki
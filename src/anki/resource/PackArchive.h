@@ -0,0 +1,88 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/util/Filesystem.h>
+#include <anki/util/Hash.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// The magic of the .ankipak archives.
+#define ANKI_PACK_ARCHIVE_MAGIC "ANKIPAK1"
+
+/// The alignment of the contents of every file in a .ankipak archive.
+const U32 PACK_ARCHIVE_DATA_ALIGNMENT = 64;
+
+/// The header of a .ankipak archive. The header is followed by the table of contents, then the filenames and then the
+/// contents of the files. The contents are stored uncompressed so they can be used directly from the mapped archive.
+class PackArchiveHeader
+{
+public:
+	Array<U8, 8> m_magic;
+	U32 m_fileCount;
+	U32 m_filenamesSize; ///< The size of the filename block.
+};
+
+/// An entry of the table of contents of a .ankipak archive. The entries are sorted by filename hash.
+class PackArchiveEntry
+{
+public:
+	U64 m_filenameHash;
+	U64 m_offset; ///< The offset of the contents from the start of the archive.
+	U64 m_size;
+	U32 m_filenameOffset; ///< The offset of the filename from the start of the filename block.
+	U32 m_filenameLength;
+};
+
+static_assert(sizeof(PackArchiveHeader) == 16, "Part of the file format");
+static_assert(sizeof(PackArchiveEntry) == 32, "Part of the file format");
+
+/// The hash of a filename inside a .ankipak archive.
+inline U64 computePackArchiveFilenameHash(const CString& filename)
+{
+	ANKI_ASSERT(!filename.isEmpty());
+	return computeHash(filename.get(), filename.getLength());
+}
+
+/// A memory mapped .ankipak archive.
+class PackArchive : public NonCopyable
+{
+public:
+	/// Map and validate an archive.
+	ANKI_USE_RESULT Error open(const CString& filename);
+
+	/// Find a file. It's a binary search on the table of contents. It's thread-safe.
+	/// @param filename The filename of the file in the archive.
+	/// @param[out] data The contents of the file. They are valid for as long as the archive is alive.
+	/// @return True if the file was found.
+	Bool findFile(const CString& filename, ConstWeakArray<U8>& data) const;
+
+	U32 getFileCount() const
+	{
+		return m_fileCount;
+	}
+
+	/// Get the filename of the i-th file of the table of contents.
+	CString getFilename(U32 i) const;
+
+private:
+	MemoryMappedFile m_mapping;
+	const PackArchiveEntry* m_entries = nullptr;
+	const char* m_filenames = nullptr;
+	U32 m_fileCount = 0;
+};
+
+/// Create a .ankipak archive with all the files of a directory. The filenames are relative to the directory.
+ANKI_USE_RESULT Error createPackArchive(
+	const CString& dir, const CString& archiveFilename, GenericMemoryPoolAllocator<U8> alloc);
+/// @}
+
+} // end namespace anki
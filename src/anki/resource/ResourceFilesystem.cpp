@@ -4,6 +4,7 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/resource/ResourceFilesystem.h>
+#include <anki/resource/PackArchive.h>
 #include <anki/util/Filesystem.h>
 #include <anki/misc/ConfigSet.h>
 #include <anki/core/Trace.h>
@@ -17,6 +18,7 @@ class CResourceFile final : public ResourceFile
 {
 public:
 	File m_file;
+	U64 m_modificationTime = 0;
 
 	CResourceFile(GenericMemoryPoolAllocator<U8> alloc)
 		: ResourceFile(alloc)
@@ -56,6 +58,19 @@ public:
 	{
 		return m_file.getSize();
 	}
+
+	U64 getModificationTime() const override
+	{
+		return m_modificationTime;
+	}
+
+	/// Open a file of the filesystem.
+	ANKI_USE_RESULT Error open(const CString& filename)
+	{
+		ANKI_CHECK(m_file.open(filename, FileOpenFlag::READ));
+		ANKI_CHECK(getFileModificationTime(filename, m_modificationTime));
+		return Error::NONE;
+	}
 };
 
 /// ZIP file
@@ -193,10 +208,90 @@ public:
 	}
 };
 
+/// A file inside a memory mapped .ankipak archive. Reading is a memcpy and seeking is free.
+class PackResourceFile final : public ResourceFile
+{
+public:
+	ConstWeakArray<U8> m_data;
+	PtrSize m_pos = 0;
+
+	PackResourceFile(GenericMemoryPoolAllocator<U8> alloc, ConstWeakArray<U8> data)
+		: ResourceFile(alloc)
+		, m_data(data)
+	{
+	}
+
+	ANKI_USE_RESULT Error read(void* buff, PtrSize size) override
+	{
+		ConstWeakArray<U8> span;
+		ANKI_CHECK(getMappedSpan(size, span));
+		memcpy(buff, span.getBegin(), size);
+		return Error::NONE;
+	}
+
+	ANKI_USE_RESULT Error readAllText(GenericMemoryPoolAllocator<U8> alloc, String& out) override
+	{
+		const char* begin = reinterpret_cast<const char*>(m_data.getBegin());
+		out.create(alloc, begin + m_pos, begin + m_data.getSize());
+		m_pos = m_data.getSize();
+		return Error::NONE;
+	}
+
+	ANKI_USE_RESULT Error readU32(U32& u) override
+	{
+		// Assume machine and file have same endianness
+		return read(&u, sizeof(u));
+	}
+
+	ANKI_USE_RESULT Error readF32(F32& f) override
+	{
+		// Assume machine and file have same endianness
+		return read(&f, sizeof(f));
+	}
+
+	ANKI_USE_RESULT Error seek(PtrSize offset, SeekOrigin origin) override
+	{
+		const PtrSize base = (origin == SeekOrigin::BEGINNING) ? 0
+							 : (origin == SeekOrigin::CURRENT) ? m_pos : m_data.getSize();
+		if(offset > m_data.getSize() - base)
+		{
+			ANKI_RESOURCE_LOGE("Seek out of bounds");
+			return Error::FUNCTION_FAILED;
+		}
+
+		m_pos = base + offset;
+		return Error::NONE;
+	}
+
+	PtrSize getSize() const override
+	{
+		return m_data.getSize();
+	}
+
+	Bool isMemoryMapped() const override
+	{
+		return true;
+	}
+
+	ANKI_USE_RESULT Error getMappedSpan(PtrSize size, ConstWeakArray<U8>& span) override
+	{
+		if(size > m_data.getSize() - m_pos)
+		{
+			ANKI_RESOURCE_LOGE("File read failed");
+			return Error::FILE_ACCESS;
+		}
+
+		span = ConstWeakArray<U8>(m_data.getBegin() + m_pos, size);
+		m_pos += size;
+		return Error::NONE;
+	}
+};
+
 ResourceFilesystem::~ResourceFilesystem()
 {
 	for(Path& p : m_paths)
 	{
+		m_alloc.deleteInstance(p.m_pack);
 		p.m_files.destroy(m_alloc);
 		p.m_path.destroy(m_alloc);
 	}
@@ -239,9 +334,25 @@ Error ResourceFilesystem::addNewPath(const CString& path)
 {
 	U fileCount = 0;
 	static const CString extension(".ankizip");
+	static const CString packExtension(".ankipak");
 
 	auto pos = path.find(extension);
-	if(pos != CString::NPOS && pos == path.getLength() - extension.getLength())
+	auto packPos = path.find(packExtension);
+	if(packPos != CString::NPOS && packPos == path.getLength() - packExtension.getLength())
+	{
+		// It's a pack. Map it and use its table of contents instead of listing the files
+
+		Path p;
+		p.m_isArchive = true;
+		p.m_path.sprintf(m_alloc, "%s", &path[0]);
+		p.m_pack = m_alloc.newInstance<PackArchive>();
+
+		const Error err = p.m_pack->open(path);
+		fileCount = p.m_pack->getFileCount();
+		m_paths.emplaceFront(m_alloc, std::move(p));
+		ANKI_CHECK(err);
+	}
+	else if(pos != CString::NPOS && pos == path.getLength() - extension.getLength())
 	{
 		// It's an archive
 
@@ -330,6 +441,17 @@ Error ResourceFilesystem::addNewPath(const CString& path)
 	return Error::NONE;
 }
 
+void ResourceFilesystem::getDataDirectories(StringListAuto& dirs) const
+{
+	for(const Path& p : m_paths)
+	{
+		if(!p.m_isArchive && !p.m_isCache)
+		{
+			dirs.pushBack(p.m_path.toCString());
+		}
+	}
+}
+
 Error ResourceFilesystem::openFile(const ResourceFilename& filename, ResourceFilePtr& filePtr)
 {
 	ResourceFile* rfile = nullptr;
@@ -351,13 +473,19 @@ Error ResourceFilesystem::openFile(const ResourceFilename& filename, ResourceFil
 				CResourceFile* file = m_alloc.newInstance<CResourceFile>(m_alloc);
 				rfile = file;
 
-				err = file->m_file.open(&newFname[0], FileOpenFlag::READ);
+				err = file->open(newFname.toCString());
 			}
 		}
 		else
 		{
 			// In data path or archive
 
+			ConstWeakArray<U8> packedData;
+			if(p.m_pack && p.m_pack->findFile(filename, packedData))
+			{
+				rfile = m_alloc.newInstance<PackResourceFile>(m_alloc, packedData);
+			}
+
 			for(const String& pfname : p.m_files)
 			{
 				if(pfname != filename)
@@ -381,7 +509,7 @@ Error ResourceFilesystem::openFile(const ResourceFilename& filename, ResourceFil
 					CResourceFile* file = m_alloc.newInstance<CResourceFile>(m_alloc);
 					rfile = file;
 
-					err = file->m_file.open(&newFname[0], FileOpenFlag::READ);
+					err = file->open(newFname.toCString());
 
 #if 0
 					printf("Opening asset %s\n", &newFname[0]);
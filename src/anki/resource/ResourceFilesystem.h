@@ -10,12 +10,14 @@
 #include <anki/util/StringList.h>
 #include <anki/util/File.h>
 #include <anki/util/Ptr.h>
+#include <anki/util/WeakArray.h>
 
 namespace anki
 {
 
 // Forward
 class ConfigSet;
+class PackArchive;
 
 /// @addtogroup resource
 /// @{
@@ -55,6 +57,26 @@ public:
 	/// Get the size of the file.
 	virtual PtrSize getSize() const = 0;
 
+	/// Get the time the file was last modified. Files in archives don't change so they return zero.
+	virtual U64 getModificationTime() const
+	{
+		return 0;
+	}
+
+	/// Return true if the contents of the file are memory mapped. Then getMappedSpan() can be used instead of read().
+	virtual Bool isMemoryMapped() const
+	{
+		return false;
+	}
+
+	/// Similar to read() but instead of copying the data it returns a span of the file's memory. It only works if
+	/// isMemoryMapped() is true. The span is valid for as long as the file is alive.
+	virtual ANKI_USE_RESULT Error getMappedSpan(PtrSize size, ConstWeakArray<U8>& span)
+	{
+		ANKI_ASSERT(!"The file is not memory mapped");
+		return Error::FUNCTION_FAILED;
+	}
+
 	Atomic<I32>& getRefcount()
 	{
 		return m_refcount;
@@ -89,6 +111,9 @@ public:
 	/// Search the path list to find the file. Then open the file for reading. It's thread-safe.
 	ANKI_USE_RESULT Error openFile(const ResourceFilename& filename, ResourceFilePtr& file);
 
+	/// Get the directories of the data paths. The archives and the cache are skipped.
+	void getDataDirectories(StringListAuto& dirs) const;
+
 #if !ANKI_TESTS
 private:
 #endif
@@ -97,6 +122,7 @@ private:
 	public:
 		StringList m_files; ///< Files inside the directory.
 		String m_path; ///< A directory or an archive.
+		PackArchive* m_pack = nullptr; ///< If it's a .ankipak. It replaces m_files.
 		Bool8 m_isArchive = false;
 		Bool8 m_isCache = false;
 
@@ -105,15 +131,19 @@ private:
 		Path(Path&& b)
 			: m_files(std::move(b.m_files))
 			, m_path(std::move(b.m_path))
+			, m_pack(b.m_pack)
 			, m_isArchive(std::move(b.m_isArchive))
 			, m_isCache(std::move(b.m_isCache))
 		{
+			b.m_pack = nullptr;
 		}
 
 		Path& operator=(Path&& b)
 		{
 			m_files = std::move(b.m_files);
 			m_path = std::move(b.m_path);
+			m_pack = b.m_pack;
+			b.m_pack = nullptr;
 			m_isArchive = std::move(b.m_isArchive);
 			m_isCache = std::move(b.m_isCache);
 			return *this;
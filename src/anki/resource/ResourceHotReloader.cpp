@@ -0,0 +1,333 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/ResourceHotReloader.h>
+#include <anki/resource/ResourceManager.h>
+#include <anki/resource/AsyncLoader.h>
+#include <anki/resource/ResourceFilesystem.h>
+#include <anki/resource/ShaderProgramResource.h>
+#include <anki/resource/MaterialResource.h>
+#include <anki/resource/TextureResource.h>
+#include <anki/resource/GenericResource.h>
+#include <anki/util/Filesystem.h>
+
+namespace anki
+{
+
+/// Return true if the resource is made from a file.
+template<typename T>
+static Bool usesFile(const T& rsrc, CString filename)
+{
+	return rsrc.getFilename() == filename;
+}
+
+static Bool usesFile(const ShaderProgramResource& prog, CString filename)
+{
+	return prog.dependsOn(filename);
+}
+
+/// Do the extra work that some resources need after they are reloaded.
+template<typename T>
+static void postReload(ResourceManager& manager, T& rsrc)
+{
+}
+
+static void postReload(ResourceManager& manager, ShaderProgramResource& prog)
+{
+	// The materials hold variants of the old source
+	DynamicArrayAuto<MaterialResourcePtr> mtls(manager.getAllocator());
+	manager.gatherResources(mtls);
+	for(MaterialResourcePtr& mtl : mtls)
+	{
+		if(mtl->getShaderProgramResource().get() == &prog)
+		{
+			mtl->invalidateVariants();
+		}
+	}
+}
+
+/// The reload of a single resource.
+class ResourceHotReloader::ReloadBase
+{
+public:
+	enum class State : U32
+	{
+		LOADING,
+		LOADED,
+		FAILED
+	};
+
+	Atomic<State> m_state = {State::LOADING};
+	Bool8 m_reloadAgain = false; ///< The file changed while it was loading.
+
+	virtual ~ReloadBase()
+	{
+	}
+
+	virtual const ResourceObject& getResource() const = 0;
+
+	/// Load the new version. It runs in the AsyncLoader.
+	ANKI_USE_RESULT virtual Error load() = 0;
+
+	/// Put the new version in place of the old one.
+	/// @return False if the resource can't be reloaded.
+	virtual Bool apply() = 0;
+
+	virtual void deleteNewer() = 0;
+};
+
+template<typename T>
+class ResourceHotReloader::Reload : public ReloadBase
+{
+public:
+	ResourcePtr<T> m_rsrc;
+	T* m_newer = nullptr;
+
+	Reload(ResourcePtr<T> rsrc)
+		: m_rsrc(rsrc)
+	{
+	}
+
+	~Reload()
+	{
+		deleteNewer();
+	}
+
+	const ResourceObject& getResource() const final
+	{
+		return *m_rsrc;
+	}
+
+	Error load() final
+	{
+		ANKI_ASSERT(m_newer == nullptr);
+		return m_rsrc->getManager().loadUnregisteredResource(m_rsrc->getFilename(), m_newer);
+	}
+
+	Bool apply() final
+	{
+		ANKI_ASSERT(m_newer);
+		if(!m_rsrc->hotReload(*m_newer))
+		{
+			return false;
+		}
+
+		postReload(m_rsrc->getManager(), *m_rsrc);
+		return true;
+	}
+
+	void deleteNewer() final
+	{
+		if(m_newer)
+		{
+			m_rsrc->getManager().getAllocator().deleteInstance(m_newer);
+			m_newer = nullptr;
+		}
+	}
+};
+
+/// Loads the new version of a resource. The task doesn't own the reload, the ResourceHotReloader does.
+class ResourceHotReloader::ReloadTask : public AsyncLoaderTask
+{
+public:
+	ReloadBase* m_reload;
+
+	ReloadTask(ReloadBase* reload)
+		: m_reload(reload)
+	{
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx) final
+	{
+		const Error err = m_reload->load();
+		m_reload->m_state.store((err) ? ReloadBase::State::FAILED : ReloadBase::State::LOADED);
+		return err;
+	}
+};
+
+ResourceHotReloader::ResourceHotReloader(ResourceManager* manager)
+	: m_manager(manager)
+{
+	ANKI_ASSERT(manager);
+}
+
+ResourceHotReloader::~ResourceHotReloader()
+{
+	m_manager->getAsyncLoader().cancelTasks(this);
+
+	auto alloc = m_manager->getAllocator();
+	for(ReloadBase* reload : m_reloads)
+	{
+		alloc.deleteInstance(reload);
+	}
+	m_reloads.destroy(alloc);
+
+	m_dataDirs.destroy(alloc);
+}
+
+Error ResourceHotReloader::init()
+{
+	auto alloc = m_manager->getAllocator();
+	ANKI_CHECK(m_notify.init(alloc));
+
+	StringListAuto dirs(alloc);
+	m_manager->getFilesystem().getDataDirectories(dirs);
+	for(const String& dir : dirs)
+	{
+		const CString cdir = dir.toCString();
+		m_dataDirs.pushBackSprintf(alloc, (cdir[cdir.getLength() - 1] == '/') ? "%s" : "%s/", cdir.cstr());
+
+		// INotify doesn't watch the subdirectories so add them one by one
+		ANKI_CHECK(m_notify.addPath(cdir));
+
+		StringListAuto subdirs(alloc);
+		ANKI_CHECK(walkDirectoryTree(cdir, &subdirs, [](const CString& fname, void* ud, Bool isDir) -> Error {
+			if(isDir)
+			{
+				static_cast<StringListAuto*>(ud)->pushBack(fname);
+			}
+			return Error::NONE;
+		}));
+
+		for(const String& subdir : subdirs)
+		{
+			StringAuto path(alloc);
+			path.sprintf("%s%s", m_dataDirs.getBack().cstr(), subdir.cstr());
+			ANKI_CHECK(m_notify.addPath(path.toCString()));
+		}
+	}
+
+	ANKI_RESOURCE_LOGI("Hot reload is enabled. Watching %u data directories", U(dirs.getSize()));
+	return Error::NONE;
+}
+
+void ResourceHotReloader::update()
+{
+	applyReloads();
+
+	StringListAuto files(m_manager->getAllocator());
+	if(m_notify.pollEvents(files))
+	{
+		ANKI_RESOURCE_LOGE("Failed to check for changed files");
+		return;
+	}
+
+	for(const String& file : files)
+	{
+		// Turn the path to a resource filename
+		CString filename;
+		for(const String& dir : m_dataDirs)
+		{
+			if(file.getLength() > dir.getLength() && file.toCString().find(dir.toCString()) == 0)
+			{
+				filename = file.toCString().cstr() + dir.getLength();
+				break;
+			}
+		}
+
+		if(filename.isEmpty())
+		{
+			continue;
+		}
+
+		reloadResources<ShaderProgramResource>(filename);
+		reloadResources<TextureResource>(filename);
+		reloadResources<GenericResource>(filename);
+	}
+}
+
+template<typename T>
+void ResourceHotReloader::reloadResources(CString filename)
+{
+	auto alloc = m_manager->getAllocator();
+
+	DynamicArrayAuto<ResourcePtr<T>> rsrcs(alloc);
+	m_manager->gatherResources(rsrcs);
+
+	for(ResourcePtr<T>& rsrc : rsrcs)
+	{
+		if(!usesFile(*rsrc, filename))
+		{
+			continue;
+		}
+
+		// If it's loading it might have read the file before the change. Load it again when it's done
+		Bool loading = false;
+		for(ReloadBase* reload : m_reloads)
+		{
+			if(&reload->getResource() == rsrc.get())
+			{
+				reload->m_reloadAgain = true;
+				loading = true;
+				break;
+			}
+		}
+
+		if(!loading)
+		{
+			ReloadBase* reload = alloc.newInstance<Reload<T>>(rsrc);
+			m_reloads.emplaceBack(alloc, reload);
+			submitReload(*reload);
+		}
+	}
+}
+
+void ResourceHotReloader::submitReload(ReloadBase& reload)
+{
+	reload.m_state.store(ReloadBase::State::LOADING);
+
+	AsyncLoader& loader = m_manager->getAsyncLoader();
+	ReloadTask* task = loader.newTask<ReloadTask>(&reload);
+	task->setOwner(this);
+	loader.submitTask(task, AsyncLoaderPriority::BACKGROUND);
+}
+
+void ResourceHotReloader::applyReloads()
+{
+	auto alloc = m_manager->getAllocator();
+
+	U i = 0;
+	while(i < m_reloads.getSize())
+	{
+		ReloadBase& reload = *m_reloads[i];
+		const ReloadBase::State state = reload.m_state.load();
+		if(state == ReloadBase::State::LOADING)
+		{
+			++i;
+			continue;
+		}
+
+		const CString filename = reload.getResource().getFilename();
+		if(state == ReloadBase::State::FAILED)
+		{
+			ANKI_RESOURCE_LOGE("Failed to reload: %s", filename.cstr());
+		}
+		else if(reload.apply())
+		{
+			ANKI_RESOURCE_LOGI("Reloaded: %s", filename.cstr());
+		}
+		else
+		{
+			ANKI_RESOURCE_LOGW("Can't reload. Restart to see the changes: %s", filename.cstr());
+		}
+
+		reload.deleteNewer();
+
+		if(reload.m_reloadAgain)
+		{
+			reload.m_reloadAgain = false;
+			submitReload(reload);
+			++i;
+		}
+		else
+		{
+			alloc.deleteInstance(&reload);
+			m_reloads[i] = m_reloads.getBack();
+			m_reloads.resize(alloc, m_reloads.getSize() - 1);
+		}
+	}
+}
+
+} // end namespace anki
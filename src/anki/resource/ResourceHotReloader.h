@@ -0,0 +1,65 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/util/INotify.h>
+#include <anki/util/StringList.h>
+#include <anki/util/DynamicArray.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// Reloads the resources when their files change. It's for development. The ResourceManager creates it only if the
+/// "rsrc.hotReload" option is set.
+///
+/// It watches the data directories and their subdirectories. The new versions of the resources are loaded in the
+/// AsyncLoader and they replace the old ones between frames. The resources keep their addresses so the ResourcePtrs
+/// that others hold stay valid. It supports shader programs (and their includes), textures and generic resources.
+/// Materials, meshes and models are not reloaded. Their users point inside them (to the material variants and the
+/// vertex buffers for example) so a change to their files needs a restart.
+///
+/// The materials get the variants of the reloaded shader programs again. The rest of the users of a shader program
+/// (the renderer passes and the UI for example) keep the programs of their variants so they have to check
+/// ShaderProgramResource::getReloadGeneration() and get the variants again when it changes.
+class ResourceHotReloader
+{
+public:
+	ResourceHotReloader(ResourceManager* manager);
+
+	~ResourceHotReloader();
+
+	ANKI_USE_RESULT Error init();
+
+	/// Apply the reloads that are done and start the reloads of the files that changed. Call it between frames while
+	/// the AsyncLoader is paused.
+	void update();
+
+private:
+	class ReloadBase;
+	template<typename T>
+	class Reload;
+	class ReloadTask;
+
+	ResourceManager* m_manager;
+	INotify m_notify;
+	StringList m_dataDirs; ///< With a slash at the end.
+	DynamicArray<ReloadBase*> m_reloads; ///< The reloads in flight.
+
+	void applyReloads();
+
+	/// Start reloading the resources that use a file.
+	template<typename T>
+	void reloadResources(CString filename);
+
+	void submitReload(ReloadBase& reload);
+};
+/// @}
+
+} // end namespace anki
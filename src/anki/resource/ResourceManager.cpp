@@ -16,6 +16,9 @@
 #include <anki/resource/GenericResource.h>
 #include <anki/resource/TextureAtlasResource.h>
 #include <anki/resource/ShaderProgramResource.h>
+#include <anki/resource/ShaderProgramPreProcessor.h>
+#include <anki/resource/TextureResidency.h>
+#include <anki/resource/ResourceHotReloader.h>
 #include <anki/util/Logger.h>
 #include <anki/misc/ConfigSet.h>
 #include <anki/gr/ShaderCompiler.h>
@@ -29,10 +32,16 @@ ResourceManager::ResourceManager()
 
 ResourceManager::~ResourceManager()
 {
+	// It holds resources and it has tasks in the AsyncLoader so it goes first
+	m_alloc.deleteInstance(m_hotReloader);
+
 	m_cacheDir.destroy(m_alloc);
 	m_alloc.deleteInstance(m_asyncLoader);
 	m_alloc.deleteInstance(m_transferGpuAlloc);
 	m_alloc.deleteInstance(m_shaderCompiler);
+	m_alloc.deleteInstance(m_shaderIncludeCache);
+	m_alloc.deleteInstance(m_textureResidency);
+	m_streamedTextures.destroy(m_alloc);
 }
 
 Error ResourceManager::init(ResourceManagerInitInfo& init)
@@ -51,6 +60,16 @@ Error ResourceManager::init(ResourceManagerInitInfo& init)
 	m_maxTextureSize = init.m_config->getNumber("rsrc.maxTextureSize");
 	m_textureAnisotropy = init.m_config->getNumber("rsrc.textureAnisotropy");
 
+	const PtrSize textureStreamingBudget = init.m_config->getNumber("rsrc.textureStreamingBudget");
+	if(textureStreamingBudget > 0)
+	{
+		m_textureStreamingTailSize = init.m_config->getNumber("rsrc.textureStreamingTailSize");
+		m_textureResidency = m_alloc.newInstance<TextureResidencyManager>(m_alloc);
+		m_textureResidency->init(textureStreamingBudget,
+			init.m_config->getNumber("rsrc.textureStreamingMaxTextureCount"),
+			init.m_config->getNumber("rsrc.textureStreamingMaxChangesInFlight"));
+	}
+
 // Init type resource managers
 //
 #define ANKI_INSTANTIATE_RESOURCE(rsrc_, ptr_) TypeResourceManager<rsrc_>::init(m_alloc);
@@ -63,16 +82,95 @@ Error ResourceManager::init(ResourceManagerInitInfo& init)
 
 	// Init the thread
 	m_asyncLoader = m_alloc.newInstance<AsyncLoader>();
-	m_asyncLoader->init(m_alloc);
+	m_asyncLoader->init(m_alloc, init.m_config->getNumber("rsrc.asyncLoaderThreadCount"));
 
 	m_transferGpuAlloc = m_alloc.newInstance<TransferGpuAllocator>();
 	ANKI_CHECK(m_transferGpuAlloc->init(init.m_config->getNumber("rsrc.transferScratchMemorySize"), m_gr, m_alloc));
 
 	m_shaderCompiler = m_alloc.newInstance<ShaderCompilerCache>(m_alloc, m_cacheDir.toCString());
+	m_shaderIncludeCache = m_alloc.newInstance<ShaderProgramPreprocessorIncludeCache>(m_alloc);
+
+	if(init.m_config->getNumber("rsrc.hotReload"))
+	{
+		ANKI_ASSERT(m_fs);
+		m_hotReloader = m_alloc.newInstance<ResourceHotReloader>(this);
+		ANKI_CHECK(m_hotReloader->init());
+	}
 
 	return Error::NONE;
 }
 
+void ResourceManager::updateTextureStreaming()
+{
+	if(!m_textureResidency)
+	{
+		return;
+	}
+
+	// Keep the textures from being unregistered while their changes are applied and started
+	LockGuard<Mutex> lock(m_textureStreamingMtx);
+
+	for(TextureResource* tex : m_streamedTextures)
+	{
+		tex->applyResidencyChange();
+	}
+	m_streamedTextures.resize(m_alloc, 0);
+
+	DynamicArrayAuto<TextureResidencyChange> changes(m_alloc);
+	m_textureResidency->update(m_textureStreamingFrame++, changes);
+
+	for(const TextureResidencyChange& change : changes)
+	{
+		static_cast<TextureResource*>(change.m_userData)->startResidencyChange(change);
+	}
+}
+
+void ResourceManager::onTextureStreamed(TextureResource* tex)
+{
+	LockGuard<Mutex> lock(m_textureStreamingMtx);
+	m_streamedTextures.emplaceBack(m_alloc, tex);
+}
+
+void ResourceManager::removeStreamedTexture(TextureResource* tex)
+{
+	for(U i = 0; i < m_streamedTextures.getSize(); ++i)
+	{
+		if(m_streamedTextures[i] == tex)
+		{
+			m_streamedTextures[i] = m_streamedTextures[m_streamedTextures.getSize() - 1];
+			m_streamedTextures.resize(m_alloc, m_streamedTextures.getSize() - 1);
+			break;
+		}
+	}
+}
+
+void ResourceManager::unregisterStreamedTexture(TextureResource* tex, U32& residencyHandle)
+{
+	ANKI_ASSERT(m_textureResidency);
+
+	// After that no changes can start or be applied. The handle might be given to another texture
+	{
+		LockGuard<Mutex> lock(m_textureStreamingMtx);
+		m_textureResidency->unregisterTexture(residencyHandle);
+		residencyHandle = INVALID_TEXTURE_RESIDENCY_HANDLE;
+		removeStreamedTexture(tex);
+	}
+
+	// A change may have started before the texture was unregistered. Wait for it and forget its result
+	m_asyncLoader->cancelTasks(static_cast<const ResourceObject*>(tex));
+
+	{
+		LockGuard<Mutex> lock(m_textureStreamingMtx);
+		removeStreamedTexture(tex);
+	}
+}
+
+void ResourceManager::updateHotReloadInternal()
+{
+	ANKI_ASSERT(m_hotReloader);
+	m_hotReloader->update();
+}
+
 U64 ResourceManager::getAsyncTaskCompletedCount() const
 {
 	return m_asyncLoader->getCompletedTaskCount();
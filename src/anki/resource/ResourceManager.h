@@ -6,9 +6,10 @@
 #pragma once
 
 #include <anki/resource/TransferGpuAllocator.h>
-#include <anki/util/List.h>
+#include <anki/util/HashMap.h>
 #include <anki/util/Functions.h>
 #include <anki/util/String.h>
+#include <anki/util/Thread.h>
 
 namespace anki
 {
@@ -21,11 +22,17 @@ class ResourceManager;
 class AsyncLoader;
 class ResourceManagerModel;
 class ShaderCompilerCache;
+class ShaderProgramPreprocessorIncludeCache;
+class TextureResidencyManager;
+class TextureResource;
+class ResourceHotReloader;
 
 /// @addtogroup resource
 /// @{
 
-/// Manage resources of a certain type
+/// Manage resources of a certain type. The resources are indexed by the hash of their filename. The index is split in
+/// shards with their own lock so loads of different resources rarely contend. A resource that is being loaded has an
+/// entry with a null pointer so loads of the same resource from other threads wait for it instead of loading it again.
 template<typename Type>
 class TypeResourceManager
 {
@@ -36,28 +43,105 @@ protected:
 
 	~TypeResourceManager()
 	{
-		ANKI_ASSERT(m_ptrs.isEmpty() && "Forgot to delete some resources");
-		m_ptrs.destroy(m_alloc);
+		for(Shard& shard : m_shards)
+		{
+			ANKI_ASSERT(shard.m_map.getBegin() == shard.m_map.getEnd() && "Forgot to delete some resources");
+			shard.m_map.destroy(m_alloc);
+		}
 	}
 
-	Type* findLoadedResource(const CString& filename)
+	/// Find a loaded resource or start loading it. If another thread is loading the same resource wait for it.
+	/// @return The resource with an extra reference that the caller has to drop. If it's nullptr the caller has to
+	///         load the resource and then call endLoad().
+	Type* findOrBeginLoad(const CString& filename, U64 filenameHash)
 	{
-		auto it = find(filename);
-		return (it != m_ptrs.end()) ? *it : nullptr;
+		Shard& shard = getShard(filenameHash);
+		LockGuard<Mutex> lock(shard.m_mtx);
+
+		while(true)
+		{
+			auto it = shard.m_map.find(filenameHash);
+			if(it == shard.m_map.getEnd())
+			{
+				// Not loaded, the caller will load it
+				shard.m_map.emplace(m_alloc, filenameHash, nullptr);
+				return nullptr;
+			}
+
+			Type* ptr = *it;
+			if(ptr == nullptr)
+			{
+				// Another thread is loading it
+				shard.m_cond.wait(shard.m_mtx);
+				continue;
+			}
+
+			ANKI_ASSERT(ptr->getFilename() == filename && "Filename hash collision");
+			(void)filename;
+
+			if(tryReference(ptr))
+			{
+				return ptr;
+			}
+
+			// It's being deleted. Forget it and load it again
+			shard.m_map.erase(m_alloc, it);
+		}
 	}
 
-	void registerResource(Type* ptr)
+	/// End a load that findOrBeginLoad() started.
+	/// @param filenameHash The hash of the filename.
+	/// @param ptr The loaded resource. It should be referenced already. If it's nullptr the load has failed.
+	void endLoad(U64 filenameHash, Type* ptr)
 	{
-		ANKI_ASSERT(ptr->getRefcount().load() == 0);
-		ANKI_ASSERT(find(ptr->getFilename()) == m_ptrs.getEnd());
-		m_ptrs.pushBack(m_alloc, ptr);
+		ANKI_ASSERT(ptr == nullptr || ptr->getRefcount().load() > 0);
+		Shard& shard = getShard(filenameHash);
+
+		{
+			LockGuard<Mutex> lock(shard.m_mtx);
+			auto it = shard.m_map.find(filenameHash);
+			ANKI_ASSERT(it != shard.m_map.getEnd() && *it == nullptr);
+			if(ptr)
+			{
+				*it = ptr;
+			}
+			else
+			{
+				shard.m_map.erase(m_alloc, it);
+			}
+		}
+
+		shard.m_cond.notifyAll();
+	}
+
+	/// Get all the loaded resources. The resources that are being deleted are skipped.
+	void gatherResources(DynamicArrayAuto<ResourcePtr<Type>>& resources)
+	{
+		for(Shard& shard : m_shards)
+		{
+			LockGuard<Mutex> lock(shard.m_mtx);
+			for(Type* ptr : shard.m_map)
+			{
+				if(ptr && tryReference(ptr))
+				{
+					resources.emplaceBack(ptr);
+					ptr->getRefcount().fetchSub(1);
+				}
+			}
+		}
 	}
 
 	void unregisterResource(Type* ptr)
 	{
-		auto it = find(ptr->getFilename());
-		ANKI_ASSERT(it != m_ptrs.end());
-		m_ptrs.erase(m_alloc, it);
+		Shard& shard = getShard(ptr->getFilenameHash());
+		LockGuard<Mutex> lock(shard.m_mtx);
+
+		// It may be already replaced by findOrBeginLoad()
+		auto it = shard.m_map.find(ptr->getFilenameHash());
+		if(it != shard.m_map.getEnd() && *it == ptr)
+		{
+			shard.m_map.erase(m_alloc, it);
+		}
 	}
 
 	void init(ResourceAllocator<U8> alloc)
@@ -66,24 +150,34 @@ protected:
 	}
 
 private:
-	using Container = List<Type*>;
+	static const U32 SHARD_COUNT_LOG2 = 4;
+
+	class Shard
+	{
+	public:
+		Mutex m_mtx;
+		ConditionVariable m_cond;
+		HashMap<U64, Type*> m_map;
+	};
 
 	ResourceAllocator<U8> m_alloc;
-	Container m_ptrs;
+	Array<Shard, 1u << SHARD_COUNT_LOG2> m_shards;
 
-	typename Container::Iterator find(const CString& filename)
+	Shard& getShard(U64 filenameHash)
 	{
-		typename Container::Iterator it;
+		// Use the high bits, the low ones index the map
+		return m_shards[filenameHash >> (64u - SHARD_COUNT_LOG2)];
+	}
 
-		for(it = m_ptrs.getBegin(); it != m_ptrs.getEnd(); ++it)
+	/// Take a reference unless the last one is being dropped. Call it with the lock of the shard.
+	static Bool tryReference(Type* ptr)
+	{
+		I32 refcount = ptr->getRefcount().load();
+		while(refcount > 0 && !ptr->getRefcount().compareExchange(refcount, refcount + 1))
 		{
-			if((*it)->getFilename() == filename)
-			{
-				break;
-			}
 		}
 
-		return it;
+		return refcount > 0;
 	}
 };
 
@@ -127,6 +221,19 @@ public:
 	template<typename T>
 	ANKI_USE_RESULT Error loadResource(const CString& filename, ResourcePtr<T>& out, Bool async = true);
 
+	/// Make the streamed texture mips visible and start new loads and evictions. Call it once between frames.
+	void updateTextureStreaming();
+
+	/// Reload the resources whose files changed. Call it once between frames while the AsyncLoader is paused. It does
+	/// nothing if the hot reload is disabled.
+	void updateHotReload()
+	{
+		if(ANKI_UNLIKELY(m_hotReloader != nullptr))
+		{
+			updateHotReloadInternal();
+		}
+	}
+
 anki_internal:
 	U32 getMaxTextureSize() const
 	{
@@ -176,18 +283,6 @@ anki_internal:
 		return m_cacheDir;
 	}
 
-	template<typename T>
-	T* findLoadedResource(const CString& filename)
-	{
-		return TypeResourceManager<T>::findLoadedResource(filename);
-	}
-
-	template<typename T>
-	void registerResource(T* ptr)
-	{
-		TypeResourceManager<T>::registerResource(ptr);
-	}
-
 	template<typename T>
 	void unregisterResource(T* ptr)
 	{
@@ -205,15 +300,54 @@ anki_internal:
 		return *m_shaderCompiler;
 	}
 
+	ShaderProgramPreprocessorIncludeCache& getShaderProgramIncludeCache()
+	{
+		ANKI_ASSERT(m_shaderIncludeCache);
+		return *m_shaderIncludeCache;
+	}
+
+	/// Get the manager of the streamed textures. It's nullptr if texture streaming is disabled.
+	TextureResidencyManager* getTextureResidencyManager() const
+	{
+		return m_textureResidency;
+	}
+
+	/// The max size of the mips that a streamed texture starts with.
+	U32 getTextureStreamingTailSize() const
+	{
+		return m_textureStreamingTailSize;
+	}
+
+	/// A TextureResource calls it when a StreamTask is done. It's thread-safe.
+	void onTextureStreamed(TextureResource* tex);
+
+	/// Stop streaming a texture. Call it before deleting the texture. It's thread-safe.
+	/// @param[in,out] residencyHandle The handle of the texture. It's invalidated.
+	void unregisterStreamedTexture(TextureResource* tex, U32& residencyHandle);
+
 	/// Get the number of times loadResource() was called.
 	U64 getLoadingRequestCount() const
 	{
-		return m_loadRequestCount;
+		return m_loadRequestCount.load();
 	}
 
 	/// Get the total number of completed async tasks.
 	U64 getAsyncTaskCompletedCount() const;
 
+	/// Get all the loaded resources of a type.
+	template<typename T>
+	void gatherResources(DynamicArrayAuto<ResourcePtr<T>>& resources)
+	{
+		TypeResourceManager<T>::gatherResources(resources);
+	}
+
+	/// Load a resource that is not registered to the manager. The hot reload loads the new versions of the resources
+	/// with it.
+	/// @param filename The file to load.
+	/// @param[out] out The new resource. Delete it with the allocator of the manager.
+	template<typename T>
+	ANKI_USE_RESULT Error loadUnregisteredResource(const CString& filename, T*& out);
+
 private:
 	GrManager* m_gr = nullptr;
 	PhysicsWorld* m_physics = nullptr;
@@ -224,10 +358,36 @@ private:
 	U32 m_maxTextureSize;
 	U32 m_textureAnisotropy;
 	AsyncLoader* m_asyncLoader = nullptr; ///< Async loading thread
-	U64 m_uuid = 0;
-	U64 m_loadRequestCount = 0;
+	Atomic<U64> m_uuid = {0};
+	Atomic<U64> m_loadRequestCount = {0};
+
+	/// Protects the reset of the m_tmpAlloc.
+	Mutex m_tmpAllocMtx;
+	U32 m_loadsInProgress = 0; ///< The loads that may use the m_tmpAlloc.
+	U32 m_tmpAllocCountBeforeLoads = 0;
 	TransferGpuAllocator* m_transferGpuAlloc = nullptr;
 	ShaderCompilerCache* m_shaderCompiler = nullptr;
+	ShaderProgramPreprocessorIncludeCache* m_shaderIncludeCache = nullptr;
+
+	/// @name Texture streaming
+	/// @{
+	TextureResidencyManager* m_textureResidency = nullptr;
+	U32 m_textureStreamingTailSize = 0;
+	U64 m_textureStreamingFrame = 0;
+	Mutex m_textureStreamingMtx;
+	DynamicArray<TextureResource*> m_streamedTextures; ///< The textures that wait for applyResidencyChange().
+	/// @}
+
+	ResourceHotReloader* m_hotReloader = nullptr; ///< It's nullptr if the hot reload is disabled.
+
+	/// Forget a texture that waits for applyResidencyChange(). Call it with m_textureStreamingMtx locked.
+	void removeStreamedTexture(TextureResource* tex);
+
+	void updateHotReloadInternal();
+
+	/// Call the load() of a resource. It keeps the temp allocator from being reset while other loads are using it.
+	template<typename T>
+	ANKI_USE_RESULT Error loadResourceObject(T& rsrc, const CString& filename, Bool async);
 };
 /// @}
 
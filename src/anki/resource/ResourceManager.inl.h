@@ -14,14 +14,16 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 	ANKI_ASSERT(!out.isCreated() && "Already loaded");
 
 	Error err = Error::NONE;
-	++m_loadRequestCount;
+	m_loadRequestCount.fetchAdd(1);
 
-	T* const other = findLoadedResource<T>(filename);
+	const U64 filenameHash = T::computeFilenameHash(filename);
+	T* const other = TypeResourceManager<T>::findOrBeginLoad(filename, filenameHash);
 
 	if(other)
 	{
-		// Found
+		// Found. Drop the reference of findOrBeginLoad()
 		out.reset(other);
+		other->getRefcount().fetchSub(1);
 	}
 	else
 	{
@@ -29,37 +31,77 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 		T* ptr = m_alloc.newInstance<T>(this);
 		ANKI_ASSERT(ptr->getRefcount().load() == 0);
 
-		// Populate the ptr. Use a block to cleanup temp_pool allocations
-		auto& pool = m_tmpAlloc.getMemoryPool();
+		// Populate the ptr
+		err = loadResourceObject(*ptr, filename, async);
 
+		if(err)
 		{
-			U allocsCountBefore = pool.getAllocationsCount();
-			(void)allocsCountBefore;
+			ANKI_RESOURCE_LOGE("Failed to load resource: %s", &filename[0]);
+			m_alloc.deleteInstance(ptr);
+			TypeResourceManager<T>::endLoad(filenameHash, nullptr);
+			return err;
+		}
 
-			err = ptr->load(filename, async);
-			if(err)
-			{
-				ANKI_RESOURCE_LOGE("Failed to load resource: %s", &filename[0]);
-				m_alloc.deleteInstance(ptr);
-				return err;
-			}
+		ptr->setFilename(filename);
+		ptr->setUuid(m_uuid.fetchAdd(1) + 1);
+
+		// Register resource. Reference it first so it's not taken for a resource that is being deleted
+		out.reset(ptr);
+		TypeResourceManager<T>::endLoad(filenameHash, ptr);
+	}
+
+	return err;
+}
+
+template<typename T>
+Error ResourceManager::loadUnregisteredResource(const CString& filename, T*& out)
+{
+	T* ptr = m_alloc.newInstance<T>(this);
+
+	const Error err = loadResourceObject(*ptr, filename, false);
+	if(err)
+	{
+		ANKI_RESOURCE_LOGE("Failed to load resource: %s", &filename[0]);
+		m_alloc.deleteInstance(ptr);
+		return err;
+	}
 
-			ANKI_ASSERT(pool.getAllocationsCount() == allocsCountBefore && "Forgot to deallocate");
+	ptr->setFilename(filename);
+	ptr->setUuid(m_uuid.fetchAdd(1) + 1);
+	out = ptr;
+	return Error::NONE;
+}
+
+template<typename T>
+Error ResourceManager::loadResourceObject(T& rsrc, const CString& filename, Bool async)
+{
+	// Other threads may use the temp pool at the same time so it's reset only when all loads are done
+	auto& pool = m_tmpAlloc.getMemoryPool();
+
+	{
+		LockGuard<Mutex> lock(m_tmpAllocMtx);
+		if(m_loadsInProgress++ == 0)
+		{
+			m_tmpAllocCountBeforeLoads = pool.getAllocationsCount();
 		}
+	}
 
-		ptr->setFilename(filename);
-		ptr->setUuid(++m_uuid);
+	const Error err = rsrc.load(filename, async);
+
+	{
+		LockGuard<Mutex> lock(m_tmpAllocMtx);
+		ANKI_ASSERT(m_loadsInProgress > 0);
+		--m_loadsInProgress;
 
-		// Reset the memory pool if no-one is using it.
 		// NOTE: Check because resources load other resources
-		if(pool.getAllocationsCount() == 0)
+		if(m_loadsInProgress == 0)
 		{
-			pool.reset();
+			ANKI_ASSERT(pool.getAllocationsCount() == m_tmpAllocCountBeforeLoads && "Forgot to deallocate");
+			if(pool.getAllocationsCount() == 0)
+			{
+				pool.reset();
+			}
 		}
-
-		// Register resource
-		registerResource(ptr);
-		out.reset(ptr);
 	}
 
 	return err;
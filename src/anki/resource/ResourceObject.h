@@ -9,6 +9,7 @@
 #include <anki/resource/ResourceFilesystem.h>
 #include <anki/util/Atomic.h>
 #include <anki/util/String.h>
+#include <anki/util/Hash.h>
 
 namespace anki
 {
@@ -59,6 +60,20 @@ anki_internal:
 	{
 		ANKI_ASSERT(m_fname.isEmpty());
 		m_fname.create(getAllocator(), fname);
+		m_fnameHash = computeFilenameHash(fname);
+	}
+
+	/// The hash that identifies the resource in the ResourceManager.
+	U64 getFilenameHash() const
+	{
+		ANKI_ASSERT(!m_fname.isEmpty());
+		return m_fnameHash;
+	}
+
+	static U64 computeFilenameHash(const CString& fname)
+	{
+		ANKI_ASSERT(!fname.isEmpty());
+		return computeHash(&fname[0], fname.getLength());
 	}
 
 	void setUuid(U64 uuid)
@@ -84,6 +99,7 @@ private:
 	ResourceManager* m_manager;
 	Atomic<I32> m_refcount;
 	String m_fname; ///< Unique resource name.
+	U64 m_fnameHash = 0;
 	U64 m_uuid = 0;
 };
 /// @}
@@ -5,6 +5,8 @@
 
 #include <anki/resource/ShaderProgramPreProcessor.h>
 #include <anki/resource/ResourceFilesystem.h>
+#include <anki/util/Hash.h>
+#include <cstring>
 
 namespace anki
 {
@@ -98,6 +100,108 @@ static ANKI_USE_RESULT Error computeShaderVariableDataType(const CString& str, S
 	return err;
 }
 
+ShaderProgramPreprocessorIncludeCache::~ShaderProgramPreprocessorIncludeCache()
+{
+	for(ShaderProgramPreprocessorSourceFile* file : m_files)
+	{
+		deleteFile(file);
+	}
+	m_files.destroy(m_alloc);
+
+	for(ShaderProgramPreprocessorSourceFile* file : m_staleFiles)
+	{
+		deleteFile(file);
+	}
+	m_staleFiles.destroy(m_alloc);
+}
+
+void ShaderProgramPreprocessorIncludeCache::deleteFile(ShaderProgramPreprocessorSourceFile* file)
+{
+	file->m_filename.destroy(m_alloc);
+	file->m_text.destroy(m_alloc);
+	file->m_lines.destroy(m_alloc);
+	m_alloc.deleteInstance(file);
+}
+
+Error ShaderProgramPreprocessorIncludeCache::getFile(
+	const CString& filename, ResourceFilesystem& fsystem, const ShaderProgramPreprocessorSourceFile*& file)
+{
+	ResourceFilePtr rfile;
+	ANKI_CHECK(fsystem.openFile(filename, rfile));
+	const U64 modificationTime = rfile->getModificationTime();
+	const U64 key = filename.computeHash();
+
+	// Search the cache
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		auto it = m_files.find(key);
+		if(it != m_files.getEnd() && (*it)->m_filename == filename && (*it)->m_modificationTime == modificationTime)
+		{
+			m_hitCount.fetchAdd(1);
+			file = *it;
+			return Error::NONE;
+		}
+	}
+
+	// Not there or stale, read it without holding the lock
+	StringAuto txt(m_alloc);
+	ANKI_CHECK(rfile->readAllText(m_alloc, txt));
+
+	ShaderProgramPreprocessorSourceFile* newFile = m_alloc.newInstance<ShaderProgramPreprocessorSourceFile>();
+	newFile->m_filename.create(m_alloc, filename);
+	newFile->m_modificationTime = modificationTime;
+
+	if(!txt.isEmpty())
+	{
+		newFile->m_hash = computeHash(txt.cstr(), txt.getLength());
+
+		// Terminate the lines and remember where the non-empty ones start
+		newFile->m_text.create(m_alloc, txt.getLength() + 1);
+		memcpy(&newFile->m_text[0], txt.cstr(), txt.getLength() + 1);
+
+		DynamicArrayAuto<ShaderProgramPreprocessorSourceFile::Line> lines(m_alloc);
+		U32 lineBegin = 0;
+		for(U32 i = 0; i < newFile->m_text.getSize(); ++i)
+		{
+			char& c = newFile->m_text[i];
+			if(c != '\n' && c != '\0')
+			{
+				continue;
+			}
+
+			c = '\0';
+			if(i > lineBegin)
+			{
+				const CString line(&newFile->m_text[lineBegin]);
+				lines.emplaceBack();
+				lines.getBack().m_offset = lineBegin;
+				lines.getBack().m_maybeDirective =
+					line.find("pragma") != CString::NPOS || line.find("include") != CString::NPOS;
+			}
+			lineBegin = i + 1;
+		}
+
+		if(lines.getSize())
+		{
+			newFile->m_lines.create(m_alloc, lines.getSize());
+			memcpy(&newFile->m_lines[0], &lines[0], lines.getSizeInBytes());
+		}
+	}
+
+	// Add it. Another thread might have added it in the meantime, it doesn't matter which one wins
+	LockGuard<Mutex> lock(m_mtx);
+	auto it = m_files.find(key);
+	if(it != m_files.getEnd())
+	{
+		m_staleFiles.emplaceBack(m_alloc, *it);
+		m_files.erase(m_alloc, it);
+	}
+	m_files.emplace(m_alloc, key, newFile);
+
+	file = newFile;
+	return Error::NONE;
+}
+
 Error ShaderProgramPreprocessor::parse()
 {
 	ANKI_ASSERT(!m_fname.isEmpty());
@@ -213,31 +317,32 @@ Error ShaderProgramPreprocessor::parseFile(CString fname, U32 depth)
 
 	Bool foundPragmaOnce = false;
 
-	// Load file in lines
-	ResourceFilePtr file;
-	ANKI_CHECK(m_fsystem->openFile(fname, file));
-	StringAuto txt(m_alloc);
-	ANKI_CHECK(file->readAllText(m_alloc, txt));
+	// Get the file split in lines
+	const ShaderProgramPreprocessorSourceFile* file;
+	ANKI_CHECK(m_includeCache->getFile(fname, *m_fsystem, file));
 
-	StringListAuto lines(m_alloc);
-	lines.splitString(txt.toCString(), '\n');
-	if(lines.getSize() < 1)
+	m_dependencies.emplaceBack(m_alloc);
+	m_dependencies.getBack().m_filename.create(fname);
+	m_dependencies.getBack().m_hash = file->m_hash;
+
+	if(file->m_lines.getSize() < 1)
 	{
 		ANKI_PP_ERROR("Source is empty");
 	}
 
 	// Parse lines
-	for(const String& line : lines)
+	for(U32 i = 0; i < file->m_lines.getSize(); ++i)
 	{
-		if(line.find("pragma") != CString::NPOS || line.find("include") != CString::NPOS)
+		const CString line = file->getLine(i);
+		if(file->m_lines[i].m_maybeDirective)
 		{
 			// Possibly a preprocessor directive we care
-			ANKI_CHECK(parseLine(line.toCString(), fname, foundPragmaOnce, depth));
+			ANKI_CHECK(parseLine(line, fname, foundPragmaOnce, depth));
 		}
 		else
 		{
 			// Just append the line
-			m_lines.pushBack(line.toCString());
+			m_lines.pushBack(line);
 		}
 	}
 
@@ -253,12 +358,11 @@ Error ShaderProgramPreprocessor::parseFile(CString fname, U32 depth)
 Error ShaderProgramPreprocessor::parseLine(CString line, CString fname, Bool& foundPragmaOnce, U32 depth)
 {
 	// Tokenize
-	DynamicArrayAuto<StringAuto> tokens(m_alloc);
-	tokenizeLine(line, tokens);
+	const ConstWeakArray<CString> tokens = tokenizeLine(line);
 	ANKI_ASSERT(tokens.getSize() > 0);
 
-	const StringAuto* token = tokens.getBegin();
-	const StringAuto* end = tokens.getEnd();
+	const CString* token = tokens.getBegin();
+	const CString* end = tokens.getEnd();
 
 	// Skip the hash
 	Bool foundAloneHash = false;
@@ -279,7 +383,12 @@ Error ShaderProgramPreprocessor::parseLine(CString line, CString fname, Bool& fo
 
 		++token;
 
-		if(*token == "once")
+		if(token == end)
+		{
+			// Ignore
+			m_lines.pushBack(line);
+		}
+		else if(*token == "once")
 		{
 			// Pragma once
 
@@ -304,7 +413,11 @@ Error ShaderProgramPreprocessor::parseLine(CString line, CString fname, Bool& fo
 
 			++token;
 
-			if(*token == "mutator")
+			if(token == end)
+			{
+				ANKI_PP_ERROR_MALFORMED();
+			}
+			else if(*token == "mutator")
 			{
 				ANKI_CHECK(parsePragmaMutator(token + 1, end, line, fname));
 			}
@@ -345,7 +458,7 @@ Error ShaderProgramPreprocessor::parseLine(CString line, CString fname, Bool& fo
 }
 
 Error ShaderProgramPreprocessor::parseInclude(
-	const StringAuto* begin, const StringAuto* end, CString line, CString fname, U32 depth)
+	const CString* begin, const CString* end, CString line, CString fname, U32 depth)
 {
 	// Gather the path
 	StringAuto path(m_alloc);
@@ -382,7 +495,7 @@ Error ShaderProgramPreprocessor::parseInclude(
 }
 
 Error ShaderProgramPreprocessor::parsePragmaMutator(
-	const StringAuto* begin, const StringAuto* end, CString line, CString fname)
+	const CString* begin, const CString* end, CString line, CString fname)
 {
 	ANKI_ASSERT(begin && end);
 
@@ -432,7 +545,7 @@ Error ShaderProgramPreprocessor::parsePragmaMutator(
 			}
 		}
 
-		mutator.m_name.create(begin->toCString());
+		mutator.m_name.create(*begin);
 		++begin;
 	}
 
@@ -443,7 +556,7 @@ Error ShaderProgramPreprocessor::parsePragmaMutator(
 		{
 			Mutator::ValueType value = 0;
 
-			if(tokenIsComment(begin->toCString()))
+			if(tokenIsComment(*begin))
 			{
 				break;
 			}
@@ -480,7 +593,7 @@ Error ShaderProgramPreprocessor::parsePragmaMutator(
 }
 
 Error ShaderProgramPreprocessor::parsePragmaInput(
-	const StringAuto* begin, const StringAuto* end, CString line, CString fname)
+	const CString* begin, const CString* end, CString line, CString fname)
 {
 	ANKI_ASSERT(begin && end);
 
@@ -519,14 +632,14 @@ Error ShaderProgramPreprocessor::parsePragmaInput(
 	}
 
 	// type
-	const StringAuto& dataTypeStr = *begin;
+	if(begin >= end)
 	{
-		if(begin >= end)
-		{
-			ANKI_PP_ERROR_MALFORMED();
-		}
+		ANKI_PP_ERROR_MALFORMED();
+	}
 
-		if(computeShaderVariableDataType(begin->toCString(), input.m_dataType))
+	const CString dataTypeStr = *begin;
+	{
+		if(computeShaderVariableDataType(*begin, input.m_dataType))
 		{
 			ANKI_PP_ERROR_MALFORMED();
 		}
@@ -549,7 +662,7 @@ Error ShaderProgramPreprocessor::parsePragmaInput(
 			}
 		}
 
-		input.m_name.create(begin->toCString());
+		input.m_name.create(*begin);
 		++begin;
 	}
 
@@ -559,7 +672,7 @@ Error ShaderProgramPreprocessor::parsePragmaInput(
 		// Create the string
 		for(; begin < end; ++begin)
 		{
-			preproc.append(begin->toCString());
+			preproc.append(*begin);
 		}
 
 		if(!preproc.isEmpty())
@@ -613,9 +726,9 @@ Error ShaderProgramPreprocessor::parsePragmaInput(
 		}
 
 		m_globalsLines.pushBackSprintf("const %s %s = %s(%s_CONSTVAL);",
-			dataTypeStr.cstr(),
+			dataTypeStr.get(),
 			input.m_name.cstr(),
-			dataTypeStr.cstr(),
+			dataTypeStr.get(),
 			input.m_name.cstr());
 
 		if(preproc)
@@ -643,7 +756,7 @@ Error ShaderProgramPreprocessor::parsePragmaInput(
 
 		m_globalsLines.pushBackSprintf("layout(ANKI_TEX_BINDING(GEN_SET_, %s_TEXUNIT)) uniform %s %s;",
 			input.m_name.cstr(),
-			dataTypeStr.cstr(),
+			dataTypeStr.get(),
 			input.m_name.cstr());
 
 		if(preproc)
@@ -658,7 +771,7 @@ Error ShaderProgramPreprocessor::parsePragmaInput(
 		// UBO
 
 		const char* name = input.m_name.cstr();
-		const char* type = dataTypeStr.cstr();
+		const char* type = dataTypeStr.get();
 
 		if(preproc)
 		{
@@ -704,7 +817,7 @@ Error ShaderProgramPreprocessor::parsePragmaInput(
 }
 
 Error ShaderProgramPreprocessor::parsePragmaStart(
-	const StringAuto* begin, const StringAuto* end, CString line, CString fname)
+	const CString* begin, const CString* end, CString line, CString fname)
 {
 	ANKI_ASSERT(begin && end);
 
@@ -775,7 +888,7 @@ Error ShaderProgramPreprocessor::parsePragmaStart(
 }
 
 Error ShaderProgramPreprocessor::parsePragmaEnd(
-	const StringAuto* begin, const StringAuto* end, CString line, CString fname)
+	const CString* begin, const CString* end, CString line, CString fname)
 {
 	ANKI_ASSERT(begin && end);
 
@@ -799,7 +912,7 @@ Error ShaderProgramPreprocessor::parsePragmaEnd(
 }
 
 Error ShaderProgramPreprocessor::parsePragmaDescriptorSet(
-	const StringAuto* begin, const StringAuto* end, CString line, CString fname)
+	const CString* begin, const CString* end, CString line, CString fname)
 {
 	ANKI_ASSERT(begin && end);
 
@@ -821,31 +934,44 @@ Error ShaderProgramPreprocessor::parsePragmaDescriptorSet(
 	return Error::NONE;
 }
 
-void ShaderProgramPreprocessor::tokenizeLine(CString line, DynamicArrayAuto<StringAuto>& tokens)
+ConstWeakArray<CString> ShaderProgramPreprocessor::tokenizeLine(CString line)
 {
 	ANKI_ASSERT(line.getLength() > 0);
+	const U32 length = line.getLength();
 
-	StringAuto l(m_alloc);
-	l.create(line);
+	// Copy the line and terminate every token in place. The buffers only grow so most lines don't allocate
+	if(m_tokenChars.getSize() < length + 1)
+	{
+		m_tokenChars.resize(length + 1);
+	}
 
-	// Replace all tabs with spaces
-	for(char& c : l)
+	U32 tokenCount = 0;
+	Bool insideToken = false;
+	for(U32 i = 0; i <= length; ++i)
 	{
-		if(c == '\t')
+		const char c = line.get()[i];
+		if(c == ' ' || c == '\t' || c == '\0')
 		{
-			c = ' ';
+			m_tokenChars[i] = '\0';
+			insideToken = false;
 		}
-	}
-
-	// Split
-	StringListAuto spaceTokens(m_alloc);
-	spaceTokens.splitString(l.toCString(), ' ', false);
+		else
+		{
+			m_tokenChars[i] = c;
+			if(!insideToken)
+			{
+				if(tokenCount == m_tokens.getSize())
+				{
+					m_tokens.emplaceBack();
+				}
 
-	// Create the array
-	for(const String& s : spaceTokens)
-	{
-		tokens.emplaceBack(m_alloc, s.toCString());
+				m_tokens[tokenCount++] = CString(&m_tokenChars[i]);
+				insideToken = true;
+			}
+		}
 	}
+
+	return (tokenCount) ? ConstWeakArray<CString>(&m_tokens[0], tokenCount) : ConstWeakArray<CString>();
 }
 
 } // end namespace anki
\ No newline at end of file
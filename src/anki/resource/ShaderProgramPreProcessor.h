@@ -8,6 +8,8 @@
 #include <anki/resource/Common.h>
 #include <anki/util/StringList.h>
 #include <anki/util/WeakArray.h>
+#include <anki/util/HashMap.h>
+#include <anki/util/Thread.h>
 #include <anki/gr/Common.h>
 
 namespace anki
@@ -99,6 +101,98 @@ private:
 	Bool8 m_instanced = false;
 };
 
+/// A file that the ShaderProgramPreprocessor read.
+/// @memberof ShaderProgramPreprocessor
+class ShaderProgramPreprocessorDependency
+{
+	friend ShaderProgramPreprocessor;
+
+public:
+	ShaderProgramPreprocessorDependency(GenericMemoryPoolAllocator<U8> alloc)
+		: m_filename(alloc)
+	{
+	}
+
+	CString getFilename() const
+	{
+		return m_filename.toCString();
+	}
+
+	/// The hash of the contents of the file.
+	U64 getHash() const
+	{
+		return m_hash;
+	}
+
+private:
+	StringAuto m_filename;
+	U64 m_hash = 0;
+};
+
+/// A file that the ShaderProgramPreprocessor read. It's split into lines once and it's immutable after that so many
+/// preprocessors can share it.
+/// @memberof ShaderProgramPreprocessorIncludeCache
+class ShaderProgramPreprocessorSourceFile
+{
+	friend class ShaderProgramPreprocessorIncludeCache;
+	friend class ShaderProgramPreprocessor;
+
+private:
+	class Line
+	{
+	public:
+		U32 m_offset; ///< Where the line starts in m_text.
+		Bool8 m_maybeDirective; ///< It might be a directive the preprocessor cares about.
+	};
+
+	String m_filename;
+	DynamicArray<char> m_text; ///< The contents with the newlines replaced by terminators.
+	DynamicArray<Line> m_lines; ///< The non-empty lines.
+	U64 m_hash = 0; ///< The hash of the contents.
+	U64 m_modificationTime = 0;
+
+	CString getLine(U32 i) const
+	{
+		return CString(&m_text[m_lines[i].m_offset]);
+	}
+};
+
+/// Caches the files that the ShaderProgramPreprocessor reads so the common headers are read and split into lines only
+/// once. A file is read again if its modification time changed. It's thread-safe.
+class ShaderProgramPreprocessorIncludeCache : public NonCopyable
+{
+public:
+	ShaderProgramPreprocessorIncludeCache(GenericMemoryPoolAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	~ShaderProgramPreprocessorIncludeCache();
+
+	/// Get a file from the cache or read it.
+	/// @param filename The file.
+	/// @param fsystem The filesystem to read the file from.
+	/// @param[out] file The file. It's valid for as long as the cache is alive.
+	ANKI_USE_RESULT Error getFile(
+		const CString& filename, ResourceFilesystem& fsystem, const ShaderProgramPreprocessorSourceFile*& file);
+
+	/// Get the number of times getFile() found the file in the cache.
+	U32 getHitCount() const
+	{
+		return m_hitCount.load();
+	}
+
+private:
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	HashMap<U64, ShaderProgramPreprocessorSourceFile*> m_files;
+	/// Files that were replaced. They are kept because some preprocessor might still use them.
+	DynamicArray<ShaderProgramPreprocessorSourceFile*> m_staleFiles;
+	Mutex m_mtx;
+	Atomic<U32> m_hitCount = {0};
+
+	void deleteFile(ShaderProgramPreprocessorSourceFile* file);
+};
+
 /// This is a special preprocessor that run before the usual preprocessor. Its purpose is to add some meta information
 /// in the shader programs.
 ///
@@ -113,16 +207,29 @@ private:
 class ShaderProgramPreprocessor : public NonCopyable
 {
 public:
-	ShaderProgramPreprocessor(CString fname, ResourceFilesystem* fsystem, GenericMemoryPoolAllocator<U8> alloc)
+	/// @param fname The file of the program.
+	/// @param fsystem The filesystem to read the files from.
+	/// @param alloc The allocator of the preprocessor.
+	/// @param includeCache An include cache to share with other preprocessors. If it's nullptr the preprocessor uses
+	///                     its own.
+	ShaderProgramPreprocessor(CString fname,
+		ResourceFilesystem* fsystem,
+		GenericMemoryPoolAllocator<U8> alloc,
+		ShaderProgramPreprocessorIncludeCache* includeCache = nullptr)
 		: m_alloc(alloc)
 		, m_fname(alloc, fname)
 		, m_fsystem(fsystem)
+		, m_localIncludeCache(alloc)
+		, m_includeCache((includeCache) ? includeCache : &m_localIncludeCache)
+		, m_tokenChars(alloc)
+		, m_tokens(alloc)
 		, m_lines(alloc)
 		, m_globalsLines(alloc)
 		, m_uboStructLines(alloc)
 		, m_finalSource(alloc)
 		, m_mutators(alloc)
 		, m_inputs(alloc)
+		, m_dependencies(alloc)
 	{
 	}
 
@@ -158,6 +265,12 @@ public:
 		return m_set;
 	}
 
+	/// Get the main file and the files it included.
+	ConstWeakArray<ShaderProgramPreprocessorDependency> getDependencies() const
+	{
+		return m_dependencies;
+	}
+
 private:
 	using Mutator = ShaderProgramPreprocessorMutator;
 	using Input = ShaderProgramPreprocessorInput;
@@ -167,6 +280,11 @@ private:
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	StringAuto m_fname;
 	ResourceFilesystem* m_fsystem = nullptr;
+	ShaderProgramPreprocessorIncludeCache m_localIncludeCache;
+	ShaderProgramPreprocessorIncludeCache* m_includeCache = nullptr;
+
+	DynamicArrayAuto<char> m_tokenChars; ///< The chars of the tokens of the last tokenized line.
+	DynamicArrayAuto<CString> m_tokens; ///< The tokens of the last tokenized line.
 
 	StringListAuto m_lines; ///< The code.
 	StringListAuto m_globalsLines;
@@ -175,6 +293,7 @@ private:
 
 	DynamicArrayAuto<Mutator> m_mutators;
 	DynamicArrayAuto<Input> m_inputs;
+	DynamicArrayAuto<ShaderProgramPreprocessorDependency> m_dependencies;
 
 	ShaderTypeBit m_shaderTypes = ShaderTypeBit::NONE;
 	Bool8 m_insideShader = false;
@@ -185,16 +304,16 @@ private:
 	ANKI_USE_RESULT Error parseFile(CString fname, U32 depth);
 	ANKI_USE_RESULT Error parseLine(CString line, CString fname, Bool& foundPragmaOnce, U32 depth);
 	ANKI_USE_RESULT Error parseInclude(
-		const StringAuto* begin, const StringAuto* end, CString line, CString fname, U32 depth);
-	ANKI_USE_RESULT Error parsePragmaMutator(
-		const StringAuto* begin, const StringAuto* end, CString line, CString fname);
-	ANKI_USE_RESULT Error parsePragmaInput(const StringAuto* begin, const StringAuto* end, CString line, CString fname);
-	ANKI_USE_RESULT Error parsePragmaStart(const StringAuto* begin, const StringAuto* end, CString line, CString fname);
-	ANKI_USE_RESULT Error parsePragmaEnd(const StringAuto* begin, const StringAuto* end, CString line, CString fname);
+		const CString* begin, const CString* end, CString line, CString fname, U32 depth);
+	ANKI_USE_RESULT Error parsePragmaMutator(const CString* begin, const CString* end, CString line, CString fname);
+	ANKI_USE_RESULT Error parsePragmaInput(const CString* begin, const CString* end, CString line, CString fname);
+	ANKI_USE_RESULT Error parsePragmaStart(const CString* begin, const CString* end, CString line, CString fname);
+	ANKI_USE_RESULT Error parsePragmaEnd(const CString* begin, const CString* end, CString line, CString fname);
 	ANKI_USE_RESULT Error parsePragmaDescriptorSet(
-		const StringAuto* begin, const StringAuto* end, CString line, CString fname);
+		const CString* begin, const CString* end, CString line, CString fname);
 
-	void tokenizeLine(CString line, DynamicArrayAuto<StringAuto>& tokens);
+	/// Split a line to tokens without allocating per token. The tokens are valid until the next call.
+	ConstWeakArray<CString> tokenizeLine(CString line);
 
 	static Bool tokenIsComment(CString token)
 	{
@@ -7,7 +7,10 @@
 #include <anki/resource/RenderingKey.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/util/Filesystem.h>
+#include <anki/util/File.h>
+#include <anki/util/Hash.h>
 #include <tinyexpr.h>
+#include <cstring>
 
 namespace anki
 {
@@ -135,25 +138,173 @@ Bool ShaderProgramResourceInputVariable::acceptAllMutations(
 	return false;
 }
 
+/// The magic of the files that ShaderProgramResource keeps in the cache directory. Bump it when the format changes.
+static const char* SHADER_PROGRAM_CACHE_MAGIC = "ANKISPC1";
+
+/// Writes a ShaderProgramResource cache file.
+class ShaderProgramCacheWriter
+{
+public:
+	File m_file;
+	Error m_err = Error::NONE;
+
+	template<typename T>
+	void write(const T& t)
+	{
+		writeBytes(&t, sizeof(t));
+	}
+
+	void writeBytes(const void* data, PtrSize size)
+	{
+		if(!m_err && size)
+		{
+			m_err = m_file.write(data, size);
+		}
+	}
+
+	void writeString(const String& str)
+	{
+		const U32 len = U32(str.getLength());
+		write(len);
+		if(len)
+		{
+			writeBytes(str.cstr(), len);
+		}
+	}
+};
+
+/// Reads a ShaderProgramResource cache file. Reading past the end fails and every read after that fails too.
+class ShaderProgramCacheReader
+{
+public:
+	ConstWeakArray<U8> m_data;
+	PtrSize m_pos = 0;
+	Bool m_failed = false;
+
+	ShaderProgramCacheReader(ConstWeakArray<U8> data)
+		: m_data(data)
+	{
+	}
+
+	template<typename T>
+	T read()
+	{
+		T t = T();
+		readBytes(&t, sizeof(t));
+		return t;
+	}
+
+	void readBytes(void* out, PtrSize size)
+	{
+		m_failed = m_failed || size > m_data.getSize() - m_pos;
+		if(!m_failed && size)
+		{
+			memcpy(out, m_data.getBegin() + m_pos, size);
+			m_pos += size;
+		}
+	}
+
+	template<typename TAlloc>
+	void readString(TAlloc alloc, String& out)
+	{
+		const U32 len = read<U32>();
+		m_failed = m_failed || len > m_data.getSize() - m_pos;
+		if(!m_failed && len)
+		{
+			const char* begin = reinterpret_cast<const char*>(m_data.getBegin() + m_pos);
+			out.create(alloc, begin, begin + len);
+			m_pos += len;
+		}
+	}
+
+	/// Check that there is enough data for a number of elements before allocating them.
+	Bool hasRoomFor(U32 count, PtrSize elementSize)
+	{
+		m_failed = m_failed || count * elementSize > m_data.getSize() - m_pos;
+		return !m_failed;
+	}
+};
+
 ShaderProgramResource::ShaderProgramResource(ResourceManager* manager)
 	: ResourceObject(manager)
 {
 }
 
 ShaderProgramResource::~ShaderProgramResource()
+{
+	if(m_cacheDirty)
+	{
+		// New variants were created, store them for the next run
+		writeCache();
+	}
+
+	destroy();
+}
+
+void ShaderProgramResource::deleteVariant(ShaderProgramResourceVariant* variant) const
+{
+	auto alloc = getAllocator();
+	variant->m_blockInfos.destroy(alloc);
+	variant->m_texUnits.destroy(alloc);
+	variant->m_shaderHeader.destroy(alloc);
+	alloc.deleteInstance(variant);
+}
+
+void ShaderProgramResource::destroyVariants(Bool retire)
 {
 	auto alloc = getAllocator();
 
-	while(!m_variants.isEmpty())
+	VariantTable* table = m_variants.load();
+	if(table)
+	{
+		for(U32 i = 0; i < table->m_capacity; ++i)
+		{
+			if(!table->m_slots[i].m_hash.load())
+			{
+				continue;
+			}
+
+			if(retire)
+			{
+				m_retiredVariants.emplaceBack(alloc, table->m_slots[i].m_variant);
+			}
+			else
+			{
+				deleteVariant(table->m_slots[i].m_variant);
+			}
+		}
+	}
+
+	while(table)
 	{
-		auto it = m_variants.getBegin();
+		VariantTable* prev = table->m_prev;
+		alloc.deleteArray(table->m_slots, table->m_capacity);
+		alloc.deleteInstance(table);
+		table = prev;
+	}
+	m_variants.store(nullptr);
+
+	while(!m_cachedVariants.isEmpty())
+	{
+		auto it = m_cachedVariants.getBegin();
 		ShaderProgramResourceVariant* variant = *it;
-		m_variants.erase(getAllocator(), it);
+		m_cachedVariants.erase(alloc, it);
+		deleteVariant(variant);
+	}
+	m_cachedVariants.destroy(alloc);
+}
+
+void ShaderProgramResource::destroy()
+{
+	auto alloc = getAllocator();
 
-		variant->m_blockInfos.destroy(alloc);
-		variant->m_texUnits.destroy(alloc);
-		alloc.deleteInstance(variant);
+	destroyVariants(false);
+
+	for(ShaderProgramResourceVariant* variant : m_retiredVariants)
+	{
+		deleteVariant(variant);
 	}
+	m_retiredVariants.destroy(alloc);
 
 	for(Input& var : m_inputVars)
 	{
@@ -169,18 +320,123 @@ ShaderProgramResource::~ShaderProgramResource()
 	}
 	m_mutators.destroy(alloc);
 
+	for(Dependency& dep : m_dependencies)
+	{
+		dep.m_filename.destroy(alloc);
+	}
+	m_dependencies.destroy(alloc);
+
 	m_source.destroy(alloc);
+	m_cacheFilename.destroy(alloc);
+
+	m_descriptorSet = 0;
+	m_shaderStages = ShaderTypeBit::NONE;
+	m_instancingMutator = nullptr;
+}
+
+Bool ShaderProgramResource::hotReload(ShaderProgramResource& newer)
+{
+	// Nothing to do if the files are the same
+	Bool same = m_dependencies.getSize() == newer.m_dependencies.getSize();
+	for(U i = 0; i < m_dependencies.getSize() && same; ++i)
+	{
+		same = m_dependencies[i].m_hash == newer.m_dependencies[i].m_hash
+			   && m_dependencies[i].m_filename == newer.m_dependencies[i].m_filename;
+	}
+
+	if(same)
+	{
+		return true;
+	}
+
+	// The materials and the renderer point to the inputs and the mutators so they have to stay the same
+	const I32 instancingMutatorIdx = (m_instancingMutator) ? I32(m_instancingMutator - &m_mutators[0]) : -1;
+	const I32 newerInstancingMutatorIdx =
+		(newer.m_instancingMutator) ? I32(newer.m_instancingMutator - &newer.m_mutators[0]) : -1;
+
+	Bool sameInterface = m_inputVars.getSize() == newer.m_inputVars.getSize()
+						 && m_mutators.getSize() == newer.m_mutators.getSize()
+						 && m_descriptorSet == newer.m_descriptorSet
+						 && instancingMutatorIdx == newerInstancingMutatorIdx;
+
+	for(U i = 0; i < m_inputVars.getSize() && sameInterface; ++i)
+	{
+		const Input& a = m_inputVars[i];
+		const Input& b = newer.m_inputVars[i];
+		sameInterface = a.m_name == b.m_name && a.m_dataType == b.m_dataType && a.m_const == b.m_const
+						&& a.m_instanced == b.m_instanced;
+	}
+
+	for(U i = 0; i < m_mutators.getSize() && sameInterface; ++i)
+	{
+		const Mutator& a = m_mutators[i];
+		const Mutator& b = newer.m_mutators[i];
+		sameInterface = a.m_name == b.m_name && a.m_values.getSize() == b.m_values.getSize();
+		for(U j = 0; j < a.m_values.getSize() && sameInterface; ++j)
+		{
+			sameInterface = a.m_values[j] == b.m_values[j];
+		}
+	}
+
+	if(!sameInterface)
+	{
+		return false;
+	}
+
+	// Start with no variants. The new ones will be created from the new source
+	destroyVariants(true);
+
+	std::swap(m_source, newer.m_source);
+	std::swap(m_dependencies, newer.m_dependencies);
+	std::swap(m_shaderStages, newer.m_shaderStages);
+	for(U i = 0; i < m_inputVars.getSize(); ++i)
+	{
+		std::swap(m_inputVars[i].m_preprocExpr, newer.m_inputVars[i].m_preprocExpr);
+	}
+
+	// Write the new source to the cache. The newer has the old source now so it shouldn't
+	m_cacheDirty = true;
+	newer.m_cacheDirty = false;
+
+	++m_reloadGeneration;
+
+	return true;
 }
 
 Error ShaderProgramResource::load(const ResourceFilename& filename, Bool async)
 {
+	m_cacheFilename.sprintf(getAllocator(),
+		"%s/%llu.ankiprogcache",
+		getManager().getCacheDirectory().cstr(),
+		computeFilenameHash(filename));
+
+	if(loadFromCache())
+	{
+		m_loadedFromCache = true;
+		return Error::NONE;
+	}
+
+	// The cache is missing or stale. Start from scratch
+	String cacheFilename = std::move(m_cacheFilename);
+	destroy();
+	m_cacheFilename = std::move(cacheFilename);
+
 	// Preprocess
-	ShaderProgramPreprocessor pp(filename, &getManager().getFilesystem(), getTempAllocator());
+	ShaderProgramPreprocessor pp(
+		filename, &getManager().getFilesystem(), getTempAllocator(), &getManager().getShaderProgramIncludeCache());
 	ANKI_CHECK(pp.parse());
 
 	// Create the source
 	m_source.create(getAllocator(), pp.getSource());
 
+	// Keep the files it's made of to check the cache
+	m_dependencies.create(getAllocator(), pp.getDependencies().getSize());
+	for(U i = 0; i < m_dependencies.getSize(); ++i)
+	{
+		m_dependencies[i].m_filename.create(getAllocator(), pp.getDependencies()[i].getFilename());
+		m_dependencies[i].m_hash = pp.getDependencies()[i].getHash();
+	}
+
 	// Create the mutators
 	U instancedMutatorIdx = MAX_U;
 	if(pp.getMutators().getSize())
@@ -237,25 +493,335 @@ Error ShaderProgramResource::load(const ResourceFilename& filename, Bool async)
 		m_instancingMutator = &m_mutators[instancedMutatorIdx];
 	}
 
+	writeCache();
+
 	return Error::NONE;
 }
 
+Bool ShaderProgramResource::loadFromCache()
+{
+	auto alloc = getAllocator();
+
+	MemoryMappedFile file;
+	if(!fileExists(m_cacheFilename.toCString()) || file.map(m_cacheFilename.toCString()))
+	{
+		return false;
+	}
+
+	ShaderProgramCacheReader reader(file.getData());
+
+	Array<char, 8> magic;
+	reader.readBytes(&magic[0], sizeof(magic));
+	const U32 pushConstantsSize = reader.read<U32>();
+	if(reader.m_failed || memcmp(&magic[0], SHADER_PROGRAM_CACHE_MAGIC, sizeof(magic)) != 0
+		|| pushConstantsSize != getManager().getGrManager().getDeviceCapabilities().m_pushConstantsSize)
+	{
+		return false;
+	}
+
+	// Check if the files changed. That's way cheaper than preprocessing them
+	const U32 dependencyCount = reader.read<U32>();
+	if(!reader.hasRoomFor(dependencyCount, sizeof(U64) + sizeof(U32)) || dependencyCount == 0)
+	{
+		return false;
+	}
+
+	m_dependencies.create(alloc, dependencyCount);
+	for(Dependency& dep : m_dependencies)
+	{
+		dep.m_hash = reader.read<U64>();
+		reader.readString(alloc, dep.m_filename);
+		if(reader.m_failed || dep.m_filename.isEmpty())
+		{
+			return false;
+		}
+
+		ResourceFilePtr depFile;
+		StringAuto txt(getTempAllocator());
+		if(getManager().getFilesystem().openFile(dep.m_filename.toCString(), depFile)
+			|| depFile->readAllText(getTempAllocator(), txt))
+		{
+			return false;
+		}
+
+		const U64 hash = (txt.isEmpty()) ? 0 : computeHash(txt.cstr(), txt.getLength());
+		if(hash != dep.m_hash)
+		{
+			return false;
+		}
+	}
+
+	// The preprocessed program
+	reader.readString(alloc, m_source);
+	m_descriptorSet = reader.read<U8>();
+	m_shaderStages = ShaderTypeBit(reader.read<U32>());
+	const U32 instancedMutatorIdx = reader.read<U32>();
+
+	const U32 mutatorCount = reader.read<U32>();
+	if(!reader.hasRoomFor(mutatorCount, sizeof(U32) * 2))
+	{
+		return false;
+	}
+
+	if(mutatorCount)
+	{
+		m_mutators.create(alloc, mutatorCount);
+	}
+
+	for(Mutator& mutator : m_mutators)
+	{
+		reader.readString(alloc, mutator.m_name);
+		const U32 valueCount = reader.read<U32>();
+		if(!reader.hasRoomFor(valueCount, sizeof(ShaderProgramResourceMutatorValue)) || valueCount == 0)
+		{
+			return false;
+		}
+
+		mutator.m_values.create(alloc, valueCount);
+		reader.readBytes(&mutator.m_values[0], mutator.m_values.getSizeInBytes());
+	}
+
+	if(instancedMutatorIdx != MAX_U32)
+	{
+		if(instancedMutatorIdx >= mutatorCount)
+		{
+			return false;
+		}
+		m_instancingMutator = &m_mutators[instancedMutatorIdx];
+	}
+
+	const U32 inputCount = reader.read<U32>();
+	if(!reader.hasRoomFor(inputCount, sizeof(U32) * 3) || inputCount > 128)
+	{
+		return false;
+	}
+
+	if(inputCount)
+	{
+		m_inputVars.create(alloc, inputCount);
+	}
+
+	for(U32 i = 0; i < inputCount; ++i)
+	{
+		Input& in = m_inputVars[i];
+		in.m_program = this;
+		in.m_idx = i;
+		reader.readString(alloc, in.m_name);
+		reader.readString(alloc, in.m_preprocExpr);
+		in.m_dataType = ShaderVariableDataType(reader.read<U32>());
+		in.m_const = reader.read<U8>() != 0;
+		in.m_instanced = reader.read<U8>() != 0;
+	}
+
+	// The variants. They will get a program when they are first used
+	const U32 variantCount = reader.read<U32>();
+	if(!reader.hasRoomFor(variantCount, sizeof(U64) + sizeof(BitSet<128, U64>)))
+	{
+		return false;
+	}
+
+	for(U32 i = 0; i < variantCount && !reader.m_failed; ++i)
+	{
+		const U64 hash = reader.read<U64>();
+		if(hash == 0 || m_cachedVariants.find(hash) != m_cachedVariants.getEnd())
+		{
+			return false;
+		}
+
+		ShaderProgramResourceVariant* variant = alloc.newInstance<ShaderProgramResourceVariant>();
+		variant->m_hash = hash;
+		m_cachedVariants.emplace(alloc, hash, variant);
+
+		reader.readBytes(&variant->m_activeInputVars, sizeof(variant->m_activeInputVars));
+		variant->m_uniBlockSize = reader.read<U32>();
+		variant->m_usesPushConstants = reader.read<U8>() != 0;
+		if(inputCount)
+		{
+			variant->m_blockInfos.create(alloc, inputCount);
+			reader.readBytes(&variant->m_blockInfos[0], variant->m_blockInfos.getSizeInBytes());
+			variant->m_texUnits.create(alloc, inputCount);
+			reader.readBytes(&variant->m_texUnits[0], variant->m_texUnits.getSizeInBytes());
+		}
+		reader.readString(alloc, variant->m_shaderHeader);
+	}
+
+	return !reader.m_failed && !m_source.isEmpty();
+}
+
+void ShaderProgramResource::writeCache() const
+{
+	ShaderProgramCacheWriter writer;
+	writer.m_err = writer.m_file.open(m_cacheFilename.toCString(), FileOpenFlag::WRITE | FileOpenFlag::BINARY);
+
+	writer.writeBytes(SHADER_PROGRAM_CACHE_MAGIC, 8);
+	writer.write(U32(getManager().getGrManager().getDeviceCapabilities().m_pushConstantsSize));
+
+	writer.write(U32(m_dependencies.getSize()));
+	for(const Dependency& dep : m_dependencies)
+	{
+		writer.write(dep.m_hash);
+		writer.writeString(dep.m_filename);
+	}
+
+	writer.writeString(m_source);
+	writer.write(m_descriptorSet);
+	writer.write(U32(m_shaderStages));
+	writer.write(U32((m_instancingMutator) ? m_instancingMutator - &m_mutators[0] : MAX_U32));
+
+	writer.write(U32(m_mutators.getSize()));
+	for(const Mutator& mutator : m_mutators)
+	{
+		writer.writeString(mutator.m_name);
+		writer.write(U32(mutator.m_values.getSize()));
+		writer.writeBytes(&mutator.m_values[0], mutator.m_values.getSizeInBytes());
+	}
+
+	writer.write(U32(m_inputVars.getSize()));
+	for(const Input& in : m_inputVars)
+	{
+		writer.writeString(in.m_name);
+		writer.writeString(in.m_preprocExpr);
+		writer.write(U32(in.m_dataType));
+		writer.write(U8(in.m_const));
+		writer.write(U8(in.m_instanced));
+	}
+
+	// Gather the variants with programs and the variants that were loaded from the cache and were never used
+	const VariantTable* table = m_variants.load();
+	U32 variantCount = (table) ? table->m_count : 0;
+	for(auto it = m_cachedVariants.getBegin(); it != m_cachedVariants.getEnd(); ++it)
+	{
+		++variantCount;
+	}
+	writer.write(variantCount);
+
+	auto writeVariant = [&](const ShaderProgramResourceVariant& variant) {
+		writer.write(variant.m_hash);
+		writer.write(variant.m_activeInputVars);
+		writer.write(variant.m_uniBlockSize);
+		writer.write(U8(variant.m_usesPushConstants));
+		writer.writeBytes(variant.m_blockInfos.getBegin(), variant.m_blockInfos.getSizeInBytes());
+		writer.writeBytes(variant.m_texUnits.getBegin(), variant.m_texUnits.getSizeInBytes());
+		writer.writeString(variant.m_shaderHeader);
+	};
+
+	if(table)
+	{
+		for(U32 i = 0; i < table->m_capacity; ++i)
+		{
+			if(table->m_slots[i].m_hash.load())
+			{
+				writeVariant(*table->m_slots[i].m_variant);
+			}
+		}
+	}
+
+	for(const ShaderProgramResourceVariant* variant : m_cachedVariants)
+	{
+		writeVariant(*variant);
+	}
+
+	if(writer.m_err)
+	{
+		ANKI_RESOURCE_LOGW("Failed to write the program cache: %s", m_cacheFilename.cstr());
+	}
+}
+
 U64 ShaderProgramResource::computeVariantHash(ConstWeakArray<ShaderProgramResourceMutation> mutations,
 	ConstWeakArray<ShaderProgramResourceConstantValue> constants) const
 {
-	U hash = 1;
+	// Hash indices instead of pointers so the hash is the same in every run and it can be stored in the cache
+	U64 hash = 1;
 
-	if(mutations.getSize())
+	for(const ShaderProgramResourceMutation& m : mutations)
+	{
+		const Array<I32, 2> mutation = {{I32(m.m_mutator - &m_mutators[0]), m.m_value}};
+		hash = appendHash(&mutation[0], sizeof(mutation), hash);
+	}
+
+	for(const ShaderProgramResourceConstantValue& c : constants)
 	{
-		hash = computeHash(&mutations[0], sizeof(mutations[0]) * mutations.getSize());
+		hash = appendHash(&c.m_variable->m_idx, sizeof(c.m_variable->m_idx), hash);
+		hash = appendHash(&c.m_vec4, sizeof(c.m_vec4), hash);
 	}
 
-	if(constants.getSize())
+	// Zero marks the empty slots of the table
+	return (hash) ? hash : 1;
+}
+
+const ShaderProgramResourceVariant* ShaderProgramResource::tryFindVariant(U64 hash) const
+{
+	const VariantTable* table = m_variants.load(AtomicMemoryOrder::ACQUIRE);
+	if(table)
 	{
-		hash = appendHash(&constants[0], sizeof(constants[0]) * constants.getSize(), hash);
+		const U32 mask = table->m_capacity - 1;
+		for(U32 i = U32(hash) & mask;; i = (i + 1) & mask)
+		{
+			const U64 slotHash = table->m_slots[i].m_hash.load(AtomicMemoryOrder::ACQUIRE);
+			if(slotHash == hash)
+			{
+				return table->m_slots[i].m_variant;
+			}
+			else if(slotHash == 0)
+			{
+				break;
+			}
+		}
 	}
 
-	return hash;
+	return nullptr;
+}
+
+void ShaderProgramResource::insertVariant(U64 hash, ShaderProgramResourceVariant* variant) const
+{
+	ANKI_ASSERT(hash && variant);
+
+	auto insert = [](VariantTable& table, U64 hash, ShaderProgramResourceVariant* variant) {
+		const U32 mask = table.m_capacity - 1;
+		U32 i = U32(hash) & mask;
+		while(table.m_slots[i].m_hash.load() != 0)
+		{
+			i = (i + 1) & mask;
+		}
+
+		// Publish the variant after it's written
+		table.m_slots[i].m_variant = variant;
+		table.m_slots[i].m_hash.store(hash, AtomicMemoryOrder::RELEASE);
+		++table.m_count;
+	};
+
+	VariantTable* table = m_variants.load();
+	if(!table || (table->m_count + 1) * 2 > table->m_capacity)
+	{
+		// Grow. Keep the old table for the readers that might be walking it
+		auto alloc = getAllocator();
+		VariantTable* newTable = alloc.newInstance<VariantTable>();
+		newTable->m_capacity = (table) ? table->m_capacity * 2 : 16;
+		newTable->m_slots = alloc.newArray<VariantTable::Slot>(newTable->m_capacity);
+		for(U32 i = 0; i < newTable->m_capacity; ++i)
+		{
+			newTable->m_slots[i].m_hash.set(0);
+			newTable->m_slots[i].m_variant = nullptr;
+		}
+
+		if(table)
+		{
+			for(U32 i = 0; i < table->m_capacity; ++i)
+			{
+				const U64 slotHash = table->m_slots[i].m_hash.load();
+				if(slotHash)
+				{
+					insert(*newTable, slotHash, table->m_slots[i].m_variant);
+				}
+			}
+		}
+
+		newTable->m_prev = table;
+		m_variants.store(newTable, AtomicMemoryOrder::RELEASE);
+		table = newTable;
+	}
+
+	insert(*table, hash, variant);
 }
 
 void ShaderProgramResource::getOrCreateVariant(ConstWeakArray<ShaderProgramResourceMutation> mutation,
@@ -287,24 +853,44 @@ void ShaderProgramResource::getOrCreateVariant(ConstWeakArray<ShaderProgramResou
 	}
 
 	// Compute hash
-	U64 hash = computeVariantHash(mutation, constants);
+	const U64 hash = computeVariantHash(mutation, constants);
+
+	// Fast path, it exists
+	variant = tryFindVariant(hash);
+	if(variant)
+	{
+		return;
+	}
 
 	LockGuard<Mutex> lock(m_mtx);
 
-	auto it = m_variants.find(hash);
-	if(it != m_variants.getEnd())
+	// Check again, another thread might have created it
+	variant = tryFindVariant(hash);
+	if(variant)
 	{
-		variant = *it;
+		return;
+	}
+
+	ShaderProgramResourceVariant* v;
+	auto it = m_cachedVariants.find(hash);
+	if(it != m_cachedVariants.getEnd())
+	{
+		// It was in the cache, only the program is missing
+		v = *it;
+		m_cachedVariants.erase(getAllocator(), it);
+		createVariantProgram(*v);
 	}
 	else
 	{
 		// Create one
-		ShaderProgramResourceVariant* v = getAllocator().newInstance<ShaderProgramResourceVariant>();
+		v = getAllocator().newInstance<ShaderProgramResourceVariant>();
+		v->m_hash = hash;
 		initVariant(mutation, constants, *v);
-
-		m_variants.emplace(getAllocator(), hash, v);
-		variant = v;
+		m_cacheDirty = true;
 	}
+
+	insertVariant(hash, v);
+	variant = v;
 }
 
 void ShaderProgramResource::initVariant(ConstWeakArray<ShaderProgramResourceMutation> mutations,
@@ -551,6 +1137,14 @@ void ShaderProgramResource::initVariant(ConstWeakArray<ShaderProgramResourceMuta
 
 	StringAuto shaderHeader(getTempAllocator());
 	shaderHeaderSrc.join("", shaderHeader);
+	variant.m_shaderHeader.create(getAllocator(), shaderHeader.toCString());
+
+	createVariantProgram(variant);
+}
+
+void ShaderProgramResource::createVariantProgram(ShaderProgramResourceVariant& variant) const
+{
+	ANKI_ASSERT(!variant.m_prog.isCreated());
 
 	// Create the program name
 	StringAuto progName(getTempAllocator());
@@ -571,7 +1165,7 @@ void ShaderProgramResource::initVariant(ConstWeakArray<ShaderProgramResourceMuta
 		}
 
 		StringAuto src(getTempAllocator());
-		src.append(shaderHeader);
+		src.append(variant.m_shaderHeader);
 		src.append(m_source);
 
 		// Compile
@@ -202,6 +202,8 @@ private:
 	U32 m_uniBlockSize = 0;
 	DynamicArray<I16> m_texUnits;
 	Bool8 m_usesPushConstants = false;
+	String m_shaderHeader; ///< The defines that are prepended to the source. Kept for the on-disk cache.
+	U64 m_hash = 0; ///< The hash of the mutation and the constants.
 };
 
 /// The value of a constant.
@@ -238,6 +240,10 @@ public:
 static_assert(sizeof(ShaderProgramResourceConstantValue) == sizeof(Vec4) * 2, "Need it to be packed");
 
 /// Shader program resource. It loads special AnKi programs.
+///
+/// The results of the preprocessing and the layouts of the variants are kept in a file in the cache directory. If the
+/// program and its includes didn't change since that file was written the load skips the preprocessing and the
+/// variants are created without evaluating the preprocessor expressions of the inputs.
 class ShaderProgramResource : public ResourceObject
 {
 public:
@@ -287,7 +293,7 @@ public:
 	}
 
 	/// Get or create a graphics shader program variant.
-	/// @note It's thread-safe.
+	/// @note It's thread-safe. Getting a variant that was created before doesn't lock.
 	void getOrCreateVariant(ConstWeakArray<ShaderProgramResourceMutation> mutation,
 		ConstWeakArray<ShaderProgramResourceConstantValue> constants,
 		const ShaderProgramResourceVariant*& variant) const;
@@ -341,6 +347,38 @@ public:
 		return m_descriptorSet;
 	}
 
+anki_internal:
+	/// Return true if the file is the program or one of its includes.
+	Bool dependsOn(CString filename) const
+	{
+		for(const Dependency& dep : m_dependencies)
+		{
+			if(dep.m_filename == filename)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Return true if the load used the cache directory instead of preprocessing.
+	Bool isLoadedFromCache() const
+	{
+		return m_loadedFromCache;
+	}
+
+	/// Take the source of a newer version of the same program. The old variants stay alive because others might still
+	/// point to them. Call it when nothing else uses the program.
+	/// @return False if the inputs, the mutators or the descriptor set changed and it can't be done.
+	Bool hotReload(ShaderProgramResource& newer);
+
+	/// Get the number of times the source was hot reloaded. The users that keep the programs of the variants should
+	/// get the variants again when it changes. The inputs and the mutators stay the same so they can be used again.
+	U32 getReloadGeneration() const
+	{
+		return m_reloadGeneration;
+	}
+
 private:
 	using Mutator = ShaderProgramResourceMutator;
 	using Input = ShaderProgramResourceInputVariable;
@@ -348,10 +386,43 @@ private:
 	DynamicArray<Input> m_inputVars;
 	DynamicArray<Mutator> m_mutators;
 
+	/// An open addressing hash table of variants. It's read without locks. When it fills up it's replaced by a bigger
+	/// one and the old one is kept around until the resource dies because readers might still be using it.
+	class VariantTable
+	{
+	public:
+		class Slot
+		{
+		public:
+			Atomic<U64> m_hash; ///< Zero if the slot is empty. Written after m_variant.
+			ShaderProgramResourceVariant* m_variant;
+		};
+
+		Slot* m_slots = nullptr;
+		U32 m_capacity = 0; ///< Power of 2.
+		U32 m_count = 0;
+		VariantTable* m_prev = nullptr;
+	};
+
+	/// A file that the program was made of.
+	class Dependency
+	{
+	public:
+		String m_filename;
+		U64 m_hash; ///< The hash of the contents.
+	};
+
 	String m_source;
+	DynamicArray<Dependency> m_dependencies;
+	String m_cacheFilename;
 
-	mutable HashMap<U64, ShaderProgramResourceVariant*> m_variants;
+	mutable Atomic<VariantTable*> m_variants = {nullptr};
+	DynamicArray<ShaderProgramResourceVariant*> m_retiredVariants; ///< The variants of the sources before hot reloads.
+	mutable HashMap<U64, ShaderProgramResourceVariant*> m_cachedVariants; ///< Loaded from disk without programs.
 	mutable Mutex m_mtx;
+	mutable Bool8 m_cacheDirty = false;
+	Bool8 m_loadedFromCache = false;
+	U32 m_reloadGeneration = 0;
 
 	U8 m_descriptorSet = 0;
 	ShaderTypeBit m_shaderStages = ShaderTypeBit::NONE;
@@ -363,6 +434,28 @@ private:
 	void initVariant(ConstWeakArray<ShaderProgramResourceMutation> mutations,
 		ConstWeakArray<ShaderProgramResourceConstantValue> constants,
 		ShaderProgramResourceVariant& variant) const;
+
+	/// Compile the shaders of a variant and create its program.
+	void createVariantProgram(ShaderProgramResourceVariant& variant) const;
+
+	const ShaderProgramResourceVariant* tryFindVariant(U64 hash) const;
+
+	/// Add a variant to the lock-free table. Needs m_mtx.
+	void insertVariant(U64 hash, ShaderProgramResourceVariant* variant) const;
+
+	void deleteVariant(ShaderProgramResourceVariant* variant) const;
+
+	/// Delete the variant tables and the cached variants. The variants of the tables are retired if retire is true.
+	void destroyVariants(Bool retire);
+
+	/// Load the preprocessed program and the variants from the cache directory.
+	/// @return True if the cache was up to date. If it's false the resource has to be destroyed.
+	Bool loadFromCache();
+
+	/// Write the preprocessed program and the variants to the cache directory.
+	void writeCache() const;
+
+	void destroy();
 };
 
 /// Smart initializer of multiple ShaderProgramResourceConstantValue.
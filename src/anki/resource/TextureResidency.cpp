@@ -0,0 +1,246 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/TextureResidency.h>
+#include <algorithm>
+
+namespace anki
+{
+
+TextureResidencyManager::~TextureResidencyManager()
+{
+	ANKI_ASSERT(m_lru.isEmpty() && "Forgot to unregister some textures");
+
+	if(m_textures)
+	{
+		m_alloc.deleteArray(m_textures, m_textureCount);
+	}
+	m_freeHandles.destroy(m_alloc);
+}
+
+void TextureResidencyManager::init(PtrSize memoryBudget, U32 maxTextureCount, U32 maxChangesInFlight)
+{
+	ANKI_ASSERT(m_textures == nullptr);
+	ANKI_ASSERT(maxTextureCount > 0 && maxChangesInFlight > 0);
+
+	m_memoryBudget = memoryBudget;
+	m_maxChangesInFlight = maxChangesInFlight;
+
+	m_textureCount = maxTextureCount;
+	m_textures = m_alloc.newArray<Texture>(maxTextureCount);
+
+	// Hand out the lower handles first
+	m_freeHandles.create(m_alloc, maxTextureCount);
+	for(U32 i = 0; i < maxTextureCount; ++i)
+	{
+		m_freeHandles[i] = maxTextureCount - i - 1;
+	}
+	m_freeHandleCount = maxTextureCount;
+}
+
+TextureResidencyHandle TextureResidencyManager::registerTexture(
+	ConstWeakArray<PtrSize> mipSizes, U32 topMip, U32 tailMip, U32 firstResidentMip, void* userData)
+{
+	ANKI_ASSERT(mipSizes.getSize() > 0 && mipSizes.getSize() <= MAX_MIPS);
+	ANKI_ASSERT(topMip <= tailMip && tailMip < mipSizes.getSize());
+	ANKI_ASSERT(firstResidentMip >= topMip && firstResidentMip <= tailMip);
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	if(m_freeHandleCount == 0)
+	{
+		return INVALID_TEXTURE_RESIDENCY_HANDLE;
+	}
+
+	const TextureResidencyHandle handle = m_freeHandles[--m_freeHandleCount];
+	Texture& tex = m_textures[handle];
+	ANKI_ASSERT(!tex.m_registered);
+
+	tex.m_memoryFromMip[mipSizes.getSize()] = 0;
+	for(I32 mip = I32(mipSizes.getSize()) - 1; mip >= 0; --mip)
+	{
+		tex.m_memoryFromMip[mip] = tex.m_memoryFromMip[mip + 1] + mipSizes[mip];
+	}
+
+	tex.m_userData = userData;
+	tex.m_lastRequestFrame = 0;
+	tex.m_requestedMip.set(MAX_U32);
+	tex.m_topMip = U8(topMip);
+	tex.m_tailMip = U8(tailMip);
+	tex.m_firstResidentMip = U8(firstResidentMip);
+	tex.m_pendingMip = NO_CHANGE;
+	tex.m_wantedMip = U8(tailMip);
+	tex.m_registered = true;
+
+	// It was never requested so it's the least recently used
+	m_lru.pushFront(&tex);
+	m_memoryUsage += tex.m_memoryFromMip[firstResidentMip];
+
+	return handle;
+}
+
+void TextureResidencyManager::unregisterTexture(TextureResidencyHandle handle)
+{
+	ANKI_ASSERT(handle < m_textureCount);
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	Texture& tex = m_textures[handle];
+	ANKI_ASSERT(tex.m_registered);
+
+	m_memoryUsage -= tex.m_memoryFromMip[tex.getTargetMip()];
+	if(tex.m_pendingMip != NO_CHANGE)
+	{
+		ANKI_ASSERT(m_changesInFlight > 0);
+		--m_changesInFlight;
+		tex.m_pendingMip = NO_CHANGE;
+	}
+
+	m_lru.erase(&tex);
+	tex.m_registered = false;
+	m_freeHandles[m_freeHandleCount++] = handle;
+}
+
+void TextureResidencyManager::setUserData(TextureResidencyHandle handle, void* userData)
+{
+	ANKI_ASSERT(handle < m_textureCount);
+
+	LockGuard<Mutex> lock(m_mtx);
+	ANKI_ASSERT(m_textures[handle].m_registered);
+	m_textures[handle].m_userData = userData;
+}
+
+void TextureResidencyManager::onResidencyChanged(TextureResidencyHandle handle, U32 firstResidentMip)
+{
+	ANKI_ASSERT(handle < m_textureCount);
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	Texture& tex = m_textures[handle];
+	ANKI_ASSERT(tex.m_registered);
+	ANKI_ASSERT(firstResidentMip >= tex.m_topMip && firstResidentMip <= tex.m_tailMip);
+
+	m_memoryUsage -= tex.m_memoryFromMip[tex.getTargetMip()];
+	if(tex.m_pendingMip != NO_CHANGE)
+	{
+		ANKI_ASSERT(m_changesInFlight > 0);
+		--m_changesInFlight;
+		tex.m_pendingMip = NO_CHANGE;
+	}
+
+	tex.m_firstResidentMip = U8(firstResidentMip);
+	m_memoryUsage += tex.m_memoryFromMip[firstResidentMip];
+}
+
+void TextureResidencyManager::startChange(Texture& tex, U32 mip, DynamicArrayAuto<TextureResidencyChange>& changes)
+{
+	ANKI_ASSERT(tex.m_pendingMip == NO_CHANGE && mip != tex.m_firstResidentMip);
+	ANKI_ASSERT(m_changesInFlight < m_maxChangesInFlight);
+
+	m_memoryUsage -= tex.m_memoryFromMip[tex.m_firstResidentMip];
+	m_memoryUsage += tex.m_memoryFromMip[mip];
+	tex.m_pendingMip = U8(mip);
+	++m_changesInFlight;
+
+	TextureResidencyChange& change = *changes.emplaceBack();
+	change.m_userData = tex.m_userData;
+	change.m_handle = TextureResidencyHandle(&tex - m_textures);
+	change.m_firstMip = U8(mip);
+	change.m_eviction = mip > tex.m_firstResidentMip;
+}
+
+Bool TextureResidencyManager::makeRoom(PtrSize size, U64 frame, DynamicArrayAuto<TextureResidencyChange>& changes)
+{
+	// First drop the textures that were not requested this frame to their tail. Then trim the textures that were
+	// requested but have more mips than they need
+	for(U32 pass = 0; pass < 2; ++pass)
+	{
+		for(auto it = m_lru.getBegin(); it != m_lru.getEnd() && m_memoryUsage + size > m_memoryBudget; ++it)
+		{
+			if(m_changesInFlight >= m_maxChangesInFlight)
+			{
+				return false;
+			}
+
+			Texture& tex = *it;
+			const Bool requested = tex.m_lastRequestFrame == frame;
+			if(tex.m_pendingMip != NO_CHANGE || (pass == 0 && requested))
+			{
+				continue;
+			}
+
+			const U32 mip = (requested) ? tex.m_wantedMip : tex.m_tailMip;
+			if(mip > tex.m_firstResidentMip)
+			{
+				startChange(tex, mip, changes);
+			}
+		}
+	}
+
+	return m_memoryUsage + size <= m_memoryBudget;
+}
+
+void TextureResidencyManager::update(U64 frame, DynamicArrayAuto<TextureResidencyChange>& changes)
+{
+	LockGuard<Mutex> lock(m_mtx);
+
+	// Gather the requests of the frame
+	DynamicArrayAuto<Load> loads(m_alloc);
+	for(U32 handle = 0; handle < m_textureCount; ++handle)
+	{
+		Texture& tex = m_textures[handle];
+		const U32 requestedMip = tex.m_requestedMip.exchange(MAX_U32);
+		if(!tex.m_registered || requestedMip == MAX_U32)
+		{
+			continue;
+		}
+
+		// Move it to the end of the LRU
+		tex.m_lastRequestFrame = frame;
+		m_lru.erase(&tex);
+		m_lru.pushBack(&tex);
+
+		tex.m_wantedMip = U8(clamp<U32>(requestedMip, tex.m_topMip, tex.m_tailMip));
+		if(tex.m_pendingMip == NO_CHANGE && tex.m_wantedMip < tex.m_firstResidentMip)
+		{
+			Load& load = *loads.emplaceBack();
+			load.m_handle = handle;
+			load.m_mip = tex.m_wantedMip;
+			load.m_missingMipCount = tex.m_firstResidentMip - tex.m_wantedMip;
+		}
+	}
+
+	// The textures that miss the most detail go first
+	std::sort(loads.getBegin(), loads.getEnd(), [](const Load& a, const Load& b) {
+		return (a.m_missingMipCount != b.m_missingMipCount) ? a.m_missingMipCount > b.m_missingMipCount
+															  : a.m_handle < b.m_handle;
+	});
+
+	for(const Load& load : loads)
+	{
+		Texture& tex = m_textures[load.m_handle];
+
+		// If the whole request doesn't fit try with fewer mips
+		for(U32 mip = load.m_mip; mip < tex.m_firstResidentMip; ++mip)
+		{
+			const PtrSize extraMemory = tex.m_memoryFromMip[mip] - tex.m_memoryFromMip[tex.m_firstResidentMip];
+			if(makeRoom(extraMemory, frame, changes))
+			{
+				if(m_changesInFlight < m_maxChangesInFlight)
+				{
+					startChange(tex, mip, changes);
+				}
+				break;
+			}
+		}
+
+		if(m_changesInFlight >= m_maxChangesInFlight)
+		{
+			break;
+		}
+	}
+}
+
+} // end namespace anki
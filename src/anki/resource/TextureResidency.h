@@ -0,0 +1,167 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/resource/Common.h>
+#include <anki/util/List.h>
+#include <anki/util/Thread.h>
+#include <anki/util/WeakArray.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// The handle of a texture that is registered to the TextureResidencyManager.
+using TextureResidencyHandle = U32;
+
+/// An invalid TextureResidencyHandle.
+const TextureResidencyHandle INVALID_TEXTURE_RESIDENCY_HANDLE = MAX_U32;
+
+/// A change of the resident mips of a texture that the TextureResidencyManager wants. The user should make the mips
+/// [m_firstMip, mipCount) resident and then call TextureResidencyManager::onResidencyChanged().
+class TextureResidencyChange
+{
+public:
+	void* m_userData;
+	TextureResidencyHandle m_handle;
+	U8 m_firstMip; ///< The new first resident mip.
+	Bool8 m_eviction; ///< True if it drops mips. False if it loads more.
+};
+
+/// Decides which mips of the textures should be resident. It's only the CPU side logic so it doesn't know anything
+/// about the GPU.
+///
+/// The textures are registered with the size of every mip. The mips from the tail mip and after are always resident.
+/// During visibility the users request the first mip that a texture needs. Once per frame update() gathers the
+/// requests and decides what to load. The textures are kept in a list that is sorted by the last frame they were
+/// requested. If a load doesn't fit in the memory budget the high mips of the least recently used textures are
+/// evicted.
+class TextureResidencyManager : public NonCopyable
+{
+public:
+	static const U32 MAX_MIPS = 16;
+
+	TextureResidencyManager(GenericMemoryPoolAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	~TextureResidencyManager();
+
+	/// @param memoryBudget The memory that all the resident mips can use.
+	/// @param maxTextureCount The maximum number of textures that can be registered.
+	/// @param maxChangesInFlight How many changes can be in flight at the same time.
+	void init(PtrSize memoryBudget, U32 maxTextureCount, U32 maxChangesInFlight);
+
+	/// Register a texture. It's thread-safe.
+	/// @param mipSizes The memory of every mip.
+	/// @param topMip The first mip that is allowed to become resident.
+	/// @param tailMip The first mip that is always resident.
+	/// @param firstResidentMip The first mip that is currently resident.
+	/// @param userData It's passed back in TextureResidencyChange.
+	/// @return A handle or INVALID_TEXTURE_RESIDENCY_HANDLE if there is no room.
+	TextureResidencyHandle registerTexture(
+		ConstWeakArray<PtrSize> mipSizes, U32 topMip, U32 tailMip, U32 firstResidentMip, void* userData);
+
+	/// Unregister a texture. Changes that are in flight are forgotten. It's thread-safe.
+	void unregisterTexture(TextureResidencyHandle handle);
+
+	/// Change the user data of a texture. It's thread-safe.
+	void setUserData(TextureResidencyHandle handle, void* userData);
+
+	/// Request a mip. The smallest mip that is requested in a frame wins. It's thread-safe and lock-free.
+	void requestMip(TextureResidencyHandle handle, U32 mip)
+	{
+		ANKI_ASSERT(handle < m_textureCount);
+		m_textures[handle].m_requestedMip.min(mip);
+	}
+
+	/// Call it when a change that update() returned is done or if it failed. It's thread-safe.
+	/// @param handle The texture.
+	/// @param firstResidentMip The first mip that is now resident.
+	void onResidencyChanged(TextureResidencyHandle handle, U32 firstResidentMip);
+
+	/// Gather the requests of the frame and decide what to load and what to evict. It's thread-safe.
+	/// @param frame A number that increases every frame.
+	/// @param[out] changes The changes that the user should do.
+	void update(U64 frame, DynamicArrayAuto<TextureResidencyChange>& changes);
+
+	/// Get the memory of the mips that are resident or will be when the changes in flight finish.
+	PtrSize getMemoryUsage() const
+	{
+		return m_memoryUsage;
+	}
+
+	PtrSize getMemoryBudget() const
+	{
+		return m_memoryBudget;
+	}
+
+	/// Get the first resident mip of a texture.
+	U32 getFirstResidentMip(TextureResidencyHandle handle) const
+	{
+		ANKI_ASSERT(handle < m_textureCount && m_textures[handle].m_registered);
+		return m_textures[handle].m_firstResidentMip;
+	}
+
+private:
+	static const U8 NO_CHANGE = MAX_U8;
+
+	class Texture : public IntrusiveListEnabled<Texture>
+	{
+	public:
+		/// The memory of the resident mips for every first mip.
+		Array<PtrSize, MAX_MIPS + 1> m_memoryFromMip;
+		void* m_userData = nullptr;
+		U64 m_lastRequestFrame = 0;
+		Atomic<U32> m_requestedMip = {MAX_U32};
+		U8 m_topMip = 0;
+		U8 m_tailMip = 0;
+		U8 m_firstResidentMip = 0;
+		U8 m_pendingMip = NO_CHANGE; ///< The first mip of the change in flight.
+		U8 m_wantedMip = 0; ///< The mip that was requested the last time.
+		Bool8 m_registered = false;
+
+		/// The first mip that the memory accounts for.
+		U32 getTargetMip() const
+		{
+			return (m_pendingMip != NO_CHANGE) ? m_pendingMip : m_firstResidentMip;
+		}
+	};
+
+	class Load
+	{
+	public:
+		U32 m_handle;
+		U32 m_mip;
+		U32 m_missingMipCount;
+	};
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	Texture* m_textures = nullptr;
+	U32 m_textureCount = 0;
+	DynamicArray<U32> m_freeHandles;
+	U32 m_freeHandleCount = 0;
+
+	/// The least recently requested textures are first.
+	IntrusiveList<Texture> m_lru;
+
+	Mutex m_mtx;
+	PtrSize m_memoryBudget = 0;
+	PtrSize m_memoryUsage = 0;
+	U32 m_maxChangesInFlight = 0;
+	U32 m_changesInFlight = 0;
+
+	/// Evict the high mips of the least recently used textures till there is enough memory.
+	Bool makeRoom(PtrSize size, U64 frame, DynamicArrayAuto<TextureResidencyChange>& changes);
+
+	void startChange(Texture& tex, U32 mip, DynamicArrayAuto<TextureResidencyChange>& changes);
+};
+/// @}
+
+} // end namespace anki
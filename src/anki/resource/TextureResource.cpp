@@ -7,6 +7,7 @@
 #include <anki/resource/ImageLoader.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/resource/AsyncLoader.h>
+#include <anki/util/Filesystem.h>
 
 namespace anki
 {
@@ -45,8 +46,31 @@ public:
 	}
 };
 
+/// Loads or evicts the mips of a streamed texture.
+class TextureResource::StreamTask : public AsyncLoaderTask
+{
+public:
+	TextureResource* m_rsrc;
+	U32 m_firstMip;
+
+	StreamTask(TextureResource* rsrc, U32 firstMip)
+		: m_rsrc(rsrc)
+		, m_firstMip(firstMip)
+	{
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx) final
+	{
+		return m_rsrc->streamMips(m_firstMip);
+	}
+};
+
 TextureResource::~TextureResource()
 {
+	if(m_residencyHandle != INVALID_TEXTURE_RESIDENCY_HANDLE)
+	{
+		getManager().unregisterStreamedTexture(this, m_residencyHandle);
+	}
 }
 
 Error TextureResource::load(const ResourceFilename& filename, Bool async)
@@ -58,6 +82,7 @@ Error TextureResource::load(const ResourceFilename& filename, Bool async)
 	if(async)
 	{
 		task = getManager().getAsyncLoader().newTask<TexUploadTask>(getManager().getAsyncLoader().getAllocator());
+		task->setOwner(static_cast<const ResourceObject*>(this));
 		ctx = &task->m_ctx;
 	}
 	else
@@ -75,7 +100,29 @@ Error TextureResource::load(const ResourceFilename& filename, Bool async)
 	ResourceFilePtr file;
 	ANKI_CHECK(openFile(filename, file));
 
-	ANKI_CHECK(loader.load(file, filename, getManager().getMaxTextureSize()));
+	// Streamed textures start with their small mips only
+	Bool stream = false;
+	if(getManager().getTextureResidencyManager())
+	{
+		StringAuto ext(getTempAllocator());
+		getFilepathExtension(filename, getTempAllocator(), ext);
+		stream = !ext.isEmpty() && ext == "ankitex";
+	}
+
+	if(stream)
+	{
+		// Only 2D textures are streamed. Check the header before loading anything
+		ANKI_CHECK(loader.loadHeader(file, filename));
+		stream = loader.getTextureType() == ImageLoader::TextureType::_2D;
+		ANKI_CHECK(file->seek(0, ResourceFile::SeekOrigin::BEGINNING));
+	}
+
+	U32 maxTextureSize = getManager().getMaxTextureSize();
+	if(stream)
+	{
+		maxTextureSize = min(maxTextureSize, getManager().getTextureStreamingTailSize());
+	}
+	ANKI_CHECK(loader.load(file, filename, maxTextureSize));
 
 	// Various sizes
 	init.m_width = loader.getWidth();
@@ -196,9 +243,178 @@ Error TextureResource::load(const ResourceFilename& filename, Bool async)
 	TextureViewInitInfo viewInit(m_tex, "Rsrc");
 	m_texView = getManager().getGrManager().newTextureView(viewInit);
 
+	if(stream)
+	{
+		registerForStreaming(loader, init.m_format);
+	}
+
 	return Error::NONE;
 }
 
+void TextureResource::registerForStreaming(const ImageLoader& loader, Format format)
+{
+	const U32 firstMip = loader.getFirstMipLevel();
+	const U32 mipCount = firstMip + loader.getMipLevelsCount();
+	m_fileSize = UVec2(loader.getWidth() << firstMip, loader.getHeight() << firstMip);
+	m_firstMip = U8(firstMip);
+
+	// The mips that are bigger than the max texture size are never loaded
+	const U32 maxSize = max(m_fileSize.x(), m_fileSize.y());
+	U32 topMip = 0;
+	while(topMip < firstMip && (maxSize >> topMip) > getManager().getMaxTextureSize())
+	{
+		++topMip;
+	}
+
+	if(topMip == firstMip || mipCount > TextureResidencyManager::MAX_MIPS)
+	{
+		// Nothing to stream
+		return;
+	}
+
+	Array<PtrSize, TextureResidencyManager::MAX_MIPS> mipSizes;
+	for(U32 mip = 0; mip < mipCount; ++mip)
+	{
+		mipSizes[mip] = computeSurfaceSize(m_fileSize.x() >> mip, m_fileSize.y() >> mip, format);
+	}
+
+	m_residencyHandle = getManager().getTextureResidencyManager()->registerTexture(
+		ConstWeakArray<PtrSize>(&mipSizes[0], mipCount), topMip, firstMip, firstMip, this);
+	if(m_residencyHandle == INVALID_TEXTURE_RESIDENCY_HANDLE)
+	{
+		ANKI_RESOURCE_LOGW("Too many streamed textures. Will not stream: %s", getFilename().get());
+		return;
+	}
+
+	// Report the size that the texture will have when it's fully resident
+	m_size.x() = m_fileSize.x() >> topMip;
+	m_size.y() = m_fileSize.y() >> topMip;
+}
+
+void TextureResource::requestResidency(F32 pixels) const
+{
+	if(m_residencyHandle == INVALID_TEXTURE_RESIDENCY_HANDLE)
+	{
+		return;
+	}
+
+	// Every mip is half the size of the previous one. The manager clamps the mip
+	const F32 maxSize = F32(max(m_fileSize.x(), m_fileSize.y()));
+	const U32 mip = (pixels >= maxSize) ? 0u : U32(log2(maxSize / max(pixels, 1.0f)));
+	getManager().getTextureResidencyManager()->requestMip(m_residencyHandle, mip);
+}
+
+void TextureResource::startResidencyChange(const TextureResidencyChange& change)
+{
+	ANKI_ASSERT(change.m_handle == m_residencyHandle && change.m_userData == this);
+
+	AsyncLoader& loader = getManager().getAsyncLoader();
+	StreamTask* task = loader.newTask<StreamTask>(this, change.m_firstMip);
+	task->setOwner(static_cast<const ResourceObject*>(this));
+
+	// Freeing memory is less urgent than giving detail to something that is visible
+	loader.submitTask(task, (change.m_eviction) ? AsyncLoaderPriority::BACKGROUND : AsyncLoaderPriority::VISIBLE);
+}
+
+Error TextureResource::streamMips(U32 firstMip)
+{
+	LoadingContext ctx(getManager().getAsyncLoader().getAllocator());
+	ImageLoader& loader = ctx.m_loader;
+
+	ResourceFilePtr file;
+	const U32 maxSize = max(m_fileSize.x(), m_fileSize.y());
+	Error err = openFile(getFilename(), file);
+	if(!err)
+	{
+		err = loader.load(file, getFilename(), maxSize >> firstMip);
+	}
+
+	if(!err)
+	{
+		ANKI_ASSERT(loader.getFirstMipLevel() == firstMip);
+
+		// The format doesn't change and m_tex is replaced only after this task is done
+		TextureInitInfo init("RsrcTex");
+		init.m_usage = TextureUsageBit::SAMPLED_ALL | TextureUsageBit::TRANSFER_DESTINATION;
+		init.m_initialUsage = TextureUsageBit::SAMPLED_ALL;
+		init.m_width = loader.getWidth();
+		init.m_height = loader.getHeight();
+		init.m_type = TextureType::_2D;
+		init.m_format = m_tex->getFormat();
+		init.m_mipmapCount = loader.getMipLevelsCount();
+
+		ctx.m_faces = 1;
+		ctx.m_layerCount = 1;
+		ctx.m_gr = &getManager().getGrManager();
+		ctx.m_trfAlloc = &getManager().getTransferGpuAllocator();
+		ctx.m_texType = init.m_type;
+		ctx.m_tex = getManager().getGrManager().newTexture(init);
+
+		err = load(ctx);
+		if(!err)
+		{
+			m_streamedTex = ctx.m_tex;
+			m_streamedTexView = getManager().getGrManager().newTextureView(TextureViewInitInfo(m_streamedTex, "Rsrc"));
+			m_streamedFirstMip = U8(firstMip);
+		}
+	}
+
+	if(err)
+	{
+		ANKI_RESOURCE_LOGE("Failed to stream mip %u of texture: %s", firstMip, getFilename().get());
+	}
+
+	// Even a failed change has to reach the TextureResidencyManager
+	getManager().onTextureStreamed(this);
+	return err;
+}
+
+void TextureResource::applyResidencyChange()
+{
+	// It was unregistered after its change was done
+	if(m_residencyHandle == INVALID_TEXTURE_RESIDENCY_HANDLE)
+	{
+		return;
+	}
+
+	if(m_streamedTex.isCreated())
+	{
+		m_tex = std::move(m_streamedTex);
+		m_texView = std::move(m_streamedTexView);
+		m_firstMip = m_streamedFirstMip;
+	}
+
+	getManager().getTextureResidencyManager()->onResidencyChanged(m_residencyHandle, m_firstMip);
+}
+
+Bool TextureResource::hotReload(TextureResource& newer)
+{
+	if(m_residencyHandle != INVALID_TEXTURE_RESIDENCY_HANDLE)
+	{
+		getManager().unregisterStreamedTexture(this, m_residencyHandle);
+	}
+
+	// Nothing requests the mips of the newer so it has no residency changes in flight and its handle can be taken
+	m_residencyHandle = newer.m_residencyHandle;
+	newer.m_residencyHandle = INVALID_TEXTURE_RESIDENCY_HANDLE;
+	if(m_residencyHandle != INVALID_TEXTURE_RESIDENCY_HANDLE)
+	{
+		getManager().getTextureResidencyManager()->setUserData(m_residencyHandle, this);
+	}
+
+	m_tex = std::move(newer.m_tex);
+	m_texView = std::move(newer.m_texView);
+	m_sampler = std::move(newer.m_sampler);
+	m_size = newer.m_size;
+	m_layerCount = newer.m_layerCount;
+	m_fileSize = newer.m_fileSize;
+	m_firstMip = newer.m_firstMip;
+	m_streamedTex.reset(nullptr);
+	m_streamedTexView.reset(nullptr);
+
+	return true;
+}
+
 Error TextureResource::load(LoadingContext& ctx)
 {
 	const U copyCount = ctx.m_layerCount * ctx.m_faces * ctx.m_loader.getMipLevelsCount();
@@ -232,25 +448,22 @@ Error TextureResource::load(LoadingContext& ctx)
 			}
 		}
 
-		// Do the copies
-		Array<TransferGpuAllocatorHandle, MAX_COPIES_BEFORE_FLUSH> handles;
-		U handleCount = 0;
+		// Get the sizes of the batch
+		Array<PtrSize, MAX_COPIES_BEFORE_FLUSH> allocationSizes;
+		Array<PtrSize, MAX_COPIES_BEFORE_FLUSH> surfOrVolSizes;
+		Array<const void*, MAX_COPIES_BEFORE_FLUSH> surfOrVolDatas;
 		for(U i = begin; i < end; ++i)
 		{
 			U mip, layer, face;
 			unflatten3dArrayIndex(ctx.m_layerCount, ctx.m_faces, ctx.m_loader.getMipLevelsCount(), i, layer, face, mip);
 
-			PtrSize surfOrVolSize;
-			const void* surfOrVolData;
-			PtrSize allocationSize;
-
 			if(ctx.m_texType == TextureType::_3D)
 			{
 				const auto& vol = ctx.m_loader.getVolume(mip);
-				surfOrVolSize = vol.m_data.getSize();
-				surfOrVolData = &vol.m_data[0];
+				surfOrVolSizes[i - begin] = vol.getData().getSize();
+				surfOrVolDatas[i - begin] = vol.getData().getBegin();
 
-				allocationSize = computeVolumeSize(ctx.m_tex->getWidth() >> mip,
+				allocationSizes[i - begin] = computeVolumeSize(ctx.m_tex->getWidth() >> mip,
 					ctx.m_tex->getHeight() >> mip,
 					ctx.m_tex->getDepth() >> mip,
 					ctx.m_tex->getFormat());
@@ -258,20 +471,34 @@ Error TextureResource::load(LoadingContext& ctx)
 			else
 			{
 				const auto& surf = ctx.m_loader.getSurface(mip, face, layer);
-				surfOrVolSize = surf.m_data.getSize();
-				surfOrVolData = &surf.m_data[0];
+				surfOrVolSizes[i - begin] = surf.getData().getSize();
+				surfOrVolDatas[i - begin] = surf.getData().getBegin();
 
-				allocationSize = computeSurfaceSize(
+				allocationSizes[i - begin] = computeSurfaceSize(
 					ctx.m_tex->getWidth() >> mip, ctx.m_tex->getHeight() >> mip, ctx.m_tex->getFormat());
 			}
 
-			ANKI_ASSERT(allocationSize >= surfOrVolSize);
-			TransferGpuAllocatorHandle& handle = handles[handleCount++];
-			ANKI_CHECK(ctx.m_trfAlloc->allocate(allocationSize, handle));
+			ANKI_ASSERT(allocationSizes[i - begin] >= surfOrVolSizes[i - begin]);
+		}
+
+		// Allocate the staging memory of the whole batch at once. Allocating while holding handles might deadlock with
+		// the other loader threads
+		const U handleCount = end - begin;
+		Array<TransferGpuAllocatorHandle, MAX_COPIES_BEFORE_FLUSH> handles;
+		ANKI_CHECK(ctx.m_trfAlloc->allocate(ConstWeakArray<PtrSize>(&allocationSizes[0], handleCount),
+			WeakArray<TransferGpuAllocatorHandle>(&handles[0], handleCount)));
+
+		// Do the copies
+		for(U i = begin; i < end; ++i)
+		{
+			U mip, layer, face;
+			unflatten3dArrayIndex(ctx.m_layerCount, ctx.m_faces, ctx.m_loader.getMipLevelsCount(), i, layer, face, mip);
+
+			TransferGpuAllocatorHandle& handle = handles[i - begin];
 			void* data = handle.getMappedMemory();
 			ANKI_ASSERT(data);
 
-			memcpy(data, surfOrVolData, surfOrVolSize);
+			memcpy(data, surfOrVolDatas[i - begin], surfOrVolSizes[i - begin]);
 
 			// Create temp tex view
 			TextureSubresourceInfo subresource;
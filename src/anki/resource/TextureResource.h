@@ -6,11 +6,15 @@
 #pragma once
 
 #include <anki/resource/ResourceObject.h>
+#include <anki/resource/TextureResidency.h>
 #include <anki/Gr.h>
 
 namespace anki
 {
 
+// Forward
+class ImageLoader;
+
 /// @addtogroup resource
 /// @{
 
@@ -18,6 +22,10 @@ namespace anki
 ///
 /// It loads or creates an image and then loads it in the GPU. It supports compressed and uncompressed TGAs and AnKi's
 /// texture format.
+///
+/// If texture streaming is enabled the 2D AnKi textures are loaded with their small mips only. The rest of the mips are
+/// loaded later if requestResidency() asks for them and the TextureResidencyManager of the ResourceManager agrees.
+/// Loading or evicting mips creates a new texture and the new texture replaces the old one between frames.
 class TextureResource : public ResourceObject
 {
 public:
@@ -49,6 +57,11 @@ public:
 		return m_sampler;
 	}
 
+	/// Request the detail that is needed to draw the texture with some size on the screen. It's thread-safe.
+	/// @param pixels The size of the texture on the screen in pixels.
+	void requestResidency(F32 pixels) const;
+
+	/// Get the width of the first mip that can be resident. The current texture may be smaller.
 	U getWidth() const
 	{
 		ANKI_ASSERT(m_size.x());
@@ -73,10 +86,21 @@ public:
 		return m_layerCount;
 	}
 
+anki_internal:
+	/// Start loading or evicting mips. The ResourceManager calls it for the changes of the TextureResidencyManager.
+	void startResidencyChange(const TextureResidencyChange& change);
+
+	/// Replace the texture with the one that has the streamed mips. The ResourceManager calls it between frames.
+	void applyResidencyChange();
+
+	/// Take the texture of a newer version of the same file. It's called between frames.
+	Bool hotReload(TextureResource& newer);
+
 private:
 	static constexpr U MAX_COPIES_BEFORE_FLUSH = 4;
 
 	class TexUploadTask;
+	class StreamTask;
 	class LoadingContext;
 
 	TexturePtr m_tex;
@@ -85,7 +109,24 @@ private:
 	UVec3 m_size = UVec3(0u);
 	U32 m_layerCount = 0;
 
+	/// @name Streaming
+	/// @{
+	TextureResidencyHandle m_residencyHandle = INVALID_TEXTURE_RESIDENCY_HANDLE;
+	UVec2 m_fileSize = UVec2(0u); ///< The size of the 1st mip of the file.
+	U8 m_firstMip = 0; ///< The first mip of the file that is resident.
+
+	/// The result of a StreamTask. If the textures are null the streaming has failed.
+	TexturePtr m_streamedTex;
+	TextureViewPtr m_streamedTexView;
+	U8 m_streamedFirstMip = 0;
+	/// @}
+
 	ANKI_USE_RESULT static Error load(LoadingContext& ctx);
+
+	/// Load the file again starting from a mip. It runs in the AsyncLoader.
+	ANKI_USE_RESULT Error streamMips(U32 firstMip);
+
+	void registerForStreaming(const ImageLoader& loader, Format format);
 };
 /// @}
 
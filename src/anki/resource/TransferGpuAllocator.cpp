@@ -116,32 +116,42 @@ Error TransferGpuAllocator::init(PtrSize maxSize, GrManager* gr, ResourceAllocat
 	return Error::NONE;
 }
 
-Error TransferGpuAllocator::allocate(PtrSize size, TransferGpuAllocatorHandle& handle)
+Error TransferGpuAllocator::allocate(ConstWeakArray<PtrSize> sizes, WeakArray<TransferGpuAllocatorHandle> handles)
 {
 	ANKI_TRACE_SCOPED_EVENT(RSRC_ALLOCATE_TRANSFER);
+	ANKI_ASSERT(sizes.getSize() > 0 && sizes.getSize() == handles.getSize());
 
 	const PtrSize frameSize = m_maxAllocSize / FRAME_COUNT;
 
-	LockGuard<Mutex> lock(m_mtx);
-
-	Frame* frame;
-	if(m_crntFrameAllocatedSize + size <= frameSize)
+	PtrSize size = 0;
+	for(PtrSize s : sizes)
 	{
-		// Have enough space in the frame
-
-		frame = &m_frames[m_frameCount];
+		size += s;
 	}
-	else
+	if(size > frameSize)
 	{
-		// Don't have enough space. Wait for next frame
+		// It would wait forever for a frame with enough space
+		ANKI_RESOURCE_LOGE("The handles don't fit in a frame of the transfer memory (%uMB > %uMB)",
+			U32(size / 1024 / 1024),
+			U32(frameSize / 1024 / 1024));
+		return Error::OUT_OF_MEMORY;
+	}
 
-		m_frameCount = (m_frameCount + 1) % FRAME_COUNT;
-		Frame& nextFrame = m_frames[m_frameCount];
+	LockGuard<Mutex> lock(m_mtx);
+
+	// Move to the next frame until there is enough space. The handles are allocated together so the caller doesn't
+	// hold any memory of the frames it waits for
+	while(m_crntFrameAllocatedSize + size > frameSize)
+	{
+		const U8 nextFrameIdx = (m_frameCount + 1) % FRAME_COUNT;
+		Frame& nextFrame = m_frames[nextFrameIdx];
 
-		// Wait for all memory to be released
-		while(nextFrame.m_pendingReleases != 0)
+		if(nextFrame.m_pendingReleases != 0)
 		{
+			// Wait for all memory to be released. Another thread might move to the next frame meanwhile so check
+			// everything again after waking up
 			m_condVar.wait(m_mtx);
+			continue;
 		}
 
 		// Wait all fences
@@ -157,15 +167,33 @@ Error TransferGpuAllocator::allocate(PtrSize size, TransferGpuAllocatorHandle& h
 		}
 
 		nextFrame.m_stackAlloc.reset();
+		m_frameCount = nextFrameIdx;
 		m_crntFrameAllocatedSize = 0;
-		frame = &nextFrame;
 	}
 
-	ANKI_CHECK(frame->m_stackAlloc.allocate(size, handle.m_handle));
-	handle.m_range = size;
-	handle.m_frame = frame - &m_frames[0];
+	Frame& frame = m_frames[m_frameCount];
+	for(U i = 0; i < sizes.getSize(); ++i)
+	{
+		const Error err = frame.m_stackAlloc.allocate(sizes[i], handles[i].m_handle);
+		if(err)
+		{
+			// Give back the handles that got memory
+			for(U j = 0; j < i; ++j)
+			{
+				--frame.m_pendingReleases;
+				handles[j].invalidate();
+			}
+
+			m_condVar.notifyAll();
+			return err;
+		}
+
+		handles[i].m_range = sizes[i];
+		handles[i].m_frame = m_frameCount;
+		++frame.m_pendingReleases;
+	}
+
 	m_crntFrameAllocatedSize += size;
-	++frame->m_pendingReleases;
 
 	return Error::NONE;
 }
@@ -185,7 +213,8 @@ void TransferGpuAllocator::release(TransferGpuAllocatorHandle& handle, FencePtr
 		ANKI_ASSERT(frame.m_pendingReleases > 0);
 		--frame.m_pendingReleases;
 
-		m_condVar.notifyOne();
+		// Many threads might wait for the frame
+		m_condVar.notifyAll();
 	}
 
 	handle.invalidate();
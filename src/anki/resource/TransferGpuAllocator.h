@@ -8,6 +8,7 @@
 #include <anki/resource/Common.h>
 #include <anki/gr/common/StackGpuAllocator.h>
 #include <anki/util/List.h>
+#include <anki/util/WeakArray.h>
 
 namespace anki
 {
@@ -100,7 +101,16 @@ public:
 
 	/// Allocate some transfer memory. If there is not enough memory it will block until some is releaced. It's
 	/// threadsafe.
-	ANKI_USE_RESULT Error allocate(PtrSize size, TransferGpuAllocatorHandle& handle);
+	/// @note Don't hold other handles while calling it. The memory they hold might be the one it waits for.
+	ANKI_USE_RESULT Error allocate(PtrSize size, TransferGpuAllocatorHandle& handle)
+	{
+		return allocate(ConstWeakArray<PtrSize>(&size, 1), WeakArray<TransferGpuAllocatorHandle>(&handle, 1));
+	}
+
+	/// Allocate the memory of many handles at once. Use it instead of many allocate() calls when the handles need to
+	/// be alive at the same time. It's threadsafe.
+	/// @note It fails with Error::OUT_OF_MEMORY if the sum of the sizes doesn't fit in a frame of the allocator.
+	ANKI_USE_RESULT Error allocate(ConstWeakArray<PtrSize> sizes, WeakArray<TransferGpuAllocatorHandle> handles);
 
 	/// Release the memory. It will not be recycled before the fence is signaled. It's threadsafe.
 	void release(TransferGpuAllocatorHandle& handle, FencePtr fence);
@@ -0,0 +1,320 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/LooseOctree.h>
+#include <anki/collision/Frustum.h>
+#include <anki/util/ParallelFor.h>
+
+namespace anki
+{
+
+/// The depth that gatherVisibleParallel() splits the tree to.
+const U32 PARALLEL_GATHER_SPLIT_DEPTH = 2;
+
+/// Spread the 10 lower bits of a number so there are 2 zero bits between them.
+static U32 spreadBits(U32 v)
+{
+	ANKI_ASSERT(v < (1u << 10));
+	v = (v | (v << 16)) & 0x030000FF;
+	v = (v | (v << 8)) & 0x0300F00F;
+	v = (v | (v << 4)) & 0x030C30C3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+/// The opposite of spreadBits.
+static U32 compactBits(U32 v)
+{
+	v &= 0x09249249;
+	v = (v | (v >> 2)) & 0x030C30C3;
+	v = (v | (v >> 4)) & 0x0300F00F;
+	v = (v | (v >> 8)) & 0x030000FF;
+	v = (v | (v >> 16)) & 0x000003FF;
+	return v;
+}
+
+LooseOctree::~LooseOctree()
+{
+	ANKI_ASSERT(getPlaceableCount() == 0);
+	if(m_nodes)
+	{
+		m_alloc.deleteArray(m_nodes, m_nodeCount);
+	}
+}
+
+void LooseOctree::init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth)
+{
+	ANKI_ASSERT(sceneAabbMin < sceneAabbMax);
+	ANKI_ASSERT(maxDepth <= MAX_DEPTH);
+	ANKI_ASSERT(m_nodes == nullptr);
+
+	m_maxDepth = maxDepth;
+	m_sceneAabbMin = sceneAabbMin;
+	m_sceneSize = sceneAabbMax - sceneAabbMin;
+
+	m_nodeCount = 0;
+	for(U32 depth = 0; depth <= maxDepth; ++depth)
+	{
+		m_depthOffsets[depth] = m_nodeCount;
+		m_nodeCount += 1u << (3u * depth);
+	}
+
+	m_nodes = m_alloc.newArray<Node>(m_nodeCount);
+}
+
+U32 LooseOctree::mortonEncode(U32 x, U32 y, U32 z)
+{
+	return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+void LooseOctree::mortonDecode(U32 morton, U32& x, U32& y, U32& z)
+{
+	x = compactBits(morton);
+	y = compactBits(morton >> 1);
+	z = compactBits(morton >> 2);
+}
+
+void LooseOctree::findNode(const Aabb& volume, U32& depth, U32& morton) const
+{
+	const Vec3 size = (volume.getMax() - volume.getMin()).xyz();
+	const Vec3 center = ((volume.getMin() + volume.getMax()) * 0.5f).xyz();
+
+	// Go as deep as the volume fits in a cell. Then it fits in the loose bounds of the cell that has its center
+	depth = 0;
+	while(depth < m_maxDepth)
+	{
+		const Vec3 childCellSize = computeCellSize(depth + 1);
+		if(size.x() > childCellSize.x() || size.y() > childCellSize.y() || size.z() > childCellSize.z())
+		{
+			break;
+		}
+		++depth;
+	}
+
+	// Volumes with a center outside the scene may not fit in the clamped cell. Move them up till they fit
+	while(depth > 0)
+	{
+		const Vec3 cellSize = computeCellSize(depth);
+		const I32 maxCoord = I32(1u << depth) - 1;
+		const Vec3 coordsf = (center - m_sceneAabbMin) / cellSize;
+		const U32 x = U32(clamp<I32>(I32(floor(coordsf.x())), 0, maxCoord));
+		const U32 y = U32(clamp<I32>(I32(floor(coordsf.y())), 0, maxCoord));
+		const U32 z = U32(clamp<I32>(I32(floor(coordsf.z())), 0, maxCoord));
+
+		const Aabb looseBox = computeLooseAabb(depth, x, y, z);
+		if(volume.getMin().xyz() >= looseBox.getMin().xyz() && volume.getMax().xyz() <= looseBox.getMax().xyz())
+		{
+			morton = mortonEncode(x, y, z);
+			return;
+		}
+
+		--depth;
+	}
+
+	// The root takes the rest
+	morton = 0;
+}
+
+void LooseOctree::place(const Aabb& volume, LooseOctreePlaceable* placeable)
+{
+	ANKI_ASSERT(placeable);
+	ANKI_ASSERT(m_nodes && "Forgot to init");
+
+	U32 depth, morton;
+	findNode(volume, depth, morton);
+
+	// Nothing to do if it stays in the same node
+	if(placeable->m_morton == morton && placeable->m_depth == depth)
+	{
+		return;
+	}
+
+	if(placeable->isPlaced())
+	{
+		remove(*placeable);
+	}
+
+	// Push it to the front of the node's list. The old head gets its m_prev after the push and a removal of the old
+	// head waits for that
+	Node& node = m_nodes[m_depthOffsets[depth] + morton];
+	placeable->m_prev.store(nullptr);
+	LooseOctreePlaceable* head = node.m_placeables.load(AtomicMemoryOrder::ACQUIRE);
+	do
+	{
+		placeable->m_next = head;
+	} while(!node.m_placeables.compareExchange(head, placeable, AtomicMemoryOrder::SEQ_CST));
+
+	if(head)
+	{
+		head->m_prev.store(placeable, AtomicMemoryOrder::SEQ_CST);
+	}
+
+	placeable->m_depth = U8(depth);
+	placeable->m_morton = morton;
+
+	// Update the counts of the node and its ancestors
+	for(U32 d = 0; d <= depth; ++d)
+	{
+		m_nodes[m_depthOffsets[d] + (morton >> (3u * (depth - d)))].m_subtreePlaceableCount.fetchAdd(1);
+	}
+}
+
+void LooseOctree::remove(LooseOctreePlaceable& placeable)
+{
+	ANKI_ASSERT(placeable.isPlaced());
+	const U32 depth = placeable.m_depth;
+	const U32 morton = placeable.m_morton;
+
+	Node& node = m_nodes[m_depthOffsets[depth] + morton];
+	{
+		LockGuard<SpinLock> lock(node.m_removeLock);
+
+		LooseOctreePlaceable* next = placeable.m_next;
+		while(true)
+		{
+			LooseOctreePlaceable* prev = placeable.m_prev.load(AtomicMemoryOrder::SEQ_CST);
+			if(prev)
+			{
+				// Not the head. The placements only touch the head so the neighbours are safe to change
+				prev->m_next = next;
+				if(next)
+				{
+					next->m_prev.store(prev, AtomicMemoryOrder::SEQ_CST);
+				}
+				break;
+			}
+
+			// Probably the head. If a placement pushed something in front of it wait for the placement to set m_prev
+			LooseOctreePlaceable* expectedHead = &placeable;
+			if(node.m_placeables.compareExchange(expectedHead, next, AtomicMemoryOrder::SEQ_CST))
+			{
+				if(next)
+				{
+					// The next is the head now. Don't overwrite the m_prev that a new placement might have set
+					LooseOctreePlaceable* expectedPrev = &placeable;
+					while(!next->m_prev.compareExchange(expectedPrev, nullptr, AtomicMemoryOrder::SEQ_CST)
+						  && expectedPrev == &placeable)
+					{
+					}
+				}
+				break;
+			}
+		}
+	}
+
+	placeable.m_prev.store(nullptr);
+	placeable.m_next = nullptr;
+	placeable.m_morton = MAX_U32;
+	placeable.m_depth = 0;
+
+	for(U32 d = 0; d <= depth; ++d)
+	{
+		m_nodes[m_depthOffsets[d] + (morton >> (3u * (depth - d)))].m_subtreePlaceableCount.fetchSub(1);
+	}
+}
+
+void LooseOctree::gatherVisible(const Frustum& frustum,
+	OctreeNodeVisibilityTestCallback testCallback,
+	void* testCallbackUserData,
+	DynamicArrayAuto<void*>& out) const
+{
+	ANKI_ASSERT(m_nodes && "Forgot to init");
+
+	walkTree(
+		[&](const Aabb& box) {
+			Bool visible = frustum.insideFrustum(box);
+			if(visible && testCallback)
+			{
+				visible = testCallback(testCallbackUserData, box);
+			}
+			return visible;
+		},
+		[&](void* placeableUserData) { out.emplaceBack(placeableUserData); });
+}
+
+void LooseOctree::gatherVisibleParallel(const Frustum& frustum,
+	OctreeNodeVisibilityTestCallback testCallback,
+	void* testCallbackUserData,
+	DynamicArrayAuto<void*>& out,
+	ThreadHive& hive) const
+{
+	ANKI_ASSERT(m_nodes && "Forgot to init");
+
+	auto testFunc = [&](const Aabb& box) {
+		Bool visible = frustum.insideFrustum(box);
+		if(visible && testCallback)
+		{
+			visible = testCallback(testCallbackUserData, box);
+		}
+		return visible;
+	};
+
+	// The nodes above the split depth are few. Gather their placeables serially. Their subtrees are visible or not
+	// depending on the nodes of the split depth
+	const U32 splitDepth = min(PARALLEL_GATHER_SPLIT_DEPTH, m_maxDepth);
+	for(U32 depth = 0; depth < splitDepth; ++depth)
+	{
+		for(U32 morton = 0; morton < (1u << (3u * depth)); ++morton)
+		{
+			const Node& node = getNode(depth, morton);
+			if(node.m_placeables.load() == nullptr)
+			{
+				continue;
+			}
+
+			U32 x, y, z;
+			mortonDecode(morton, x, y, z);
+			if(depth == 0 || testFunc(computeLooseAabb(depth, x, y, z)))
+			{
+				for(const LooseOctreePlaceable* placeable = node.m_placeables.load(); placeable;
+					placeable = placeable->m_next)
+				{
+					out.emplaceBack(placeable->m_userData);
+				}
+			}
+		}
+	}
+
+	// Walk the subtrees of the split depth in parallel. The results are batched to keep the lock cold
+	SpinLock outLock;
+	Error err = parallelFor(hive, 0, 1u << (3u * splitDepth), 1, [&](PtrSize begin, PtrSize end, U32) -> Error {
+		Array<void*, 64> batch;
+		U32 batchCount = 0;
+
+		auto flush = [&]() {
+			LockGuard<SpinLock> lock(outLock);
+			for(U32 i = 0; i < batchCount; ++i)
+			{
+				out.emplaceBack(batch[i]);
+			}
+			batchCount = 0;
+		};
+
+		auto newPlaceableFunc = [&](void* placeableUserData) {
+			batch[batchCount++] = placeableUserData;
+			if(batchCount == batch.getSize())
+			{
+				flush();
+			}
+		};
+
+		for(PtrSize morton = begin; morton < end; ++morton)
+		{
+			U32 x, y, z;
+			mortonDecode(U32(morton), x, y, z);
+			walkTreeInternal(splitDepth, x, y, z, U32(morton), testFunc, newPlaceableFunc);
+		}
+
+		if(batchCount)
+		{
+			flush();
+		}
+
+		return Error::NONE;
+	});
+	(void)err;
+}
+
+} // end namespace anki
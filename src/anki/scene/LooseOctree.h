@@ -0,0 +1,205 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Octree.h>
+#include <anki/util/Thread.h>
+
+namespace anki
+{
+
+// Forward
+class LooseOctreePlaceable;
+
+/// @addtogroup scene
+/// @{
+
+/// A loose octree for visibility tests. It's an alternative to Octree that is faster to update.
+///
+/// The bounds of every node are the bounds of its cell expanded by half the cell size on every side. That way every
+/// volume fits in a single node that is found in constant time from the volume's center and size. The nodes of all
+/// depths are pre-allocated in one flat array and the nodes of a depth are ordered by the Morton code of their cell.
+/// The children of a node are 8 consecutive elements so walking the tree touches contiguous memory.
+///
+/// Every node has a list of placeables and an atomic count of the placeables of its subtree. There is no global lock so
+/// many threads can place and remove placeables at the same time. Placing pushes to the front of the list with a CAS
+/// and never blocks. The removals from a node take a lock of the node to serialize with each other but they don't block
+/// the placements. Re-placing a placeable that stays in the same node doesn't touch any shared state.
+class LooseOctree : public NonCopyable
+{
+public:
+	static const U32 MAX_DEPTH = 7;
+
+	LooseOctree(SceneAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	~LooseOctree();
+
+	void init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth);
+
+	/// Place or re-place an element in the tree.
+	/// @note It's thread-safe against place and remove of other placeables.
+	void place(const Aabb& volume, LooseOctreePlaceable* placeable);
+
+	/// Remove an element from the tree.
+	/// @note It's thread-safe against place and remove of other placeables.
+	void remove(LooseOctreePlaceable& placeable);
+
+	/// Gather visible placeables.
+	/// @param frustum The frustum to test against.
+	/// @param testCallback A ptr to a function that will be used to perform an additional test to the box of the
+	///                     node. Can be nullptr.
+	/// @param testCallbackUserData Parameter to the testCallback. Can be nullptr.
+	/// @param out The output of the tests.
+	/// @note It's thread-safe against other gather calls but not against place and remove.
+	void gatherVisible(const Frustum& frustum,
+		OctreeNodeVisibilityTestCallback testCallback,
+		void* testCallbackUserData,
+		DynamicArrayAuto<void*>& out) const;
+
+	/// Similar to gatherVisible but the subtrees are walked by the threads of a ThreadHive. It waits for the hive so
+	/// it can't be called from inside a ThreadHiveTaskCallback.
+	void gatherVisibleParallel(const Frustum& frustum,
+		OctreeNodeVisibilityTestCallback testCallback,
+		void* testCallbackUserData,
+		DynamicArrayAuto<void*>& out,
+		ThreadHive& hive) const;
+
+	/// Walk the tree. Every placeable is visited once.
+	/// @tparam TTestAabbFunc The lambda that will test an Aabb. Signature of lambda: Bool(*)(const Aabb& nodeBox)
+	/// @tparam TNewPlaceableFunc The lambda to do something with a visible placeable.
+	///                           Signature: void(*)(void* placeableUserData).
+	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+	void walkTree(TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc) const
+	{
+		walkTreeInternal(0, 0, 0, 0, 0, testFunc, newPlaceableFunc);
+	}
+
+	U32 getPlaceableCount() const
+	{
+		return (m_nodes) ? m_nodes[0].m_subtreePlaceableCount.load() : 0;
+	}
+
+private:
+	class Node
+	{
+	public:
+		Atomic<LooseOctreePlaceable*> m_placeables = {nullptr};
+		SpinLock m_removeLock;
+		Atomic<U32> m_subtreePlaceableCount = {0};
+	};
+
+	SceneAllocator<U8> m_alloc;
+	Node* m_nodes = nullptr;
+	U32 m_nodeCount = 0;
+	Array<U32, MAX_DEPTH + 1> m_depthOffsets; ///< Where the nodes of a depth start.
+	U32 m_maxDepth = 0;
+	Vec3 m_sceneAabbMin = Vec3(0.0f);
+	Vec3 m_sceneSize = Vec3(0.0f);
+
+	const Node& getNode(U32 depth, U32 morton) const
+	{
+		return m_nodes[m_depthOffsets[depth] + morton];
+	}
+
+	Vec3 computeCellSize(U32 depth) const
+	{
+		return m_sceneSize / F32(1u << depth);
+	}
+
+	/// The bounds of a node including the looseness.
+	Aabb computeLooseAabb(U32 depth, U32 x, U32 y, U32 z) const
+	{
+		const Vec3 cellSize = computeCellSize(depth);
+		const Vec3 cellMin = m_sceneAabbMin + Vec3(F32(x), F32(y), F32(z)) * cellSize;
+		return Aabb(cellMin - cellSize * 0.5f, cellMin + cellSize * 1.5f);
+	}
+
+	/// Find the node that a volume belongs to.
+	void findNode(const Aabb& volume, U32& depth, U32& morton) const;
+
+	static U32 mortonEncode(U32 x, U32 y, U32 z);
+	static void mortonDecode(U32 morton, U32& x, U32& y, U32& z);
+
+	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+	void walkTreeInternal(U32 depth,
+		U32 x,
+		U32 y,
+		U32 z,
+		U32 morton,
+		TTestAabbFunc& testFunc,
+		TNewPlaceableFunc& newPlaceableFunc) const;
+};
+
+/// An entity that can be placed in a LooseOctree.
+class LooseOctreePlaceable : public NonCopyable
+{
+	friend class LooseOctree;
+
+public:
+	void* m_userData = nullptr;
+
+	Bool isPlaced() const
+	{
+		return m_morton != MAX_U32;
+	}
+
+private:
+	/// It's set by the placement that pushes the next placeable to the list so it's atomic.
+	Atomic<LooseOctreePlaceable*> m_prev = {nullptr};
+	LooseOctreePlaceable* m_next = nullptr;
+	U32 m_morton = MAX_U32;
+	U8 m_depth = 0;
+};
+
+template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+inline void LooseOctree::walkTreeInternal(U32 depth,
+	U32 x,
+	U32 y,
+	U32 z,
+	U32 morton,
+	TTestAabbFunc& testFunc,
+	TNewPlaceableFunc& newPlaceableFunc) const
+{
+	const Node& node = getNode(depth, morton);
+	if(node.m_subtreePlaceableCount.load() == 0)
+	{
+		return;
+	}
+
+	// The root is not tested because it holds the volumes that don't fit anywhere else
+	if(depth > 0 && !testFunc(computeLooseAabb(depth, x, y, z)))
+	{
+		return;
+	}
+
+	ANKI_TRACE_INC_COUNTER(OCTREE_VISIBLE_LEAFS, 1);
+
+	for(const LooseOctreePlaceable* placeable = node.m_placeables.load(); placeable; placeable = placeable->m_next)
+	{
+		ANKI_ASSERT(placeable->m_userData);
+		newPlaceableFunc(placeable->m_userData);
+	}
+
+	if(depth < m_maxDepth)
+	{
+		for(U32 i = 0; i < 8; ++i)
+		{
+			walkTreeInternal(depth + 1,
+				(x << 1) | (i & 1),
+				(y << 1) | ((i >> 1) & 1),
+				(z << 1) | (i >> 2),
+				(morton << 3) | i,
+				testFunc,
+				newPlaceableFunc);
+		}
+	}
+}
+/// @}
+
+} // end namespace anki
@@ -66,6 +66,12 @@ Error ModelPatchNode::init(const ModelPatch* modelPatch, U idx, const ModelNode&
 	return Error::NONE;
 }
 
+/// Fold the scale of the quantized positions to the world transform.
+static Mat4 computeModelTransform(const Transform& worldTrf, F32 positionScale)
+{
+	return Mat4(Transform(worldTrf.getOrigin(), worldTrf.getRotation(), worldTrf.getScale() * positionScale));
+}
+
 void ModelPatchNode::drawCallback(RenderQueueDrawContext& ctx, ConstWeakArray<void*> userData)
 {
 	ANKI_ASSERT(userData.getSize() > 0 && userData.getSize() <= MAX_INSTANCES);
@@ -104,11 +110,11 @@ void ModelPatchNode::drawCallback(RenderQueueDrawContext& ctx, ConstWeakArray<vo
 
 	// Uniforms
 	Array<Mat4, MAX_INSTANCES> trfs;
-	trfs[0] = Mat4(self.getParent()->getComponentAt<MoveComponent>(0).getWorldTransform());
-	for(U i = 1; i < userData.getSize(); ++i)
+	for(U i = 0; i < userData.getSize(); ++i)
 	{
 		const ModelPatchNode& self2 = *static_cast<const ModelPatchNode*>(userData[i]);
-		trfs[i] = Mat4(self2.getParent()->getComponentAt<MoveComponent>(0).getWorldTransform());
+		trfs[i] = computeModelTransform(
+			self2.getParent()->getComponentAt<MoveComponent>(0).getWorldTransform(), modelInf.m_positionScale);
 	}
 
 	static_cast<const MaterialRenderComponent&>(self.getComponentAt<RenderComponent>(1))
@@ -293,11 +299,11 @@ void ModelNode::drawCallback(RenderQueueDrawContext& ctx, ConstWeakArray<void*>
 
 		// Uniforms
 		Array<Mat4, MAX_INSTANCES> trfs;
-		trfs[0] = Mat4(self.getComponent<MoveComponent>().getWorldTransform());
-		for(U i = 1; i < userData.getSize(); ++i)
+		for(U i = 0; i < userData.getSize(); ++i)
 		{
 			const ModelNode& self2 = *static_cast<const ModelNode*>(userData[i]);
-			trfs[i] = Mat4(self2.getComponent<MoveComponent>().getWorldTransform());
+			trfs[i] = computeModelTransform(
+				self2.getComponent<MoveComponent>().getWorldTransform(), modelInf.m_positionScale);
 		}
 
 		static_cast<const MaterialRenderComponent&>(self.getComponent<RenderComponent>())
@@ -14,35 +14,11 @@
 #include <anki/renderer/MainRenderer.h>
 #include <anki/misc/ConfigSet.h>
 #include <anki/util/ThreadPool.h>
+#include <anki/util/ParallelFor.h>
 
 namespace anki
 {
 
-const U NODE_UPDATE_BATCH = 10;
-
-class UpdateSceneNodesCtx
-{
-public:
-	SceneGraph* m_scene = nullptr;
-
-	IntrusiveList<SceneNode>::Iterator m_crntNode;
-	SpinLock m_crntNodeLock;
-
-	Second m_prevUpdateTime;
-	Second m_crntTime;
-};
-
-class UpdateSceneNodesTask : public ThreadPoolTask
-{
-public:
-	UpdateSceneNodesCtx* m_ctx;
-
-	Error operator()(U32 taskId, PtrSize threadsCount)
-	{
-		return m_ctx->m_scene->updateNodes(*m_ctx);
-	}
-};
-
 SceneGraph::SceneGraph()
 {
 }
@@ -56,6 +32,7 @@ SceneGraph::~SceneGraph()
 	(void)err;
 
 	deleteNodesMarkedForDeletion();
+	m_componentLists.destroy(m_alloc);
 
 	if(m_octree)
 	{
@@ -84,9 +61,15 @@ Error SceneGraph::init(AllocAlignedCallback allocCb,
 	m_scriptManager = scriptManager;
 
 	m_alloc = SceneAllocator<U8>(allocCb, allocCbData);
-	m_frameAlloc = SceneFrameAllocator<U8>(allocCb, allocCbData, 1 * 1024 * 1024);
+	// Every thread of the hive gets its own frame arena. The extra one is for the main thread
+	m_frameAlloc = SceneFrameAllocator<U8>(
+		allocCb, allocCbData, 1 * 1024 * 1024, 2.0, 0, true, ANKI_SAFE_ALIGNMENT, m_threadHive->getThreadCount() + 1);
 
 	m_earlyZDist = config.getNumber("scene.earlyZDistance");
+	m_screenHeight = config.getNumber("height");
+	m_lodScreenSizes[0] = config.getNumber("scene.lodScreenSize0");
+	m_lodScreenSizes[1] = config.getNumber("scene.lodScreenSize1");
+	m_lodHysteresis = config.getNumber("scene.lodHysteresis");
 
 	ANKI_CHECK(m_events.init(this));
 
@@ -211,9 +194,6 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 		deleteNodesMarkedForDeletion();
 	}
 
-	ThreadPool& threadPool = *m_threadpool;
-	(void)threadPool;
-
 	// Update
 	{
 		ANKI_TRACE_SCOPED_EVENT(SCENE_PHYSICS_UPDATE);
@@ -225,21 +205,7 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 		ANKI_CHECK(m_events.updateAllEvents(prevUpdateTime, crntTime));
 
 		// Then the rest
-		Array<UpdateSceneNodesTask, ThreadPool::MAX_THREADS> jobs2;
-		UpdateSceneNodesCtx updateCtx;
-		updateCtx.m_scene = this;
-		updateCtx.m_crntNode = m_nodes.getBegin();
-		updateCtx.m_prevUpdateTime = prevUpdateTime;
-		updateCtx.m_crntTime = crntTime;
-
-		for(U i = 0; i < threadPool.getThreadCount(); i++)
-		{
-			UpdateSceneNodesTask& job = jobs2[i];
-			job.m_ctx = &updateCtx;
-			threadPool.assignNewTask(i, &job);
-		}
-
-		ANKI_CHECK(threadPool.waitForAllThreadsToFinish());
+		ANKI_CHECK(updateNodes(prevUpdateTime, crntTime));
 	}
 
 	m_stats.m_updateTime = HighRezTimer::getCurrentTime() - m_stats.m_updateTime;
@@ -253,85 +219,134 @@ void SceneGraph::doVisibilityTests(RenderQueue& rqueue)
 	m_stats.m_visibilityTestsTime = HighRezTimer::getCurrentTime() - m_stats.m_visibilityTestsTime;
 }
 
-Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
+Error SceneGraph::updateNodeComponents(
+	Second prevTime, Second crntTime, SceneNode& node, Timestamp& componentTimestamp)
 {
 	ANKI_TRACE_INC_COUNTER(SCENE_NODES_UPDATED, 1);
 
-	Error err = Error::NONE;
-
-	// Components update
-	Timestamp componentTimestam = 0;
-	err = node.iterateComponents([&](SceneComponent& comp) -> Error {
+	componentTimestamp = 0;
+	return node.iterateComponents([&](SceneComponent& comp) -> Error {
 		Bool updated = false;
 		Error e = comp.updateReal(prevTime, crntTime, updated);
-		componentTimestam = max(componentTimestam, comp.getTimestamp());
+		componentTimestamp = max(componentTimestamp, comp.getTimestamp());
 
 		return e;
 	});
+}
+
+Error SceneGraph::updateNodes(Second prevUpdateTime, Second crntTime)
+{
+	// Keep the world transforms of the previous frame. Walk the dense storage instead of the components
+	MoveComponentPool& movePool = m_componentLists.getMoveComponentPool();
+	ANKI_CHECK(
+		parallelFor(*m_threadHive, 0, movePool.getChunkCount(), 1, [&](PtrSize begin, PtrSize end, U32) -> Error {
+			for(PtrSize i = begin; i < end; ++i)
+			{
+				MoveComponentPool::Chunk& chunk = movePool.getChunkAt(i);
+				const U32 count = movePool.getChunkElementCount(i);
+				for(U32 j = 0; j < count; ++j)
+				{
+					chunk.m_prevWorldTransforms[j] = chunk.m_worldTransforms[j];
+				}
+			}
+
+			return Error::NONE;
+		}));
 
-	// Update children
-	if(!err)
+	// Flatten the hierarchy into levels. First the roots, then their children and so on
+	DynamicArrayAuto<SceneNode*> nodes(m_frameAlloc);
+	nodes.create(m_nodesCount);
+	DynamicArrayAuto<U32> levelOffsets(m_frameAlloc);
+	levelOffsets.create(m_nodesCount + 1);
+
+	U32 nodeCount = 0;
+	for(SceneNode& node : m_nodes)
 	{
-		err = node.visitChildren([&](SceneNode& child) -> Error { return updateNode(prevTime, crntTime, child); });
+		if(node.getParent() == nullptr)
+		{
+			nodes[nodeCount++] = &node;
+		}
 	}
 
-	// Frame update
-	if(!err)
+	U32 levelCount = 0;
+	U32 levelBegin = 0;
+	while(levelBegin < nodeCount)
 	{
-		err = node.frameUpdateComplete(prevTime, crntTime, componentTimestam);
+		const U32 levelEnd = nodeCount;
+		levelOffsets[levelCount++] = levelBegin;
+
+		for(U32 i = levelBegin; i < levelEnd; ++i)
+		{
+			Error err = nodes[i]->visitChildren([&](SceneNode& child) -> Error {
+				nodes[nodeCount++] = &child;
+				return Error::NONE;
+			});
+			(void)err;
+		}
+
+		levelBegin = levelEnd;
 	}
+	levelOffsets[levelCount] = nodeCount;
+	ANKI_ASSERT(nodeCount == m_nodesCount);
 
-	return err;
-}
+	DynamicArrayAuto<Timestamp> componentTimestamps(m_frameAlloc);
+	componentTimestamps.create(nodeCount);
 
-Error SceneGraph::updateNodes(UpdateSceneNodesCtx& ctx) const
-{
-	ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
+	m_stats.m_levelCount = levelCount;
+	for(Second& time : m_stats.m_levelUpdateTimes)
+	{
+		time = 0.0;
+	}
+
+	// Update the components top to bottom because the children need the transforms of their parents
+	for(U32 level = 0; level < levelCount; ++level)
+	{
+		const Second startTime = HighRezTimer::getCurrentTime();
+
+		ANKI_CHECK(parallelFor(*m_threadHive,
+			levelOffsets[level],
+			levelOffsets[level + 1],
+			0,
+			[&](PtrSize begin, PtrSize end, U32) -> Error {
+				ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
 
-	IntrusiveList<SceneNode>::Iterator& it = ctx.m_crntNode;
-	IntrusiveList<SceneNode>::ConstIterator end = m_nodes.getEnd();
-	SpinLock& lock = ctx.m_crntNodeLock;
+				for(PtrSize i = begin; i < end; ++i)
+				{
+					ANKI_CHECK(updateNodeComponents(prevUpdateTime, crntTime, *nodes[i], componentTimestamps[i]));
+				}
+
+				return Error::NONE;
+			}));
+
+		m_stats.m_levelUpdateTimes[min<U32>(level, MAX_SCENE_GRAPH_STATS_LEVELS - 1)] +=
+			HighRezTimer::getCurrentTime() - startTime;
+	}
 
-	Bool quit = false;
-	Error err = Error::NONE;
-	while(!quit && !err)
+	// Complete the frame update bottom to top so the parents run after their children
+	for(U32 level = levelCount; level-- > 0;)
 	{
-		// Fetch a few scene nodes
-		Array<SceneNode*, NODE_UPDATE_BATCH> nodes = {{
-			nullptr,
-		}};
-		lock.lock();
-		for(SceneNode*& node : nodes)
-		{
-			if(it != end)
-			{
-				node = &(*it);
-				++it;
-			}
-		}
-		lock.unlock();
+		const Second startTime = HighRezTimer::getCurrentTime();
 
-		// Process nodes
-		U count = 0;
-		for(U i = 0; i < nodes.getSize(); ++i)
-		{
-			if(nodes[i])
-			{
-				if(nodes[i]->getParent() == nullptr)
+		ANKI_CHECK(parallelFor(*m_threadHive,
+			levelOffsets[level],
+			levelOffsets[level + 1],
+			0,
+			[&](PtrSize begin, PtrSize end, U32) -> Error {
+				ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
+
+				for(PtrSize i = begin; i < end; ++i)
 				{
-					err = updateNode(ctx.m_prevUpdateTime, ctx.m_crntTime, *nodes[i]);
+					ANKI_CHECK(nodes[i]->frameUpdateComplete(prevUpdateTime, crntTime, componentTimestamps[i]));
 				}
-				++count;
-			}
-		}
 
-		if(ANKI_UNLIKELY(count == 0))
-		{
-			quit = true;
-		}
+				return Error::NONE;
+			}));
+
+		m_stats.m_levelUpdateTimes[min<U32>(level, MAX_SCENE_GRAPH_STATS_LEVELS - 1)] +=
+			HighRezTimer::getCurrentTime() - startTime;
 	}
 
-	return err;
+	return Error::NONE;
 }
 
 } // end namespace anki
@@ -13,6 +13,7 @@
 #include <anki/util/HashMap.h>
 #include <anki/core/App.h>
 #include <anki/scene/events/EventManager.h>
+#include <anki/resource/Common.h>
 
 namespace anki
 {
@@ -24,25 +25,30 @@ class CameraNode;
 class Input;
 class ConfigSet;
 class PerspectiveCameraNode;
-class UpdateSceneNodesCtx;
 class Octree;
 
 /// @addtogroup scene
 /// @{
 
+/// The number of hierarchy levels that SceneGraphStats tracks. The time of deeper levels goes to the last one.
+const U MAX_SCENE_GRAPH_STATS_LEVELS = 8;
+
 /// SceneGraph statistics.
 class SceneGraphStats
 {
 public:
 	Second m_updateTime ANKI_DBG_NULLIFY;
 	Second m_visibilityTestsTime ANKI_DBG_NULLIFY;
+
+	/// The time spent updating the nodes of each hierarchy level. Level 0 is the roots.
+	Array<Second, MAX_SCENE_GRAPH_STATS_LEVELS> m_levelUpdateTimes ANKI_DBG_NULLIFY;
+	U32 m_levelCount ANKI_DBG_NULLIFY; ///< The number of hierarchy levels of the last update.
 };
 
 /// The scene graph that  all the scene entities
 class SceneGraph
 {
 	friend class SceneNode;
-	friend class UpdateSceneNodesTask;
 
 public:
 	SceneGraph();
@@ -230,6 +236,12 @@ anki_internal:
 		return m_earlyZDist;
 	}
 
+	/// The height of the screen in pixels. Visibility uses it to request texture detail.
+	F32 getScreenHeight() const
+	{
+		return m_screenHeight;
+	}
+
 	Octree& getOctree()
 	{
 		ANKI_ASSERT(m_octree);
@@ -258,6 +270,7 @@ private:
 
 	SceneNode* m_mainCam = nullptr;
 	Timestamp m_activeCameraChangeTimestamp = 0;
+	Timestamp m_visibilityTestsTimestamp = 0; ///< The global timestamp of the last visibility tests.
 	PerspectiveCameraNode* m_defaultMainCam = nullptr;
 
 	EventManager m_events;
@@ -276,6 +289,9 @@ private:
 	SceneComponentLists m_componentLists;
 
 	F32 m_earlyZDist = -1.0;
+	F32 m_screenHeight = 0.0;
+	Array<F32, MAX_LOD_COUNT - 1> m_lodScreenSizes; ///< The screen sizes where every LOD after the 1st starts.
+	F32 m_lodHysteresis = 0.0;
 
 	SceneGraphStats m_stats;
 
@@ -286,8 +302,11 @@ private:
 	/// Delete the nodes that are marked for deletion
 	void deleteNodesMarkedForDeletion();
 
-	ANKI_USE_RESULT Error updateNodes(UpdateSceneNodesCtx& ctx) const;
-	ANKI_USE_RESULT static Error updateNode(Second prevTime, Second crntTime, SceneNode& node);
+	/// Update all the nodes in parallel. The hierarchy is flattened into levels and the nodes of a level are updated
+	/// concurrently.
+	ANKI_USE_RESULT Error updateNodes(Second prevUpdateTime, Second crntTime);
+	ANKI_USE_RESULT static Error updateNodeComponents(
+		Second prevTime, Second crntTime, SceneNode& node, Timestamp& componentTimestamp);
 
 	/// Do visibility tests.
 	static void doVisibilityTests(SceneNode& frustumable, SceneGraph& scene, RenderQueue& rqueue);
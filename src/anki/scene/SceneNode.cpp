@@ -13,6 +13,11 @@ SceneNode::SceneNode(SceneGraph* scene, CString name)
 	: m_scene(scene)
 	, m_uuid(scene->getNewUuid())
 {
+	for(U8& idx : m_componentIndicesByType)
+	{
+		idx = MAX_U8;
+	}
+
 	if(name)
 	{
 		m_name.create(getSceneAllocator(), name);
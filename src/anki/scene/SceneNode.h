@@ -135,36 +135,20 @@ public:
 		return err;
 	}
 
-	/// Try geting a pointer to the first component of the requested type
+	/// Try geting a pointer to the last added component of the requested type. It's O(1).
 	template<typename Component>
 	Component* tryGetComponent()
 	{
-		U count = m_components.getSize();
-		while(count-- != 0)
-		{
-			SceneComponent* comp = m_components[count];
-			if(comp->getType() == Component::CLASS_TYPE)
-			{
-				return static_cast<Component*>(comp);
-			}
-		}
-		return nullptr;
+		const U8 idx = m_componentIndicesByType[Component::CLASS_TYPE];
+		return (idx != MAX_U8) ? static_cast<Component*>(m_components[idx]) : nullptr;
 	}
 
-	/// Try geting a pointer to the first component of the requested type
+	/// Try geting a pointer to the last added component of the requested type. It's O(1).
 	template<typename Component>
 	const Component* tryGetComponent() const
 	{
-		U count = m_components.getSize();
-		while(count-- != 0)
-		{
-			const SceneComponent* comp = m_components[count];
-			if(comp->getType() == Component::CLASS_TYPE)
-			{
-				return static_cast<const Component*>(comp);
-			}
-		}
-		return nullptr;
+		const U8 idx = m_componentIndicesByType[Component::CLASS_TYPE];
+		return (idx != MAX_U8) ? static_cast<const Component*>(m_components[idx]) : nullptr;
 	}
 
 	/// Get a pointer to the first component of the requested type
@@ -212,6 +196,8 @@ protected:
 	TComponent* newComponent(TArgs&&... args)
 	{
 		TComponent* comp = getSceneAllocator().newInstance<TComponent>(this, std::forward<TArgs>(args)...);
+		ANKI_ASSERT(m_components.getSize() < MAX_U8);
+		m_componentIndicesByType[comp->getType()] = U8(m_components.getSize());
 		m_components.emplaceBack(getSceneAllocator(), comp);
 		return comp;
 	}
@@ -228,6 +214,7 @@ private:
 	SceneGraph* m_scene = nullptr;
 
 	DynamicArray<SceneComponent*> m_components;
+	Array<U8, U(SceneComponentType::COUNT)> m_componentIndicesByType; ///< Index in m_components or MAX_U8.
 
 	String m_name; ///< A unique name
 	BitMask<Flag> m_flags;
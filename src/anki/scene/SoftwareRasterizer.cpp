@@ -6,10 +6,23 @@
 #include <anki/scene/SoftwareRasterizer.h>
 #include <anki/collision/Functions.h>
 #include <anki/core/Trace.h>
+#include <anki/util/ParallelFor.h>
+#include <anki/math/Simd.h>
 
 namespace anki
 {
 
+const U32 TILE_PIXEL_COUNT = SoftwareRasterizer::TILE_SIZE * SoftwareRasterizer::TILE_SIZE;
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+/// Mask the lanes of a group of 4 pixels that starts from x that are inside [minX, maxX).
+static ANKI_USE_RESULT __m128 computeLaneMask(U32 x, U32 minX, U32 maxX)
+{
+	const __m128 lanes = _mm_add_ps(_mm_set1_ps(F32(x)), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+	return _mm_and_ps(_mm_cmpge_ps(lanes, _mm_set1_ps(F32(minX))), _mm_cmplt_ps(lanes, _mm_set1_ps(F32(maxX))));
+}
+#endif
+
 void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U width, U height)
 {
 	m_mv = mv;
@@ -24,17 +37,43 @@ void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U width, U heigh
 		{&m_planesW[0], &m_planesW[1], &m_planesW[2], &m_planesW[3], &m_planesW[4], &m_planesW[5]}};
 	extractClipPlanes(m_mvp, planes2);
 
-	// Reset z buffer
+	// Allocate
 	ANKI_ASSERT(width > 0 && height > 0);
 	m_width = width;
 	m_height = height;
-	U size = width * height;
-	if(m_zbuffer.getSize() < size)
+	m_tileCountX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileCountY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	const U32 tileCount = getTileCount();
+	if(m_zbuffer.getSize() < tileCount * TILE_PIXEL_COUNT)
 	{
 		m_zbuffer.destroy(m_alloc);
-		m_zbuffer.create(m_alloc, size);
+		m_zbuffer.create(m_alloc, tileCount * TILE_PIXEL_COUNT);
+	}
+
+	if(m_tileMaxDepths.getSize() < tileCount)
+	{
+		m_tileMaxDepths.destroy(m_alloc);
+		m_tileMaxDepths.create(m_alloc, tileCount);
+	}
+
+	// Reset z buffer. The pixels outside the window are zero so they don't affect the HiZ
+	for(U32 tile = 0; tile < tileCount; ++tile)
+	{
+		const U32 tileMinX = (tile % m_tileCountX) * TILE_SIZE;
+		const U32 tileMinY = (tile / m_tileCountX) * TILE_SIZE;
+		F32* depths = &m_zbuffer[tile * TILE_PIXEL_COUNT];
+		for(U32 y = 0; y < TILE_SIZE; ++y)
+		{
+			for(U32 x = 0; x < TILE_SIZE; ++x)
+			{
+				depths[y * TILE_SIZE + x] = (tileMinX + x < width && tileMinY + y < height) ? 1.0f : 0.0f;
+			}
+		}
+
+		m_tileMaxDepths[tile] = 1.0f;
 	}
-	memset(&m_zbuffer[0], 0xFF, sizeof(m_zbuffer[0]) * size);
+
+	m_triangleCount = 0;
 }
 
 void SoftwareRasterizer::clipTriangle(const Vec4* inVerts, Vec4* outVerts, U& outVertCount) const
@@ -173,6 +212,12 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 	ANKI_ASSERT(verts && vertCount > 0 && (vertCount % 3) == 0);
 	ANKI_ASSERT(stride >= sizeof(F32) * 3 && (stride % sizeof(F32)) == 0);
 
+	const Vec2 windowSize(m_width, m_height);
+
+	// Gather the triangles in batches to keep the lock cold
+	Array<Triangle, 64> batch;
+	U32 batchCount = 0;
+
 	U floatStride = stride / sizeof(F32);
 	const F32* vertsEnd = verts + vertCount * floatStride;
 	while(verts != vertsEnd)
@@ -208,99 +253,295 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 			continue;
 		}
 
-		// Rasterize
-		Array<Vec4, 3> clip;
+		// Project to window space
 		for(U j = 0; j < clippedCount; j += 3)
 		{
+			Triangle& tri = batch[batchCount++];
 			for(U k = 0; k < 3; k++)
 			{
-				clip[k] = m_p * clippedTrisVspace[j + k].xyz1();
-				ANKI_ASSERT(clip[k].w() > 0.0f);
+				const Vec4 clip = m_p * clippedTrisVspace[j + k].xyz1();
+				ANKI_ASSERT(clip.w() > 0.0f);
+
+				const Vec3 ndc = clip.xyz() / clip.w();
+				tri.m_verts[k] = Vec3((ndc.xy() / 2.0f + 0.5f) * windowSize, ndc.z());
 			}
 
-			rasterizeTriangle(&clip[0]);
+			if(batchCount == batch.getSize())
+			{
+				appendTriangles(&batch[0], batchCount);
+				batchCount = 0;
+			}
 		}
 	}
+
+	if(batchCount)
+	{
+		appendTriangles(&batch[0], batchCount);
+	}
 }
 
-Bool SoftwareRasterizer::computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const
+void SoftwareRasterizer::appendTriangles(const Triangle* tris, U32 count)
 {
-	Vec2 dca = c - a;
-	Vec2 dba = b - a;
-	Vec2 dap = a - p;
-
-	Vec3 n(dca.x(), dba.x(), dap.x());
-	Vec3 m(dca.y(), dba.y(), dap.y());
+	LockGuard<SpinLock> lock(m_trianglesLock);
 
-	Vec3 k = n.cross(m);
-
-	Bool skip = false;
-	if(!isZero(k.z()))
+	if(m_triangles.getSize() < m_triangleCount + count)
 	{
-		uvw = Vec3(1.0 - (k.x() + k.y()) / k.z(), k.y() / k.z(), k.x() / k.z());
+		m_triangles.resize(m_alloc, max<PtrSize>(m_triangleCount + count, m_triangles.getSize() * 2));
+	}
 
-		if(uvw.x() < 0.0f || uvw.y() < 0.0f || uvw.z() < 0.0f)
-		{
-			skip = true;
-		}
+	for(U32 i = 0; i < count; ++i)
+	{
+		m_triangles[m_triangleCount++] = tris[i];
 	}
-	else
+}
+
+void SoftwareRasterizer::computeTriangleBounds(const Triangle& tri, U32& minX, U32& minY, U32& maxX, U32& maxY) const
+{
+	Vec2 bboxMin(MAX_F32), bboxMax(MIN_F32);
+	for(const Vec3& v : tri.m_verts)
 	{
-		skip = true;
+		bboxMin = bboxMin.min(v.xy());
+		bboxMax = bboxMax.max(v.xy());
 	}
 
-	return skip;
+	minX = U32(clamp(floorf(bboxMin.x()), 0.0f, F32(m_width)));
+	minY = U32(clamp(floorf(bboxMin.y()), 0.0f, F32(m_height)));
+	maxX = U32(clamp(ceilf(bboxMax.x()), 0.0f, F32(m_width)));
+	maxY = U32(clamp(ceilf(bboxMax.y()), 0.0f, F32(m_height)));
 }
 
-void SoftwareRasterizer::rasterizeTriangle(const Vec4* tri)
+void SoftwareRasterizer::binTriangles()
 {
-	ANKI_ASSERT(tri);
+	ANKI_TRACE_SCOPED_EVENT(SCENE_RASTERIZER_BIN);
 
-	const Vec2 windowSize(m_width, m_height);
-	Array<Vec3, 3> ndc;
-	Array<Vec2, 3> window;
-	Vec2 bboxMin(MAX_F32), bboxMax(MIN_F32);
-	for(U i = 0; i < 3; i++)
+	const U32 tileCount = getTileCount();
+	if(m_tileTriangleOffsets.getSize() < tileCount + 1)
 	{
-		ndc[i] = tri[i].xyz() / tri[i].w();
-		window[i] = (ndc[i].xy() / 2.0 + 0.5) * windowSize;
+		m_tileTriangleOffsets.destroy(m_alloc);
+		m_tileTriangleOffsets.create(m_alloc, tileCount + 1);
+	}
+	memset(&m_tileTriangleOffsets[0], 0, sizeof(U32) * (tileCount + 1));
 
-		for(U j = 0; j < 2; j++)
+	// Count the triangles of every tile
+	U32 indexCount = 0;
+	for(U32 i = 0; i < m_triangleCount; ++i)
+	{
+		U32 minX, minY, maxX, maxY;
+		computeTriangleBounds(m_triangles[i], minX, minY, maxX, maxY);
+		if(minX >= maxX || minY >= maxY)
 		{
-			bboxMin[j] = floor(min(bboxMin[j], window[i][j]));
-			bboxMin[j] = clamp(bboxMin[j], 0.0f, windowSize[j]);
+			continue;
+		}
 
-			bboxMax[j] = ceil(max(bboxMax[j], window[i][j]));
-			bboxMax[j] = clamp(bboxMax[j], 0.0f, windowSize[j]);
+		for(U32 ty = minY / TILE_SIZE; ty <= (maxY - 1) / TILE_SIZE; ++ty)
+		{
+			for(U32 tx = minX / TILE_SIZE; tx <= (maxX - 1) / TILE_SIZE; ++tx)
+			{
+				++m_tileTriangleOffsets[ty * m_tileCountX + tx];
+				++indexCount;
+			}
 		}
 	}
 
-	for(F32 y = bboxMin.y() + 0.5; y < bboxMax.y() + 0.5; y += 1.0)
+	// Turn the counts to the ends of the tile ranges
+	for(U32 tile = 1; tile < tileCount; ++tile)
+	{
+		m_tileTriangleOffsets[tile] += m_tileTriangleOffsets[tile - 1];
+	}
+	m_tileTriangleOffsets[tileCount] = indexCount;
+
+	if(indexCount == 0)
+	{
+		return;
+	}
+
+	if(m_tileTriangleIndices.getSize() < indexCount)
 	{
-		for(F32 x = bboxMin.x() + 0.5; x < bboxMax.x() + 0.5; x += 1.0)
+		m_tileTriangleIndices.destroy(m_alloc);
+		m_tileTriangleIndices.create(m_alloc, indexCount);
+	}
+
+	// Fill the ranges from the end. In the end the offsets point to the start of the ranges
+	for(U32 i = 0; i < m_triangleCount; ++i)
+	{
+		U32 minX, minY, maxX, maxY;
+		computeTriangleBounds(m_triangles[i], minX, minY, maxX, maxY);
+		if(minX >= maxX || minY >= maxY)
+		{
+			continue;
+		}
+
+		for(U32 ty = minY / TILE_SIZE; ty <= (maxY - 1) / TILE_SIZE; ++ty)
 		{
-			Vec2 p(x, y);
-			Vec3 bc;
-			if(!computeBarycetrinc(window[0], window[1], window[2], p, bc))
+			for(U32 tx = minX / TILE_SIZE; tx <= (maxX - 1) / TILE_SIZE; ++tx)
 			{
-				const F32 z0 = ndc[0].z();
-				const F32 z1 = ndc[1].z();
-				const F32 z2 = ndc[2].z();
+				m_tileTriangleIndices[--m_tileTriangleOffsets[ty * m_tileCountX + tx]] = i;
+			}
+		}
+	}
+}
 
-				F32 depth = z0 * bc[0] + z1 * bc[1] + z2 * bc[2];
-				ANKI_ASSERT(depth >= 0.0 && depth <= 1.0);
+void SoftwareRasterizer::rasterizeTiles(U32 firstTile, U32 tileCount)
+{
+	ANKI_ASSERT(firstTile + tileCount <= getTileCount());
+	ANKI_ASSERT(m_tileTriangleOffsets.getSize() > getTileCount() && "Forgot to bin");
+	ANKI_TRACE_SCOPED_EVENT(SCENE_RASTERIZER_RASTERIZE);
 
-				// Clamp it to a bit less that 1.0f because 1.0f will produce a 0 depthi
-				depth = min(depth, 1.0f - EPSILON);
+	for(U32 tile = firstTile; tile < firstTile + tileCount; ++tile)
+	{
+		if(m_tileTriangleOffsets[tile] < m_tileTriangleOffsets[tile + 1])
+		{
+			rasterizeTile(tile);
+			updateTileMaxDepth(tile);
+		}
+	}
+}
+
+void SoftwareRasterizer::rasterizeTile(U32 tile)
+{
+	const U32 tileMinX = (tile % m_tileCountX) * TILE_SIZE;
+	const U32 tileMinY = (tile / m_tileCountX) * TILE_SIZE;
+	F32* depths = &m_zbuffer[tile * TILE_PIXEL_COUNT];
 
-				// Store the min of the current value and new one
-				const U32 depthi = depth * MAX_U32;
-				m_zbuffer[U(y) * m_width + U(x)].min(depthi);
+	for(U32 idx = m_tileTriangleOffsets[tile]; idx < m_tileTriangleOffsets[tile + 1]; ++idx)
+	{
+		const Triangle& tri = m_triangles[m_tileTriangleIndices[idx]];
+
+		// Make the triangle counter clockwise in window space
+		Vec3 v0 = tri.m_verts[0];
+		Vec3 v1 = tri.m_verts[1];
+		Vec3 v2 = tri.m_verts[2];
+		F32 area = (v1.x() - v0.x()) * (v2.y() - v0.y()) - (v1.y() - v0.y()) * (v2.x() - v0.x());
+		if(area == 0.0f)
+		{
+			continue;
+		}
+		else if(area < 0.0f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		// The edge functions are E(x, y) = A * x + B * y + C and they are positive inside. Edge i is the one opposite
+		// to vertex i so E_i / area is the barycentric of vertex i
+		const Array<const Vec3*, 3> verts = {{&v0, &v1, &v2}};
+		Array<F32, 3> a, b, c;
+		for(U i = 0; i < 3; ++i)
+		{
+			const Vec3& from = *verts[(i + 1) % 3];
+			const Vec3& to = *verts[(i + 2) % 3];
+			a[i] = from.y() - to.y();
+			b[i] = to.x() - from.x();
+			c[i] = -(a[i] * from.x() + b[i] * from.y());
+		}
+
+		// The depth is a plane in window space
+		const F32 invArea = 1.0f / area;
+		const F32 zx = (v0.z() * a[0] + v1.z() * a[1] + v2.z() * a[2]) * invArea;
+		const F32 zy = (v0.z() * b[0] + v1.z() * b[1] + v2.z() * b[2]) * invArea;
+		const F32 z0 = (v0.z() * c[0] + v1.z() * c[1] + v2.z() * c[2]) * invArea;
+
+		// The pixels of the tile that the triangle may touch
+		U32 minX, minY, maxX, maxY;
+		computeTriangleBounds(tri, minX, minY, maxX, maxY);
+		minX = max(minX, tileMinX) - tileMinX;
+		minY = max(minY, tileMinY) - tileMinY;
+		maxX = min(maxX, tileMinX + TILE_SIZE) - tileMinX;
+		maxY = min(maxY, tileMinY + TILE_SIZE) - tileMinY;
+		ANKI_ASSERT(minX < maxX && minY < maxY);
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 a0 = _mm_set1_ps(a[0]);
+		const __m128 a1 = _mm_set1_ps(a[1]);
+		const __m128 a2 = _mm_set1_ps(a[2]);
+		const __m128 zx4 = _mm_set1_ps(zx);
+
+		for(U32 y = minY; y < maxY; ++y)
+		{
+			// Evaluate the parts of the functions that are constant across the row
+			const F32 py = F32(tileMinY + y) + 0.5f;
+			const __m128 row0 = _mm_set1_ps(b[0] * py + c[0]);
+			const __m128 row1 = _mm_set1_ps(b[1] * py + c[1]);
+			const __m128 row2 = _mm_set1_ps(b[2] * py + c[2]);
+			const __m128 rowZ = _mm_set1_ps(zy * py + z0);
+
+			for(U32 x = minX & ~3u; x < maxX; x += 4)
+			{
+				const __m128 px = _mm_add_ps(_mm_set1_ps(F32(tileMinX + x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+
+				const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), row0);
+				const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), row1);
+				const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), row2);
+
+				__m128 inside = computeLaneMask(x, minX, maxX);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(e0, zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(e1, zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(e2, zero));
+				if(_mm_movemask_ps(inside) == 0)
+				{
+					continue;
+				}
+
+				F32* dst = depths + y * TILE_SIZE + x;
+				const __m128 oldDepth = _mm_loadu_ps(dst);
+				const __m128 newDepth = _mm_min_ps(oldDepth, _mm_add_ps(_mm_mul_ps(zx4, px), rowZ));
+				_mm_storeu_ps(dst, _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
 			}
 		}
+#else
+		for(U32 y = minY; y < maxY; ++y)
+		{
+			const F32 py = F32(tileMinY + y) + 0.5f;
+			for(U32 x = minX; x < maxX; ++x)
+			{
+				const F32 px = F32(tileMinX + x) + 0.5f;
+				if(a[0] * px + b[0] * py + c[0] >= 0.0f && a[1] * px + b[1] * py + c[1] >= 0.0f
+					&& a[2] * px + b[2] * py + c[2] >= 0.0f)
+				{
+					F32& depth = depths[y * TILE_SIZE + x];
+					depth = min(depth, zx * px + zy * py + z0);
+				}
+			}
+		}
+#endif
 	}
 }
 
+void SoftwareRasterizer::updateTileMaxDepth(U32 tile)
+{
+	const F32* depths = &m_zbuffer[tile * TILE_PIXEL_COUNT];
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+	__m128 maxDepth = _mm_setzero_ps();
+	for(U32 i = 0; i < TILE_PIXEL_COUNT; i += 4)
+	{
+		maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(depths + i));
+	}
+
+	maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+	maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+	m_tileMaxDepths[tile] = _mm_cvtss_f32(maxDepth);
+#else
+	F32 maxDepth = 0.0f;
+	for(U32 i = 0; i < TILE_PIXEL_COUNT; ++i)
+	{
+		maxDepth = max(maxDepth, depths[i]);
+	}
+	m_tileMaxDepths[tile] = maxDepth;
+#endif
+}
+
+Error SoftwareRasterizer::rasterize(ThreadHive& hive)
+{
+	binTriangles();
+
+	return parallelFor(hive, 0, getTileCount(), 1, [this](PtrSize begin, PtrSize end, U32) -> Error {
+		rasterizeTiles(U32(begin), U32(end - begin));
+		return Error::NONE;
+	});
+}
+
 Bool SoftwareRasterizer::visibilityTest(const CollisionShape& cs, const Aabb& aabb) const
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_RASTERIZER_TEST);
@@ -363,31 +604,61 @@ Bool SoftwareRasterizer::visibilityTestInternal(const CollisionShape& cs, const
 	}
 
 	// Fix the bounds
-	bboxMin.x() = floorf(bboxMin.x());
-	bboxMin.x() = clamp(bboxMin.x(), 0.0f, F32(m_width));
-
-	bboxMax.x() = ceilf(bboxMax.x());
-	bboxMax.x() = clamp(bboxMax.x(), 0.0f, F32(m_width));
-
-	bboxMin.y() = floorf(bboxMin.y());
-	bboxMin.y() = clamp(bboxMin.y(), 0.0f, F32(m_height));
-
-	bboxMax.y() = ceilf(bboxMax.y());
-	bboxMax.y() = clamp(bboxMax.y(), 0.0f, F32(m_height));
+	const U32 minX = U32(clamp(floorf(bboxMin.x()), 0.0f, F32(m_width)));
+	const U32 minY = U32(clamp(floorf(bboxMin.y()), 0.0f, F32(m_height)));
+	const U32 maxX = U32(clamp(ceilf(bboxMax.x()), 0.0f, F32(m_width)));
+	const U32 maxY = U32(clamp(ceilf(bboxMax.y()), 0.0f, F32(m_height)));
+	if(minX >= maxX || minY >= maxY)
+	{
+		return false;
+	}
 
 	// Loop the tiles
-	F32 minZ = bboxMin.z();
-	for(U y = bboxMin.y(); y < bboxMax.y(); y += 1.0f)
+	const F32 minZ = bboxMin.z();
+	for(U32 ty = minY / TILE_SIZE; ty <= (maxY - 1) / TILE_SIZE; ++ty)
 	{
-		for(U x = bboxMin.x(); x < bboxMax.x(); x += 1.0f)
+		for(U32 tx = minX / TILE_SIZE; tx <= (maxX - 1) / TILE_SIZE; ++tx)
 		{
-			U idx = U(y) * m_width + U(x);
-			U32 depthi = m_zbuffer[idx].get();
-			F32 depthf = depthi / F32(MAX_U32);
-			if(minZ < depthf)
+			// Skip the tile if all of its pixels are closer than the box
+			const U32 tile = ty * m_tileCountX + tx;
+			if(minZ >= m_tileMaxDepths[tile])
+			{
+				continue;
+			}
+
+			const U32 tileMinX = tx * TILE_SIZE;
+			const U32 tileMinY = ty * TILE_SIZE;
+			const U32 beginX = max(minX, tileMinX) - tileMinX;
+			const U32 beginY = max(minY, tileMinY) - tileMinY;
+			const U32 endX = min(maxX, tileMinX + TILE_SIZE) - tileMinX;
+			const U32 endY = min(maxY, tileMinY + TILE_SIZE) - tileMinY;
+			const F32* depths = &m_zbuffer[tile * TILE_PIXEL_COUNT];
+
+#if ANKI_SIMD == ANKI_SIMD_SSE
+			const __m128 minZ4 = _mm_set1_ps(minZ);
+			for(U32 y = beginY; y < endY; ++y)
 			{
-				return true;
+				for(U32 x = beginX & ~3u; x < endX; x += 4)
+				{
+					const __m128 closer = _mm_cmplt_ps(minZ4, _mm_loadu_ps(depths + y * TILE_SIZE + x));
+					if(_mm_movemask_ps(_mm_and_ps(closer, computeLaneMask(x, beginX, endX))))
+					{
+						return true;
+					}
+				}
 			}
+#else
+			for(U32 y = beginY; y < endY; ++y)
+			{
+				for(U32 x = beginX; x < endX; ++x)
+				{
+					if(minZ < depths[y * TILE_SIZE + x])
+					{
+						return true;
+					}
+				}
+			}
+#endif
 		}
 	}
 
@@ -396,18 +667,21 @@ Bool SoftwareRasterizer::visibilityTestInternal(const CollisionShape& cs, const
 
 void SoftwareRasterizer::fillDepthBuffer(ConstWeakArray<F32> depthValues)
 {
-	ANKI_ASSERT(m_zbuffer.getSize() == depthValues.getSize());
+	ANKI_ASSERT(depthValues.getSize() == m_width * m_height);
 
-	U count = depthValues.getSize();
-	while(count--)
+	for(U32 y = 0; y < m_height; ++y)
 	{
-		F32 depth = depthValues[count];
-		ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
-
-		depth = min(depth, 1.0f - EPSILON); // See a few lines above why is that
+		for(U32 x = 0; x < m_width; ++x)
+		{
+			const F32 depth = depthValues[y * m_width + x];
+			ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
+			m_zbuffer[computePixelIndex(x, y)] = depth;
+		}
+	}
 
-		const U32 depthi = depth * MAX_U32;
-		m_zbuffer[count].set(depthi);
+	for(U32 tile = 0; tile < getTileCount(); ++tile)
+	{
+		updateTileMaxDepth(tile);
 	}
 }
 
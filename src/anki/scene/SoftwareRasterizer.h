@@ -9,17 +9,29 @@
 #include <anki/Math.h>
 #include <anki/collision/Plane.h>
 #include <anki/util/WeakArray.h>
+#include <anki/util/Thread.h>
 
 namespace anki
 {
 
+// Forward
+class ThreadHive;
+
 /// @addtogroup scene
 /// @{
 
 /// Software rasterizer for visibility tests.
+///
+/// The depth buffer is split in tiles of TILE_SIZE x TILE_SIZE pixels. The pixels of a tile are contiguous in memory.
+/// draw() only transforms and clips the triangles. The triangles are binned to the tiles they touch and then every
+/// tile is rasterized on its own using SIMD edge functions, so different tiles can be rasterized by different threads.
+/// Every tile also keeps the max depth of its pixels (a one level HiZ) that allows visibilityTest() to skip whole
+/// tiles.
 class SoftwareRasterizer
 {
 public:
+	static const U32 TILE_SIZE = 16;
+
 	SoftwareRasterizer()
 	{
 	}
@@ -27,6 +39,10 @@ public:
 	~SoftwareRasterizer()
 	{
 		m_zbuffer.destroy(m_alloc);
+		m_tileMaxDepths.destroy(m_alloc);
+		m_triangles.destroy(m_alloc);
+		m_tileTriangleOffsets.destroy(m_alloc);
+		m_tileTriangleIndices.destroy(m_alloc);
 	}
 
 	/// Initialize.
@@ -38,7 +54,7 @@ public:
 	/// Prepare for rendering. Call it before every draw.
 	void prepare(const Mat4& mv, const Mat4& p, U width, U height);
 
-	/// Render some verts.
+	/// Render some verts. The triangles are queued and rasterized later by rasterize() or rasterizeTiles().
 	/// @param[in] verts Pointer to the first vertex to draw.
 	/// @param vertCount The number of verts to draw.
 	/// @param stride The stride (in bytes) of the next vertex.
@@ -46,6 +62,18 @@ public:
 	/// @note It's thread-safe against other draw() invocations only.
 	void draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling);
 
+	/// Bin the triangles of the draw() calls to the tiles. Call it after all the draw() calls and before
+	/// rasterizeTiles().
+	void binTriangles();
+
+	/// Rasterize the binned triangles of a range of tiles.
+	/// @note It's thread-safe against other rasterizeTiles() invocations that work on different tiles.
+	void rasterizeTiles(U32 firstTile, U32 tileCount);
+
+	/// Bin and rasterize all the triangles of the draw() calls using the threads of a hive. It waits for the hive so
+	/// it can't be called from inside a ThreadHiveTaskCallback.
+	ANKI_USE_RESULT Error rasterize(ThreadHive& hive);
+
 	/// Fill the depth buffer with some values.
 	void fillDepthBuffer(ConstWeakArray<F32> depthValues);
 
@@ -55,7 +83,26 @@ public:
 	/// @return Return true if it's visible and false otherwise.
 	Bool visibilityTest(const CollisionShape& cs, const Aabb& aabb) const;
 
+	U32 getTileCount() const
+	{
+		return m_tileCountX * m_tileCountY;
+	}
+
+	/// Read the depth of a pixel. Used for debugging.
+	F32 getDepth(U32 x, U32 y) const
+	{
+		ANKI_ASSERT(x < m_width && y < m_height);
+		return m_zbuffer[computePixelIndex(x, y)];
+	}
+
 private:
+	/// A triangle in window space. The z is the NDC depth.
+	class Triangle
+	{
+	public:
+		Array<Vec3, 3> m_verts;
+	};
+
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Mat4 m_mv; ///< ModelView.
 	Mat4 m_p; ///< Projection.
@@ -64,12 +111,36 @@ private:
 	Array<Plane, 6> m_planesW; ///< In world space.
 	U32 m_width;
 	U32 m_height;
-	DynamicArray<Atomic<U32>> m_zbuffer;
+	U32 m_tileCountX = 0;
+	U32 m_tileCountY = 0;
+
+	DynamicArray<F32> m_zbuffer; ///< In tile order. The pixels outside the window are zero.
+	DynamicArray<F32> m_tileMaxDepths; ///< The HiZ.
+
+	DynamicArray<Triangle> m_triangles;
+	U32 m_triangleCount = 0;
+	SpinLock m_trianglesLock;
+
+	/// Where the triangle indices of a tile start in m_tileTriangleIndices. It has getTileCount() + 1 elements.
+	DynamicArray<U32> m_tileTriangleOffsets;
+	DynamicArray<U32> m_tileTriangleIndices;
+
+	U32 computePixelIndex(U32 x, U32 y) const
+	{
+		const U32 tile = (y / TILE_SIZE) * m_tileCountX + x / TILE_SIZE;
+		return tile * TILE_SIZE * TILE_SIZE + (y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE;
+	}
+
+	/// Compute the pixels that a triangle may touch. The max is exclusive.
+	void computeTriangleBounds(const Triangle& tri, U32& minX, U32& minY, U32& maxX, U32& maxY) const;
+
+	/// Queue some triangles in window space.
+	void appendTriangles(const Triangle* tris, U32 count);
 
-	/// @param tri In clip space.
-	void rasterizeTriangle(const Vec4* tri);
+	void rasterizeTile(U32 tile);
 
-	Bool computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const;
+	/// Recompute the HiZ of a tile.
+	void updateTileMaxDepth(U32 tile);
 
 	/// Clip triangle in the near plane.
 	/// @note Triangles in view space.
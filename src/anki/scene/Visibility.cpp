@@ -15,13 +15,38 @@
 #include <anki/scene/LightNode.h>
 #include <anki/scene/components/MoveComponent.h>
 #include <anki/renderer/MainRenderer.h>
+#include <anki/resource/ResourceManager.h>
 #include <anki/util/Logger.h>
 #include <anki/util/ThreadHive.h>
 #include <anki/util/ThreadPool.h>
+#include <anki/util/RadixSort.h>
 
 namespace anki
 {
 
+/// The size of a bounding box on the screen as a fraction of the screen height. It's negative if the frustum is not a
+/// perspective one.
+static F32 computeScreenSize(const Aabb& aabb, F32 distance, const Frustum& frustum)
+{
+	if(frustum.getType() != FrustumType::PERSPECTIVE)
+	{
+		return -1.0f;
+	}
+
+	const F32 tanHalfFovY = tan(static_cast<const PerspectiveFrustum&>(frustum).getFovY() / 2.0f);
+	const F32 radius = (aabb.getMax() - aabb.getMin()).xyz().getLength() / 2.0f;
+	return radius / (max(distance, 0.01f) * tanHalfFovY);
+}
+
+/// Ask for the texture detail that a renderable needs on the screen.
+static void requestTextureResidency(const RenderComponent& rc, F32 screenSize, F32 screenHeight)
+{
+	if(screenSize > 0.0f)
+	{
+		rc.requestTextureResidency(screenSize * screenHeight);
+	}
+}
+
 void VisibilityContext::submitNewWork(const FrustumComponent& frc, RenderQueue& rqueue, ThreadHive& hive)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_SUBMIT_WORK);
@@ -66,6 +91,16 @@ void VisibilityContext::submitNewWork(const FrustumComponent& frc, RenderQueue&
 	frcCtx->m_visTestsSignalSem = hive.newSemaphore(1);
 	frcCtx->m_renderQueue = &rqueue;
 
+	// Reuse the results of the previous tests if the frustum didn't change and no spatial got removed since then
+	if(frc.visibilityCacheAllowed())
+	{
+		const FrustumComponentVisibilityCache& cache = frc.getVisibilityCache();
+		frcCtx->m_fillVisibilityCache = true;
+		frcCtx->m_useVisibilityCache =
+			cache.m_valid && cache.m_timestamp == m_prevTestsTimestamp && frc.getTimestamp() <= cache.m_timestamp
+			&& m_scene->getSceneComponentLists().getSpatialComponentRemoveTimestamp() <= cache.m_timestamp;
+	}
+
 	// Submit new work
 	//
 
@@ -150,11 +185,11 @@ void GatherVisiblesFromOctreeTask::gather(ThreadHive& hive, ThreadHiveSemaphore&
 		},
 		[&](void* placeableUserData) {
 			ANKI_ASSERT(placeableUserData);
-			SpatialComponent* scomp = static_cast<SpatialComponent*>(placeableUserData);
+			const SpatialComponent* scomp = static_cast<const SpatialComponent*>(placeableUserData);
 
 			ANKI_ASSERT(m_spatialCount < m_spatials.getSize());
 
-			m_spatials[m_spatialCount++] = scomp;
+			m_spatials[m_spatialCount++] = scomp->getPoolIndex();
 
 			if(m_spatialCount == m_spatials.getSize())
 			{
@@ -165,6 +200,73 @@ void GatherVisiblesFromOctreeTask::gather(ThreadHive& hive, ThreadHiveSemaphore&
 	// Flush the remaining
 	flush(hive, sem);
 
+	finalize(hive);
+}
+
+void GatherVisiblesFromOctreeTask::gatherFromCache(ThreadHive& hive, ThreadHiveSemaphore& sem, U32 threadId)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_CACHE);
+
+	const FrustumComponentVisibilityCache& cache = m_frcCtx->m_frc->getVisibilityCache();
+	ANKI_ASSERT(cache.m_valid);
+	auto alloc = m_frcCtx->m_visCtx->m_scene->getFrameAllocator();
+	RenderQueueView& result = m_frcCtx->m_queueViews[threadId];
+	result.m_timestamp = max(result.m_timestamp, m_frcCtx->m_frc->getSceneNode().getComponentMaxTimestamp());
+	const SpatialComponentPool& spatialPool =
+		m_frcCtx->m_visCtx->m_scene->getSceneComponentLists().getSpatialComponentPool();
+
+	// The spatials that didn't change have the same visibility. Keep their renderables. The timestamps of the pool
+	// change when the AABB or the RenderComponent changes
+	U32 cachedCount = 0;
+	for(U32 i = 0; i < cache.m_entryCount; ++i)
+	{
+		const FrustumComponentVisibilityCacheEntry& entry = cache.m_entries[i];
+		const U32 poolIdx = entry.m_spatial->getPoolIndex();
+		if(spatialPool.getChunk(poolIdx).m_timestamps[poolIdx % SpatialComponentPool::CHUNK_SIZE] > cache.m_timestamp)
+		{
+			// It's in the m_updatedSpatials, it will be tested again
+			continue;
+		}
+
+		RenderableQueueElement* el = (entry.m_forwardShading) ? result.m_forwardShadingRenderables.newElement(alloc)
+															  : result.m_renderables.newElement(alloc);
+		*el = entry.m_renderable;
+		*result.m_visibilityCacheEntries.newElement(alloc) = entry;
+
+		if(m_frcCtx->m_visCtx->m_textureStreamingScreenHeight > 0.0f)
+		{
+			const RenderComponent* rc = entry.m_spatial->getSceneNode().tryGetComponent<RenderComponent>();
+			ANKI_ASSERT(rc);
+			const F32 screenSize = computeScreenSize(
+				entry.m_spatial->getAabb(), entry.m_renderable.m_distanceFromCamera, m_frcCtx->m_frc->getFrustum());
+			requestTextureResidency(*rc, screenSize, m_frcCtx->m_visCtx->m_textureStreamingScreenHeight);
+		}
+
+		result.m_timestamp = max(result.m_timestamp, entry.m_spatial->getSceneNode().getComponentMaxTimestamp());
+		++cachedCount;
+	}
+
+	ANKI_TRACE_INC_COUNTER(SCENE_VIS_CACHED_SPATIALS, cachedCount);
+	m_frcCtx->m_reusedCacheEntryCount = cachedCount;
+
+	// Test the spatials that changed
+	for(U32 poolIdx : m_frcCtx->m_visCtx->m_updatedSpatials)
+	{
+		m_spatials[m_spatialCount++] = poolIdx;
+
+		if(m_spatialCount == m_spatials.getSize())
+		{
+			flush(hive, sem);
+		}
+	}
+
+	flush(hive, sem);
+
+	finalize(hive);
+}
+
+void GatherVisiblesFromOctreeTask::finalize(ThreadHive& hive)
+{
 	// Fire an additional dummy task to decrease the semaphore to zero
 	ThreadHiveTask task;
 	task.m_callback = dummyCallback;
@@ -209,7 +311,7 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 	auto alloc = m_frcCtx->m_visCtx->m_scene->getFrameAllocator();
 
 	Timestamp& timestamp = m_frcCtx->m_queueViews[taskId].m_timestamp;
-	timestamp = testedNode.getComponentMaxTimestamp();
+	timestamp = max(timestamp, testedNode.getComponentMaxTimestamp());
 
 	const Bool wantsRenderComponents =
 		testedFrc.visibilityTestsEnabled(FrustumComponentVisibilityTestFlag::RENDER_COMPONENTS);
@@ -234,11 +336,80 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 	const Bool wantsEarlyZ = testedFrc.visibilityTestsEnabled(FrustumComponentVisibilityTestFlag::EARLY_Z)
 							 && m_frcCtx->m_visCtx->m_earlyZDist > 0.0f;
 
+	// Cull the spatials in one batch before touching their components. The batch reads only the dense storage of the
+	// SpatialComponentPool. The AABB of a sphere is enough to rebuild the sphere so for spheres and AABBs the batch
+	// test is exact. For the rest of the shapes it's conservative
+	static_assert(MAX_SPATIALS_PER_VIS_TEST <= 64, "The visibility mask is a single U64");
+	const SpatialComponentPool& spatialPool =
+		m_frcCtx->m_visCtx->m_scene->getSceneComponentLists().getSpatialComponentPool();
+	Array<F32, MAX_SPATIALS_PER_VIS_TEST> centersX, centersY, centersZ, extentsX, extentsY, extentsZ, radii;
+	U64 exactMask = 0;
+	for(U i = 0; i < m_spatialToTestCount; ++i)
+	{
+		const U32 poolIdx = m_spatialsToTest[i];
+		const SpatialComponentPool::Chunk& chunk = spatialPool.getChunk(poolIdx);
+		const Vec4& aabbMin = chunk.m_aabbMins[poolIdx % SpatialComponentPool::CHUNK_SIZE];
+		const Vec4& aabbMax = chunk.m_aabbMaxs[poolIdx % SpatialComponentPool::CHUNK_SIZE];
+		const CollisionShapeType shapeType = chunk.m_shapeTypes[poolIdx % SpatialComponentPool::CHUNK_SIZE];
+		const Vec4 center = (aabbMin + aabbMax) * 0.5f;
+		const Vec4 extent = (aabbMax - aabbMin) * 0.5f;
+
+		centersX[i] = center.x();
+		centersY[i] = center.y();
+		centersZ[i] = center.z();
+
+		if(shapeType == CollisionShapeType::SPHERE)
+		{
+			extentsX[i] = extentsY[i] = extentsZ[i] = 0.0f;
+			radii[i] = extent.x();
+			exactMask |= U64(1) << i;
+		}
+		else
+		{
+			extentsX[i] = extent.x();
+			extentsY[i] = extent.y();
+			extentsZ[i] = extent.z();
+			radii[i] = 0.0f;
+
+			if(shapeType == CollisionShapeType::AABB)
+			{
+				exactMask |= U64(1) << i;
+			}
+		}
+	}
+
+	BoundingVolumeBatch batch;
+	batch.m_centersX = &centersX[0];
+	batch.m_centersY = &centersY[0];
+	batch.m_centersZ = &centersZ[0];
+	batch.m_extentsX = &extentsX[0];
+	batch.m_extentsY = &extentsY[0];
+	batch.m_extentsZ = &extentsZ[0];
+	batch.m_radii = &radii[0];
+	batch.m_count = m_spatialToTestCount;
+
+	U64 visibleMask;
+	cullBoundingVolumes(testedFrc.getFrustum().getPlanesWorldSpace(), batch, &visibleMask);
+
+	// Keep the visible
+	Array<Bool8, MAX_SPATIALS_PER_VIS_TEST> spatialsTestedExactly;
+	U spatialCount = 0;
+	for(U i = 0; i < m_spatialToTestCount; ++i)
+	{
+		if(visibleMask & (U64(1) << i))
+		{
+			spatialsTestedExactly[spatialCount] = (exactMask & (U64(1) << i)) != 0;
+			m_spatialsToTest[spatialCount++] = m_spatialsToTest[i];
+		}
+	}
+
 	// Iterate
 	RenderQueueView& result = m_frcCtx->m_queueViews[taskId];
-	for(U i = 0; i < m_spatialToTestCount; ++i)
+	for(U i = 0; i < spatialCount; ++i)
 	{
-		const SpatialComponent* spatialC = m_spatialsToTest[i];
+		const U32 poolIdx = m_spatialsToTest[i];
+		const SpatialComponent* spatialC =
+			spatialPool.getChunk(poolIdx).m_components[poolIdx % SpatialComponentPool::CHUNK_SIZE];
 		ANKI_ASSERT(spatialC);
 		const SceneNode& node = spatialC->getSceneNode();
 
@@ -310,7 +481,8 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 		U spIdx = 0;
 		U count = 0;
 		Error err = node.iterateComponentsOfType<SpatialComponent>([&](SpatialComponent& sp) {
-			if(testedFrc.insideFrustum(sp) && testAgainstRasterizer(sp.getSpatialCollisionShape(), sp.getAabb()))
+			const Bool insideFrustum = (&sp == spatialC && spatialsTestedExactly[i]) || testedFrc.insideFrustum(sp);
+			if(insideFrustum && testAgainstRasterizer(sp.getSpatialCollisionShape(), sp.getAabb()))
 			{
 				// Inside
 				ANKI_ASSERT(spIdx < MAX_U8);
@@ -364,6 +536,37 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 				const Plane& nearPlane = testedFrc.getFrustum().getPlanesWorldSpace()[FrustumPlaneType::NEAR];
 				el->m_distanceFromCamera = max(0.0f, sps[0].m_sp->getAabb().testPlane(nearPlane));
 
+				// Select the LOD from the size on the screen. The renderables that are there only for the shadows get
+				// the coarsest one
+				if(wantsRenderComponents)
+				{
+					const F32 screenSize =
+						computeScreenSize(sps[0].m_sp->getAabb(), el->m_distanceFromCamera, testedFrc.getFrustum());
+
+					el->m_lod = (screenSize < 0.0f) ? 0
+													: rc->selectLod(screenSize,
+														  m_frcCtx->m_visCtx->m_lodScreenSizes,
+														  m_frcCtx->m_visCtx->m_lodHysteresis,
+														  &testedFrc == m_frcCtx->m_visCtx->m_lodFrc);
+
+					if(m_frcCtx->m_visCtx->m_textureStreamingScreenHeight > 0.0f)
+					{
+						requestTextureResidency(*rc, screenSize, m_frcCtx->m_visCtx->m_textureStreamingScreenHeight);
+					}
+				}
+				else
+				{
+					el->m_lod = MAX_LOD_COUNT - 1;
+				}
+
+				if(m_frcCtx->m_fillVisibilityCache)
+				{
+					FrustumComponentVisibilityCacheEntry* entry = result.m_visibilityCacheEntries.newElement(alloc);
+					entry->m_spatial = spatialC;
+					entry->m_renderable = *el;
+					entry->m_forwardShading = rc->isForwardShading();
+				}
+
 				if(wantsEarlyZ && el->m_distanceFromCamera < m_frcCtx->m_visCtx->m_earlyZDist
 					&& !rc->isForwardShading())
 				{
@@ -558,8 +761,8 @@ void CombineResultsTask::combine()
 	}
 #endif
 
-	// Sort some of the arrays
-	std::sort(results.m_renderables.getBegin(), results.m_renderables.getEnd(), MaterialDistanceSortFunctor(20.0f));
+	// Sort some of the arrays. The forward shading renderables are sorted back to front for the blending
+	sortRenderables(alloc, results.m_renderables);
 
 	std::sort(results.m_earlyZRenderables.getBegin(),
 		results.m_earlyZRenderables.getEnd(),
@@ -569,6 +772,12 @@ void CombineResultsTask::combine()
 		results.m_forwardShadingRenderables.getEnd(),
 		RevDistanceSortFunctor<RenderableQueueElement>());
 
+	// Keep the results for the next tests
+	if(m_frcCtx->m_fillVisibilityCache)
+	{
+		fillVisibilityCache();
+	}
+
 	// Cleanup
 	if(m_frcCtx->m_r)
 	{
@@ -576,6 +785,68 @@ void CombineResultsTask::combine()
 	}
 }
 
+void CombineResultsTask::sortRenderables(SceneFrameAllocator<U8>& alloc, WeakArray<RenderableQueueElement> renderables)
+{
+	const U32 count = renderables.getSize();
+	if(count < 2)
+	{
+		return;
+	}
+
+	// Compute the keys once and sort them along with the indices. It's cheaper than moving the elements in every pass
+	RenderableSortKey* keys = alloc.newArray<RenderableSortKey>(count);
+	RenderableSortKey* tmpKeys = alloc.newArray<RenderableSortKey>(count);
+	for(U32 i = 0; i < count; ++i)
+	{
+		keys[i].m_key = RenderableSortKey::compute(renderables[i]);
+		keys[i].m_index = i;
+	}
+
+	radixSort(keys, count, tmpKeys, [](const RenderableSortKey& k) { return k.m_key; });
+
+	// Reorder the elements
+	RenderableQueueElement* tmpRenderables = alloc.newArray<RenderableQueueElement>(count);
+	memcpy(tmpRenderables, &renderables[0], sizeof(RenderableQueueElement) * count);
+	for(U32 i = 0; i < count; ++i)
+	{
+		renderables[i] = tmpRenderables[keys[i].m_index];
+	}
+}
+
+void CombineResultsTask::fillVisibilityCache()
+{
+	FrustumComponentVisibilityCache& cache = m_frcCtx->m_frc->getVisibilityCache();
+	auto alloc = m_frcCtx->m_frc->getAllocator();
+
+	U32 entryCount = 0;
+	for(const RenderQueueView& view : m_frcCtx->m_queueViews)
+	{
+		entryCount += view.m_visibilityCacheEntries.m_elementCount;
+	}
+
+	if(cache.m_entries.getSize() < entryCount)
+	{
+		cache.m_entries.destroy(alloc);
+		cache.m_entries.create(alloc, entryCount);
+	}
+
+	cache.m_entryCount = 0;
+	for(const RenderQueueView& view : m_frcCtx->m_queueViews)
+	{
+		if(view.m_visibilityCacheEntries.m_elementCount)
+		{
+			memcpy(&cache.m_entries[cache.m_entryCount],
+				view.m_visibilityCacheEntries.m_elements,
+				sizeof(FrustumComponentVisibilityCacheEntry) * view.m_visibilityCacheEntries.m_elementCount);
+			cache.m_entryCount += view.m_visibilityCacheEntries.m_elementCount;
+		}
+	}
+
+	cache.m_timestamp = m_frcCtx->m_visCtx->m_scene->getGlobalTimestamp();
+	cache.m_reusedEntryCount = m_frcCtx->m_reusedCacheEntryCount;
+	cache.m_valid = true;
+}
+
 template<typename T>
 void CombineResultsTask::combineQueueElements(SceneFrameAllocator<U8>& alloc,
 	WeakArray<TRenderQueueElementStorage<T>> subStorages,
@@ -681,10 +952,53 @@ void SceneGraph::doVisibilityTests(SceneNode& fsn, SceneGraph& scene, RenderQueu
 	VisibilityContext ctx;
 	ctx.m_scene = &scene;
 	ctx.m_earlyZDist = scene.getEarlyZDistance();
+	if(scene.getResourceManager().getTextureResidencyManager())
+	{
+		ctx.m_textureStreamingScreenHeight = scene.getScreenHeight();
+	}
+	ctx.m_prevTestsTimestamp = scene.m_visibilityTestsTimestamp;
+	ctx.m_lodFrc = &fsn.getComponent<FrustumComponent>();
+	ctx.m_lodScreenSizes = ConstWeakArray<F32>(&scene.m_lodScreenSizes[0], scene.m_lodScreenSizes.getSize());
+	ctx.m_lodHysteresis = scene.m_lodHysteresis;
+
+	// Gather the spatials that got updated after the previous tests. The frustums that have a visibility cache test
+	// only those. Walk the timestamps of the pool and keep the indices, the components are not touched
+	const SpatialComponentPool& spatialPool = scene.getSceneComponentLists().getSpatialComponentPool();
+	U32 updatedCount = 0;
+	for(U32 i = 0; i < spatialPool.getChunkCount(); ++i)
+	{
+		const SpatialComponentPool::Chunk& chunk = spatialPool.getChunkAt(i);
+		for(U32 j = 0; j < spatialPool.getChunkElementCount(i); ++j)
+		{
+			updatedCount += chunk.m_timestamps[j] > ctx.m_prevTestsTimestamp;
+		}
+	}
+
+	if(updatedCount)
+	{
+		U32* updatedSpatials = scene.getFrameAllocator().newArray<U32>(updatedCount);
+		ctx.m_updatedSpatials = WeakArray<U32>(updatedSpatials, updatedCount);
+
+		updatedCount = 0;
+		for(U32 i = 0; i < spatialPool.getChunkCount(); ++i)
+		{
+			const SpatialComponentPool::Chunk& chunk = spatialPool.getChunkAt(i);
+			for(U32 j = 0; j < spatialPool.getChunkElementCount(i); ++j)
+			{
+				if(chunk.m_timestamps[j] > ctx.m_prevTestsTimestamp)
+				{
+					updatedSpatials[updatedCount++] = i * SpatialComponentPool::CHUNK_SIZE + j;
+				}
+			}
+		}
+	}
+
 	ctx.submitNewWork(fsn.getComponent<FrustumComponent>(), rqueue, hive);
 
 	hive.waitAllTasks();
 	ctx.m_testedFrcs.destroy(scene.getFrameAllocator());
+
+	scene.m_visibilityTestsTimestamp = scene.getGlobalTimestamp();
 }
 
 } // end namespace anki
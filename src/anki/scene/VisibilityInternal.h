@@ -44,32 +44,38 @@ public:
 	}
 };
 
-/// Material and distance sort.
-class MaterialDistanceSortFunctor
+/// The key that sorts the renderables so the ones that can be merged to a single drawcall end up next to each other.
+/// The LOD is the most significant part, then the merge key and last a depth bucket so the instances of a drawcall go
+/// front to back. The pass doesn't need bits because every array of the render queue feeds a single pass.
+class RenderableSortKey
 {
 public:
-	MaterialDistanceSortFunctor(F32 distanceGranularity)
-		: m_distGranularity(1.0f / distanceGranularity)
-	{
-	}
+	U64 m_key;
+	U32 m_index; ///< The index of the renderable in the queue.
 
-	Bool operator()(const RenderableQueueElement& a, const RenderableQueueElement& b)
+	static U64 compute(const RenderableQueueElement& el)
 	{
-		const U aClass = a.m_distanceFromCamera * m_distGranularity;
-		const U bClass = b.m_distanceFromCamera * m_distGranularity;
-
-		if(aClass == bClass && a.m_callback == b.m_callback)
-		{
-			return a.m_mergeKey < b.m_mergeKey;
-		}
-		else
+		const U LOD_BITS = 2;
+		const U DEPTH_BITS = 16;
+		const U MERGE_KEY_BITS = 64 - LOD_BITS - DEPTH_BITS;
+		const F32 DEPTH_BUCKET_SIZE = 0.5f;
+		static_assert(MAX_LOD_COUNT <= (1u << LOD_BITS), "Not enough bits");
+
+		const U64 lod = el.m_lod;
+
+		// Mix the callback with the merge key since different callbacks can't merge. Only the high bits are kept and
+		// the merge keys might be small numbers like UUIDs so multiply both to spread all their bits to the high ones
+		U64 mergeKey = 0;
+		if(el.m_mergeKey != 0)
 		{
-			return a.m_distanceFromCamera < b.m_distanceFromCamera;
+			mergeKey = (el.m_mergeKey * 0x9E3779B97F4A7C15ull) ^ (ptrToNumber(el.m_callback) * 0xC2B2AE3D27D4EB4Full);
+			mergeKey >>= 64 - MERGE_KEY_BITS;
 		}
-	}
 
-private:
-	F32 m_distGranularity;
+		const U64 depth = min<U64>(U64(el.m_distanceFromCamera / DEPTH_BUCKET_SIZE), (1u << DEPTH_BITS) - 1);
+
+		return (lod << (64 - LOD_BITS)) | (mergeKey << DEPTH_BITS) | depth;
+	}
 };
 
 /// Storage for a single element type.
@@ -113,6 +119,7 @@ public:
 	TRenderQueueElementStorage<ReflectionProbeQueueElement> m_reflectionProbes;
 	TRenderQueueElementStorage<LensFlareQueueElement> m_lensFlares;
 	TRenderQueueElementStorage<DecalQueueElement> m_decals;
+	TRenderQueueElementStorage<FrustumComponentVisibilityCacheEntry> m_visibilityCacheEntries;
 
 	Timestamp m_timestamp = 0;
 };
@@ -127,6 +134,15 @@ public:
 	Atomic<U32> m_testsCount = {0};
 
 	F32 m_earlyZDist = -1.0f; ///< Cache this.
+	F32 m_textureStreamingScreenHeight = 0.0f; ///< If it's zero texture streaming is disabled.
+
+	const FrustumComponent* m_lodFrc = nullptr; ///< The frustum that keeps the LODs of the renderables for hysteresis.
+	ConstWeakArray<F32> m_lodScreenSizes;
+	F32 m_lodHysteresis = 0.0f;
+
+	Timestamp m_prevTestsTimestamp = 0; ///< The global timestamp of the previous visibility tests.
+	/// The SpatialComponentPool indices of the spatials that got updated after the previous tests.
+	WeakArray<U32> m_updatedSpatials;
 
 	List<const FrustumComponent*> m_testedFrcs;
 	Mutex m_mtx;
@@ -151,6 +167,11 @@ public:
 	DynamicArray<RenderQueueView> m_queueViews; ///< Sub result. Will be combined later.
 	ThreadHiveSemaphore* m_visTestsSignalSem = nullptr;
 
+	// Visibility cache members
+	Bool8 m_useVisibilityCache = false; ///< Test only the m_updatedSpatials and take the rest from the cache.
+	Bool8 m_fillVisibilityCache = false;
+	U32 m_reusedCacheEntryCount = 0;
+
 	// Gather results members
 	RenderQueue* m_renderQueue = nullptr;
 };
@@ -180,7 +201,7 @@ private:
 static_assert(
 	std::is_trivially_destructible<FillRasterizerWithCoverageTask>::value == true, "Should be trivially destructible");
 
-/// ThreadHive task to get visible nodes from the octree.
+/// ThreadHive task to get visible nodes from the octree or from the visibility cache of the frustum.
 class GatherVisiblesFromOctreeTask
 {
 public:
@@ -196,15 +217,27 @@ public:
 	static void callback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem)
 	{
 		GatherVisiblesFromOctreeTask& self = *static_cast<GatherVisiblesFromOctreeTask*>(ud);
-		self.gather(hive, *sem);
+		if(self.m_frcCtx->m_useVisibilityCache)
+		{
+			self.gatherFromCache(hive, *sem, threadId);
+		}
+		else
+		{
+			self.gather(hive, *sem);
+		}
 	}
 
 private:
-	Array<SpatialComponent*, MAX_SPATIALS_PER_VIS_TEST> m_spatials;
+	Array<U32, MAX_SPATIALS_PER_VIS_TEST> m_spatials; ///< SpatialComponentPool indices.
 	U32 m_spatialCount = 0;
 
 	void gather(ThreadHive& hive, ThreadHiveSemaphore& sem);
 
+	void gatherFromCache(ThreadHive& hive, ThreadHiveSemaphore& sem, U32 threadId);
+
+	/// Submit a dummy task that signals the m_visTestsSignalSem.
+	void finalize(ThreadHive& hive);
+
 	/// Submit tasks to test the m_spatials.
 	void flush(ThreadHive& hive, ThreadHiveSemaphore& sem);
 
@@ -221,7 +254,7 @@ class VisibilityTestTask
 public:
 	FrustumVisibilityContext* m_frcCtx = nullptr;
 
-	Array<SpatialComponent*, MAX_SPATIALS_PER_VIS_TEST> m_spatialsToTest;
+	Array<U32, MAX_SPATIALS_PER_VIS_TEST> m_spatialsToTest; ///< SpatialComponentPool indices.
 	U32 m_spatialToTestCount = 0;
 
 	VisibilityTestTask(FrustumVisibilityContext* frcCtx)
@@ -269,6 +302,12 @@ public:
 private:
 	void combine();
 
+	/// Copy the m_visibilityCacheEntries of the views to the cache of the frustum.
+	void fillVisibilityCache();
+
+	/// Sort the renderables with a radix sort on RenderableSortKey.
+	static void sortRenderables(SceneFrameAllocator<U8>& alloc, WeakArray<RenderableQueueElement> renderables);
+
 	template<typename T>
 	static void combineQueueElements(SceneFrameAllocator<U8>& alloc,
 		WeakArray<TRenderQueueElementStorage<T>> subStorages,
@@ -24,6 +24,7 @@ FrustumComponent::FrustumComponent(SceneNode* node, Frustum* frustum)
 FrustumComponent::~FrustumComponent()
 {
 	m_coverageBuff.m_depthMap.destroy(getAllocator());
+	m_visCache.m_entries.destroy(getAllocator());
 }
 
 Error FrustumComponent::update(Second, Second, Bool& updated)
@@ -9,6 +9,7 @@
 #include <anki/scene/components/SpatialComponent.h>
 #include <anki/scene/Common.h>
 #include <anki/scene/components/SceneComponent.h>
+#include <anki/renderer/RenderQueue.h>
 #include <anki/util/BitMask.h>
 
 namespace anki
@@ -37,6 +38,27 @@ enum class FrustumComponentVisibilityTestFlag : U16
 };
 ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(FrustumComponentVisibilityTestFlag, inline)
 
+/// A renderable that was visible in the last visibility tests of a FrustumComponent.
+class FrustumComponentVisibilityCacheEntry
+{
+public:
+	const SpatialComponent* m_spatial;
+	RenderableQueueElement m_renderable;
+	Bool8 m_forwardShading;
+};
+
+/// The results of the last visibility tests of a FrustumComponent. If the frustum didn't change the next visibility
+/// tests reuse the entries of the spatials that didn't change and test only the spatials that did.
+class FrustumComponentVisibilityCache
+{
+public:
+	DynamicArray<FrustumComponentVisibilityCacheEntry> m_entries;
+	U32 m_entryCount = 0;
+	Timestamp m_timestamp = 0; ///< The global timestamp when the entries got gathered.
+	U32 m_reusedEntryCount = 0; ///< How many entries the last tests took from the cache. Zero if they didn't use it.
+	Bool8 m_valid = false;
+};
+
 /// Frustum component interface for scene nodes. Useful for nodes that are frustums like cameras and lights.
 class FrustumComponent : public SceneComponent
 {
@@ -118,6 +140,7 @@ public:
 	{
 		m_flags.unset(FrustumComponentVisibilityTestFlag::ALL_TESTS);
 		m_flags.set(bits, true);
+		m_visCache.m_valid = false;
 
 #if ANKI_ASSERTS_ENABLED
 		if(m_flags.get(FrustumComponentVisibilityTestFlag::RENDER_COMPONENTS)
@@ -142,6 +165,22 @@ public:
 		return m_flags.getAny(FrustumComponentVisibilityTestFlag::ALL_TESTS);
 	}
 
+	/// Can the results of the visibility tests be cached? Only if the frustum gathers shadow casters and nothing else.
+	/// The rest of the tests spawn more frustums or they depend on the coverage buffer that changes every frame.
+	Bool visibilityCacheAllowed() const
+	{
+		const FrustumComponentVisibilityTestFlag otherTests =
+			(FrustumComponentVisibilityTestFlag::ALL_TESTS | FrustumComponentVisibilityTestFlag::OCCLUDERS)
+			& ~FrustumComponentVisibilityTestFlag::SHADOW_CASTERS;
+		return m_flags.get(FrustumComponentVisibilityTestFlag::SHADOW_CASTERS) && !m_flags.getAny(otherTests);
+	}
+
+	/// The visibility tests read and write it.
+	FrustumComponentVisibilityCache& getVisibilityCache() const
+	{
+		return m_visCache;
+	}
+
 	/// The type is FillCoverageBufferCallback.
 	static void fillCoverageBufferCallback(void* userData, F32* depthValues, U32 width, U32 height)
 	{
@@ -198,6 +237,8 @@ private:
 		U32 m_depthMapWidth = 0;
 		U32 m_depthMapHeight = 0;
 	} m_coverageBuff; ///< Coverage buffer for extra visibility tests.
+
+	mutable FrustumComponentVisibilityCache m_visCache;
 };
 /// @}
 
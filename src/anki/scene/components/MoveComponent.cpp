@@ -5,6 +5,7 @@
 
 #include <anki/scene/components/MoveComponent.h>
 #include <anki/scene/SceneNode.h>
+#include <anki/scene/SceneGraph.h>
 
 namespace anki
 {
@@ -13,11 +14,19 @@ MoveComponent::MoveComponent(SceneNode* node, MoveComponentFlag flags)
 	: SceneComponent(CLASS_TYPE, node)
 	, m_flags(flags)
 {
+	m_pool = &node->getSceneGraph().getSceneComponentLists().getMoveComponentPool();
+	m_poolIndex = m_pool->add(getAllocator(), this);
+
+	MoveComponentPool::Chunk& chunk = m_pool->getChunk(m_poolIndex);
+	chunk.m_worldTransforms[m_poolIndex % MoveComponentPool::CHUNK_SIZE] = Transform::getIdentity();
+	chunk.m_prevWorldTransforms[m_poolIndex % MoveComponentPool::CHUNK_SIZE] = Transform::getIdentity();
+
 	markForUpdate();
 }
 
 MoveComponent::~MoveComponent()
 {
+	m_pool->remove(m_poolIndex);
 }
 
 Error MoveComponent::update(Second, Second, Bool& updated)
@@ -28,12 +37,12 @@ Error MoveComponent::update(Second, Second, Bool& updated)
 
 Bool MoveComponent::updateWorldTransform(SceneNode& node)
 {
-	m_prevWTrf = m_wtrf;
 	const Bool dirty = m_flags.get(MoveComponentFlag::MARKED_FOR_UPDATE);
 
 	// If dirty then update world transform
 	if(dirty)
 	{
+		Transform& wtrf = getWorldTransformMutable();
 		const SceneNode* parent = node.getParent();
 
 		if(parent)
@@ -43,26 +52,26 @@ Bool MoveComponent::updateWorldTransform(SceneNode& node)
 			if(parentMove == nullptr)
 			{
 				// Parent not movable
-				m_wtrf = m_ltrf;
+				wtrf = m_ltrf;
 			}
 			else if(m_flags.get(MoveComponentFlag::IGNORE_PARENT_TRANSFORM))
 			{
-				m_wtrf = m_ltrf;
+				wtrf = m_ltrf;
 			}
 			else if(m_flags.get(MoveComponentFlag::IGNORE_LOCAL_TRANSFORM))
 			{
-				m_wtrf = parentMove->getWorldTransform();
+				wtrf = parentMove->getWorldTransform();
 			}
 			else
 			{
-				m_wtrf = parentMove->getWorldTransform().combineTransformations(m_ltrf);
+				wtrf = parentMove->getWorldTransform().combineTransformations(m_ltrf);
 			}
 		}
 		else
 		{
 			// No parent
 
-			m_wtrf = m_ltrf;
+			wtrf = m_ltrf;
 		}
 
 		// Now it's a good time to cleanse parent
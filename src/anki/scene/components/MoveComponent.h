@@ -35,6 +35,9 @@ ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(MoveComponentFlag, inline)
 /// Interface for movable scene nodes
 class MoveComponent : public SceneComponent
 {
+	template<typename, typename>
+	friend class SceneComponentPool;
+
 public:
 	static const SceneComponentType CLASS_TYPE = SceneComponentType::MOVE;
 
@@ -91,12 +94,12 @@ public:
 
 	const Transform& getWorldTransform() const
 	{
-		return m_wtrf;
+		return m_pool->getChunk(m_poolIndex).m_worldTransforms[m_poolIndex % MoveComponentPool::CHUNK_SIZE];
 	}
 
 	const Transform& getPreviousWorldTransform() const
 	{
-		return m_prevWTrf;
+		return m_pool->getChunk(m_poolIndex).m_prevWorldTransforms[m_poolIndex % MoveComponentPool::CHUNK_SIZE];
 	}
 
 	/// Called when there is an update in the world transformation.
@@ -165,11 +168,9 @@ private:
 	/// The transformation in local space
 	Transform m_ltrf = Transform::getIdentity();
 
-	/// The transformation in world space (local combined with parent's transformation)
-	Transform m_wtrf = Transform::getIdentity();
-
-	/// Keep the previous transformation for checking if it moved
-	Transform m_prevWTrf = Transform::getIdentity();
+	/// The world and the previous world transformations live in the pool.
+	MoveComponentPool* m_pool;
+	U32 m_poolIndex;
 
 	BitMask<MoveComponentFlag> m_flags;
 
@@ -178,7 +179,13 @@ private:
 		m_flags.set(MoveComponentFlag::MARKED_FOR_UPDATE);
 	}
 
-	/// Called every frame. It updates the @a m_wtrf if @a shouldUpdateWTrf is true. Then it moves to the children.
+	Transform& getWorldTransformMutable()
+	{
+		return m_pool->getChunk(m_poolIndex).m_worldTransforms[m_poolIndex % MoveComponentPool::CHUNK_SIZE];
+	}
+
+	/// Called every frame. It updates the world transform if it's dirty and marks the children dirty. The previous
+	/// world transform is updated by SceneGraph for all the components at once.
 	Bool updateWorldTransform(SceneNode& node);
 };
 /// @}
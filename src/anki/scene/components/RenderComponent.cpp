@@ -4,7 +4,9 @@
 // http://www.anki3d.org/LICENSE
 
 #include <anki/scene/components/RenderComponent.h>
+#include <anki/scene/components/SpatialComponent.h>
 #include <anki/scene/SceneNode.h>
+#include <anki/scene/SceneGraph.h>
 #include <anki/resource/TextureResource.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/util/Logger.h>
@@ -12,6 +14,52 @@
 namespace anki
 {
 
+U8 RenderComponent::selectLod(F32 screenSize, ConstWeakArray<F32> lodScreenSizes, F32 hysteresis, Bool remember) const
+{
+	ANKI_ASSERT(lodScreenSizes.getSize() < MAX_LOD_COUNT);
+
+	auto lodFor = [&](F32 scale) -> U8 {
+		U8 lod = 0;
+		for(F32 threshold : lodScreenSizes)
+		{
+			lod += screenSize < threshold * scale;
+		}
+		return lod;
+	};
+
+	// Stay at the previous LOD unless the size is out of the band around the thresholds
+	const U8 lod = clamp(m_lod.load(AtomicMemoryOrder::RELAXED), lodFor(1.0f - hysteresis), lodFor(1.0f + hysteresis));
+
+	if(remember)
+	{
+		m_lod.store(lod, AtomicMemoryOrder::RELAXED);
+	}
+
+	return lod;
+}
+
+Error RenderComponent::update(Second, Second, Bool& updated)
+{
+	updated = m_markedForUpdate;
+	if(updated)
+	{
+		m_markedForUpdate = false;
+
+		// The visibility tests find what changed from the timestamps of the SpatialComponentPool. Make the spatials of
+		// the node look updated so they are tested again
+		SpatialComponentPool& pool = getSceneGraph().getSceneComponentLists().getSpatialComponentPool();
+		const Timestamp timestamp = getGlobalTimestamp();
+		Error err = m_node->iterateComponentsOfType<SpatialComponent>([&](SpatialComponent& sp) -> Error {
+			const U32 idx = sp.getPoolIndex();
+			pool.getChunk(idx).m_timestamps[idx % SpatialComponentPool::CHUNK_SIZE] = timestamp;
+			return Error::NONE;
+		});
+		(void)err;
+	}
+
+	return Error::NONE;
+}
+
 MaterialRenderComponent::MaterialRenderComponent(SceneNode* node, MaterialResourcePtr mtl)
 	: RenderComponent(node)
 	, m_mtl(mtl)
@@ -33,6 +81,19 @@ MaterialRenderComponent::~MaterialRenderComponent()
 	m_vars.destroy(getAllocator());
 }
 
+void MaterialRenderComponent::requestTextureResidency(F32 pixels) const
+{
+	for(const MaterialRenderComponentVariable& var : m_vars)
+	{
+		const MaterialVariable& mvar = var.getMaterialVariable();
+		if(mvar.getShaderProgramResourceInputVariable().getShaderVariableDataType()
+			== ShaderVariableDataType::SAMPLER_2D)
+		{
+			mvar.getValue<TextureResourcePtr>()->requestResidency(pixels);
+		}
+	}
+}
+
 void MaterialRenderComponent::allocateAndSetupUniforms(
 	U set, const RenderQueueDrawContext& ctx, ConstWeakArray<Mat4> transforms, StagingGpuMemoryManager& alloc) const
 {
@@ -33,6 +33,15 @@ public:
 		return m_castsShadow;
 	}
 
+	void setCastsShadow(Bool castsShadow)
+	{
+		if(castsShadow != m_castsShadow)
+		{
+			m_castsShadow = castsShadow;
+			markForUpdate();
+		}
+	}
+
 	Bool isForwardShading() const
 	{
 		return m_isForwardShading;
@@ -40,9 +49,39 @@ public:
 
 	virtual void setupRenderableQueueElement(RenderableQueueElement& el) const = 0;
 
+	/// Request the texture detail that the renderable needs. It's thread-safe.
+	/// @param pixels The size of the renderable on the screen in pixels.
+	virtual void requestTextureResidency(F32 pixels) const
+	{
+	}
+
+	/// Select the LOD from the size of the renderable on the screen. It's thread-safe.
+	/// @param screenSize The size of the renderable as a fraction of the screen height.
+	/// @param lodScreenSizes The screen sizes where every LOD after the 1st starts.
+	/// @param hysteresis How much the screen size needs to go past a threshold to change the previous LOD.
+	/// @param remember Keep the LOD so it's the previous LOD the next time.
+	U8 selectLod(F32 screenSize, ConstWeakArray<F32> lodScreenSizes, F32 hysteresis, Bool remember) const;
+
+	/// Call it when something the visibility tests keep changed without the spatial changing. The material, the output
+	/// of setupRenderableQueueElement or the shadow casting for example. The next update invalidates the cached
+	/// visibility results of the node.
+	void markForUpdate()
+	{
+		m_markedForUpdate = true;
+	}
+
+	/// @name SceneComponent overrides
+	/// @{
+	ANKI_USE_RESULT Error update(Second, Second, Bool& updated) override;
+	/// @}
+
 protected:
 	Bool8 m_castsShadow = false;
 	Bool8 m_isForwardShading = false;
+
+private:
+	mutable Atomic<U8> m_lod = {0}; ///< The previous LOD.
+	Bool8 m_markedForUpdate = false;
 };
 
 /// A wrapper on top of MaterialVariable
@@ -120,6 +159,8 @@ public:
 		return err;
 	}
 
+	void requestTextureResidency(F32 pixels) const override;
+
 	void allocateAndSetupUniforms(U set,
 		const RenderQueueDrawContext& ctx,
 		ConstWeakArray<Mat4> transforms,
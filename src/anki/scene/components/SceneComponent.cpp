@@ -83,6 +83,11 @@ void SceneComponentLists::remove(SceneComponent* comp)
 	ANKI_ASSERT(comp);
 
 	m_lists[comp->getType()].erase(comp);
+
+	if(comp->getType() == SceneComponentType::SPATIAL)
+	{
+		m_spatialRemoveTimestamp = comp->getGlobalTimestamp();
+	}
 }
 
 } // end namespace anki
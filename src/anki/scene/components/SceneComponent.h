@@ -6,6 +6,7 @@
 #pragma once
 
 #include <anki/scene/Common.h>
+#include <anki/scene/components/SceneComponentPool.h>
 #include <anki/util/Functions.h>
 #include <anki/util/BitMask.h>
 #include <anki/util/List.h>
@@ -120,7 +121,8 @@ private:
 	U32 m_idx;
 };
 
-/// Multiple lists of all types of components.
+/// Multiple lists of all types of components. It also holds the dense storage of the components that are touched by
+/// the passes that walk all the scene.
 class SceneComponentLists : public NonCopyable
 {
 anki_internal:
@@ -132,10 +134,32 @@ anki_internal:
 	{
 	}
 
+	void destroy(SceneAllocator<U8> alloc)
+	{
+		m_movePool.destroy(alloc);
+		m_spatialPool.destroy(alloc);
+	}
+
 	void insertNew(SceneComponent* comp);
 
 	void remove(SceneComponent* comp);
 
+	MoveComponentPool& getMoveComponentPool()
+	{
+		return m_movePool;
+	}
+
+	SpatialComponentPool& getSpatialComponentPool()
+	{
+		return m_spatialPool;
+	}
+
+	/// The last time a SpatialComponent got removed.
+	Timestamp getSpatialComponentRemoveTimestamp() const
+	{
+		return m_spatialRemoveTimestamp;
+	}
+
 	template<typename TSceneComponentType, typename Func>
 	void iterateComponents(Func func)
 	{
@@ -151,6 +175,9 @@ anki_internal:
 
 private:
 	Array<IntrusiveList<SceneComponent>, U(SceneComponentType::COUNT)> m_lists;
+	MoveComponentPool m_movePool;
+	SpatialComponentPool m_spatialPool;
+	Timestamp m_spatialRemoveTimestamp = 0;
 };
 /// @}
 
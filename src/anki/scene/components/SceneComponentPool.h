@@ -0,0 +1,175 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Common.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/Math.h>
+#include <anki/collision/CollisionShape.h>
+
+namespace anki
+{
+
+// Forward
+class SpatialComponent;
+
+/// @addtogroup scene
+/// @{
+
+/// Storage for the hot data of all the components of a type. The data live in fixed size chunks and every field is
+/// kept in its own array (struct of arrays) so the passes that touch one field of all the components walk contiguous
+/// memory. The chunks never move so references to the data stay valid until the component is removed.
+/// @tparam TComponent The component type. It should have a U32 m_poolIndex member.
+/// @tparam TData The per chunk data. It should have Array members of TData::CHUNK_SIZE elements and a
+///               copy(dstIdx, src, srcIdx) method.
+template<typename TComponent, typename TData>
+class SceneComponentPool : public NonCopyable
+{
+public:
+	static const U32 CHUNK_SIZE = TData::CHUNK_SIZE;
+
+	class Chunk : public TData
+	{
+	public:
+		Array<TComponent*, CHUNK_SIZE> m_components;
+	};
+
+	SceneComponentPool() = default;
+
+	~SceneComponentPool()
+	{
+		ANKI_ASSERT(m_chunks.getSize() == 0 && "Forgot to destroy");
+	}
+
+	void destroy(SceneAllocator<U8> alloc)
+	{
+		ANKI_ASSERT(m_count == 0);
+		for(Chunk* chunk : m_chunks)
+		{
+			alloc.deleteInstance(chunk);
+		}
+		m_chunks.destroy(alloc);
+	}
+
+	/// Allocate a new element. The data of the element are uninitialized.
+	/// @return The index of the element.
+	U32 add(SceneAllocator<U8> alloc, TComponent* comp)
+	{
+		ANKI_ASSERT(comp);
+		if(m_count == m_chunks.getSize() * CHUNK_SIZE)
+		{
+			m_chunks.emplaceBack(alloc, alloc.newInstance<Chunk>());
+		}
+
+		const U32 idx = m_count++;
+		getChunk(idx).m_components[idx % CHUNK_SIZE] = comp;
+		return idx;
+	}
+
+	/// Remove an element. The last element takes its place to keep the storage dense.
+	void remove(U32 idx)
+	{
+		ANKI_ASSERT(idx < m_count);
+		const U32 lastIdx = --m_count;
+		if(idx != lastIdx)
+		{
+			Chunk& chunk = getChunk(idx);
+			const Chunk& lastChunk = getChunk(lastIdx);
+			TComponent* lastComp = lastChunk.m_components[lastIdx % CHUNK_SIZE];
+
+			chunk.copy(idx % CHUNK_SIZE, lastChunk, lastIdx % CHUNK_SIZE);
+			chunk.m_components[idx % CHUNK_SIZE] = lastComp;
+			lastComp->m_poolIndex = idx;
+		}
+	}
+
+	/// Get the number of elements.
+	U32 getCount() const
+	{
+		return m_count;
+	}
+
+	/// Get the number of chunks that have elements.
+	U32 getChunkCount() const
+	{
+		return (m_count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	}
+
+	/// Get the number of elements of a chunk.
+	U32 getChunkElementCount(U32 chunkIdx) const
+	{
+		ANKI_ASSERT(chunkIdx < getChunkCount());
+		return min(m_count - chunkIdx * CHUNK_SIZE, CHUNK_SIZE);
+	}
+
+	Chunk& getChunkAt(U32 chunkIdx)
+	{
+		return *m_chunks[chunkIdx];
+	}
+
+	const Chunk& getChunkAt(U32 chunkIdx) const
+	{
+		return *m_chunks[chunkIdx];
+	}
+
+	/// Get the chunk of an element.
+	Chunk& getChunk(U32 idx)
+	{
+		return *m_chunks[idx / CHUNK_SIZE];
+	}
+
+	/// Get the chunk of an element.
+	const Chunk& getChunk(U32 idx) const
+	{
+		return *m_chunks[idx / CHUNK_SIZE];
+	}
+
+private:
+	DynamicArray<Chunk*> m_chunks;
+	U32 m_count = 0;
+};
+
+/// The hot data of the MoveComponents.
+class MoveComponentPoolData
+{
+public:
+	static const U32 CHUNK_SIZE = 128;
+
+	Array<Transform, CHUNK_SIZE> m_worldTransforms;
+	Array<Transform, CHUNK_SIZE> m_prevWorldTransforms;
+
+	void copy(U32 dstIdx, const MoveComponentPoolData& src, U32 srcIdx)
+	{
+		m_worldTransforms[dstIdx] = src.m_worldTransforms[srcIdx];
+		m_prevWorldTransforms[dstIdx] = src.m_prevWorldTransforms[srcIdx];
+	}
+};
+
+/// The hot data of the SpatialComponents.
+class SpatialComponentPoolData
+{
+public:
+	static const U32 CHUNK_SIZE = 256;
+
+	Array<Vec4, CHUNK_SIZE> m_aabbMins;
+	Array<Vec4, CHUNK_SIZE> m_aabbMaxs;
+	Array<Timestamp, CHUNK_SIZE> m_timestamps; ///< When the AABB or the RenderComponent of the node got updated.
+	Array<CollisionShapeType, CHUNK_SIZE> m_shapeTypes; ///< The type of the shape the AABB was computed from.
+
+	void copy(U32 dstIdx, const SpatialComponentPoolData& src, U32 srcIdx)
+	{
+		m_aabbMins[dstIdx] = src.m_aabbMins[srcIdx];
+		m_aabbMaxs[dstIdx] = src.m_aabbMaxs[srcIdx];
+		m_timestamps[dstIdx] = src.m_timestamps[srcIdx];
+		m_shapeTypes[dstIdx] = src.m_shapeTypes[srcIdx];
+	}
+};
+
+using MoveComponentPool = SceneComponentPool<MoveComponent, MoveComponentPoolData>;
+using SpatialComponentPool = SceneComponentPool<SpatialComponent, SpatialComponentPoolData>;
+/// @}
+
+} // end namespace anki
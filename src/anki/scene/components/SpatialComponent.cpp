@@ -17,10 +17,19 @@ SpatialComponent::SpatialComponent(SceneNode* node, const CollisionShape* shape)
 	ANKI_ASSERT(shape);
 	markForUpdate();
 	m_octreeInfo.m_userData = this;
+
+	SpatialComponentPool& pool = getSceneGraph().getSceneComponentLists().getSpatialComponentPool();
+	m_poolIndex = pool.add(getAllocator(), this);
+	pool.getChunk(m_poolIndex).m_aabbMins[m_poolIndex % SpatialComponentPool::CHUNK_SIZE] = Vec4(0.0f);
+	pool.getChunk(m_poolIndex).m_aabbMaxs[m_poolIndex % SpatialComponentPool::CHUNK_SIZE] = Vec4(0.0f);
+	pool.getChunk(m_poolIndex).m_timestamps[m_poolIndex % SpatialComponentPool::CHUNK_SIZE] = 0;
+	pool.getChunk(m_poolIndex).m_shapeTypes[m_poolIndex % SpatialComponentPool::CHUNK_SIZE] = shape->getType();
 }
 
 SpatialComponent::~SpatialComponent()
 {
+	getSceneGraph().getSceneComponentLists().getSpatialComponentPool().remove(m_poolIndex);
+
 	if(m_placed)
 	{
 		getSceneGraph().getOctree().remove(m_octreeInfo);
@@ -35,6 +44,12 @@ Error SpatialComponent::update(Second, Second, Bool& updated)
 		m_shape->computeAabb(m_aabb);
 		m_markedForUpdate = false;
 
+		SpatialComponentPool::Chunk& chunk =
+			getSceneGraph().getSceneComponentLists().getSpatialComponentPool().getChunk(m_poolIndex);
+		chunk.m_aabbMins[m_poolIndex % SpatialComponentPool::CHUNK_SIZE] = m_aabb.getMin();
+		chunk.m_aabbMaxs[m_poolIndex % SpatialComponentPool::CHUNK_SIZE] = m_aabb.getMax();
+		chunk.m_timestamps[m_poolIndex % SpatialComponentPool::CHUNK_SIZE] = getGlobalTimestamp();
+
 		getSceneGraph().getOctree().place(m_aabb, &m_octreeInfo);
 		m_placed = true;
 	}
@@ -21,6 +21,9 @@ namespace anki
 /// Spatial component for scene nodes. It is used by scene nodes that need to be placed in the visibility structures.
 class SpatialComponent : public SceneComponent
 {
+	template<typename, typename>
+	friend class SceneComponentPool;
+
 public:
 	static const SceneComponentType CLASS_TYPE = SceneComponentType::SPATIAL;
 
@@ -65,6 +68,12 @@ public:
 		m_origin = origin;
 	}
 
+	/// The index of the component's AABB in the SpatialComponentPool.
+	U32 getPoolIndex() const
+	{
+		return m_poolIndex;
+	}
+
 	/// The derived class has to manually call this method when the collision shape got updated.
 	void markForUpdate()
 	{
@@ -85,6 +94,8 @@ private:
 	Vec4 m_origin = Vec4(MAX_F32, MAX_F32, MAX_F32, 0.0);
 
 	OctreePlaceable m_octreeInfo;
+
+	U32 m_poolIndex;
 };
 
 /// A class that holds spatial information and implements the SpatialComponent virtuals. You just need to update the
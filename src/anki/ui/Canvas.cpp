@@ -40,15 +40,7 @@ Error Canvas::init(FontPtr font, U32 fontHeight, U32 width, U32 height)
 
 	// Create program
 	ANKI_CHECK(m_manager->getResourceManager().loadResource("shaders/Ui.glslp", m_prog));
-	const ShaderProgramResourceVariant* variant;
-
-	for(U i = 0; i < SHADER_COUNT; ++i)
-	{
-		ShaderProgramResourceMutationInitList<1> mutators(m_prog);
-		mutators.add("TEXTURE_TYPE", i);
-		m_prog->getOrCreateVariant(mutators.get(), variant);
-		m_grProgs[i] = variant->getProgram();
-	}
+	getProgramVariants();
 
 	// Other
 	m_stackAlloc = StackAllocator<U8>(getAllocator().getMemoryPool().getAllocationCallback(),
@@ -64,6 +56,21 @@ Error Canvas::init(FontPtr font, U32 fontHeight, U32 width, U32 height)
 	return Error::NONE;
 }
 
+void Canvas::getProgramVariants()
+{
+	const ShaderProgramResourceVariant* variant;
+
+	for(U i = 0; i < SHADER_COUNT; ++i)
+	{
+		ShaderProgramResourceMutationInitList<1> mutators(m_prog);
+		mutators.add("TEXTURE_TYPE", i);
+		m_prog->getOrCreateVariant(mutators.get(), variant);
+		m_grProgs[i] = variant->getProgram();
+	}
+
+	m_progReloadGeneration = m_prog->getReloadGeneration();
+}
+
 void Canvas::reset()
 {
 	m_references.destroy(m_stackAlloc);
@@ -213,6 +220,11 @@ void Canvas::appendToCommandBuffer(CommandBufferPtr cmdb)
 	cmdb->setViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
 
 	// Prog & tex
+	if(m_prog->getReloadGeneration() != m_progReloadGeneration)
+	{
+		getProgramVariants();
+	}
+
 	ShaderProgramPtr boundProg;
 
 	const nk_draw_command* cmd = nullptr;
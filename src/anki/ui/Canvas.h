@@ -82,6 +82,7 @@ private:
 
 	ShaderProgramResourcePtr m_prog;
 	Array<ShaderProgramPtr, SHADER_COUNT> m_grProgs;
+	U32 m_progReloadGeneration = 0; ///< The generation of m_prog that m_grProgs came from.
 	SamplerPtr m_sampler;
 
 	StackAllocator<U8> m_stackAlloc;
@@ -93,6 +94,9 @@ private:
 #endif
 
 	void reset();
+
+	/// Get the variants of m_prog. Call it again when m_prog is hot reloaded.
+	void getProgramVariants();
 };
 /// @}
 
@@ -384,6 +384,11 @@ public:
 		// Don't touch the m_alloc
 	}
 
+	GenericMemoryPoolAllocator<T> getAllocator() const
+	{
+		return m_alloc;
+	}
+
 private:
 	GenericMemoryPoolAllocator<T> m_alloc;
 };
@@ -6,6 +6,8 @@
 #pragma once
 
 #include <anki/util/String.h>
+#include <anki/util/WeakArray.h>
+#include <anki/util/NonCopyable.h>
 
 namespace anki
 {
@@ -25,6 +27,9 @@ void getFilepathFilename(const CString& filename, GenericMemoryPoolAllocator<U8>
 /// Return true if directory exists?
 Bool directoryExists(const CString& dir);
 
+/// Get the time a file was last modified. The value is only meant to be compared with other values of the same file.
+ANKI_USE_RESULT Error getFileModificationTime(const CString& filename, U64& time);
+
 /// Callback for the @ref walkDirectoryTree.
 /// @param filename The file or directory name.
 /// @param userData User data passed to walkDirectoryTree.
@@ -44,6 +49,37 @@ ANKI_USE_RESULT Error createDirectory(const CString& dir);
 /// Write the home directory to @a buff. The @a buffSize is the size of the @a buff. If the @buffSize is not enough the
 /// function will throw an exception.
 ANKI_USE_RESULT Error getHomeDirectory(GenericMemoryPoolAllocator<U8> alloc, String& out);
+
+/// A read-only file that is memory mapped as a whole.
+class MemoryMappedFile : public NonCopyable
+{
+public:
+	MemoryMappedFile() = default;
+
+	/// Unmaps the file.
+	~MemoryMappedFile()
+	{
+		unmap();
+	}
+
+	/// Map a file for reading. An empty file is not mapped but it's not an error either.
+	ANKI_USE_RESULT Error map(const CString& filename);
+
+	void unmap();
+
+	/// Get the contents of the file. They are valid until the file is unmapped.
+	ConstWeakArray<U8> getData() const
+	{
+		return ConstWeakArray<U8>(static_cast<const U8*>(m_mem), m_size);
+	}
+
+private:
+	void* m_mem = nullptr;
+	PtrSize m_size = 0;
+#if ANKI_OS == ANKI_OS_WINDOWS
+	void* m_mapping = nullptr; ///< The handle of the file mapping.
+#endif
+};
 /// @}
 
 } // end namespace anki
@@ -12,6 +12,9 @@
 #include <dirent.h>
 #include <cerrno>
 #include <fts.h> // For walkDirectoryTree
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <cstdlib>
 
 // Define PATH_MAX if needed
@@ -48,6 +51,23 @@ Bool directoryExists(const CString& filename)
 	}
 }
 
+Error getFileModificationTime(const CString& filename, U64& time)
+{
+	struct stat s;
+	if(stat(filename.get(), &s))
+	{
+		ANKI_UTIL_LOGE("stat() failed: %s : %s", strerror(errno), filename.get());
+		return Error::FUNCTION_FAILED;
+	}
+
+#if ANKI_OS == ANKI_OS_LINUX || ANKI_OS == ANKI_OS_ANDROID
+	time = U64(s.st_mtim.tv_sec) * 1000000000 + U64(s.st_mtim.tv_nsec);
+#else
+	time = U64(s.st_mtime);
+#endif
+	return Error::NONE;
+}
+
 Error walkDirectoryTree(const CString& dir, void* userData, WalkDirectoryTreeCallback callback)
 {
 	ANKI_ASSERT(callback != nullptr);
@@ -188,4 +208,52 @@ Error getHomeDirectory(GenericMemoryPoolAllocator<U8> alloc, String& out)
 	return Error::NONE;
 }
 
+Error MemoryMappedFile::map(const CString& filename)
+{
+	ANKI_ASSERT(m_mem == nullptr && "Already mapped");
+
+	const int fd = open(filename.get(), O_RDONLY);
+	if(fd == -1)
+	{
+		ANKI_UTIL_LOGE("open() failed: %s : %s", strerror(errno), filename.get());
+		return Error::FILE_ACCESS;
+	}
+
+	Error err = Error::NONE;
+	struct stat s;
+	if(fstat(fd, &s))
+	{
+		ANKI_UTIL_LOGE("fstat() failed: %s : %s", strerror(errno), filename.get());
+		err = Error::FILE_ACCESS;
+	}
+	else if(s.st_size > 0)
+	{
+		void* mem = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mem == MAP_FAILED)
+		{
+			ANKI_UTIL_LOGE("mmap() failed: %s : %s", strerror(errno), filename.get());
+			err = Error::FILE_ACCESS;
+		}
+		else
+		{
+			m_mem = mem;
+			m_size = s.st_size;
+		}
+	}
+
+	// The mapping keeps the file alive
+	close(fd);
+	return err;
+}
+
+void MemoryMappedFile::unmap()
+{
+	if(m_mem)
+	{
+		munmap(m_mem, m_size);
+		m_mem = nullptr;
+		m_size = 0;
+	}
+}
+
 } // end namespace anki
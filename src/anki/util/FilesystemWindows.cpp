@@ -33,6 +33,19 @@ Bool directoryExists(const CString& filename)
 	return dwAttrib != INVALID_FILE_ATTRIBUTES && (dwAttrib & FILE_ATTRIBUTE_DIRECTORY);
 }
 
+Error getFileModificationTime(const CString& filename, U64& time)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if(!GetFileAttributesEx(filename.get(), GetFileExInfoStandard, &data))
+	{
+		ANKI_UTIL_LOGE("GetFileAttributesEx() failed: %s", filename.get());
+		return Error::FUNCTION_FAILED;
+	}
+
+	time = (U64(data.ftLastWriteTime.dwHighDateTime) << 32) | U64(data.ftLastWriteTime.dwLowDateTime);
+	return Error::NONE;
+}
+
 Error removeDirectory(const CString& dirname)
 {
 	// For some reason dirname should be double null terminated
@@ -201,4 +214,69 @@ Error walkDirectoryTree(const CString& dir, void* userData, WalkDirectoryTreeCal
 	return walkDirectoryTreeInternal(dir, userData, callback, baseDirLen);
 }
 
+Error MemoryMappedFile::map(const CString& filename)
+{
+	ANKI_ASSERT(m_mem == nullptr && "Already mapped");
+
+	HANDLE file = CreateFile(
+		filename.get(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		ANKI_UTIL_LOGE("CreateFile() failed: %s", filename.get());
+		return Error::FILE_ACCESS;
+	}
+
+	Error err = Error::NONE;
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size))
+	{
+		ANKI_UTIL_LOGE("GetFileSizeEx() failed: %s", filename.get());
+		err = Error::FILE_ACCESS;
+	}
+
+	HANDLE mapping = nullptr;
+	if(!err && size.QuadPart > 0)
+	{
+		mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mapping == nullptr)
+		{
+			ANKI_UTIL_LOGE("CreateFileMapping() failed: %s", filename.get());
+			err = Error::FILE_ACCESS;
+		}
+	}
+
+	if(mapping)
+	{
+		void* mem = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if(mem == nullptr)
+		{
+			ANKI_UTIL_LOGE("MapViewOfFile() failed: %s", filename.get());
+			CloseHandle(mapping);
+			err = Error::FILE_ACCESS;
+		}
+		else
+		{
+			m_mem = mem;
+			m_size = PtrSize(size.QuadPart);
+			m_mapping = mapping;
+		}
+	}
+
+	// The mapping keeps the file alive
+	CloseHandle(file);
+	return err;
+}
+
+void MemoryMappedFile::unmap()
+{
+	if(m_mem)
+	{
+		UnmapViewOfFile(m_mem);
+		CloseHandle(m_mapping);
+		m_mem = nullptr;
+		m_mapping = nullptr;
+		m_size = 0;
+	}
+}
+
 } // end namespace anki
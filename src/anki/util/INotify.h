@@ -6,6 +6,8 @@
 #pragma once
 
 #include <anki/util/String.h>
+#include <anki/util/StringList.h>
+#include <anki/util/DynamicArray.h>
 
 namespace anki
 {
@@ -13,7 +15,7 @@ namespace anki
 /// @addtogroup util_file
 /// @{
 
-/// A wrapper on top of inotify. Check for filesystem updates.
+/// A wrapper on top of inotify. Check for filesystem updates. It can watch more than one path.
 class INotify
 {
 public:
@@ -25,33 +27,60 @@ public:
 	~INotify()
 	{
 		destroyInternal();
-		m_path.destroy(m_alloc);
+
+		for(Watch& w : m_watches)
+		{
+			w.m_path.destroy(m_alloc);
+		}
+		m_watches.destroy(m_alloc);
 	}
 
 	// Non-copyable
 	INotify& operator=(const INotify&) = delete;
 
-	/// @param path Path to file or directory.
-	ANKI_USE_RESULT Error init(GenericMemoryPoolAllocator<U8> alloc, CString path)
+	/// Init without watching anything. Use addPath() to add paths.
+	ANKI_USE_RESULT Error init(GenericMemoryPoolAllocator<U8> alloc)
 	{
 		m_alloc = alloc;
-		m_path.create(alloc, path);
 		return initInternal();
 	}
 
-	/// Check if the file was modified in any way.
+	/// @param path Path to file or directory.
+	ANKI_USE_RESULT Error init(GenericMemoryPoolAllocator<U8> alloc, CString path)
+	{
+		ANKI_CHECK(init(alloc));
+		return addPath(path);
+	}
+
+	/// Watch one more file or directory. The directories are not watched recursively.
+	ANKI_USE_RESULT Error addPath(CString path);
+
+	/// Check if the files were modified in any way.
 	ANKI_USE_RESULT Error pollEvents(Bool& modified);
 
+	/// Get the files that were written or moved in place since the previous poll. For the watched directories it gets
+	/// the files inside them. A file may be in the list more than once.
+	/// @param[out] files The paths of the files. They start with the watched path.
+	ANKI_USE_RESULT Error pollEvents(StringListAuto& files);
+
 private:
+	class Watch
+	{
+	public:
+		String m_path;
+		int m_id = -1;
+	};
+
 	GenericMemoryPoolAllocator<U8> m_alloc;
-	String m_path;
+	DynamicArray<Watch> m_watches;
 #if ANKI_OS == ANKI_OS_LINUX
 	int m_fd = -1;
-	int m_watch = -1;
 #endif
 
 	void destroyInternal();
 	ANKI_USE_RESULT Error initInternal();
+	ANKI_USE_RESULT Error addWatchInternal(Watch& watch);
+	ANKI_USE_RESULT Error pollEventsInternal(Bool& modified, StringListAuto* files);
 };
 /// @}
 
@@ -14,45 +14,31 @@ namespace anki
 
 Error INotify::initInternal()
 {
-	ANKI_ASSERT(m_fd < 0 && m_watch < 0);
-
-	Error err = Error::NONE;
+	ANKI_ASSERT(m_fd < 0);
 
 	m_fd = inotify_init();
 	if(m_fd < 0)
 	{
 		ANKI_UTIL_LOGE("inotify_init() failed: %s", strerror(errno));
-		err = Error::FUNCTION_FAILED;
-	}
-
-	if(!err)
-	{
-		m_watch = inotify_add_watch(m_fd, &m_path[0], IN_MODIFY | IN_CREATE | IN_DELETE | IN_IGNORED | IN_DELETE_SELF);
-		if(m_watch < 0)
-		{
-			ANKI_UTIL_LOGE("inotify_add_watch() failed: %s", strerror(errno));
-			err = Error::FUNCTION_FAILED;
-		}
-	}
-
-	if(err)
-	{
-		destroyInternal();
+		return Error::FUNCTION_FAILED;
 	}
 
-	return err;
+	return Error::NONE;
 }
 
 void INotify::destroyInternal()
 {
-	if(m_watch >= 0)
+	for(Watch& w : m_watches)
 	{
-		int err = inotify_rm_watch(m_fd, m_watch);
-		if(err < 0)
+		if(w.m_id >= 0)
 		{
-			ANKI_UTIL_LOGE("inotify_rm_watch() failed: %s\n", strerror(errno));
+			int err = inotify_rm_watch(m_fd, w.m_id);
+			if(err < 0)
+			{
+				ANKI_UTIL_LOGE("inotify_rm_watch() failed: %s\n", strerror(errno));
+			}
+			w.m_id = -1;
 		}
-		m_watch = -1;
 	}
 
 	if(m_fd >= 0)
@@ -66,14 +52,48 @@ void INotify::destroyInternal()
 	}
 }
 
+Error INotify::addWatchInternal(Watch& watch)
+{
+	ANKI_ASSERT(m_fd >= 0 && watch.m_id < 0);
+
+	watch.m_id = inotify_add_watch(m_fd,
+		&watch.m_path[0],
+		IN_MODIFY | IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_IGNORED | IN_DELETE_SELF);
+	if(watch.m_id < 0)
+	{
+		ANKI_UTIL_LOGE("inotify_add_watch() failed: %s", strerror(errno));
+		return Error::FUNCTION_FAILED;
+	}
+
+	return Error::NONE;
+}
+
+Error INotify::addPath(CString path)
+{
+	Watch& watch = *m_watches.emplaceBack(m_alloc);
+	watch.m_path.create(m_alloc, path);
+	return addWatchInternal(watch);
+}
+
 Error INotify::pollEvents(Bool& modified)
 {
-	ANKI_ASSERT(m_fd >= 0 && m_watch >= 0);
+	return pollEventsInternal(modified, nullptr);
+}
+
+Error INotify::pollEvents(StringListAuto& files)
+{
+	Bool modified;
+	return pollEventsInternal(modified, &files);
+}
+
+Error INotify::pollEventsInternal(Bool& modified, StringListAuto* files)
+{
+	ANKI_ASSERT(m_fd >= 0);
 
 	Error err = Error::NONE;
 	modified = false;
 
-	while(true)
+	while(!err)
 	{
 		pollfd pfd = {m_fd, POLLIN, 0};
 		int ret = poll(&pfd, 1, 0);
@@ -89,39 +109,61 @@ Error INotify::pollEvents(Bool& modified)
 			// No events, move on
 			break;
 		}
-		else
-		{
-			// Process the new event
 
-			Array<U8, 2_KB> readBuff;
-			int nbytes = read(m_fd, &readBuff[0], sizeof(readBuff));
-			if(nbytes > 0)
-			{
-				inotify_event* event = reinterpret_cast<inotify_event*>(&readBuff[0]);
+		// Process the new events. One read may return many of them
+		alignas(inotify_event) Array<U8, 4_KB> readBuff;
+		int nbytes = read(m_fd, &readBuff[0], sizeof(readBuff));
+		if(nbytes <= 0)
+		{
+			ANKI_UTIL_LOGE("read() failed to read the expected size of data: %s", strerror(errno));
+			err = Error::FUNCTION_FAILED;
+			break;
+		}
 
-				if(event->mask & IN_IGNORED)
-				{
-					// File was moved or deleted. Some editors on save they delete the file and move another file to
-					// its place. In that case the m_fd and the m_watch need to be re-created.
+		for(int offset = 0; offset < nbytes && !err;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(&readBuff[offset]);
+			offset += sizeof(inotify_event) + event->len;
 
-					m_watch = -1; // Watch descriptor was removed implicitly
-					destroyInternal();
-					err = initInternal();
-					if(err)
-					{
-						break;
-					}
-				}
-				else
+			Watch* watch = nullptr;
+			for(Watch& w : m_watches)
+			{
+				if(w.m_id == event->wd)
 				{
-					modified = true;
+					watch = &w;
+					break;
 				}
 			}
+
+			if(watch == nullptr)
+			{
+				// It's from a watch that was removed
+				continue;
+			}
+
+			if(event->mask & IN_IGNORED)
+			{
+				// File was moved or deleted. Some editors on save they delete the file and move another file to its
+				// place. In that case the watch needs to be re-created.
+				watch->m_id = -1; // Watch descriptor was removed implicitly
+				err = addWatchInternal(*watch);
+				modified = true;
+			}
 			else
 			{
-				ANKI_UTIL_LOGE("read() failed to read the expected size of data: %s", strerror(errno));
-				err = Error::FUNCTION_FAILED;
-				break;
+				modified = true;
+
+				if(files && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+				{
+					if(event->len > 0)
+					{
+						files->pushBackSprintf("%s/%s", watch->m_path.cstr(), event->name);
+					}
+					else
+					{
+						files->pushBackSprintf("%s", watch->m_path.cstr());
+					}
+				}
 			}
 		}
 	}
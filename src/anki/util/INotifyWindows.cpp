@@ -19,7 +19,31 @@ void INotify::destroyInternal()
 	// TODO
 }
 
+Error INotify::addWatchInternal(Watch& watch)
+{
+	// TODO
+	return Error::NONE;
+}
+
+Error INotify::addPath(CString path)
+{
+	Watch& watch = *m_watches.emplaceBack(m_alloc);
+	watch.m_path.create(m_alloc, path);
+	return addWatchInternal(watch);
+}
+
 Error INotify::pollEvents(Bool& modified)
+{
+	return pollEventsInternal(modified, nullptr);
+}
+
+Error INotify::pollEvents(StringListAuto& files)
+{
+	Bool modified;
+	return pollEventsInternal(modified, &files);
+}
+
+Error INotify::pollEventsInternal(Bool& modified, StringListAuto* files)
 {
 	// TODO
 	modified = false;
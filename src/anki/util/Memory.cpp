@@ -137,6 +137,64 @@ void* allocAligned(void* userData, void* ptr, PtrSize size, PtrSize alignment)
 	return out;
 }
 
+/// Gives a unique number to the pools that have per-thread state.
+static Atomic<U32> g_poolUuid = {1};
+
+/// A slot of a pool that the current thread used recently.
+class ThreadSlotCacheEntry
+{
+public:
+	U32 m_poolUuid = 0;
+	U32 m_slot = 0;
+};
+
+static thread_local Array<ThreadSlotCacheEntry, 4> g_threadSlotCache;
+static thread_local U32 g_threadSlotCacheNext = 0;
+
+/// Find the slot of a pool that the current thread owns or claim a free one. The slots are claimed in order so the
+/// owned one is always before the free ones.
+/// @return The slot or MAX_U32 if all slots are owned by other threads.
+static U32 getThreadSlot(U32 poolUuid, Atomic<ThreadId>* owners, U32 ownerCount)
+{
+	ANKI_ASSERT(poolUuid != 0);
+
+	for(const ThreadSlotCacheEntry& entry : g_threadSlotCache)
+	{
+		if(entry.m_poolUuid == poolUuid)
+		{
+			return entry.m_slot;
+		}
+	}
+
+	const ThreadId tid = Thread::getCurrentThreadId();
+	ANKI_ASSERT(tid != 0);
+	U32 slot = MAX_U32;
+	for(U32 i = 0; i < ownerCount; ++i)
+	{
+		ThreadId owner = owners[i].load();
+		while(owner == 0)
+		{
+			if(owners[i].compareExchange(owner, tid))
+			{
+				owner = tid;
+			}
+		}
+
+		if(owner == tid)
+		{
+			slot = i;
+			break;
+		}
+	}
+
+	ThreadSlotCacheEntry& entry = g_threadSlotCache[g_threadSlotCacheNext];
+	g_threadSlotCacheNext = (g_threadSlotCacheNext + 1) % g_threadSlotCache.getSize();
+	entry.m_poolUuid = poolUuid;
+	entry.m_slot = slot;
+
+	return slot;
+}
+
 BaseMemoryPool::~BaseMemoryPool()
 {
 	ANKI_ASSERT(m_refcount.load() == 0 && "Refcount should be zero");
@@ -147,6 +205,16 @@ Bool BaseMemoryPool::isCreated() const
 	return m_allocCb != nullptr;
 }
 
+U32 BaseMemoryPool::getAllocationsCount() const
+{
+	if(m_type == Type::THREAD_CACHING)
+	{
+		return static_cast<const ThreadCachingMemoryPool*>(this)->getAllocationsCount();
+	}
+
+	return m_allocationsCount.load();
+}
+
 void* BaseMemoryPool::allocate(PtrSize size, PtrSize alignmentBytes)
 {
 	void* out = nullptr;
@@ -161,6 +229,9 @@ void* BaseMemoryPool::allocate(PtrSize size, PtrSize alignmentBytes)
 	case Type::CHAIN:
 		out = static_cast<ChainMemoryPool*>(this)->allocate(size, alignmentBytes);
 		break;
+	case Type::THREAD_CACHING:
+		out = static_cast<ThreadCachingMemoryPool*>(this)->allocate(size, alignmentBytes);
+		break;
 	default:
 		ANKI_ASSERT(0);
 	}
@@ -181,6 +252,9 @@ void BaseMemoryPool::free(void* ptr)
 	case Type::CHAIN:
 		static_cast<ChainMemoryPool*>(this)->free(ptr);
 		break;
+	case Type::THREAD_CACHING:
+		static_cast<ThreadCachingMemoryPool*>(this)->free(ptr);
+		break;
 	default:
 		ANKI_ASSERT(0);
 	}
@@ -271,20 +345,39 @@ StackMemoryPool::StackMemoryPool()
 
 StackMemoryPool::~StackMemoryPool()
 {
-	// Iterate all until you find an unused
-	for(Chunk& ch : m_chunks)
+	if(m_arenas == nullptr)
 	{
-		if(ch.m_baseMem != nullptr)
-		{
-			ch.check();
+		return;
+	}
 
-			invalidateMemory(ch.m_baseMem, ch.m_size);
-			m_allocCb(m_allocCbUserData, ch.m_baseMem, 0, 0);
-		}
-		else
+	for(U32 a = 0; a < getArenaCount(); ++a)
+	{
+		Arena& arena = m_arenas[a];
+
+		// Iterate all until you find an unused
+		for(Chunk& ch : arena.m_chunks)
 		{
-			break;
+			if(ch.m_baseMem != nullptr)
+			{
+				ch.check();
+
+				invalidateMemory(ch.m_baseMem, ch.m_size);
+				m_allocCb(m_allocCbUserData, ch.m_baseMem, 0, 0);
+			}
+			else
+			{
+				break;
+			}
 		}
+
+		arena.~Arena();
+	}
+
+	m_allocCb(m_allocCbUserData, m_arenas, 0, 0);
+
+	if(m_arenaOwners)
+	{
+		m_allocCb(m_allocCbUserData, m_arenaOwners, 0, 0);
 	}
 
 	// Do some error checks
@@ -301,13 +394,16 @@ void StackMemoryPool::create(AllocAlignedCallback allocCb,
 	F32 nextChunkScale,
 	PtrSize nextChunkBias,
 	Bool ignoreDeallocationErrors,
-	PtrSize alignmentBytes)
+	PtrSize alignmentBytes,
+	U32 maxThreadCount)
 {
 	ANKI_ASSERT(!isCreated());
 	ANKI_ASSERT(allocCb);
 	ANKI_ASSERT(initialChunkSize > 0);
 	ANKI_ASSERT(nextChunkScale >= 1.0);
 	ANKI_ASSERT(alignmentBytes > 0);
+	ANKI_ASSERT((maxThreadCount == 0 || ignoreDeallocationErrors)
+				&& "Allocations are not counted in per-thread mode so deallocation errors can't be detected");
 
 	m_allocCb = allocCb;
 	m_allocCbUserData = allocCbUserData;
@@ -316,26 +412,92 @@ void StackMemoryPool::create(AllocAlignedCallback allocCb,
 	m_nextChunkScale = nextChunkScale;
 	m_nextChunkBias = nextChunkBias;
 	m_ignoreDeallocationErrors = ignoreDeallocationErrors;
+	m_threadArenaCount = maxThreadCount;
 
-	// Create the first chunk
-	void* mem = m_allocCb(m_allocCbUserData, nullptr, m_initialChunkSize, m_alignmentBytes);
+	// Create the arenas
+	const U32 arenaCount = getArenaCount();
+	m_arenas = static_cast<Arena*>(
+		m_allocCb(m_allocCbUserData, nullptr, sizeof(Arena) * arenaCount, max(ARENA_ALIGNMENT, alignof(Arena))));
+	if(m_arenas == nullptr)
+	{
+		ANKI_CREATION_OOM_ACTION();
+		return;
+	}
 
-	if(mem != nullptr)
+	for(U32 a = 0; a < arenaCount; ++a)
+	{
+		::new(&m_arenas[a]) Arena();
+	}
+
+	if(m_threadArenaCount > 0)
 	{
-		invalidateMemory(mem, m_initialChunkSize);
+		m_arenaOwners = static_cast<Atomic<ThreadId>*>(m_allocCb(
+			m_allocCbUserData, nullptr, sizeof(Atomic<ThreadId>) * m_threadArenaCount, alignof(Atomic<ThreadId>)));
+		if(m_arenaOwners == nullptr)
+		{
+			ANKI_CREATION_OOM_ACTION();
+			return;
+		}
 
-		m_chunks[0].m_baseMem = static_cast<U8*>(mem);
-		m_chunks[0].m_mem.store(m_chunks[0].m_baseMem);
-		m_chunks[0].m_size = initialChunkSize;
+		for(U32 i = 0; i < m_threadArenaCount; ++i)
+		{
+			::new(&m_arenaOwners[i]) Atomic<ThreadId>(0);
+		}
 
-		ANKI_ASSERT(m_crntChunkIdx.load() == 0);
+		m_uuid = g_poolUuid.fetchAdd(1);
 	}
-	else
+
+	// Create the first chunk of the shared arena. The rest will create it on first use
+	if(!initArena(m_arenas[0]))
 	{
 		ANKI_CREATION_OOM_ACTION();
 	}
 }
 
+Bool StackMemoryPool::initArena(Arena& arena)
+{
+	ANKI_ASSERT(arena.m_chunks[0].m_baseMem == nullptr);
+
+	void* mem = m_allocCb(m_allocCbUserData, nullptr, m_initialChunkSize, m_alignmentBytes);
+	if(mem == nullptr)
+	{
+		return false;
+	}
+
+	invalidateMemory(mem, m_initialChunkSize);
+
+	arena.m_chunks[0].m_baseMem = static_cast<U8*>(mem);
+	arena.m_chunks[0].m_mem.store(arena.m_chunks[0].m_baseMem);
+	arena.m_chunks[0].m_size = m_initialChunkSize;
+
+	ANKI_ASSERT(arena.m_crntChunkIdx.load() == 0);
+	return true;
+}
+
+StackMemoryPool::Arena& StackMemoryPool::getArena()
+{
+	if(m_threadArenaCount == 0)
+	{
+		return m_arenas[0];
+	}
+
+	const U32 slot = getThreadSlot(m_uuid, m_arenaOwners, m_threadArenaCount);
+	if(slot == MAX_U32)
+	{
+		return m_arenas[0];
+	}
+
+	Arena& arena = m_arenas[slot + 1];
+	if(ANKI_UNLIKELY(arena.m_chunks[0].m_baseMem == nullptr) && !initArena(arena))
+	{
+		// Can't create the first chunk. Fallback to the shared arena
+		ANKI_UTIL_LOGE("Failed to create the arena of a thread. Will use the shared one");
+		return m_arenas[0];
+	}
+
+	return arena;
+}
+
 void* StackMemoryPool::allocate(PtrSize size, PtrSize alignment)
 {
 	ANKI_ASSERT(isCreated());
@@ -346,13 +508,14 @@ void* StackMemoryPool::allocate(PtrSize size, PtrSize alignment)
 	ANKI_ASSERT(size > 0);
 	ANKI_ASSERT(size <= m_initialChunkSize && "The chunks should have enough space to hold at least one allocation");
 
+	Arena& arena = getArena();
 	Chunk* crntChunk = nullptr;
 	Bool retry = true;
 	U8* out = nullptr;
 
 	do
 	{
-		crntChunk = &m_chunks[m_crntChunkIdx.load()];
+		crntChunk = &arena.m_chunks[arena.m_crntChunkIdx.load()];
 		crntChunk->check();
 
 		out = crntChunk->m_mem.fetchAdd(size);
@@ -363,22 +526,25 @@ void* StackMemoryPool::allocate(PtrSize size, PtrSize alignment)
 			// All is fine, there is enough space in the chunk
 
 			retry = false;
-			m_allocationsCount.fetchAdd(1);
+			if(m_threadArenaCount == 0)
+			{
+				m_allocationsCount.fetchAdd(1);
+			}
 		}
 		else
 		{
 			// Need new chunk
 
-			LockGuard<Mutex> lock(m_lock);
+			LockGuard<Mutex> lock(arena.m_lock);
 
 			// Make sure that only one thread will create a new chunk
-			if(&m_chunks[m_crntChunkIdx.load()] == crntChunk)
+			if(&arena.m_chunks[arena.m_crntChunkIdx.load()] == crntChunk)
 			{
 				// We can create a new chunk
 
 				PtrSize oldChunkSize = crntChunk->m_size;
 				++crntChunk;
-				if(crntChunk >= m_chunks.getEnd())
+				if(crntChunk >= arena.m_chunks.getEnd())
 				{
 					ANKI_UTIL_LOGE("Number of chunks is not enough. Expect a crash");
 				}
@@ -400,8 +566,8 @@ void* StackMemoryPool::allocate(PtrSize size, PtrSize alignment)
 						crntChunk->m_mem.store(crntChunk->m_baseMem);
 						crntChunk->m_size = newChunkSize;
 
-						U idx = m_crntChunkIdx.fetchAdd(1);
-						ANKI_ASSERT(&m_chunks[idx] == crntChunk - 1);
+						U idx = arena.m_crntChunkIdx.fetchAdd(1);
+						ANKI_ASSERT(&arena.m_chunks[idx] == crntChunk - 1);
 						(void)idx;
 					}
 					else
@@ -418,8 +584,8 @@ void* StackMemoryPool::allocate(PtrSize size, PtrSize alignment)
 					crntChunk->checkReset();
 					invalidateMemory(crntChunk->m_baseMem, crntChunk->m_size);
 
-					U idx = m_crntChunkIdx.fetchAdd(1);
-					ANKI_ASSERT(&m_chunks[idx] == crntChunk - 1);
+					U idx = arena.m_crntChunkIdx.fetchAdd(1);
+					ANKI_ASSERT(&arena.m_chunks[idx] == crntChunk - 1);
 					(void)idx;
 				}
 			}
@@ -437,17 +603,34 @@ void StackMemoryPool::free(void* ptr)
 	// allocated by this class
 	ANKI_ASSERT(ptr != nullptr && isAligned(m_alignmentBytes, ptr));
 
-	auto count = m_allocationsCount.fetchSub(1);
-	ANKI_ASSERT(count > 0);
-	(void)count;
+	if(m_threadArenaCount == 0)
+	{
+		auto count = m_allocationsCount.fetchSub(1);
+		ANKI_ASSERT(count > 0);
+		(void)count;
+	}
 }
 
-void StackMemoryPool::reset()
+void StackMemoryPool::resetArena(Arena& arena)
 {
-	ANKI_ASSERT(isCreated());
+	// Arenas of threads that never allocated have no chunks
+	if(arena.m_chunks[0].m_baseMem == nullptr)
+	{
+		return;
+	}
+
+	// Compute the memory used before rewinding. The chunks before the current are full
+	PtrSize used = 0;
+	const U32 crntChunkIdx = arena.m_crntChunkIdx.load();
+	for(U32 i = 0; i <= crntChunkIdx; ++i)
+	{
+		const Chunk& ch = arena.m_chunks[i];
+		used += min<PtrSize>(PtrSize(ch.m_mem.load() - ch.m_baseMem), ch.m_size);
+	}
+	arena.m_highWaterMark = max(arena.m_highWaterMark, used);
 
 	// Iterate all until you find an unused
-	for(Chunk& ch : m_chunks)
+	for(Chunk& ch : arena.m_chunks)
 	{
 		if(ch.m_baseMem != nullptr)
 		{
@@ -463,8 +646,18 @@ void StackMemoryPool::reset()
 	}
 
 	// Set the crnt chunk
-	m_chunks[0].checkReset();
-	m_crntChunkIdx.store(0);
+	arena.m_chunks[0].checkReset();
+	arena.m_crntChunkIdx.store(0);
+}
+
+void StackMemoryPool::reset()
+{
+	ANKI_ASSERT(isCreated());
+
+	for(U32 a = 0; a < getArenaCount(); ++a)
+	{
+		resetArena(m_arenas[a]);
+	}
 
 	// Reset allocation count and do some error checks
 	auto allocCount = m_allocationsCount.exchange(0);
@@ -477,15 +670,31 @@ void StackMemoryPool::reset()
 PtrSize StackMemoryPool::getMemoryCapacity() const
 {
 	PtrSize sum = 0;
-	U crntChunkIdx = m_crntChunkIdx.load();
-	for(U i = 0; i <= crntChunkIdx; ++i)
+	for(U32 a = 0; a < getArenaCount(); ++a)
 	{
-		sum += m_chunks[i].m_size;
+		const Arena& arena = m_arenas[a];
+		if(arena.m_chunks[0].m_baseMem == nullptr)
+		{
+			continue;
+		}
+
+		U crntChunkIdx = arena.m_crntChunkIdx.load();
+		for(U i = 0; i <= crntChunkIdx; ++i)
+		{
+			sum += arena.m_chunks[i].m_size;
+		}
 	}
 
 	return sum;
 }
 
+PtrSize StackMemoryPool::getArenaHighWaterMark(U32 arenaIdx) const
+{
+	ANKI_ASSERT(isCreated());
+	ANKI_ASSERT(arenaIdx < getArenaCount());
+	return m_arenas[arenaIdx].m_highWaterMark;
+}
+
 ChainMemoryPool::ChainMemoryPool()
 	: BaseMemoryPool(Type::CHAIN)
 {
@@ -776,4 +985,395 @@ void ChainMemoryPool::destroyChunk(Chunk* ch)
 	m_allocCb(m_allocCbUserData, ch, 0, 0);
 }
 
+/// The sizes of the size classes of ThreadCachingMemoryPool. The step grows with the size to keep the waste bounded.
+static const Array<U16, ThreadCachingMemoryPool::SIZE_CLASS_COUNT> THREAD_CACHING_SIZE_CLASSES = {
+	{16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640, 768, 896, 1024}};
+
+static U32 hashSpanAddress(PtrSize spanBase, U32 tableSize)
+{
+	ANKI_ASSERT(isPowerOfTwo(tableSize));
+	return U32((U64(spanBase) * 0x9E3779B97F4A7C15ull) >> 32) & (tableSize - 1);
+}
+
+ThreadCachingMemoryPool::ThreadCachingMemoryPool()
+	: BaseMemoryPool(Type::THREAD_CACHING)
+{
+}
+
+ThreadCachingMemoryPool::~ThreadCachingMemoryPool()
+{
+	if(!isCreated())
+	{
+		return;
+	}
+
+	const U32 count = getAllocationsCount();
+	if(count != 0)
+	{
+		ANKI_UTIL_LOGW("Memory pool destroyed before all memory being released "
+					   "(%u deallocations missed)",
+			count);
+	}
+
+	for(U32 i = 0; i < SPAN_TABLE_SIZE; ++i)
+	{
+		const PtrSize spanBase = m_spans[i].load();
+		if(spanBase)
+		{
+			invalidateMemory(reinterpret_cast<void*>(spanBase), SPAN_SIZE);
+			m_allocCb(m_allocCbUserData, reinterpret_cast<void*>(spanBase), 0, 0);
+		}
+	}
+
+	m_allocCb(m_allocCbUserData, m_spans, 0, 0);
+
+	if(m_threadCaches)
+	{
+		m_allocCb(m_allocCbUserData, m_threadCaches, 0, 0);
+		m_allocCb(m_allocCbUserData, m_threadCacheOwners, 0, 0);
+	}
+}
+
+void ThreadCachingMemoryPool::create(AllocAlignedCallback allocCb, void* allocCbUserData, U32 maxThreadCount)
+{
+	ANKI_ASSERT(!isCreated());
+	ANKI_ASSERT(allocCb != nullptr);
+
+	m_allocCb = allocCb;
+	m_allocCbUserData = allocCbUserData;
+	m_threadCacheCount = maxThreadCount;
+	m_uuid = g_poolUuid.fetchAdd(1);
+
+	m_spans = static_cast<Atomic<PtrSize>*>(
+		m_allocCb(m_allocCbUserData, nullptr, sizeof(Atomic<PtrSize>) * SPAN_TABLE_SIZE, alignof(Atomic<PtrSize>)));
+	if(m_spans == nullptr)
+	{
+		ANKI_CREATION_OOM_ACTION();
+		return;
+	}
+
+	for(U32 i = 0; i < SPAN_TABLE_SIZE; ++i)
+	{
+		::new(&m_spans[i]) Atomic<PtrSize>(0);
+	}
+
+	if(m_threadCacheCount > 0)
+	{
+		m_threadCaches = static_cast<ThreadCache*>(
+			m_allocCb(m_allocCbUserData, nullptr, sizeof(ThreadCache) * m_threadCacheCount, alignof(ThreadCache)));
+		m_threadCacheOwners = static_cast<Atomic<ThreadId>*>(m_allocCb(
+			m_allocCbUserData, nullptr, sizeof(Atomic<ThreadId>) * m_threadCacheCount, alignof(Atomic<ThreadId>)));
+		if(m_threadCaches == nullptr || m_threadCacheOwners == nullptr)
+		{
+			ANKI_CREATION_OOM_ACTION();
+			return;
+		}
+
+		for(U32 i = 0; i < m_threadCacheCount; ++i)
+		{
+			::new(&m_threadCaches[i]) ThreadCache();
+			::new(&m_threadCacheOwners[i]) Atomic<ThreadId>(0);
+		}
+	}
+}
+
+U32 ThreadCachingMemoryPool::computeSizeClass(PtrSize size)
+{
+	ANKI_ASSERT(size <= MAX_SMALL_SIZE);
+	size = max<PtrSize>(size, 1);
+
+	U32 sizeClass;
+	if(size <= 128)
+	{
+		sizeClass = U32((size + 15) / 16 - 1);
+	}
+	else if(size <= 256)
+	{
+		sizeClass = U32(8 + (size - 128 + 31) / 32 - 1);
+	}
+	else if(size <= 512)
+	{
+		sizeClass = U32(12 + (size - 256 + 63) / 64 - 1);
+	}
+	else
+	{
+		sizeClass = U32(16 + (size - 512 + 127) / 128 - 1);
+	}
+
+	ANKI_ASSERT(sizeClass < SIZE_CLASS_COUNT);
+	ANKI_ASSERT(size <= getSizeClassSize(sizeClass));
+	ANKI_ASSERT(sizeClass == 0 || size > getSizeClassSize(sizeClass - 1));
+	return sizeClass;
+}
+
+PtrSize ThreadCachingMemoryPool::getSizeClassSize(U32 sizeClass)
+{
+	return THREAD_CACHING_SIZE_CLASSES[sizeClass];
+}
+
+U32 ThreadCachingMemoryPool::computeBatchSize(U32 sizeClass)
+{
+	return clamp<U32>(U32(4096 / getSizeClassSize(sizeClass)), 4, 64);
+}
+
+ThreadCachingMemoryPool::ThreadCache* ThreadCachingMemoryPool::getThreadCache()
+{
+	if(m_threadCacheCount == 0)
+	{
+		return nullptr;
+	}
+
+	const U32 slot = getThreadSlot(m_uuid, m_threadCacheOwners, m_threadCacheCount);
+	return (slot != MAX_U32) ? &m_threadCaches[slot] : nullptr;
+}
+
+void* ThreadCachingMemoryPool::allocate(PtrSize size, PtrSize alignment)
+{
+	ANKI_ASSERT(isCreated());
+
+	if(size <= MAX_SMALL_SIZE && alignment <= SMALL_ALIGNMENT)
+	{
+		const U32 sizeClass = computeSizeClass(size);
+		FreeObject* obj = nullptr;
+
+		ThreadCache* cache = getThreadCache();
+		if(cache)
+		{
+			obj = cache->m_heads[sizeClass];
+			if(ANKI_UNLIKELY(obj == nullptr))
+			{
+				cache->m_counts[sizeClass] = fetchFromCentralList(sizeClass, computeBatchSize(sizeClass), obj);
+			}
+
+			if(obj)
+			{
+				cache->m_heads[sizeClass] = obj->m_next;
+				--cache->m_counts[sizeClass];
+				cache->m_allocationsCount.store(cache->m_allocationsCount.load() + 1);
+				return obj;
+			}
+		}
+		else if(fetchFromCentralList(sizeClass, 1, obj))
+		{
+			m_allocationsCount.fetchAdd(1);
+			return obj;
+		}
+
+		// Out of spans, fallback to the allocation callback
+	}
+
+	void* mem = m_allocCb(m_allocCbUserData, nullptr, size, alignment);
+	if(mem != nullptr)
+	{
+		m_allocationsCount.fetchAdd(1);
+	}
+	else
+	{
+		ANKI_OOM_ACTION();
+	}
+
+	return mem;
+}
+
+void ThreadCachingMemoryPool::free(void* ptr)
+{
+	ANKI_ASSERT(isCreated());
+	ANKI_ASSERT(ptr);
+
+	if(!isInSpan(ptr))
+	{
+		m_allocationsCount.fetchSub(1);
+		m_allocCb(m_allocCbUserData, ptr, 0, 0);
+		return;
+	}
+
+	const PtrSize spanBase = PtrSize(ptr) & ~(SPAN_SIZE - 1);
+	const SpanHeader& header = *reinterpret_cast<const SpanHeader*>(spanBase);
+	ANKI_ASSERT(header.m_pool == this && "Freeing memory of another pool");
+	const U32 sizeClass = header.m_sizeClass;
+	ANKI_ASSERT((PtrSize(ptr) - spanBase - SPAN_HEADER_SIZE) % getSizeClassSize(sizeClass) == 0);
+
+	FreeObject* obj = static_cast<FreeObject*>(ptr);
+	ThreadCache* cache = getThreadCache();
+	if(cache)
+	{
+		obj->m_next = cache->m_heads[sizeClass];
+		cache->m_heads[sizeClass] = obj;
+		++cache->m_counts[sizeClass];
+		cache->m_allocationsCount.store(cache->m_allocationsCount.load() - 1);
+
+		// Give a batch back if the thread holds too many
+		const U32 batchSize = computeBatchSize(sizeClass);
+		if(ANKI_UNLIKELY(cache->m_counts[sizeClass] > batchSize * 2))
+		{
+			FreeObject* head = cache->m_heads[sizeClass];
+			FreeObject* tail = head;
+			for(U32 i = 1; i < batchSize; ++i)
+			{
+				tail = tail->m_next;
+			}
+
+			cache->m_heads[sizeClass] = tail->m_next;
+			cache->m_counts[sizeClass] -= batchSize;
+			releaseToCentralList(sizeClass, head, tail, batchSize);
+		}
+	}
+	else
+	{
+		releaseToCentralList(sizeClass, obj, obj, 1);
+		m_allocationsCount.fetchSub(1);
+	}
+}
+
+U32 ThreadCachingMemoryPool::getAllocationsCount() const
+{
+	I64 count = I32(m_allocationsCount.load());
+	for(U32 i = 0; i < m_threadCacheCount; ++i)
+	{
+		count += m_threadCaches[i].m_allocationsCount.load();
+	}
+
+	ANKI_ASSERT(count >= 0);
+	return U32(count);
+}
+
+U32 ThreadCachingMemoryPool::fetchFromCentralList(U32 sizeClass, U32 count, FreeObject*& head)
+{
+	ANKI_ASSERT(count > 0);
+	CentralFreeList& list = m_centralLists[sizeClass];
+
+	{
+		LockGuard<SpinLock> lock(list.m_lock);
+		if(list.m_count > 0)
+		{
+			const U32 outCount = min(count, list.m_count);
+			head = list.m_head;
+			FreeObject* tail = head;
+			for(U32 i = 1; i < outCount; ++i)
+			{
+				tail = tail->m_next;
+			}
+
+			list.m_head = tail->m_next;
+			list.m_count -= outCount;
+			tail->m_next = nullptr;
+			return outCount;
+		}
+	}
+
+	// The list is empty. Create a span without holding the lock, keep what was asked and give the rest to the list
+	FreeObject* spanTail;
+	const U32 spanObjectCount = createSpan(sizeClass, head, spanTail);
+	if(spanObjectCount == 0)
+	{
+		head = nullptr;
+		return 0;
+	}
+
+	const U32 outCount = min(count, spanObjectCount);
+	FreeObject* tail = head;
+	for(U32 i = 1; i < outCount; ++i)
+	{
+		tail = tail->m_next;
+	}
+
+	if(outCount < spanObjectCount)
+	{
+		releaseToCentralList(sizeClass, tail->m_next, spanTail, spanObjectCount - outCount);
+	}
+
+	tail->m_next = nullptr;
+	return outCount;
+}
+
+void ThreadCachingMemoryPool::releaseToCentralList(U32 sizeClass, FreeObject* head, FreeObject* tail, U32 count)
+{
+	ANKI_ASSERT(head && tail && count > 0);
+	CentralFreeList& list = m_centralLists[sizeClass];
+
+	LockGuard<SpinLock> lock(list.m_lock);
+	tail->m_next = list.m_head;
+	list.m_head = head;
+	list.m_count += count;
+}
+
+U32 ThreadCachingMemoryPool::createSpan(U32 sizeClass, FreeObject*& head, FreeObject*& tail)
+{
+	if(m_spanCount.fetchAdd(1) >= MAX_SPANS)
+	{
+		m_spanCount.fetchSub(1);
+		return 0;
+	}
+
+	U8* mem = static_cast<U8*>(m_allocCb(m_allocCbUserData, nullptr, SPAN_SIZE, SPAN_SIZE));
+	if(mem == nullptr)
+	{
+		m_spanCount.fetchSub(1);
+		return 0;
+	}
+
+	ANKI_ASSERT(isAligned(SPAN_SIZE, mem));
+	invalidateMemory(mem, SPAN_SIZE);
+
+	static_assert(sizeof(SpanHeader) <= SPAN_HEADER_SIZE, "See file");
+	SpanHeader& header = *reinterpret_cast<SpanHeader*>(mem);
+	header.m_pool = this;
+	header.m_sizeClass = sizeClass;
+
+	// Link the objects in address order
+	const PtrSize objectSize = getSizeClassSize(sizeClass);
+	const U32 objectCount = U32((SPAN_SIZE - SPAN_HEADER_SIZE) / objectSize);
+	head = reinterpret_cast<FreeObject*>(mem + SPAN_HEADER_SIZE);
+	for(U32 i = 0; i < objectCount - 1; ++i)
+	{
+		reinterpret_cast<FreeObject*>(mem + SPAN_HEADER_SIZE + i * objectSize)->m_next =
+			reinterpret_cast<FreeObject*>(mem + SPAN_HEADER_SIZE + (i + 1) * objectSize);
+	}
+
+	tail = reinterpret_cast<FreeObject*>(mem + SPAN_HEADER_SIZE + (objectCount - 1) * objectSize);
+	tail->m_next = nullptr;
+
+	// Publish the span
+	const PtrSize spanBase = PtrSize(mem);
+	U32 idx = hashSpanAddress(spanBase, SPAN_TABLE_SIZE);
+	while(true)
+	{
+		PtrSize expected = 0;
+		if(m_spans[idx].compareExchange(expected, spanBase))
+		{
+			break;
+		}
+
+		// Probe the next slot if it's taken. On spurious failure try the same one again
+		if(expected != 0)
+		{
+			idx = (idx + 1) & (SPAN_TABLE_SIZE - 1);
+		}
+	}
+
+	return objectCount;
+}
+
+Bool ThreadCachingMemoryPool::isInSpan(const void* ptr) const
+{
+	const PtrSize spanBase = PtrSize(ptr) & ~(SPAN_SIZE - 1);
+	U32 idx = hashSpanAddress(spanBase, SPAN_TABLE_SIZE);
+	for(U32 i = 0; i < SPAN_TABLE_SIZE; ++i)
+	{
+		const PtrSize crnt = m_spans[idx].load();
+		if(crnt == spanBase)
+		{
+			return true;
+		}
+		else if(crnt == 0)
+		{
+			return false;
+		}
+
+		idx = (idx + 1) & (SPAN_TABLE_SIZE - 1);
+	}
+
+	return false;
+}
+
 } // end namespace anki
@@ -49,7 +49,7 @@ using AllocationSignature = U32;
 ///         returns nullptr
 void* allocAligned(void* userData, void* ptr, PtrSize size, PtrSize alignment);
 
-/// Generic memory pool. The base of HeapMemoryPool or StackMemoryPool or ChainMemoryPool.
+/// Generic memory pool. The base of HeapMemoryPool or StackMemoryPool or ChainMemoryPool or ThreadCachingMemoryPool.
 class BaseMemoryPool : public NonCopyable
 {
 public:
@@ -59,7 +59,8 @@ public:
 		NONE,
 		HEAP,
 		STACK,
-		CHAIN
+		CHAIN,
+		THREAD_CACHING
 	};
 
 	BaseMemoryPool(Type type)
@@ -104,10 +105,7 @@ public:
 	}
 
 	/// Return number of allocations
-	U32 getAllocationsCount() const
-	{
-		return m_allocationsCount.load();
-	}
+	U32 getAllocationsCount() const;
 
 protected:
 	/// User allocation function.
@@ -162,7 +160,11 @@ private:
 };
 
 /// Thread safe memory pool. It's a preallocated memory pool that is used for memory allocations on top of that
-/// preallocated memory. It is mainly used by fast stack allocators
+/// preallocated memory. It is mainly used by fast stack allocators.
+///
+/// The chunks are organized in arenas. By default there is a single arena and all threads bump the same atomic
+/// pointer. In per-thread mode every thread gets its own arena so the threads don't share cache lines. The arenas are
+/// reset together.
 class StackMemoryPool : public BaseMemoryPool
 {
 public:
@@ -184,13 +186,16 @@ public:
 	/// @param ignoreDeallocationErrors Method free() may fail if the ptr is not in the top of the stack. Set that to
 	///        true to suppress such errors
 	/// @param alignmentBytes The maximum supported alignment for returned memory
+	/// @param maxThreadCount If it's not zero the pool is in per-thread mode. The first maxThreadCount threads that
+	///        allocate get their own arena and the rest share one. The allocations are not counted in that mode.
 	void create(AllocAlignedCallback allocCb,
 		void* allocCbUserData,
 		PtrSize initialChunkSize,
 		F32 nextChunkScale = 2.0,
 		PtrSize nextChunkBias = 0,
 		Bool ignoreDeallocationErrors = true,
-		PtrSize alignmentBytes = ANKI_SAFE_ALIGNMENT);
+		PtrSize alignmentBytes = ANKI_SAFE_ALIGNMENT,
+		U32 maxThreadCount = 0);
 
 	/// Allocate aligned memory. The operation is thread safe
 	/// @param size The size to allocate
@@ -208,6 +213,15 @@ public:
 	/// Get the current capacity of the pool. It's not thread safe.
 	PtrSize getMemoryCapacity() const;
 
+	/// Get the number of arenas. Arena 0 is the shared one and the rest belong to threads.
+	U32 getArenaCount() const
+	{
+		return m_threadArenaCount + 1;
+	}
+
+	/// Get the max memory an arena used between two reset() calls. Use it to tune the initialChunkSize.
+	PtrSize getArenaHighWaterMark(U32 arenaIdx) const;
+
 private:
 	/// The memory chunk.
 	class Chunk
@@ -239,6 +253,29 @@ private:
 		}
 	};
 
+	/// The max number of chunks.
+	static const U MAX_CHUNKS = 256;
+
+	/// The alignment of the arenas. It's the size of a cache line to avoid false sharing.
+	static const PtrSize ARENA_ALIGNMENT = 64;
+
+	/// A number of chunks that are used one after the other.
+	class alignas(ARENA_ALIGNMENT) Arena
+	{
+	public:
+		/// The chunks.
+		Array<Chunk, MAX_CHUNKS> m_chunks;
+
+		/// The current chunk. Chose the more strict memory order to avoid compiler re-ordering of instructions
+		Atomic<U32, AtomicMemoryOrder::SEQ_CST> m_crntChunkIdx = {0};
+
+		/// Protect the m_crntChunkIdx.
+		Mutex m_lock;
+
+		/// The max memory used between two resets.
+		PtrSize m_highWaterMark = 0;
+	};
+
 	/// Alignment of allocations
 	PtrSize m_alignmentBytes = 0;
 
@@ -254,18 +291,26 @@ private:
 	/// Ignore deallocation errors.
 	Bool8 m_ignoreDeallocationErrors = false;
 
-	/// The current chunk. Chose the more strict memory order to avoid compiler
-	/// re-ordering of instructions
-	Atomic<U32, AtomicMemoryOrder::SEQ_CST> m_crntChunkIdx = {0};
+	/// The shared arena and then the arenas of the threads.
+	Arena* m_arenas = nullptr;
 
-	/// The max number of chunks.
-	static const U MAX_CHUNKS = 256;
+	/// The threads that own the arenas. Zero if the arena is free.
+	Atomic<ThreadId>* m_arenaOwners = nullptr;
 
-	/// The chunks.
-	Array<Chunk, MAX_CHUNKS> m_chunks;
+	/// The number of arenas of the threads.
+	U32 m_threadArenaCount = 0;
 
-	/// Protect the m_crntChunkIdx.
-	Mutex m_lock;
+	/// A unique number that identifies the pool in the thread local cache of getArena().
+	U32 m_uuid = 0;
+
+	/// Get the arena of the current thread.
+	Arena& getArena();
+
+	/// Allocate the first chunk of an arena.
+	Bool initArena(Arena& arena);
+
+	/// Rewind the chunks of an arena.
+	void resetArena(Arena& arena);
 };
 
 /// Chain memory pool. Almost similar to StackMemoryPool but more flexible and at the same time a bit slower.
@@ -370,6 +415,139 @@ private:
 	/// Destroy a chunk.
 	void destroyChunk(Chunk* ch);
 };
+
+/// Thread safe memory pool for many small allocations. It's a drop-in replacement of HeapMemoryPool.
+///
+/// The small allocations are rounded up to a number of size classes. Every class has a central free list of objects
+/// that are carved from big spans. Every thread has its own cache of free objects per class so most allocations and
+/// deallocations don't lock or touch shared cache lines. The objects move between the thread caches and the central
+/// lists in batches. The big allocations and the ones with big alignment go to the allocation callback. The memory of
+/// the spans is released when the pool is destroyed.
+class ThreadCachingMemoryPool : public BaseMemoryPool
+{
+public:
+	/// The max size of small allocations.
+	static const PtrSize MAX_SMALL_SIZE = 1024;
+
+	/// The alignment of the small allocations.
+	static const PtrSize SMALL_ALIGNMENT = 16;
+
+	/// The number of size classes.
+	static const U32 SIZE_CLASS_COUNT = 20;
+
+	/// Default constructor.
+	ThreadCachingMemoryPool();
+
+	/// Destroy
+	~ThreadCachingMemoryPool() final;
+
+	/// The real constructor.
+	/// @param allocCb The allocation function callback
+	/// @param allocCbUserData The user data to pass to the allocation function
+	/// @param maxThreadCount The first maxThreadCount threads that allocate get their own cache. The rest use the
+	///        central free lists directly.
+	void create(AllocAlignedCallback allocCb, void* allocCbUserData, U32 maxThreadCount = 64);
+
+	/// Allocate memory. This operation is thread safe
+	void* allocate(PtrSize size, PtrSize alignment);
+
+	/// Free memory. This operation is thread safe
+	/// @param[in, out] ptr Memory block to deallocate.
+	void free(void* ptr);
+
+	/// Return number of allocations. It's accurate if no other thread allocates or frees at the same time.
+	U32 getAllocationsCount() const;
+
+	/// Get the size class of an allocation size.
+	static U32 computeSizeClass(PtrSize size);
+
+	/// Get the size of the objects of a size class.
+	static PtrSize getSizeClassSize(U32 sizeClass);
+
+private:
+	/// The size of a span. The spans are aligned to that so it's easy to find the span of an object.
+	static const PtrSize SPAN_SIZE = 64 * 1024;
+
+	/// The size of the span's header. The objects come after it.
+	static const PtrSize SPAN_HEADER_SIZE = 64;
+
+	/// The max number of spans. The small allocations go to the allocation callback after that.
+	static const U32 MAX_SPANS = 4 * 1024;
+
+	/// The size of the hash set of the spans. Keep it sparse for short probe sequences.
+	static const U32 SPAN_TABLE_SIZE = MAX_SPANS * 2;
+
+	/// A free object. It's stored in the object's memory.
+	class FreeObject
+	{
+	public:
+		FreeObject* m_next;
+	};
+
+	/// The header of a span.
+	class SpanHeader
+	{
+	public:
+		ThreadCachingMemoryPool* m_pool;
+		U32 m_sizeClass;
+	};
+
+	/// The central free list of a size class.
+	class alignas(64) CentralFreeList
+	{
+	public:
+		FreeObject* m_head = nullptr;
+		U32 m_count = 0;
+		SpinLock m_lock;
+	};
+
+	/// The free objects of a thread.
+	class alignas(64) ThreadCache
+	{
+	public:
+		Array<FreeObject*, SIZE_CLASS_COUNT> m_heads = {};
+		Array<U32, SIZE_CLASS_COUNT> m_counts = {};
+
+		/// Allocations minus deallocations of the thread. Only the owner writes it.
+		Atomic<I32> m_allocationsCount = {0};
+	};
+
+	Array<CentralFreeList, SIZE_CLASS_COUNT> m_centralLists;
+
+	ThreadCache* m_threadCaches = nullptr;
+
+	/// The threads that own the caches. Zero if the cache is free.
+	Atomic<ThreadId>* m_threadCacheOwners = nullptr;
+
+	U32 m_threadCacheCount = 0;
+
+	/// A unique number that identifies the pool in the thread local cache of getThreadCache().
+	U32 m_uuid = 0;
+
+	/// An insert only hash set with the base addresses of the spans. Used to tell apart the small allocations.
+	Atomic<PtrSize>* m_spans = nullptr;
+
+	Atomic<U32> m_spanCount = {0};
+
+	/// Get the cache of the current thread or nullptr if there are no free caches.
+	ThreadCache* getThreadCache();
+
+	/// Take a number of objects from the central free list. Creates a new span if the list is empty.
+	/// @return The number of objects. Zero on failure.
+	U32 fetchFromCentralList(U32 sizeClass, U32 count, FreeObject*& head);
+
+	/// Return a linked list of objects to the central free list.
+	void releaseToCentralList(U32 sizeClass, FreeObject* head, FreeObject* tail, U32 count);
+
+	/// Create a new span and return the linked list of its objects.
+	U32 createSpan(U32 sizeClass, FreeObject*& head, FreeObject*& tail);
+
+	/// Find if the memory is part of a span.
+	Bool isInSpan(const void* ptr) const;
+
+	/// The number of objects that move between a thread cache and a central list at once.
+	static U32 computeBatchSize(U32 sizeClass);
+};
 /// @}
 
 } // end namespace anki
@@ -0,0 +1,103 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/util/ParallelFor.h>
+#include <anki/util/Functions.h>
+
+namespace anki
+{
+
+/// When the grain size is not given split the range to that many chunks per thread.
+const PtrSize AUTO_GRAIN_CHUNKS_PER_THREAD = 8;
+
+ParallelForJob::ParallelForJob(
+	PtrSize begin, PtrSize end, PtrSize grainSize, ParallelForCallback callback, void* userData)
+	: m_callback(callback)
+	, m_userData(userData)
+	, m_end(end)
+	, m_grainSize(grainSize)
+{
+	ANKI_ASSERT(begin <= end && callback);
+	m_crnt.set(begin);
+}
+
+void ParallelForJob::submit(ThreadHive& hive)
+{
+	const PtrSize threadCount = hive.getThreadCount();
+	const PtrSize elementCount = m_end - m_crnt.get();
+	ANKI_ASSERT(elementCount > 0);
+
+	if(m_grainSize == 0)
+	{
+		m_grainSize = max<PtrSize>(1, elementCount / (threadCount * AUTO_GRAIN_CHUNKS_PER_THREAD));
+	}
+
+	// Don't wake more threads than there are chunks
+	const U32 taskCount = U32(min<PtrSize>(threadCount, (elementCount + m_grainSize - 1) / m_grainSize));
+	m_chunkDivisor = taskCount * 2;
+	m_activeTaskCount.set(taskCount);
+
+	Array<ThreadHiveTask, ThreadHive::MAX_THREADS> tasks;
+	for(U i = 0; i < taskCount; ++i)
+	{
+		tasks[i].m_callback = taskCallback;
+		tasks[i].m_argument = this;
+	}
+
+	hive.submitTasks(&tasks[0], taskCount);
+}
+
+Bool ParallelForJob::fetchChunk(PtrSize& begin, PtrSize& end)
+{
+	PtrSize crnt = m_crnt.load();
+	PtrSize size;
+	do
+	{
+		if(crnt >= m_end)
+		{
+			return false;
+		}
+
+		const PtrSize remaining = m_end - crnt;
+		size = min(max(m_grainSize, remaining / m_chunkDivisor), remaining);
+	} while(!m_crnt.compareExchange(crnt, crnt + size));
+
+	begin = crnt;
+	end = crnt + size;
+	return true;
+}
+
+void ParallelForJob::taskCallback(void* arg, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem)
+{
+	ParallelForJob& self = *static_cast<ParallelForJob*>(arg);
+
+	PtrSize begin, end;
+	while(self.fetchChunk(begin, end))
+	{
+		const Error err = self.m_callback(self.m_userData, begin, end, threadId);
+		if(ANKI_UNLIKELY(err))
+		{
+			// Keep the first error and skip the rest of the work
+			if(self.m_err)
+			{
+				I32 expected = Error::NONE;
+				while(expected == Error::NONE && !self.m_err->compareExchange(expected, err._getCode()))
+				{
+				}
+			}
+
+			self.m_crnt.store(self.m_end);
+			break;
+		}
+	}
+
+	// The last task to finish sees the writes of all the others
+	if(self.m_activeTaskCount.fetchSub(1, AtomicMemoryOrder::ACQ_REL) == 1 && self.m_completionCallback)
+	{
+		self.m_completionCallback(self.m_completionUserData, threadId, hive);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,108 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/ThreadHive.h>
+#include <type_traits>
+
+namespace anki
+{
+
+/// @addtogroup util_thread
+/// @{
+
+/// The callback of a ParallelForJob. It processes the elements in [begin, end).
+/// @memberof ParallelForJob
+using ParallelForCallback = Error (*)(void* userData, PtrSize begin, PtrSize end, U32 threadId);
+
+/// A range of work that is processed by the threads of a ThreadHive. The range is split into chunks that start big and
+/// become smaller as the range is consumed (guided scheduling). That way the tail of the work is balanced across the
+/// threads without the caller having to pick the perfect chunk size.
+class ParallelForJob : public NonCopyable
+{
+public:
+	/// Called by the last thread that finished working on the job.
+	using CompletionCallback = void (*)(void* userData, U32 threadId, ThreadHive& hive);
+
+	/// @param begin The start of the range.
+	/// @param end The end of the range.
+	/// @param grainSize The minimum number of elements of a chunk. If zero it will be computed from the range size
+	///                  and the thread count.
+	/// @param callback The callback that will process a chunk.
+	/// @param userData The user data to pass to the callback.
+	ParallelForJob(PtrSize begin, PtrSize end, PtrSize grainSize, ParallelForCallback callback, void* userData);
+
+	/// Set a callback that will be called when all the range is processed.
+	void setCompletionCallback(CompletionCallback callback, void* userData)
+	{
+		m_completionCallback = callback;
+		m_completionUserData = userData;
+	}
+
+	/// Set where to write the first error that the callbacks returned.
+	void setErrorOutput(Atomic<I32>* err)
+	{
+		m_err = err;
+	}
+
+	/// Submit the hive tasks that will process the range. The ParallelForJob should outlive the tasks. It can be called
+	/// from inside a ThreadHiveTaskCallback.
+	void submit(ThreadHive& hive);
+
+private:
+	ParallelForCallback m_callback;
+	void* m_userData;
+	CompletionCallback m_completionCallback = nullptr;
+	void* m_completionUserData = nullptr;
+	Atomic<I32>* m_err = nullptr;
+
+	Atomic<PtrSize> m_crnt;
+	PtrSize m_end;
+	PtrSize m_grainSize;
+	PtrSize m_chunkDivisor = 1;
+	Atomic<U32> m_activeTaskCount = {0};
+
+	/// Get the next chunk. It's thread-safe.
+	Bool fetchChunk(PtrSize& begin, PtrSize& end);
+
+	static void taskCallback(void* arg, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem);
+};
+
+/// @memberof ParallelForJob
+template<typename TFunc>
+Error callParallelForFunctor(void* userData, PtrSize begin, PtrSize end, U32 threadId)
+{
+	return (*static_cast<TFunc*>(userData))(begin, end, threadId);
+}
+
+/// Process the range [begin, end) in parallel using the threads of a ThreadHive and wait for all the work to finish.
+/// It calls ThreadHive::waitAllTasks() so it can't be called from inside a ThreadHiveTaskCallback.
+/// @param hive The hive.
+/// @param begin The start of the range.
+/// @param end The end of the range.
+/// @param grainSize The minimum number of elements that will be processed at once. Zero lets the hive decide.
+/// @param func A functor with signature Error(PtrSize begin, PtrSize end, U32 threadId).
+/// @return The first error that one of the func invocations returned.
+template<typename TFunc>
+ANKI_USE_RESULT Error parallelFor(ThreadHive& hive, PtrSize begin, PtrSize end, PtrSize grainSize, TFunc func)
+{
+	ANKI_ASSERT(begin <= end);
+	if(begin == end)
+	{
+		return Error::NONE;
+	}
+
+	Atomic<I32> err = {Error::NONE};
+	ParallelForJob job(begin, end, grainSize, callParallelForFunctor<TFunc>, &func);
+	job.setErrorOutput(&err);
+	job.submit(hive);
+	hive.waitAllTasks();
+
+	return Error(err.get());
+}
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,84 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/StdTypes.h>
+#include <anki/util/Array.h>
+#include <anki/util/Assert.h>
+#include <cstring>
+
+namespace anki
+{
+
+/// @addtogroup util_other
+/// @{
+
+/// Sort elements on a U64 key with a least significant digit radix sort. It does one pass per byte of the key and it
+/// skips the bytes that are the same in all the keys. The sort is stable.
+/// @param[in,out] elements The elements to sort. They should be trivially copyable.
+/// @param count The number of elements.
+/// @param[out] tmpElements Scratch memory of count elements.
+/// @param getKey A functor that returns the U64 key of an element.
+template<typename T, typename TGetKey>
+void radixSort(T* elements, PtrSize count, T* tmpElements, TGetKey getKey)
+{
+	ANKI_ASSERT(elements && tmpElements);
+	const U BYTE_COUNT = sizeof(U64);
+	const U BUCKET_COUNT = 256;
+
+	// Build all the histograms in one go
+	Array2d<PtrSize, BYTE_COUNT, BUCKET_COUNT> histograms;
+	memset(&histograms[0][0], 0, sizeof(histograms));
+	for(PtrSize i = 0; i < count; ++i)
+	{
+		const U64 key = getKey(elements[i]);
+		for(U b = 0; b < BYTE_COUNT; ++b)
+		{
+			++histograms[b][(key >> (b * 8)) & 0xFF];
+		}
+	}
+
+	T* in = elements;
+	T* out = tmpElements;
+	for(U b = 0; b < BYTE_COUNT; ++b)
+	{
+		Array<PtrSize, BUCKET_COUNT>& histogram = histograms[b];
+
+		// If all the keys have the same byte there is nothing to do
+		const U64 firstByte = (count > 0) ? (getKey(in[0]) >> (b * 8)) & 0xFF : 0;
+		if(histogram[firstByte] == count)
+		{
+			continue;
+		}
+
+		// Histogram to offsets
+		PtrSize offset = 0;
+		for(PtrSize& bucket : histogram)
+		{
+			const PtrSize bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+
+		// Scatter
+		for(PtrSize i = 0; i < count; ++i)
+		{
+			const U64 byte = (getKey(in[i]) >> (b * 8)) & 0xFF;
+			out[histogram[byte]++] = in[i];
+		}
+
+		std::swap(in, out);
+	}
+
+	// Odd number of passes, the result is in the scratch memory
+	if(in != elements)
+	{
+		memcpy(elements, in, sizeof(T) * count);
+	}
+}
+/// @}
+
+} // end namespace anki
@@ -18,12 +18,131 @@ namespace anki
 #	define ANKI_HIVE_DEBUG_PRINT(...) ((void)0)
 #endif
 
+class ThreadHive::Task : public NonCopyable
+{
+public:
+	Task* m_next; ///< Next in the list.
+
+	ThreadHiveTaskCallback m_cb; ///< Callback that defines the task.
+	void* m_arg; ///< Args for the callback.
+
+	ThreadHiveSemaphore* m_waitSemaphore;
+	ThreadHiveSemaphore* m_signalSemaphore;
+
+	/// Check if the dependencies are satisfied.
+	Bool isReady() const
+	{
+		return m_waitSemaphore == nullptr || m_waitSemaphore->m_atomic.load(AtomicMemoryOrder::SEQ_CST) == 0;
+	}
+};
+
+/// Chase-Lev deque with a fixed capacity. Only the owner thread can push and pop from the bottom, all other threads
+/// steal from the top. See "Dynamic Circular Work-Stealing Deque" and "Correct and Efficient Work-Stealing for Weak
+/// Memory Models".
+class ThreadHive::TaskDeque : public NonCopyable
+{
+public:
+	static const U CAPACITY = 1024;
+
+	TaskDeque()
+	{
+		m_top.set(0);
+		m_bottom.set(0);
+	}
+
+	/// Push a task at the bottom. Only the owner can call that.
+	/// @return False if the deque is full.
+	Bool push(Task* task)
+	{
+		const I64 b = m_bottom.load(AtomicMemoryOrder::RELAXED);
+		const I64 t = m_top.load(AtomicMemoryOrder::ACQUIRE);
+		if(b - t >= I64(CAPACITY))
+		{
+			return false;
+		}
+
+		m_tasks[b & (CAPACITY - 1)].store(task, AtomicMemoryOrder::RELAXED);
+
+		// Sequentially consistent to pair with the sleeping threads counter
+		m_bottom.store(b + 1, AtomicMemoryOrder::SEQ_CST);
+		return true;
+	}
+
+	/// Pop a task from the bottom. Only the owner can call that.
+	Task* pop()
+	{
+		const I64 b = m_bottom.load(AtomicMemoryOrder::RELAXED) - 1;
+		m_bottom.store(b, AtomicMemoryOrder::SEQ_CST);
+		I64 t = m_top.load(AtomicMemoryOrder::SEQ_CST);
+
+		Task* task = nullptr;
+		if(t <= b)
+		{
+			task = m_tasks[b & (CAPACITY - 1)].load(AtomicMemoryOrder::RELAXED);
+
+			if(t == b)
+			{
+				// Last element, race with the thieves
+				if(!m_top.compareExchange(t, t + 1, AtomicMemoryOrder::SEQ_CST))
+				{
+					task = nullptr;
+				}
+
+				m_bottom.store(b + 1, AtomicMemoryOrder::RELAXED);
+			}
+		}
+		else
+		{
+			// Empty
+			m_bottom.store(b + 1, AtomicMemoryOrder::RELAXED);
+		}
+
+		return task;
+	}
+
+	/// Steal a task from the top. Any thread can call that.
+	/// @param[out] abort Set to true if the steal failed because of contention.
+	Task* steal(Bool& abort)
+	{
+		abort = false;
+		I64 t = m_top.load(AtomicMemoryOrder::SEQ_CST);
+		const I64 b = m_bottom.load(AtomicMemoryOrder::SEQ_CST);
+
+		Task* task = nullptr;
+		if(t < b)
+		{
+			task = m_tasks[t & (CAPACITY - 1)].load(AtomicMemoryOrder::RELAXED);
+
+			if(!m_top.compareExchange(t, t + 1, AtomicMemoryOrder::SEQ_CST))
+			{
+				task = nullptr;
+				abort = true;
+			}
+		}
+
+		return task;
+	}
+
+	/// Check if it's empty. The result is a hint since other threads might change the deque.
+	Bool isEmpty() const
+	{
+		return m_bottom.load(AtomicMemoryOrder::SEQ_CST) <= m_top.load(AtomicMemoryOrder::SEQ_CST);
+	}
+
+private:
+	// Keep the indices in separate cache lines. The top is touched by the thieves and the bottom by the owner.
+	alignas(64) Atomic<I64> m_top;
+	alignas(64) Atomic<I64> m_bottom;
+	Array<Atomic<Task*>, CAPACITY> m_tasks;
+};
+
 class ThreadHive::Thread
 {
 public:
 	U32 m_id; ///< An ID
 	anki::Thread m_thread; ///< Runs the workingFunc
 	ThreadHive* m_hive;
+	TaskDeque m_deque; ///< Used in work-stealing mode.
 
 	/// Constructor
 	Thread(U32 id, ThreadHive* hive, Bool pinToCores)
@@ -40,32 +159,36 @@ private:
 	static Error threadCallback(anki::ThreadCallbackInfo& info)
 	{
 		Thread& self = *static_cast<Thread*>(info.m_userData);
+		m_currentThread = &self;
 
-		self.m_hive->threadRun(self.m_id);
+		if(self.m_hive->m_workStealing)
+		{
+			self.m_hive->threadRunWorkStealing(self.m_id);
+		}
+		else
+		{
+			self.m_hive->threadRun(self.m_id);
+		}
+
+		m_currentThread = nullptr;
 		return Error::NONE;
 	}
 };
 
-class ThreadHive::Task : public NonCopyable
-{
-public:
-	Task* m_next; ///< Next in the list.
-
-	ThreadHiveTaskCallback m_cb; ///< Callback that defines the task.
-	void* m_arg; ///< Args for the callback.
+thread_local ThreadHive::Thread* ThreadHive::m_currentThread = nullptr;
 
-	ThreadHiveSemaphore* m_waitSemaphore;
-	ThreadHiveSemaphore* m_signalSemaphore;
-};
-
-ThreadHive::ThreadHive(U threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool pinToCores)
+ThreadHive::ThreadHive(U threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool pinToCores, Bool workStealing)
 	: m_slowAlloc(alloc)
 	, m_alloc(alloc.getMemoryPool().getAllocationCallback(),
 		  alloc.getMemoryPool().getAllocationCallbackUserData(),
 		  1024 * 4)
 	, m_threadCount(threadCount)
+	, m_workStealing(workStealing)
 {
-	m_threads = reinterpret_cast<Thread*>(m_slowAlloc.allocate(sizeof(Thread) * threadCount));
+	ANKI_ASSERT(threadCount > 0 && threadCount <= MAX_THREADS);
+
+	PtrSize alignment = alignof(Thread);
+	m_threads = reinterpret_cast<Thread*>(m_slowAlloc.allocate(sizeof(Thread) * threadCount, &alignment));
 	for(U i = 0; i < threadCount; ++i)
 	{
 		::new(&m_threads[i]) Thread(i, this, pinToCores);
@@ -125,25 +248,74 @@ void ThreadHive::submitTasks(ThreadHiveTask* tasks, const U taskCount)
 		prevTask = &outTask;
 	}
 
-	// Push work
+	// Count them before they become visible to the workers
+	m_pendingTasks.fetchAdd(taskCount);
+
+	if(m_workStealing && m_currentThread && m_currentThread->m_hive == this)
+	{
+		// Submitted from a task callback. Push the ready tasks to the local deque and the rest to the shared queue
+		TaskDeque& deque = m_currentThread->m_deque;
+		Task* sharedHead = nullptr;
+		Task* sharedTail = nullptr;
+		U pushedCount = 0;
+
+		for(U i = 0; i < taskCount; ++i)
+		{
+			Task* task = &htasks[i];
+
+			if(task->isReady() && deque.push(task))
+			{
+				++pushedCount;
+				continue;
+			}
+
+			task->m_next = nullptr;
+			if(sharedTail)
+			{
+				sharedTail->m_next = task;
+			}
+			else
+			{
+				sharedHead = task;
+			}
+			sharedTail = task;
+		}
+
+		if(sharedHead)
+		{
+			pushToSharedQueue(sharedHead, sharedTail);
+		}
+		else if(pushedCount > 0)
+		{
+			wakeSleepingThreads();
+		}
+	}
+	else
+	{
+		pushToSharedQueue(&htasks[0], &htasks[taskCount - 1]);
+	}
+}
+
+void ThreadHive::pushToSharedQueue(Task* first, Task* last)
+{
+	ANKI_ASSERT(first && last);
+
 	{
 		LockGuard<Mutex> lock(m_mtx);
 
 		if(m_head != nullptr)
 		{
 			ANKI_ASSERT(m_tail && m_head);
-			m_tail->m_next = &htasks[0];
-			m_tail = &htasks[taskCount - 1];
+			m_tail->m_next = first;
+			m_tail = last;
 		}
 		else
 		{
 			ANKI_ASSERT(m_tail == nullptr);
-			m_head = &htasks[0];
-			m_tail = &htasks[taskCount - 1];
+			m_head = first;
+			m_tail = last;
 		}
 
-		m_pendingTasks += taskCount;
-
 		ANKI_HIVE_DEBUG_PRINT("submit tasks\n");
 	}
 
@@ -151,6 +323,28 @@ void ThreadHive::submitTasks(ThreadHiveTask* tasks, const U taskCount)
 	m_cvar.notifyAll();
 }
 
+void ThreadHive::wakeSleepingThreads()
+{
+	if(m_sleepingThreadCount.load() > 0)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		m_cvar.notifyAll();
+	}
+}
+
+Bool ThreadHive::dequesHaveWork() const
+{
+	for(U i = 0; i < m_threadCount; ++i)
+	{
+		if(!m_threads[i].m_deque.isEmpty())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void ThreadHive::threadRun(U threadId)
 {
 	Task* task = nullptr;
@@ -180,6 +374,108 @@ void ThreadHive::threadRun(U threadId)
 	ANKI_HIVE_DEBUG_PRINT("tid: %lu thread quits!\n", threadId);
 }
 
+void ThreadHive::threadRunWorkStealing(U threadId)
+{
+	Task* task;
+	while((task = waitForWorkStealing(threadId)) != nullptr)
+	{
+		// Run the task
+		ANKI_ASSERT(task->m_cb);
+		ANKI_HIVE_DEBUG_PRINT(
+			"tid: %lu will exec %p (udata: %p)\n", threadId, static_cast<void*>(task), static_cast<void*>(task->m_arg));
+		task->m_cb(task->m_arg, threadId, *this, task->m_signalSemaphore);
+
+#if ANKI_EXTRA_CHECKS
+		task->m_cb = nullptr;
+#endif
+
+		// Signal the semaphore. If a dependency got resolved the tasks that wait on it are in the shared queue
+		Bool wake = false;
+		if(task->m_signalSemaphore)
+		{
+			const U32 out = task->m_signalSemaphore->m_atomic.fetchSub(1, AtomicMemoryOrder::SEQ_CST);
+			ANKI_ASSERT(out > 0u);
+			wake = out == 1;
+		}
+
+		// Complete the task
+		if(m_pendingTasks.fetchSub(1) == 1)
+		{
+			// Out of tasks, wake the waitAllTasks()
+			LockGuard<Mutex> lock(m_mtx);
+			m_cvar.notifyAll();
+		}
+		else if(wake)
+		{
+			wakeSleepingThreads();
+		}
+	}
+
+	ANKI_HIVE_DEBUG_PRINT("tid: %lu thread quits!\n", threadId);
+}
+
+ThreadHive::Task* ThreadHive::waitForWorkStealing(U threadId)
+{
+	TaskDeque& localDeque = m_threads[threadId].m_deque;
+
+	while(true)
+	{
+		// First try the local deque
+		Task* task = localDeque.pop();
+		if(task)
+		{
+			return task;
+		}
+
+		// Then try to steal from the others. Start from the next thread to spread the thieves
+		Bool retry;
+		do
+		{
+			retry = false;
+			for(U i = 1; i < m_threadCount; ++i)
+			{
+				Bool abort;
+				task = m_threads[(threadId + i) % m_threadCount].m_deque.steal(abort);
+				if(task)
+				{
+					ANKI_HIVE_DEBUG_PRINT("tid: %lu stole %p\n", threadId, static_cast<void*>(task));
+					return task;
+				}
+
+				retry = retry || abort;
+			}
+		} while(retry);
+
+		// Last resort is the shared queue
+		LockGuard<Mutex> lock(m_mtx);
+
+		if(m_quit)
+		{
+			return nullptr;
+		}
+
+		// Announce that it's going to sleep before checking for work. The pushes to the deques and the semaphore
+		// signals check the counter after they publish their work so nothing will be missed
+		m_sleepingThreadCount.fetchAdd(1);
+
+		task = getNewTask();
+		if(task == nullptr && !dequesHaveWork())
+		{
+			ANKI_HIVE_DEBUG_PRINT("tid: %lu waiting\n", threadId);
+			m_cvar.wait(m_mtx);
+		}
+
+		m_sleepingThreadCount.fetchSub(1);
+
+		if(task)
+		{
+			return task;
+		}
+	}
+
+	return nullptr;
+}
+
 Bool ThreadHive::waitForWork(U threadId, Task*& task)
 {
 	LockGuard<Mutex> lock(m_mtx);
@@ -189,9 +485,9 @@ Bool ThreadHive::waitForWork(U threadId, Task*& task)
 	// Complete the previous task
 	if(task)
 	{
-		--m_pendingTasks;
+		const U32 pendingTasks = m_pendingTasks.fetchSub(1) - 1;
 
-		if(task->m_signalSemaphore || m_pendingTasks == 0)
+		if(task->m_signalSemaphore || pendingTasks == 0)
 		{
 			// A dependency maybe got resolved or we are out of tasks. Wake them all
 			ANKI_HIVE_DEBUG_PRINT("tid: %lu wake all\n", threadId);
@@ -217,9 +513,7 @@ ThreadHive::Task* ThreadHive::getNewTask()
 	while(task)
 	{
 		// Check if there are dependencies
-		const Bool allDepsCompleted = task->m_waitSemaphore == nullptr || task->m_waitSemaphore->m_atomic.load() == 0;
-
-		if(allDepsCompleted)
+		if(task->isReady())
 		{
 			// Found something, pop it
 			if(prevTask)
@@ -255,7 +549,7 @@ void ThreadHive::waitAllTasks()
 	ANKI_HIVE_DEBUG_PRINT("mt: waiting all\n");
 
 	LockGuard<Mutex> lock(m_mtx);
-	while(m_pendingTasks > 0)
+	while(m_pendingTasks.load() > 0)
 	{
 		m_cvar.wait(m_mtx);
 	}
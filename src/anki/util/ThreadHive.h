@@ -63,13 +63,22 @@ public:
 
 /// A scheduler of small tasks. It takes a number of tasks and schedules them in one of the threads. The tasks can
 /// depend on previously submitted tasks or be completely independent.
+///
+/// It has two modes. The default one keeps all tasks in a single list that is protected by a mutex. The work-stealing
+/// mode gives every thread a lock-free deque. Tasks submitted from inside a ThreadHiveTaskCallback are pushed to the
+/// deque of the calling thread and idle threads steal from the others. Tasks submitted from other threads or tasks
+/// that wait on a semaphore still go through the shared list.
 class ThreadHive : public NonCopyable
 {
 public:
 	static const U MAX_THREADS = 32;
 
 	/// Create the hive.
-	ThreadHive(U threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool pinToCores = false);
+	/// @param threadCount The number of worker threads.
+	/// @param alloc The allocator to use for internal allocations.
+	/// @param pinToCores Pin each thread to a core.
+	/// @param workStealing Use the work-stealing scheduler.
+	ThreadHive(U threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool pinToCores = false, Bool workStealing = false);
 
 	~ThreadHive();
 
@@ -78,6 +87,11 @@ public:
 		return m_threadCount;
 	}
 
+	Bool isWorkStealing() const
+	{
+		return m_workStealing;
+	}
+
 	/// Create a new semaphore with some initial value.
 	/// @param initialValue  Can't be zero.
 	ThreadHiveSemaphore* newSemaphore(const U32 initialValue)
@@ -123,29 +137,50 @@ private:
 	/// Lightweight task.
 	class Task;
 
+	/// Chase-Lev work-stealing deque.
+	class TaskDeque;
+
 	GenericMemoryPoolAllocator<U8> m_slowAlloc;
 	StackAllocator<U8> m_alloc;
 	Thread* m_threads = nullptr;
 	U32 m_threadCount = 0;
+	Bool8 m_workStealing = false;
 
 	Task* m_head = nullptr; ///< Head of the task list.
 	Task* m_tail = nullptr; ///< Tail of the task list.
 	Bool m_quit = false;
-	U32 m_pendingTasks = 0;
+	Atomic<U32, AtomicMemoryOrder::SEQ_CST> m_pendingTasks = {0};
+
+	/// Number of threads that are about to sleep or are sleeping. Used by the work-stealing mode only.
+	Atomic<U32, AtomicMemoryOrder::SEQ_CST> m_sleepingThreadCount = {0};
 
 	Mutex m_mtx;
 	ConditionVariable m_cvar;
 
+	/// The hive thread that runs on the current OS thread. It's nullptr for non-hive threads.
+	static thread_local Thread* m_currentThread;
+
 	void threadRun(U threadId);
 
+	void threadRunWorkStealing(U threadId);
+
 	/// Wait for more tasks.
 	Bool waitForWork(U threadId, Task*& task);
 
+	/// Wait for more tasks. Work-stealing version.
+	Task* waitForWorkStealing(U threadId);
+
 	/// Get new work from the queue.
 	Task* getNewTask();
 
-	/// Complete a task.
-	void completeTask(U taskId);
+	/// Push a list of tasks to the shared queue.
+	void pushToSharedQueue(Task* first, Task* last);
+
+	/// Wake threads that sleep waiting for work.
+	void wakeSleepingThreads();
+
+	/// Check if a deque has tasks that can be stolen.
+	Bool dequesHaveWork() const;
 };
 /// @}
 
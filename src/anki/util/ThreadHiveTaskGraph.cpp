@@ -0,0 +1,111 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/util/ThreadHiveTaskGraph.h>
+
+namespace anki
+{
+
+/// Connects a node with a node that depends on it.
+class ThreadHiveTaskGraph::Edge
+{
+public:
+	ThreadHiveTaskGraphNode* m_dependent;
+	Edge* m_next;
+};
+
+class ThreadHiveTaskGraphNode
+{
+public:
+	ParallelForJob m_job;
+	ThreadHiveTaskGraph::Edge* m_dependents = nullptr;
+	ThreadHiveTaskGraphNode* m_next = nullptr;
+	Atomic<U32> m_unresolvedDependencyCount = {0};
+
+	ThreadHiveTaskGraphNode(PtrSize begin, PtrSize end, PtrSize grainSize, ParallelForCallback callback, void* userData)
+		: m_job(begin, end, grainSize, callback, userData)
+	{
+	}
+};
+
+ThreadHiveTaskGraphNode* ThreadHiveTaskGraph::newNode(
+	PtrSize begin, PtrSize end, PtrSize grainSize, ParallelForCallback callback, void* userData)
+{
+	ANKI_ASSERT(begin < end);
+
+	ThreadHiveTaskGraphNode* node = ::new(m_hive->allocateScratchMemory(
+		sizeof(ThreadHiveTaskGraphNode), alignof(ThreadHiveTaskGraphNode)))
+		ThreadHiveTaskGraphNode(begin, end, grainSize, callback, userData);
+
+	node->m_job.setCompletionCallback(nodeCompleted, node);
+	node->m_job.setErrorOutput(&m_err);
+
+	node->m_next = m_nodes;
+	m_nodes = node;
+	++m_nodeCount;
+
+	return node;
+}
+
+void ThreadHiveTaskGraph::addDependency(ThreadHiveTaskGraphNode* node, ThreadHiveTaskGraphNode* dependency)
+{
+	ANKI_ASSERT(node && dependency && node != dependency);
+
+	Edge* edge = static_cast<Edge*>(m_hive->allocateScratchMemory(sizeof(Edge), alignof(Edge)));
+	edge->m_dependent = node;
+	edge->m_next = dependency->m_dependents;
+	dependency->m_dependents = edge;
+
+	node->m_unresolvedDependencyCount.set(node->m_unresolvedDependencyCount.get() + 1);
+}
+
+void ThreadHiveTaskGraph::nodeCompleted(void* userData, U32 threadId, ThreadHive& hive)
+{
+	ThreadHiveTaskGraphNode& node = *static_cast<ThreadHiveTaskGraphNode*>(userData);
+
+	// Release the dependents. The last dependency to complete will submit the work
+	for(Edge* edge = node.m_dependents; edge; edge = edge->m_next)
+	{
+		ThreadHiveTaskGraphNode& dependent = *edge->m_dependent;
+		if(dependent.m_unresolvedDependencyCount.fetchSub(1, AtomicMemoryOrder::ACQ_REL) == 1)
+		{
+			dependent.m_job.submit(hive);
+		}
+	}
+}
+
+Error ThreadHiveTaskGraph::run()
+{
+	if(m_nodeCount == 0)
+	{
+		return Error::NONE;
+	}
+
+	// Gather the roots first because as soon as a node is submitted it can start submitting other nodes
+	ThreadHiveTaskGraphNode** roots = static_cast<ThreadHiveTaskGraphNode**>(m_hive->allocateScratchMemory(
+		sizeof(ThreadHiveTaskGraphNode*) * m_nodeCount, alignof(ThreadHiveTaskGraphNode*)));
+	U32 rootCount = 0;
+	for(ThreadHiveTaskGraphNode* node = m_nodes; node; node = node->m_next)
+	{
+		if(node->m_unresolvedDependencyCount.get() == 0)
+		{
+			roots[rootCount++] = node;
+		}
+	}
+	ANKI_ASSERT(rootCount > 0 && "The graph has a cycle");
+
+	for(U32 i = 0; i < rootCount; ++i)
+	{
+		roots[i]->m_job.submit(*m_hive);
+	}
+
+	m_hive->waitAllTasks();
+
+	m_nodes = nullptr;
+	m_nodeCount = 0;
+	return Error(m_err.get());
+}
+
+} // end namespace anki
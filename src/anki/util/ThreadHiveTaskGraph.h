@@ -0,0 +1,82 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/ParallelFor.h>
+
+namespace anki
+{
+
+/// @addtogroup util_thread
+/// @{
+
+/// A node of the ThreadHiveTaskGraph. @memberof ThreadHiveTaskGraph
+class ThreadHiveTaskGraphNode;
+
+/// A small graph of tasks and parallel loops that will run on a ThreadHive. Nodes start running when all the nodes
+/// they depend on are done. Independent nodes run concurrently. All memory lives in the hive's scratch memory so the
+/// graph can only run once.
+class ThreadHiveTaskGraph : public NonCopyable
+{
+	friend class ThreadHiveTaskGraphNode;
+
+public:
+	ThreadHiveTaskGraph(ThreadHive& hive)
+		: m_hive(&hive)
+	{
+	}
+
+	~ThreadHiveTaskGraph()
+	{
+		ANKI_ASSERT(m_nodeCount == 0 && "Forgot to run the graph");
+	}
+
+	/// Add a single task.
+	/// @param func A functor with signature Error(U32 threadId).
+	template<typename TFunc>
+	ThreadHiveTaskGraphNode* addTask(TFunc func)
+	{
+		return addParallelFor(0, 1, 1, [func](PtrSize, PtrSize, U32 threadId) mutable -> Error {
+			return func(threadId);
+		});
+	}
+
+	/// Add a parallel loop. See parallelFor().
+	/// @param func A functor with signature Error(PtrSize begin, PtrSize end, U32 threadId).
+	template<typename TFunc>
+	ThreadHiveTaskGraphNode* addParallelFor(PtrSize begin, PtrSize end, PtrSize grainSize, TFunc func)
+	{
+		static_assert(std::is_trivially_destructible<TFunc>::value, "The functor will never be destroyed");
+		TFunc* funcCopy =
+			::new(m_hive->allocateScratchMemory(sizeof(TFunc), alignof(TFunc))) TFunc(std::move(func));
+
+		return newNode(begin, end, grainSize, callParallelForFunctor<TFunc>, funcCopy);
+	}
+
+	/// Make @a node run after @a dependency is done.
+	void addDependency(ThreadHiveTaskGraphNode* node, ThreadHiveTaskGraphNode* dependency);
+
+	/// Run the graph and wait for it to finish. It calls ThreadHive::waitAllTasks() so it can't be called from inside
+	/// a ThreadHiveTaskCallback.
+	/// @return The first error that one of the nodes returned.
+	ANKI_USE_RESULT Error run();
+
+private:
+	class Edge;
+
+	ThreadHive* m_hive;
+	ThreadHiveTaskGraphNode* m_nodes = nullptr; ///< All the nodes in a list.
+	U32 m_nodeCount = 0;
+	Atomic<I32> m_err = {Error::NONE};
+
+	ThreadHiveTaskGraphNode* newNode(
+		PtrSize begin, PtrSize end, PtrSize grainSize, ParallelForCallback callback, void* userData);
+
+	static void nodeCompleted(void* userData, U32 threadId, ThreadHive& hive);
+};
+/// @}
+
+} // end namespace anki
@@ -32,7 +32,7 @@ public:
 		, m_threadpool(threadpool)
 	{
 		ANKI_ASSERT(threadpool);
-		m_thread.start(this, threadCallback, (pinToCore) ? m_id : -1);
+		m_thread.start(this, threadCallback, (pinToCore) ? I(m_id) : -1);
 	}
 
 private:
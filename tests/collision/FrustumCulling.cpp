@@ -0,0 +1,164 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/Collision.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/DynamicArray.h>
+
+namespace anki
+{
+
+/// Random volumes around a frustum in both the packed and the CollisionShape form.
+class FrustumCullingVolumes
+{
+public:
+	DynamicArrayAuto<F32> m_centersX, m_centersY, m_centersZ, m_extentsX, m_extentsY, m_extentsZ, m_radii;
+	DynamicArrayAuto<Aabb> m_aabbs;
+	DynamicArrayAuto<Sphere> m_spheres;
+	BoundingVolumeBatch m_batch;
+
+	FrustumCullingVolumes(HeapAllocator<U8> alloc, U32 count)
+		: m_centersX(alloc)
+		, m_centersY(alloc)
+		, m_centersZ(alloc)
+		, m_extentsX(alloc)
+		, m_extentsY(alloc)
+		, m_extentsZ(alloc)
+		, m_radii(alloc)
+		, m_aabbs(alloc)
+		, m_spheres(alloc)
+	{
+		for(DynamicArrayAuto<F32>* arr :
+			{&m_centersX, &m_centersY, &m_centersZ, &m_extentsX, &m_extentsY, &m_extentsZ, &m_radii})
+		{
+			arr->create(count, 0.0f);
+		}
+		m_aabbs.create(count);
+		m_spheres.create(count);
+
+		for(U32 i = 0; i < count; ++i)
+		{
+			const Vec4 center(randRange(-100.0f, 100.0f), randRange(-100.0f, 100.0f), randRange(-100.0f, 100.0f), 0.0f);
+			m_centersX[i] = center.x();
+			m_centersY[i] = center.y();
+			m_centersZ[i] = center.z();
+
+			// Even are AABBs, odd are spheres
+			if((i & 1) == 0)
+			{
+				const Vec4 extent(randRange(0.1f, 5.0f), randRange(0.1f, 5.0f), randRange(0.1f, 5.0f), 0.0f);
+				m_extentsX[i] = extent.x();
+				m_extentsY[i] = extent.y();
+				m_extentsZ[i] = extent.z();
+				m_aabbs[i] = Aabb(center - extent, center + extent);
+			}
+			else
+			{
+				m_radii[i] = randRange(0.1f, 5.0f);
+				m_spheres[i] = Sphere(center, m_radii[i]);
+			}
+		}
+
+		m_batch.m_centersX = &m_centersX[0];
+		m_batch.m_centersY = &m_centersY[0];
+		m_batch.m_centersZ = &m_centersZ[0];
+		m_batch.m_extentsX = &m_extentsX[0];
+		m_batch.m_extentsY = &m_extentsY[0];
+		m_batch.m_extentsZ = &m_extentsZ[0];
+		m_batch.m_radii = &m_radii[0];
+		m_batch.m_count = count;
+	}
+
+	const CollisionShape& getShape(U32 i) const
+	{
+		return ((i & 1) == 0) ? static_cast<const CollisionShape&>(m_aabbs[i]) : m_spheres[i];
+	}
+};
+
+static PerspectiveFrustum createTestFrustum()
+{
+	PerspectiveFrustum fr(toRad(60.0f), toRad(45.0f), 0.1f, 80.0f);
+	fr.resetTransform(Transform(Vec4(10.0f, 5.0f, -3.0f, 0.0f), Mat3x4(Euler(0.3f, 1.1f, 0.0f)), 1.0f));
+	return fr;
+}
+
+ANKI_TEST(Collision, FrustumCulling)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const PerspectiveFrustum fr = createTestFrustum();
+
+	// A count that is not a multiple of 4 or 64 to test the remainders
+	const U32 COUNT = 1001;
+	FrustumCullingVolumes volumes(alloc, COUNT);
+
+	DynamicArrayAuto<U64> mask(alloc);
+	mask.create((COUNT + 63) / 64, MAX_U64);
+	cullBoundingVolumes(fr.getPlanesWorldSpace(), volumes.m_batch, &mask[0]);
+
+	U32 visibleCount = 0;
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		const Bool visible = (mask[i / 64] & (U64(1) << (i % 64))) != 0;
+		ANKI_TEST_EXPECT_EQ(visible, fr.insideFrustum(volumes.getShape(i)));
+		visibleCount += visible;
+	}
+
+	// Sanity check the test data
+	ANKI_TEST_EXPECT_GT(visibleCount, 0);
+	ANKI_TEST_EXPECT_LT(visibleCount, COUNT);
+
+	// The bits after the count should be clear
+	ANKI_TEST_EXPECT_EQ(mask[COUNT / 64] >> (COUNT % 64), 0);
+}
+
+ANKI_TEST(Collision, FrustumCullingBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const PerspectiveFrustum fr = createTestFrustum();
+
+	const U32 COUNT = 64 * 1024;
+	const U ITERATIONS = 32;
+	FrustumCullingVolumes volumes(alloc, COUNT);
+
+	DynamicArrayAuto<U64> mask(alloc);
+	mask.create(COUNT / 64);
+
+	// Scalar through the CollisionShape interface
+	U32 scalarVisibleCount = 0;
+	Second begin = HighRezTimer::getCurrentTime();
+	for(U it = 0; it < ITERATIONS; ++it)
+	{
+		scalarVisibleCount = 0;
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			scalarVisibleCount += fr.insideFrustum(volumes.getShape(i));
+		}
+	}
+	const Second scalarTime = (HighRezTimer::getCurrentTime() - begin) / ITERATIONS;
+
+	// Batch
+	U32 batchVisibleCount = 0;
+	begin = HighRezTimer::getCurrentTime();
+	for(U it = 0; it < ITERATIONS; ++it)
+	{
+		cullBoundingVolumes(fr.getPlanesWorldSpace(), volumes.m_batch, &mask[0]);
+	}
+	const Second batchTime = (HighRezTimer::getCurrentTime() - begin) / ITERATIONS;
+
+	for(U64 m : mask)
+	{
+		batchVisibleCount += __builtin_popcountll(m);
+	}
+	ANKI_TEST_EXPECT_EQ(batchVisibleCount, scalarVisibleCount);
+
+	ANKI_TEST_LOGI("Culling %u volumes: scalar %.3fms, batch %.3fms (%.2fx)",
+		COUNT,
+		scalarTime * 1000.0,
+		batchTime * 1000.0,
+		scalarTime / batchTime);
+}
+
+} // end namespace anki
@@ -4,9 +4,16 @@
 // http://www.anki3d.org/LICENSE
 
 #include "tests/framework/Framework.h"
+#include <anki/scene/SceneGraph.h>
+#include <anki/core/NativeWindow.h>
+#include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/File.h>
 #include <iostream>
 #include <cstring>
 #include <malloc.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 namespace anki
 {
@@ -285,4 +292,101 @@ ResourceManager* createResourceManager(
 	return resources;
 }
 
+Error writeTextFile(CString filename, CString text)
+{
+	struct stat prevStat;
+	const Bool existed = stat(filename.get(), &prevStat) == 0;
+
+	{
+		File file;
+		ANKI_CHECK(file.open(filename, FileOpenFlag::WRITE));
+		ANKI_CHECK(file.writeText("%s", text.get()));
+	}
+
+	// Writes that are close in time can get the same timestamp. Move it forward so the change is always visible
+	if(existed)
+	{
+		Array<timespec, 2> times;
+		times[0].tv_sec = 0;
+		times[0].tv_nsec = UTIME_OMIT;
+		times[1] = prevStat.st_mtim;
+		times[1].tv_sec += 1;
+		if(utimensat(AT_FDCWD, filename.get(), &times[0], 0) != 0)
+		{
+			ANKI_TEST_LOGE("utimensat() failed: %s", filename.get());
+			return Error::FUNCTION_FAILED;
+		}
+	}
+
+	return Error::NONE;
+}
+
+EngineTestContext::EngineTestContext()
+{
+	initConfig(m_cfg);
+	m_cfg.set("width", 64);
+	m_cfg.set("height", 64);
+}
+
+EngineTestContext::~EngineTestContext()
+{
+	delete m_scene;
+	delete m_hive;
+	delete m_threadpool;
+	delete m_resources;
+	delete m_physics;
+	delete m_fs;
+	GrManager::deleteInstance(m_gr);
+	delete m_win;
+}
+
+void EngineTestContext::initGr()
+{
+	ANKI_ASSERT(!m_gr);
+	m_win = createWindow(m_cfg);
+	m_gr = createGrManager(m_cfg, m_win);
+}
+
+void EngineTestContext::initResources()
+{
+	ANKI_ASSERT(!m_resources);
+	if(!m_gr)
+	{
+		initGr();
+	}
+
+	m_resources = createResourceManager(m_cfg, m_gr, m_physics, m_fs);
+}
+
+void EngineTestContext::initThreads()
+{
+	ANKI_ASSERT(!m_hive);
+	m_threadpool = new ThreadPool(4);
+	m_hive = new ThreadHive(4, HeapAllocator<U8>(allocAligned, nullptr));
+}
+
+void EngineTestContext::initScene()
+{
+	ANKI_ASSERT(!m_scene);
+	if(!m_resources)
+	{
+		initResources();
+	}
+
+	if(!m_hive)
+	{
+		initThreads();
+	}
+
+	m_scene = new SceneGraph();
+	ANKI_TEST_EXPECT_NO_ERR(m_scene->init(
+		allocAligned, nullptr, m_threadpool, m_hive, m_resources, nullptr, nullptr, &m_globalTimestamp, m_cfg));
+}
+
+void EngineTestContext::updateScene()
+{
+	++m_globalTimestamp;
+	ANKI_TEST_EXPECT_NO_ERR(m_scene->update(Second(m_globalTimestamp - 1), Second(m_globalTimestamp)));
+}
+
 } // end namespace anki
@@ -24,6 +24,9 @@ namespace anki
 class TestSuite;
 class Test;
 class Tester;
+class ThreadPool;
+class ThreadHive;
+class SceneGraph;
 
 #define ANKI_TEST_LOGI(...) ANKI_LOG("TEST", NORMAL, __VA_ARGS__)
 #define ANKI_TEST_LOGE(...) ANKI_LOG("TEST", ERROR, __VA_ARGS__)
@@ -228,4 +231,44 @@ GrManager* createGrManager(const Config& cfg, NativeWindow* win);
 ResourceManager* createResourceManager(
 	const Config& cfg, GrManager* gr, PhysicsWorld*& physics, ResourceFilesystem*& resourceFs);
 
+/// Write a text file. If the file exists its modification time moves forward even if it's written again right away.
+/// That way the caches that check the modification time always see the change.
+ANKI_USE_RESULT Error writeTextFile(CString filename, CString text);
+
+/// The engine subsystems that a test needs. It starts with a small window. Change m_cfg and then call the init
+/// functions of the subsystems. The destructor deletes what was created.
+class EngineTestContext
+{
+public:
+	Config m_cfg;
+	NativeWindow* m_win = nullptr;
+	GrManager* m_gr = nullptr;
+	PhysicsWorld* m_physics = nullptr;
+	ResourceFilesystem* m_fs = nullptr;
+	ResourceManager* m_resources = nullptr;
+	ThreadPool* m_threadpool = nullptr;
+	ThreadHive* m_hive = nullptr;
+	SceneGraph* m_scene = nullptr;
+	Timestamp m_globalTimestamp = 1;
+
+	EngineTestContext();
+
+	~EngineTestContext();
+
+	/// Create the window and the GrManager.
+	void initGr();
+
+	/// Create the ResourceManager. It calls initGr() if needed.
+	void initResources();
+
+	/// Create the ThreadPool and the ThreadHive.
+	void initThreads();
+
+	/// Create the SceneGraph. It calls the other init functions if needed.
+	void initScene();
+
+	/// Update the scene for the next frame.
+	void updateScene();
+};
+
 } // end namespace anki
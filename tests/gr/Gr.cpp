@@ -11,6 +11,9 @@
 #include <anki/core/StagingGpuMemoryManager.h>
 #include <anki/resource/TransferGpuAllocator.h>
 #include <ctime>
+#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_NULL
+#	include <anki/gr/null/GrManagerImpl.h>
+#endif
 
 namespace anki
 {
@@ -2171,4 +2174,185 @@ void main()
 	COMMON_END()
 }
 
+ANKI_TEST(Gr, TransferGpuAllocatorStress)
+{
+	COMMON_BEGIN()
+
+	// Many threads allocate pairs of handles like the mesh loading does. They allocate a lot more than the size of
+	// the allocator so the frames wrap many times
+	const U THREAD_COUNT = 4;
+	const U ITERATION_COUNT = 64;
+
+	class Ctx
+	{
+	public:
+		TransferGpuAllocator* m_alloc;
+		FencePtr m_fence;
+		Atomic<U32> m_overlapCount = {0};
+	};
+
+	Ctx ctx;
+	ctx.m_alloc = transfAlloc;
+	{
+		CommandBufferInitInfo cinit;
+		cinit.m_flags = CommandBufferFlag::TRANSFER_WORK | CommandBufferFlag::SMALL_BATCH;
+		CommandBufferPtr cmdb = gr->newCommandBuffer(cinit);
+		cmdb->flush(&ctx.m_fence);
+	}
+
+	Array<Thread*, THREAD_COUNT> threads;
+	for(U t = 0; t < THREAD_COUNT; ++t)
+	{
+		threads[t] = new Thread("TransferStress");
+		threads[t]->start(&ctx, [](ThreadCallbackInfo& info) -> Error {
+			Ctx& ctx = *static_cast<Ctx*>(info.m_userData);
+
+			for(U i = 0; i < ITERATION_COUNT; ++i)
+			{
+				const Array<PtrSize, 2> sizes = {{randRange(4u, 12u) * 1_MB, randRange(1u, 4u) * 1_MB}};
+				Array<TransferGpuAllocatorHandle, 2> handles;
+				ANKI_CHECK(ctx.m_alloc->allocate(sizes, WeakArray<TransferGpuAllocatorHandle>(handles)));
+
+				// Stamp the handles and check that no other thread writes to them
+				const U64 stamp = Thread::getCurrentThreadId() ^ (U64(i) << 48u);
+				for(TransferGpuAllocatorHandle& handle : handles)
+				{
+					U8* mem = static_cast<U8*>(handle.getMappedMemory());
+					memcpy(mem, &stamp, sizeof(stamp));
+					memcpy(mem + handle.getRange() - sizeof(stamp), &stamp, sizeof(stamp));
+				}
+
+				HighRezTimer::sleep(0.1_ms);
+
+				for(TransferGpuAllocatorHandle& handle : handles)
+				{
+					const U8* mem = static_cast<const U8*>(handle.getMappedMemory());
+					if(memcmp(mem, &stamp, sizeof(stamp)) != 0
+						|| memcmp(mem + handle.getRange() - sizeof(stamp), &stamp, sizeof(stamp)) != 0)
+					{
+						ctx.m_overlapCount.fetchAdd(1);
+					}
+
+					ctx.m_alloc->release(handle, ctx.m_fence);
+				}
+			}
+
+			return Error::NONE;
+		});
+	}
+
+	for(U t = 0; t < THREAD_COUNT; ++t)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(threads[t]->join());
+		delete threads[t];
+	}
+
+	ANKI_TEST_EXPECT_EQ(ctx.m_overlapCount.get(), 0);
+
+	COMMON_END()
+}
+
+ANKI_TEST(Gr, TransferGpuAllocatorBatchTooBig)
+{
+	COMMON_BEGIN()
+
+	FencePtr fence;
+	{
+		CommandBufferInitInfo cinit;
+		cinit.m_flags = CommandBufferFlag::TRANSFER_WORK | CommandBufferFlag::SMALL_BATCH;
+		CommandBufferPtr cmdb = gr->newCommandBuffer(cinit);
+		cmdb->flush(&fence);
+	}
+
+	// Fill most of the current frame so the big batch would have to wait for other frames if it was allowed to
+	TransferGpuAllocatorHandle small;
+	ANKI_TEST_EXPECT_NO_ERR(transfAlloc->allocate(16_MB, small));
+
+	// The allocator has 128MB in 3 frames. The batch is bigger than a frame. It fails instead of waiting forever
+	{
+		const Array<PtrSize, 2> sizes = {{40_MB, 40_MB}};
+		Array<TransferGpuAllocatorHandle, 2> handles;
+		ANKI_TEST_EXPECT_ERR(
+			transfAlloc->allocate(sizes, WeakArray<TransferGpuAllocatorHandle>(handles)), Error::OUT_OF_MEMORY);
+	}
+
+	// A single handle bigger than a frame fails the same way
+	{
+		TransferGpuAllocatorHandle handle;
+		ANKI_TEST_EXPECT_ERR(transfAlloc->allocate(100_MB, handle), Error::OUT_OF_MEMORY);
+	}
+
+	// The allocator is not locked and the frames still wrap
+	transfAlloc->release(small, fence);
+	for(U i = 0; i < 8; ++i)
+	{
+		const Array<PtrSize, 2> sizes = {{20_MB, 10_MB}};
+		Array<TransferGpuAllocatorHandle, 2> handles;
+		ANKI_TEST_EXPECT_NO_ERR(transfAlloc->allocate(sizes, WeakArray<TransferGpuAllocatorHandle>(handles)));
+
+		for(TransferGpuAllocatorHandle& handle : handles)
+		{
+			transfAlloc->release(handle, fence);
+		}
+	}
+
+	COMMON_END()
+}
+
+#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_NULL
+ANKI_TEST(Gr, NullBackendCounters)
+{
+	COMMON_BEGIN()
+
+	ShaderProgramPtr prog = createProgram(VERT_SRC, FRAG_SRC, *gr);
+	FramebufferPtr fb = createDefaultFb(*gr);
+
+	const U FRAMES = 4;
+	const U DRAWCALLS = 10;
+	for(U i = 0; i < FRAMES; ++i)
+	{
+		gr->beginFrame();
+
+		CommandBufferInitInfo cinit;
+		cinit.m_flags = CommandBufferFlag::GRAPHICS_WORK;
+		CommandBufferPtr cmdb = gr->newCommandBuffer(cinit);
+		ANKI_TEST_EXPECT_EQ(cmdb->isEmpty(), true);
+
+		cmdb->setViewport(0, 0, WIDTH, HEIGHT);
+		cmdb->bindShaderProgram(prog);
+		cmdb->beginRenderPass(fb, {}, {});
+		for(U j = 0; j < DRAWCALLS; ++j)
+		{
+			cmdb->drawArrays(PrimitiveTopology::TRIANGLES, 3);
+		}
+
+		// The drawcalls of the second level command buffers are added to the primary
+		cinit.m_flags = CommandBufferFlag::SECOND_LEVEL | CommandBufferFlag::GRAPHICS_WORK;
+		cinit.m_framebuffer = fb;
+		CommandBufferPtr cmdb2 = gr->newCommandBuffer(cinit);
+		cmdb2->bindShaderProgram(prog);
+		cmdb2->drawArrays(PrimitiveTopology::TRIANGLES, 3);
+		cmdb2->flush();
+		cmdb->pushSecondLevelCommandBuffer(cmdb2);
+
+		cmdb->endRenderPass();
+
+		FencePtr fence;
+		cmdb->flush(&fence);
+		ANKI_TEST_EXPECT_EQ(fence->clientWait(0.0), true);
+
+		gr->swapBuffers();
+	}
+
+	const NullGrCounters counters = static_cast<GrManagerImpl*>(gr)->getCounters();
+	ANKI_TEST_EXPECT_EQ(counters.m_commandBufferCount, FRAMES);
+	ANKI_TEST_EXPECT_EQ(counters.m_renderPassCount, FRAMES);
+	ANKI_TEST_EXPECT_EQ(counters.m_drawcallCount, FRAMES * (DRAWCALLS + 1));
+	ANKI_TEST_EXPECT_EQ(counters.m_dispatchCount, 0);
+	ANKI_TEST_EXPECT_EQ(gr->getStats().m_commandBufferCount, 0);
+
+	COMMON_END()
+}
+#endif
+
 } // end namespace anki
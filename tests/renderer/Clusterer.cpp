@@ -6,7 +6,7 @@
 #include <tests/framework/Framework.h>
 #include <anki/renderer/Clusterer.h>
 #include <anki/Collision.h>
-#include <anki/util/ThreadPool.h>
+#include <anki/util/ThreadHive.h>
 #include "anki/util/HighRezTimer.h"
 
 namespace anki
@@ -34,7 +34,7 @@ ANKI_TEST(Renderer, Clusterer)
 	Mat4 projMat = fr.calculateProjectionMatrix();
 	Vec4 unprojParams = projMat.extractPerspectiveUnprojectionParams();
 
-	ThreadPool threadpool(4);
+	ThreadHive hive(4, alloc);
 
 	// Gen spheres
 	DynamicArrayAuto<Sphere> spheres(alloc);
@@ -70,8 +70,10 @@ ANKI_TEST(Renderer, Clusterer)
 		pinf.m_viewMat = Mat4(camTrf).getInverse();
 		pinf.m_projMat = projMat;
 		pinf.m_camTrf = camTrf;
+		pinf.m_near = fr.getNear();
+		pinf.m_far = fr.getFar();
 
-		c.prepare(threadpool, pinf);
+		c.prepare(hive, pinf);
 		ClustererTestResult rez;
 		c.initTestResults(alloc, rez);
 
@@ -127,8 +129,10 @@ ANKI_TEST(Renderer, Clusterer)
 		pinf.m_viewMat = Mat4(camTrf).getInverse();
 		pinf.m_projMat = projMat;
 		pinf.m_camTrf = camTrf;
+		pinf.m_near = fr.getNear();
+		pinf.m_far = fr.getFar();
 
-		c.prepare(threadpool, pinf);
+		c.prepare(hive, pinf);
 		ClustererTestResult rez;
 		c.initTestResults(alloc, rez);
 
@@ -147,4 +151,287 @@ ANKI_TEST(Renderer, Clusterer)
 		clusterBinCount / F32(ITERATION_COUNT * FRUSTUM_COUNT));
 }
 
+/// Bin as many lights as a big scene would have in a frame.
+static void binLightsBenchmark(Clusterer& c, HeapAllocator<U8>& alloc, U lightCount)
+{
+	const U ITERATION_COUNT = 8;
+
+	DynamicArrayAuto<Sphere> spheres(alloc);
+	spheres.create(lightCount);
+	DynamicArrayAuto<Aabb> sphereBoxes(alloc);
+	sphereBoxes.create(lightCount);
+	for(U i = 0; i < lightCount; ++i)
+	{
+		const Vec4 center(randRange(-50.0f, 50.0f), randRange(-50.0f, 50.0f), randRange(-200.0f, 0.0f), 0.0f);
+		spheres[i] = Sphere(center, randRange(0.5f, 10.0f));
+		spheres[i].computeAabb(sphereBoxes[i]);
+	}
+
+	ClustererTestResult rez;
+	c.initTestResults(alloc, rez);
+
+	HighRezTimer timer;
+	timer.start();
+	U clusterBinCount = 0;
+	for(U i = 0; i < ITERATION_COUNT; ++i)
+	{
+		for(U s = 0; s < lightCount; ++s)
+		{
+			c.bin(spheres[s], sphereBoxes[s], rez);
+			clusterBinCount += rez.getClusterCount();
+		}
+	}
+	timer.stop();
+	const F64 ms = timer.getElapsedTime() * 1000.0 / F64(ITERATION_COUNT);
+	printf("Binned %u lights in %f ms.\n"
+		   "Avg clusters per light %f\n",
+		unsigned(lightCount),
+		ms,
+		clusterBinCount / F32(ITERATION_COUNT * lightCount));
+}
+
+ANKI_TEST(Renderer, ClustererThroughput)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(4, alloc);
+
+	Clusterer c;
+	c.init(alloc, 32, 26, 32);
+
+	PerspectiveFrustum fr(toRad(70.0), toRad(60.0), 0.1, 500.0);
+	Transform camTrf(Vec4(0.0), Mat3x4::getIdentity(), 1.0);
+
+	ClustererPrepareInfo pinf;
+	pinf.m_viewMat = Mat4(camTrf).getInverse();
+	pinf.m_projMat = fr.calculateProjectionMatrix();
+	pinf.m_camTrf = camTrf;
+	pinf.m_near = fr.getNear();
+	pinf.m_far = fr.getFar();
+	c.prepare(hive, pinf);
+
+	binLightsBenchmark(c, alloc, 1000);
+	binLightsBenchmark(c, alloc, 10000);
+}
+
+/// The clusters of a row that a reference test finds. The shapes that touch a cluster within the tolerance can go
+/// either way.
+class ClusterRowReference
+{
+public:
+	U64 m_mustHave = 0;
+	U64 m_mayHave = 0;
+};
+
+static ClusterRowReference sphereRowReference(const Clusterer& c, const Sphere& sphere, U xBegin, U xEnd, U y, U z)
+{
+	const F32 tolerance = 1.0e-3f * max(1.0f, sphere.getRadius());
+	const Sphere smaller(sphere.getCenter(), max(0.0f, sphere.getRadius() - tolerance));
+	const Sphere bigger(sphere.getCenter(), sphere.getRadius() + tolerance);
+
+	ClusterRowReference ref;
+	for(U x = xBegin; x < xEnd; ++x)
+	{
+		const Aabb box = c.getClusterBox(x, y, z);
+		if(testCollisionShapes(smaller, box))
+		{
+			ref.m_mustHave |= U64(1) << x;
+		}
+
+		if(testCollisionShapes(bigger, box))
+		{
+			ref.m_mayHave |= U64(1) << x;
+		}
+	}
+
+	return ref;
+}
+
+static ClusterRowReference planesRowReference(
+	const Clusterer& c, ConstWeakArray<Plane> planes, U xBegin, U xEnd, U y, U z)
+{
+	const F32 tolerance = 1.0e-3f;
+
+	ClusterRowReference ref;
+	for(U x = xBegin; x < xEnd; ++x)
+	{
+		const Aabb box = c.getClusterBox(x, y, z);
+		Bool insideSmaller = true;
+		Bool insideBigger = true;
+		for(const Plane& plane : planes)
+		{
+			const Plane smaller(plane.getNormal(), plane.getOffset() + tolerance);
+			const Plane bigger(plane.getNormal(), plane.getOffset() - tolerance);
+			insideSmaller = insideSmaller && box.testPlane(smaller) >= 0.0f;
+			insideBigger = insideBigger && box.testPlane(bigger) >= 0.0f;
+		}
+
+		if(insideSmaller)
+		{
+			ref.m_mustHave |= U64(1) << x;
+		}
+
+		if(insideBigger)
+		{
+			ref.m_mayHave |= U64(1) << x;
+		}
+	}
+
+	return ref;
+}
+
+/// Check the result of a row test against the reference.
+static void checkRow(const ClustererTestResult& rez, const ClusterRowReference& ref, U xBegin, U xEnd, U y, U z)
+{
+	U64 found = 0;
+	for(auto it = rez.getClustersBegin(); it != rez.getClustersEnd(); ++it)
+	{
+		ANKI_TEST_EXPECT_EQ(it->y(), y);
+		ANKI_TEST_EXPECT_EQ(it->z(), z);
+		ANKI_TEST_EXPECT_GEQ(it->x(), xBegin);
+		ANKI_TEST_EXPECT_LT(it->x(), xEnd);
+
+		const U64 bit = U64(1) << it->x();
+		ANKI_TEST_EXPECT_EQ(found & bit, 0);
+		found |= bit;
+	}
+
+	ANKI_TEST_EXPECT_EQ(found & ref.m_mustHave, ref.m_mustHave);
+	ANKI_TEST_EXPECT_EQ(found & ~ref.m_mayHave, 0);
+}
+
+ANKI_TEST(Renderer, ClustererSimdRows)
+{
+	// The X count is not a multiple of 4 so the row tests read the padding of the rows and the last row reads the
+	// padding of the whole storage
+	const U CLUSTER_COUNT_X = 30;
+	const U CLUSTER_COUNT_Y = 18;
+	const U CLUSTER_COUNT_Z = 16;
+	const U SHAPE_COUNT = 256;
+	static_assert(CLUSTER_COUNT_X <= 64, "The row masks are U64");
+
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(4, alloc);
+
+	Clusterer c;
+	c.init(alloc, CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+
+	PerspectiveFrustum fr(toRad(70.0), toRad(60.0), 0.1, 100.0);
+	Transform camTrf(Vec4(1.0, 2.0, 3.0, 0.0), Mat3x4::getIdentity(), 1.0);
+
+	ClustererPrepareInfo pinf;
+	pinf.m_viewMat = Mat4(camTrf).getInverse();
+	pinf.m_projMat = fr.calculateProjectionMatrix();
+	pinf.m_viewProjMat = pinf.m_projMat * pinf.m_viewMat;
+	pinf.m_camTrf = camTrf;
+	pinf.m_near = fr.getNear();
+	pinf.m_far = fr.getFar();
+	c.prepare(hive, pinf);
+
+	// Aligned and unaligned starts, tails shorter than 4 and rows that end at the last cluster
+	const Array<UVec2, 9> xRanges = {{UVec2(0, CLUSTER_COUNT_X),
+		UVec2(1, CLUSTER_COUNT_X),
+		UVec2(3, 7),
+		UVec2(5, 6),
+		UVec2(2, 5),
+		UVec2(13, 19),
+		UVec2(CLUSTER_COUNT_X - 3, CLUSTER_COUNT_X),
+		UVec2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_X),
+		UVec2(CLUSTER_COUNT_X - 6, CLUSTER_COUNT_X - 1)}};
+
+	// The first, a middle and the last row
+	const Array<UVec2, 3> rows = {{UVec2(0, 0),
+		UVec2(CLUSTER_COUNT_Y / 2, CLUSTER_COUNT_Z / 3),
+		UVec2(CLUSTER_COUNT_Y - 1, CLUSTER_COUNT_Z - 1)}};
+
+	for(U i = 0; i < SHAPE_COUNT; ++i)
+	{
+		// A sphere in view space close to the clusters of the rows
+		const UVec2 row = rows[i % rows.getSize()];
+		const Aabb rowBox = c.getClusterBox(CLUSTER_COUNT_X / 2, row.x(), row.y());
+		const Vec4 rowCenter = (rowBox.getMin() + rowBox.getMax()) * 0.5f;
+		const F32 rowSize = (rowBox.getMax() - rowBox.getMin()).getLength();
+		const Vec4 center = rowCenter
+							+ Vec4(randRange(-rowSize * F32(CLUSTER_COUNT_X), rowSize * F32(CLUSTER_COUNT_X)),
+								  randRange(-rowSize, rowSize),
+								  randRange(-rowSize, rowSize),
+								  0.0f);
+		const Sphere sphere(center, randRange(0.01f, 2.0f) * rowSize);
+
+		// A frustum in view space
+		const F32 fovX = toRad(randRange(10.0f, 90.0f));
+		const F32 fovY = toRad(randRange(10.0f, 90.0f));
+		PerspectiveFrustum shape(fovX, fovY, 0.01f, rowSize * 4.0f);
+		shape.transform(Transform(center, Mat3x4::getIdentity(), 1.0f));
+		const ConstWeakArray<Plane> planes(&shape.getPlanesWorldSpace()[0], shape.getPlanesWorldSpace().getSize());
+
+		for(const UVec2& range : xRanges)
+		{
+			{
+				ClustererTestResult rez;
+				c.initTestResults(alloc, rez);
+				c.binSphereRow(sphere, range.x(), range.y(), row.x(), row.y(), rez);
+				checkRow(rez,
+					sphereRowReference(c, sphere, range.x(), range.y(), row.x(), row.y()),
+					range.x(),
+					range.y(),
+					row.x(),
+					row.y());
+			}
+
+			{
+				ClustererTestResult rez;
+				c.initTestResults(alloc, rez);
+				c.binPlanesRow(planes, range.x(), range.y(), row.x(), row.y(), rez);
+				checkRow(rez,
+					planesRowReference(c, planes, range.x(), range.y(), row.x(), row.y()),
+					range.x(),
+					range.y(),
+					row.x(),
+					row.y());
+			}
+		}
+	}
+
+	// The whole binning returns only the clusters that the reference finds
+	ClustererTestResult rez;
+	c.initTestResults(alloc, rez);
+	for(U i = 0; i < SHAPE_COUNT; ++i)
+	{
+		const Vec4 center(randRange(-30.0f, 30.0f), randRange(-30.0f, 30.0f), randRange(-100.0f, 0.0f), 0.0f);
+		const Sphere sphere = Sphere(center, randRange(0.1f, 10.0f));
+		Aabb box;
+		sphere.computeAabb(box);
+		c.bin(sphere, box, rez);
+
+		const Sphere vsphere((pinf.m_viewMat * center.xyz1()).xyz0(), sphere.getRadius());
+		for(auto it = rez.getClustersBegin(); it != rez.getClustersEnd(); ++it)
+		{
+			const ClusterRowReference ref = sphereRowReference(c, vsphere, it->x(), it->x() + 1, it->y(), it->z());
+			ANKI_TEST_EXPECT_NEQ(ref.m_mayHave, 0);
+		}
+
+		PerspectiveFrustum shape(toRad(randRange(10.0f, 90.0f)), toRad(randRange(10.0f, 90.0f)), 0.01f, 20.0f);
+		shape.transform(Transform(center, Mat3x4::getIdentity(), 1.0f));
+		shape.computeAabb(box);
+		c.binPerspectiveFrustum(shape, box, rez);
+
+		Array<Plane, 5> vplanes;
+		for(U p = 0; p < vplanes.getSize(); ++p)
+		{
+			vplanes[p] = shape.getPlanesWorldSpace()[p + 1].getTransformed(Transform(pinf.m_viewMat));
+		}
+
+		for(auto it = rez.getClustersBegin(); it != rez.getClustersEnd(); ++it)
+		{
+			const ClusterRowReference ref = planesRowReference(c,
+				ConstWeakArray<Plane>(&vplanes[0], vplanes.getSize()),
+				it->x(),
+				it->x() + 1,
+				it->y(),
+				it->z());
+			ANKI_TEST_EXPECT_NEQ(ref.m_mayHave, 0);
+		}
+	}
+}
+
 } // end namespace anki
@@ -0,0 +1,222 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/renderer/LightBin.h>
+#include <anki/renderer/RenderQueue.h>
+#include <anki/core/StagingGpuMemoryManager.h>
+#include <anki/Collision.h>
+
+namespace anki
+{
+
+class LightBinTestContext : public EngineTestContext
+{
+public:
+	static const U POINT_LIGHT_COUNT = 6;
+	static const U SPOT_LIGHT_COUNT = 4;
+
+	StagingGpuMemoryManager* m_stagingMem = nullptr;
+	LightBin* m_bin = nullptr;
+	HeapAllocator<U8> m_alloc = HeapAllocator<U8>(allocAligned, nullptr);
+
+	PerspectiveFrustum m_frustum = PerspectiveFrustum(toRad(60.0f), toRad(50.0f), 0.1f, 100.0f);
+	Transform m_camTrf = Transform::getIdentity();
+
+	Array<PointLightQueueElement, POINT_LIGHT_COUNT> m_pointLights;
+	Array<SpotLightQueueElement, SPOT_LIGHT_COUNT> m_spotLights;
+	U32 m_pointLightCount = POINT_LIGHT_COUNT;
+
+	LightBinTestContext()
+	{
+		initGr();
+		initThreads();
+
+		m_stagingMem = new StagingGpuMemoryManager();
+		ANKI_TEST_EXPECT_NO_ERR(m_stagingMem->init(m_gr, m_cfg));
+
+		m_bin = new LightBin(m_alloc, 16, 12, 16, m_hive, m_stagingMem, true);
+
+		// Some lights in front of the camera
+		for(U i = 0; i < POINT_LIGHT_COUNT; ++i)
+		{
+			PointLightQueueElement& light = m_pointLights[i];
+			light = PointLightQueueElement();
+			light.m_uuid = i + 1;
+			light.m_worldPosition = Vec3(F32(i) * 2.0f - 5.0f, 0.0f, -10.0f - F32(i));
+			light.m_radius = 3.0f;
+			light.m_diffuseColor = Vec3(1.0f);
+		}
+
+		for(U i = 0; i < SPOT_LIGHT_COUNT; ++i)
+		{
+			SpotLightQueueElement& light = m_spotLights[i];
+			light = SpotLightQueueElement();
+			light.m_uuid = 100 + i;
+			light.m_textureMatrix = Mat4::getIdentity();
+			light.m_distance = 15.0f;
+			light.m_outerAngle = toRad(45.0f);
+			light.m_innerAngle = toRad(30.0f);
+			light.m_diffuseColor = Vec3(1.0f);
+			moveSpotLight(i, Vec3(F32(i) * 3.0f - 4.0f, 2.0f, -5.0f));
+		}
+	}
+
+	~LightBinTestContext()
+	{
+		delete m_bin;
+		delete m_stagingMem;
+	}
+
+	void moveSpotLight(U i, const Vec3& pos)
+	{
+		m_spotLights[i].m_worldTransform = Mat4(Transform(pos.xyz0(), Mat3x4::getIdentity(), 1.0f));
+	}
+
+	/// Bin the lights of a frame.
+	void binFrame()
+	{
+		RenderQueue rqueue;
+		rqueue.m_pointLights = WeakArray<PointLightQueueElement>(&m_pointLights[0], m_pointLightCount);
+		rqueue.m_spotLights = WeakArray<SpotLightQueueElement>(&m_spotLights[0], SPOT_LIGHT_COUNT);
+		rqueue.m_cameraNear = m_frustum.getNear();
+		rqueue.m_cameraFar = m_frustum.getFar();
+
+		const Mat4 viewMat = Mat4(m_camTrf).getInverse();
+		const Mat4 projMat = m_frustum.calculateProjectionMatrix();
+
+		StackAllocator<U8> frameAlloc(allocAligned, nullptr, 1_MB, 1.0);
+		LightBinOut out;
+		ANKI_TEST_EXPECT_NO_ERR(m_bin->bin(
+			viewMat, projMat, projMat * viewMat, Mat4(m_camTrf), rqueue, frameAlloc, 64 * 1024, false, out));
+
+		m_stagingMem->endFrame();
+	}
+
+	U32 getLightCount() const
+	{
+		return m_pointLightCount + SPOT_LIGHT_COUNT;
+	}
+
+	/// Check that the cache has the clusters that binning the lights now would give.
+	void checkCache() const
+	{
+		ClustererTestResult rez;
+		m_bin->getClusterer().initTestResults(m_alloc, rez);
+
+		for(U i = 0; i < m_pointLightCount; ++i)
+		{
+			const PointLightQueueElement& light = m_pointLights[i];
+			Sphere sphere(light.m_worldPosition.xyz0(), light.m_radius);
+			Aabb box;
+			sphere.computeAabb(box);
+			m_bin->getClusterer().bin(sphere, box, rez);
+			checkCachedClusters(light.m_uuid, rez);
+		}
+
+		for(const SpotLightQueueElement& light : m_spotLights)
+		{
+			PerspectiveFrustum shape(light.m_outerAngle, light.m_outerAngle, 0.01f, light.m_distance);
+			shape.transform(Transform(light.m_worldTransform));
+			Aabb box;
+			shape.computeAabb(box);
+			m_bin->getClusterer().binPerspectiveFrustum(shape, box, rez);
+			checkCachedClusters(light.m_uuid, rez);
+		}
+	}
+
+	void checkCachedClusters(U64 uuid, const ClustererTestResult& rez) const
+	{
+		ConstWeakArray<Cluster> clusters;
+		ANKI_TEST_EXPECT_EQ(m_bin->tryGetCachedClusters(uuid, clusters), true);
+		ANKI_TEST_EXPECT_EQ(clusters.getSize(), rez.getClusterCount());
+		ANKI_TEST_EXPECT_GT(clusters.getSize(), 0);
+
+		auto it = rez.getClustersBegin();
+		for(const Cluster& c : clusters)
+		{
+			ANKI_TEST_EXPECT_EQ(c.x(), it->x());
+			ANKI_TEST_EXPECT_EQ(c.y(), it->y());
+			ANKI_TEST_EXPECT_EQ(c.z(), it->z());
+			++it;
+		}
+	}
+};
+
+ANKI_TEST(Renderer, LightBinCache)
+{
+	LightBinTestContext ctx;
+	ConstWeakArray<Cluster> clusters;
+
+	// The first frame has nothing to compare the camera with. Everything is binned and nothing is kept
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), ctx.getLightCount());
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->tryGetCachedClusters(ctx.m_pointLights[0].m_uuid, clusters), false);
+
+	// The camera is still. Everything is binned again and kept
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), ctx.getLightCount());
+	ctx.checkCache();
+
+	// Nothing moves. All come from the cache
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 0);
+	ctx.checkCache();
+
+	// A point light moves. Only that is binned again
+	ctx.m_pointLights[2].m_worldPosition += Vec3(0.0f, 3.0f, -4.0f);
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 1);
+	ctx.checkCache();
+
+	// Its radius changes
+	ctx.m_pointLights[2].m_radius = 5.0f;
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 1);
+	ctx.checkCache();
+
+	// A spot light moves
+	ctx.moveSpotLight(1, Vec3(0.0f, -2.0f, -8.0f));
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 1);
+	ctx.checkCache();
+
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 0);
+
+	// The camera moves. Everything is binned again and the cache is dropped
+	ctx.m_camTrf = Transform(Vec4(1.0f, 0.0f, 2.0f, 0.0f), Mat3x4::getIdentity(), 1.0f);
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), ctx.getLightCount());
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->tryGetCachedClusters(ctx.m_pointLights[0].m_uuid, clusters), false);
+
+	// And it's rebuilt in the new view
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), ctx.getLightCount());
+	ctx.checkCache();
+
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 0);
+
+	// A light is removed. The rest come from the cache and the removed one leaves it
+	--ctx.m_pointLightCount;
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 0);
+	ANKI_TEST_EXPECT_EQ(
+		ctx.m_bin->tryGetCachedClusters(ctx.m_pointLights[ctx.m_pointLightCount].m_uuid, clusters), false);
+	ctx.checkCache();
+
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 0);
+	ctx.checkCache();
+
+	// And it comes back
+	++ctx.m_pointLightCount;
+	ctx.binFrame();
+	ANKI_TEST_EXPECT_EQ(ctx.m_bin->getLastCacheMissCount(), 1);
+	ctx.checkCache();
+}
+
+} // end namespace anki
@@ -0,0 +1,295 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/renderer/RendererObject.h>
+#include <anki/gr/ShaderCompiler.h>
+#include <anki/core/NativeWindow.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/ThreadPool.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/System.h>
+#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_NULL
+#	include <anki/gr/null/GrManagerImpl.h>
+#endif
+
+namespace anki
+{
+
+static U32 computeCount(U32 drawcallCount, Second recordingTimePerDrawcall, U32 threadCount)
+{
+	return RendererObject::computeNumberOfSecondLevelCommandBuffers(
+		drawcallCount, recordingTimePerDrawcall, threadCount);
+}
+
+ANKI_TEST(Renderer, SecondLevelCommandBufferCount)
+{
+	const U32 MIN_DRAWCALLS = MIN_DRAWCALLS_PER_2ND_LEVEL_COMMAND_BUFFER;
+
+	// Nothing to draw still gets a command buffer
+	ANKI_TEST_EXPECT_EQ(computeCount(0, 5.0 / 1000000.0, 8), 1);
+	ANKI_TEST_EXPECT_EQ(computeCount(1, 5.0 / 1000000.0, 8), 1);
+
+	// Expensive drawcalls. The min drawcall count is the limit
+	const Second expensive = MIN_RECORDING_TIME_PER_2ND_LEVEL_COMMAND_BUFFER;
+	ANKI_TEST_EXPECT_EQ(computeCount(MIN_DRAWCALLS - 1, expensive, 8), 1);
+	ANKI_TEST_EXPECT_EQ(computeCount(MIN_DRAWCALLS, expensive, 8), 1);
+	ANKI_TEST_EXPECT_EQ(computeCount(MIN_DRAWCALLS * 2 - 1, expensive, 8), 1);
+	ANKI_TEST_EXPECT_EQ(computeCount(MIN_DRAWCALLS * 2, expensive, 8), 2);
+	ANKI_TEST_EXPECT_EQ(computeCount(MIN_DRAWCALLS * 3 - 1, expensive, 8), 2);
+	ANKI_TEST_EXPECT_EQ(computeCount(MIN_DRAWCALLS * 3, expensive, 8), 3);
+
+	// Cheap drawcalls. The recording time is the limit. It takes 50 to fill a command buffer
+	const Second cheap = 1.0 / 1000000.0;
+	const U32 cheapPerCmdb = U32(MIN_RECORDING_TIME_PER_2ND_LEVEL_COMMAND_BUFFER / cheap + 0.5);
+	ANKI_TEST_EXPECT_EQ(cheapPerCmdb, 50);
+	for(U32 i = 1; i <= 8; ++i)
+	{
+		ANKI_TEST_EXPECT_EQ(computeCount(cheapPerCmdb * i - 1, cheap, 8), max(i - 1, 1u));
+		ANKI_TEST_EXPECT_EQ(computeCount(cheapPerCmdb * i, cheap, 8), i);
+		ANKI_TEST_EXPECT_EQ(computeCount(cheapPerCmdb * i + 1, cheap, 8), i);
+	}
+
+	// No more than the threads
+	ANKI_TEST_EXPECT_EQ(computeCount(cheapPerCmdb * 9, cheap, 8), 8);
+	ANKI_TEST_EXPECT_EQ(computeCount(MIN_DRAWCALLS * 100, expensive, 3), 3);
+	ANKI_TEST_EXPECT_EQ(computeCount(MAX_U32, 1.0, 16), 16);
+	ANKI_TEST_EXPECT_EQ(computeCount(MIN_DRAWCALLS * 100, expensive, 1), 1);
+}
+
+#if ANKI_GR_BACKEND == ANKI_GR_BACKEND_NULL
+
+static const char* BENCH_VERT_SRC = R"(
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+void main()
+{
+	gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+})";
+
+static const char* BENCH_FRAG_SRC = R"(
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	out_color = vec4(0.5);
+})";
+
+static ShaderPtr createBenchShader(CString src, ShaderType type, GrManager& gr)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ShaderCompiler comp(alloc);
+
+	ShaderCompilerOptions options;
+	options.setFromGrManager(gr);
+	options.m_shaderType = type;
+
+	DynamicArrayAuto<U8> bin(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(comp.compile(src, options, bin));
+
+	return gr.newShader(ShaderInitInfo(type, WeakArray<U8>(&bin[0], bin.getSize())));
+}
+
+/// Mimics the GBuffer and the ForwardShading passes. The drawcalls are split to 2nd level command buffers the way the
+/// renderer does it and the recording time of a drawcall is measured like the RenderableDrawer does.
+class SecondLevelBenchmark
+{
+public:
+	static const U32 GBUFFER_DRAWCALLS = 4000;
+	static const U32 FS_DRAWCALLS = 1000;
+	static const U32 FRAMES = 32;
+
+	GrManager* m_gr = nullptr;
+	ShaderProgramPtr m_prog;
+	BufferPtr m_uniforms;
+	BufferPtr m_indices;
+
+	Second m_recordingTimePerDrawcall = 5.0 / 1000000.0;
+	Atomic<U64> m_frameRecordingTimeNs = {0};
+
+	RenderGraphPtr m_rgraph;
+
+	class PassCtx
+	{
+	public:
+		SecondLevelBenchmark* m_bench;
+		U32 m_drawcallCount;
+	};
+
+	PassCtx m_gbufferPass = {this, GBUFFER_DRAWCALLS};
+	PassCtx m_fsPass = {this, FS_DRAWCALLS};
+
+	static void runCallback(RenderPassWorkContext& rgraphCtx)
+	{
+		const PassCtx& pass = *static_cast<const PassCtx*>(rgraphCtx.m_userData);
+		SecondLevelBenchmark& self = *pass.m_bench;
+		PtrSize start, end;
+		ThreadPoolTask::choseStartEnd(rgraphCtx.m_currentSecondLevelCommandBufferIndex,
+			rgraphCtx.m_secondLevelCommandBufferCount,
+			pass.m_drawcallCount,
+			start,
+			end);
+
+		const Second startTime = HighRezTimer::getCurrentTime();
+
+		CommandBufferPtr& cmdb = rgraphCtx.m_commandBuffer;
+		cmdb->setViewport(0, 0, 64, 64);
+		cmdb->bindShaderProgram(self.m_prog);
+		cmdb->bindIndexBuffer(self.m_indices, 0, IndexType::U16);
+		for(PtrSize i = start; i < end; ++i)
+		{
+			cmdb->bindUniformBuffer(0, 0, self.m_uniforms, (i % 64) * 256, sizeof(Mat4));
+			cmdb->drawElements(PrimitiveTopology::TRIANGLES, 36);
+		}
+
+		const Second time = HighRezTimer::getCurrentTime() - startTime;
+		self.m_frameRecordingTimeNs.fetchAdd(U64(time * 1000000000.0));
+	}
+
+	/// Run some frames and return the time it took to record the 2nd level command buffers.
+	Second run(ThreadHive& hive, StackAllocator<U8>& frameAlloc)
+	{
+		Second recordingTime = 0.0;
+
+		for(U frame = 0; frame < FRAMES; ++frame)
+		{
+			m_gr->beginFrame();
+
+			RenderGraphDescription descr(frameAlloc);
+
+			RenderTargetDescription depthDescr("Depth");
+			depthDescr.m_width = 64;
+			depthDescr.m_height = 64;
+			depthDescr.m_format = Format::D24_UNORM_S8_UINT;
+			depthDescr.bake();
+			const RenderTargetHandle depthRt = descr.newRenderTarget(depthDescr);
+
+			RenderTargetDescription colorDescr("Color");
+			colorDescr.m_width = 64;
+			colorDescr.m_height = 64;
+			colorDescr.m_format = Format::R8G8B8A8_UNORM;
+			colorDescr.bake();
+			const RenderTargetHandle gbufferRt = descr.newRenderTarget(colorDescr);
+			const RenderTargetHandle fsRt = descr.newRenderTarget(colorDescr);
+
+			FramebufferDescription fbDescr;
+			fbDescr.m_colorAttachmentCount = 1;
+			fbDescr.m_depthStencilAttachment.m_aspect = DepthStencilAspectBit::DEPTH;
+			fbDescr.bake();
+
+			const TextureSubresourceInfo depthSubresource(DepthStencilAspectBit::DEPTH);
+
+			GraphicsRenderPassDescription& gbuffer = descr.newGraphicsRenderPass("GBuffer");
+			gbuffer.setFramebufferInfo(fbDescr, {{gbufferRt}}, depthRt);
+			gbuffer.setWork(runCallback,
+				&m_gbufferPass,
+				RendererObject::computeNumberOfSecondLevelCommandBuffers(
+					GBUFFER_DRAWCALLS, m_recordingTimePerDrawcall, hive.getThreadCount()));
+			gbuffer.newConsumer({gbufferRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE});
+			gbuffer.newProducer({gbufferRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE});
+			gbuffer.newConsumer({depthRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE, depthSubresource});
+			gbuffer.newProducer({depthRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ_WRITE, depthSubresource});
+
+			GraphicsRenderPassDescription& fs = descr.newGraphicsRenderPass("Forward shading");
+			fs.setFramebufferInfo(fbDescr, {{fsRt}}, depthRt);
+			fs.setWork(runCallback,
+				&m_fsPass,
+				RendererObject::computeNumberOfSecondLevelCommandBuffers(
+					FS_DRAWCALLS, m_recordingTimePerDrawcall, hive.getThreadCount()));
+			fs.newConsumer({fsRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE});
+			fs.newProducer({fsRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_WRITE});
+			fs.newConsumer({depthRt, TextureUsageBit::FRAMEBUFFER_ATTACHMENT_READ, depthSubresource});
+
+			m_rgraph->compileNewGraph(descr, frameAlloc);
+
+			// Record in the hive with the code of the MainRenderer
+			const U32 secondLevelCmdbCount = m_rgraph->getSecondLevelCommandBufferCount();
+			ANKI_TEST_EXPECT_LEQ(secondLevelCmdbCount, hive.getThreadCount() * 2);
+
+			const Second startTime = HighRezTimer::getCurrentTime();
+			RendererObject::recordSecondLevelCommandBuffers(*m_rgraph, hive, frameAlloc);
+			recordingTime += HighRezTimer::getCurrentTime() - startTime;
+
+			m_rgraph->run();
+			m_rgraph->flush();
+			m_rgraph->reset();
+
+			// Smooth the recording time of a drawcall
+			const U64 timeNs = m_frameRecordingTimeNs.exchange(0);
+			const Second time = Second(timeNs) / (Second(GBUFFER_DRAWCALLS + FS_DRAWCALLS) * 1000000000.0);
+			m_recordingTimePerDrawcall = mix(m_recordingTimePerDrawcall, time, 0.1);
+
+			m_gr->swapBuffers();
+
+			frameAlloc.getMemoryPool().reset();
+		}
+
+		return recordingTime;
+	}
+};
+
+ANKI_TEST(Renderer, SecondLevelCommandBufferBenchmark)
+{
+	Config cfg;
+	cfg.set("width", 64);
+	cfg.set("height", 64);
+	NativeWindow* win = createWindow(cfg);
+	GrManager* gr = createGrManager(cfg, win);
+
+	{
+		HeapAllocator<U8> alloc(allocAligned, nullptr);
+		StackAllocator<U8> frameAlloc(allocAligned, nullptr, 1_MB, 1.0);
+
+		SecondLevelBenchmark bench;
+		bench.m_gr = gr;
+		bench.m_prog = gr->newShaderProgram(ShaderProgramInitInfo(
+			createBenchShader(BENCH_VERT_SRC, ShaderType::VERTEX, *gr),
+			createBenchShader(BENCH_FRAG_SRC, ShaderType::FRAGMENT, *gr)));
+		bench.m_uniforms = gr->newBuffer(BufferInitInfo(
+			64 * 256, BufferUsageBit::UNIFORM_ALL, BufferMapAccessBit::NONE, "SecondLevelBenchUniforms"));
+		bench.m_indices = gr->newBuffer(BufferInitInfo(
+			36 * sizeof(U16), BufferUsageBit::INDEX, BufferMapAccessBit::NONE, "SecondLevelBenchIndices"));
+		bench.m_rgraph = gr->newRenderGraph();
+
+		const NullGrCounters countersBefore = static_cast<GrManagerImpl*>(gr)->getCounters();
+
+		const U32 maxThreadCount = max(getCpuCoresCount(), 1u);
+		Second singleThreadTime = 0.0;
+		for(U32 threadCount = 1; threadCount <= maxThreadCount; ++threadCount)
+		{
+			ThreadHive hive(threadCount, alloc, true);
+			const Second time = bench.run(hive, frameAlloc);
+
+			if(threadCount == 1)
+			{
+				singleThreadTime = time;
+			}
+
+			ANKI_TEST_LOGI("Recorded the 2nd level command buffers in %u threads: %fms per frame | speedup %f "
+						   "(%f us per drawcall)",
+				threadCount,
+				time / Second(SecondLevelBenchmark::FRAMES) * 1000.0,
+				singleThreadTime / time,
+				bench.m_recordingTimePerDrawcall * 1000000.0);
+		}
+
+		// Every drawcall got recorded no matter how the passes were split
+		const NullGrCounters counters = static_cast<GrManagerImpl*>(gr)->getCounters();
+		ANKI_TEST_EXPECT_EQ(counters.m_drawcallCount - countersBefore.m_drawcallCount,
+			maxThreadCount * SecondLevelBenchmark::FRAMES
+				* (SecondLevelBenchmark::GBUFFER_DRAWCALLS + SecondLevelBenchmark::FS_DRAWCALLS));
+	}
+
+	gr->finish();
+	GrManager::deleteInstance(gr);
+	delete win;
+}
+
+#endif
+
+} // end namespace anki
@@ -0,0 +1,141 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/renderer/TileAllocator.h>
+
+namespace anki
+{
+
+static Bool viewportsOverlap(const Array<U32, 4>& a, const Array<U32, 4>& b)
+{
+	return a[0] < b[0] + b[2] && b[0] < a[0] + a[2] && a[1] < b[1] + b[3] && b[1] < a[1] + a[3];
+}
+
+static Bool viewportsEqual(const Array<U32, 4>& a, const Array<U32, 4>& b)
+{
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+ANKI_TEST(Renderer, TileAllocator)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// A 1024 atlas with tiles of 256, 128 and 64
+	TileAllocator talloc;
+	talloc.init(alloc, 1024, 256, 3);
+	ANKI_TEST_EXPECT_EQ(talloc.getTileResolution(0), 256);
+	ANKI_TEST_EXPECT_EQ(talloc.getTileResolution(2), 64);
+
+	Array<U32, 4> viewport;
+	ANKI_TEST_EXPECT_EQ(talloc.allocatePinned(0, viewport), false);
+	ANKI_TEST_EXPECT_EQ(viewport[0], 0);
+	ANKI_TEST_EXPECT_EQ(viewport[1], 0);
+	ANKI_TEST_EXPECT_EQ(viewport[2], 256);
+
+	// Fill the atlas with LOD 0 tiles
+	Array<Array<U32, 4>, 16> viewports;
+	Timestamp timestamp = 1;
+	for(U32 light = 1; light < 16; ++light)
+	{
+		const TileAllocatorResult res = talloc.allocate(timestamp, 1, light, 0, 10, 0, viewports[light]);
+		ANKI_TEST_EXPECT_EQ(res, TileAllocatorResult::ALLOCATION_SUCCEEDED);
+		ANKI_TEST_EXPECT_EQ(viewports[light][2], 256);
+
+		ANKI_TEST_EXPECT_EQ(viewportsOverlap(viewport, viewports[light]), false);
+		for(U32 otherLight = 1; otherLight < light; ++otherLight)
+		{
+			ANKI_TEST_EXPECT_EQ(viewportsOverlap(viewports[otherLight], viewports[light]), false);
+		}
+	}
+
+	// All the tiles are used in this frame so nothing can be kicked
+	ANKI_TEST_EXPECT_EQ(
+		talloc.allocate(timestamp, 1, 100, 0, 10, 2, viewport), TileAllocatorResult::ALLOCATION_FAILED);
+
+	// Next frame. The tile of an unchanged light is cached, the tile of a changed one has to be rendered again
+	++timestamp;
+	ANKI_TEST_EXPECT_EQ(talloc.allocate(timestamp, 1, 1, 0, 10, 0, viewport), TileAllocatorResult::CACHED);
+	ANKI_TEST_EXPECT_EQ(viewportsEqual(viewport, viewports[1]), true);
+	ANKI_TEST_EXPECT_EQ(
+		talloc.allocate(timestamp, 2, 2, 0, 10, 0, viewport), TileAllocatorResult::ALLOCATION_SUCCEEDED);
+	ANKI_TEST_EXPECT_EQ(viewportsEqual(viewport, viewports[2]), true);
+	ANKI_TEST_EXPECT_EQ(
+		talloc.allocate(timestamp, 1, 3, 0, 11, 0, viewport), TileAllocatorResult::ALLOCATION_SUCCEEDED);
+	ANKI_TEST_EXPECT_EQ(viewportsEqual(viewport, viewports[3]), true);
+
+	// Small tiles. They kick one of the LOD 0 tiles that were used the longest time ago and share its space
+	++timestamp;
+	Array<Array<U32, 4>, 16> smallViewports;
+	for(U32 i = 0; i < 16; ++i)
+	{
+		const TileAllocatorResult res = talloc.allocate(timestamp, 1, 100 + i, 0, 10, 2, smallViewports[i]);
+		ANKI_TEST_EXPECT_EQ(res, TileAllocatorResult::ALLOCATION_SUCCEEDED);
+		ANKI_TEST_EXPECT_EQ(smallViewports[i][2], 64);
+	}
+
+	// Light 4 is the first one that wasn't used in the previous frame
+	for(U32 i = 0; i < 16; ++i)
+	{
+		ANKI_TEST_EXPECT_EQ(viewportsOverlap(smallViewports[i], viewports[4]), true);
+	}
+
+	// The kicked light gets a new tile and kicks the next one
+	ANKI_TEST_EXPECT_EQ(
+		talloc.allocate(timestamp, 1, 4, 0, 10, 0, viewport), TileAllocatorResult::ALLOCATION_SUCCEEDED);
+	ANKI_TEST_EXPECT_EQ(viewportsEqual(viewport, viewports[5]), true);
+
+	// Release the small tiles. They merge back to a tile that can hold a LOD 0 tile
+	for(U32 i = 0; i < 16; ++i)
+	{
+		talloc.invalidateCache(100 + i, 0);
+	}
+
+	++timestamp;
+	ANKI_TEST_EXPECT_EQ(
+		talloc.allocate(timestamp, 1, 200, 0, 10, 0, viewport), TileAllocatorResult::ALLOCATION_SUCCEEDED);
+	ANKI_TEST_EXPECT_EQ(viewportsEqual(viewport, viewports[4]), true);
+
+	// A changed LOD needs a new tile
+	ANKI_TEST_EXPECT_EQ(
+		talloc.allocate(timestamp, 1, 1, 0, 10, 1, viewport), TileAllocatorResult::ALLOCATION_SUCCEEDED);
+	ANKI_TEST_EXPECT_EQ(viewport[0], viewports[1][0]);
+	ANKI_TEST_EXPECT_EQ(viewport[1], viewports[1][1]);
+	ANKI_TEST_EXPECT_EQ(viewport[2], 128);
+}
+
+ANKI_TEST(Renderer, TileAllocatorLodHysteresis)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Tiles of 256, 128 and 64
+	TileAllocator talloc;
+	talloc.init(alloc, 1024, 256, 3);
+
+	// Without a tile the LOD is the smallest tile that has more texels than the pixels
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(300.0f, 1, 0, 0.1f), 0);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(130.0f, 1, 0, 0.1f), 0);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(120.0f, 1, 0, 0.1f), 1);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(10.0f, 1, 0, 0.1f), 2);
+
+	// The light has a LOD 1 tile. It keeps it around the 128 threshold
+	Array<U32, 4> viewport;
+	ANKI_TEST_EXPECT_EQ(
+		talloc.allocate(1, 1, 1, 0, 10, 1, viewport), TileAllocatorResult::ALLOCATION_SUCCEEDED);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(130.0f, 1, 0, 0.1f), 1);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(145.0f, 1, 0, 0.1f), 0);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(60.0f, 1, 0, 0.1f), 1);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(55.0f, 1, 0, 0.1f), 2);
+
+	// Other faces and lights don't have tiles
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(130.0f, 1, 1, 0.1f), 0);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(60.0f, 2, 0, 0.1f), 2);
+
+	// The LOD is the same without hysteresis
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(130.0f, 1, 0, 0.0f), 0);
+	ANKI_TEST_EXPECT_EQ(talloc.selectLod(60.0f, 1, 0, 0.0f), 2);
+}
+
+} // end namespace anki
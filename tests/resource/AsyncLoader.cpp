@@ -269,4 +269,83 @@ ANKI_TEST(Resource, AsyncLoader)
 	}
 }
 
+ANKI_TEST(Resource, AsyncLoaderThreadsAndPriorities)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Many threads. Will deadlock if the tasks don't run in parallel
+	{
+		const U THREAD_COUNT = 4;
+		AsyncLoader a;
+		a.init(alloc, THREAD_COUNT);
+		ANKI_TEST_EXPECT_EQ(a.getThreadCount(), THREAD_COUNT);
+		Barrier barrier(THREAD_COUNT + 1);
+		Atomic<U32> counter = {0};
+
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			a.submitNewTask<Task>(0.0, &barrier, &counter);
+		}
+
+		barrier.wait();
+		ANKI_TEST_EXPECT_EQ(counter.load(), THREAD_COUNT);
+	}
+
+	// Priorities
+	{
+		AsyncLoader a;
+		a.init(alloc);
+		Barrier barrier(2);
+		Atomic<U32> counter = {0};
+
+		a.pause();
+		a.submitTask(a.newTask<Task>(0.0, nullptr, &counter, 1), AsyncLoaderPriority::BACKGROUND);
+		a.submitTask(a.newTask<Task>(0.0, &barrier, &counter, 2), AsyncLoaderPriority::BACKGROUND);
+		a.submitTask(a.newTask<Task>(0.0, nullptr, &counter, 0), AsyncLoaderPriority::VISIBLE);
+		ANKI_TEST_EXPECT_EQ(a.getQueuedTaskCount(AsyncLoaderPriority::BACKGROUND), 2);
+		ANKI_TEST_EXPECT_EQ(a.getQueuedTaskCount(AsyncLoaderPriority::VISIBLE), 1);
+		a.resume();
+
+		barrier.wait();
+		a.pause();
+		ANKI_TEST_EXPECT_EQ(counter.load(), 3);
+		ANKI_TEST_EXPECT_EQ(a.getCompletedTaskCount(), 3);
+		a.resume();
+	}
+
+	// Cancel
+	{
+		AsyncLoader a;
+		a.init(alloc);
+		Barrier barrier(2);
+		Atomic<U32> counter = {0};
+		const U32 owner = 0;
+
+		a.pause();
+		for(U i = 0; i < 3; ++i)
+		{
+			Task* task = a.newTask<Task>(0.0, nullptr, &counter);
+			task->setOwner(&owner);
+			a.submitTask(task, AsyncLoaderPriority(i % U(AsyncLoaderPriority::COUNT)));
+		}
+		a.submitNewTask<Task>(0.0, nullptr, &counter);
+
+		ANKI_TEST_EXPECT_EQ(a.cancelTasks(&owner), 3);
+		a.resume();
+
+		a.submitNewTask<Task>(0.0, &barrier, &counter);
+		barrier.wait();
+		ANKI_TEST_EXPECT_EQ(counter.load(), 2);
+
+		// Cancel a running task. It should wait for it
+		Task* task = a.newTask<Task>(0.5, nullptr, &counter);
+		task->setOwner(&owner);
+		a.submitTask(task);
+		HighRezTimer::sleep(0.25);
+		ANKI_TEST_EXPECT_EQ(a.cancelTasks(&owner), 0);
+		ANKI_TEST_EXPECT_EQ(counter.load(), 3);
+		ANKI_TEST_EXPECT_EQ(a.getCompletedTaskCount(), 3);
+	}
+}
+
 } // end namespace anki
@@ -0,0 +1,206 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/resource/ImageLoader.h>
+#include <anki/util/File.h>
+#include <anki/util/Filesystem.h>
+#include <cstring>
+
+namespace anki
+{
+
+/// Same as the header of the AnKi textures.
+class TestAnkiTextureHeader
+{
+public:
+	Array<U8, 8> m_magic;
+	U32 m_width;
+	U32 m_height;
+	U32 m_depthOrLayerCount;
+	ImageLoader::TextureType m_type;
+	ImageLoader::ColorFormat m_colorFormat;
+	ImageLoader::DataCompression m_compressionFormats;
+	U32 m_normal;
+	U32 m_mipLevels;
+	U8 m_padding[88];
+};
+
+static_assert(sizeof(TestAnkiTextureHeader) == 128, "Should match the AnKi texture header");
+
+/// Fill every surface with a value that identifies its compression, mip and layer.
+static U8 computeTestTexel(ImageLoader::DataCompression comp, U32 mip, U32 layer)
+{
+	return U8(((comp == ImageLoader::DataCompression::RAW) ? 0x80 : 0x40) | (mip << 4) | layer);
+}
+
+/// Write an RGBA8 AnKi texture.
+static Error writeTestTexture(CString filename,
+	ImageLoader::TextureType type,
+	U32 size,
+	U32 layerCount,
+	U32 mipCount,
+	ImageLoader::DataCompression compressions)
+{
+	TestAnkiTextureHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(&header.m_magic[0], "ANKITEX1", 8);
+	header.m_width = size;
+	header.m_height = size;
+	header.m_depthOrLayerCount = layerCount;
+	header.m_type = type;
+	header.m_colorFormat = ImageLoader::ColorFormat::RGBA8;
+	header.m_compressionFormats = compressions;
+	header.m_mipLevels = mipCount;
+
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+	ANKI_CHECK(file.write(&header, sizeof(header)));
+
+	for(ImageLoader::DataCompression comp : {ImageLoader::DataCompression::RAW, ImageLoader::DataCompression::S3TC})
+	{
+		if((compressions & comp) == ImageLoader::DataCompression::NONE)
+		{
+			continue;
+		}
+
+		for(U32 mip = 0; mip < mipCount; ++mip)
+		{
+			const U32 mipSize = size >> mip;
+			const U32 surfSize = (comp == ImageLoader::DataCompression::RAW) ? mipSize * mipSize * 4
+																			 : (mipSize / 4) * (mipSize / 4) * 16;
+
+			for(U32 layer = 0; layer < layerCount; ++layer)
+			{
+				Array<U8, 64 * 64 * 4> texels;
+				ANKI_ASSERT(surfSize <= sizeof(texels));
+				memset(&texels[0], computeTestTexel(comp, mip, layer), surfSize);
+				ANKI_CHECK(file.write(&texels[0], surfSize));
+			}
+		}
+	}
+
+	return Error::NONE;
+}
+
+/// Check that every loaded surface has the right size and data.
+static void checkTestSurfaces(const ImageLoader& loader, U32 fileFirstMip, U32 layerCount)
+{
+	for(U32 mip = 0; mip < loader.getMipLevelsCount(); ++mip)
+	{
+		for(U32 layer = 0; layer < layerCount; ++layer)
+		{
+			const ImageLoader::Surface& surf = loader.getSurface(mip, 0, layer);
+			ANKI_TEST_EXPECT_EQ(surf.m_width, loader.getWidth() >> mip);
+
+			const PtrSize expectedSize = (loader.getCompression() == ImageLoader::DataCompression::RAW)
+											 ? surf.m_width * surf.m_height * 4
+											 : (surf.m_width / 4) * (surf.m_height / 4) * 16;
+			ANKI_TEST_EXPECT_EQ(surf.getData().getSize(), expectedSize);
+
+			const U8 expectedTexel = computeTestTexel(loader.getCompression(), fileFirstMip + mip, layer);
+			ANKI_TEST_EXPECT_EQ(surf.getData()[0], expectedTexel);
+			ANKI_TEST_EXPECT_EQ(surf.getData()[surf.getData().getSize() - 1], expectedTexel);
+		}
+	}
+}
+
+ANKI_TEST(Resource, ImageLoader)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const CString dir = "image_loader_test";
+	if(directoryExists(dir))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+
+	ANKI_TEST_EXPECT_NO_ERR(writeTestTexture("image_loader_test/2d.ankitex",
+		ImageLoader::TextureType::_2D,
+		64,
+		1,
+		5,
+		ImageLoader::DataCompression::RAW | ImageLoader::DataCompression::S3TC));
+	ANKI_TEST_EXPECT_NO_ERR(writeTestTexture("image_loader_test/array.ankitex",
+		ImageLoader::TextureType::_2D_ARRAY,
+		32,
+		3,
+		4,
+		ImageLoader::DataCompression::RAW));
+
+	ResourceFilesystem fs(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath(dir));
+
+	// Only the header
+	{
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("2d.ankitex", file));
+
+		ImageLoader loader(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(loader.loadHeader(file, "2d.ankitex", 16));
+		ANKI_TEST_EXPECT_EQ(loader.getTextureType(), ImageLoader::TextureType::_2D);
+		ANKI_TEST_EXPECT_EQ(loader.getFirstMipLevel(), 2);
+		ANKI_TEST_EXPECT_EQ(loader.getMipLevelsCount(), 3);
+		ANKI_TEST_EXPECT_EQ(loader.getWidth(), 16);
+	}
+
+	// All the mips
+	{
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("2d.ankitex", file));
+
+		ImageLoader loader(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(loader.load(file, "2d.ankitex"));
+		ANKI_TEST_EXPECT_EQ(loader.getFirstMipLevel(), 0);
+		ANKI_TEST_EXPECT_EQ(loader.getMipLevelsCount(), 5);
+		ANKI_TEST_EXPECT_EQ(loader.getWidth(), 64);
+		checkTestSurfaces(loader, 0, 1);
+	}
+
+	// Skip the big mips of a segment that is not the first
+	{
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("2d.ankitex", file));
+
+		ImageLoader loader(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(loader.load(file, "2d.ankitex", 16));
+		ANKI_TEST_EXPECT_EQ(loader.getFirstMipLevel(), 2);
+		ANKI_TEST_EXPECT_EQ(loader.getMipLevelsCount(), 3);
+		ANKI_TEST_EXPECT_EQ(loader.getWidth(), 16);
+		ANKI_TEST_EXPECT_EQ(loader.getHeight(), 16);
+		checkTestSurfaces(loader, 2, 1);
+	}
+
+	// The last mip is always loaded
+	{
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("2d.ankitex", file));
+
+		ImageLoader loader(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(loader.load(file, "2d.ankitex", 1));
+		ANKI_TEST_EXPECT_EQ(loader.getFirstMipLevel(), 4);
+		ANKI_TEST_EXPECT_EQ(loader.getMipLevelsCount(), 1);
+		checkTestSurfaces(loader, 4, 1);
+	}
+
+	// The layers of an array
+	{
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("array.ankitex", file));
+
+		ImageLoader loader(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(loader.load(file, "array.ankitex", 16));
+		ANKI_TEST_EXPECT_EQ(loader.getCompression(), ImageLoader::DataCompression::RAW);
+		ANKI_TEST_EXPECT_EQ(loader.getLayerCount(), 3);
+		ANKI_TEST_EXPECT_EQ(loader.getFirstMipLevel(), 1);
+		ANKI_TEST_EXPECT_EQ(loader.getMipLevelsCount(), 3);
+		checkTestSurfaces(loader, 1, 3);
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+}
+
+} // end namespace anki
@@ -0,0 +1,215 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/resource/MeshOptimizer.h>
+
+namespace anki
+{
+
+/// Create a flat grid of quads with its triangles in random order. It's the worst case for the vertex cache.
+static void createTestGrid(
+	U32 quadsPerSide, DynamicArrayAuto<U32>& indices, DynamicArrayAuto<Vec3>& positions, Bool shuffle)
+{
+	const U32 vertsPerSide = quadsPerSide + 1;
+	positions.create(vertsPerSide * vertsPerSide);
+	for(U32 y = 0; y < vertsPerSide; ++y)
+	{
+		for(U32 x = 0; x < vertsPerSide; ++x)
+		{
+			positions[y * vertsPerSide + x] = Vec3(F32(x), F32(y), 0.0f);
+		}
+	}
+
+	indices.create(quadsPerSide * quadsPerSide * 6);
+	U32 count = 0;
+	for(U32 y = 0; y < quadsPerSide; ++y)
+	{
+		for(U32 x = 0; x < quadsPerSide; ++x)
+		{
+			const U32 v = y * vertsPerSide + x;
+			const Array<U32, 6> quad = {{v, v + 1, v + vertsPerSide, v + 1, v + vertsPerSide + 1, v + vertsPerSide}};
+			for(U32 idx : quad)
+			{
+				indices[count++] = idx;
+			}
+		}
+	}
+
+	if(shuffle)
+	{
+		// Deterministic shuffle of the triangles
+		U32 seed = 0x1234567;
+		const U32 triCount = indices.getSize() / 3;
+		for(U32 i = triCount - 1; i > 0; --i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			const U32 j = seed % (i + 1);
+			for(U32 k = 0; k < 3; ++k)
+			{
+				std::swap(indices[i * 3 + k], indices[j * 3 + k]);
+			}
+		}
+	}
+}
+
+ANKI_TEST(Resource, MeshOptimizer)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Vertex cache
+	{
+		DynamicArrayAuto<U32> indices(alloc);
+		DynamicArrayAuto<Vec3> positions(alloc);
+		createTestGrid(64, indices, positions, true);
+
+		const VertexCacheStatistics before =
+			MeshOptimizer::computeVertexCacheStatistics(indices, positions.getSize(), alloc);
+
+		DynamicArrayAuto<U32> optimized(alloc);
+		optimized.create(indices.getSize());
+		MeshOptimizer::optimizeVertexCache(indices, positions.getSize(), WeakArray<U32>(optimized), alloc);
+
+		const VertexCacheStatistics after =
+			MeshOptimizer::computeVertexCacheStatistics(optimized, positions.getSize(), alloc);
+
+		ANKI_TEST_LOGI("Vertex cache of a %u triangle grid: ACMR %f -> %f, ATVR %f -> %f",
+			indices.getSize() / 3,
+			before.m_acmr,
+			after.m_acmr,
+			before.m_atvr,
+			after.m_atvr);
+
+		ANKI_TEST_EXPECT_GT(before.m_acmr, 2.0f);
+		ANKI_TEST_EXPECT_LT(after.m_acmr, 0.8f);
+		ANKI_TEST_EXPECT_LT(after.m_atvr, 1.5f);
+
+		// The same triangles are there
+		U64 beforeSum = 0, afterSum = 0;
+		for(U32 i = 0; i < indices.getSize(); ++i)
+		{
+			beforeSum += indices[i] * indices[i];
+			afterSum += optimized[i] * optimized[i];
+		}
+		ANKI_TEST_EXPECT_EQ(beforeSum, afterSum);
+	}
+
+	// Vertex fetch
+	{
+		DynamicArrayAuto<U32> indices(alloc);
+		DynamicArrayAuto<Vec3> positions(alloc);
+		createTestGrid(8, indices, positions, true);
+
+		// Add a vertex that is not used
+		positions.resize(positions.getSize() + 1);
+		positions.getBack() = Vec3(-1.0f);
+
+		DynamicArrayAuto<U32> remap(alloc);
+		remap.create(positions.getSize());
+		const U32 newVertexCount =
+			MeshOptimizer::optimizeVertexFetch(WeakArray<U32>(indices), WeakArray<U32>(remap));
+		ANKI_TEST_EXPECT_EQ(newVertexCount, positions.getSize() - 1);
+		ANKI_TEST_EXPECT_EQ(remap[positions.getSize() - 1], MAX_U32);
+
+		// Every index is at most one more than the max before it
+		U32 maxIdx = 0;
+		for(U32 i = 0; i < indices.getSize(); ++i)
+		{
+			ANKI_TEST_EXPECT_LEQ(indices[i], (i == 0) ? 0 : maxIdx + 1);
+			maxIdx = max(maxIdx, indices[i]);
+		}
+	}
+
+	// Meshlets
+	{
+		DynamicArrayAuto<U32> indices(alloc);
+		DynamicArrayAuto<Vec3> positions(alloc);
+		createTestGrid(32, indices, positions, false);
+
+		MeshBinaryFile::SubMesh subMesh;
+		subMesh.m_firstIndex = 0;
+		subMesh.m_indexCount = indices.getSize();
+
+		const U32 MAX_VERTICES = 64;
+		const U32 MAX_TRIANGLES = 126;
+		DynamicArrayAuto<MeshBinaryFile::Meshlet> meshlets(alloc);
+		MeshOptimizer::generateMeshlets(indices, positions, subMesh, MAX_VERTICES, MAX_TRIANGLES, meshlets);
+		ANKI_TEST_EXPECT_GT(meshlets.getSize(), 1);
+
+		U32 idxSum = 0;
+		for(const MeshBinaryFile::Meshlet& meshlet : meshlets)
+		{
+			ANKI_TEST_EXPECT_EQ(meshlet.m_firstIndex, idxSum);
+			ANKI_TEST_EXPECT_LEQ(meshlet.m_vertexCount, MAX_VERTICES);
+			ANKI_TEST_EXPECT_LEQ(meshlet.m_indexCount / 3, MAX_TRIANGLES);
+			idxSum += meshlet.m_indexCount;
+
+			for(U32 i = meshlet.m_firstIndex; i < meshlet.m_firstIndex + meshlet.m_indexCount; ++i)
+			{
+				const Vec3& pos = positions[indices[i]];
+				for(U32 d = 0; d < 3; ++d)
+				{
+					ANKI_TEST_EXPECT_GEQ(pos[d], meshlet.m_aabbMin[d]);
+					ANKI_TEST_EXPECT_LEQ(pos[d], meshlet.m_aabbMax[d]);
+				}
+			}
+
+			// The grid is flat so the normals are all the same
+			ANKI_TEST_EXPECT_NEAR(meshlet.m_coneAxis.z(), 1.0f, EPSILON);
+			ANKI_TEST_EXPECT_NEAR(meshlet.m_coneCutoff, 1.0f, EPSILON);
+		}
+		ANKI_TEST_EXPECT_EQ(idxSum, indices.getSize());
+	}
+
+	// Simplify a flat grid. It can go down to the triangles that are needed for the locked border
+	{
+		DynamicArrayAuto<U32> indices(alloc);
+		DynamicArrayAuto<Vec3> positions(alloc);
+		createTestGrid(32, indices, positions, false);
+
+		DynamicArrayAuto<U32> simplified(alloc);
+		const F32 error = MeshOptimizer::simplify(indices, positions, indices.getSize() / 4, 0.01f, simplified, alloc);
+		ANKI_TEST_LOGI("Flat grid simplified from %u to %u triangles with error %f",
+			indices.getSize() / 3,
+			simplified.getSize() / 3,
+			error);
+
+		ANKI_TEST_EXPECT_LEQ(simplified.getSize(), indices.getSize() / 4);
+		ANKI_TEST_EXPECT_LEQ(error, 0.01f);
+
+		// Nothing moved or flipped so the area is the same
+		F32 area = 0.0f;
+		for(U32 i = 0; i < simplified.getSize(); i += 3)
+		{
+			const Vec3& a = positions[simplified[i]];
+			const Vec3 n = (positions[simplified[i + 1]] - a).cross(positions[simplified[i + 2]] - a);
+			ANKI_TEST_EXPECT_GT(n.z(), 0.0f);
+			area += n.getLength() / 2.0f;
+		}
+		ANKI_TEST_EXPECT_NEAR(area, 32.0f * 32.0f, 0.01f);
+	}
+
+	// A curved grid can't be simplified with zero error
+	{
+		DynamicArrayAuto<U32> indices(alloc);
+		DynamicArrayAuto<Vec3> positions(alloc);
+		createTestGrid(16, indices, positions, false);
+		for(Vec3& pos : positions)
+		{
+			pos.z() = sin(pos.x() * 0.4f) * cos(pos.y() * 0.4f);
+		}
+
+		DynamicArrayAuto<U32> simplified(alloc);
+		MeshOptimizer::simplify(indices, positions, 0, 0.0f, simplified, alloc);
+		ANKI_TEST_EXPECT_EQ(simplified.getSize(), indices.getSize());
+
+		const F32 error = MeshOptimizer::simplify(indices, positions, indices.getSize() / 2, 0.5f, simplified, alloc);
+		ANKI_TEST_EXPECT_LEQ(simplified.getSize(), indices.getSize() / 2);
+		ANKI_TEST_EXPECT_GT(error, 0.0f);
+		ANKI_TEST_EXPECT_LEQ(error, 0.5f);
+	}
+}
+
+} // end namespace anki
@@ -5,6 +5,8 @@
 
 #include "tests/framework/Framework.h"
 #include "anki/resource/ResourceFilesystem.h"
+#include "anki/resource/PackArchive.h"
+#include "anki/util/HighRezTimer.h"
 
 namespace anki
 {
@@ -33,6 +35,71 @@ ANKI_TEST(Resource, ResourceFilesystem)
 		ANKI_TEST_EXPECT_NO_ERR(file->readAllText(alloc, txt));
 		ANKI_TEST_EXPECT_EQ(txt, "hell\n");
 	}
+
+	{
+		ANKI_TEST_EXPECT_NO_ERR(createPackArchive("data/dir", "dir.ankipak", alloc));
+		ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath("dir.ankipak"));
+
+		ResourceFilePtr file;
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("subdir0/hello.txt", file));
+		ANKI_TEST_EXPECT_EQ(file->isMemoryMapped(), true);
+		ANKI_TEST_EXPECT_EQ(file->getSize(), 6);
+		StringAuto txt(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(file->readAllText(alloc, txt));
+		ANKI_TEST_EXPECT_EQ(txt, "hello\n");
+
+		// The contents are aligned and reading them doesn't copy
+		ConstWeakArray<U8> span;
+		ANKI_TEST_EXPECT_NO_ERR(file->seek(0, ResourceFile::SeekOrigin::BEGINNING));
+		ANKI_TEST_EXPECT_NO_ERR(file->getMappedSpan(5, span));
+		ANKI_TEST_EXPECT_EQ(PtrSize(span.getBegin()) % PACK_ARCHIVE_DATA_ALIGNMENT, 0);
+		ANKI_TEST_EXPECT_EQ(memcmp(span.getBegin(), "hello", 5), 0);
+
+		Array<char, 2> buff;
+		ANKI_TEST_EXPECT_ERR(file->read(&buff[0], 2), Error::FILE_ACCESS);
+		ANKI_TEST_EXPECT_NO_ERR(file->seek(1, ResourceFile::SeekOrigin::BEGINNING));
+		ANKI_TEST_EXPECT_NO_ERR(file->read(&buff[0], 2));
+		ANKI_TEST_EXPECT_EQ(buff[1], 'l');
+
+		// Empty files are there too
+		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("a.txt", file));
+		ANKI_TEST_EXPECT_EQ(file->getSize(), 0);
+	}
+}
+
+ANKI_TEST(Resource, ResourceFilesystemBench)
+{
+	printf("Test requires the data dir\n");
+
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const U ITERATIONS = 10000;
+
+	ANKI_TEST_EXPECT_NO_ERR(createPackArchive("data/dir", "dir.ankipak", alloc));
+	Array<CString, 2> archives = {{"./data/dir.ankizip", "dir.ankipak"}};
+	Array<Second, 2> times;
+
+	for(U i = 0; i < archives.getSize(); ++i)
+	{
+		ResourceFilesystem fs(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath(archives[i]));
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		for(U it = 0; it < ITERATIONS; ++it)
+		{
+			ResourceFilePtr file;
+			ANKI_TEST_EXPECT_NO_ERR(fs.openFile("subdir0/hello.txt", file));
+			Array<char, 4> buff;
+			ANKI_TEST_EXPECT_NO_ERR(file->read(&buff[0], buff.getSize()));
+			ANKI_TEST_EXPECT_NO_ERR(file->seek(0, ResourceFile::SeekOrigin::BEGINNING));
+			ANKI_TEST_EXPECT_NO_ERR(file->read(&buff[0], buff.getSize()));
+		}
+		times[i] = (HighRezTimer::getCurrentTime() - begin) / ITERATIONS;
+	}
+
+	ANKI_TEST_LOGI("Open, read, rewind and read again: ankizip %.3fus, ankipak %.3fus (%.2fx)",
+		times[0] * 1000000.0,
+		times[1] * 1000000.0,
+		times[0] / times[1]);
 }
 
 } // end namespace anki
@@ -6,7 +6,12 @@
 #include "tests/framework/Framework.h"
 #include "anki/resource/DummyResource.h"
 #include "anki/resource/ResourceManager.h"
+#include "anki/resource/GenericResource.h"
+#include "anki/resource/AsyncLoader.h"
 #include "anki/core/Config.h"
+#include "anki/util/ThreadPool.h"
+#include "anki/util/Filesystem.h"
+#include "anki/util/HighRezTimer.h"
 
 namespace anki
 {
@@ -83,8 +88,109 @@ ANKI_TEST(Resource, ResourceManager)
 		}
 	}
 
+	// Parallel loads of the same resources
+	{
+		const U THREAD_COUNT = 8;
+		const U RESOURCE_COUNT = 16;
+
+		class LoadTask : public ThreadPoolTask
+		{
+		public:
+			ResourceManager* m_resources = nullptr;
+			Array<DummyResourcePtr, RESOURCE_COUNT> m_ptrs;
+
+			Error operator()(U32 taskId, PtrSize threadsCount)
+			{
+				// Every task starts from a different resource
+				for(U i = 0; i < RESOURCE_COUNT; ++i)
+				{
+					const U idx = (i + taskId) % RESOURCE_COUNT;
+					Array<char, 32> name;
+					snprintf(&name[0], name.getSize(), "parallel%u", U32(idx));
+					ANKI_CHECK(m_resources->loadResource(&name[0], m_ptrs[idx]));
+				}
+
+				return Error::NONE;
+			}
+		};
+
+		ThreadPool threadPool(THREAD_COUNT);
+		Array<LoadTask, THREAD_COUNT> tasks;
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			tasks[i].m_resources = resources;
+			threadPool.assignNewTask(i, &tasks[i]);
+		}
+		ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+
+		// Every resource loaded once
+		for(U i = 0; i < RESOURCE_COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(tasks[0].m_ptrs[i]->getRefcount().load(), I32(THREAD_COUNT));
+			for(U j = 1; j < THREAD_COUNT; ++j)
+			{
+				ANKI_TEST_EXPECT_EQ(tasks[j].m_ptrs[i].get(), tasks[0].m_ptrs[i].get());
+			}
+
+			if(i > 0)
+			{
+				ANKI_TEST_EXPECT_NEQ(tasks[0].m_ptrs[i].get(), tasks[0].m_ptrs[i - 1].get());
+			}
+		}
+	}
+
 	// Delete
 	alloc.deleteInstance(resources);
 }
 
+ANKI_TEST(Resource, ResourceHotReload)
+{
+	const CString dir = "hot_reload_test";
+	if(directoryExists(dir))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory("hot_reload_test/sub"));
+	ANKI_TEST_EXPECT_NO_ERR(writeTextFile("hot_reload_test/sub/file.txt", "old"));
+
+	Config config;
+	config.set("rsrc.dataPaths", dir);
+	config.set("rsrc.hotReload", 1);
+
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	ResourceManagerInitInfo rinit;
+	rinit.m_gr = nullptr;
+	rinit.m_config = &config;
+	rinit.m_cacheDir = "/tmp/";
+	rinit.m_allocCallback = allocAligned;
+	rinit.m_allocCallbackData = nullptr;
+	ResourceManager* resources = alloc.newInstance<ResourceManager>();
+	ANKI_TEST_EXPECT_NO_ERR(resources->init(rinit));
+
+	{
+		GenericResourcePtr rsrc;
+		ANKI_TEST_EXPECT_NO_ERR(resources->loadResource("sub/file.txt", rsrc, false));
+		ANKI_TEST_EXPECT_EQ(rsrc->getData().getSize(), 3);
+
+		ANKI_TEST_EXPECT_NO_ERR(writeTextFile("hot_reload_test/sub/file.txt", "new data"));
+
+		// The reload is applied between frames
+		for(U i = 0; i < 200 && rsrc->getData().getSize() == 3; ++i)
+		{
+			HighRezTimer::sleep(0.01);
+			resources->getAsyncLoader().pause();
+			resources->updateHotReload();
+			resources->getAsyncLoader().resume();
+		}
+
+		ANKI_TEST_EXPECT_EQ(rsrc->getData().getSize(), 8);
+		ANKI_TEST_EXPECT_EQ(memcmp(&rsrc->getData()[0], "new data", 8), 0);
+	}
+
+	alloc.deleteInstance(resources);
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+}
+
 } // end namespace anki
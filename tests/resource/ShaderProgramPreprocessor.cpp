@@ -0,0 +1,124 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/resource/ShaderProgramPreProcessor.h>
+#include <anki/resource/ResourceFilesystem.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/ParallelFor.h>
+#include <anki/util/Filesystem.h>
+
+namespace anki
+{
+
+static const char* PP_TEST_PROGRAM = R"(#pragma anki mutator	LOD 0 1 2
+#pragma anki input const Vec3 u_color
+#include "Common.glsl"
+#include "Common.glsl"
+
+#pragma anki start vert
+void main()
+{
+	gl_Position = vec4(commonFunc(), 1.0);
+}
+#pragma anki end
+
+#pragma anki start frag
+layout(location = 0) out vec3 out_color;
+void main()
+{
+	out_color = u_color;
+}
+#pragma anki end
+)";
+
+ANKI_TEST(Resource, ShaderProgramPreprocessor)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const CString dir = "shader_pp_test";
+	if(directoryExists(dir))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir));
+	ANKI_TEST_EXPECT_NO_ERR(writeTextFile("shader_pp_test/Common.glsl",
+		"#pragma once\nvec3 commonFunc()\n{\n\treturn vec3(1.0);\n}\n"));
+
+	const U PROGRAM_COUNT = 16;
+	for(U i = 0; i < PROGRAM_COUNT; ++i)
+	{
+		StringAuto fname(alloc);
+		fname.sprintf("shader_pp_test/Prog%u.glslp", U32(i));
+		ANKI_TEST_EXPECT_NO_ERR(writeTextFile(fname.toCString(), PP_TEST_PROGRAM));
+	}
+
+	ResourceFilesystem fs(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath(dir));
+
+	// Serial with its own cache
+	StringAuto reference(alloc);
+	{
+		ShaderProgramPreprocessor pp("Prog0.glslp", &fs, alloc);
+		ANKI_TEST_EXPECT_NO_ERR(pp.parse());
+		reference.create(pp.getSource());
+
+		ANKI_TEST_EXPECT_EQ(pp.getMutators().getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(pp.getMutators()[0].getName(), "LOD");
+		ANKI_TEST_EXPECT_EQ(pp.getMutators()[0].getValues().getSize(), 3);
+		ANKI_TEST_EXPECT_EQ(pp.getInputs().getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(pp.getInputs()[0].getName(), "u_color");
+		ANKI_TEST_EXPECT_EQ(pp.getInputs()[0].isConstant(), true);
+		ANKI_TEST_EXPECT_EQ(pp.getDependencies().getSize(), 3);
+		ANKI_TEST_EXPECT_NEQ(reference.find("commonFunc"), String::NPOS);
+	}
+
+	// In parallel with a shared cache
+	ShaderProgramPreprocessorIncludeCache cache(alloc);
+	{
+		ThreadHive hive(4, alloc);
+
+		DynamicArrayAuto<ShaderProgramPreprocessor*> pps(alloc);
+		pps.create(PROGRAM_COUNT);
+		for(U i = 0; i < PROGRAM_COUNT; ++i)
+		{
+			StringAuto fname(alloc);
+			fname.sprintf("Prog%u.glslp", U32(i));
+			pps[i] = alloc.newInstance<ShaderProgramPreprocessor>(fname.toCString(), &fs, alloc, &cache);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(
+			parallelFor(hive, 0, PROGRAM_COUNT, 1, [&](PtrSize begin, PtrSize end, U32) -> Error {
+				for(PtrSize i = begin; i < end; ++i)
+				{
+					ANKI_CHECK(pps[i]->parse());
+				}
+				return Error::NONE;
+			}));
+
+		for(ShaderProgramPreprocessor* pp : pps)
+		{
+			ANKI_TEST_EXPECT_EQ(reference, pp->getSource());
+			alloc.deleteInstance(pp);
+		}
+
+		// The include is read once and then it's reused
+		ANKI_TEST_EXPECT_GT(cache.getHitCount(), PROGRAM_COUNT);
+	}
+
+	// Changing a file invalidates its entry
+	{
+			ANKI_TEST_EXPECT_NO_ERR(writeTextFile("shader_pp_test/Common.glsl",
+			"#pragma once\nvec3 commonFunc()\n{\n\treturn vec3(0.5);\n}\n"));
+
+		ShaderProgramPreprocessor pp("Prog0.glslp", &fs, alloc, &cache);
+		ANKI_TEST_EXPECT_NO_ERR(pp.parse());
+		ANKI_TEST_EXPECT_NEQ(CString(pp.getSource()).find("vec3(0.5)"), CString::NPOS);
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
+}
+
+} // end namespace anki
@@ -0,0 +1,302 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/resource/ShaderProgramResource.h>
+#include <anki/util/Filesystem.h>
+
+namespace anki
+{
+
+static const U VARIANT_COUNT = 32;
+
+static const char* COMMON_GLSL = "#pragma once\nVec3 commonFunc()\n{\n\treturn Vec3(1.0);\n}\n";
+
+static const char* PROGRAM_BODY = R"(#pragma anki input Mat4 u_mvp
+#pragma anki input Vec4 u_color "VARIANT > 0"
+#include "Common.glsl"
+
+#pragma anki start vert
+layout(location = 0) in Vec3 in_position;
+
+out gl_PerVertex
+{
+	Vec4 gl_Position;
+};
+
+void main()
+{
+	gl_Position = u_mvp * Vec4(in_position * commonFunc(), 1.0);
+}
+#pragma anki end
+
+#pragma anki start frag
+layout(location = 0) out Vec4 out_color;
+
+void main()
+{
+#if VARIANT > 0
+	out_color = u_color;
+#else
+	out_color = Vec4(commonFunc(), 1.0);
+#endif
+}
+#pragma anki end
+)";
+
+/// Write the program with a mutator of VARIANT_COUNT values and some extra lines at the top.
+static Error writeProgram(CString extra)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	StringAuto txt(alloc);
+	txt.sprintf("#pragma anki mutator VARIANT");
+	for(U i = 0; i < VARIANT_COUNT; ++i)
+	{
+		StringAuto val(alloc);
+		val.sprintf(" %u", U32(i));
+		txt.append(val);
+	}
+	txt.append("\n");
+	txt.append(extra);
+	txt.append(PROGRAM_BODY);
+
+	return writeTextFile("shader_prog_test/Prog.glslp", txt.toCString());
+}
+
+static const ShaderProgramResourceVariant* getVariant(const ShaderProgramResource& prog, I32 value)
+{
+	ShaderProgramResourceMutation mutation;
+	mutation.m_mutator = prog.tryFindMutator("VARIANT");
+	mutation.m_value = value;
+
+	const ShaderProgramResourceVariant* variant;
+	prog.getOrCreateVariant(ConstWeakArray<ShaderProgramResourceMutation>(&mutation, 1), variant);
+	return variant;
+}
+
+class ShaderProgramResourceTestContext : public EngineTestContext
+{
+public:
+	ShaderProgramResourceTestContext()
+	{
+		if(directoryExists("shader_prog_test"))
+		{
+			ANKI_TEST_EXPECT_NO_ERR(removeDirectory("shader_prog_test"));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory("shader_prog_test"));
+		ANKI_TEST_EXPECT_NO_ERR(writeTextFile("shader_prog_test/Common.glsl", COMMON_GLSL));
+		ANKI_TEST_EXPECT_NO_ERR(writeProgram(""));
+
+		m_cfg.set("rsrc.dataPaths", "shader_prog_test");
+		initResources();
+
+		// Start without a cache from a previous run. An empty file is an invalid cache
+		StringAuto cacheFilename(HeapAllocator<U8>(allocAligned, nullptr));
+		cacheFilename.sprintf("%s/%llu.ankiprogcache",
+			m_resources->getCacheDirectory().cstr(),
+			ResourceObject::computeFilenameHash("Prog.glslp"));
+		ANKI_TEST_EXPECT_NO_ERR(writeTextFile(cacheFilename.toCString(), ""));
+	}
+
+	~ShaderProgramResourceTestContext()
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory("shader_prog_test"));
+	}
+};
+
+ANKI_TEST(Resource, ShaderProgramResourceCache)
+{
+	ShaderProgramResourceTestContext ctx;
+
+	// The first load preprocesses and writes the cache. The variants are added to it when the program dies
+	Array<U32, 2> uniBlockSizes;
+	Array<I16, 2> mvpOffsets;
+	{
+		ShaderProgramResourcePtr prog;
+		ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("Prog.glslp", prog));
+		ANKI_TEST_EXPECT_EQ(prog->isLoadedFromCache(), false);
+
+		const ShaderProgramResourceInputVariable* mvp = prog->tryFindInputVariable("u_mvp");
+		const ShaderProgramResourceInputVariable* color = prog->tryFindInputVariable("u_color");
+		for(U i = 0; i < 2; ++i)
+		{
+			const ShaderProgramResourceVariant* variant = getVariant(*prog, i);
+			ANKI_TEST_EXPECT_EQ(variant->variableActive(*color), i > 0);
+			uniBlockSizes[i] = variant->getUniformBlockSize();
+			mvpOffsets[i] = variant->getVariableBlockInfo(*mvp).m_offset;
+		}
+		ANKI_TEST_EXPECT_LT(uniBlockSizes[0], uniBlockSizes[1]);
+	}
+
+	// Nothing changed. It comes from the cache and the variants are the same
+	{
+		ShaderProgramResourcePtr prog;
+		ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("Prog.glslp", prog));
+		ANKI_TEST_EXPECT_EQ(prog->isLoadedFromCache(), true);
+		ANKI_TEST_EXPECT_EQ(prog->getMutators().getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(prog->getMutators()[0].getValues().getSize(), VARIANT_COUNT);
+		ANKI_TEST_EXPECT_EQ(prog->getInputVariables().getSize(), 2);
+
+		const ShaderProgramResourceInputVariable* mvp = prog->tryFindInputVariable("u_mvp");
+		const ShaderProgramResourceInputVariable* color = prog->tryFindInputVariable("u_color");
+		for(U i = 0; i < 2; ++i)
+		{
+			const ShaderProgramResourceVariant* variant = getVariant(*prog, i);
+			ANKI_TEST_EXPECT_NEQ(variant->getProgram().get(), nullptr);
+			ANKI_TEST_EXPECT_EQ(variant->variableActive(*color), i > 0);
+			ANKI_TEST_EXPECT_EQ(variant->getUniformBlockSize(), uniBlockSizes[i]);
+			ANKI_TEST_EXPECT_EQ(variant->getVariableBlockInfo(*mvp).m_offset, mvpOffsets[i]);
+		}
+	}
+
+	// Changing an include invalidates the cache
+	ANKI_TEST_EXPECT_NO_ERR(
+		writeTextFile("shader_prog_test/Common.glsl", "#pragma once\nVec3 commonFunc()\n{\n\treturn Vec3(0.5);\n}\n"));
+	{
+		ShaderProgramResourcePtr prog;
+		ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("Prog.glslp", prog));
+		ANKI_TEST_EXPECT_EQ(prog->isLoadedFromCache(), false);
+	}
+
+	// And the new cache is used next time
+	{
+		ShaderProgramResourcePtr prog;
+		ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("Prog.glslp", prog));
+		ANKI_TEST_EXPECT_EQ(prog->isLoadedFromCache(), true);
+	}
+
+	// Changing the program invalidates the cache too and the new inputs show up
+	ANKI_TEST_EXPECT_NO_ERR(writeProgram("#pragma anki input Vec4 u_extra\n"));
+	{
+		ShaderProgramResourcePtr prog;
+		ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("Prog.glslp", prog));
+		ANKI_TEST_EXPECT_EQ(prog->isLoadedFromCache(), false);
+		ANKI_TEST_EXPECT_EQ(prog->getInputVariables().getSize(), 3);
+		ANKI_TEST_EXPECT_NEQ(prog->tryFindInputVariable("u_extra"), nullptr);
+
+		const ShaderProgramResourceVariant* variant = getVariant(*prog, 0);
+		ANKI_TEST_EXPECT_GT(variant->getUniformBlockSize(), uniBlockSizes[0]);
+	}
+}
+
+ANKI_TEST(Resource, ShaderProgramResourceVariants)
+{
+	ShaderProgramResourceTestContext ctx;
+
+	ShaderProgramResourcePtr prog;
+	ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("Prog.glslp", prog));
+
+	// Many threads get all the variants. Half of them go through the variants in the same order so they race for the
+	// same keys and the rest start from different ones. The table grows while the threads read it
+	const U THREAD_COUNT = 8;
+
+	class ThreadCtx
+	{
+	public:
+		const ShaderProgramResource* m_prog;
+		U32 m_firstVariant;
+		Array<const ShaderProgramResourceVariant*, VARIANT_COUNT> m_variants;
+	};
+
+	Array<ThreadCtx, THREAD_COUNT> threadCtxs;
+	Array<Thread*, THREAD_COUNT> threads;
+	for(U t = 0; t < THREAD_COUNT; ++t)
+	{
+		threadCtxs[t].m_prog = prog.get();
+		threadCtxs[t].m_firstVariant = (t & 1) ? t * 5 : 0;
+
+		threads[t] = new Thread("VariantTest");
+		threads[t]->start(&threadCtxs[t], [](ThreadCallbackInfo& info) -> Error {
+			ThreadCtx& ctx = *static_cast<ThreadCtx*>(info.m_userData);
+
+			for(U i = 0; i < VARIANT_COUNT; ++i)
+			{
+				const U value = (ctx.m_firstVariant + i) % VARIANT_COUNT;
+				ctx.m_variants[value] = getVariant(*ctx.m_prog, value);
+			}
+
+			// The second time they are found without locking
+			for(U value = 0; value < VARIANT_COUNT; ++value)
+			{
+				if(getVariant(*ctx.m_prog, value) != ctx.m_variants[value])
+				{
+					return Error::FUNCTION_FAILED;
+				}
+			}
+
+			return Error::NONE;
+		});
+	}
+
+	for(U t = 0; t < THREAD_COUNT; ++t)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(threads[t]->join());
+		delete threads[t];
+	}
+
+	// Every thread got the same variant for a key and different keys got different variants
+	const ShaderProgramResourceInputVariable* color = prog->tryFindInputVariable("u_color");
+	for(U value = 0; value < VARIANT_COUNT; ++value)
+	{
+		const ShaderProgramResourceVariant* variant = threadCtxs[0].m_variants[value];
+		ANKI_TEST_EXPECT_NEQ(variant, nullptr);
+		ANKI_TEST_EXPECT_NEQ(variant->getProgram().get(), nullptr);
+		ANKI_TEST_EXPECT_EQ(variant->variableActive(*color), value > 0);
+
+		for(U t = 1; t < THREAD_COUNT; ++t)
+		{
+			ANKI_TEST_EXPECT_EQ(threadCtxs[t].m_variants[value], variant);
+		}
+
+		for(U other = 0; other < value; ++other)
+		{
+			ANKI_TEST_EXPECT_NEQ(threadCtxs[0].m_variants[other], variant);
+		}
+	}
+}
+
+ANKI_TEST(Resource, ShaderProgramResourceHotReload)
+{
+	ShaderProgramResourceTestContext ctx;
+
+	ShaderProgramResourcePtr prog;
+	ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("Prog.glslp", prog));
+	ANKI_TEST_EXPECT_EQ(prog->getReloadGeneration(), 0);
+	const ShaderProgramResourceVariant* oldVariant = getVariant(*prog, 1);
+	const ShaderProgramResourceInputVariable* color = prog->tryFindInputVariable("u_color");
+
+	// The same files. Nothing changes and the users don't need to get their variants again
+	{
+		ShaderProgramResource* newer;
+		ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadUnregisteredResource("Prog.glslp", newer));
+		ANKI_TEST_EXPECT_EQ(prog->hotReload(*newer), true);
+		ctx.m_resources->getAllocator().deleteInstance(newer);
+	}
+	ANKI_TEST_EXPECT_EQ(prog->getReloadGeneration(), 0);
+	ANKI_TEST_EXPECT_EQ(getVariant(*prog, 1), oldVariant);
+
+	// An include changes. The users see a new generation and the variants they get again have new programs
+	ANKI_TEST_EXPECT_NO_ERR(
+		writeTextFile("shader_prog_test/Common.glsl", "#pragma once\nVec3 commonFunc()\n{\n\treturn Vec3(0.5);\n}\n"));
+	{
+		ShaderProgramResource* newer;
+		ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadUnregisteredResource("Prog.glslp", newer));
+		ANKI_TEST_EXPECT_EQ(prog->hotReload(*newer), true);
+		ctx.m_resources->getAllocator().deleteInstance(newer);
+	}
+	ANKI_TEST_EXPECT_EQ(prog->getReloadGeneration(), 1);
+
+	// The inputs keep their addresses so the old mutations and constants still work
+	ANKI_TEST_EXPECT_EQ(prog->tryFindInputVariable("u_color"), color);
+	const ShaderProgramResourceVariant* newVariant = getVariant(*prog, 1);
+	ANKI_TEST_EXPECT_NEQ(newVariant, oldVariant);
+	ANKI_TEST_EXPECT_NEQ(newVariant->getProgram().get(), oldVariant->getProgram().get());
+	ANKI_TEST_EXPECT_EQ(newVariant->variableActive(*color), true);
+
+	// The old variant stays alive for the users that haven't got the new one yet
+	ANKI_TEST_EXPECT_NEQ(oldVariant->getProgram().get(), nullptr);
+}
+
+} // end namespace anki
@@ -0,0 +1,207 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/resource/TextureResidency.h>
+
+namespace anki
+{
+
+/// The mip sizes of a 256x256 RGBA8 texture with mips down to 4x4.
+static const Array<PtrSize, 7> TEST_MIP_SIZES = {{256 * 256 * 4, 128 * 128 * 4, 64 * 64 * 4, 32 * 32 * 4, 16 * 16 * 4,
+	8 * 8 * 4, 4 * 4 * 4}};
+
+static PtrSize computeTestMemory(U32 firstMip)
+{
+	PtrSize size = 0;
+	for(U32 mip = firstMip; mip < TEST_MIP_SIZES.getSize(); ++mip)
+	{
+		size += TEST_MIP_SIZES[mip];
+	}
+	return size;
+}
+
+/// Apply all the changes like the GPU side would do.
+static void completeChanges(TextureResidencyManager& mgr, DynamicArrayAuto<TextureResidencyChange>& changes)
+{
+	for(const TextureResidencyChange& change : changes)
+	{
+		mgr.onResidencyChanged(change.m_handle, change.m_firstMip);
+	}
+	changes.destroy();
+}
+
+ANKI_TEST(Resource, TextureResidency)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const ConstWeakArray<PtrSize> mipSizes(&TEST_MIP_SIZES[0], TEST_MIP_SIZES.getSize());
+	const U32 TAIL_MIP = 2;
+
+	// Load requests and the budget
+	{
+		TextureResidencyManager mgr(alloc);
+		mgr.init(computeTestMemory(0) + computeTestMemory(1), 16, 4);
+
+		int a, b;
+		const TextureResidencyHandle ha = mgr.registerTexture(mipSizes, 0, TAIL_MIP, TAIL_MIP, &a);
+		const TextureResidencyHandle hb = mgr.registerTexture(mipSizes, 0, TAIL_MIP, TAIL_MIP, &b);
+		ANKI_TEST_EXPECT_EQ(mgr.getMemoryUsage(), 2 * computeTestMemory(TAIL_MIP));
+
+		// Nothing requested, nothing changes
+		DynamicArrayAuto<TextureResidencyChange> changes(alloc);
+		mgr.update(1, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 0);
+
+		// The smallest requested mip wins
+		mgr.requestMip(ha, 1);
+		mgr.requestMip(ha, 0);
+		mgr.requestMip(ha, 1);
+		mgr.update(2, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_handle, ha);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_userData, &a);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_firstMip, 0);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_eviction, false);
+
+		// The memory is accounted before the change is done so the same change is not requested twice
+		ANKI_TEST_EXPECT_EQ(mgr.getMemoryUsage(), computeTestMemory(0) + computeTestMemory(TAIL_MIP));
+		mgr.requestMip(ha, 0);
+		DynamicArrayAuto<TextureResidencyChange> changes2(alloc);
+		mgr.update(3, changes2);
+		ANKI_TEST_EXPECT_EQ(changes2.getSize(), 0);
+
+		completeChanges(mgr, changes);
+		ANKI_TEST_EXPECT_EQ(mgr.getFirstResidentMip(ha), 0);
+
+		// Both want everything but only one fits. The other gets as much as fits
+		mgr.requestMip(ha, 0);
+		mgr.requestMip(hb, 0);
+		mgr.update(4, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 1);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_handle, hb);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_firstMip, 1);
+		completeChanges(mgr, changes);
+		ANKI_TEST_EXPECT_LEQ(mgr.getMemoryUsage(), mgr.getMemoryBudget());
+
+		// Requests outside the allowed range are clamped
+		mgr.requestMip(hb, 100);
+		mgr.update(5, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 0);
+
+		mgr.unregisterTexture(ha);
+		mgr.unregisterTexture(hb);
+		ANKI_TEST_EXPECT_EQ(mgr.getMemoryUsage(), 0);
+	}
+
+	// LRU eviction
+	{
+		TextureResidencyManager mgr(alloc);
+		mgr.init(computeTestMemory(0) + 2 * computeTestMemory(TAIL_MIP), 16, 4);
+
+		Array<TextureResidencyHandle, 3> handles;
+		for(TextureResidencyHandle& h : handles)
+		{
+			h = mgr.registerTexture(mipSizes, 0, TAIL_MIP, TAIL_MIP, nullptr);
+		}
+
+		// Make the 1st fully resident
+		DynamicArrayAuto<TextureResidencyChange> changes(alloc);
+		mgr.requestMip(handles[0], 0);
+		mgr.update(1, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 1);
+		completeChanges(mgr, changes);
+
+		// The 2nd is used in a later frame so the 1st is the least recently used and it's evicted to its tail
+		mgr.requestMip(handles[1], 0);
+		mgr.update(2, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_handle, handles[0]);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_eviction, true);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_firstMip, TAIL_MIP);
+		ANKI_TEST_EXPECT_EQ(changes[1].m_handle, handles[1]);
+		ANKI_TEST_EXPECT_EQ(changes[1].m_firstMip, 0);
+		completeChanges(mgr, changes);
+		ANKI_TEST_EXPECT_LEQ(mgr.getMemoryUsage(), mgr.getMemoryBudget());
+
+		// A texture that is requested in the same frame is not evicted. It's trimmed to what it needs
+		mgr.requestMip(handles[1], 1);
+		mgr.requestMip(handles[2], 0);
+		mgr.update(3, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_handle, handles[1]);
+		ANKI_TEST_EXPECT_EQ(changes[0].m_firstMip, 1);
+		ANKI_TEST_EXPECT_EQ(changes[1].m_handle, handles[2]);
+		ANKI_TEST_EXPECT_EQ(changes[1].m_firstMip, 1);
+		completeChanges(mgr, changes);
+		ANKI_TEST_EXPECT_LEQ(mgr.getMemoryUsage(), mgr.getMemoryBudget());
+
+		for(TextureResidencyHandle h : handles)
+		{
+			mgr.unregisterTexture(h);
+		}
+	}
+
+	// The number of changes in flight is limited and failed changes give their memory back
+	{
+		TextureResidencyManager mgr(alloc);
+		mgr.init(10 * computeTestMemory(0), 16, 2);
+
+		Array<TextureResidencyHandle, 4> handles;
+		for(TextureResidencyHandle& h : handles)
+		{
+			h = mgr.registerTexture(mipSizes, 0, TAIL_MIP, TAIL_MIP, nullptr);
+			mgr.requestMip(h, 0);
+		}
+
+		DynamicArrayAuto<TextureResidencyChange> changes(alloc);
+		mgr.update(1, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 2);
+
+		// Fail them
+		for(const TextureResidencyChange& change : changes)
+		{
+			mgr.onResidencyChanged(change.m_handle, TAIL_MIP);
+		}
+		changes.destroy();
+		ANKI_TEST_EXPECT_EQ(mgr.getMemoryUsage(), 4 * computeTestMemory(TAIL_MIP));
+
+		// The rest get their turn
+		for(TextureResidencyHandle h : handles)
+		{
+			mgr.requestMip(h, 0);
+		}
+		mgr.update(2, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 2);
+
+		// Unregistering a texture with a change in flight frees its slot. The other change is still in flight
+		const TextureResidencyHandle removed = changes[0].m_handle;
+		const TextureResidencyHandle inFlight = changes[1].m_handle;
+		mgr.unregisterTexture(removed);
+		changes.destroy();
+
+		for(TextureResidencyHandle h : handles)
+		{
+			if(h != removed)
+			{
+				mgr.requestMip(h, 0);
+			}
+		}
+		mgr.update(3, changes);
+		ANKI_TEST_EXPECT_EQ(changes.getSize(), 1);
+		ANKI_TEST_EXPECT_NEQ(changes[0].m_handle, inFlight);
+		completeChanges(mgr, changes);
+		mgr.onResidencyChanged(inFlight, 0);
+
+		for(TextureResidencyHandle h : handles)
+		{
+			if(h != removed)
+			{
+				mgr.unregisterTexture(h);
+			}
+		}
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,150 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/SceneGraph.h>
+#include <anki/scene/CameraNode.h>
+#include <anki/scene/components/FrustumComponent.h>
+#include <anki/scene/components/RenderComponent.h>
+#include <anki/scene/components/SpatialComponent.h>
+
+namespace anki
+{
+
+/// A renderable with a unit box that moves along the -Z axis.
+class LodTestNode : public SceneNode
+{
+public:
+	class MyRenderComponent : public RenderComponent
+	{
+	public:
+		MyRenderComponent(SceneNode* node)
+			: RenderComponent(node)
+		{
+		}
+
+		void setupRenderableQueueElement(RenderableQueueElement& el) const override
+		{
+			el.m_callback = drawCallback;
+			el.m_mergeKey = 1;
+			el.m_userData = this;
+		}
+
+		static void drawCallback(RenderQueueDrawContext& ctx, ConstWeakArray<void*> userData)
+		{
+		}
+	};
+
+	Aabb m_aabb;
+
+	LodTestNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init()
+	{
+		newComponent<MyRenderComponent>();
+		newComponent<SpatialComponent>(&m_aabb);
+		return Error::NONE;
+	}
+
+	/// Move it so its closest side is at some distance from the near plane.
+	void setDistance(F32 near, F32 distance)
+	{
+		const Vec3 center(0.0f, 0.0f, -(near + distance + 0.5f));
+		m_aabb = Aabb((center - Vec3(0.5f)).xyz0(), (center + Vec3(0.5f)).xyz0());
+
+		SpatialComponent& sp = getComponent<SpatialComponent>();
+		sp.setSpatialOrigin(center.xyz0());
+		sp.markForUpdate();
+	}
+
+	/// The radius the visibility tests use for the size on the screen.
+	static F32 getRadius()
+	{
+		return Vec3(1.0f).getLength() / 2.0f;
+	}
+};
+
+class LodTestContext : public EngineTestContext
+{
+public:
+	PerspectiveCameraNode* m_cam = nullptr;
+	LodTestNode* m_node = nullptr;
+	F32 m_near = 0.1f;
+	F32 m_fovY = toRad(60.0f);
+
+	LodTestContext()
+	{
+		initScene();
+
+		// The camera looks down -Z. It keeps the LODs
+		ANKI_TEST_EXPECT_NO_ERR(m_scene->newSceneNode<PerspectiveCameraNode>("cam", m_cam));
+		m_cam->setAll(m_fovY, m_fovY, m_near, 1000.0f);
+		m_cam->getComponent<FrustumComponent>().setEnabledVisibilityTests(
+			FrustumComponentVisibilityTestFlag::RENDER_COMPONENTS);
+		m_scene->setActiveCameraNode(m_cam);
+
+		ANKI_TEST_EXPECT_NO_ERR(m_scene->newSceneNode<LodTestNode>("node", m_node));
+	}
+
+	/// Move the node to where it has some size on the screen and get its LOD.
+	U32 getLod(F32 screenSize)
+	{
+		const F32 distance = LodTestNode::getRadius() / (screenSize * tan(m_fovY / 2.0f));
+		m_node->setDistance(m_near, distance);
+
+		updateScene();
+
+		RenderQueue rqueue;
+		m_scene->doVisibilityTests(rqueue);
+		ANKI_TEST_EXPECT_EQ(rqueue.m_renderables.getSize(), 1);
+		return rqueue.m_renderables[0].m_lod;
+	}
+};
+
+ANKI_TEST(Scene, LodSelection)
+{
+	LodTestContext ctx;
+
+	const F32 size0 = ctx.m_cfg.getNumber("scene.lodScreenSize0");
+	const F32 size1 = ctx.m_cfg.getNumber("scene.lodScreenSize1");
+	const F32 hysteresis = ctx.m_cfg.getNumber("scene.lodHysteresis");
+	ANKI_TEST_EXPECT_GT(hysteresis, 0.0f);
+	ANKI_TEST_EXPECT_GT(size0 * (1.0f - hysteresis), size1 * (1.0f + hysteresis));
+
+	// How far inside or outside of the hysteresis band to go
+	const F32 inside = 1.01f;
+	const F32 outside = 0.99f;
+
+	// Close to the camera
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size0 * (1.0f + hysteresis) * 1.5f), 0);
+
+	// Moving away. Past the 1st threshold but in the band it keeps the LOD 0
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size0 * outside), 0);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size0 * (1.0f - hysteresis) * inside), 0);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size0 * (1.0f - hysteresis) * outside), 1);
+
+	// And the same for the 2nd threshold
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size1 * outside), 1);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size1 * (1.0f - hysteresis) * inside), 1);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size1 * (1.0f - hysteresis) * outside), 2);
+
+	// Coming back. It has to go past the other side of the band to change the LOD
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size1 / outside), 2);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size1 * (1.0f + hysteresis) * outside), 2);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size1 * (1.0f + hysteresis) / outside), 1);
+
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size0 / outside), 1);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size0 * (1.0f + hysteresis) * outside), 1);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size0 * (1.0f + hysteresis) / outside), 0);
+
+	// Big jumps skip the LODs in between
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size1 * (1.0f - hysteresis) * 0.5f), 2);
+	ANKI_TEST_EXPECT_EQ(ctx.getLod(size0 * (1.0f + hysteresis) * 2.0f), 0);
+}
+
+} // end namespace anki
@@ -5,7 +5,12 @@
 
 #include <tests/framework/Framework.h>
 #include <anki/scene/Octree.h>
+#include <anki/scene/LooseOctree.h>
 #include <anki/collision/Frustum.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/ParallelFor.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/System.h>
 
 namespace anki
 {
@@ -85,4 +90,323 @@ ANKI_TEST(Scene, Octree)
 	}
 }
 
+ANKI_TEST(Scene, LooseOctree)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(4, alloc);
+
+	LooseOctree octree(alloc);
+	octree.init(Vec3(-100.0f), Vec3(100.0f), 5);
+
+	OrthographicFrustum frustum(-200.0f, 200.0f, -200.0f, 200.0f, 200.0f, -200.0f);
+	frustum.resetTransform(Transform::getIdentity());
+
+	// A frustum that sees only the positive X half
+	OrthographicFrustum halfFrustum(0.0f, 200.0f, -200.0f, 200.0f, 200.0f, -200.0f);
+	halfFrustum.resetTransform(Transform::getIdentity());
+
+	const U ITERATION_COUNT = 1000;
+	Array<LooseOctreePlaceable, ITERATION_COUNT> placeables;
+	Array<Aabb, ITERATION_COUNT> volumes;
+	std::vector<U32> placed;
+	for(U i = 0; i < ITERATION_COUNT; ++i)
+	{
+		// Some volumes are a bit outside the scene
+		const Vec3 center(randRange(-110.0f, 110.0f), randRange(-110.0f, 110.0f), randRange(-110.0f, 110.0f));
+		const Vec3 extent(randRange(0.1f, 20.0f), randRange(0.1f, 20.0f), randRange(0.1f, 20.0f));
+		volumes[i] = Aabb(center - extent, center + extent);
+
+		I mode = rand() % 4;
+		if(mode == 0 || placed.empty())
+		{
+			// Place
+			placeables[i].m_userData = &placeables[i];
+			octree.place(volumes[i], &placeables[i]);
+			placed.push_back(i);
+		}
+		else if(mode == 1)
+		{
+			// Re-place
+			const U32 idx = placed[rand() % placed.size()];
+			volumes[idx] = volumes[i];
+			octree.place(volumes[idx], &placeables[idx]);
+		}
+		else if(mode == 2)
+		{
+			// Remove
+			octree.remove(placeables[placed.back()]);
+			placed.pop_back();
+		}
+		else
+		{
+			// Gather all
+			DynamicArrayAuto<void*> arr(alloc);
+			octree.gatherVisible(frustum, nullptr, nullptr, arr);
+			ANKI_TEST_EXPECT_EQ(arr.getSize(), placed.size());
+
+			DynamicArrayAuto<void*> arr2(alloc);
+			octree.gatherVisibleParallel(frustum, nullptr, nullptr, arr2, hive);
+			ANKI_TEST_EXPECT_EQ(arr2.getSize(), placed.size());
+
+			// Gather half. Everything that touches the half should be there
+			DynamicArrayAuto<void*> halfArr(alloc);
+			octree.gatherVisibleParallel(halfFrustum, nullptr, nullptr, halfArr, hive);
+			for(U32 idx : placed)
+			{
+				if(volumes[idx].getMax().x() <= 0.0f)
+				{
+					continue;
+				}
+
+				Bool found = false;
+				for(void* placeable : halfArr)
+				{
+					if(&placeables[idx] == static_cast<LooseOctreePlaceable*>(placeable))
+					{
+						found = true;
+						break;
+					}
+				}
+
+				ANKI_TEST_EXPECT_EQ(found, true);
+			}
+		}
+
+		ANKI_TEST_EXPECT_EQ(octree.getPlaceableCount(), placed.size());
+	}
+
+	// Remove all
+	while(!placed.empty())
+	{
+		octree.remove(placeables[placed.back()]);
+		placed.pop_back();
+	}
+}
+
+ANKI_TEST(Scene, LooseOctreeMultithreaded)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(8, alloc);
+
+	// A shallow tree so the threads place to the same nodes all the time
+	LooseOctree octree(alloc);
+	octree.init(Vec3(-100.0f), Vec3(100.0f), 1);
+
+	OrthographicFrustum frustum(-200.0f, 200.0f, -200.0f, 200.0f, 200.0f, -200.0f);
+	frustum.resetTransform(Transform::getIdentity());
+
+	const U32 COUNT = 4 * 1024;
+	Array<LooseOctreePlaceable, COUNT>* placeables = alloc.newInstance<Array<LooseOctreePlaceable, COUNT>>();
+	Array<Aabb, COUNT>* volumes = alloc.newInstance<Array<Aabb, COUNT>>();
+	std::vector<U8> visited(COUNT);
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		(*placeables)[i].m_userData = &(*placeables)[i];
+	}
+
+	for(U32 iteration = 0; iteration < 32; ++iteration)
+	{
+		for(Aabb& volume : *volumes)
+		{
+			const Vec3 center(randRange(-100.0f, 100.0f), randRange(-100.0f, 100.0f), randRange(-100.0f, 100.0f));
+			const Vec3 extent(randRange(0.1f, 60.0f), randRange(0.1f, 60.0f), randRange(0.1f, 60.0f));
+			volume = Aabb(center - extent, center + extent);
+		}
+
+		// Place, re-place and remove from many threads. The odd iterations remove every 4th placeable
+		const Bool removeSome = (iteration & 1) != 0;
+		Error err = parallelFor(hive, 0, COUNT, 8, [&](PtrSize begin, PtrSize end, U32) -> Error {
+			for(PtrSize i = begin; i < end; ++i)
+			{
+				LooseOctreePlaceable& placeable = (*placeables)[i];
+				if(removeSome && (i % 4) == 0)
+				{
+					if(placeable.isPlaced())
+					{
+						octree.remove(placeable);
+					}
+				}
+				else
+				{
+					octree.place((*volumes)[i], &placeable);
+				}
+			}
+			return Error::NONE;
+		});
+		ANKI_TEST_EXPECT_NO_ERR(err);
+
+		// Every placed placeable is in the tree once
+		const U32 placedCount = (removeSome) ? COUNT - COUNT / 4 : COUNT;
+		ANKI_TEST_EXPECT_EQ(octree.getPlaceableCount(), placedCount);
+
+		DynamicArrayAuto<void*> arr(alloc);
+		octree.gatherVisible(frustum, nullptr, nullptr, arr);
+		ANKI_TEST_EXPECT_EQ(arr.getSize(), placedCount);
+
+		std::fill(visited.begin(), visited.end(), 0);
+		for(void* placeable : arr)
+		{
+			const PtrSize idx = static_cast<LooseOctreePlaceable*>(placeable) - &(*placeables)[0];
+			ANKI_TEST_EXPECT_EQ(visited[idx], 0);
+			visited[idx] = 1;
+		}
+	}
+
+	for(LooseOctreePlaceable& placeable : *placeables)
+	{
+		if(placeable.isPlaced())
+		{
+			octree.remove(placeable);
+		}
+	}
+
+	alloc.deleteInstance(volumes);
+	alloc.deleteInstance(placeables);
+}
+
+/// Moves the volumes of the octree benchmark.
+class OctreeBenchVolumes
+{
+public:
+	static const U32 COUNT = 16 * 1024;
+
+	Array<Aabb, COUNT> m_volumes;
+
+	void randomize(F32 maxMove)
+	{
+		for(Aabb& volume : m_volumes)
+		{
+			if(maxMove == 0.0f)
+			{
+				const Vec4 center(randRange(-90.0f, 90.0f), randRange(-90.0f, 90.0f), randRange(-90.0f, 90.0f), 0.0f);
+				const Vec4 extent(randRange(0.2f, 2.0f), randRange(0.2f, 2.0f), randRange(0.2f, 2.0f), 0.0f);
+				volume = Aabb(center - extent, center + extent);
+			}
+			else
+			{
+				const Vec4 move(randRange(-maxMove, maxMove), randRange(-maxMove, maxMove), 0.0f, 0.0f);
+				volume = Aabb(volume.getMin() + move, volume.getMax() + move);
+			}
+		}
+	}
+};
+
+/// Run the same benchmark on both octrees.
+template<typename TOctree, typename TPlaceable, typename TGatherFunc>
+static void benchOctree(CString name,
+	TOctree& octree,
+	Array<TPlaceable, OctreeBenchVolumes::COUNT>& placeables,
+	OctreeBenchVolumes& volumes,
+	ThreadHive& hive,
+	TGatherFunc gatherFunc)
+{
+	const U FRAME_COUNT = 8;
+	const U32 COUNT = OctreeBenchVolumes::COUNT;
+
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		placeables[i].m_userData = &placeables[i];
+	}
+
+	// Place
+	volumes.randomize(0.0f);
+	Second begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		octree.place(volumes.m_volumes[i], &placeables[i]);
+	}
+	const Second placeTime = HighRezTimer::getCurrentTime() - begin;
+
+	// Move everything a bit and re-place it from many threads like the scene update does
+	Second replaceTime = 0.0;
+	Second gatherTime = 0.0;
+	for(U frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		volumes.randomize(0.5f);
+
+		begin = HighRezTimer::getCurrentTime();
+		Error err = parallelFor(hive, 0, COUNT, 0, [&](PtrSize begin, PtrSize end, U32) -> Error {
+			for(PtrSize i = begin; i < end; ++i)
+			{
+				octree.place(volumes.m_volumes[i], &placeables[i]);
+			}
+			return Error::NONE;
+		});
+		ANKI_TEST_EXPECT_NO_ERR(err);
+		replaceTime += HighRezTimer::getCurrentTime() - begin;
+
+		begin = HighRezTimer::getCurrentTime();
+		gatherFunc();
+		gatherTime += HighRezTimer::getCurrentTime() - begin;
+	}
+
+	// Remove
+	begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		octree.remove(placeables[i]);
+	}
+	const Second removeTime = HighRezTimer::getCurrentTime() - begin;
+
+	ANKI_TEST_LOGI("%s: %u volumes. Place %.3fms, re-place %.3fms/frame, gather %.3fms/frame, remove %.3fms",
+		&name[0],
+		COUNT,
+		placeTime * 1000.0,
+		replaceTime * 1000.0 / FRAME_COUNT,
+		gatherTime * 1000.0 / FRAME_COUNT,
+		removeTime * 1000.0);
+}
+
+ANKI_TEST(Scene, OctreeBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), alloc);
+
+	PerspectiveFrustum frustum(toRad(90.0f), toRad(60.0f), 0.1f, 150.0f);
+	frustum.resetTransform(Transform::getIdentity());
+
+	OctreeBenchVolumes* volumes = alloc.newInstance<OctreeBenchVolumes>();
+
+	{
+		Octree octree(alloc);
+		octree.init(Vec3(-100.0f), Vec3(100.0f), 5);
+		Array<OctreePlaceable, OctreeBenchVolumes::COUNT>* placeables =
+			alloc.newInstance<Array<OctreePlaceable, OctreeBenchVolumes::COUNT>>();
+
+		benchOctree(CString("Octree"), octree, *placeables, *volumes, hive, [&]() {
+			for(OctreePlaceable& placeable : *placeables)
+			{
+				placeable.reset();
+			}
+
+			DynamicArrayAuto<void*> arr(alloc);
+			octree.gatherVisible(frustum, 0, nullptr, nullptr, arr);
+		});
+
+		alloc.deleteInstance(placeables);
+	}
+
+	{
+		LooseOctree octree(alloc);
+		octree.init(Vec3(-100.0f), Vec3(100.0f), 5);
+		Array<LooseOctreePlaceable, OctreeBenchVolumes::COUNT>* placeables =
+			alloc.newInstance<Array<LooseOctreePlaceable, OctreeBenchVolumes::COUNT>>();
+
+		// Gather in one thread like the Octree and then with the hive
+		benchOctree(CString("LooseOctree"), octree, *placeables, *volumes, hive, [&]() {
+			DynamicArrayAuto<void*> arr(alloc);
+			octree.gatherVisible(frustum, nullptr, nullptr, arr);
+		});
+
+		benchOctree(CString("LooseOctree with parallel gather"), octree, *placeables, *volumes, hive, [&]() {
+			DynamicArrayAuto<void*> arr(alloc);
+			octree.gatherVisibleParallel(frustum, nullptr, nullptr, arr, hive);
+		});
+
+		alloc.deleteInstance(placeables);
+	}
+
+	alloc.deleteInstance(volumes);
+}
+
 } // end namespace anki
@@ -0,0 +1,74 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/VisibilityInternal.h>
+#include <anki/util/RadixSort.h>
+
+namespace anki
+{
+
+static void drawCallbackA(RenderQueueDrawContext&, ConstWeakArray<void*>)
+{
+}
+
+static void drawCallbackB(RenderQueueDrawContext&, ConstWeakArray<void*>)
+{
+}
+
+ANKI_TEST(Scene, RenderableSortKey)
+{
+	// Small sequential merge keys like the UUIDs of the models, in random depths and in two callbacks
+	const U MERGE_KEY_COUNT = 16;
+	const U ELEMENTS_PER_KEY = 8;
+	const U COUNT = MERGE_KEY_COUNT * ELEMENTS_PER_KEY * 2;
+
+	Array<RenderableQueueElement, COUNT> elements;
+	for(U i = 0; i < COUNT; ++i)
+	{
+		RenderableQueueElement& el = elements[i];
+		el.m_callback = (i & 1) ? drawCallbackA : drawCallbackB;
+		el.m_userData = nullptr;
+		el.m_mergeKey = (i / 2) % MERGE_KEY_COUNT + 1;
+		el.m_distanceFromCamera = randRange(0.0f, 1000.0f);
+		el.m_lod = 0;
+	}
+
+	Array<RenderableSortKey, COUNT> keys;
+	Array<RenderableSortKey, COUNT> tmpKeys;
+	for(U i = 0; i < COUNT; ++i)
+	{
+		keys[i].m_key = RenderableSortKey::compute(elements[i]);
+		keys[i].m_index = i;
+	}
+
+	radixSort(&keys[0], COUNT, &tmpKeys[0], [](const RenderableSortKey& k) { return k.m_key; });
+
+	// The elements that can merge are next to each other and front to back
+	for(U i = 0; i < COUNT; i += ELEMENTS_PER_KEY)
+	{
+		const RenderableQueueElement& first = elements[keys[i].m_index];
+
+		for(U j = i + 1; j < i + ELEMENTS_PER_KEY; ++j)
+		{
+			const RenderableQueueElement& el = elements[keys[j].m_index];
+			const RenderableQueueElement& prev = elements[keys[j - 1].m_index];
+
+			ANKI_TEST_EXPECT_EQ(el.m_mergeKey, first.m_mergeKey);
+			ANKI_TEST_EXPECT_EQ(el.m_callback, first.m_callback);
+			ANKI_TEST_EXPECT_LEQ(prev.m_distanceFromCamera, el.m_distanceFromCamera + 0.5f);
+		}
+	}
+
+	// The LOD is more significant than the merge key
+	RenderableQueueElement lod0 = elements[0];
+	RenderableQueueElement lod1 = elements[0];
+	lod1.m_lod = 1;
+	lod1.m_mergeKey = 1;
+	lod0.m_mergeKey = MERGE_KEY_COUNT;
+	ANKI_TEST_EXPECT_LT(RenderableSortKey::compute(lod0), RenderableSortKey::compute(lod1));
+}
+
+} // end namespace anki
@@ -0,0 +1,311 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/SceneGraph.h>
+#include <anki/scene/components/MoveComponent.h>
+#include <anki/scene/components/RenderComponent.h>
+#include <anki/scene/components/SpatialComponent.h>
+#include <anki/scene/components/SceneComponentPool.h>
+
+namespace anki
+{
+
+/// A component that keeps a copy of its pool data to compare.
+class PoolTestComponent
+{
+public:
+	U32 m_poolIndex = MAX_U32;
+	U32 m_value = 0;
+};
+
+class PoolTestData
+{
+public:
+	static const U32 CHUNK_SIZE = 4;
+
+	Array<U32, CHUNK_SIZE> m_values;
+
+	void copy(U32 dstIdx, const PoolTestData& src, U32 srcIdx)
+	{
+		m_values[dstIdx] = src.m_values[srcIdx];
+	}
+};
+
+using PoolTestPool = SceneComponentPool<PoolTestComponent, PoolTestData>;
+
+/// Check that the pool is dense and that every element points to the component that points back to it.
+static void checkPool(const PoolTestPool& pool, const PoolTestComponent* comps, U32 compCount)
+{
+	U32 aliveCount = 0;
+	for(U32 i = 0; i < compCount; ++i)
+	{
+		const PoolTestComponent& comp = comps[i];
+		if(comp.m_poolIndex == MAX_U32)
+		{
+			continue;
+		}
+
+		++aliveCount;
+		ANKI_TEST_EXPECT_LT(comp.m_poolIndex, pool.getCount());
+		const PoolTestPool::Chunk& chunk = pool.getChunk(comp.m_poolIndex);
+		ANKI_TEST_EXPECT_EQ(chunk.m_components[comp.m_poolIndex % PoolTestPool::CHUNK_SIZE], &comp);
+		ANKI_TEST_EXPECT_EQ(chunk.m_values[comp.m_poolIndex % PoolTestPool::CHUNK_SIZE], comp.m_value);
+	}
+
+	ANKI_TEST_EXPECT_EQ(pool.getCount(), aliveCount);
+	ANKI_TEST_EXPECT_EQ(pool.getChunkCount(), (aliveCount + PoolTestPool::CHUNK_SIZE - 1) / PoolTestPool::CHUNK_SIZE);
+
+	U32 count = 0;
+	for(U32 i = 0; i < pool.getChunkCount(); ++i)
+	{
+		const PoolTestPool::Chunk& chunk = pool.getChunkAt(i);
+		for(U32 j = 0; j < pool.getChunkElementCount(i); ++j)
+		{
+			ANKI_TEST_EXPECT_EQ(chunk.m_components[j]->m_poolIndex, i * PoolTestPool::CHUNK_SIZE + j);
+			++count;
+		}
+	}
+	ANKI_TEST_EXPECT_EQ(count, aliveCount);
+}
+
+ANKI_TEST(Scene, SceneComponentPool)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	PoolTestPool pool;
+
+	const U32 COMP_COUNT = 11;
+	Array<PoolTestComponent, COMP_COUNT> comps;
+
+	auto add = [&](U32 i) {
+		comps[i].m_value = i * 10 + 1;
+		comps[i].m_poolIndex = pool.add(alloc, &comps[i]);
+		pool.getChunk(comps[i].m_poolIndex).m_values[comps[i].m_poolIndex % PoolTestPool::CHUNK_SIZE] =
+			comps[i].m_value;
+	};
+
+	auto remove = [&](U32 i) {
+		pool.remove(comps[i].m_poolIndex);
+		comps[i].m_poolIndex = MAX_U32;
+	};
+
+	// Fill more than a couple of chunks
+	for(U32 i = 0; i < COMP_COUNT; ++i)
+	{
+		add(i);
+		ANKI_TEST_EXPECT_EQ(comps[i].m_poolIndex, i);
+	}
+	checkPool(pool, &comps[0], COMP_COUNT);
+
+	// Remove from the middle of a chunk. The last element moves to another chunk
+	remove(1);
+	checkPool(pool, &comps[0], COMP_COUNT);
+	ANKI_TEST_EXPECT_EQ(comps[COMP_COUNT - 1].m_poolIndex, 1);
+
+	// Remove the first and the last
+	remove(0);
+	checkPool(pool, &comps[0], COMP_COUNT);
+	remove(COMP_COUNT - 2);
+	checkPool(pool, &comps[0], COMP_COUNT);
+
+	// Update the data through the indices of the components that moved
+	for(PoolTestComponent& comp : comps)
+	{
+		if(comp.m_poolIndex != MAX_U32)
+		{
+			comp.m_value += 1000;
+			pool.getChunk(comp.m_poolIndex).m_values[comp.m_poolIndex % PoolTestPool::CHUNK_SIZE] = comp.m_value;
+		}
+	}
+	checkPool(pool, &comps[0], COMP_COUNT);
+
+	// Re-add. The storage stays dense
+	add(0);
+	add(1);
+	checkPool(pool, &comps[0], COMP_COUNT);
+
+	// Empty it
+	for(U32 i = 0; i < COMP_COUNT; ++i)
+	{
+		if(comps[i].m_poolIndex != MAX_U32)
+		{
+			remove(i);
+			checkPool(pool, &comps[0], COMP_COUNT);
+		}
+	}
+	ANKI_TEST_EXPECT_EQ(pool.getCount(), 0);
+	ANKI_TEST_EXPECT_EQ(pool.getChunkCount(), 0);
+
+	// Reuse the chunks
+	add(5);
+	ANKI_TEST_EXPECT_EQ(comps[5].m_poolIndex, 0);
+	checkPool(pool, &comps[0], COMP_COUNT);
+	remove(5);
+
+	pool.destroy(alloc);
+}
+
+/// A node with a sphere and an AABB spatial.
+class ComponentPoolTestNode : public SceneNode
+{
+public:
+	Sphere m_sphere;
+	Aabb m_aabb;
+
+	ComponentPoolTestNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init(const Vec3& center)
+	{
+		newComponent<MoveComponent>();
+		newComponent<SpatialComponent>(&m_sphere);
+		newComponent<SpatialComponent>(&m_aabb);
+		moveTo(center);
+		return Error::NONE;
+	}
+
+	void moveTo(const Vec3& center)
+	{
+		m_sphere = Sphere(center.xyz0(), 0.5f);
+		m_aabb = Aabb((center - Vec3(1.0f)).xyz0(), (center + Vec3(1.0f)).xyz0());
+
+		Error err = iterateComponentsOfType<SpatialComponent>([&](SpatialComponent& sp) {
+			sp.setSpatialOrigin(center.xyz0());
+			sp.markForUpdate();
+			return Error::NONE;
+		});
+		(void)err;
+	}
+};
+
+class ComponentPoolTestContext : public EngineTestContext
+{
+public:
+	static const U NODE_COUNT = 300; ///< With 2 spatials each they span a few chunks.
+
+	Array<ComponentPoolTestNode*, NODE_COUNT> m_nodes; ///< nullptr for the deleted.
+
+	ComponentPoolTestContext()
+	{
+		initScene();
+
+		for(U i = 0; i < NODE_COUNT; ++i)
+		{
+			newNode(i);
+		}
+	}
+
+	void newNode(U i)
+	{
+		StringAuto name(HeapAllocator<U8>(allocAligned, nullptr));
+		name.sprintf("node%u_%llu", U32(i), m_globalTimestamp);
+		ANKI_TEST_EXPECT_NO_ERR(m_scene->newSceneNode<ComponentPoolTestNode>(
+			name.toCString(), m_nodes[i], Vec3(F32(i), F32(i % 7), -F32(i % 13))));
+	}
+
+	/// Check that the SpatialComponentPool holds the same data as the components.
+	void checkSpatialPool() const
+	{
+		const SpatialComponentPool& pool = m_scene->getSceneComponentLists().getSpatialComponentPool();
+
+		U32 spatialCount = 0;
+		for(const ComponentPoolTestNode* node : m_nodes)
+		{
+			if(!node)
+			{
+				continue;
+			}
+
+			Error err = node->iterateComponentsOfType<SpatialComponent>([&](const SpatialComponent& sp) {
+				const U32 idx = sp.getPoolIndex();
+				ANKI_TEST_EXPECT_LT(idx, pool.getCount());
+
+				const SpatialComponentPool::Chunk& chunk = pool.getChunk(idx);
+				const U32 i = idx % SpatialComponentPool::CHUNK_SIZE;
+				ANKI_TEST_EXPECT_EQ(chunk.m_components[i], &sp);
+				ANKI_TEST_EXPECT_EQ(chunk.m_aabbMins[i], sp.getAabb().getMin());
+				ANKI_TEST_EXPECT_EQ(chunk.m_aabbMaxs[i], sp.getAabb().getMax());
+				ANKI_TEST_EXPECT_EQ(chunk.m_shapeTypes[i], sp.getSpatialCollisionShape().getType());
+
+				++spatialCount;
+				return Error::NONE;
+			});
+			ANKI_TEST_EXPECT_NO_ERR(err);
+		}
+
+		ANKI_TEST_EXPECT_EQ(pool.getCount(), spatialCount);
+	}
+};
+
+ANKI_TEST(Scene, SceneComponentPoolSpatials)
+{
+	ComponentPoolTestContext ctx;
+	const U NODE_COUNT = ComponentPoolTestContext::NODE_COUNT;
+	const SpatialComponentPool& pool = ctx.m_scene->getSceneComponentLists().getSpatialComponentPool();
+
+	// Lookup by type. The last component of a type is returned and the missing types return nothing
+	{
+		ComponentPoolTestNode& node = *ctx.m_nodes[0];
+		ANKI_TEST_EXPECT_EQ(node.getComponentCount(), 3);
+		ANKI_TEST_EXPECT_EQ(node.tryGetComponent<MoveComponent>(), &node.getComponentAt<MoveComponent>(0));
+		ANKI_TEST_EXPECT_EQ(node.tryGetComponent<SpatialComponent>(), &node.getComponentAt<SpatialComponent>(2));
+		ANKI_TEST_EXPECT_EQ(node.tryGetComponent<RenderComponent>(), nullptr);
+		ANKI_TEST_EXPECT_EQ(
+			node.tryGetComponent<SpatialComponent>()->getSpatialCollisionShape().getType(), CollisionShapeType::AABB);
+	}
+
+	// The first update fills the AABBs
+	ctx.updateScene();
+	ANKI_TEST_EXPECT_EQ(pool.getCount(), NODE_COUNT * 2);
+	ANKI_TEST_EXPECT_GT(pool.getChunkCount(), 2);
+	ctx.checkSpatialPool();
+
+	// Delete some nodes. The storage stays dense and the moved elements are still found by their components
+	for(U i = 0; i < NODE_COUNT; i += 3)
+	{
+		ctx.m_nodes[i]->setMarkedForDeletion();
+		ctx.m_nodes[i] = nullptr;
+	}
+	ctx.updateScene();
+	ANKI_TEST_EXPECT_EQ(pool.getCount(), (NODE_COUNT - (NODE_COUNT + 2) / 3) * 2);
+	ctx.checkSpatialPool();
+
+	// Move some nodes. Their data change through the indices they got after the removal
+	const Timestamp moveTimestamp = ctx.m_globalTimestamp + 1;
+	for(U i = 1; i < NODE_COUNT; i += 5)
+	{
+		if(ctx.m_nodes[i])
+		{
+			ctx.m_nodes[i]->moveTo(Vec3(-F32(i), 10.0f, 3.0f));
+		}
+	}
+	ctx.updateScene();
+	ctx.checkSpatialPool();
+
+	for(U i = 0; i < NODE_COUNT; ++i)
+	{
+		if(ctx.m_nodes[i])
+		{
+			const Timestamp expectedTimestamp = (i % 5 == 1) ? moveTimestamp : 2;
+			const SpatialComponent& sp = *ctx.m_nodes[i]->tryGetComponent<SpatialComponent>();
+			ANKI_TEST_EXPECT_EQ(
+				pool.getChunk(sp.getPoolIndex()).m_timestamps[sp.getPoolIndex() % SpatialComponentPool::CHUNK_SIZE],
+				expectedTimestamp);
+		}
+	}
+
+	// Add nodes back
+	for(U i = 0; i < NODE_COUNT; i += 3)
+	{
+		ctx.newNode(i);
+	}
+	ctx.updateScene();
+	ANKI_TEST_EXPECT_EQ(pool.getCount(), NODE_COUNT * 2);
+	ctx.checkSpatialPool();
+}
+
+} // end namespace anki
@@ -0,0 +1,197 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/SoftwareRasterizer.h>
+#include <anki/collision/Aabb.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/System.h>
+
+namespace anki
+{
+
+const U32 RASTERIZER_WIDTH = 250;
+const U32 RASTERIZER_HEIGHT = 130;
+
+static Mat4 createRasterizerProjection()
+{
+	return Mat4::calculatePerspectiveProjectionMatrix(toRad(60.0f), toRad(35.0f), 0.1f, 100.0f);
+}
+
+/// Random triangles in front of the camera.
+static void createRandomTriangles(U32 triangleCount, DynamicArrayAuto<Vec3>& verts)
+{
+	verts.create(triangleCount * 3);
+	for(U32 i = 0; i < triangleCount; ++i)
+	{
+		const Vec3 center(randRange(-40.0f, 40.0f), randRange(-20.0f, 20.0f), randRange(-80.0f, -1.0f));
+		for(U32 j = 0; j < 3; ++j)
+		{
+			verts[i * 3 + j] = center + Vec3(randRange(-5.0f, 5.0f), randRange(-5.0f, 5.0f), randRange(-2.0f, 2.0f));
+		}
+	}
+}
+
+ANKI_TEST(Scene, SoftwareRasterizer)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const Mat4 proj = createRasterizerProjection();
+
+	// Occlusion
+	{
+		SoftwareRasterizer r;
+		r.init(alloc);
+		r.prepare(Mat4::getIdentity(), proj, RASTERIZER_WIDTH, RASTERIZER_HEIGHT);
+
+		// A quad that faces the camera
+		const Array<Vec3, 6> quad = {{Vec3(-5.0f, -5.0f, -10.0f),
+			Vec3(5.0f, -5.0f, -10.0f),
+			Vec3(5.0f, 5.0f, -10.0f),
+			Vec3(5.0f, 5.0f, -10.0f),
+			Vec3(-5.0f, 5.0f, -10.0f),
+			Vec3(-5.0f, -5.0f, -10.0f)}};
+		r.draw(&quad[0][0], quad.getSize(), sizeof(Vec3), true);
+		r.binTriangles();
+		r.rasterizeTiles(0, r.getTileCount());
+
+		// The depth of the quad
+		const Vec4 quadClip = proj * Vec4(0.0f, 0.0f, -10.0f, 1.0f);
+		const F32 quadDepth = quadClip.z() / quadClip.w();
+		ANKI_TEST_EXPECT_NEAR(r.getDepth(RASTERIZER_WIDTH / 2, RASTERIZER_HEIGHT / 2), quadDepth, 1.0e-5f);
+		ANKI_TEST_EXPECT_EQ(r.getDepth(0, 0), 1.0f);
+
+		// Behind the quad
+		Aabb box(Vec4(-1.0f, -1.0f, -30.0f, 0.0f), Vec4(1.0f, 1.0f, -20.0f, 0.0f));
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(box, box), false);
+
+		// In front of the quad
+		box = Aabb(Vec4(-1.0f, -1.0f, -5.0f, 0.0f), Vec4(1.0f, 1.0f, -4.0f, 0.0f));
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(box, box), true);
+
+		// Behind but it sticks out of the quad's side
+		box = Aabb(Vec4(9.0f, -1.0f, -22.0f, 0.0f), Vec4(11.0f, 1.0f, -20.0f, 0.0f));
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(box, box), true);
+
+		// Touches the near plane
+		box = Aabb(Vec4(-1.0f, -1.0f, -1.0f, 0.0f), Vec4(1.0f, 1.0f, 1.0f, 0.0f));
+		ANKI_TEST_EXPECT_EQ(r.visibilityTest(box, box), true);
+	}
+
+	// Serial and threaded rasterization should produce the same depth
+	{
+		DynamicArrayAuto<Vec3> verts(alloc);
+		createRandomTriangles(512, verts);
+
+		SoftwareRasterizer serial;
+		serial.init(alloc);
+		serial.prepare(Mat4::getIdentity(), proj, RASTERIZER_WIDTH, RASTERIZER_HEIGHT);
+		serial.draw(&verts[0][0], verts.getSize(), sizeof(Vec3), false);
+		serial.binTriangles();
+		serial.rasterizeTiles(0, serial.getTileCount());
+
+		ThreadHive hive(4, alloc);
+		SoftwareRasterizer threaded;
+		threaded.init(alloc);
+		threaded.prepare(Mat4::getIdentity(), proj, RASTERIZER_WIDTH, RASTERIZER_HEIGHT);
+
+		// Draw from many threads too
+		class DrawArgs
+		{
+		public:
+			SoftwareRasterizer* m_r;
+			const Vec3* m_verts;
+			U32 m_vertCount;
+		};
+
+		const U32 DRAW_COUNT = 8;
+		Array<DrawArgs, DRAW_COUNT> drawArgs;
+		Array<ThreadHiveTask, DRAW_COUNT> tasks;
+		for(U32 i = 0; i < DRAW_COUNT; ++i)
+		{
+			drawArgs[i].m_r = &threaded;
+			drawArgs[i].m_vertCount = verts.getSize() / DRAW_COUNT;
+			drawArgs[i].m_verts = &verts[i * drawArgs[i].m_vertCount];
+
+			tasks[i].m_callback = [](void* ud, U32, ThreadHive&, ThreadHiveSemaphore*) {
+				const DrawArgs& args = *static_cast<const DrawArgs*>(ud);
+				args.m_r->draw(&args.m_verts[0][0], args.m_vertCount, sizeof(Vec3), false);
+			};
+			tasks[i].m_argument = &drawArgs[i];
+		}
+		hive.submitTasks(&tasks[0], DRAW_COUNT);
+		hive.waitAllTasks();
+
+		ANKI_TEST_EXPECT_NO_ERR(threaded.rasterize(hive));
+
+		U32 coveredCount = 0;
+		for(U32 y = 0; y < RASTERIZER_HEIGHT; ++y)
+		{
+			for(U32 x = 0; x < RASTERIZER_WIDTH; ++x)
+			{
+				ANKI_TEST_EXPECT_EQ(serial.getDepth(x, y), threaded.getDepth(x, y));
+				coveredCount += serial.getDepth(x, y) < 1.0f;
+			}
+		}
+
+		// Sanity check the test data
+		ANKI_TEST_EXPECT_GT(coveredCount, 0);
+	}
+}
+
+ANKI_TEST(Scene, SoftwareRasterizerBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), alloc);
+	const Mat4 proj = createRasterizerProjection();
+
+	const U32 TRIANGLE_COUNT = 10 * 1024;
+	const U32 ITERATIONS = 16;
+	DynamicArrayAuto<Vec3> verts(alloc);
+	createRandomTriangles(TRIANGLE_COUNT, verts);
+
+	SoftwareRasterizer r;
+	r.init(alloc);
+
+	Second serialTime = 0.0;
+	Second threadedTime = 0.0;
+	for(U32 it = 0; it < ITERATIONS; ++it)
+	{
+		Second begin = HighRezTimer::getCurrentTime();
+		r.prepare(Mat4::getIdentity(), proj, RASTERIZER_WIDTH, RASTERIZER_HEIGHT);
+		r.draw(&verts[0][0], verts.getSize(), sizeof(Vec3), false);
+		r.binTriangles();
+		r.rasterizeTiles(0, r.getTileCount());
+		serialTime += HighRezTimer::getCurrentTime() - begin;
+
+		begin = HighRezTimer::getCurrentTime();
+		r.prepare(Mat4::getIdentity(), proj, RASTERIZER_WIDTH, RASTERIZER_HEIGHT);
+		r.draw(&verts[0][0], verts.getSize(), sizeof(Vec3), false);
+		ANKI_TEST_EXPECT_NO_ERR(r.rasterize(hive));
+		threadedTime += HighRezTimer::getCurrentTime() - begin;
+	}
+
+	// Test many boxes
+	const U32 BOX_COUNT = 4 * 1024;
+	U32 visibleCount = 0;
+	Second begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < BOX_COUNT; ++i)
+	{
+		const Vec4 center(randRange(-40.0f, 40.0f), randRange(-20.0f, 20.0f), randRange(-90.0f, -5.0f), 0.0f);
+		const Aabb box(center - Vec4(1.0f, 1.0f, 1.0f, 0.0f), center + Vec4(1.0f, 1.0f, 1.0f, 0.0f));
+		visibleCount += r.visibilityTest(box, box);
+	}
+	const Second testTime = HighRezTimer::getCurrentTime() - begin;
+
+	ANKI_TEST_LOGI("Rasterizing %u triangles: serial %.3fms, threaded %.3fms. Testing %u boxes %.3fms (%u visible)",
+		TRIANGLE_COUNT,
+		serialTime / ITERATIONS * 1000.0,
+		threadedTime / ITERATIONS * 1000.0,
+		BOX_COUNT,
+		testTime * 1000.0,
+		visibleCount);
+}
+
+} // end namespace anki
@@ -0,0 +1,189 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/SceneGraph.h>
+#include <anki/scene/CameraNode.h>
+#include <anki/scene/components/FrustumComponent.h>
+#include <anki/scene/components/MoveComponent.h>
+#include <anki/scene/components/RenderComponent.h>
+#include <anki/scene/components/SpatialComponent.h>
+
+namespace anki
+{
+
+/// A shadow caster with an AABB spatial.
+class VisibilityCacheTestNode : public SceneNode
+{
+public:
+	class MyRenderComponent : public RenderComponent
+	{
+	public:
+		U64 m_mergeKey = 1;
+
+		MyRenderComponent(SceneNode* node)
+			: RenderComponent(node)
+		{
+			m_castsShadow = true;
+		}
+
+		void setupRenderableQueueElement(RenderableQueueElement& el) const override
+		{
+			el.m_callback = drawCallback;
+			el.m_mergeKey = m_mergeKey;
+			el.m_userData = this;
+		}
+
+		static void drawCallback(RenderQueueDrawContext& ctx, ConstWeakArray<void*> userData)
+		{
+		}
+	};
+
+	Aabb m_aabb;
+
+	VisibilityCacheTestNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init(const Vec3& center)
+	{
+		newComponent<MyRenderComponent>();
+		newComponent<SpatialComponent>(&m_aabb);
+		moveTo(center);
+		return Error::NONE;
+	}
+
+	void moveTo(const Vec3& center)
+	{
+		m_aabb = Aabb((center - Vec3(0.5f)).xyz0(), (center + Vec3(0.5f)).xyz0());
+
+		SpatialComponent& sp = getComponent<SpatialComponent>();
+		sp.setSpatialOrigin(center.xyz0());
+		sp.markForUpdate();
+	}
+
+	MyRenderComponent& getRenderComponent()
+	{
+		return static_cast<MyRenderComponent&>(getComponent<RenderComponent>());
+	}
+};
+
+class VisibilityCacheTestContext : public EngineTestContext
+{
+public:
+	static const U NODE_COUNT = 8;
+
+	PerspectiveCameraNode* m_cam = nullptr;
+	Array<VisibilityCacheTestNode*, NODE_COUNT> m_nodes;
+
+	VisibilityCacheTestContext()
+	{
+		initScene();
+
+		// A camera that gathers only shadow casters, like the light frustums. It looks down -Z
+		ANKI_TEST_EXPECT_NO_ERR(m_scene->newSceneNode<PerspectiveCameraNode>("cam", m_cam));
+		m_cam->setAll(toRad(60.0f), toRad(60.0f), 0.1f, 100.0f);
+		m_cam->getComponent<FrustumComponent>().setEnabledVisibilityTests(
+			FrustumComponentVisibilityTestFlag::SHADOW_CASTERS);
+		m_scene->setActiveCameraNode(m_cam);
+
+		// A row of casters in front of the camera
+		HeapAllocator<U8> alloc(allocAligned, nullptr);
+		for(U i = 0; i < NODE_COUNT; ++i)
+		{
+			StringAuto name(alloc);
+			name.sprintf("caster%u", U32(i));
+			ANKI_TEST_EXPECT_NO_ERR(m_scene->newSceneNode<VisibilityCacheTestNode>(
+				name.toCString(), m_nodes[i], Vec3(F32(i) - F32(NODE_COUNT) / 2.0f, 0.0f, -10.0f)));
+		}
+	}
+
+	/// Update the scene and run the visibility tests.
+	/// @param[out] mergeKeySum The sum of the merge keys of the visible renderables.
+	/// @return The number of visible renderables.
+	U32 runFrame(U64& mergeKeySum)
+	{
+		updateScene();
+
+		RenderQueue rqueue;
+		m_scene->doVisibilityTests(rqueue);
+
+		mergeKeySum = 0;
+		for(const RenderableQueueElement& el : rqueue.m_renderables)
+		{
+			mergeKeySum += el.m_mergeKey;
+		}
+
+		return rqueue.m_renderables.getSize();
+	}
+
+	U32 getReusedEntryCount() const
+	{
+		return m_cam->getComponent<FrustumComponent>().getVisibilityCache().m_reusedEntryCount;
+	}
+};
+
+ANKI_TEST(Scene, VisibilityCache)
+{
+	VisibilityCacheTestContext ctx;
+	const U32 NODE_COUNT = VisibilityCacheTestContext::NODE_COUNT;
+	U64 mergeKeySum;
+
+	// The first tests fill the cache
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), 0);
+	ANKI_TEST_EXPECT_EQ(mergeKeySum, NODE_COUNT);
+
+	// Nothing changed. All come from the cache
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT);
+
+	// A spatial moves. Only that one is tested again
+	ctx.m_nodes[0]->moveTo(Vec3(0.0f, 1.0f, -12.0f));
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT - 1);
+
+	// It moves out of the frustum
+	ctx.m_nodes[0]->moveTo(Vec3(0.0f, 0.0f, 10.0f));
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT - 1);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT - 1);
+
+	// And back in
+	ctx.m_nodes[0]->moveTo(Vec3(0.0f, 0.0f, -10.0f));
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT - 1);
+
+	// The frustum moves. Nothing is reused
+	ctx.m_cam->getComponent<MoveComponent>().setLocalOrigin(Vec4(0.0f, 0.0f, 1.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), 0);
+
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT);
+
+	// A non-spatial change. The renderable changes without the spatial moving. It's not taken from the cache
+	ctx.m_nodes[1]->getRenderComponent().m_mergeKey = 100;
+	ctx.m_nodes[1]->getRenderComponent().markForUpdate();
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT - 1);
+	ANKI_TEST_EXPECT_EQ(mergeKeySum, NODE_COUNT - 1 + 100);
+
+	// A caster stops casting shadows
+	ctx.m_nodes[2]->getRenderComponent().setCastsShadow(false);
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT - 1);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT - 1);
+
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT - 1);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT - 1);
+
+	// And starts again. It wasn't in the cache but it's found
+	ctx.m_nodes[2]->getRenderComponent().setCastsShadow(true);
+	ANKI_TEST_EXPECT_EQ(ctx.runFrame(mergeKeySum), NODE_COUNT);
+	ANKI_TEST_EXPECT_EQ(ctx.getReusedEntryCount(), NODE_COUNT - 1);
+	ANKI_TEST_EXPECT_EQ(mergeKeySum, NODE_COUNT - 1 + 100);
+}
+
+} // end namespace anki
@@ -6,6 +6,7 @@
 #include <tests/framework/Framework.h>
 #include <anki/util/INotify.h>
 #include <anki/util/Filesystem.h>
+#include <anki/util/File.h>
 
 ANKI_TEST(Util, INotify)
 {
@@ -36,4 +37,45 @@ ANKI_TEST(Util, INotify)
 
 		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir));
 	}
+
+	// Monitor many dirs and get the files that changed
+	{
+		CString dirA = "in_test_dir_a";
+		CString dirB = "in_test_dir_b";
+
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory(dirA));
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory(dirB));
+
+		{
+			INotify in;
+			ANKI_TEST_EXPECT_NO_ERR(in.init(alloc));
+			ANKI_TEST_EXPECT_NO_ERR(in.addPath(dirA));
+			ANKI_TEST_EXPECT_NO_ERR(in.addPath(dirB));
+
+			StringListAuto files(alloc);
+			ANKI_TEST_EXPECT_NO_ERR(in.pollEvents(files));
+			ANKI_TEST_EXPECT_EQ(files.getSize(), 0);
+
+			for(CString fname : {"in_test_dir_a/a.txt", "in_test_dir_b/b.txt"})
+			{
+				File file;
+				ANKI_TEST_EXPECT_NO_ERR(file.open(fname, FileOpenFlag::WRITE));
+				ANKI_TEST_EXPECT_NO_ERR(file.writeText("blah"));
+				file.close();
+			}
+
+			ANKI_TEST_EXPECT_NO_ERR(in.pollEvents(files));
+			ANKI_TEST_EXPECT_EQ(files.getSize(), 2);
+			ANKI_TEST_EXPECT_EQ(files.getFront(), "in_test_dir_a/a.txt");
+			ANKI_TEST_EXPECT_EQ(files.getBack(), "in_test_dir_b/b.txt");
+
+			// Nothing new
+			files.destroy();
+			ANKI_TEST_EXPECT_NO_ERR(in.pollEvents(files));
+			ANKI_TEST_EXPECT_EQ(files.getSize(), 0);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dirA));
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dirB));
+	}
 }
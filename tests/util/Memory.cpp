@@ -7,6 +7,7 @@
 #include "tests/util/Foo.h"
 #include "anki/util/Memory.h"
 #include "anki/util/ThreadPool.h"
+#include "anki/util/HighRezTimer.h"
 #include <type_traits>
 #include <cstring>
 
@@ -168,6 +169,80 @@ ANKI_TEST(Util, StackMemoryPool)
 			}
 		}
 	}
+
+	// Parallel with per-thread arenas. More threads than arenas so some share
+	{
+		StackMemoryPool pool;
+		const U THREAD_COUNT = 32;
+		const U ARENA_THREAD_COUNT = 8;
+		const U ALLOC_SIZE = 25;
+		const U ALLOC_COUNT = 0xF;
+		ThreadPool threadPool(THREAD_COUNT);
+
+		class AllocateTask : public ThreadPoolTask
+		{
+		public:
+			StackMemoryPool* m_pool = nullptr;
+			Array<void*, ALLOC_COUNT> m_allocations;
+
+			Error operator()(U32 taskId, PtrSize threadsCount)
+			{
+				for(U i = 0; i < m_allocations.getSize(); ++i)
+				{
+					void* ptr = m_pool->allocate(ALLOC_SIZE, 1);
+					memset(ptr, (taskId << 4) | i, ALLOC_SIZE);
+					m_allocations[i] = ptr;
+				}
+
+				return Error::NONE;
+			}
+		};
+
+		pool.create(allocAligned, nullptr, 100, 1.0, 0, true, ANKI_SAFE_ALIGNMENT, ARENA_THREAD_COUNT);
+		ANKI_TEST_EXPECT_EQ(pool.getArenaCount(), ARENA_THREAD_COUNT + 1);
+		Array<AllocateTask, THREAD_COUNT> tasks;
+
+		for(U iteration = 0; iteration < 2; ++iteration)
+		{
+			for(U i = 0; i < THREAD_COUNT; ++i)
+			{
+				tasks[i].m_pool = &pool;
+				threadPool.assignNewTask(i, &tasks[i]);
+			}
+
+			ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+
+			// Check
+			for(U i = 0; i < THREAD_COUNT; ++i)
+			{
+				const auto& task = tasks[i];
+
+				for(U j = 0; j < task.m_allocations.getSize(); ++j)
+				{
+					U8 magic = (i << 4) | j;
+					U8* ptr = static_cast<U8*>(task.m_allocations[j]);
+
+					for(U k = 0; k < ALLOC_SIZE; ++k)
+					{
+						ANKI_TEST_EXPECT_EQ(ptr[k], magic);
+					}
+				}
+			}
+
+			pool.reset();
+		}
+
+		// All arenas were used and together they hold at least all the allocations
+		PtrSize highWaterMarkSum = 0;
+		for(U32 i = 0; i < pool.getArenaCount(); ++i)
+		{
+			ANKI_TEST_EXPECT_GT(pool.getArenaHighWaterMark(i), 0);
+			highWaterMarkSum += pool.getArenaHighWaterMark(i);
+		}
+
+		ANKI_TEST_EXPECT_GEQ(
+			highWaterMarkSum, THREAD_COUNT * ALLOC_COUNT * getAlignedRoundUp(ANKI_SAFE_ALIGNMENT, ALLOC_SIZE));
+	}
 }
 
 ANKI_TEST(Util, ChainMemoryPool)
@@ -218,3 +293,211 @@ ANKI_TEST(Util, ChainMemoryPool)
 		ANKI_TEST_EXPECT_EQ(pool.getChunksCount(), 0);
 	}
 }
+
+/// Allocates and frees random sizes from a pool. Part of the memory is freed by the next task to test frees from
+/// other threads.
+class MemoryChurnTask : public ThreadPoolTask
+{
+public:
+	static const U SLOT_COUNT = 256;
+
+	BaseMemoryPool* m_pool = nullptr;
+	U32 m_iterationCount = 0;
+	PtrSize m_maxSize = 0;
+	Array<void*, SLOT_COUNT> m_slots = {};
+	Array<PtrSize, SLOT_COUNT> m_sizes = {};
+	Bool8 m_corrupted = false;
+
+	Error operator()(U32 taskId, PtrSize threadsCount)
+	{
+		U32 seed = taskId * 7919 + 1;
+		for(U32 i = 0; i < m_iterationCount; ++i)
+		{
+			// Xorshift
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+
+			const U slot = seed % SLOT_COUNT;
+			if(m_slots[slot])
+			{
+				U8* mem = static_cast<U8*>(m_slots[slot]);
+				m_corrupted = m_corrupted || mem[0] != U8(slot) || mem[m_sizes[slot] - 1] != U8(slot);
+				m_pool->free(mem);
+				m_slots[slot] = nullptr;
+			}
+			else
+			{
+				// Mostly small sizes
+				const PtrSize size = ((seed >> 8) % 8 == 0) ? (seed >> 12) % m_maxSize + 1 : (seed >> 12) % 128 + 1;
+				U8* mem = static_cast<U8*>(m_pool->allocate(size, 8));
+				mem[0] = mem[size - 1] = U8(slot);
+				m_slots[slot] = mem;
+				m_sizes[slot] = size;
+			}
+		}
+
+		return Error::NONE;
+	}
+
+	void freeAll()
+	{
+		for(void*& mem : m_slots)
+		{
+			if(mem)
+			{
+				m_pool->free(mem);
+				mem = nullptr;
+			}
+		}
+	}
+};
+
+ANKI_TEST(Util, ThreadCachingMemoryPool)
+{
+	// Size classes
+	{
+		for(PtrSize size = 1; size <= ThreadCachingMemoryPool::MAX_SMALL_SIZE; ++size)
+		{
+			const U32 sizeClass = ThreadCachingMemoryPool::computeSizeClass(size);
+			ANKI_TEST_EXPECT_LT(sizeClass, ThreadCachingMemoryPool::SIZE_CLASS_COUNT);
+			ANKI_TEST_EXPECT_GEQ(ThreadCachingMemoryPool::getSizeClassSize(sizeClass), size);
+		}
+
+		ANKI_TEST_EXPECT_EQ(ThreadCachingMemoryPool::computeSizeClass(16), 0);
+		ANKI_TEST_EXPECT_EQ(ThreadCachingMemoryPool::computeSizeClass(17), 1);
+		ANKI_TEST_EXPECT_EQ(ThreadCachingMemoryPool::computeSizeClass(ThreadCachingMemoryPool::MAX_SMALL_SIZE),
+			ThreadCachingMemoryPool::SIZE_CLASS_COUNT - 1);
+	}
+
+	// Small, big and aligned allocations
+	{
+		ThreadCachingMemoryPool pool;
+		pool.create(allocAligned, nullptr);
+
+		void* a = pool.allocate(10, 8);
+		void* b = pool.allocate(10, 8);
+		void* c = pool.allocate(4000, 16);
+		void* d = pool.allocate(32, 64);
+		ANKI_TEST_EXPECT_NEQ(a, nullptr);
+		ANKI_TEST_EXPECT_NEQ(b, nullptr);
+		ANKI_TEST_EXPECT_NEQ(a, b);
+		ANKI_TEST_EXPECT_NEQ(c, nullptr);
+		ANKI_TEST_EXPECT_EQ(isAligned(16, a), true);
+		ANKI_TEST_EXPECT_EQ(isAligned(64, d), true);
+		ANKI_TEST_EXPECT_EQ(pool.getAllocationsCount(), 4);
+
+		memset(c, 0xFF, 4000);
+		pool.free(a);
+		pool.free(c);
+		pool.free(d);
+		ANKI_TEST_EXPECT_EQ(pool.getAllocationsCount(), 1);
+
+		// The last freed is reused
+		void* e = pool.allocate(16, 16);
+		ANKI_TEST_EXPECT_EQ(e, a);
+		pool.free(e);
+		pool.free(b);
+		ANKI_TEST_EXPECT_EQ(pool.getAllocationsCount(), 0);
+	}
+
+	// Through the allocator and the base pool
+	{
+		ThreadCachingAllocator<U8> alloc(allocAligned, nullptr);
+		BaseMemoryPool& pool = alloc.getMemoryPool();
+
+		U32* arr = alloc.newArray<U32>(100);
+		ANKI_TEST_EXPECT_EQ(pool.getAllocationsCount(), 1);
+		alloc.deleteArray(arr, 100);
+		ANKI_TEST_EXPECT_EQ(pool.getAllocationsCount(), 0);
+	}
+
+	// Parallel with more threads than caches. Every task frees the memory of the previous one
+	{
+		const U THREAD_COUNT = 8;
+		ThreadPool threadPool(THREAD_COUNT);
+		ThreadCachingMemoryPool pool;
+		pool.create(allocAligned, nullptr, THREAD_COUNT / 2);
+
+		Array<MemoryChurnTask, THREAD_COUNT> tasks;
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			tasks[i].m_pool = &pool;
+			tasks[i].m_iterationCount = 10000;
+			tasks[i].m_maxSize = 2000;
+			threadPool.assignNewTask(i, &tasks[i]);
+		}
+		ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+
+		const Array<void*, MemoryChurnTask::SLOT_COUNT> firstSlots = tasks[0].m_slots;
+		const Array<PtrSize, MemoryChurnTask::SLOT_COUNT> firstSizes = tasks[0].m_sizes;
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(tasks[i].m_corrupted, false);
+			tasks[i].m_slots = (i + 1 < THREAD_COUNT) ? tasks[i + 1].m_slots : firstSlots;
+			tasks[i].m_sizes = (i + 1 < THREAD_COUNT) ? tasks[i + 1].m_sizes : firstSizes;
+		}
+
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			threadPool.assignNewTask(i, &tasks[i]);
+		}
+		ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+
+		for(MemoryChurnTask& task : tasks)
+		{
+			ANKI_TEST_EXPECT_EQ(task.m_corrupted, false);
+			task.freeAll();
+		}
+
+		ANKI_TEST_EXPECT_EQ(pool.getAllocationsCount(), 0);
+	}
+}
+
+ANKI_TEST(Util, ThreadCachingMemoryPoolBench)
+{
+	const U THREAD_COUNT = 4;
+	ThreadPool threadPool(THREAD_COUNT);
+
+	auto bench = [&](BaseMemoryPool& pool) -> Second {
+		Array<MemoryChurnTask, THREAD_COUNT> tasks;
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			tasks[i].m_pool = &pool;
+			tasks[i].m_iterationCount = 1000000;
+			tasks[i].m_maxSize = 4000;
+		}
+
+		HighRezTimer timer;
+		timer.start();
+		for(U i = 0; i < THREAD_COUNT; ++i)
+		{
+			threadPool.assignNewTask(i, &tasks[i]);
+		}
+		ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+		timer.stop();
+
+		for(MemoryChurnTask& task : tasks)
+		{
+			ANKI_TEST_EXPECT_EQ(task.m_corrupted, false);
+			task.freeAll();
+		}
+
+		ANKI_TEST_EXPECT_EQ(pool.getAllocationsCount(), 0);
+		return timer.getElapsedTime();
+	};
+
+	HeapMemoryPool heapPool;
+	heapPool.create(allocAligned, nullptr);
+	const Second heapTime = bench(heapPool);
+
+	ThreadCachingMemoryPool threadCachingPool;
+	threadCachingPool.create(allocAligned, nullptr);
+	const Second threadCachingTime = bench(threadCachingPool);
+
+	ANKI_TEST_LOGI("Mixed size churn in %u threads: heap %fs, thread caching %fs | %f%%",
+		THREAD_COUNT,
+		heapTime,
+		threadCachingTime,
+		heapTime / threadCachingTime * 100.0);
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/util/ParallelFor.h>
+#include <anki/util/ThreadHiveTaskGraph.h>
+#include <anki/util/DynamicArray.h>
+
+namespace anki
+{
+
+ANKI_TEST(Util, ParallelFor)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	for(U mode = 0; mode < 2; ++mode)
+	{
+		ThreadHive hive(4, alloc, false, mode == 1);
+
+		const U ELEMENT_COUNT = 10000;
+		DynamicArrayAuto<U32> arr(alloc);
+		arr.create(ELEMENT_COUNT, 0);
+
+		// Every element should be visited once
+		for(PtrSize grain : {PtrSize(0), PtrSize(1), PtrSize(7), PtrSize(ELEMENT_COUNT * 2)})
+		{
+			Error err = parallelFor(hive, 0, ELEMENT_COUNT, grain, [&](PtrSize begin, PtrSize end, U32) -> Error {
+				ANKI_TEST_EXPECT_LT(begin, end);
+				for(PtrSize i = begin; i < end; ++i)
+				{
+					++arr[i];
+				}
+				return Error::NONE;
+			});
+			ANKI_TEST_EXPECT_NO_ERR(err);
+		}
+
+		for(U32 v : arr)
+		{
+			ANKI_TEST_EXPECT_EQ(v, 4);
+		}
+
+		// Errors
+		Error err = parallelFor(hive, 0, ELEMENT_COUNT, 1, [&](PtrSize begin, PtrSize end, U32) -> Error {
+			return (begin <= 100 && end > 100) ? Error::USER_DATA : Error::NONE;
+		});
+		ANKI_TEST_EXPECT_EQ(err, Error::USER_DATA);
+	}
+}
+
+ANKI_TEST(Util, ThreadHiveTaskGraph)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	for(U mode = 0; mode < 2; ++mode)
+	{
+		ThreadHive hive(4, alloc, false, mode == 1);
+
+		// A diamond: a -> (b, c) -> d
+		const U ELEMENT_COUNT = 1000;
+		DynamicArrayAuto<U32> arr(alloc);
+		arr.create(ELEMENT_COUNT, 0);
+		Atomic<U32> sum = {0};
+		U32 result = 0;
+
+		ThreadHiveTaskGraph graph(hive);
+		ThreadHiveTaskGraphNode* a =
+			graph.addParallelFor(0, ELEMENT_COUNT, 0, [&](PtrSize begin, PtrSize end, U32) -> Error {
+				for(PtrSize i = begin; i < end; ++i)
+				{
+					arr[i] = 1;
+				}
+				return Error::NONE;
+			});
+
+		ThreadHiveTaskGraphNode* b =
+			graph.addParallelFor(0, ELEMENT_COUNT / 2, 0, [&](PtrSize begin, PtrSize end, U32) -> Error {
+				for(PtrSize i = begin; i < end; ++i)
+				{
+					sum.fetchAdd(arr[i]);
+				}
+				return Error::NONE;
+			});
+
+		ThreadHiveTaskGraphNode* c =
+			graph.addParallelFor(ELEMENT_COUNT / 2, ELEMENT_COUNT, 0, [&](PtrSize begin, PtrSize end, U32) -> Error {
+				for(PtrSize i = begin; i < end; ++i)
+				{
+					sum.fetchAdd(arr[i] * 2);
+				}
+				return Error::NONE;
+			});
+
+		ThreadHiveTaskGraphNode* d = graph.addTask([&](U32) -> Error {
+			result = sum.load();
+			return Error::NONE;
+		});
+
+		graph.addDependency(b, a);
+		graph.addDependency(c, a);
+		graph.addDependency(d, b);
+		graph.addDependency(d, c);
+
+		ANKI_TEST_EXPECT_NO_ERR(graph.run());
+		ANKI_TEST_EXPECT_EQ(result, ELEMENT_COUNT / 2 * 3);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,88 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/util/RadixSort.h>
+#include <anki/util/DynamicArray.h>
+#include <algorithm>
+
+namespace anki
+{
+
+class RadixSortElement
+{
+public:
+	U64 m_key;
+	U32 m_order; ///< The order before the sort. For testing the stability.
+};
+
+ANKI_TEST(Util, RadixSort)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Random keys
+	{
+		const U COUNT = 10000;
+		DynamicArrayAuto<RadixSortElement> elements(alloc);
+		DynamicArrayAuto<RadixSortElement> tmp(alloc);
+		elements.create(COUNT);
+		tmp.create(COUNT);
+
+		for(U i = 0; i < COUNT; ++i)
+		{
+			elements[i].m_key = (U64(rand()) << 40) ^ (U64(rand()) << 20) ^ U64(rand() % 16);
+			elements[i].m_order = i;
+		}
+
+		DynamicArrayAuto<RadixSortElement> ref(alloc);
+		ref.create(COUNT);
+		memcpy(&ref[0], &elements[0], sizeof(RadixSortElement) * COUNT);
+		std::stable_sort(ref.getBegin(), ref.getEnd(), [](const RadixSortElement& a, const RadixSortElement& b) {
+			return a.m_key < b.m_key;
+		});
+
+		radixSort(&elements[0], COUNT, &tmp[0], [](const RadixSortElement& e) { return e.m_key; });
+
+		for(U i = 0; i < COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(elements[i].m_key, ref[i].m_key);
+			ANKI_TEST_EXPECT_EQ(elements[i].m_order, ref[i].m_order);
+		}
+	}
+
+	// Few distinct keys. Most of the passes are skipped and it should be stable
+	{
+		const U COUNT = 1000;
+		DynamicArrayAuto<RadixSortElement> elements(alloc);
+		DynamicArrayAuto<RadixSortElement> tmp(alloc);
+		elements.create(COUNT);
+		tmp.create(COUNT);
+
+		for(U i = 0; i < COUNT; ++i)
+		{
+			elements[i].m_key = U64(rand() % 4) << 32;
+			elements[i].m_order = i;
+		}
+
+		radixSort(&elements[0], COUNT, &tmp[0], [](const RadixSortElement& e) { return e.m_key; });
+
+		for(U i = 1; i < COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_LEQ(elements[i - 1].m_key, elements[i].m_key);
+			if(elements[i - 1].m_key == elements[i].m_key)
+			{
+				ANKI_TEST_EXPECT_LT(elements[i - 1].m_order, elements[i].m_order);
+			}
+		}
+	}
+
+	// Empty
+	{
+		RadixSortElement a, b;
+		radixSort(&a, 0, &b, [](const RadixSortElement& e) { return e.m_key; });
+	}
+}
+
+} // end namespace anki
@@ -58,11 +58,11 @@ static void taskToWait(void* arg, U32 threadId, ThreadHive& hive, ThreadHiveSema
 	ANKI_TEST_EXPECT_GEQ(prev, 10);
 }
 
-ANKI_TEST(Util, ThreadHive)
+static void testThreadHive(Bool workStealing)
 {
 	const U32 threadCount = 4;
 	HeapAllocator<U8> alloc(allocAligned, nullptr);
-	ThreadHive hive(threadCount, alloc);
+	ThreadHive hive(threadCount, alloc, false, workStealing);
 
 	// Simple test
 	if(1)
@@ -169,6 +169,16 @@ ANKI_TEST(Util, ThreadHive)
 	}
 }
 
+ANKI_TEST(Util, ThreadHive)
+{
+	testThreadHive(false);
+}
+
+ANKI_TEST(Util, ThreadHiveWorkStealing)
+{
+	testThreadHive(true);
+}
+
 class FibTask
 {
 public:
@@ -245,4 +255,76 @@ ANKI_TEST(Util, ThreadHiveBench)
 	ANKI_TEST_EXPECT_EQ(sum.get(), serialFib);
 }
 
+static void tinyTask(void* arg, U32, ThreadHive& hive, ThreadHiveSemaphore* sem)
+{
+	static_cast<Atomic<U64>*>(arg)->fetchAdd(1);
+}
+
+ANKI_TEST(Util, ThreadHiveContentionBench)
+{
+	static const U FIB_N = 24;
+	static const U FLAT_TASK_COUNT = 64 * 1024;
+	static const U FLAT_BATCH = 64;
+	const Array<U32, 4> threadCounts = {{1, 4, 16, 32}};
+
+	const U64 serialFib = fib(FIB_N);
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	for(U32 threadCount : threadCounts)
+	{
+		Array<F64, 2> fibTimes;
+		Array<F64, 2> flatTimes;
+
+		for(U mode = 0; mode < 2; ++mode)
+		{
+			ThreadHive hive(threadCount, alloc, false, mode == 1);
+
+			// Recursive tasks. All submissions happen from inside the callbacks
+			{
+				StackAllocator<U8> salloc(allocAligned, nullptr, 1024);
+				Atomic<U64> sum = {0};
+				FibTask task(&sum, salloc, FIB_N);
+
+				const Second begin = HighRezTimer::getCurrentTime();
+				hive.submitTask(FibTask::callback, &task);
+				hive.waitAllTasks();
+				fibTimes[mode] = (HighRezTimer::getCurrentTime() - begin) * 1000.0;
+
+				ANKI_TEST_EXPECT_EQ(sum.get(), serialFib);
+			}
+
+			// Many tiny tasks submitted from the main thread
+			{
+				Atomic<U64> count = {0};
+				Array<ThreadHiveTask, FLAT_BATCH> tasks;
+				for(ThreadHiveTask& task : tasks)
+				{
+					task.m_callback = tinyTask;
+					task.m_argument = &count;
+				}
+
+				const Second begin = HighRezTimer::getCurrentTime();
+				for(U i = 0; i < FLAT_TASK_COUNT / FLAT_BATCH; ++i)
+				{
+					hive.submitTasks(&tasks[0], FLAT_BATCH);
+				}
+				hive.waitAllTasks();
+				flatTimes[mode] = (HighRezTimer::getCurrentTime() - begin) * 1000.0;
+
+				ANKI_TEST_EXPECT_EQ(count.get(), FLAT_TASK_COUNT);
+			}
+		}
+
+		ANKI_TEST_LOGI("%2u threads: fib(%u) shared %8.3fms stealing %8.3fms | %u flat tasks shared %8.3fms stealing "
+					   "%8.3fms",
+			threadCount,
+			FIB_N,
+			fibTimes[0],
+			fibTimes[1],
+			FLAT_TASK_COUNT,
+			flatTimes[0],
+			flatTimes[1]);
+	}
+}
+
 } // end namespace anki
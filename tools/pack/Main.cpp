@@ -0,0 +1,30 @@
+// Copyright (C) 2009-2018, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/resource/PackArchive.h>
+
+using namespace anki;
+
+static const char* USAGE = R"(Usage: %s in_dir out_file.ankipak
+Pack all the files of a directory into a memory mappable archive.
+)";
+
+int main(int argc, char** argv)
+{
+	if(argc != 3)
+	{
+		fprintf(stderr, USAGE, argv[0]);
+		return 1;
+	}
+
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	if(createPackArchive(argv[1], argv[2], alloc))
+	{
+		ANKI_LOGE("Packing failed");
+		return 1;
+	}
+
+	return 0;
+}
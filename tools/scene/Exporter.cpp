@@ -287,6 +287,11 @@ const aiMaterial& Exporter::getMaterialAt(unsigned index) const
 	return *m_scene->mMaterials[index];
 }
 
+unsigned Exporter::getModelLodCount(const Model& model) const
+{
+	return (model.m_lod1MeshName.empty()) ? m_lodCount : 1;
+}
+
 std::string Exporter::getModelName(const Model& model) const
 {
 	std::string name = getMeshName(getMeshAt(model.m_meshIndex));
@@ -398,6 +403,14 @@ void Exporter::exportModel(const Model& model) const
 	// Write mesh
 	file << "\t\t\t<mesh>" << m_rpath << getMeshName(getMeshAt(model.m_meshIndex)) << ".ankimesh</mesh>\n";
 
+	// Write the generated LODs
+	const std::string meshName = getMeshName(getMeshAt(model.m_meshIndex));
+	for(unsigned lod = 1; lod < getModelLodCount(model); ++lod)
+	{
+		file << "\t\t\t<mesh" << lod << ">" << m_rpath << meshName << "_lod" << lod << ".ankimesh</mesh" << lod
+			 << ">\n";
+	}
+
 	// Write mesh1
 	if(!model.m_lod1MeshName.empty())
 	{
@@ -1081,7 +1094,7 @@ void Exporter::exportAll()
 		Model& model = m_models[node.m_modelIndex];
 
 		// TODO If static bake transform
-		exportMesh(*m_scene->mMeshes[model.m_meshIndex], nullptr, 3);
+		exportMesh(*m_scene->mMeshes[model.m_meshIndex], nullptr, 3, getModelLodCount(model));
 
 		exportMaterial(*m_scene->mMaterials[model.m_materialIndex]);
 
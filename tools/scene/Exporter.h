@@ -105,6 +105,9 @@ public:
 	std::string m_texrpath;
 
 	bool m_flipyz = false;
+	bool m_optimizeMeshes = true;
+	unsigned m_lodCount = 1; ///< The LODs to generate for the meshes of the models.
+	float m_lodMaxError = 0.01f; ///< The max simplification error of LOD 1 relative to the size of the mesh.
 
 	const aiScene* m_scene = nullptr;
 	const aiScene* m_sceneNoTriangles = nullptr;
@@ -148,13 +151,18 @@ private:
 	const aiMaterial& getMaterialAt(unsigned index) const;
 	std::string getModelName(const Model& model) const;
 
+	/// The LODs to generate for a model. A model with a hand made LOD1 doesn't get any.
+	unsigned getModelLodCount(const Model& model) const;
+
 	/// Visits the node hierarchy and gathers models and nodes.
 	void visitNode(const aiNode* ainode);
 	/// @}
 
 	/// Export a mesh.
 	/// @param transform If not nullptr then transform the vertices using that.
-	void exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsigned vertCountPerFace) const;
+	/// @param lodCount If more than one then the extra LODs are simplified and written to <name>_lod<N>.ankimesh.
+	void exportMesh(
+		const aiMesh& mesh, const aiMatrix4x4* transform, unsigned vertCountPerFace, unsigned lodCount = 1) const;
 
 	/// Export a skeleton.
 	void exportSkeleton(const aiMesh& mesh) const;
@@ -5,11 +5,13 @@
 
 #include "Exporter.h"
 #include <anki/resource/MeshLoader.h>
+#include <anki/resource/MeshOptimizer.h>
 #include <anki/Math.h>
 #include <cmath>
 #include <cfloat>
 
-void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsigned vertCountPerFace) const
+void Exporter::exportMesh(
+	const aiMesh& mesh, const aiMatrix4x4* transform, unsigned vertCountPerFace, unsigned lodCount) const
 {
 	std::string name = mesh.mName.C_Str();
 	LOGI("Exporting mesh %s", name.c_str());
@@ -58,9 +60,9 @@ void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsi
 		uint16_t m_boneIndices[4] = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF};
 		uint8_t m_weights[4] = {0, 0, 0, 0};
 	};
-	std::vector<WeightVertex> bweights;
+	std::vector<WeightVertex> baseBweights;
 
-	std::vector<float> positions;
+	std::vector<float> basePositions;
 
 	struct NTVertex
 	{
@@ -69,7 +71,7 @@ void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsi
 		float m_uv[2];
 	};
 
-	std::vector<NTVertex> ntVerts;
+	std::vector<NTVertex> baseNtVerts;
 
 	float maxPositionDistance = 0.0; // Distance of positions from zero
 	float maxUvDistance = -FLT_MAX, minUvDistance = FLT_MAX;
@@ -80,8 +82,8 @@ void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsi
 
 		const unsigned vertCount = mesh.mNumVertices;
 
-		positions.resize(vertCount * 3);
-		ntVerts.resize(vertCount);
+		basePositions.resize(vertCount * 3);
+		baseNtVerts.resize(vertCount);
 
 		for(unsigned i = 0; i < vertCount; i++)
 		{
@@ -109,9 +111,9 @@ void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsi
 				b = toLefthanded * b;
 			}
 
-			positions[i * 3 + 0] = pos.x;
-			positions[i * 3 + 1] = pos.y;
-			positions[i * 3 + 2] = pos.z;
+			basePositions[i * 3 + 0] = pos.x;
+			basePositions[i * 3 + 1] = pos.y;
+			basePositions[i * 3 + 2] = pos.z;
 			for(int d = 0; d < 3; ++d)
 			{
 				maxPositionDistance = std::max<float>(maxPositionDistance, fabs(pos[d]));
@@ -119,24 +121,24 @@ void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsi
 				aabbMax[d] = std::max(aabbMax[d], pos[d]);
 			}
 
-			ntVerts[i].m_n[0] = n.x;
-			ntVerts[i].m_n[1] = n.y;
-			ntVerts[i].m_n[2] = n.z;
+			baseNtVerts[i].m_n[0] = n.x;
+			baseNtVerts[i].m_n[1] = n.y;
+			baseNtVerts[i].m_n[2] = n.z;
 
-			ntVerts[i].m_t[0] = t.x;
-			ntVerts[i].m_t[1] = t.y;
-			ntVerts[i].m_t[2] = t.z;
-			ntVerts[i].m_t[3] = ((n ^ t) * b < 0.0) ? 1.0 : -1.0;
+			baseNtVerts[i].m_t[0] = t.x;
+			baseNtVerts[i].m_t[1] = t.y;
+			baseNtVerts[i].m_t[2] = t.z;
+			baseNtVerts[i].m_t[3] = ((n ^ t) * b < 0.0) ? 1.0 : -1.0;
 
-			ntVerts[i].m_uv[0] = uv.x;
-			ntVerts[i].m_uv[1] = uv.y;
+			baseNtVerts[i].m_uv[0] = uv.x;
+			baseNtVerts[i].m_uv[1] = uv.y;
 			maxUvDistance = std::max(maxUvDistance, std::max(uv.x, uv.y));
 			minUvDistance = std::min(minUvDistance, std::min(uv.x, uv.y));
 		}
 
 		if(hasBoneWeights)
 		{
-			bweights.resize(vertCount);
+			baseBweights.resize(vertCount);
 
 			for(unsigned i = 0; i < mesh.mNumBones; ++i)
 			{
@@ -144,9 +146,9 @@ void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsi
 				for(unsigned j = 0; j < bone.mNumWeights; ++j)
 				{
 					const aiVertexWeight& aiWeight = bone.mWeights[j];
-					assert(aiWeight.mVertexId < bweights.size());
+					assert(aiWeight.mVertexId < baseBweights.size());
 
-					WeightVertex& vert = bweights[aiWeight.mVertexId];
+					WeightVertex& vert = baseBweights[aiWeight.mVertexId];
 
 					unsigned idx;
 					if(vert.m_boneIndices[0] == 0xFFFF)
@@ -180,212 +182,341 @@ void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsi
 		aabbMax += anki::EPSILON * 10.0f;
 	}
 
-	// Chose the formats of the attributes
+	//
+	// Gather the indices
+	//
+	std::vector<uint32_t> baseIndices;
+	baseIndices.reserve(mesh.mNumFaces * vertCountPerFace);
+	for(unsigned i = 0; i < mesh.mNumFaces; i++)
 	{
-		// Positions
-		auto& posa = header.m_vertexAttributes[anki::VertexAttributeLocation::POSITION];
-		posa.m_bufferBinding = 0;
-		posa.m_format =
-			(maxPositionDistance < 2.0) ? anki::Format::R16G16B16A16_SFLOAT : anki::Format::R32G32B32_SFLOAT;
-		posa.m_relativeOffset = 0;
-		posa.m_scale = 1.0;
-
-		// Normals
-		auto& na = header.m_vertexAttributes[anki::VertexAttributeLocation::NORMAL];
-		na.m_bufferBinding = 1;
-		na.m_format = anki::Format::A2B10G10R10_SNORM_PACK32;
-		na.m_relativeOffset = 0;
-		na.m_scale = 1.0;
-
-		// Tangents
-		auto& ta = header.m_vertexAttributes[anki::VertexAttributeLocation::TANGENT];
-		ta.m_bufferBinding = 1;
-		ta.m_format = anki::Format::A2B10G10R10_SNORM_PACK32;
-		ta.m_relativeOffset = sizeof(uint32_t);
-		ta.m_scale = 1.0;
-
-		// UVs
-		auto& uva = header.m_vertexAttributes[anki::VertexAttributeLocation::UV];
-		uva.m_bufferBinding = 1;
-		if(minUvDistance >= 0.0 && maxUvDistance <= 1.0)
-		{
-			uva.m_format = anki::Format::R16G16_UNORM;
-		}
-		else
+		const aiFace& face = mesh.mFaces[i];
+
+		if(face.mNumIndices != vertCountPerFace)
 		{
-			uva.m_format = anki::Format::R16G16_SFLOAT;
+			ERROR("For some reason assimp returned wrong number of verts for a face (face.mNumIndices=%d). Probably"
+				  "degenerates in input file",
+				face.mNumIndices);
 		}
-		uva.m_relativeOffset = sizeof(uint32_t) * 2;
-		uva.m_scale = 1.0;
 
-		// Bone weight
-		if(hasBoneWeights)
+		for(unsigned j = 0; j < vertCountPerFace; j++)
 		{
-			auto& bidxa = header.m_vertexAttributes[anki::VertexAttributeLocation::BONE_INDICES];
-			bidxa.m_bufferBinding = 2;
-			bidxa.m_format = anki::Format::R16G16B16A16_UINT;
-			bidxa.m_relativeOffset = 0;
-			bidxa.m_scale = 1.0;
-
-			auto& wa = header.m_vertexAttributes[anki::VertexAttributeLocation::BONE_WEIGHTS];
-			wa.m_bufferBinding = 2;
-			wa.m_format = anki::Format::R8G8B8A8_UNORM;
-			wa.m_relativeOffset = sizeof(uint16_t) * 4;
-			wa.m_scale = 1.0;
+			baseIndices.push_back(face.mIndices[j]);
 		}
 	}
 
-	// Arange the attributes into vert buffers
+	//
+	// Write the LODs. The LODs after the 1st are simplified versions of the 1st
+	//
+	if(vertCountPerFace != 3)
 	{
-		header.m_vertexBufferCount = 2;
-
-		// First buff has positions
-		const auto& posa = header.m_vertexAttributes[anki::VertexAttributeLocation::POSITION];
-		if(posa.m_format == anki::Format::R32G32B32_SFLOAT)
-		{
-			header.m_vertexBuffers[0].m_vertexStride = sizeof(float) * 3;
-		}
-		else if(posa.m_format == anki::Format::R16G16B16A16_SFLOAT)
-		{
-			header.m_vertexBuffers[0].m_vertexStride = sizeof(uint16_t) * 4;
-		}
-		else
-		{
-			assert(0);
-		}
-
-		// 2nd buff has normal + tangent + texcoords
-		header.m_vertexBuffers[1].m_vertexStride = sizeof(uint32_t) * 2 + sizeof(uint16_t) * 2;
-
-		// 3rd has bone weights
-		if(hasBoneWeights)
-		{
-			header.m_vertexBuffers[2].m_vertexStride = sizeof(WeightVertex);
-			++header.m_vertexBufferCount;
-		}
+		lodCount = 1;
 	}
 
-	// Write some other header stuff
+	const float aabbDiagonal = (aabbMax - aabbMin).getLength();
+	for(unsigned lod = 0; lod < lodCount; ++lod)
 	{
-		memcpy(&header.m_magic[0], anki::MeshBinaryFile::MAGIC, 8);
-		header.m_flags = (vertCountPerFace == 4) ? anki::MeshBinaryFile::Flag::QUAD : anki::MeshBinaryFile::Flag::NONE;
-		header.m_indexType = anki::IndexType::U16;
-		header.m_totalIndexCount = mesh.mNumFaces * vertCountPerFace;
-		header.m_totalVertexCount = mesh.mNumVertices;
-		header.m_subMeshCount = 1;
-		header.m_aabbMin = aabbMin;
-		header.m_aabbMax = aabbMax;
-	}
+		std::vector<uint32_t> indices = baseIndices;
+		std::vector<float> positions = basePositions;
+		std::vector<NTVertex> ntVerts = baseNtVerts;
+		std::vector<WeightVertex> bweights = baseBweights;
 
-	// Open file
-	std::fstream file;
-	file.open(m_outputDirectory + name + ".ankimesh", std::ios::out | std::ios::binary);
+		if(lod > 0)
+		{
+			anki::HeapAllocator<anki::U8> alloc(anki::allocAligned, nullptr);
+
+			// Every LOD has half the triangles of the previous and the error can grow with the LOD
+			const unsigned targetIndexCount = (baseIndices.size() / 3 >> lod) * 3;
+			const float maxError = aabbDiagonal * m_lodMaxError * lod;
+
+			anki::DynamicArrayAuto<anki::U32> simplified(alloc);
+			const float error = anki::MeshOptimizer::simplify(
+				anki::ConstWeakArray<anki::U32>(&baseIndices[0], baseIndices.size()),
+				anki::ConstWeakArray<anki::Vec3>(reinterpret_cast<const anki::Vec3*>(&basePositions[0]),
+					basePositions.size() / 3),
+				targetIndexCount,
+				maxError,
+				simplified,
+				alloc);
+
+			if(simplified.getSize() == 0)
+			{
+				ERROR("Simplification of %s removed all the triangles", name.c_str());
+			}
 
-	// Write header
-	file.write(reinterpret_cast<char*>(&header), sizeof(header));
+			indices.assign(simplified.getBegin(), simplified.getEnd());
+			LOGI("Mesh %s LOD %u has %u triangles out of %u with error %f",
+				name.c_str(),
+				lod,
+				unsigned(indices.size() / 3),
+				unsigned(baseIndices.size() / 3),
+				error);
+		}
 
-	// Write sub meshes
-	{
+		//
+		// Optimize
+		//
 		anki::MeshBinaryFile::SubMesh smesh;
 		smesh.m_firstIndex = 0;
-		smesh.m_indexCount = header.m_totalIndexCount;
+		smesh.m_indexCount = indices.size();
 		smesh.m_aabbMin = aabbMin;
 		smesh.m_aabbMax = aabbMax;
 
-		file.write(reinterpret_cast<char*>(&smesh), sizeof(smesh));
-	}
+		std::vector<anki::MeshBinaryFile::Meshlet> meshlets;
+		if(m_optimizeMeshes && vertCountPerFace == 3)
+		{
+			anki::HeapAllocator<anki::U8> alloc(anki::allocAligned, nullptr);
+			const unsigned vertCount = mesh.mNumVertices;
+
+			const anki::VertexCacheStatistics before = anki::MeshOptimizer::computeVertexCacheStatistics(
+				anki::ConstWeakArray<anki::U32>(&indices[0], indices.size()), vertCount, alloc);
+
+			// Reorder the triangles
+			std::vector<uint32_t> optimizedIndices(indices.size());
+			anki::MeshOptimizer::optimizeVertexCache(anki::ConstWeakArray<anki::U32>(&indices[0], indices.size()),
+				vertCount,
+				anki::WeakArray<anki::U32>(&optimizedIndices[0], optimizedIndices.size()),
+				alloc);
+			indices = optimizedIndices;
+
+			// Reorder the vertices
+			std::vector<uint32_t> remap(vertCount);
+			const unsigned newVertCount = anki::MeshOptimizer::optimizeVertexFetch(
+				anki::WeakArray<anki::U32>(&indices[0], indices.size()),
+				anki::WeakArray<anki::U32>(&remap[0], vertCount));
+
+			std::vector<float> newPositions(newVertCount * 3);
+			std::vector<NTVertex> newNtVerts(newVertCount);
+			std::vector<WeightVertex> newBweights((hasBoneWeights) ? newVertCount : 0);
+			for(unsigned i = 0; i < vertCount; ++i)
+			{
+				const uint32_t newIdx = remap[i];
+				if(newIdx == anki::MAX_U32)
+				{
+					continue;
+				}
 
-	// Write indices
-	for(unsigned i = 0; i < mesh.mNumFaces; i++)
-	{
-		const aiFace& face = mesh.mFaces[i];
+				memcpy(&newPositions[newIdx * 3], &positions[i * 3], sizeof(float) * 3);
+				newNtVerts[newIdx] = ntVerts[i];
+				if(hasBoneWeights)
+				{
+					newBweights[newIdx] = bweights[i];
+				}
+			}
 
-		if(face.mNumIndices != vertCountPerFace)
-		{
-			ERROR("For some reason assimp returned wrong number of verts for a face (face.mNumIndices=%d). Probably"
-				  "degenerates in input file",
-				face.mNumIndices);
+			positions = newPositions;
+			ntVerts = newNtVerts;
+			bweights = newBweights;
+
+			const anki::VertexCacheStatistics after = anki::MeshOptimizer::computeVertexCacheStatistics(
+				anki::ConstWeakArray<anki::U32>(&indices[0], indices.size()), newVertCount, alloc);
+
+			LOGI("Mesh %s vertex cache: ACMR %f -> %f, ATVR %f -> %f",
+				name.c_str(),
+				before.m_acmr,
+				after.m_acmr,
+				before.m_atvr,
+				after.m_atvr);
+
+			// Meshlets
+			anki::DynamicArrayAuto<anki::MeshBinaryFile::Meshlet> ankiMeshlets(alloc);
+			anki::MeshOptimizer::generateMeshlets(anki::ConstWeakArray<anki::U32>(&indices[0], indices.size()),
+				anki::ConstWeakArray<anki::Vec3>(reinterpret_cast<const anki::Vec3*>(&positions[0]), newVertCount),
+				smesh,
+				64,
+				126,
+				ankiMeshlets);
+			meshlets.assign(ankiMeshlets.getBegin(), ankiMeshlets.getEnd());
 		}
 
-		for(unsigned j = 0; j < vertCountPerFace; j++)
+		const unsigned vertCount = positions.size() / 3;
+
+		// Chose the formats of the attributes
 		{
-			uint32_t index32 = face.mIndices[j];
-			if(index32 > 0xFFFF)
+			// Positions. Quantize them to 16bit if the scale can be folded to the transform of the model. It can't if
+			// there is skinning
+			auto& posa = header.m_vertexAttributes[anki::VertexAttributeLocation::POSITION];
+			posa.m_bufferBinding = 0;
+			posa.m_relativeOffset = 0;
+			if(m_optimizeMeshes && !hasBoneWeights && maxPositionDistance > 0.0)
 			{
-				ERROR("Index too big");
+				posa.m_format = anki::Format::R16G16B16A16_SNORM;
+				posa.m_scale = maxPositionDistance;
+			}
+			else
+			{
+				posa.m_format =
+					(maxPositionDistance < 2.0) ? anki::Format::R16G16B16A16_SFLOAT : anki::Format::R32G32B32_SFLOAT;
+				posa.m_scale = 1.0;
 			}
 
-			uint16_t index = index32;
-			file.write(reinterpret_cast<char*>(&index), sizeof(index));
-		}
-	}
+			// Normals
+			auto& na = header.m_vertexAttributes[anki::VertexAttributeLocation::NORMAL];
+			na.m_bufferBinding = 1;
+			na.m_format = anki::Format::A2B10G10R10_SNORM_PACK32;
+			na.m_relativeOffset = 0;
+			na.m_scale = 1.0;
+
+			// Tangents
+			auto& ta = header.m_vertexAttributes[anki::VertexAttributeLocation::TANGENT];
+			ta.m_bufferBinding = 1;
+			ta.m_format = anki::Format::A2B10G10R10_SNORM_PACK32;
+			ta.m_relativeOffset = sizeof(uint32_t);
+			ta.m_scale = 1.0;
+
+			// UVs
+			auto& uva = header.m_vertexAttributes[anki::VertexAttributeLocation::UV];
+			uva.m_bufferBinding = 1;
+			if(minUvDistance >= 0.0 && maxUvDistance <= 1.0)
+			{
+				uva.m_format = anki::Format::R16G16_UNORM;
+			}
+			else
+			{
+				uva.m_format = anki::Format::R16G16_SFLOAT;
+			}
+			uva.m_relativeOffset = sizeof(uint32_t) * 2;
+			uva.m_scale = 1.0;
 
-	// Write first vert buffer
-	{
-		const auto& posa = header.m_vertexAttributes[anki::VertexAttributeLocation::POSITION];
-		if(posa.m_format == anki::Format::R32G32B32_SFLOAT)
-		{
-			file.write(reinterpret_cast<char*>(&positions[0]), positions.size() * sizeof(positions[0]));
+			// Bone weight
+			if(hasBoneWeights)
+			{
+				auto& bidxa = header.m_vertexAttributes[anki::VertexAttributeLocation::BONE_INDICES];
+				bidxa.m_bufferBinding = 2;
+				bidxa.m_format = anki::Format::R16G16B16A16_UINT;
+				bidxa.m_relativeOffset = 0;
+				bidxa.m_scale = 1.0;
+
+				auto& wa = header.m_vertexAttributes[anki::VertexAttributeLocation::BONE_WEIGHTS];
+				wa.m_bufferBinding = 2;
+				wa.m_format = anki::Format::R8G8B8A8_UNORM;
+				wa.m_relativeOffset = sizeof(uint16_t) * 4;
+				wa.m_scale = 1.0;
+			}
 		}
-		else if(posa.m_format == anki::Format::R16G16B16A16_SFLOAT)
+
+		// Arange the attributes into vert buffers
 		{
-			std::vector<uint16_t> pos16;
-			pos16.resize(mesh.mNumVertices * 4);
+			header.m_vertexBufferCount = 2;
 
-			const float* p32 = &positions[0];
-			const float* p32end = p32 + positions.size();
-			uint16_t* p16 = &pos16[0];
-			while(p32 != p32end)
+			// First buff has positions
+			const auto& posa = header.m_vertexAttributes[anki::VertexAttributeLocation::POSITION];
+			if(posa.m_format == anki::Format::R32G32B32_SFLOAT)
 			{
-				p16[0] = anki::F16(p32[0]).toU16();
-				p16[1] = anki::F16(p32[1]).toU16();
-				p16[2] = anki::F16(p32[2]).toU16();
-				p16[3] = anki::F16(0.0f).toU16();
+				header.m_vertexBuffers[0].m_vertexStride = sizeof(float) * 3;
+			}
+			else if(posa.m_format == anki::Format::R16G16B16A16_SFLOAT
+					|| posa.m_format == anki::Format::R16G16B16A16_SNORM)
+			{
+				header.m_vertexBuffers[0].m_vertexStride = sizeof(uint16_t) * 4;
+			}
+			else
+			{
+				assert(0);
+			}
+
+			// 2nd buff has normal + tangent + texcoords
+			header.m_vertexBuffers[1].m_vertexStride = sizeof(uint32_t) * 2 + sizeof(uint16_t) * 2;
 
-				p32 += 3;
-				p16 += 4;
+			// 3rd has bone weights
+			if(hasBoneWeights)
+			{
+				header.m_vertexBuffers[2].m_vertexStride = sizeof(WeightVertex);
+				++header.m_vertexBufferCount;
 			}
+		}
 
-			file.write(reinterpret_cast<char*>(&pos16[0]), pos16.size() * sizeof(pos16[0]));
+		// Write some other header stuff
+		{
+			memcpy(&header.m_magic[0], anki::MeshBinaryFile::MAGIC, 8);
+			header.m_flags =
+				(vertCountPerFace == 4) ? anki::MeshBinaryFile::Flag::QUAD : anki::MeshBinaryFile::Flag::NONE;
+			if(!meshlets.empty())
+			{
+				header.m_flags |= anki::MeshBinaryFile::Flag::MESHLETS;
+			}
+			header.m_indexType = anki::IndexType::U16;
+			header.m_totalIndexCount = indices.size();
+			header.m_totalVertexCount = vertCount;
+			header.m_subMeshCount = 1;
+			header.m_aabbMin = aabbMin;
+			header.m_aabbMax = aabbMax;
 		}
-		else
+
+		// Open file
+		std::fstream file;
+		const std::string lodSuffix = (lod > 0) ? "_lod" + std::to_string(lod) : "";
+		file.open(m_outputDirectory + name + lodSuffix + ".ankimesh", std::ios::out | std::ios::binary);
+
+		// Write header
+		file.write(reinterpret_cast<char*>(&header), sizeof(header));
+
+		// Write sub meshes
+		file.write(reinterpret_cast<char*>(&smesh), sizeof(smesh));
+
+		// Write meshlets
+		if(!meshlets.empty())
 		{
-			assert(0);
+			const uint32_t meshletCount = meshlets.size();
+			file.write(reinterpret_cast<const char*>(&meshletCount), sizeof(meshletCount));
+			file.write(reinterpret_cast<char*>(&meshlets[0]), meshlets.size() * sizeof(meshlets[0]));
 		}
-	}
 
-	// Write 2nd vert buffer
-	{
-		struct Vert
+		// Write indices
+		for(uint32_t index32 : indices)
 		{
-			uint32_t m_n;
-			uint32_t m_t;
-			uint16_t m_uv[2];
-		};
+			if(index32 > 0xFFFF)
+			{
+				ERROR("Index too big");
+			}
 
-		std::vector<Vert> verts;
-		verts.resize(mesh.mNumVertices);
+			uint16_t index = index32;
+			file.write(reinterpret_cast<char*>(&index), sizeof(index));
+		}
 
-		for(unsigned i = 0; i < mesh.mNumVertices; ++i)
+		// Write first vert buffer
 		{
-			const auto& inVert = ntVerts[i];
+			const auto& posa = header.m_vertexAttributes[anki::VertexAttributeLocation::POSITION];
+			if(posa.m_format == anki::Format::R32G32B32_SFLOAT)
+			{
+				file.write(reinterpret_cast<char*>(&positions[0]), positions.size() * sizeof(positions[0]));
+			}
+			else if(posa.m_format == anki::Format::R16G16B16A16_SFLOAT)
+			{
+				std::vector<uint16_t> pos16;
+				pos16.resize(vertCount * 4);
 
-			verts[i].m_n = anki::packColorToR10G10B10A2SNorm(inVert.m_n[0], inVert.m_n[1], inVert.m_n[2], 0.0);
-			verts[i].m_t =
-				anki::packColorToR10G10B10A2SNorm(inVert.m_t[0], inVert.m_t[1], inVert.m_t[2], inVert.m_t[3]);
+				const float* p32 = &positions[0];
+				const float* p32end = p32 + positions.size();
+				uint16_t* p16 = &pos16[0];
+				while(p32 != p32end)
+				{
+					p16[0] = anki::F16(p32[0]).toU16();
+					p16[1] = anki::F16(p32[1]).toU16();
+					p16[2] = anki::F16(p32[2]).toU16();
+					p16[3] = anki::F16(0.0f).toU16();
 
-			const float uv[2] = {inVert.m_uv[0], inVert.m_uv[1]};
-			const anki::Format uvfmt = header.m_vertexAttributes[anki::VertexAttributeLocation::UV].m_format;
-			if(uvfmt == anki::Format::R16G16_UNORM)
-			{
-				assert(uv[0] <= 1.0 && uv[0] >= 0.0 && uv[1] <= 1.0 && uv[1] >= 0.0);
-				verts[i].m_uv[0] = uv[0] * 0xFFFF;
-				verts[i].m_uv[1] = uv[1] * 0xFFFF;
+					p32 += 3;
+					p16 += 4;
+				}
+
+				file.write(reinterpret_cast<char*>(&pos16[0]), pos16.size() * sizeof(pos16[0]));
 			}
-			else if(uvfmt == anki::Format::R16G16_SFLOAT)
+			else if(posa.m_format == anki::Format::R16G16B16A16_SNORM)
 			{
-				verts[i].m_uv[0] = anki::F16(uv[0]).toU16();
-				verts[i].m_uv[1] = anki::F16(uv[1]).toU16();
+				std::vector<int16_t> pos16;
+				pos16.resize(vertCount * 4);
+
+				for(unsigned i = 0; i < vertCount; ++i)
+				{
+					for(unsigned d = 0; d < 3; ++d)
+					{
+						const float norm = std::max(-1.0f, std::min(1.0f, positions[i * 3 + d] / posa.m_scale));
+						pos16[i * 4 + d] = int16_t(std::round(norm * 32767.0f));
+					}
+					pos16[i * 4 + 3] = 0;
+				}
+
+				file.write(reinterpret_cast<char*>(&pos16[0]), pos16.size() * sizeof(pos16[0]));
 			}
 			else
 			{
@@ -393,12 +524,52 @@ void Exporter::exportMesh(const aiMesh& mesh, const aiMatrix4x4* transform, unsi
 			}
 		}
 
-		file.write(reinterpret_cast<char*>(&verts[0]), verts.size() * sizeof(verts[0]));
-	}
+		// Write 2nd vert buffer
+		{
+			struct Vert
+			{
+				uint32_t m_n;
+				uint32_t m_t;
+				uint16_t m_uv[2];
+			};
 
-	// Write 3rd vert buffer
-	if(hasBoneWeights)
-	{
-		file.write(reinterpret_cast<char*>(&bweights[0]), bweights.size() * sizeof(bweights[0]));
+			std::vector<Vert> verts;
+			verts.resize(vertCount);
+
+			for(unsigned i = 0; i < vertCount; ++i)
+			{
+				const auto& inVert = ntVerts[i];
+
+				verts[i].m_n = anki::packColorToR10G10B10A2SNorm(inVert.m_n[0], inVert.m_n[1], inVert.m_n[2], 0.0);
+				verts[i].m_t =
+					anki::packColorToR10G10B10A2SNorm(inVert.m_t[0], inVert.m_t[1], inVert.m_t[2], inVert.m_t[3]);
+
+				const float uv[2] = {inVert.m_uv[0], inVert.m_uv[1]};
+				const anki::Format uvfmt = header.m_vertexAttributes[anki::VertexAttributeLocation::UV].m_format;
+				if(uvfmt == anki::Format::R16G16_UNORM)
+				{
+					assert(uv[0] <= 1.0 && uv[0] >= 0.0 && uv[1] <= 1.0 && uv[1] >= 0.0);
+					verts[i].m_uv[0] = uv[0] * 0xFFFF;
+					verts[i].m_uv[1] = uv[1] * 0xFFFF;
+				}
+				else if(uvfmt == anki::Format::R16G16_SFLOAT)
+				{
+					verts[i].m_uv[0] = anki::F16(uv[0]).toU16();
+					verts[i].m_uv[1] = anki::F16(uv[1]).toU16();
+				}
+				else
+				{
+					assert(0);
+				}
+			}
+
+			file.write(reinterpret_cast<char*>(&verts[0]), verts.size() * sizeof(verts[0]));
+		}
+
+		// Write 3rd vert buffer
+		if(hasBoneWeights)
+		{
+			file.write(reinterpret_cast<char*>(&bweights[0]), bweights.size() * sizeof(bweights[0]));
+		}
 	}
 }
@@ -12,6 +12,8 @@ Options:
 -rpath <string>     : Replace all absolute paths of assets with that path
 -texrpath <string>  : Same as rpath but for textures
 -flipyz             : Flip y with z (For blender exports)
+-noopt              : Don't reorder the triangles and vertices and don't quantize the positions of the meshes
+-lods <number>      : Generate that many LODs for the meshes of the models (1 to 3). Default is 1
 )";
 
 	bool rpathFound = false;
@@ -66,6 +68,23 @@ Options:
 		{
 			exporter.m_flipyz = true;
 		}
+		else if(strcmp(argv[i], "-noopt") == 0)
+		{
+			exporter.m_optimizeMeshes = false;
+		}
+		else if(strcmp(argv[i], "-lods") == 0)
+		{
+			++i;
+
+			if(i < argc && atoi(argv[i]) >= 1 && atoi(argv[i]) <= 3)
+			{
+				exporter.m_lodCount = atoi(argv[i]);
+			}
+			else
+			{
+				goto error;
+			}
+		}
 		else
 		{
 			goto error;